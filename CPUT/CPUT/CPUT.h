@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <crtdbg.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <sstream>
 #include <assert.h>
@@ -30,6 +31,8 @@
 #include "CPUTEventHandler.h"
 #include "CPUTCallbackHandler.h"
 #include "CPUTTimer.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTAllocator.h"
 
 #ifdef CPUT_GPA_INSTRUMENTATION
 // For D3DPERF_* calls, you also need d3d9.lib included
@@ -163,6 +166,7 @@ typedef enum CPUTResult
 //    CPUT_ERROR_UNSUPPORTED_VERTEX_ELEMENT_TYPE = CPUT_ERROR_VERTEX_LAYOUT_PROBLEM+3,
 //    CPUT_ERROR_INDEX_BUFFER_LAYOUT_PROBLEM = CPUT_ERROR_VERTEX_LAYOUT_PROBLEM+4,
     CPUT_ERROR_SHADER_INPUT_SLOT_NOT_MATCHED = CPUT_ERROR_VERTEX_LAYOUT_PROBLEM+5,
+    CPUT_ERROR_SHADER_COMPILE_ERROR = CPUT_ERROR_VERTEX_LAYOUT_PROBLEM+6,
 //
 //
 //    // Context creation errors
@@ -259,6 +263,10 @@ enum CPUT_DATA_FORMAT_TYPE
 
     CPUT_CHAR=11,
     CPUT_BOOL=12,
+
+    CPUT_F16=13,
+    CPUT_SNORM16=14,    // -32767..32767 is -1..1
+    CPUT_SNORM8=15,     // -127..127 is -1..1
 };
 
 // Corresponding sizes (in bytes) that match CPUT_DATA_FORMAT_TYPE
@@ -283,6 +291,10 @@ const int CPUT_DATA_FORMAT_SIZE[] =
 
         1, //CPUT_CHAR
         1, //CPUT_BOOL
+
+        2, //CPUT_F16
+        2, //CPUT_SNORM16
+        1, //CPUT_SNORM8
 };
 
 //-----------------------------------------------------------------------------
@@ -450,6 +462,9 @@ protected:
     CPUTBuffer  *mpDepthBuffer;
     CPUTTexture *mpBackBufferTexture;
     CPUTTexture *mpDepthBufferTexture;
+    CPUTFrameScheduler mFrameScheduler; // Paces the message loop's calls to InnerExecutionLoop()
+    CPUTArena    mFrameArena;       // Reset at the start of every InnerExecutionLoop()
+    CPUTFrameAllocations mFrameAllocations; // Made by the last InnerExecutionLoop()
 
 public:
     CPUT() :
@@ -461,12 +476,20 @@ public:
         mpDepthBuffer(NULL),
         mpBackBufferTexture(NULL),
         mpDepthBufferTexture(NULL)
-    {}
+    {
+        memset( &mFrameAllocations, 0, sizeof(mFrameAllocations) );
+    }
     virtual ~CPUT() {}
 
     CPUTCamera  *GetCamera() { return mpCamera; }
     CPUTCamera  *GetShadowCamera() { return mpShadowCamera; } // TODO: Support more than one.
     virtual void InnerExecutionLoop() {;}
+    // Called while the frame scheduler idles between frames, to report any activity (e.g.
+    // sensor motion) to it.  Input messages are reported by the message loop.
+    virtual void PollActivity() {;}
+    CPUTFrameScheduler *GetFrameScheduler() { return &mFrameScheduler; }
+    CPUTArena   *GetFrameArena() { return &mFrameArena; }
+    const CPUTFrameAllocations &GetFrameAllocations() const { return mFrameAllocations; }
     virtual void ResizeWindowSoft(UINT width, UINT height) {UNREFERENCED_PARAMETER(width);UNREFERENCED_PARAMETER(height);}
     virtual void ResizeWindow(UINT width, UINT height) {
         CPUTRenderTargetColor::SetActiveWidthHeight( width, height );
@@ -0,0 +1,462 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTAllocator.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#ifdef _WIN32
+#   define ALLOCATOR_LOCK(p)                EnterCriticalSection( &(p)->mLock )
+#   define ALLOCATOR_UNLOCK(p)              LeaveCriticalSection( &(p)->mLock )
+#   define ALLOCATOR_ADD(pValue, amount)    InterlockedExchangeAdd( (pValue), (amount) )
+#   define ALLOCATOR_ADD64(pValue, amount)  InterlockedExchangeAdd64( (pValue), (amount) )
+#else
+#   define ALLOCATOR_LOCK(p)                pthread_mutex_lock( &(p)->mLock )
+#   define ALLOCATOR_UNLOCK(p)              pthread_mutex_unlock( &(p)->mLock )
+#   define ALLOCATOR_ADD(pValue, amount)    __sync_fetch_and_add( (pValue), (amount) )
+#   define ALLOCATOR_ADD64(pValue, amount)  __sync_fetch_and_add( (pValue), (amount) )
+#endif
+
+// Chunk headers are padded so the memory after them keeps the heap's alignment
+static const size_t ARENA_HEADER_SIZE = 16;
+static const size_t POOL_ALIGNMENT    = 16;
+
+//-----------------------------------------------------------------------------
+static uint8_t *AlignUp( uint8_t *pAddress, size_t alignment )
+{
+    return (uint8_t*)(((uintptr_t)pAddress + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+#ifdef CPUT_COUNT_HEAP_ALLOCATIONS
+// C++11 deprecated dynamic exception specifications, and C++17 rejects throw(std::bad_alloc)
+#if __cplusplus < 201103L
+#   define ALLOCATOR_THROWS_BAD_ALLOC  throw(std::bad_alloc)
+#   define ALLOCATOR_NO_THROW          throw()
+#else
+#   define ALLOCATOR_THROWS_BAD_ALLOC
+#   define ALLOCATOR_NO_THROW          noexcept
+#endif
+
+#ifdef _WIN32
+static volatile LONGLONG sHeapAllocations = 0;
+static volatile LONGLONG sHeapFrees       = 0;
+static volatile LONGLONG sHeapBytes       = 0;
+#else
+static volatile int64_t  sHeapAllocations = 0;
+static volatile int64_t  sHeapFrees       = 0;
+static volatile int64_t  sHeapBytes       = 0;
+#endif
+
+//-----------------------------------------------------------------------------
+static void *CountedAllocate( size_t size )
+{
+    ALLOCATOR_ADD64( &sHeapAllocations, 1 );
+    ALLOCATOR_ADD64( &sHeapBytes, (int64_t)size );
+    return malloc( size ? size : 1 );
+}
+
+//-----------------------------------------------------------------------------
+static void CountedFree( void *pMemory )
+{
+    if( pMemory )
+    {
+        ALLOCATOR_ADD64( &sHeapFrees, 1 );
+        free( pMemory );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void *operator new( size_t size ) ALLOCATOR_THROWS_BAD_ALLOC
+{
+    void *pMemory = CountedAllocate( size );
+    if( !pMemory )
+    {
+        throw std::bad_alloc();
+    }
+    return pMemory;
+}
+
+//-----------------------------------------------------------------------------
+void *operator new[]( size_t size ) ALLOCATOR_THROWS_BAD_ALLOC
+{
+    return operator new( size );
+}
+
+//-----------------------------------------------------------------------------
+void *operator new( size_t size, const std::nothrow_t & ) ALLOCATOR_NO_THROW
+{
+    return CountedAllocate( size );
+}
+
+//-----------------------------------------------------------------------------
+void *operator new[]( size_t size, const std::nothrow_t & ) ALLOCATOR_NO_THROW
+{
+    return CountedAllocate( size );
+}
+
+//-----------------------------------------------------------------------------
+void operator delete( void *pMemory ) ALLOCATOR_NO_THROW
+{
+    CountedFree( pMemory );
+}
+
+//-----------------------------------------------------------------------------
+void operator delete[]( void *pMemory ) ALLOCATOR_NO_THROW
+{
+    CountedFree( pMemory );
+}
+
+//-----------------------------------------------------------------------------
+void operator delete( void *pMemory, const std::nothrow_t & ) ALLOCATOR_NO_THROW
+{
+    CountedFree( pMemory );
+}
+
+//-----------------------------------------------------------------------------
+void operator delete[]( void *pMemory, const std::nothrow_t & ) ALLOCATOR_NO_THROW
+{
+    CountedFree( pMemory );
+}
+
+#ifdef __cpp_sized_deallocation
+//-----------------------------------------------------------------------------
+void operator delete( void *pMemory, size_t ) ALLOCATOR_NO_THROW
+{
+    CountedFree( pMemory );
+}
+
+//-----------------------------------------------------------------------------
+void operator delete[]( void *pMemory, size_t ) ALLOCATOR_NO_THROW
+{
+    CountedFree( pMemory );
+}
+#endif
+#endif // CPUT_COUNT_HEAP_ALLOCATIONS
+
+//-----------------------------------------------------------------------------
+CPUTHeapCounters CPUTGetHeapCounters()
+{
+    CPUTHeapCounters counters;
+#ifdef CPUT_COUNT_HEAP_ALLOCATIONS
+    // Adding 0 reads all 64 bits at once, even on 32-bit targets
+    counters.mAllocations = (uint64_t)ALLOCATOR_ADD64( &sHeapAllocations, 0 );
+    counters.mFrees       = (uint64_t)ALLOCATOR_ADD64( &sHeapFrees, 0 );
+    counters.mBytes       = (uint64_t)ALLOCATOR_ADD64( &sHeapBytes, 0 );
+#else
+    memset( &counters, 0, sizeof(counters) );
+#endif
+    return counters;
+}
+
+//-----------------------------------------------------------------------------
+CPUTArena::CPUTArena( size_t chunkSize ) :
+    mpFirst(NULL),
+    mpCurrent(NULL),
+    mpHead(NULL),
+    mpEnd(NULL),
+    mChunkSize(chunkSize)
+{
+    memset( &mStats, 0, sizeof(mStats) );
+}
+
+//-----------------------------------------------------------------------------
+CPUTArena::~CPUTArena()
+{
+    FreeChunks();
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTArena::Allocate( size_t size, size_t alignment )
+{
+    assert( alignment && 0 == (alignment & (alignment - 1)) );
+    if( mpCurrent )
+    {
+        uint8_t *pStart = AlignUp( mpHead, alignment );
+        size_t   bytes  = (size_t)(pStart - mpHead) + size;
+        if( bytes <= (size_t)(mpEnd - mpHead) )
+        {
+            mpHead = pStart + size;
+            mStats.mAllocations++;
+            mStats.mBytes += bytes;
+            mStats.mUsed  += bytes;
+            mStats.mPeak   = mStats.mUsed > mStats.mPeak ? mStats.mUsed : mStats.mPeak;
+            return pStart;
+        }
+    }
+    return AllocateFromNextChunk( size, alignment );
+}
+
+// Moves on to the next free chunk if the allocation fits in it, or else puts a new chunk
+// in front of it.  The end of the current chunk is left unused.
+//-----------------------------------------------------------------------------
+void *CPUTArena::AllocateFromNextChunk( size_t size, size_t alignment )
+{
+    size_t needed = size + alignment - 1;
+    Chunk *pNext  = mpCurrent ? mpCurrent->mpNext : mpFirst;
+    if( !pNext || pNext->mSize < needed )
+    {
+        size_t chunkSize = needed > mChunkSize ? needed : mChunkSize;
+        Chunk *pChunk    = (Chunk*)new uint8_t[ARENA_HEADER_SIZE + chunkSize];
+        pChunk->mpNext   = pNext;
+        pChunk->mSize    = chunkSize;
+        if( mpCurrent )
+        {
+            mpCurrent->mpNext = pChunk;
+        }
+        else
+        {
+            mpFirst = pChunk;
+        }
+        pNext = pChunk;
+        mStats.mChunkAllocations++;
+        mStats.mCapacity += chunkSize;
+    }
+    mpCurrent = pNext;
+    mpHead    = (uint8_t*)pNext + ARENA_HEADER_SIZE;
+    mpEnd     = mpHead + pNext->mSize;
+    return Allocate( size, alignment );
+}
+
+//-----------------------------------------------------------------------------
+CPUTArena::Mark CPUTArena::GetMark() const
+{
+    Mark mark;
+    mark.mpChunk = mpCurrent;
+    mark.mpHead  = mpHead;
+    mark.mUsed   = mStats.mUsed;
+    return mark;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTArena::Rewind( const Mark &mark )
+{
+    mpCurrent    = mark.mpChunk;
+    mpHead       = mark.mpHead;
+    mpEnd        = mpCurrent ? (uint8_t*)mpCurrent + ARENA_HEADER_SIZE + mpCurrent->mSize : NULL;
+    mStats.mUsed = mark.mUsed;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTArena::Reset()
+{
+    if( mpFirst && mpFirst->mpNext )
+    {
+        // One chunk for all of it next time
+        size_t capacity = mStats.mCapacity;
+        FreeChunks();
+        mpFirst = (Chunk*)new uint8_t[ARENA_HEADER_SIZE + capacity];
+        mpFirst->mpNext = NULL;
+        mpFirst->mSize  = capacity;
+        mStats.mChunkAllocations++;
+        mStats.mCapacity = capacity;
+    }
+    mpCurrent = NULL;
+    mpHead    = NULL;
+    mpEnd     = NULL;
+    mStats.mAllocations = 0;
+    mStats.mBytes       = 0;
+    mStats.mUsed        = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTArena::ReleaseMemory()
+{
+    FreeChunks();
+    mStats.mAllocations = 0;
+    mStats.mBytes       = 0;
+    mStats.mUsed        = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTArena::FreeChunks()
+{
+    while( mpFirst )
+    {
+        Chunk *pNext = mpFirst->mpNext;
+        delete [] (uint8_t*)mpFirst;
+        mpFirst = pNext;
+    }
+    mpCurrent = NULL;
+    mpHead    = NULL;
+    mpEnd     = NULL;
+    mStats.mCapacity = 0;
+}
+
+//-----------------------------------------------------------------------------
+CPUTPool::CPUTPool( size_t blockSize, uint32_t blocksPerChunk ) :
+    mBlockSize((blockSize + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1)),
+    mBlocksPerChunk(blocksPerChunk),
+    mpFree(NULL),
+    mpChunks(NULL)
+{
+    assert( blockSize && blocksPerChunk );
+    memset( &mStats, 0, sizeof(mStats) );
+#ifdef _WIN32
+    InitializeCriticalSection( &mLock );
+#else
+    pthread_mutex_init( &mLock, NULL );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+CPUTPool::~CPUTPool()
+{
+    if( 0 == mStats.mLive )
+    {
+        while( mpChunks )
+        {
+            uint8_t *pNext = *(uint8_t**)mpChunks;
+            delete [] mpChunks;
+            mpChunks = pNext;
+        }
+    }
+#ifdef _WIN32
+    DeleteCriticalSection( &mLock );
+#else
+    pthread_mutex_destroy( &mLock );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTPool::Allocate()
+{
+    ALLOCATOR_LOCK(this);
+    if( !mpFree )
+    {
+        uint8_t *pChunk = new uint8_t[sizeof(uint8_t*) + POOL_ALIGNMENT - 1 + mBlockSize * mBlocksPerChunk];
+        *(uint8_t**)pChunk = mpChunks;
+        mpChunks = pChunk;
+        mStats.mHeapAllocations++;
+
+        // Link the blocks so they're handed out in address order
+        uint8_t *pFirst = AlignUp( pChunk + sizeof(uint8_t*), POOL_ALIGNMENT );
+        for( uint32_t ii=mBlocksPerChunk; ii>0; ii-- )
+        {
+            Block *pBlock  = (Block*)(pFirst + (ii - 1) * mBlockSize);
+            pBlock->mpNext = mpFree;
+            mpFree         = pBlock;
+        }
+    }
+    Block *pBlock = mpFree;
+    mpFree = pBlock->mpNext;
+    mStats.mAllocations++;
+    mStats.mLive++;
+    mStats.mPeak = mStats.mLive > mStats.mPeak ? mStats.mLive : mStats.mPeak;
+    ALLOCATOR_UNLOCK(this);
+    return pBlock;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTPool::Free( void *pBlock )
+{
+    if( !pBlock )
+    {
+        return;
+    }
+    ALLOCATOR_LOCK(this);
+    assert( mStats.mLive > 0 );
+    ((Block*)pBlock)->mpNext = mpFree;
+    mpFree = (Block*)pBlock;
+    mStats.mLive--;
+    ALLOCATOR_UNLOCK(this);
+}
+
+//-----------------------------------------------------------------------------
+CPUTPoolStats CPUTPool::GetStats()
+{
+    ALLOCATOR_LOCK(this);
+    CPUTPoolStats stats = mStats;
+    ALLOCATOR_UNLOCK(this);
+    return stats;
+}
+
+//-----------------------------------------------------------------------------
+CPUTPoolSet::CPUTPoolSet( size_t granularity, size_t maxSize, uint32_t blocksPerChunk ) :
+    mppPools(NULL),
+    mPoolCount((uint32_t)(maxSize / granularity)),
+    mGranularity(granularity),
+    mHeapBlocks(0),
+    mHeapBlocksLive(0)
+{
+    assert( granularity && mPoolCount );
+    mppPools = new CPUTPool*[mPoolCount];
+    for( uint32_t ii=0; ii<mPoolCount; ii++ )
+    {
+        mppPools[ii] = new CPUTPool( (ii + 1) * granularity, blocksPerChunk );
+    }
+}
+
+//-----------------------------------------------------------------------------
+CPUTPoolSet::~CPUTPoolSet()
+{
+    for( uint32_t ii=0; ii<mPoolCount; ii++ )
+    {
+        delete mppPools[ii];
+    }
+    delete [] mppPools;
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTPoolSet::Allocate( size_t size )
+{
+    size_t index = size ? (size - 1) / mGranularity : 0;
+    if( index < mPoolCount )
+    {
+        return mppPools[index]->Allocate();
+    }
+    ALLOCATOR_ADD( &mHeapBlocks, 1 );
+    ALLOCATOR_ADD( &mHeapBlocksLive, 1 );
+    return ::operator new( size );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTPoolSet::Free( void *pBlock, size_t size )
+{
+    if( !pBlock )
+    {
+        return;
+    }
+    size_t index = size ? (size - 1) / mGranularity : 0;
+    if( index < mPoolCount )
+    {
+        mppPools[index]->Free( pBlock );
+        return;
+    }
+    ALLOCATOR_ADD( &mHeapBlocksLive, -1 );
+    ::operator delete( pBlock );
+}
+
+//-----------------------------------------------------------------------------
+CPUTPoolStats CPUTPoolSet::GetStats()
+{
+    CPUTPoolStats stats;
+    memset( &stats, 0, sizeof(stats) );
+    for( uint32_t ii=0; ii<mPoolCount; ii++ )
+    {
+        CPUTPoolStats poolStats = mppPools[ii]->GetStats();
+        stats.mAllocations     += poolStats.mAllocations;
+        stats.mHeapAllocations += poolStats.mHeapAllocations;
+        stats.mLive            += poolStats.mLive;
+        stats.mPeak            += poolStats.mPeak;
+    }
+    long heapBlocks = ALLOCATOR_ADD( &mHeapBlocks, 0 );
+    long heapLive   = ALLOCATOR_ADD( &mHeapBlocksLive, 0 );
+    stats.mAllocations     += heapBlocks;
+    stats.mHeapAllocations += heapBlocks;
+    stats.mLive            += heapLive;
+    return stats;
+}
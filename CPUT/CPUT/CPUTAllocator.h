@@ -0,0 +1,216 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTALLOCATOR_H__
+#define __CPUTALLOCATOR_H__
+
+// Allocators for memory with a known lifetime.
+//
+// CPUTArena hands out memory by bumping a pointer through chunks it keeps, and frees it
+// all at once: on Reset(), or when a CPUTArenaScope ends.  CPUT uses one arena for data
+// that lives for one frame (CPUT::GetFrameArena(), reset by InnerExecutionLoop()) and
+// one for data that lives while a file is parsed (CPUTAssetLibrary::GetLoadArena()).
+// Arena memory is never destructed: only put PODs in it.
+//
+// CPUTPool hands out blocks of one size from a free list, and CPUTPoolSet keeps a pool
+// per size class.  Render nodes come from a pool set (see CPUTRenderNode::operator new),
+// so an asset set's nodes sit together and releasing them doesn't fragment the heap.
+//
+// Defining CPUT_COUNT_HEAP_ALLOCATIONS (for the whole build) replaces the global operator
+// new and delete with ones that count heap allocations, process-wide, with an interlocked
+// add per call (see CPUTGetHeapCounters()).  It is off by default: replacing them affects
+// every library linked into the app, not just CPUT.
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#endif
+
+// Totals since the process started.  All 0 without CPUT_COUNT_HEAP_ALLOCATIONS.
+//-----------------------------------------------------------------------------
+struct CPUTHeapCounters
+{
+    uint64_t mAllocations;
+    uint64_t mFrees;
+    uint64_t mBytes;            // Allocated; frees aren't subtracted
+};
+
+CPUTHeapCounters CPUTGetHeapCounters();
+
+// What one frame allocated.  The heap counts include every thread's allocations.
+//-----------------------------------------------------------------------------
+struct CPUTFrameAllocations
+{
+    uint64_t mHeapAllocations;
+    uint64_t mHeapBytes;
+    uint64_t mArenaAllocations;
+    uint64_t mArenaBytes;
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTArenaStats
+{
+    uint64_t mAllocations;      // Since the last Reset()
+    uint64_t mBytes;            // Since the last Reset(), including alignment padding
+    uint64_t mChunkAllocations; // Heap allocations made for chunks, ever
+    size_t   mUsed;
+    size_t   mPeak;             // Most ever used at once
+    size_t   mCapacity;         // Of the chunks held
+};
+
+//-----------------------------------------------------------------------------
+class CPUTArena
+{
+protected:
+    struct Chunk
+    {
+        Chunk  *mpNext;
+        size_t  mSize;          // Bytes after the header
+    };
+
+    Chunk          *mpFirst;
+    Chunk          *mpCurrent;  // Chunks after it are free
+    uint8_t        *mpHead;
+    uint8_t        *mpEnd;
+    size_t          mChunkSize;
+    CPUTArenaStats  mStats;
+
+    void *AllocateFromNextChunk( size_t size, size_t alignment );
+    void  FreeChunks();
+
+public:
+    struct Mark
+    {
+        Chunk   *mpChunk;
+        uint8_t *mpHead;
+        size_t   mUsed;
+    };
+
+    // Takes no memory until the first Allocate()
+    CPUTArena( size_t chunkSize = 64 * 1024 );
+    ~CPUTArena();
+
+    // alignment is a power of two.  Allocations larger than the chunk size get a chunk of their own.
+    void *Allocate( size_t size, size_t alignment = 16 );
+    template<class T> T *AllocateArray( size_t count ) { return (T*)Allocate( sizeof(T) * count ); }
+
+    // Frees everything allocated since GetMark().  Chunks stay for reuse.  Don't Reset() or
+    // ReleaseMemory() between the two.
+    Mark  GetMark() const;
+    void  Rewind( const Mark &mark );
+
+    // Frees everything.  If the allocations since the last Reset() needed more than one chunk,
+    // the chunks are replaced by a single one that holds them all, so the same allocations
+    // don't go to the heap again.
+    void  Reset();
+
+    // Frees everything and gives the chunks back to the heap
+    void  ReleaseMemory();
+
+    const CPUTArenaStats &GetStats() const { return mStats; }
+};
+
+// Rewinds an arena, when it goes out of scope, to where it was when the scope started
+//-----------------------------------------------------------------------------
+class CPUTArenaScope
+{
+protected:
+    CPUTArena       &mArena;
+    CPUTArena::Mark  mMark;
+
+    CPUTArenaScope &operator=( const CPUTArenaScope & );
+
+public:
+    CPUTArenaScope( CPUTArena &arena ) : mArena(arena), mMark(arena.GetMark()) {}
+    ~CPUTArenaScope() { mArena.Rewind( mMark ); }
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTPoolStats
+{
+    uint64_t mAllocations;
+    uint64_t mHeapAllocations;  // Chunks, plus (for a CPUTPoolSet) blocks too large for any pool
+    uint32_t mLive;             // Blocks allocated and not yet freed
+    uint32_t mPeak;
+};
+
+// Thread safe
+//-----------------------------------------------------------------------------
+class CPUTPool
+{
+protected:
+    struct Block
+    {
+        Block *mpNext;
+    };
+
+    size_t          mBlockSize;
+    uint32_t        mBlocksPerChunk;
+    Block          *mpFree;
+    uint8_t        *mpChunks;   // Each starts with a pointer to the next
+    CPUTPoolStats   mStats;
+
+#ifdef _WIN32
+    CRITICAL_SECTION mLock;
+#else
+    pthread_mutex_t  mLock;
+#endif
+
+    CPUTPool( const CPUTPool & );
+    CPUTPool &operator=( const CPUTPool & );
+
+public:
+    // Blocks are 16-byte aligned, and at least blockSize bytes
+    CPUTPool( size_t blockSize, uint32_t blocksPerChunk = 64 );
+
+    // Frees the chunks only if every block was freed: a block still in use stays valid.
+    ~CPUTPool();
+
+    void  *Allocate();
+    void   Free( void *pBlock );
+    size_t GetBlockSize() const { return mBlockSize; }
+    CPUTPoolStats GetStats();
+};
+
+// Pools for every multiple of granularity up to maxSize.  Larger blocks come from the heap.
+//-----------------------------------------------------------------------------
+class CPUTPoolSet
+{
+protected:
+    CPUTPool      **mppPools;
+    uint32_t        mPoolCount;
+    size_t          mGranularity;
+    volatile long   mHeapBlocks;     // Blocks too large for any pool, ever
+    volatile long   mHeapBlocksLive; // and not yet freed
+
+    CPUTPoolSet( const CPUTPoolSet & );
+    CPUTPoolSet &operator=( const CPUTPoolSet & );
+
+public:
+    CPUTPoolSet( size_t granularity, size_t maxSize, uint32_t blocksPerChunk = 64 );
+    ~CPUTPoolSet();
+
+    // Free() must get the same size as Allocate() did
+    void *Allocate( size_t size );
+    void  Free( void *pBlock, size_t size );
+
+    // Summed over the pools.  mPeak leaves out the blocks from the heap.
+    CPUTPoolStats GetStats();
+};
+
+#endif // __CPUTALLOCATOR_H__
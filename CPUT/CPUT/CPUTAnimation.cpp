@@ -0,0 +1,513 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTAnimation.h"
+#include "CPUTThreadPool.h"
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+static const float SQRT_2     = 1.41421356f;
+static const float INV_SQRT_2 = 0.70710678f;
+
+// IEEE half precision, rounding to nearest even.  Values outside the half range
+// (including infinities and NaNs) clamp to +-65504.
+//-----------------------------------------------------------------------------
+static uint16_t FloatToHalf( float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t abs  = bits & 0x7FFFFFFF;
+    if( abs >= 0x477FF000 )
+    {
+        return (uint16_t)(sign | 0x7BFF);
+    }
+    if( abs < 0x38800000 )
+    {
+        // Denormal: multiples of 2^-24
+        float absValue;
+        memcpy( &absValue, &abs, sizeof(absValue) );
+        return (uint16_t)(sign | (uint32_t)(absValue * 16777216.0f + 0.5f));
+    }
+    abs -= 0x38000000; // Rebias the exponent from 127 to 15
+    return (uint16_t)(sign | ((abs + 0xFFF + ((abs >> 13) & 1)) >> 13));
+}
+
+// Shifting the exponent and mantissa into place and multiplying by 2^112 rebiases
+// the exponent, and turns half denormals into float normals, without branches.
+//-----------------------------------------------------------------------------
+static inline float HalfToFloat( uint16_t half )
+{
+    uint32_t bits = (uint32_t)(half & 0x7FFF) << 13;
+    float value;
+    memcpy( &value, &bits, sizeof(value) );
+    value *= 5.192296858534828e33f;
+    return (half & 0x8000) ? -value : value;
+}
+
+// Drops the largest component (its index goes in the top bits of the first two values)
+// and stores the others, which lie within +-1/sqrt(2), with 15 bits each.
+//-----------------------------------------------------------------------------
+static void EncodeSmallestThree( const quaternion &rotation, uint16_t *pBits )
+{
+    float component[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+    uint32_t largest = 0;
+    for( uint32_t ii=1; ii<4; ii++ )
+    {
+        if( fabsf(component[ii]) > fabsf(component[largest]) )
+        {
+            largest = ii;
+        }
+    }
+    // q and -q are the same rotation, so make the dropped component positive
+    float sign = component[largest] < 0.0f ? -1.0f : 1.0f;
+    uint32_t count = 0;
+    for( uint32_t ii=0; ii<4; ii++ )
+    {
+        if( ii != largest )
+        {
+            float value = (component[ii] * sign * SQRT_2) * 0.5f + 0.5f;
+            value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+            pBits[count++] = (uint16_t)(value * 32767.0f + 0.5f);
+        }
+    }
+    pBits[0] |= (uint16_t)((largest & 1) << 15);
+    pBits[1] |= (uint16_t)((largest >> 1) << 15);
+}
+
+//-----------------------------------------------------------------------------
+static quaternion DecodeSmallestThree( const uint16_t *pBits )
+{
+    static const uint8_t kept[4][3] = { {1,2,3}, {0,2,3}, {0,1,3}, {0,1,2} };
+    uint32_t largest = (pBits[0] >> 15) | ((pBits[1] >> 15) << 1);
+    const float scale = 2.0f / 32767.0f * INV_SQRT_2;
+    float component[4];
+    float lengthSq = 1.0f;
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        float value = (float)(pBits[ii] & 0x7FFF) * scale - INV_SQRT_2;
+        component[kept[largest][ii]] = value;
+        lengthSq -= value * value;
+    }
+    component[largest] = lengthSq > 0.0f ? sqrtf(lengthSq) : 0.0f;
+    return quaternion( component[0], component[1], component[2], component[3] );
+}
+
+//-----------------------------------------------------------------------------
+static void EncodeVectors( CPUT_ANIMATION_VECTOR_FORMAT format, const float3 *pValues, uint32_t count,
+                           std::vector<float> *pFloats, std::vector<uint16_t> *pBits, float *pMin, float *pStep )
+{
+    pMin[0] = pMin[1] = pMin[2] = 0.0f;
+    pStep[0] = pStep[1] = pStep[2] = 0.0f;
+    if( CPUT_ANIMATION_VECTOR_FLOAT32 == format )
+    {
+        for( uint32_t ii=0; ii<count; ii++ )
+        {
+            pFloats->push_back( pValues[ii].x );
+            pFloats->push_back( pValues[ii].y );
+            pFloats->push_back( pValues[ii].z );
+        }
+    }
+    else if( CPUT_ANIMATION_VECTOR_FLOAT16 == format )
+    {
+        for( uint32_t ii=0; ii<count; ii++ )
+        {
+            pBits->push_back( FloatToHalf( pValues[ii].x ) );
+            pBits->push_back( FloatToHalf( pValues[ii].y ) );
+            pBits->push_back( FloatToHalf( pValues[ii].z ) );
+        }
+    }
+    else
+    {
+        for( uint32_t cc=0; cc<3; cc++ )
+        {
+            float minValue = (&pValues[0].x)[cc];
+            float maxValue = minValue;
+            for( uint32_t ii=1; ii<count; ii++ )
+            {
+                float value = (&pValues[ii].x)[cc];
+                minValue = value < minValue ? value : minValue;
+                maxValue = value > maxValue ? value : maxValue;
+            }
+            pMin[cc]  = minValue;
+            pStep[cc] = (maxValue - minValue) / 65535.0f;
+        }
+        for( uint32_t ii=0; ii<count; ii++ )
+        {
+            for( uint32_t cc=0; cc<3; cc++ )
+            {
+                float steps = pStep[cc] > 0.0f ? ((&pValues[ii].x)[cc] - pMin[cc]) / pStep[cc] : 0.0f;
+                steps = steps > 65535.0f ? 65535.0f : steps;
+                pBits->push_back( (uint16_t)(steps + 0.5f) );
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static inline float3 DecodeVector( CPUT_ANIMATION_VECTOR_FORMAT format, const float *pFloats, const uint16_t *pBits, uint32_t key, const float *pMin, const float *pStep )
+{
+    if( CPUT_ANIMATION_VECTOR_FLOAT32 == format )
+    {
+        const float *pValue = pFloats + key*3;
+        return float3( pValue[0], pValue[1], pValue[2] );
+    }
+    const uint16_t *pValue = pBits + key*3;
+    if( CPUT_ANIMATION_VECTOR_FLOAT16 == format )
+    {
+        return float3( HalfToFloat( pValue[0] ), HalfToFloat( pValue[1] ), HalfToFloat( pValue[2] ) );
+    }
+    return float3( pMin[0] + (float)pValue[0] * pStep[0],
+                   pMin[1] + (float)pValue[1] * pStep[1],
+                   pMin[2] + (float)pValue[2] * pStep[2] );
+}
+
+//-----------------------------------------------------------------------------
+static inline float3 Lerp( const float3 &a, const float3 &b, float t )
+{
+    return float3( a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t );
+}
+
+// scale * rotation * translation, in the row-vector convention
+//-----------------------------------------------------------------------------
+static inline void ComposeMatrix( const float3 &translation, const quaternion &q, const float3 &scale, float4x4 *pMatrix )
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, zw = q.z * q.w, xz = q.x * q.z;
+    float yw = q.y * q.w, yz = q.y * q.z, xw = q.x * q.w;
+    pMatrix->r0 = float4( (1 - 2*(yy+zz)) * scale.x,      2*(xy+zw)  * scale.x,      2*(xz-yw)  * scale.x, 0.0f );
+    pMatrix->r1 = float4(      2*(xy-zw)  * scale.y, (1 - 2*(xx+zz)) * scale.y,      2*(yz+xw)  * scale.y, 0.0f );
+    pMatrix->r2 = float4(      2*(xz+yw)  * scale.z,      2*(yz-xw)  * scale.z, (1 - 2*(xx+yy)) * scale.z, 0.0f );
+    pMatrix->r3 = float4( translation, 1.0f );
+}
+
+//-----------------------------------------------------------------------------
+CPUTAnimationClip::CPUTAnimationClip( CPUT_ANIMATION_VECTOR_FORMAT translationFormat, CPUT_ANIMATION_ROTATION_FORMAT rotationFormat, CPUT_ANIMATION_VECTOR_FORMAT scaleFormat ) :
+    mTranslationFormat(translationFormat),
+    mRotationFormat(rotationFormat),
+    mScaleFormat(scaleFormat),
+    mDuration(0.0f)
+{
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTAnimationClip::AddChannel( uint32_t keyCount, const float *pTimes, const float3 *pTranslations, const quaternion *pRotations, const float3 *pScales )
+{
+    assert( keyCount > 0 );
+    Channel channel;
+    channel.mFirstKey = (uint32_t)mTimes.size();
+    channel.mKeyCount = keyCount;
+    for( uint32_t ii=0; ii<keyCount; ii++ )
+    {
+        assert( 0 == ii || pTimes[ii] > pTimes[ii-1] );
+        mTimes.push_back( pTimes[ii] );
+    }
+    mDuration = pTimes[keyCount-1] > mDuration ? pTimes[keyCount-1] : mDuration;
+
+    EncodeVectors( mTranslationFormat, pTranslations, keyCount, &mTranslations, &mTranslationBits, channel.mTranslationMin, channel.mTranslationStep );
+    EncodeVectors( mScaleFormat, pScales, keyCount, &mScales, &mScaleBits, channel.mScaleMin, channel.mScaleStep );
+    for( uint32_t ii=0; ii<keyCount; ii++ )
+    {
+        if( CPUT_ANIMATION_ROTATION_FLOAT32 == mRotationFormat )
+        {
+            mRotations.push_back( pRotations[ii].x );
+            mRotations.push_back( pRotations[ii].y );
+            mRotations.push_back( pRotations[ii].z );
+            mRotations.push_back( pRotations[ii].w );
+        }
+        else
+        {
+            uint16_t bits[3];
+            EncodeSmallestThree( pRotations[ii], bits );
+            mRotationBits.insert( mRotationBits.end(), bits, bits + 3 );
+        }
+    }
+    mChannels.push_back( channel );
+    return (uint32_t)mChannels.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTAnimationClip::GetKeyDataSize() const
+{
+    return (mTimes.size() + mTranslations.size() + mRotations.size() + mScales.size()) * sizeof(float) +
+           (mTranslationBits.size() + mRotationBits.size() + mScaleBits.size()) * sizeof(uint16_t);
+}
+
+//-----------------------------------------------------------------------------
+float CPUTAnimationClip::WrapTime( double time ) const
+{
+    if( mDuration <= 0.0f )
+    {
+        return 0.0f;
+    }
+    double wrapped = fmod( time, (double)mDuration );
+    return (float)(wrapped < 0.0 ? wrapped + mDuration : wrapped);
+}
+
+// Returns the key at or before time (clamped so that there is a next key), trying the
+// cursor and the key after it before searching.
+//-----------------------------------------------------------------------------
+uint32_t CPUTAnimationClip::FindKey( const Channel &channel, float time, uint32_t cursor ) const
+{
+    const float *pTimes = &mTimes[channel.mFirstKey];
+    uint32_t last = channel.mKeyCount - 1;
+    if( 0 == last )
+    {
+        return 0;
+    }
+    if( cursor < last && pTimes[cursor] <= time )
+    {
+        if( time < pTimes[cursor+1] || cursor+1 == last )
+        {
+            return cursor;
+        }
+        if( time < pTimes[cursor+2] || cursor+2 == last )
+        {
+            return cursor+1;
+        }
+    }
+    // First key after time, among keys 1..last-1.  Times before the first key find key 0,
+    // times after the last find last-1.
+    const float *pNext = std::upper_bound( pTimes + 1, pTimes + last, time );
+    return (uint32_t)(pNext - pTimes) - 1;
+}
+
+// Finds the keys either side of time and decodes them
+//-----------------------------------------------------------------------------
+float CPUTAnimationClip::FetchKeys( uint32_t channelIndex, float time, uint32_t *pCursor, float3 *pTranslations, quaternion *pRotations, float3 *pScales ) const
+{
+    const Channel &channel = mChannels[channelIndex];
+    uint32_t key = FindKey( channel, time, *pCursor );
+    *pCursor = key;
+
+    uint32_t k0 = channel.mFirstKey + key;
+    uint32_t k1 = k0;
+    float fraction = 0.0f;
+    if( channel.mKeyCount > 1 )
+    {
+        k1 = k0 + 1;
+        fraction = (time - mTimes[k0]) / (mTimes[k1] - mTimes[k0]);
+        fraction = fraction < 0.0f ? 0.0f : (fraction > 1.0f ? 1.0f : fraction);
+    }
+
+    const float    *pTranslationFloats = mTranslations.empty()    ? NULL : &mTranslations[0];
+    const uint16_t *pTranslationBits   = mTranslationBits.empty() ? NULL : &mTranslationBits[0];
+    pTranslations[0] = DecodeVector( mTranslationFormat, pTranslationFloats, pTranslationBits, k0, channel.mTranslationMin, channel.mTranslationStep );
+    pTranslations[1] = DecodeVector( mTranslationFormat, pTranslationFloats, pTranslationBits, k1, channel.mTranslationMin, channel.mTranslationStep );
+
+    const float    *pScaleFloats = mScales.empty()    ? NULL : &mScales[0];
+    const uint16_t *pScaleBits   = mScaleBits.empty() ? NULL : &mScaleBits[0];
+    pScales[0] = DecodeVector( mScaleFormat, pScaleFloats, pScaleBits, k0, channel.mScaleMin, channel.mScaleStep );
+    pScales[1] = DecodeVector( mScaleFormat, pScaleFloats, pScaleBits, k1, channel.mScaleMin, channel.mScaleStep );
+
+    if( CPUT_ANIMATION_ROTATION_FLOAT32 == mRotationFormat )
+    {
+        const float *pRotation0 = &mRotations[k0*4];
+        const float *pRotation1 = &mRotations[k1*4];
+        pRotations[0] = quaternion( pRotation0[0], pRotation0[1], pRotation0[2], pRotation0[3] );
+        pRotations[1] = quaternion( pRotation1[0], pRotation1[1], pRotation1[2], pRotation1[3] );
+    }
+    else
+    {
+        pRotations[0] = DecodeSmallestThree( &mRotationBits[k0*3] );
+        pRotations[1] = DecodeSmallestThree( &mRotationBits[k1*3] );
+    }
+    return fraction;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTAnimationClip::Sample( uint32_t channel, float time, uint32_t *pCursor, float3 *pTranslation, quaternion *pRotation, float3 *pScale ) const
+{
+    float3     translations[2], scales[2];
+    quaternion rotations[2];
+    float fraction = FetchKeys( channel, time, pCursor, translations, rotations, scales );
+    *pTranslation = Lerp( translations[0], translations[1], fraction );
+    *pScale       = Lerp( scales[0], scales[1], fraction );
+    *pRotation    = quaternionSlerp( rotations[0], rotations[1], fraction );
+}
+
+// Keys are fetched a channel at a time, into lanes of four channels, and then four
+// channels are interpolated and turned into matrices at once.  The SSE path does the
+// same operations as Sample() and ComposeMatrix(), so the results are identical.
+//-----------------------------------------------------------------------------
+void CPUTAnimationClip::SampleMatrices( float time, uint32_t firstChannel, uint32_t count, uint32_t *pCursors, float4x4 *pMatrices ) const
+{
+    for( uint32_t first=0; first<count; first+=4 )
+    {
+        uint32_t laneCount = std::min( 4u, count - first );
+        float fraction[4];
+        float translation[2][3][4], rotation[2][4][4], scale[2][3][4]; // [key][component][lane]
+        for( uint32_t lane=0; lane<4; lane++ )
+        {
+            // Unused lanes repeat the first channel
+            uint32_t ii = first + (lane < laneCount ? lane : 0);
+            float3     translations[2], scales[2];
+            quaternion rotations[2];
+            fraction[lane] = FetchKeys( firstChannel + ii, time, &pCursors[ii], translations, rotations, scales );
+            for( uint32_t key=0; key<2; key++ )
+            {
+                for( uint32_t cc=0; cc<3; cc++ )
+                {
+                    translation[key][cc][lane] = translations[key].f[cc];
+                    scale[key][cc][lane]       = scales[key].f[cc];
+                }
+                rotation[key][0][lane] = rotations[key].x;
+                rotation[key][1][lane] = rotations[key].y;
+                rotation[key][2][lane] = rotations[key].z;
+                rotation[key][3][lane] = rotations[key].w;
+            }
+        }
+#if defined(CPUT_MATH_SSE)
+        __m128 t = _mm_loadu_ps( fraction );
+        __m128 tx, ty, tz, sx, sy, sz;
+        {
+            __m128 a;
+            a = _mm_loadu_ps( translation[0][0] ); tx = _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( translation[1][0] ), a ), t ) );
+            a = _mm_loadu_ps( translation[0][1] ); ty = _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( translation[1][1] ), a ), t ) );
+            a = _mm_loadu_ps( translation[0][2] ); tz = _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( translation[1][2] ), a ), t ) );
+            a = _mm_loadu_ps( scale[0][0] );       sx = _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( scale[1][0] ), a ), t ) );
+            a = _mm_loadu_ps( scale[0][1] );       sy = _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( scale[1][1] ), a ), t ) );
+            a = _mm_loadu_ps( scale[0][2] );       sz = _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( scale[1][2] ), a ), t ) );
+        }
+
+        // quaternionSlerp()
+        __m128 ax = _mm_loadu_ps( rotation[0][0] ), ay = _mm_loadu_ps( rotation[0][1] ), az = _mm_loadu_ps( rotation[0][2] ), aw = _mm_loadu_ps( rotation[0][3] );
+        __m128 bx = _mm_loadu_ps( rotation[1][0] ), by = _mm_loadu_ps( rotation[1][1] ), bz = _mm_loadu_ps( rotation[1][2] ), bw = _mm_loadu_ps( rotation[1][3] );
+        __m128 cosTheta = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, bx ), _mm_mul_ps( ay, by ) ), _mm_mul_ps( az, bz ) ), _mm_mul_ps( aw, bw ) );
+        __m128 one      = _mm_set1_ps( 1.0f );
+        __m128 signBit  = _mm_and_ps( _mm_cmplt_ps( cosTheta, _mm_setzero_ps() ), _mm_set1_ps( -0.0f ) );
+        __m128 xm1 = _mm_sub_ps( _mm_xor_ps( cosTheta, signBit ), one );
+        __m128 d   = _mm_sub_ps( one, t );
+        __m128 tt  = _mm_mul_ps( t, t );
+        __m128 dd  = _mm_mul_ps( d, d );
+        __m128 wa  = one;
+        __m128 wb  = one;
+        for( int ii=7; ii>=0; ii-- )
+        {
+            __m128 uu = _mm_set1_ps( kSlerpU[ii] );
+            __m128 vv = _mm_set1_ps( kSlerpV[ii] );
+            wa = _mm_add_ps( one, _mm_mul_ps( _mm_mul_ps( _mm_sub_ps( _mm_mul_ps( uu, dd ), vv ), xm1 ), wa ) );
+            wb = _mm_add_ps( one, _mm_mul_ps( _mm_mul_ps( _mm_sub_ps( _mm_mul_ps( uu, tt ), vv ), xm1 ), wb ) );
+        }
+        wa = _mm_mul_ps( wa, d );
+        wb = _mm_mul_ps( wb, _mm_xor_ps( t, signBit ) );
+        __m128 qx = _mm_add_ps( _mm_mul_ps( ax, wa ), _mm_mul_ps( bx, wb ) );
+        __m128 qy = _mm_add_ps( _mm_mul_ps( ay, wa ), _mm_mul_ps( by, wb ) );
+        __m128 qz = _mm_add_ps( _mm_mul_ps( az, wa ), _mm_mul_ps( bz, wb ) );
+        __m128 qw = _mm_add_ps( _mm_mul_ps( aw, wa ), _mm_mul_ps( bw, wb ) );
+
+        // ComposeMatrix()
+        __m128 two = _mm_set1_ps( 2.0f );
+        __m128 xx = _mm_mul_ps( qx, qx ), yy = _mm_mul_ps( qy, qy ), zz = _mm_mul_ps( qz, qz );
+        __m128 xy = _mm_mul_ps( qx, qy ), zw = _mm_mul_ps( qz, qw ), xz = _mm_mul_ps( qx, qz );
+        __m128 yw = _mm_mul_ps( qy, qw ), yz = _mm_mul_ps( qy, qz ), xw = _mm_mul_ps( qx, qw );
+        __m128 r0 = _mm_mul_ps( _mm_sub_ps( one, _mm_mul_ps( two, _mm_add_ps( yy, zz ) ) ), sx );
+        __m128 r1 = _mm_mul_ps( _mm_mul_ps( two, _mm_add_ps( xy, zw ) ), sx );
+        __m128 r2 = _mm_mul_ps( _mm_mul_ps( two, _mm_sub_ps( xz, yw ) ), sx );
+        __m128 r3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+        __m128 row0[4] = { r0, r1, r2, r3 };
+        r0 = _mm_mul_ps( _mm_mul_ps( two, _mm_sub_ps( xy, zw ) ), sy );
+        r1 = _mm_mul_ps( _mm_sub_ps( one, _mm_mul_ps( two, _mm_add_ps( xx, zz ) ) ), sy );
+        r2 = _mm_mul_ps( _mm_mul_ps( two, _mm_add_ps( yz, xw ) ), sy );
+        r3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+        __m128 row1[4] = { r0, r1, r2, r3 };
+        r0 = _mm_mul_ps( _mm_mul_ps( two, _mm_add_ps( xz, yw ) ), sz );
+        r1 = _mm_mul_ps( _mm_mul_ps( two, _mm_sub_ps( yz, xw ) ), sz );
+        r2 = _mm_mul_ps( _mm_sub_ps( one, _mm_mul_ps( two, _mm_add_ps( xx, yy ) ) ), sz );
+        r3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+        __m128 row2[4] = { r0, r1, r2, r3 };
+        r0 = tx; r1 = ty; r2 = tz; r3 = one;
+        _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+        __m128 row3[4] = { r0, r1, r2, r3 };
+        for( uint32_t lane=0; lane<laneCount; lane++ )
+        {
+            float *pMatrix = (float*)&pMatrices[first + lane];
+            _mm_storeu_ps( pMatrix + 0,  row0[lane] );
+            _mm_storeu_ps( pMatrix + 4,  row1[lane] );
+            _mm_storeu_ps( pMatrix + 8,  row2[lane] );
+            _mm_storeu_ps( pMatrix + 12, row3[lane] );
+        }
+#else
+        for( uint32_t lane=0; lane<laneCount; lane++ )
+        {
+            float3 translation0( translation[0][0][lane], translation[0][1][lane], translation[0][2][lane] );
+            float3 translation1( translation[1][0][lane], translation[1][1][lane], translation[1][2][lane] );
+            float3 scale0( scale[0][0][lane], scale[0][1][lane], scale[0][2][lane] );
+            float3 scale1( scale[1][0][lane], scale[1][1][lane], scale[1][2][lane] );
+            quaternion rotation0( rotation[0][0][lane], rotation[0][1][lane], rotation[0][2][lane], rotation[0][3][lane] );
+            quaternion rotation1( rotation[1][0][lane], rotation[1][1][lane], rotation[1][2][lane], rotation[1][3][lane] );
+            ComposeMatrix( Lerp( translation0, translation1, fraction[lane] ),
+                           quaternionSlerp( rotation0, rotation1, fraction[lane] ),
+                           Lerp( scale0, scale1, fraction[lane] ),
+                           &pMatrices[first + lane] );
+        }
+#endif
+    }
+}
+
+// Samples one batch of channels
+//-----------------------------------------------------------------------------
+class CPUTAnimationSampleTask : public CPUTTask
+{
+public:
+    const CPUTAnimationClip *mpClip;
+    float                    mTime;
+    uint32_t                 mChannelCount;
+    uint32_t                *mpCursors;
+    float4x4                *mpMatrices;
+
+    void Execute( uint32_t taskIndex, uint32_t /*threadIndex*/ )
+    {
+        uint32_t first = taskIndex * CPUT_ANIMATION_BATCH_SIZE;
+        uint32_t count = std::min( CPUT_ANIMATION_BATCH_SIZE, mChannelCount - first );
+        mpClip->SampleMatrices( mTime, first, count, mpCursors + first, mpMatrices + first );
+    }
+};
+
+//-----------------------------------------------------------------------------
+void CPUTAnimationSampler::SetClip( const CPUTAnimationClip *pClip )
+{
+    mpClip = pClip;
+    mCursors.assign( pClip ? pClip->GetChannelCount() : 0, 0 );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTAnimationSampler::Evaluate( double time, bool loop, float4x4 *pMatrices, CPUTThreadPool *pPool )
+{
+    uint32_t channelCount = (uint32_t)mCursors.size();
+    if( 0 == channelCount )
+    {
+        return;
+    }
+    float sampleTime = loop ? mpClip->WrapTime( time ) : (float)time;
+    uint32_t batchCount = (channelCount + CPUT_ANIMATION_BATCH_SIZE - 1) / CPUT_ANIMATION_BATCH_SIZE;
+    if( !pPool || pPool->GetThreadCount() < 2 || batchCount < 2 )
+    {
+        mpClip->SampleMatrices( sampleTime, 0, channelCount, &mCursors[0], pMatrices );
+        return;
+    }
+    CPUTAnimationSampleTask task;
+    task.mpClip        = mpClip;
+    task.mTime         = sampleTime;
+    task.mChannelCount = channelCount;
+    task.mpCursors     = &mCursors[0];
+    task.mpMatrices    = pMatrices;
+    pPool->ParallelFor( &task, batchCount );
+}
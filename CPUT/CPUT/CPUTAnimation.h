@@ -0,0 +1,136 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTANIMATION_H__
+#define __CPUTANIMATION_H__
+
+// Keyframed transform animation.  A clip holds one track per channel (a node or a bone),
+// and each key of a track has a time, a translation, a rotation and a scale.  Keys are
+// stored structure-of-arrays: one array of times, one of translations, one of rotations
+// and one of scales, each shared by all channels, with every channel owning a
+// contiguous range of keys.
+//
+// Translations and scales can be stored as halves, or as 16 bit fixed point spread over
+// the channel's range.  Rotations can be stored as "smallest three": the largest
+// component is dropped (and rebuilt from the unit length) and the other three are kept
+// with 15 bits each.  Fully compressed, a key takes 22 bytes instead of 44.
+//
+// Sampling a channel looks for the two keys either side of the time.  The caller keeps
+// a cursor per channel (the key found last time), so playback only checks that key and
+// the next one; a binary search is only needed after a seek.  Rotations are slerped,
+// translations and scales lerped, and times outside a track clamp to its first or last key.
+#include "CPUTMath.h"
+#include <stdint.h>
+#include <vector>
+
+class CPUTThreadPool;
+
+// Channels sampled by one thread pool task
+const uint32_t CPUT_ANIMATION_BATCH_SIZE = 64;
+
+enum CPUT_ANIMATION_VECTOR_FORMAT
+{
+    CPUT_ANIMATION_VECTOR_FLOAT32,
+    CPUT_ANIMATION_VECTOR_FLOAT16,
+    CPUT_ANIMATION_VECTOR_FIXED16,          // 65536 steps between the channel's min and max
+};
+
+enum CPUT_ANIMATION_ROTATION_FORMAT
+{
+    CPUT_ANIMATION_ROTATION_FLOAT32,
+    CPUT_ANIMATION_ROTATION_SMALLEST_THREE, // 48 bits
+};
+
+//-----------------------------------------------------------------------------
+class CPUTAnimationClip
+{
+protected:
+    struct Channel
+    {
+        uint32_t mFirstKey;
+        uint32_t mKeyCount;
+        float    mTranslationMin[3];   // FIXED16 decodes to min + value * step
+        float    mTranslationStep[3];
+        float    mScaleMin[3];
+        float    mScaleStep[3];
+    };
+
+    CPUT_ANIMATION_VECTOR_FORMAT   mTranslationFormat;
+    CPUT_ANIMATION_ROTATION_FORMAT mRotationFormat;
+    CPUT_ANIMATION_VECTOR_FORMAT   mScaleFormat;
+    std::vector<Channel>           mChannels;
+    float                          mDuration;
+
+    // Indexed by key.  The FLOAT32 formats use the float arrays (3 floats a vector, 4 a
+    // rotation); the others use the uint16_t arrays (3 values a key).
+    std::vector<float>             mTimes;
+    std::vector<float>             mTranslations;
+    std::vector<uint16_t>          mTranslationBits;
+    std::vector<float>             mRotations;
+    std::vector<uint16_t>          mRotationBits;
+    std::vector<float>             mScales;
+    std::vector<uint16_t>          mScaleBits;
+
+    uint32_t FindKey( const Channel &channel, float time, uint32_t cursor ) const;
+    float    FetchKeys( uint32_t channel, float time, uint32_t *pCursor, float3 *pTranslations, quaternion *pRotations, float3 *pScales ) const;
+
+public:
+    CPUTAnimationClip( CPUT_ANIMATION_VECTOR_FORMAT   translationFormat = CPUT_ANIMATION_VECTOR_FLOAT32,
+                       CPUT_ANIMATION_ROTATION_FORMAT rotationFormat    = CPUT_ANIMATION_ROTATION_FLOAT32,
+                       CPUT_ANIMATION_VECTOR_FORMAT   scaleFormat       = CPUT_ANIMATION_VECTOR_FLOAT32 );
+
+    // Copies (and encodes) keyCount keys, which must be in increasing time order.
+    // Rotations must be unit length.  Returns the new channel's index.
+    uint32_t AddChannel( uint32_t keyCount, const float *pTimes, const float3 *pTranslations, const quaternion *pRotations, const float3 *pScales );
+
+    uint32_t GetChannelCount() const               { return (uint32_t)mChannels.size(); }
+    uint32_t GetKeyCount( uint32_t channel ) const { return mChannels[channel].mKeyCount; }
+    float    GetDuration() const                   { return mDuration; }   // Last key time of any channel
+    uint64_t GetKeyDataSize() const;                                       // Bytes
+
+    // time modulo the duration, for looping playback
+    float    WrapTime( double time ) const;
+
+    // pCursor is the channel's cursor; start it at 0.
+    void     Sample( uint32_t channel, float time, uint32_t *pCursor, float3 *pTranslation, quaternion *pRotation, float3 *pScale ) const;
+
+    // pMatrices[ii] = scale * rotation * translation of channel firstChannel+ii, using
+    // (and updating) pCursors[ii]
+    void     SampleMatrices( float time, uint32_t firstChannel, uint32_t count, uint32_t *pCursors, float4x4 *pMatrices ) const;
+};
+
+// Playback state of one instance of a clip (a cursor per channel), so that many
+// instances can play the same clip at different times.
+//-----------------------------------------------------------------------------
+class CPUTAnimationSampler
+{
+protected:
+    const CPUTAnimationClip *mpClip;
+    std::vector<uint32_t>    mCursors;
+
+public:
+    CPUTAnimationSampler( const CPUTAnimationClip *pClip = NULL ) : mpClip(NULL) { SetClip( pClip ); }
+
+    // Call again after adding channels to the clip
+    void                     SetClip( const CPUTAnimationClip *pClip );
+    const CPUTAnimationClip *GetClip() const { return mpClip; }
+
+    // Samples every channel of the clip into pMatrices (GetChannelCount() of them).  loop
+    // wraps time to the clip's duration.  With a pool, batches of CPUT_ANIMATION_BATCH_SIZE
+    // channels run on its threads.
+    void Evaluate( double time, bool loop, float4x4 *pMatrices, CPUTThreadPool *pPool = NULL );
+};
+
+#endif // __CPUTANIMATION_H__
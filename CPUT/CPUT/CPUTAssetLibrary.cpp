@@ -13,7 +13,6 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 /////////////////////////////////////////////////////////////////////////////////////////////
-#include <algorithm> // for std::string.transform()
 #include "CPUTAssetLibrary.h"
 #include "CPUTRenderNode.h"
 #include "CPUTAssetSet.h"
@@ -39,6 +38,13 @@ CPUTAssetListEntry *CPUTAssetLibrary::mpBufferList = NULL;
 CPUTAssetListEntry *CPUTAssetLibrary::mpConstantBufferList = NULL;
 CPUTAssetListEntry *CPUTAssetLibrary::mpRenderStateBlockList = NULL;
 CPUTAssetListEntry *CPUTAssetLibrary::mpFontList = NULL;
+CPUTArena           CPUTAssetLibrary::mLoadArena( 1024 * 1024 );
+CPUTFlatHashMap<CPUTAssetListEntry*> CPUTAssetLibrary::mAssetIndex;
+CPUTFlatHashMap<CPUTMaterial*>       CPUTAssetLibrary::mMaterialsByContent;
+CPUTMaterialStats                    CPUTAssetLibrary::mMaterialStats;
+bool                                 CPUTAssetLibrary::mOptimizeMeshes = false;
+CPUTMeshOptimizerSettings            CPUTAssetLibrary::mMeshOptimizerSettings;
+CPUTMeshOptimizerStats               CPUTAssetLibrary::mMeshOptimizerStats;
 
 //-----------------------------------------------------------------------------
 void CPUTAssetLibrary::ReleaseTexturesAndBuffers()
@@ -62,6 +68,17 @@ void CPUTAssetLibrary::RebindTexturesAndBuffers()
     }
 }
 
+//-----------------------------------------------------------------------------
+void CPUTAssetLibrary::RebindTextures( const std::vector<CPUTTexture*> &textures )
+{
+    CPUTAssetListEntry *pMaterial = mpMaterialList;
+    while( pMaterial )
+    {
+        ((CPUTMaterial*)pMaterial->pData)->RebindTextures( textures );
+        pMaterial = pMaterial->pNext;
+    }
+}
+
 //-----------------------------------------------------------------------------
 void CPUTAssetLibrary::DeleteAssetLibrary()
 {
@@ -74,7 +91,7 @@ void CPUTAssetLibrary::ReleaseAllLibraryLists()
     // Release philosophy:  Everyone that references releases.  If node refers to parent, then it should release parent, etc...
     // TODO: Traverse lists.  Print names and ref counts (as debug aid)
 #undef SAFE_RELEASE_LIST
-#define SAFE_RELEASE_LIST(x) {ReleaseList(x); x = NULL;}
+#define SAFE_RELEASE_LIST(x) ReleaseList(&(x));
 
     SAFE_RELEASE_LIST(mpAssetSetList);
     SAFE_RELEASE_LIST(mpMaterialList);
@@ -87,6 +104,9 @@ void CPUTAssetLibrary::ReleaseAllLibraryLists()
     SAFE_RELEASE_LIST(mpConstantBufferList );
     SAFE_RELEASE_LIST(mpRenderStateBlockList );
     SAFE_RELEASE_LIST(mpFontList);
+    mMaterialsByContent.Clear();
+    memset( &mMaterialStats, 0, sizeof(mMaterialStats) );
+    mMeshOptimizerStats = CPUTMeshOptimizerStats();
 
     // The following -specific items are destroyed in the derived class
     // TODO.  Move their declaration and definition to the derived class too
@@ -95,19 +115,24 @@ void CPUTAssetLibrary::ReleaseAllLibraryLists()
     // SAFE_RELEASE_LIST(mpGeometryShaderList);
 }
 
+// Releases the list's assets, deletes its entries and empties it
 //-----------------------------------------------------------------------------
-void CPUTAssetLibrary::ReleaseList(CPUTAssetListEntry *pLibraryRoot)
+void CPUTAssetLibrary::ReleaseList(CPUTAssetListEntry **ppLibraryRoot)
 {
     CPUTAssetListEntry *pNext;
-    for( CPUTAssetListEntry *pNodeEntry = pLibraryRoot; NULL != pNodeEntry; pNodeEntry = pNext )
+    for( CPUTAssetListEntry *pNodeEntry = *ppLibraryRoot; NULL != pNodeEntry; pNodeEntry = pNext )
     {
         pNext = pNodeEntry->pNext;
         CPUTRenderNode *pDebugNode = (CPUTRenderNode*)pNodeEntry->pData;
         CPUTRefCount *pRefCountedNode = (CPUTRefCount*)pNodeEntry->pData;
         pRefCountedNode->Release();
         HEAPCHECK;
+        // The index has no erase: leave a NULL behind
+        mAssetIndex.Insert( GetIndexKey( ppLibraryRoot, pNodeEntry->nameID ), NULL );
         delete pNodeEntry;
     }
+    mAssetIndex.Insert( GetIndexKey( ppLibraryRoot, CPUT_STRING_ID_NONE ), NULL );
+    *ppLibraryRoot = NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -125,49 +150,55 @@ void CPUTAssetLibrary::DeleteListEntries(CPUTAssetListEntry *pLibraryRoot)
 // Find an asset in a specific library
 // ** Does not Addref() returned items **
 // Asset library doesn't care if we're using absolute paths for names or not, it
-// just adds/finds/deletes the matching string literal.
+// just adds/finds/deletes the matching string literal (ignoring case).
 //-----------------------------------------------------------------------------
-void *CPUTAssetLibrary::FindAsset(const cString &name, CPUTAssetListEntry *pList, bool nameIsFullPathAndFilename)
+void *CPUTAssetLibrary::FindAsset(const cString &name, CPUTAssetListEntry **ppList, bool nameIsFullPathAndFilename)
 {
+    if( nameIsFullPathAndFilename )
+    {
+        return FindAsset( CPUTStringTable::Find( name ), ppList );
+    }
     cString absolutePathAndFilename;
     CPUTOSServices *pServices = CPUTOSServices::GetOSServices();
-    pServices->ResolveAbsolutePathAndFilename( nameIsFullPathAndFilename ? name : (mAssetSetDirectoryName + name), &absolutePathAndFilename);
-    absolutePathAndFilename = nameIsFullPathAndFilename ? name : absolutePathAndFilename;
+    pServices->ResolveAbsolutePathAndFilename( mAssetSetDirectoryName + name, &absolutePathAndFilename);
 
-    UINT hash = CPUTComputeHash( absolutePathAndFilename );
-    while(NULL!=pList)
+    // A name that was never interned can't name an asset
+    return FindAsset( CPUTStringTable::Find( absolutePathAndFilename ), ppList );
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTAssetLibrary::FindAsset(CPUTStringID nameID, CPUTAssetListEntry **ppList)
+{
+    if( CPUT_STRING_ID_NONE == nameID )
     {
-        if( hash == pList->hash && (0 == _wcsicmp( absolutePathAndFilename.data(), pList->name.data() )) )
-        {
-            return (void*)pList->pData;
-        }
-        pList = pList->pNext;
+        return NULL;
     }
-    return NULL;
+    CPUTAssetListEntry **ppEntry = mAssetIndex.Find( GetIndexKey( ppList, nameID ) );
+    if( !ppEntry || !*ppEntry )
+    {
+        return NULL;
+    }
+    ASSERT( (*ppEntry)->nameID == nameID, _L("Asset index key collision") );
+    return (*ppEntry)->pData;
 }
 
 //-----------------------------------------------------------------------------
 void CPUTAssetLibrary::AddAsset(const cString &name, void *pAsset, CPUTAssetListEntry **pHead)
 {
-    // convert string to lowercase
-    cString lowercaseName = name;
-    std::transform(lowercaseName.begin(), lowercaseName.end(), lowercaseName.begin(), ::tolower);
-
-    // Do we already have one by this name?
-    CPUTAssetListEntry *pTail = *pHead;
-    // TODO:  Save explicit tail pointer instead of iterating to find the null.
-    for( CPUTAssetListEntry *pCur=*pHead; NULL!=pCur; pCur=pCur->pNext )
-    {
-        // Assert that we haven't added one with this name
-        ASSERT( 0 != _wcsicmp( pCur->name.data(), name.data() ), _L("Warning: asset ")+name+_L(" already exists") );
-        pTail = pCur;
-    }
+    CPUTStringID nameID = CPUTStringTable::Intern( name );
+
+    // Assert that we haven't added one with this name
+    ASSERT( NULL == FindAsset( nameID, pHead ), _L("Warning: asset ")+name+_L(" already exists") );
+
+    CPUTAssetListEntry **ppTail = mAssetIndex.Find( GetIndexKey( pHead, CPUT_STRING_ID_NONE ) );
+    CPUTAssetListEntry *pTail = ( ppTail && *pHead ) ? *ppTail : NULL;
     CPUTAssetListEntry **pDest = pTail ? &pTail->pNext : pHead;
     *pDest = new CPUTAssetListEntry();
-    (*pDest)->hash = CPUTComputeHash(name);
-    (*pDest)->name = name;
+    (*pDest)->nameID = nameID;
     (*pDest)->pData = pAsset;
     (*pDest)->pNext = NULL;
+    mAssetIndex.Insert( GetIndexKey( pHead, nameID ), *pDest );
+    mAssetIndex.Insert( GetIndexKey( pHead, CPUT_STRING_ID_NONE ), *pDest );
 
     // TODO: Our assets are not yet all derived from CPUTRenderNode.
     // TODO: For now, rely on caller performing the AddRef() as it knows the assets type.
@@ -246,13 +277,51 @@ CPUTMaterial *CPUTAssetLibrary::GetMaterial(const cString &name, bool nameIsFull
     }
 
     // We need to clone the material.  Do that by loading it again, but with a different name.
-    // Add the model's suffix (address as string, plus model's material array index as string)
-    CPUTMaterial *pUniqueMaterial = FindMaterial(absolutePathAndFilename + modelSuffix + meshSuffix, true);
-    ASSERT( NULL == pUniqueMaterial, _L("Unique material already not unique: ") + absolutePathAndFilename + modelSuffix + meshSuffix );
+    // Add the model's suffix (address as string, plus model's material array index as string).
+    // Joined in place: operator+ would allocate a temporary string per term.
+    cString uniqueName;
+    uniqueName.reserve( absolutePathAndFilename.length() + modelSuffix.length() + meshSuffix.length() );
+    uniqueName.append( absolutePathAndFilename ).append( modelSuffix ).append( meshSuffix );
+    CPUTMaterial *pUniqueMaterial = FindMaterial(uniqueName, true);
+    ASSERT( NULL == pUniqueMaterial, _L("Unique material already not unique: ") + uniqueName );
 
     return pMaterial->CloneMaterial( absolutePathAndFilename, modelSuffix, meshSuffix );
 }
 
+// Materials are kept alive by the material list, so the table holds no references
+//-----------------------------------------------------------------------------
+CPUTMaterial *CPUTAssetLibrary::FindIdenticalMaterial( CPUTMaterial *pMaterial )
+{
+    size_t bytes = pMaterial->GetMemoryUsage();
+    mMaterialStats.mLoaded++;
+
+    std::vector<const void*> key;
+    pMaterial->GetContentKey( &key );
+    if( !key.empty() )
+    {
+        uint64_t hash = CPUTHashBytes( &key[0], key.size() * sizeof(key[0]) );
+        CPUTMaterial **ppFound = mMaterialsByContent.Find( hash );
+        if( !ppFound )
+        {
+            mMaterialsByContent.Insert( hash, pMaterial );
+        }
+        else
+        {
+            // Compare the keys too: materials with equal hashes but different content aren't shared
+            std::vector<const void*> foundKey;
+            (*ppFound)->GetContentKey( &foundKey );
+            if( foundKey == key )
+            {
+                mMaterialStats.mShared++;
+                mMaterialStats.mBytesSaved += bytes;
+                return *ppFound;
+            }
+        }
+    }
+    mMaterialStats.mBytes += bytes;
+    return NULL;
+}
+
 // Get CPUTModel from asset library
 // If the model exists, then the existing model is Addref'ed and returned
 //-----------------------------------------------------------------------------
@@ -315,7 +384,7 @@ CPUTLight *CPUTAssetLibrary::GetLight(const cString &name)
 }
 
 //-----------------------------------------------------------------------------
-CPUTTexture *CPUTAssetLibrary::GetTexture(const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB )
+CPUTTexture *CPUTAssetLibrary::GetTexture(const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB, bool allowStreaming )
 {
     cString finalName;
     if( name.at(0) == '$' )
@@ -331,7 +400,7 @@ CPUTTexture *CPUTAssetLibrary::GetTexture(const cString &name, bool nameIsFullPa
     CPUTTexture *pTexture = FindTexture(finalName, true);
     if(NULL==pTexture)
     {
-        return CPUTTexture::CreateTexture( name, finalName, loadAsSRGB);
+        return CPUTTexture::CreateTexture( name, finalName, loadAsSRGB, allowStreaming );
     }
     pTexture->AddRef();
     return pTexture;
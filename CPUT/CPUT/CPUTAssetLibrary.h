@@ -18,6 +18,9 @@
 
 #include "CPUT.h"
 #include "CPUTOSServicesWin.h" // TODO: why is this windows-specific?
+#include "CPUTStringID.h"
+#include "CPUTHash.h"
+#include "CPUTMeshOptimizer.h"
 
 // Global Asset Library
 //
@@ -26,16 +29,26 @@
 // system via the Getxxx() operators stays in the library.  Further Getxxx()
 // operations on an already loaded object will addref and return the previously
 // loaded object.
+//
+// Assets are named by interned strings (see CPUTStringID.h).  Besides the lists, the
+// library keeps an index from (list, name ID) to list entry, so finding an asset, or
+// finding that it isn't loaded yet, doesn't walk the list.
+//
+// Materials are also shared by content: when a material file turns out to bind the same
+// shaders, render state and resources as one already loaded, the library hands out the
+// one it has under both names (see FindIdenticalMaterial()).  Draws with either then sort
+// and batch together, and bind one set of shader parameters.
+//
+// With SetMeshOptimizerSettings(), models' meshes are reordered and quantized as they load.
 //-----------------------------------------------------------------------------
 // node that holds a single library object
 struct CPUTAssetListEntry
 {
-    UINT                hash;
-    cString             name;
+    CPUTStringID        nameID;
     void               *pData;
     CPUTAssetListEntry *pNext;
 };
-#define SAFE_RELEASE_LIST(list) ReleaseList(list);(list)=NULL;
+#define SAFE_RELEASE_LIST(list) ReleaseList(&(list));
 
 class CPUTAssetSet;
 class CPUTNullNode;
@@ -48,10 +61,36 @@ class CPUTBuffer;
 class CPUTRenderStateBlock;
 class CPUTFont;
 
+// Materials loaded from files since the library's lists were last released.  Clones made
+// for per-model payloads aren't counted.
+//-----------------------------------------------------------------------------
+struct CPUTMaterialStats
+{
+    UINT    mLoaded;
+    UINT    mShared;            // Of those, found identical to one loaded before, and dropped
+    size_t  mBytes;             // Held by the materials kept
+    size_t  mBytesSaved;        // Freed by dropping the identical ones
+
+    UINT GetUnique() const { return mLoaded - mShared; }
+};
+
 class CPUTAssetLibrary
 {
 protected:
     static CPUTAssetLibrary *mpAssetLibrary;
+    static CPUTArena         mLoadArena;
+
+    // Keyed by GetIndexKey().  A list's entry with CPUT_STRING_ID_NONE is its tail.
+    static CPUTFlatHashMap<CPUTAssetListEntry*> mAssetIndex;
+
+    // Shareable materials, keyed by the hash of their content key
+    static CPUTFlatHashMap<CPUTMaterial*> mMaterialsByContent;
+    static CPUTMaterialStats              mMaterialStats;
+
+    // Applied to each mesh as models load, when mOptimizeMeshes
+    static bool                      mOptimizeMeshes;
+    static CPUTMeshOptimizerSettings mMeshOptimizerSettings;
+    static CPUTMeshOptimizerStats    mMeshOptimizerStats;
 
     // simple linked lists for now, but if we want to optimize or load blocks
     // we can change these to dynamically re-sizing arrays and then just do
@@ -80,16 +119,31 @@ public: // TODO: temporary for debug.
 
     static void RebindTexturesAndBuffers();
     static void ReleaseTexturesAndBuffers();
+    static void RebindTextures( const std::vector<CPUTTexture*> &textures ); // textures sorted by address
 
 public:
     static CPUTAssetLibrary *GetAssetLibrary(){ return mpAssetLibrary; }
+    // Scratch memory for parsing asset files on the loading thread.  Take a CPUTArenaScope
+    // on it: everything allocated in it is gone when the scope ends.
+    static CPUTArena        *GetLoadArena(){ return &mLoadArena; }
     static void              DeleteAssetLibrary();
 
+    // Optimize meshes as models load (see CPUTMeshOptimizer.h).  NULL turns it off, the default:
+    // model files baked with CPUTModel::OptimizeModelPayload() are already optimized.
+    static void SetMeshOptimizerSettings( const CPUTMeshOptimizerSettings *pSettings )
+    {
+        mOptimizeMeshes = NULL != pSettings;
+        if( pSettings ) { mMeshOptimizerSettings = *pSettings; }
+    }
+    static const CPUTMeshOptimizerSettings *GetMeshOptimizerSettings() { return mOptimizeMeshes ? &mMeshOptimizerSettings : NULL; }
+    static CPUTMeshOptimizerStats          *GetMeshOptimizerStats() { return &mMeshOptimizerStats; }
+
     CPUTAssetLibrary() {}
     virtual ~CPUTAssetLibrary() {}
 
     // Add/get/delete items to specified library
-    void *FindAsset(const cString &name, CPUTAssetListEntry *pList, bool nameIsFullPathAndFilename=false);
+    void *FindAsset(const cString &name, CPUTAssetListEntry **ppList, bool nameIsFullPathAndFilename=false);
+    void *FindAsset(CPUTStringID nameID, CPUTAssetListEntry **ppList);
     virtual void ReleaseAllLibraryLists();
 
     void SetMediaDirectoryName( const cString &directoryName)
@@ -135,22 +189,22 @@ public:
     void AddRenderStateBlock(const cString &name, CPUTRenderStateBlock *pRenderStateBlock){ AddAsset( name, pRenderStateBlock, &mpRenderStateBlockList ); }
     void AddFont(            const cString &name, CPUTFont             *pFont)            { AddAsset( name, pFont,             &mpFontList ); }
 
-    CPUTAssetSet *FindAssetSet(const cString &name, bool nameIsFullPathAndFilename=false)       { return (CPUTAssetSet*)FindAsset( name, mpAssetSetList, nameIsFullPathAndFilename ); }
-    CPUTNullNode *FindNullNode(const cString &name, bool nameIsFullPathAndFilename=false)       { return (CPUTNullNode*)FindAsset( name, mpNullNodeList, nameIsFullPathAndFilename ); }
-    CPUTModel    *FindModel(const cString &name, bool nameIsFullPathAndFilename=false)          { return (CPUTModel*)FindAsset(    name, mpModelList,    nameIsFullPathAndFilename ); }
-    CPUTMaterial *FindMaterial(const cString &name, bool nameIsFullPathAndFilename=false)       { return (CPUTMaterial*)FindAsset( name, mpMaterialList, nameIsFullPathAndFilename ); }
-    CPUTLight    *FindLight(const cString &name, bool nameIsFullPathAndFilename=false)          { return (CPUTLight*)FindAsset(    name, mpLightList,    nameIsFullPathAndFilename ); }
-    CPUTCamera   *FindCamera(const cString &name, bool nameIsFullPathAndFilename=false)         { return (CPUTCamera*)FindAsset(   name, mpCameraList,   nameIsFullPathAndFilename ); }
-    CPUTTexture  *FindTexture(const cString &name, bool nameIsFullPathAndFilename=false)        { return (CPUTTexture*)FindAsset(  name, mpTextureList,  nameIsFullPathAndFilename ); }
-    CPUTBuffer   *FindBuffer(const cString &name, bool nameIsFullPathAndFilename=false)         { return (CPUTBuffer*)FindAsset(   name, mpBufferList,   nameIsFullPathAndFilename ); }
-    CPUTBuffer   *FindConstantBuffer(const cString &name, bool nameIsFullPathAndFilename=false) { return (CPUTBuffer*)FindAsset(   name, mpConstantBufferList, nameIsFullPathAndFilename ); }
-    CPUTRenderStateBlock *FindRenderStateBlock(const cString &name, bool nameIsFullPathAndFilename=false ) { return (CPUTRenderStateBlock*)FindAsset( name, mpRenderStateBlockList, nameIsFullPathAndFilename ); }
-    CPUTFont     *FindFont(const cString &name, bool nameIsFullPathAndFilename=false)           { return (CPUTFont*)FindAsset(     name, mpFontList,     nameIsFullPathAndFilename ); }
+    CPUTAssetSet *FindAssetSet(const cString &name, bool nameIsFullPathAndFilename=false)       { return (CPUTAssetSet*)FindAsset( name, &mpAssetSetList, nameIsFullPathAndFilename ); }
+    CPUTNullNode *FindNullNode(const cString &name, bool nameIsFullPathAndFilename=false)       { return (CPUTNullNode*)FindAsset( name, &mpNullNodeList, nameIsFullPathAndFilename ); }
+    CPUTModel    *FindModel(const cString &name, bool nameIsFullPathAndFilename=false)          { return (CPUTModel*)FindAsset(    name, &mpModelList,    nameIsFullPathAndFilename ); }
+    CPUTMaterial *FindMaterial(const cString &name, bool nameIsFullPathAndFilename=false)       { return (CPUTMaterial*)FindAsset( name, &mpMaterialList, nameIsFullPathAndFilename ); }
+    CPUTLight    *FindLight(const cString &name, bool nameIsFullPathAndFilename=false)          { return (CPUTLight*)FindAsset(    name, &mpLightList,    nameIsFullPathAndFilename ); }
+    CPUTCamera   *FindCamera(const cString &name, bool nameIsFullPathAndFilename=false)         { return (CPUTCamera*)FindAsset(   name, &mpCameraList,   nameIsFullPathAndFilename ); }
+    CPUTTexture  *FindTexture(const cString &name, bool nameIsFullPathAndFilename=false)        { return (CPUTTexture*)FindAsset(  name, &mpTextureList,  nameIsFullPathAndFilename ); }
+    CPUTBuffer   *FindBuffer(const cString &name, bool nameIsFullPathAndFilename=false)         { return (CPUTBuffer*)FindAsset(   name, &mpBufferList,   nameIsFullPathAndFilename ); }
+    CPUTBuffer   *FindConstantBuffer(const cString &name, bool nameIsFullPathAndFilename=false) { return (CPUTBuffer*)FindAsset(   name, &mpConstantBufferList, nameIsFullPathAndFilename ); }
+    CPUTRenderStateBlock *FindRenderStateBlock(const cString &name, bool nameIsFullPathAndFilename=false ) { return (CPUTRenderStateBlock*)FindAsset( name, &mpRenderStateBlockList, nameIsFullPathAndFilename ); }
+    CPUTFont     *FindFont(const cString &name, bool nameIsFullPathAndFilename=false)           { return (CPUTFont*)FindAsset(     name, &mpFontList,     nameIsFullPathAndFilename ); }
 
     // If the asset exists, these 'Get' methods will addref and return it.  Otherwise,
     // they will create it and return it.
     CPUTAssetSet         *GetAssetSet(        const cString &name, bool nameIsFullPathAndFilename=false );
-    CPUTTexture          *GetTexture(         const cString &name, bool nameIsFullPathAndFilename=false, bool loadAsSRGB=true );
+    CPUTTexture          *GetTexture(         const cString &name, bool nameIsFullPathAndFilename=false, bool loadAsSRGB=true, bool allowStreaming=false );
     CPUTMaterial         *GetMaterial(        const cString &name, bool nameIsFullPathAndFilename=false, const cString &modelSuffix=_L(""), const cString &meshSuffix=_L("") );
     CPUTModel            *GetModel(           const cString &name, bool nameIsFullPathAndFilename=false  );
     CPUTRenderStateBlock *GetRenderStateBlock(const cString &name, bool nameIsFullPathAndFilename=false);
@@ -160,20 +214,20 @@ public:
     CPUTLight            *GetLight(           const cString &name );
     CPUTFont             *GetFont(            const cString &name );
 
+    // Call with a material just loaded, before adding it.  Returns a material already in the
+    // library that draws identically, or NULL if there's none (and remembers this one).
+    // ** Does not Addref() returned items **
+    CPUTMaterial         *FindIdenticalMaterial( CPUTMaterial *pMaterial );
+    const CPUTMaterialStats &GetMaterialStats() const { return mMaterialStats; }
+
 protected:
     // helper functions
-    void ReleaseList(CPUTAssetListEntry *pLibraryRoot);
+    void ReleaseList(CPUTAssetListEntry **ppLibraryRoot);
     void DeleteListEntries(CPUTAssetListEntry *pLibraryRoot);
     void AddAsset( const cString &name, void *pAsset, CPUTAssetListEntry **pHead );
-    UINT CPUTComputeHash( const cString &string )
+    static uint64_t GetIndexKey( CPUTAssetListEntry **ppList, CPUTStringID nameID )
     {
-        size_t length = string.length();
-        UINT hash = 0;
-        for( size_t ii=0; ii<length; ii++ )
-        {
-            hash += tolower(string[ii]);
-        }
-        return hash;
+        return CPUTHashBytes( &nameID, sizeof(nameID), CPUTHashBytes( &ppList, sizeof(ppList) ) );
     }
 };
 
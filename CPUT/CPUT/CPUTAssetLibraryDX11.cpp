@@ -62,19 +62,22 @@ void CPUTAssetLibraryDX11::ReleaseAllLibraryLists()
 
 // Erase the specified list, Release()-ing underlying objects
 //-----------------------------------------------------------------------------
-void CPUTAssetLibraryDX11::ReleaseIunknownList( CPUTAssetListEntry *pList )
+void CPUTAssetLibraryDX11::ReleaseIunknownList( CPUTAssetListEntry **ppList )
 {
-    CPUTAssetListEntry *pNode = pList;
+    CPUTAssetListEntry *pNode = *ppList;
     CPUTAssetListEntry *pOldNode = NULL;
 
     while( NULL!=pNode )
     {
         // release the object using the DirectX IUnknown interface
         ((IUnknown*)(pNode->pData))->Release();
+        mAssetIndex.Insert( GetIndexKey( ppList, pNode->nameID ), NULL );
         pOldNode = pNode;
         pNode = pNode->pNext;
         delete pOldNode;
     }
+    mAssetIndex.Insert( GetIndexKey( ppList, CPUT_STRING_ID_NONE ), NULL );
+    *ppList = NULL;
     HEAPCHECK;
 }
 
@@ -347,17 +350,18 @@ CPUTResult CPUTAssetLibraryDX11::CreateComputeShaderFromMemory(
     return result;
 }
 
-// Use DX11 compile from file method to do all the heavy lifting
+// Compiles through the shader cache, so unchanged shaders are loaded instead of compiled
 //-----------------------------------------------------------------------------
-CPUTResult CPUTAssetLibraryDX11::CompileShaderFromFile(
-    const cString  &fileName,
+static const CPUTShaderMacro gpShaderMacros[] = { { "_CPUT", "1" }, { NULL, NULL } }; // TODO: Support passed-in, and defined in .mtl file.  Perhaps under [Shader Defines], etc
+CPUTResult CPUTAssetLibraryDX11::CompileShader(
+    const char     *pShaderSource,
+    UINT            sourceSize,
+    const char     *pSourceName,
     const cString  &shaderMain,
     const cString  &shaderProfile,
     ID3DBlob      **ppBlob
 )
 {
-    CPUTResult result = CPUT_SUCCESS;
-
     char pShaderMainAsChar[128];
     char pShaderProfileAsChar[128];
     ASSERT( shaderMain.length()     < 128, _L("Shader main name '")    + shaderMain    + _L("' longer than 128 chars.") );
@@ -366,31 +370,48 @@ CPUTResult CPUTAssetLibraryDX11::CompileShaderFromFile(
     wcstombs_s( &count, pShaderMainAsChar,    shaderMain.c_str(),    128 );
     wcstombs_s( &count, pShaderProfileAsChar, shaderProfile.c_str(), 128 );
 
-    // use DirectX to compile the shader file
-    ID3DBlob *pErrorBlob = NULL;
-    D3D10_SHADER_MACRO pShaderMacros[2] = { "_CPUT", "1", NULL, NULL };
-    HRESULT hr = D3DX11CompileFromFile(
-        fileName.c_str(),     // fileName
-        pShaderMacros,        // macro define's
-        NULL,                 // includes
-        pShaderMainAsChar,    // main function name
-        pShaderProfileAsChar, // shader profile/feature level
-        0,                    // flags 1
-        0,                    // flags 2
-        NULL,                 // threaded load? (no for right now)
-        ppBlob,               // blob data with compiled code
-        &pErrorBlob,          // any compile errors stored here
-        NULL
-    );
-    ASSERT( SUCCEEDED(hr), _L("Error compiling shader '") + fileName + _L("'.\n") + (pErrorBlob ? s2ws((char*)pErrorBlob->GetBufferPointer()) : _L("no error message") ) );
-    if(pErrorBlob)
+    std::vector<uint8_t> bytecode;
+    std::string          errors;
+    bool compiled = mShaderCache.GetBytecode( pShaderSource, sourceSize, pSourceName, gpShaderMacros, pShaderMainAsChar, pShaderProfileAsChar, &bytecode, &errors );
+    ASSERT( compiled, _L("Error compiling shader '") + s2ws(pSourceName) + _L("'.\n") + (errors.empty() ? _L("no error message") : s2ws(errors.c_str())) );
+    if( !compiled || FAILED( D3DCreateBlob( bytecode.size(), ppBlob ) ) )
     {
-        pErrorBlob->Release();
+        *ppBlob = NULL;
+        return CPUT_ERROR_SHADER_COMPILE_ERROR;
     }
-    return result;
+    memcpy( (*ppBlob)->GetBufferPointer(), &bytecode[0], bytecode.size() );
+    return CPUT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+CPUTResult CPUTAssetLibraryDX11::CompileShaderFromFile(
+    const cString  &fileName,
+    const cString  &shaderMain,
+    const cString  &shaderProfile,
+    ID3DBlob      **ppBlob
+)
+{
+    // Binary, so the size matches what the compiler reads
+    FILE *pFile = NULL;
+    errno_t err = _wfopen_s( &pFile, fileName.c_str(), _L("rb") );
+    ASSERT( 0 == err, _L("Error opening shader '") + fileName + _L("'.") );
+    if( err )
+    {
+        return CPUTOSServices::GetOSServices()->TranslateFileError( err );
+    }
+    fseek( pFile, 0, SEEK_END );
+    std::vector<char> source( ftell( pFile ) + 1, 0 );
+    fseek( pFile, 0, SEEK_SET );
+    UINT sourceSize = (UINT)fread( &source[0], 1, source.size() - 1, pFile );
+    fclose( pFile );
+
+    char pFileNameAsChar[MAX_PATH];
+    size_t count;
+    wcstombs_s( &count, pFileNameAsChar, fileName.c_str(), MAX_PATH );
+
+    return CompileShader( &source[0], sourceSize, pFileNameAsChar, shaderMain, shaderProfile, ppBlob );
 }
 
-// Use DX11 compile from file method to do all the heavy lifting
 //-----------------------------------------------------------------------------
 CPUTResult CPUTAssetLibraryDX11::CompileShaderFromMemory(
     const char     *pShaderSource,
@@ -399,40 +420,10 @@ CPUTResult CPUTAssetLibraryDX11::CompileShaderFromMemory(
     ID3DBlob      **ppBlob
 )
 {
-    CPUTResult result = CPUT_SUCCESS;
-
     char pShaderMainAsChar[128];
-    char pShaderProfileAsChar[128];
-    ASSERT( shaderMain.length()     < 128, _L("Shader main name '")    + shaderMain    + _L("' longer than 128 chars.") );
-    ASSERT( shaderProfile.length()  < 128, _L("Shader profile name '") + shaderProfile + _L("' longer than 128 chars.") );
     size_t count;
-    wcstombs_s( &count, pShaderMainAsChar,    shaderMain.c_str(),    128 );
-    wcstombs_s( &count, pShaderProfileAsChar, shaderProfile.c_str(), 128 );
+    wcstombs_s( &count, pShaderMainAsChar, shaderMain.c_str(), 128 );
 
-    // use DirectX to compile the shader file
-    ID3DBlob *pErrorBlob = NULL;
-    D3D10_SHADER_MACRO pShaderMacros[2] = { "_CPUT", "1", NULL, NULL }; // TODO: Support passed-in, and defined in .mtl file.  Perhaps under [Shader Defines], etc
-    char *pShaderMainAsChars = ws2s(shaderMain.c_str());
-    HRESULT hr = D3DX11CompileFromMemory(
-        pShaderSource,     // shader as a string
-        strlen( pShaderSource ), //
-        pShaderMainAsChars, // Use entrypoint as file name
-        pShaderMacros,        // macro define's
-        NULL,                 // includes
-        pShaderMainAsChar,    // main function name
-        pShaderProfileAsChar, // shader profile/feature level
-        0,                    // flags 1
-        0,                    // flags 2
-        NULL,                 // threaded load? (no for right now)
-        ppBlob,               // blob data with compiled code
-        &pErrorBlob,          // any compile errors stored here
-        NULL
-    );
-    ASSERT( SUCCEEDED(hr), _L("Error compiling shader '") + shaderMain + _L("'.\n") + (pErrorBlob ? s2ws((char*)pErrorBlob->GetBufferPointer()) : _L("no error message") ) );
-    if(pErrorBlob)
-    {
-        pErrorBlob->Release();
-    }
-    delete pShaderMainAsChars;
-    return result;
+    // Use the entry point as the file name
+    return CompileShader( pShaderSource, (UINT)strlen( pShaderSource ), pShaderMainAsChar, shaderMain, shaderProfile, ppBlob );
 }
@@ -18,6 +18,7 @@
 
 #include "CPUTAssetLibrary.h"
 #include "CPUTConfigBlock.h"
+#include "CPUTShaderCompilerDX11.h"
 
 #include <d3d11.h>
 #include <D3DX11tex.h> // for D3DX11_IMAGE_LOAD_INFO structs
@@ -55,15 +56,23 @@ protected:
     static CPUTAssetListEntry  *mpHullShaderList;
     static CPUTAssetListEntry  *mpDomainShaderList;
 
+    CPUTShaderCompilerDX11      mShaderCompiler;
+    CPUTShaderCache             mShaderCache;
+
+    CPUTResult CompileShader( const char *pShaderSource, UINT sourceSize, const char *pSourceName, const cString &shaderMain, const cString &shaderProfile, ID3DBlob **ppBlob );
+
 public:
-    CPUTAssetLibraryDX11(){}
+    CPUTAssetLibraryDX11()
+    {
+        mShaderCache.SetCompiler( &mShaderCompiler );
+    }
     virtual ~CPUTAssetLibraryDX11()
     {
         ReleaseAllLibraryLists();
     }
 
     virtual void ReleaseAllLibraryLists();
-    void ReleaseIunknownList( CPUTAssetListEntry *pList );
+    void ReleaseIunknownList( CPUTAssetListEntry **ppList );
 
     void AddPixelShader(    const cString &name, CPUTPixelShaderDX11    *pShader) { AddAsset( name, pShader, &mpPixelShaderList ); }
     void AddComputeShader(  const cString &name, CPUTComputeShaderDX11  *pShader) { AddAsset( name, pShader, &mpComputeShaderList ); }
@@ -72,12 +81,12 @@ public:
     void AddHullShader(     const cString &name, CPUTHullShaderDX11     *pShader) { AddAsset( name, pShader, &mpHullShaderList ); }
     void AddDomainShader(   const cString &name, CPUTDomainShaderDX11   *pShader) { AddAsset( name, pShader, &mpDomainShaderList ); }
     
-    CPUTPixelShaderDX11    *FindPixelShader(    const cString &name, bool nameIsFullPathAndFilename=false ) { return    (CPUTPixelShaderDX11*)FindAsset( name, mpPixelShaderList,    nameIsFullPathAndFilename ); }
-    CPUTComputeShaderDX11  *FindComputeShader(  const cString &name, bool nameIsFullPathAndFilename=false ) { return  (CPUTComputeShaderDX11*)FindAsset( name, mpComputeShaderList,  nameIsFullPathAndFilename ); }
-    CPUTVertexShaderDX11   *FindVertexShader(   const cString &name, bool nameIsFullPathAndFilename=false ) { return   (CPUTVertexShaderDX11*)FindAsset( name, mpVertexShaderList,   nameIsFullPathAndFilename ); }
-    CPUTGeometryShaderDX11 *FindGeometryShader( const cString &name, bool nameIsFullPathAndFilename=false ) { return (CPUTGeometryShaderDX11*)FindAsset( name, mpGeometryShaderList, nameIsFullPathAndFilename ); }
-    CPUTHullShaderDX11     *FindHullShader(     const cString &name, bool nameIsFullPathAndFilename=false ) { return     (CPUTHullShaderDX11*)FindAsset( name, mpHullShaderList,     nameIsFullPathAndFilename ); }
-    CPUTDomainShaderDX11   *FindDomainShader(   const cString &name, bool nameIsFullPathAndFilename=false ) { return   (CPUTDomainShaderDX11*)FindAsset( name, mpDomainShaderList,   nameIsFullPathAndFilename ); }
+    CPUTPixelShaderDX11    *FindPixelShader(    const cString &name, bool nameIsFullPathAndFilename=false ) { return    (CPUTPixelShaderDX11*)FindAsset( name, &mpPixelShaderList,    nameIsFullPathAndFilename ); }
+    CPUTComputeShaderDX11  *FindComputeShader(  const cString &name, bool nameIsFullPathAndFilename=false ) { return  (CPUTComputeShaderDX11*)FindAsset( name, &mpComputeShaderList,  nameIsFullPathAndFilename ); }
+    CPUTVertexShaderDX11   *FindVertexShader(   const cString &name, bool nameIsFullPathAndFilename=false ) { return   (CPUTVertexShaderDX11*)FindAsset( name, &mpVertexShaderList,   nameIsFullPathAndFilename ); }
+    CPUTGeometryShaderDX11 *FindGeometryShader( const cString &name, bool nameIsFullPathAndFilename=false ) { return (CPUTGeometryShaderDX11*)FindAsset( name, &mpGeometryShaderList, nameIsFullPathAndFilename ); }
+    CPUTHullShaderDX11     *FindHullShader(     const cString &name, bool nameIsFullPathAndFilename=false ) { return     (CPUTHullShaderDX11*)FindAsset( name, &mpHullShaderList,     nameIsFullPathAndFilename ); }
+    CPUTDomainShaderDX11   *FindDomainShader(   const cString &name, bool nameIsFullPathAndFilename=false ) { return   (CPUTDomainShaderDX11*)FindAsset( name, &mpDomainShaderList,   nameIsFullPathAndFilename ); }
 
     // shaders - vertex, pixel
     CPUTResult GetPixelShader(     const cString &name, ID3D11Device *pD3dDevice, const cString &shaderMain, const cString &shaderProfile, CPUTPixelShaderDX11    **ppShader, bool nameIsFullPathAndFilename=false);
@@ -95,6 +104,8 @@ public:
     CPUTResult CreateHullShaderFromMemory(      const cString &name, ID3D11Device *pD3dDevice, const cString &shaderMain, const cString &shaderProfile, CPUTHullShaderDX11     **ppShader, char *pShaderSource );
     CPUTResult CreateDomainShaderFromMemory(    const cString &name, ID3D11Device *pD3dDevice, const cString &shaderMain, const cString &shaderProfile, CPUTDomainShaderDX11   **ppShader, char *pShaderSource );
  
+    // Compiled shaders are cached on disk once a directory is set (see CPUTShaderCache)
+    CPUTShaderCache *GetShaderCache() { return &mShaderCache; }
     CPUTResult CompileShaderFromFile(  const cString &fileName,   const cString &shaderMain, const cString &shaderProfile, ID3DBlob **ppBlob);
     CPUTResult CompileShaderFromMemory(const char *pShaderSource, const cString &shaderMain, const cString &shaderProfile, ID3DBlob **ppBlob);
 };
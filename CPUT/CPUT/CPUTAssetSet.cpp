@@ -14,6 +14,14 @@
 // limitations under the License.
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "CPUTAssetSet.h"
+#include "CPUTModel.h"
+#include "CPUTRenderParams.h"
+#include "CPUTOcclusionCuller.h"
+#include "CPUTProfiler.h"
+#include "CPUTAllocator.h"
+
+// Asset sets with at least this many models cull through their BVH instead of testing every model
+#define CPUT_BVH_CULL_MODEL_COUNT 128
 #ifdef CPUT_FOR_DX11
     #include "CPUTAssetLibraryDX11.h"
 #elif defined(CPUT_FOR_OGLES)
@@ -30,7 +38,8 @@ CPUTAssetSet::CPUTAssetSet() :
     mAssetCount(0),
     mpRootNode(NULL),
     mpFirstCamera(NULL),
-    mCameraCount(0)
+    mCameraCount(0),
+    mCullListBuilt(false)
 {
 }
 
@@ -46,12 +55,121 @@ CPUTAssetSet::~CPUTAssetSet()
     }
 }
 
+//-----------------------------------------------------------------------------
+void CPUTAssetSet::BuildCullList()
+{
+    mCullModels.clear();
+    mCuller.Clear();
+    mBVH.Clear();
+    for( UINT ii=0; ii<mAssetCount; ii++ )
+    {
+        if( mppAssetList[ii] && mppAssetList[ii]->IsModel() )
+        {
+            CPUTModel *pModel = (CPUTModel*)mppAssetList[ii];
+            float3 center, half;
+            pModel->GetBoundsWorldSpace( &center, &half );
+            mCullModels.push_back( pModel );
+            mCuller.AddBox( center, half );
+            mBVH.AddPrimitive( center, half );
+        }
+    }
+    mCullListBuilt = true;
+}
+
+// World-space bounds change whenever a model moves, so refresh them from the models.
+// The BVH refits (or rebuilds) on its next Update().
+//-----------------------------------------------------------------------------
+void CPUTAssetSet::UpdateCullBounds()
+{
+    if( !mCullListBuilt )
+    {
+        BuildCullList();
+    }
+    UINT modelCount = (UINT)mCullModels.size();
+    for( UINT ii=0; ii<modelCount; ii++ )
+    {
+        float3 center, half;
+        mCullModels[ii]->GetBoundsWorldSpace( &center, &half );
+        mCuller.SetBox( ii, center, half );
+        mBVH.SetPrimitive( ii, center, half );
+    }
+}
+
+// Tests every model in the set against the camera's frustum in one batch, and
+// records the result on the models.  Their Render() functions then skip the
+// per-model CPUTFrustum::IsVisible() test.
+//-----------------------------------------------------------------------------
+void CPUTAssetSet::CullModels(CPUTRenderParameters &renderParams)
+{
+    CPUT_PROFILE_ZONE("Cull models");
+    UpdateCullBounds();
+    if( mCullModels.empty() )
+    {
+        return;
+    }
+    UINT modelCount = (UINT)mCullModels.size();
+    for( UINT ii=0; ii<modelCount; ii++ )
+    {
+        mCullModels[ii]->SetFrustumVisible( false );
+    }
+
+    CPUTFrustum *pFrustum = &renderParams.mpCamera->mFrustum;
+    mCuller.SetPlanes( pFrustum->mpNormal, pFrustum->mpPosition[0], pFrustum->mpPosition[6] );
+    UINT visibleCount;
+    if( modelCount >= CPUT_BVH_CULL_MODEL_COUNT )
+    {
+        mBVH.Update();
+        mVisibleModels.clear();
+        visibleCount = mBVH.QueryFrustum( mCuller.GetPlanes(), 6, mVisibleModels );
+    }
+    else
+    {
+        mVisibleModels.resize( modelCount );
+        visibleCount = mCuller.Cull( &mVisibleModels[0] );
+    }
+    pFrustum->mNumFrustumVisibleModels += visibleCount;
+    pFrustum->mNumFrustumCulledModels  += modelCount - visibleCount;
+    CPUT_PROFILE_COUNTER("Frustum visible models", visibleCount);
+
+    // Test whatever survived the frustum against the occlusion culler's depth buffer.  The
+    // boxes only live until the test is done, so they go in the frame's scratch memory.
+    CPUTOcclusionCuller *pOcclusionCuller = renderParams.mpOcclusionCuller;
+    CPUTArena  localArena;
+    CPUTArena *pArena = renderParams.mpFrameArena ? renderParams.mpFrameArena : &localArena;
+    CPUTArenaScope scope( *pArena );
+    uint8_t *pOccludeeVisible = NULL;
+    if( pOcclusionCuller && visibleCount )
+    {
+        float3 *pCenters = pArena->AllocateArray<float3>( visibleCount );
+        float3 *pHalves  = pArena->AllocateArray<float3>( visibleCount );
+        pOccludeeVisible = pArena->AllocateArray<uint8_t>( visibleCount );
+        for( UINT ii=0; ii<visibleCount; ii++ )
+        {
+            mCullModels[mVisibleModels[ii]]->GetBoundsWorldSpace( &pCenters[ii], &pHalves[ii] );
+        }
+        pOcclusionCuller->TestBoxes( pCenters, pHalves, visibleCount, pOccludeeVisible );
+    }
+    for( UINT ii=0; ii<visibleCount; ii++ )
+    {
+        bool visible = !pOccludeeVisible || pOccludeeVisible[ii];
+        mCullModels[mVisibleModels[ii]]->SetFrustumVisible( visible );
+    }
+
+    renderParams.mModelsFrustumCulled = true;
+}
+
 //-----------------------------------------------------------------------------
 void CPUTAssetSet::RenderRecursive(CPUTRenderParameters &renderParams )
 {
     if(mpRootNode)
     {
+        bool culled = renderParams.mpCamera && renderParams.mRenderOnlyVisibleModels && renderParams.mDrawModels;
+        if( culled )
+        {
+            CullModels(renderParams);
+        }
         mpRootNode->RenderRecursive(renderParams);
+        renderParams.mModelsFrustumCulled = false;
     }
 }
 
@@ -60,18 +178,23 @@ void CPUTAssetSet::RenderShadowRecursive(CPUTRenderParameters &renderParams )
 {
     if(mpRootNode)
     {
+        bool culled = renderParams.mpCamera && renderParams.mRenderOnlyVisibleModels && renderParams.mDrawModels;
+        if( culled )
+        {
+            CullModels(renderParams);
+        }
         mpRootNode->RenderShadowRecursive(renderParams);
+        renderParams.mModelsFrustumCulled = false;
     }
 }
 
 //-----------------------------------------------------------------------------
 void CPUTAssetSet::GetBoundingBox(float3 *pCenter, float3 *pHalf)
 {
-    *pCenter = *pHalf = float3(0.0f);
-    if(mpRootNode)
-    {
-        mpRootNode->GetBoundingBoxRecursive(pCenter, pHalf);
-    }
+    // The BVH's root holds the union of all the models' bounds
+    UpdateCullBounds();
+    mBVH.Update();
+    mBVH.GetBounds(pCenter, pHalf);
 }
 
 //-----------------------------------------------------------------------------
@@ -88,6 +211,7 @@ CPUTResult CPUTAssetSet::GetAssetByIndex(const UINT index, CPUTRenderNode **ppRe
 //-----------------------------------------------------------------------------
 CPUTAssetSet *CPUTAssetSet::CreateAssetSet( const cString &name, const cString &absolutePathAndFilename )
 {
+    CPUT_PROFILE_ZONE("Load asset set");
     // TODO: accept DX11/OGL param to control which platform we generate.
     // TODO: be sure to support the case where we want to support only one of them
 #ifdef CPUT_FOR_DX11
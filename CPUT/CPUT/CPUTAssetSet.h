@@ -19,8 +19,12 @@
 #include "CPUTRefCount.h"
 #include "CPUTNullNode.h"
 #include "CPUTCamera.h"
+#include "CPUTFrustumCuller.h"
+#include "CPUTBVH.h"
+#include <vector>
 
 class CPUTRenderNode;
+class CPUTModel;
 class CPUTNullNode;
 class CPUTRenderParameters;
 
@@ -34,6 +38,18 @@ protected:
     CPUTCamera      *mpFirstCamera;
     UINT             mCameraCount;
 
+    // Batched frustum culling of every model in the set (see CullModels()).
+    // Small sets are culled linearly, large ones through the BVH.
+    CPUTFrustumCuller        mCuller;
+    CPUTBVH                  mBVH;
+    std::vector<CPUTModel*>  mCullModels;
+    std::vector<uint32_t>    mVisibleModels;
+    bool                     mCullListBuilt;
+
+    void               BuildCullList();
+    void               UpdateCullBounds();
+    void               CullModels(CPUTRenderParameters &renderParams);
+
     ~CPUTAssetSet(); // Destructor is not public.  Must release instead of delete.
 
 public:
@@ -0,0 +1,575 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTBVH.h"
+#include <assert.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+// Interior nodes deeper than this become leaves, which keeps the query stacks fixed-size.
+#define CPUT_BVH_MAX_DEPTH  60
+#define CPUT_BVH_STACK_SIZE 64
+#define CPUT_BVH_BIN_COUNT  16
+
+//-----------------------------------------------------------------------------
+static inline float HalfSurfaceArea( const float *pMin, const float *pMax )
+{
+    float dx = pMax[0] - pMin[0];
+    float dy = pMax[1] - pMin[1];
+    float dz = pMax[2] - pMin[2];
+    return dx*dy + dy*dz + dz*dx;
+}
+
+//-----------------------------------------------------------------------------
+static inline void InitBounds( float *pMin, float *pMax )
+{
+    pMin[0] = pMin[1] = pMin[2] =  FLT_MAX;
+    pMax[0] = pMax[1] = pMax[2] = -FLT_MAX;
+}
+
+//-----------------------------------------------------------------------------
+static inline void GrowBounds( float *pMin, float *pMax, const float *pOtherMin, const float *pOtherMax )
+{
+    for( int ii=0; ii<3; ii++ )
+    {
+        pMin[ii] = pOtherMin[ii] < pMin[ii] ? pOtherMin[ii] : pMin[ii];
+        pMax[ii] = pOtherMax[ii] > pMax[ii] ? pOtherMax[ii] : pMax[ii];
+    }
+}
+
+// Returns the distance at which the ray enters the box (0 if it starts inside), or FLT_MAX on a miss.
+// parallelAxes has a bit set for each axis the ray doesn't move along.  Those are tested
+// directly: with an infinite reciprocal, a ray starting on one of the box's planes would
+// compute 0 * infinity = NaN there, and the comparisons below would drop the hit.
+//-----------------------------------------------------------------------------
+static inline float IntersectRayBox( const float *pMin, const float *pMax, const float3 &origin, const float3 &invDirection, uint32_t parallelAxes, float maxDistance )
+{
+    float tNear = 0.0f;
+    float tFar  = maxDistance;
+    for( int ii=0; ii<3; ii++ )
+    {
+        if( parallelAxes & (1u << ii) )
+        {
+            if( origin.f[ii] < pMin[ii] || origin.f[ii] > pMax[ii] )
+            {
+                return FLT_MAX;
+            }
+            continue;
+        }
+        float t0 = (pMin[ii] - origin.f[ii]) * invDirection.f[ii];
+        float t1 = (pMax[ii] - origin.f[ii]) * invDirection.f[ii];
+        if( t0 > t1 ) { float tt = t0; t0 = t1; t1 = tt; }
+        tNear = t0 > tNear ? t0 : tNear;
+        tFar  = t1 < tFar  ? t1 : tFar;
+    }
+    return tNear <= tFar ? tNear : FLT_MAX;
+}
+
+// Returns -1 if the box is completely in front of the plane, 1 if completely behind it, 0 if it straddles it.
+//-----------------------------------------------------------------------------
+static inline int ClassifyBox( const float *pPlane, const float *pMin, const float *pMax )
+{
+    float cx = (pMax[0] + pMin[0]) * 0.5f, hx = (pMax[0] - pMin[0]) * 0.5f;
+    float cy = (pMax[1] + pMin[1]) * 0.5f, hy = (pMax[1] - pMin[1]) * 0.5f;
+    float cz = (pMax[2] + pMin[2]) * 0.5f, hz = (pMax[2] - pMin[2]) * 0.5f;
+    float distance = pPlane[0]*cx + pPlane[1]*cy + pPlane[2]*cz + pPlane[3];
+    float radius   = fabsf(pPlane[0])*hx + fabsf(pPlane[1])*hy + fabsf(pPlane[2])*hz;
+    if( distance >= radius )  { return -1; }
+    if( distance + radius <= 0.0f ) { return 1; }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+static inline bool BoxesOverlap( const float *pMinA, const float *pMaxA, const float *pMinB, const float *pMaxB )
+{
+    return pMinA[0] <= pMaxB[0] && pMaxA[0] >= pMinB[0] &&
+           pMinA[1] <= pMaxB[1] && pMaxA[1] >= pMinB[1] &&
+           pMinA[2] <= pMaxB[2] && pMaxA[2] >= pMinB[2];
+}
+
+//-----------------------------------------------------------------------------
+CPUTBVH::CPUTBVH() :
+    mMaxLeafSize(4),
+    mRebuildThreshold(1.5f),
+    mBuildCost(0.0f),
+    mCost(0.0f),
+    mNeedsBuild(false),
+    mNeedsRefit(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+void CPUTBVH::Clear()
+{
+    mBoxes.clear();
+    mNodes.clear();
+    mPrimitives.clear();
+    mBuildCost = mCost = 0.0f;
+    mNeedsBuild = mNeedsRefit = false;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTBVH::AddPrimitive( const float3 &center, const float3 &half )
+{
+    mBoxes.push_back( CPUTBVHBox() );
+    uint32_t index = (uint32_t)mBoxes.size() - 1;
+    SetPrimitive( index, center, half );
+    mNeedsBuild = true;
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTBVH::SetPrimitive( uint32_t index, const float3 &center, const float3 &half )
+{
+    assert( index < mBoxes.size() );
+    CPUTBVHBox &box = mBoxes[index];
+    for( int ii=0; ii<3; ii++ )
+    {
+        box.mMin[ii] = center.f[ii] - half.f[ii];
+        box.mMax[ii] = center.f[ii] + half.f[ii];
+    }
+    mNeedsRefit = true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTBVH::Build()
+{
+    uint32_t count = (uint32_t)mBoxes.size();
+    mNodes.clear();
+    mPrimitives.resize( count );
+    mNeedsBuild = mNeedsRefit = false;
+    if( 0 == count )
+    {
+        mBuildCost = mCost = 0.0f;
+        return;
+    }
+
+    std::vector<float> centroids( count * 3 );
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        mPrimitives[ii] = ii;
+        for( int aa=0; aa<3; aa++ )
+        {
+            centroids[ii*3+aa] = (mBoxes[ii].mMin[aa] + mBoxes[ii].mMax[aa]) * 0.5f;
+        }
+    }
+    mNodes.reserve( 2 * count );
+    BuildRecursive( 0, count, 0, centroids );
+    mBuildCost = mCost = ComputeCost();
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTBVH::BuildRecursive( uint32_t first, uint32_t count, uint32_t depth, std::vector<float> &centroids )
+{
+    uint32_t nodeIndex = (uint32_t)mNodes.size();
+    mNodes.push_back( CPUTBVHNode() );
+
+    float nodeMin[3], nodeMax[3], centroidMin[3], centroidMax[3];
+    InitBounds( nodeMin, nodeMax );
+    InitBounds( centroidMin, centroidMax );
+    for( uint32_t ii=first; ii<first+count; ii++ )
+    {
+        const CPUTBVHBox &box = mBoxes[mPrimitives[ii]];
+        const float *pCentroid = &centroids[mPrimitives[ii]*3];
+        GrowBounds( nodeMin, nodeMax, box.mMin, box.mMax );
+        GrowBounds( centroidMin, centroidMax, pCentroid, pCentroid );
+    }
+    CPUTBVHNode &node = mNodes[nodeIndex];
+    for( int aa=0; aa<3; aa++ )
+    {
+        node.mMin[aa] = nodeMin[aa];
+        node.mMax[aa] = nodeMax[aa];
+    }
+    node.mFirst = first;
+    node.mCount = count;
+    if( count <= mMaxLeafSize || depth >= CPUT_BVH_MAX_DEPTH )
+    {
+        return nodeIndex;
+    }
+
+    // Split along the axis with the largest centroid extent
+    int   axis   = 0;
+    float extent = centroidMax[0] - centroidMin[0];
+    for( int aa=1; aa<3; aa++ )
+    {
+        if( centroidMax[aa] - centroidMin[aa] > extent )
+        {
+            axis   = aa;
+            extent = centroidMax[aa] - centroidMin[aa];
+        }
+    }
+
+    uint32_t leftCount = 0;
+    if( extent > 0.0f )
+    {
+        // Bin the centroids and pick the bin boundary with the lowest SAH cost
+        uint32_t binCount[CPUT_BVH_BIN_COUNT] = {0};
+        float    binMin[CPUT_BVH_BIN_COUNT][3], binMax[CPUT_BVH_BIN_COUNT][3];
+        for( int bb=0; bb<CPUT_BVH_BIN_COUNT; bb++ )
+        {
+            InitBounds( binMin[bb], binMax[bb] );
+        }
+        float scale = CPUT_BVH_BIN_COUNT / extent;
+        for( uint32_t ii=first; ii<first+count; ii++ )
+        {
+            uint32_t primitive = mPrimitives[ii];
+            int bin = (int)((centroids[primitive*3+axis] - centroidMin[axis]) * scale);
+            bin = bin < CPUT_BVH_BIN_COUNT ? bin : CPUT_BVH_BIN_COUNT - 1;
+            binCount[bin]++;
+            GrowBounds( binMin[bin], binMax[bin], mBoxes[primitive].mMin, mBoxes[primitive].mMax );
+        }
+
+        float rightArea[CPUT_BVH_BIN_COUNT];
+        float boundsMin[3], boundsMax[3];
+        InitBounds( boundsMin, boundsMax );
+        for( int bb=CPUT_BVH_BIN_COUNT-1; bb>0; bb-- )
+        {
+            GrowBounds( boundsMin, boundsMax, binMin[bb], binMax[bb] );
+            rightArea[bb] = binCount[bb] ? HalfSurfaceArea( boundsMin, boundsMax ) : (bb < CPUT_BVH_BIN_COUNT-1 ? rightArea[bb+1] : 0.0f);
+        }
+
+        float    bestCost  = FLT_MAX;
+        int      bestSplit = 0;
+        uint32_t leftSoFar = 0;
+        InitBounds( boundsMin, boundsMax );
+        for( int bb=1; bb<CPUT_BVH_BIN_COUNT; bb++ )
+        {
+            leftSoFar += binCount[bb-1];
+            if( binCount[bb-1] )
+            {
+                GrowBounds( boundsMin, boundsMax, binMin[bb-1], binMax[bb-1] );
+            }
+            uint32_t rightCount = count - leftSoFar;
+            if( 0 == leftSoFar || 0 == rightCount )
+            {
+                continue;
+            }
+            float cost = HalfSurfaceArea( boundsMin, boundsMax ) * leftSoFar + rightArea[bb] * rightCount;
+            if( cost < bestCost )
+            {
+                bestCost  = cost;
+                bestSplit = bb;
+            }
+        }
+
+        if( bestSplit )
+        {
+            uint32_t *pBegin = &mPrimitives[0] + first;
+            uint32_t *pEnd   = pBegin + count;
+            uint32_t *pLeft  = pBegin;
+            for( uint32_t *pp=pBegin; pp<pEnd; pp++ )
+            {
+                int bin = (int)((centroids[*pp*3+axis] - centroidMin[axis]) * scale);
+                if( bin < bestSplit )
+                {
+                    std::swap( *pp, *pLeft );
+                    pLeft++;
+                }
+            }
+            leftCount = (uint32_t)(pLeft - pBegin);
+        }
+    }
+    if( 0 == leftCount || count == leftCount )
+    {
+        // All centroids coincide (or binning couldn't separate them).  Split by count.
+        leftCount = count / 2;
+    }
+
+    BuildRecursive( first, leftCount, depth + 1, centroids );
+    uint32_t right = BuildRecursive( first + leftCount, count - leftCount, depth + 1, centroids );
+    mNodes[nodeIndex].mFirst = right;
+    mNodes[nodeIndex].mCount = 0;
+    return nodeIndex;
+}
+
+// Surface-area-weighted cost of the tree: interior nodes count as one traversal
+// step, leaves as one test per primitive.  Relative to the root's area.
+//-----------------------------------------------------------------------------
+float CPUTBVH::ComputeCost() const
+{
+    if( mNodes.empty() )
+    {
+        return 0.0f;
+    }
+    float rootArea = HalfSurfaceArea( mNodes[0].mMin, mNodes[0].mMax );
+    if( rootArea <= 0.0f )
+    {
+        return 0.0f;
+    }
+    float cost = 0.0f;
+    for( size_t ii=0; ii<mNodes.size(); ii++ )
+    {
+        const CPUTBVHNode &node = mNodes[ii];
+        cost += HalfSurfaceArea( node.mMin, node.mMax ) * (node.mCount ? (float)node.mCount : 1.0f);
+    }
+    return cost / rootArea;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTBVH::Refit()
+{
+    for( size_t ii=mNodes.size(); ii-- > 0; )
+    {
+        CPUTBVHNode &node = mNodes[ii];
+        InitBounds( node.mMin, node.mMax );
+        if( node.mCount )
+        {
+            for( uint32_t pp=node.mFirst; pp<node.mFirst+node.mCount; pp++ )
+            {
+                const CPUTBVHBox &box = mBoxes[mPrimitives[pp]];
+                GrowBounds( node.mMin, node.mMax, box.mMin, box.mMax );
+            }
+        }
+        else
+        {
+            GrowBounds( node.mMin, node.mMax, mNodes[ii+1].mMin, mNodes[ii+1].mMax );
+            GrowBounds( node.mMin, node.mMax, mNodes[node.mFirst].mMin, mNodes[node.mFirst].mMax );
+        }
+    }
+    mCost = ComputeCost();
+    mNeedsRefit = false;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTBVH::Update()
+{
+    if( mNeedsBuild )
+    {
+        Build();
+        return;
+    }
+    if( mNeedsRefit )
+    {
+        Refit();
+        if( NeedsRebuild() )
+        {
+            Build();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTBVH::GetBounds( float3 *pCenter, float3 *pHalf ) const
+{
+    if( mNodes.empty() )
+    {
+        *pCenter = *pHalf = float3(0.0f);
+        return;
+    }
+    const CPUTBVHNode &root = mNodes[0];
+    *pCenter = float3( root.mMax[0] + root.mMin[0], root.mMax[1] + root.mMin[1], root.mMax[2] + root.mMin[2] ) * 0.5f;
+    *pHalf   = float3( root.mMax[0] - root.mMin[0], root.mMax[1] - root.mMin[1], root.mMax[2] - root.mMin[2] ) * 0.5f;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTBVH::QueryFrustum( const float *pPlanes, uint32_t planeCount, std::vector<uint32_t> &results ) const
+{
+    assert( !mNeedsBuild && planeCount <= 32 );
+    if( mNodes.empty() )
+    {
+        return 0;
+    }
+    size_t startCount = results.size();
+
+    // Each stack entry carries the planes its node still straddles.  A node
+    // completely behind a plane doesn't test its children against that plane.
+    uint32_t nodeStack[CPUT_BVH_STACK_SIZE];
+    uint32_t maskStack[CPUT_BVH_STACK_SIZE];
+    uint32_t stackSize = 1;
+    nodeStack[0] = 0;
+    maskStack[0] = planeCount == 32 ? 0xFFFFFFFF : (1u << planeCount) - 1;
+    while( stackSize )
+    {
+        stackSize--;
+        const CPUTBVHNode &node = mNodes[nodeStack[stackSize]];
+        uint32_t mask = maskStack[stackSize];
+        bool culled = false;
+        for( uint32_t pp=0; pp<planeCount && !culled; pp++ )
+        {
+            if( mask & (1u << pp) )
+            {
+                int side = ClassifyBox( pPlanes + pp*4, node.mMin, node.mMax );
+                culled = side < 0;
+                mask  &= side > 0 ? ~(1u << pp) : 0xFFFFFFFF;
+            }
+        }
+        if( culled )
+        {
+            continue;
+        }
+        if( node.mCount )
+        {
+            for( uint32_t ii=node.mFirst; ii<node.mFirst+node.mCount; ii++ )
+            {
+                const CPUTBVHBox &box = mBoxes[mPrimitives[ii]];
+                bool primitiveCulled = false;
+                for( uint32_t pp=0; pp<planeCount && !primitiveCulled; pp++ )
+                {
+                    primitiveCulled = (mask & (1u << pp)) && ClassifyBox( pPlanes + pp*4, box.mMin, box.mMax ) < 0;
+                }
+                if( !primitiveCulled )
+                {
+                    results.push_back( mPrimitives[ii] );
+                }
+            }
+        }
+        else
+        {
+            nodeStack[stackSize] = node.mFirst;                            maskStack[stackSize++] = mask;
+            nodeStack[stackSize] = (uint32_t)(&node - &mNodes[0]) + 1;     maskStack[stackSize++] = mask;
+        }
+    }
+    return (uint32_t)(results.size() - startCount);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTBVH::QueryBox( const float3 &center, const float3 &half, std::vector<uint32_t> &results ) const
+{
+    assert( !mNeedsBuild );
+    if( mNodes.empty() )
+    {
+        return 0;
+    }
+    size_t startCount = results.size();
+    float queryMin[3] = { center.x - half.x, center.y - half.y, center.z - half.z };
+    float queryMax[3] = { center.x + half.x, center.y + half.y, center.z + half.z };
+
+    uint32_t stack[CPUT_BVH_STACK_SIZE];
+    uint32_t stackSize = 1;
+    stack[0] = 0;
+    while( stackSize )
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        const CPUTBVHNode &node = mNodes[nodeIndex];
+        if( !BoxesOverlap( node.mMin, node.mMax, queryMin, queryMax ) )
+        {
+            continue;
+        }
+        if( node.mCount )
+        {
+            for( uint32_t ii=node.mFirst; ii<node.mFirst+node.mCount; ii++ )
+            {
+                const CPUTBVHBox &box = mBoxes[mPrimitives[ii]];
+                if( BoxesOverlap( box.mMin, box.mMax, queryMin, queryMax ) )
+                {
+                    results.push_back( mPrimitives[ii] );
+                }
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.mFirst;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+    }
+    return (uint32_t)(results.size() - startCount);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTBVH::QueryPoint( const float3 &point, std::vector<uint32_t> &results ) const
+{
+    return QueryBox( point, float3(0.0f), results );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTBVH::Raycast( const float3 &origin, const float3 &direction, float maxDistance, CPUTBVHRayTester *pTester, CPUTBVHRayHit *pHit ) const
+{
+    assert( !mNeedsBuild );
+    if( mNodes.empty() )
+    {
+        return false;
+    }
+    // Components too small to invert (zero or denormal) count as not moving along that axis
+    float3   invDirection( 0.0f );
+    uint32_t parallelAxes = 0;
+    for( int ii=0; ii<3; ii++ )
+    {
+        bool parallel = fabsf( direction.f[ii] ) < FLT_MIN;
+        invDirection.f[ii] = parallel ? 0.0f : 1.0f / direction.f[ii];
+        parallelAxes |= parallel ? (1u << ii) : 0;
+    }
+    float    closest   = maxDistance;
+    uint32_t primitive = 0xFFFFFFFF;
+
+    uint32_t stack[CPUT_BVH_STACK_SIZE];
+    float    entry[CPUT_BVH_STACK_SIZE];
+    uint32_t stackSize = 0;
+    float    rootEntry = IntersectRayBox( mNodes[0].mMin, mNodes[0].mMax, origin, invDirection, parallelAxes, closest );
+    if( rootEntry != FLT_MAX )
+    {
+        stack[0] = 0;
+        entry[0] = rootEntry;
+        stackSize = 1;
+    }
+    while( stackSize )
+    {
+        stackSize--;
+        if( entry[stackSize] > closest )
+        {
+            continue; // Found something closer since this node was pushed
+        }
+        uint32_t nodeIndex = stack[stackSize];
+        const CPUTBVHNode &node = mNodes[nodeIndex];
+        if( node.mCount )
+        {
+            for( uint32_t ii=node.mFirst; ii<node.mFirst+node.mCount; ii++ )
+            {
+                uint32_t index = mPrimitives[ii];
+                float distance;
+                bool  hit;
+                if( pTester )
+                {
+                    hit = pTester->IntersectRay( index, origin, direction, closest, &distance ) && distance <= closest;
+                }
+                else
+                {
+                    distance = IntersectRayBox( mBoxes[index].mMin, mBoxes[index].mMax, origin, invDirection, parallelAxes, closest );
+                    hit = distance != FLT_MAX;
+                }
+                if( hit && (distance < closest || 0xFFFFFFFF == primitive) )
+                {
+                    closest   = distance;
+                    primitive = index;
+                }
+            }
+        }
+        else
+        {
+            // Visit the nearer child first (it's pushed last)
+            uint32_t left  = nodeIndex + 1;
+            uint32_t right = node.mFirst;
+            float leftEntry  = IntersectRayBox( mNodes[left].mMin,  mNodes[left].mMax,  origin, invDirection, parallelAxes, closest );
+            float rightEntry = IntersectRayBox( mNodes[right].mMin, mNodes[right].mMax, origin, invDirection, parallelAxes, closest );
+            if( leftEntry > rightEntry )
+            {
+                std::swap( left, right );
+                std::swap( leftEntry, rightEntry );
+            }
+            if( rightEntry != FLT_MAX ) { stack[stackSize] = right; entry[stackSize++] = rightEntry; }
+            if( leftEntry  != FLT_MAX ) { stack[stackSize] = left;  entry[stackSize++] = leftEntry;  }
+        }
+    }
+    if( 0xFFFFFFFF == primitive )
+    {
+        return false;
+    }
+    if( pHit )
+    {
+        pHit->mPrimitive = primitive;
+        pHit->mDistance  = closest;
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTBVH_H__
+#define __CPUTBVH_H__
+
+// Bounding volume hierarchy over axis-aligned boxes.
+//
+// Primitives are boxes identified by the index AddPrimitive() returned.  Build()
+// creates the tree with a binned surface-area heuristic (SAH).  When primitives
+// move, SetPrimitive() + Update() refits the existing tree bottom-up, and only
+// rebuilds when the refitted tree's SAH cost has grown past the rebuild threshold
+// (relative to the cost right after the last build).
+//
+// Nodes are stored depth-first: an interior node's left child immediately follows
+// it and its right child is at mFirst.  Every child has a higher index than its
+// parent, so a refit is a single reverse pass over the node array.
+//
+// Queries append the indices of the primitives they find to a caller-supplied list.
+#include "CPUTMath.h"
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+struct CPUTBVHBox
+{
+    float mMin[3];
+    float mMax[3];
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTBVHNode
+{
+    float    mMin[3];
+    uint32_t mFirst; // Leaf: first entry in the primitive list.  Interior: right child.
+    float    mMax[3];
+    uint32_t mCount; // Leaf: number of primitives.  Interior: 0.
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTBVHRayHit
+{
+    uint32_t mPrimitive;
+    float    mDistance;
+};
+
+// Exact ray test for a primitive (e.g., a triangle).  Without one, Raycast() hits the primitives' boxes.
+//-----------------------------------------------------------------------------
+class CPUTBVHRayTester
+{
+public:
+    virtual ~CPUTBVHRayTester() {}
+
+    // Return true and set *pDistance if the ray hits the primitive closer than maxDistance.
+    virtual bool IntersectRay( uint32_t primitive, const float3 &origin, const float3 &direction, float maxDistance, float *pDistance ) = 0;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTBVH
+{
+protected:
+    std::vector<CPUTBVHBox>  mBoxes;       // Indexed by primitive
+    std::vector<CPUTBVHNode> mNodes;
+    std::vector<uint32_t>    mPrimitives;  // Leaf ranges index into this
+    uint32_t                 mMaxLeafSize;
+    float                    mRebuildThreshold;
+    float                    mBuildCost;   // SAH cost right after the last Build()
+    float                    mCost;        // SAH cost after the last Build() or Refit()
+    bool                     mNeedsBuild;  // Primitives were added or removed
+    bool                     mNeedsRefit;  // Primitives moved
+
+    uint32_t BuildRecursive( uint32_t first, uint32_t count, uint32_t depth, std::vector<float> &centroids );
+    float    ComputeCost() const;
+
+public:
+    CPUTBVH();
+    ~CPUTBVH() {}
+
+    void     Clear();
+    uint32_t AddPrimitive( const float3 &center, const float3 &half );
+    void     SetPrimitive( uint32_t index, const float3 &center, const float3 &half );
+    uint32_t GetPrimitiveCount() const { return (uint32_t)mBoxes.size(); }
+
+    void     Build();
+    void     Refit();
+    void     Update();  // Builds, refits, or rebuilds as needed
+    bool     NeedsRebuild() const { return mCost > mBuildCost * mRebuildThreshold; }
+
+    // Bounds of everything in the tree.  Zero when empty.
+    void     GetBounds( float3 *pCenter, float3 *pHalf ) const;
+
+    // pPlanes holds planeCount (nx, ny, nz, d) planes with outward-facing normals (see CPUTFrustumCuller).
+    // A primitive is reported unless its box is completely in front of one of the planes.
+    uint32_t QueryFrustum( const float *pPlanes, uint32_t planeCount, std::vector<uint32_t> &results ) const;
+    uint32_t QueryBox( const float3 &center, const float3 &half, std::vector<uint32_t> &results ) const;
+    uint32_t QueryPoint( const float3 &point, std::vector<uint32_t> &results ) const;
+
+    // Closest hit along the ray within maxDistance.  direction must be normalized for mDistance to be a distance.
+    bool     Raycast( const float3 &origin, const float3 &direction, float maxDistance, CPUTBVHRayTester *pTester, CPUTBVHRayHit *pHit ) const;
+
+    uint32_t GetNodeCount() const                 { return (uint32_t)mNodes.size(); }
+    float    GetCost() const                      { return mCost; }
+    void     SetMaxLeafSize( uint32_t size )      { mMaxLeafSize = size ? size : 1; mNeedsBuild = true; }
+    void     SetRebuildThreshold( float ratio )   { mRebuildThreshold = ratio; }
+};
+
+#endif // __CPUTBVH_H__
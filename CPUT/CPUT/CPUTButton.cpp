@@ -245,9 +245,9 @@ CPUTEventHandledCode CPUTButton::HandleMouseEvent(int x, int y, int wheel, CPUTM
             // tell gui system this control image is now dirty
             // and needs to rebuild it's draw list
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -264,9 +264,9 @@ CPUTEventHandledCode CPUTButton::HandleMouseEvent(int x, int y, int wheel, CPUTM
             // tell gui system this control image is now dirty
             // and needs to rebuild it's draw list
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -287,9 +287,9 @@ CPUTEventHandledCode CPUTButton::HandleMouseEvent(int x, int y, int wheel, CPUTM
         {
             mButtonState = CPUT_BUTTON_NEUTRAL;
 #ifdef CPUT_FOR_DX11
-            CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+            CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-            CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+            CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -382,9 +382,9 @@ void CPUTButton::SetText(const cString String)
     {
         // otherwise, we mark this as dirty
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -437,9 +437,9 @@ void CPUTButton::SetEnable(bool in_bEnabled)
 
     // otherwise, we mark this as dirty
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -798,9 +798,9 @@ CPUTResult CPUTButton::Resize(int width, int height)
         // Mark this control as 'dirty' for drawing and inform the gui system that
         // it needs to re-calculate it's drawing buffer
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
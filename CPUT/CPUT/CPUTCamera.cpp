@@ -65,12 +65,12 @@ void CPUTCamera::LookAt( float xx, float yy, float zz )
     float3 right = cross3(float3(0.0f,1.0f,0.0f), look).normalize(); // TODO: simplicy algebraically
     float3 up    = cross3(look, right);
     
-    mParentMatrix = float4x4(
+    SetParentMatrix( float4x4(
         right.x, right.y, right.z, 0.0f,
            up.x,    up.y,    up.z, 0.0f,
          look.x,  look.y,  look.z, 0.0f,
           pos.x,   pos.y,   pos.z, 1.0f
-    );
+    ));
 }
 
 //-----------------------------------------------------------------------------
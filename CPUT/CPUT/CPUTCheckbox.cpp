@@ -261,9 +261,9 @@ CPUTEventHandledCode CPUTCheckbox::HandleMouseEvent(int x, int y, int wheel, CPU
             // and needs to rebuild it's draw list
             
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -292,9 +292,9 @@ CPUTEventHandledCode CPUTCheckbox::HandleMouseEvent(int x, int y, int wheel, CPU
             // tell gui system this control image is now dirty
             // and needs to rebuild it's draw list            
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -369,24 +369,24 @@ void CPUTCheckbox::SetText(const cString String)
     GetTextPosition(x,y);
     mpCheckboxText->SetPosition(x, y);
 
-    // position or size may move - force a recalculation of this control's location
-    // if it is managed by the auto-arrange function
-    if(this->IsAutoArranged())
-    {
+    // the text is drawn as part of this control, so rebuild it even if the layout
+    // doesn't move it
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->Resize();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->Resize();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
-    }
-    else
+
+    // position or size may move - force a recalculation of this control's location
+    // if it is managed by the auto-arrange function
+    if(this->IsAutoArranged())
     {
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->Resize();
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->Resize();
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -547,9 +547,9 @@ void CPUTCheckbox::Recalculate()
     // Mark this control as 'dirty' for drawing and inform the gui system that
     // it needs to re-calculate it's drawing buffer
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
@@ -0,0 +1,162 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTCollisionMesh.h"
+#include "CPUTModel.h"
+#include "CPUTMesh.h"
+#include "CPUTAssetLibrary.h"
+#include <fstream>
+
+//-----------------------------------------------------------------------------
+CPUTResult CPUTCollisionMesh::AddModel( CPUTModel *pModel )
+{
+    const cString &filename = pModel->GetPayloadFilename();
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if( file.fail() )
+    {
+        return CPUT_ERROR_FILE_NOT_FOUND;
+    }
+    float4x4 world = *pModel->GetWorldMatrix();
+
+    // The file's data is only needed until it's copied into the collision mesh
+    CPUTArena *pArena = CPUTAssetLibrary::GetLoadArena();
+    while(file.good() && !file.eof())
+    {
+        CPUTArenaScope scope( *pArena );
+        CPUTRawMeshData meshData( pArena );
+        meshData.Read(file);
+        if(file.eof())
+        {
+            break; // Same end-of-file handling as CPUTModel::LoadModelPayload()
+        }
+
+        // Find the (float3) position stream
+        const CPUTVertexElementDesc *pPosition = NULL;
+        for( UINT ii=0; ii<meshData.mFormatDescriptorCount; ii++ )
+        {
+            if( CPUT_VERTEX_ELEMENT_POSITON == meshData.mpElements[ii].mVertexElementSemantic &&
+                tFLOAT == meshData.mpElements[ii].mVertexElementType &&
+                sizeof(float3) <= meshData.mpElements[ii].mElementSizeInBytes )
+            {
+                pPosition = &meshData.mpElements[ii];
+                break;
+            }
+        }
+        if( !pPosition || !meshData.mVertexCount || meshData.mIndexCount < 3 )
+        {
+            continue;
+        }
+
+        float3 *pPositions = pArena->AllocateArray<float3>( meshData.mVertexCount );
+        const char *pVertex = (const char*)meshData.mpVertices + pPosition->mOffset;
+        for( UINT ii=0; ii<meshData.mVertexCount; ii++, pVertex += meshData.mStride )
+        {
+            pPositions[ii] = *(const float3*)pVertex;
+        }
+
+        const UINT *pIndices = meshData.mpIndices;
+        if( tUINT32 != meshData.mIndexType )
+        {
+            // 16-bit indices are packed at the start of the index block (see CPUTModel::LoadModelPayload())
+            const USHORT *pIndices16 = (const USHORT*)meshData.mpIndices;
+            UINT         *pWidened   = pArena->AllocateArray<UINT>( meshData.mIndexCount );
+            for( UINT ii=0; ii<meshData.mIndexCount; ii++ )
+            {
+                pWidened[ii] = pIndices16[ii];
+            }
+            pIndices = pWidened;
+        }
+        AddTriangles( pPositions, pIndices, meshData.mIndexCount, world );
+    }
+    file.close();
+    return CPUT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTCollisionMesh::AddTriangles( const float3 *pPositions, const UINT *pIndices, UINT indexCount, const float4x4 &world )
+{
+    for( UINT ii=0; ii+2<indexCount; ii+=3 )
+    {
+        float3 corner[3];
+        for( UINT jj=0; jj<3; jj++ )
+        {
+            corner[jj] = float3( float4( pPositions[pIndices[ii+jj]], 1.0f ) * world );
+            mPositions.push_back( corner[jj] );
+        }
+        float3 minCorner = corner[0], maxCorner = corner[0];
+        for( UINT jj=1; jj<3; jj++ )
+        {
+            minCorner = Min( minCorner, corner[jj] );
+            maxCorner = Max( maxCorner, corner[jj] );
+        }
+        mBVH.AddPrimitive( (maxCorner + minCorner) * 0.5f, (maxCorner - minCorner) * 0.5f );
+    }
+}
+
+// Moller-Trumbore.  Both faces are hit.
+//-----------------------------------------------------------------------------
+bool CPUTCollisionMesh::IntersectRay( uint32_t primitive, const float3 &origin, const float3 &direction, float maxDistance, float *pDistance )
+{
+    const float3 &v0 = mPositions[primitive*3+0];
+    float3 edge1 = mPositions[primitive*3+1] - v0;
+    float3 edge2 = mPositions[primitive*3+2] - v0;
+    float3 p     = cross3( direction, edge2 );
+    float  det   = dot3( edge1, p );
+    if( fabsf(det) < 1e-12f )
+    {
+        return false; // Ray is parallel to the triangle
+    }
+    float  invDet = 1.0f / det;
+    float3 s = origin - v0;
+    float  u = dot3( s, p ) * invDet;
+    if( u < 0.0f || u > 1.0f )
+    {
+        return false;
+    }
+    float3 q = cross3( s, edge1 );
+    float  v = dot3( direction, q ) * invDet;
+    if( v < 0.0f || u + v > 1.0f )
+    {
+        return false;
+    }
+    float t = dot3( edge2, q ) * invDet;
+    if( t < 0.0f || t > maxDistance )
+    {
+        return false;
+    }
+    *pDistance = t;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTCollisionMesh::Raycast( const float3 &origin, const float3 &direction, float maxDistance, CPUTCollisionHit *pHit )
+{
+    mBVH.Update();
+    CPUTBVHRayHit hit;
+    if( !mBVH.Raycast( origin, direction, maxDistance, this, &hit ) )
+    {
+        return false;
+    }
+    if( pHit )
+    {
+        const float3 &v0 = mPositions[hit.mPrimitive*3+0];
+        float3 normal = cross3( mPositions[hit.mPrimitive*3+1] - v0, mPositions[hit.mPrimitive*3+2] - v0 ).normalize();
+        pHit->mNormal    = dot3( normal, direction ) > 0.0f ? normal * -1.0f : normal;
+        pHit->mPosition  = origin + direction * hit.mDistance;
+        pHit->mDistance  = hit.mDistance;
+        pHit->mTriangle  = hit.mPrimitive;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTCOLLISIONMESH_H__
+#define __CPUTCOLLISIONMESH_H__
+
+// CPU-side copy of a model's triangles, in world space, with a BVH for ray queries.
+// Used for gameplay queries against level geometry (the GPU copy of the meshes
+// isn't readable).
+#include "CPUT.h"
+#include "CPUTBVH.h"
+#include <vector>
+
+class CPUTModel;
+
+//-----------------------------------------------------------------------------
+struct CPUTCollisionHit
+{
+    float3 mPosition;
+    float3 mNormal;   // Faces the ray origin
+    float  mDistance;
+    UINT   mTriangle;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTCollisionMesh : public CPUTBVHRayTester
+{
+protected:
+    std::vector<float3> mPositions; // Three world-space vertices per triangle
+    CPUTBVH             mBVH;
+
+public:
+    CPUTCollisionMesh() {}
+    virtual ~CPUTCollisionMesh() {}
+
+    // Re-reads the model's .mdl file and adds its triangles, transformed by the model's current world matrix.
+    CPUTResult AddModel( CPUTModel *pModel );
+    void       AddTriangles( const float3 *pPositions, const UINT *pIndices, UINT indexCount, const float4x4 &world );
+    void       Clear() { mPositions.clear(); mBVH.Clear(); }
+    void       Build() { mBVH.Update(); }
+    UINT       GetTriangleCount() const { return (UINT)mPositions.size() / 3; }
+    const float3 *GetTrianglePositions() const { return mPositions.empty() ? NULL : &mPositions[0]; } // Three per triangle
+
+    // Closest triangle hit within maxDistance.  direction must be normalized.
+    bool       Raycast( const float3 &origin, const float3 &direction, float maxDistance, CPUTCollisionHit *pHit );
+
+    // CPUTBVHRayTester
+    bool       IntersectRay( uint32_t primitive, const float3 &origin, const float3 &direction, float maxDistance, float *pDistance );
+};
+
+#endif // __CPUTCOLLISIONMESH_H__
@@ -140,21 +140,32 @@ CPUTConfigEntry *CPUTConfigBlock::AddValue(const cString &szName, const cString
 
     // TODO: What should we do if it already exists?
     CPUTConfigEntry *pEntry = &mpValues[mnValueCount++];
-    pEntry->szName  = szNameLower;
+    pEntry->nameID  = CPUTStringTable::Intern(szNameLower);
     pEntry->szValue = szValueLower;
     return pEntry;
 }
 //----------------------------------------------------------------
 CPUTConfigEntry *CPUTConfigBlock::GetValueByName(const cString &szName)
 {
-    cString szString = szName;
-    std::transform(szString.begin(), szString.end(), szString.begin(), ::tolower);
-
-    for(int ii=0; ii<mnValueCount; ++ii)
+    // A name nobody interned isn't in any block
+    return GetValueByID(CPUTStringTable::Find(szName));
+}
+//----------------------------------------------------------------
+CPUTConfigEntry *CPUTConfigBlock::GetValueByName(const CPUTStringChar *szName)
+{
+    return GetValueByID(CPUTStringTable::Find(szName));
+}
+//----------------------------------------------------------------
+CPUTConfigEntry *CPUTConfigBlock::GetValueByID(CPUTStringID nameID)
+{
+    if(CPUT_STRING_ID_NONE != nameID)
     {
-        if(mpValues[ii].szName.compare(szString) == 0)
+        for(int ii=0; ii<mnValueCount; ++ii)
         {
-            return &mpValues[ii];
+            if(mpValues[ii].nameID == nameID)
+            {
+                return &mpValues[ii];
+            }
         }
     }
 
@@ -265,9 +276,10 @@ CPUTResult CPUTConfigFile::LoadFile(const cString &szFilename)
             {
                 bool dup = false;
                 // No value, just a key, save it anyway
+                CPUTStringID nameID = CPUTStringTable::Intern(szCurrLine);
                 for(int ii=0;ii<pCurrBlock->mnValueCount;++ii)
                 {
-                    if(!pCurrBlock->mpValues[ii].szName.compare(szCurrLine))
+                    if(pCurrBlock->mpValues[ii].nameID == nameID)
                     {
                         dup = true;
                         break;
@@ -275,7 +287,7 @@ CPUTResult CPUTConfigFile::LoadFile(const cString &szFilename)
                 }
                 if(!dup)
                 {
-                    pCurrBlock->mpValues[pCurrBlock->mnValueCount].szName = szCurrLine;
+                    pCurrBlock->mpValues[pCurrBlock->mnValueCount].nameID = nameID;
                     pCurrBlock->mnValueCount++;
                 }
             }
@@ -288,9 +300,10 @@ CPUTResult CPUTConfigFile::LoadFile(const cString &szFilename)
                 std::transform(szName.begin(), szName.end(), szName.begin(), ::tolower);
 
                 bool dup = false;
+                CPUTStringID nameID = CPUTStringTable::Intern(szName);
                 for(int ii=0;ii<pCurrBlock->mnValueCount;++ii)
                 {
-                    if(!pCurrBlock->mpValues[ii].szName.compare(szName))
+                    if(pCurrBlock->mpValues[ii].nameID == nameID)
                     {
                         dup = true;
                         break;
@@ -299,7 +312,7 @@ CPUTResult CPUTConfigFile::LoadFile(const cString &szFilename)
                 if(!dup)
                 {
                     pCurrBlock->mpValues[pCurrBlock->mnValueCount].szValue = szValue;
-                    pCurrBlock->mpValues[pCurrBlock->mnValueCount].szName = szName;
+                    pCurrBlock->mpValues[pCurrBlock->mnValueCount].nameID = nameID;
                     pCurrBlock->mnValueCount++;
                 }
             }
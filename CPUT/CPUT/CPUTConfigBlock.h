@@ -19,6 +19,7 @@
 
 
 #include "CPUT.h"
+#include "CPUTStringID.h"
 
 #include <algorithm> // for std::transform
 
@@ -36,21 +37,23 @@ typedef UINT UINT;
 class CPUTConfigEntry
 {
 private:
-    cString szName;
-    cString szValue;
+    CPUTStringID nameID;    // Interned, so the name isn't stored in every entry
+    cString      szValue;
 
     friend class CPUTConfigBlock;
     friend class CPUTConfigFile;
 
 public:
-    CPUTConfigEntry() {}
-    CPUTConfigEntry(const cString &name, const cString &value): szName(name), szValue(value){};
+    CPUTConfigEntry() : nameID(CPUT_STRING_ID_NONE) {}
+    CPUTConfigEntry(const cString &name, const cString &value): nameID(CPUTStringTable::Intern(name)), szValue(value){};
 
     static CPUTConfigEntry  &sNullConfigValue;
 
-    const cString & NameAsString(void){ return  szName;};
+    // Names are compared ignoring case, so this may not be the file's spelling
+    cString         NameAsString(void){ return CPUTStringTable::GetString(nameID); }
+    CPUTStringID    NameAsID(void){ return nameID; }
     const cString & ValueAsString(void){ return szValue; }
-	bool IsValid(void){ return !szName.empty(); }
+	bool IsValid(void){ return CPUT_STRING_ID_NONE != nameID; }
     float ValueAsFloat(void)
     {
         float fValue=0;
@@ -94,6 +97,9 @@ public:
     CPUTConfigEntry *AddValue(const cString &szName, const cString &szValue);
     CPUTConfigEntry *GetValue(int nValueIndex);
     CPUTConfigEntry *GetValueByName(const cString &szName);
+    CPUTConfigEntry *GetValueByName(const CPUTStringChar *szName);
+    // Names are compared ignoring case, as by GetValueByName()
+    CPUTConfigEntry *GetValueByID(CPUTStringID nameID);
     const cString &GetName(void);
     int GetNameValue(void);
     int ValueCount(void);
@@ -23,7 +23,8 @@ CPUTControl::CPUTControl():mControlVisible(true),
     mcontrolType(CPUT_CONTROL_UNKNOWN),
     mcontrolID(0),
     mpCallbackHandler(NULL),
-    mControlState(CPUT_CONTROL_ACTIVE)
+    mControlState(CPUT_CONTROL_ACTIVE),
+    mGraphicsDirty(true)
 {
 }
 
@@ -70,6 +71,7 @@ void CPUTControl::SetControlCallback(CPUTCallbackHandler *pHandler)
 void CPUTControl::SetVisibility(bool bVisible)
 {
     mControlVisible = bVisible;
+    mGraphicsDirty = true;
 }
 
 // visibility state
@@ -118,6 +120,7 @@ void CPUTControl::SetEnable(bool bEnabled)
     {
         mControlState = CPUT_CONTROL_ACTIVE;
     }
+    mGraphicsDirty = true;
 }
 
 // Return bool if the control is enabled/greyed out
@@ -109,6 +109,10 @@ public:
     virtual unsigned int GetQuadCount() {return 0;}
     virtual void DrawIntoBuffer(float *pVertexBufferMirror, int *pInsertIndex, int pMaxBufferSize) {return;}
 
+    // set when the control's vertices need regenerating - the GUI controller clears it once it has
+    bool IsGraphicsDirty() {return mGraphicsDirty;}
+    void SetGraphicsDirty(bool bDirty) {mGraphicsDirty = bDirty;}
+
 protected:
     bool                    mControlVisible;
     bool                    mControlAutoArranged;
@@ -117,6 +121,7 @@ protected:
     CPUTControlID           mcontrolID;
     CPUTCallbackHandler    *mpCallbackHandler;
     CPUTGUIControlState     mControlState;
+    bool                    mGraphicsDirty;
 };
 
 #endif //#ifndef __CPUTCONTROL_H__
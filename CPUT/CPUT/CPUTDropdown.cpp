@@ -1073,9 +1073,9 @@ void CPUTDropdown::Recalculate()
 
     // mark this as dirty
 #ifdef CPUT_FOR_DX11
-    CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+    CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-    CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+    CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
 #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
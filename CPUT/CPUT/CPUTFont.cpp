@@ -57,7 +57,7 @@ CPUT_SIZE CPUTFont::GetGlyphSize(const char c)
     size.height=0;
     size.width=0;
 
-    int index = FindGlyphIndex(c);
+    int index = GetGlyphIndex(c);
     if(-1!=index)
     {
         size.width=mpGlyphSizes[index].width;
@@ -72,7 +72,7 @@ CPUT_SIZE CPUTFont::GetGlyphSize(const char c)
 //-----------------------------------------------------------------------------
 void CPUTFont::GetGlyphUVS(const char c, const bool bEnabledVersion, float3 &UV1, float3 &UV2)
 {
-    int index = FindGlyphIndex(c);
+    int index = GetGlyphIndex(c);
     if(-1!=index)
     {
         if(bEnabledVersion)
@@ -92,21 +92,94 @@ void CPUTFont::GetGlyphUVS(const char c, const bool bEnabledVersion, float3 &UV1
     }    
 }
 
-// find the index of the glyph that corresponds to the char passed in
+// fill the character -> glyph table from gFontMap_active
 //-----------------------------------------------------------------------------
-int CPUTFont::FindGlyphIndex(const char c)
+void CPUTFont::BuildGlyphMap()
 {
-    int index=0;
-    while(-1 != gFontMap_active[index])
+    for(int ii=0; ii<CPUT_MAX_NUMBER_OF_CHARACTERS; ii++)
     {
-        if(c == gFontMap_active[index])
+        mpGlyphMap[ii] = -1;
+    }
+    for(int index=0; -1 != gFontMap_active[index] && index < (int)mNumberOfGlyphsInAtlas; index++)
+    {
+        mpGlyphMap[gFontMap_active[index]] = index;
+    }
+    ClearGlyphRunCache();
+}
+
+//-----------------------------------------------------------------------------
+const CPUTGlyphRun &CPUTFont::LayoutText(const cString &Text, const CPUTGlyphRun *pPrevious)
+{
+    uint64_t key = CPUTHashBytes(Text.c_str(), Text.size()*sizeof(Text[0]));
+    CPUTGlyphRun **ppRun = mGlyphRunCache.Find(key);
+    if(ppRun && (*ppRun)->mText == Text)
+    {
+        return **ppRun;
+    }
+
+    // a different string with the same hash is replaced
+    CPUTGlyphRun *pRun = ppRun ? *ppRun : NULL;
+    CPUTGlyphRun previous;
+    if(!pRun)
+    {
+        if(mUsedGlyphRuns >= CPUT_MAX_CACHED_GLYPH_RUNS)
         {
-            return index;
+            // Labels that change every frame would fill the cache; start over rather than
+            // track use, and keep the runs' memory for the strings that follow
+            if(pPrevious)
+            {
+                previous = *pPrevious; // pPrevious may be one of the runs about to be reused
+                pPrevious = &previous;
+            }
+            mGlyphRunCache.Clear();
+            mUsedGlyphRuns = 0;
         }
-        index++;
+        if(mUsedGlyphRuns == mGlyphRuns.size())
+        {
+            mGlyphRuns.push_back(new CPUTGlyphRun());
+        }
+        pRun = mGlyphRuns[mUsedGlyphRuns++];
+        mGlyphRunCache.Insert(key, pRun);
+    }
+    else if(pRun == pPrevious)
+    {
+        previous = *pPrevious;
+        pPrevious = &previous;
     }
+    CPUTLayoutGlyphRun(*this, Text, pPrevious, pRun);
+    return *pRun;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFont::ClearGlyphRunCache()
+{
+    for(UINT ii=0; ii<mGlyphRuns.size(); ii++)
+    {
+        SAFE_DELETE(mGlyphRuns[ii]);
+    }
+    mGlyphRuns.clear();
+    mGlyphRunCache.Clear();
+    mUsedGlyphRuns = 0;
+}
 
-    // not found
-    return -1;
+// Constructor
+//-----------------------------------------------------------------------------
+CPUTFont::CPUTFont():
+    mAtlasWidth(0.0f),
+    mAtlasHeight(0.0f),
+    mDisabledYOffset(0.0f),
+    mNumberOfGlyphsInAtlas(0),
+    mUsedGlyphRuns(0)
+{
+    for(int ii=0; ii<CPUT_MAX_NUMBER_OF_CHARACTERS; ii++)
+    {
+        mpGlyphMap[ii] = -1;
+    }
 }
 
+// Destructor
+//-----------------------------------------------------------------------------
+CPUTFont::~CPUTFont()
+{
+    ClearGlyphRunCache();
+}
@@ -18,8 +18,11 @@
 
 #include "CPUT.h"
 #include "CPUTRefCount.h"
+#include "CPUTGlyphRun.h"
+#include "CPUTHash.h"
 
 #define CPUT_MAX_NUMBER_OF_CHARACTERS 256
+#define CPUT_MAX_CACHED_GLYPH_RUNS    1024
 
 class CPUTFont : public CPUTRefCount
 {
@@ -31,8 +34,20 @@ public:
     CPUT_SIZE GetGlyphSize(const char c);
     void GetGlyphUVS(const char c, const bool bEnabledVersion, float3& UV1, float3& UV2);
 
+    // O(1) lookups for laying out text.  The index is -1 if the font doesn't have the character.
+    int GetGlyphIndex(const wchar_t c) const { return ((unsigned int)c < CPUT_MAX_NUMBER_OF_CHARACTERS) ? mpGlyphMap[(unsigned int)c] : -1; }
+    const CPUT_SIZE &GetGlyphSizeByIndex(const int index) const { return mpGlyphSizes[index]; }
+    const float *GetGlyphUVCoordsByIndex(const int index, const bool bEnabledVersion) const { return (bEnabledVersion ? mpGlyphUVCoords : mpGlyphUVCoordsDisabled) + 4*index; }
+
+    // Returns the layout of Text, from the cache if it has been laid out before.  On a miss,
+    // the unchanged start and end of pPrevious (if given) are reused.  The reference is
+    // only valid until the next call.
+    const CPUTGlyphRun &LayoutText(const cString &Text, const CPUTGlyphRun *pPrevious);
+    void ClearGlyphRunCache();
+
 protected:
-    ~CPUTFont(){}  // Destructor is not public.  Must release instead of delete.
+    CPUTFont();
+    ~CPUTFont();  // Destructor is not public.  Must release instead of delete.
 
     // atlas texture info
     float mAtlasWidth;
@@ -40,15 +55,20 @@ protected:
     float mDisabledYOffset;
     UINT mNumberOfGlyphsInAtlas;
 
-    int mpGlyphMap[CPUT_MAX_NUMBER_OF_CHARACTERS];    
+    int mpGlyphMap[CPUT_MAX_NUMBER_OF_CHARACTERS];    // character -> glyph index, filled by BuildGlyphMap()
 
     int mpGlyphStarts[CPUT_MAX_NUMBER_OF_CHARACTERS];
     CPUT_SIZE mpGlyphSizes[CPUT_MAX_NUMBER_OF_CHARACTERS];
     float mpGlyphUVCoords[4*CPUT_MAX_NUMBER_OF_CHARACTERS]; // 4 floats/glyph = upper-left:(uv1.x, uv1.y), lower-right:(uv2.x, uv2.y)
     float mpGlyphUVCoordsDisabled[4*CPUT_MAX_NUMBER_OF_CHARACTERS]; // 4 floats/glyph = upper-left:(uv1.x, uv1.y), lower-right:(uv2.x, uv2.y)
 
+    // laid out strings, keyed by the hash of the string
+    CPUTFlatHashMap<CPUTGlyphRun*> mGlyphRunCache;
+    std::vector<CPUTGlyphRun*> mGlyphRuns;    // owned; the first mUsedGlyphRuns are in the cache
+    UINT mUsedGlyphRuns;
+
     // helper functions
-    int FindGlyphIndex(const char c);
+    void BuildGlyphMap();
 };
 
 #endif // #ifndef __CPUTFONT_H__
\ No newline at end of file
@@ -103,6 +103,7 @@ CPUTFont *CPUTFontDX11::CreateFont( cString FontName, cString AbsolutePathAndFil
         index++;
     }
     pNewFont->mNumberOfGlyphsInAtlas = index;
+    pNewFont->BuildGlyphMap();
 
     // add font to the asset library
     CPUTAssetLibrary::GetAssetLibrary()->AddFont( FontName, pNewFont);
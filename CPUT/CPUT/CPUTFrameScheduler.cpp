@@ -0,0 +1,178 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFrameScheduler.h"
+#include <assert.h>
+#include <string.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <time.h>
+#endif
+
+//-----------------------------------------------------------------------------
+CPUTFrameScheduler::CPUTFrameScheduler() :
+    mTargetPeriod(0.0),
+    mIdlePeriod(1.0 / 4.0),
+    mPollPeriod(1.0 / 30.0),
+    mIdleDelay(2.0),
+    mIdleThrottling(false),
+    mNextFrame(0.0),
+    mNextPoll(0.0),
+    mLastActivity(0.0)
+{
+    ResetStats();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::SetTargetRate( double framesPerSecond )
+{
+    mTargetPeriod = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::SetIdleRate( double framesPerSecond )
+{
+    assert( framesPerSecond > 0.0 );
+    mIdlePeriod = 1.0 / framesPerSecond;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::SetPollRate( double pollsPerSecond )
+{
+    assert( pollsPerSecond > 0.0 );
+    mPollPeriod = 1.0 / pollsPerSecond;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::SetIdleDelay( double seconds )
+{
+    mIdleDelay = seconds;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::Reset( double now )
+{
+    mNextFrame    = now;
+    mNextPoll     = now;
+    mLastActivity = now;
+}
+
+//-----------------------------------------------------------------------------
+CPUT_FRAME_ACTION CPUTFrameScheduler::GetAction( double now, double *pWaitSeconds ) const
+{
+    if( now >= mNextFrame )
+    {
+        return CPUT_FRAME_RENDER;
+    }
+    double wake = mNextFrame;
+    if( IsIdle( now ) )
+    {
+        if( now >= mNextPoll )
+        {
+            return CPUT_FRAME_POLL;
+        }
+        wake = mNextPoll < wake ? mNextPoll : wake;
+    }
+    *pWaitSeconds = wake - now;
+    return CPUT_FRAME_WAIT;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::BeginFrame( double now )
+{
+    bool   idle   = IsIdle( now );
+    double period = idle ? mIdlePeriod : mTargetPeriod;
+    mNextFrame += period;
+    if( mNextFrame <= now )
+    {
+        // A whole period behind (or no target rate): restart the grid here
+        mNextFrame = now + period;
+    }
+    // The frame's Update() looks for activity itself
+    mNextPoll = now + mPollPeriod;
+    mStats.mFrames++;
+    mStats.mIdleFrames += idle ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::EndFrame( double cpuSeconds )
+{
+    mStats.mLastCPUSeconds = cpuSeconds;
+    mStats.mCPUSeconds    += cpuSeconds;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::Polled( double now )
+{
+    mNextPoll = now + mPollPeriod;
+    mStats.mPolls++;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::Woke( bool byMessage )
+{
+    mStats.mWakeups++;
+    mStats.mEventWakeups += byMessage ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::ReportActivity( double now )
+{
+    if( IsIdle( now ) )
+    {
+        mNextFrame = now;
+        mStats.mActivityWakeups++;
+    }
+    mLastActivity = now;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrameScheduler::ResetStats()
+{
+    memset( &mStats, 0, sizeof(mStats) );
+}
+
+//-----------------------------------------------------------------------------
+double CPUTFrameScheduler::GetSeconds()
+{
+#ifdef _WIN32
+    LARGE_INTEGER ticks, frequency;
+    QueryPerformanceCounter( &ticks );
+    QueryPerformanceFrequency( &frequency );
+    return (double)ticks.QuadPart / (double)frequency.QuadPart;
+#else
+    timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+double CPUTFrameScheduler::GetThreadCPUSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes( GetCurrentThread(), &creation, &exit, &kernel, &user );
+    uint64_t kernelTime = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64_t userTime   = ((uint64_t)user.dwHighDateTime   << 32) | user.dwLowDateTime;
+    return (double)(kernelTime + userTime) * 1e-7;
+#else
+    timespec now;
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now );
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
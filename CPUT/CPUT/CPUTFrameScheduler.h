@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTFRAMESCHEDULER_H__
+#define __CPUTFRAMESCHEDULER_H__
+
+// Decides when the message loop renders, polls for activity or sleeps.
+//
+// Frames start on a grid at the target rate.  A late frame doesn't push back the ones
+// after it, unless it falls a whole period behind and the grid restarts.  A target rate
+// of 0 renders whenever the loop has no messages (the default).
+//
+// With idle throttling on, the app reports activity: the loop reports input messages,
+// and the app reports motion (e.g. from its sensors) in Update() or PollActivity().
+// After the idle delay without any, frames drop to the idle rate, and PollActivity() is
+// called at the poll rate in between.  The first report while idle makes a frame due
+// at once.
+//
+// Times are seconds on any monotonic clock.  The message loop passes GetSeconds(); a test
+// can pass a virtual clock instead.
+#include <stdint.h>
+
+enum CPUT_FRAME_ACTION
+{
+    CPUT_FRAME_RENDER,      // Call BeginFrame(), render, then EndFrame()
+    CPUT_FRAME_POLL,        // Call Polled(), then look for activity
+    CPUT_FRAME_WAIT,        // Sleep until a message arrives or the wait is over, then call Woke()
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTFrameSchedulerStats
+{
+    uint64_t mFrames;
+    uint64_t mIdleFrames;           // Frames at the idle rate
+    uint64_t mPolls;
+    uint64_t mWakeups;              // Waits that ended
+    uint64_t mEventWakeups;         // Waits that a message ended early
+    uint64_t mActivityWakeups;      // Reports of activity that ended idling
+    double   mCPUSeconds;           // CPU time of the rendering thread, over all frames
+    double   mLastCPUSeconds;       // and of the last frame
+
+    double   GetCPUSecondsPerFrame() const { return mFrames ? mCPUSeconds / mFrames : 0.0; }
+};
+
+//-----------------------------------------------------------------------------
+class CPUTFrameScheduler
+{
+protected:
+    double                  mTargetPeriod;
+    double                  mIdlePeriod;
+    double                  mPollPeriod;
+    double                  mIdleDelay;
+    bool                    mIdleThrottling;
+
+    double                  mNextFrame;
+    double                  mNextPoll;
+    double                  mLastActivity;
+    CPUTFrameSchedulerStats mStats;
+
+public:
+    CPUTFrameScheduler();
+
+    // 0 renders as often as the loop allows
+    void   SetTargetRate( double framesPerSecond );
+    void   SetIdleRate( double framesPerSecond );   // Above 0
+    void   SetPollRate( double pollsPerSecond );    // Above 0
+    void   SetIdleDelay( double seconds );
+    void   SetIdleThrottling( bool throttle ) { mIdleThrottling = throttle; }
+    double GetTargetRate() const { return mTargetPeriod > 0.0 ? 1.0 / mTargetPeriod : 0.0; }
+
+    // Starts the grid, counting as activity.  The loop calls it before its first frame.
+    void   Reset( double now );
+
+    // What to do at time now.  For CPUT_FRAME_WAIT, *pWaitSeconds is how long to sleep.
+    CPUT_FRAME_ACTION GetAction( double now, double *pWaitSeconds ) const;
+
+    void   BeginFrame( double now );
+    void   EndFrame( double cpuSeconds );
+    void   Polled( double now );
+    void   Woke( bool byMessage );
+    void   ReportActivity( double now );
+    bool   IsIdle( double now ) const { return mIdleThrottling && now - mLastActivity >= mIdleDelay; }
+
+    const CPUTFrameSchedulerStats &GetStats() const { return mStats; }
+    void   ResetStats();
+
+    // Monotonic wall clock, and CPU time used by the calling thread.  On Windows the CPU
+    // time only advances at the scheduler's tick (15.6 ms by default), so only averages
+    // over many frames are meaningful.
+    static double GetSeconds();
+    static double GetThreadCPUSeconds();
+};
+
+#endif // __CPUTFRAMESCHEDULER_H__
@@ -0,0 +1,253 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFrustumCuller.h"
+#include <assert.h>
+#include <math.h>
+
+#if defined(__AVX512F__)
+#   include <immintrin.h>
+#   define CPUT_CULL_AVX512
+#elif defined(__AVX__)
+#   include <immintrin.h>
+#   define CPUT_CULL_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#   include <xmmintrin.h>
+#   define CPUT_CULL_SSE
+#endif
+
+#if defined(CPUT_CULL_AVX512)
+//-----------------------------------------------------------------------------
+static inline uint32_t CountBits16( uint32_t bits )
+{
+    bits = bits - ((bits >> 1) & 0x5555);
+    bits = (bits & 0x3333) + ((bits >> 2) & 0x3333);
+    bits = (bits + (bits >> 4)) & 0x0F0F;
+    return (bits + (bits >> 8)) & 0x1F;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+CPUTFrustumCuller::CPUTFrustumCuller() :
+    mCount(0),
+    mUseSIMD(true)
+{
+    // Until SetPlanes() is called nothing is culled (every box is behind every plane).
+    for( int ii=0; ii<6; ii++ )
+    {
+        mPlane[ii][0] = mPlane[ii][1] = mPlane[ii][2] = 0.0f;
+        mPlane[ii][3] = -1.0f;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrustumCuller::Reserve( uint32_t count )
+{
+    uint32_t padded = (count + BATCH_SIZE - 1) & ~(uint32_t)(BATCH_SIZE - 1);
+    if( padded > mCenterX.size() )
+    {
+        mCenterX.resize( padded, 0.0f );
+        mCenterY.resize( padded, 0.0f );
+        mCenterZ.resize( padded, 0.0f );
+        mHalfX.resize( padded, 0.0f );
+        mHalfY.resize( padded, 0.0f );
+        mHalfZ.resize( padded, 0.0f );
+    }
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTFrustumCuller::AddBox( const float3 &center, const float3 &half )
+{
+    uint32_t index = mCount;
+    if( mCount == mCenterX.size() )
+    {
+        Reserve( mCount < (uint32_t)BATCH_SIZE ? (uint32_t)BATCH_SIZE : mCount * 2 );
+    }
+    mCount++;
+    SetBox( index, center, half );
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrustumCuller::SetBox( uint32_t index, const float3 &center, const float3 &half )
+{
+    assert( index < mCount );
+    mCenterX[index] = center.x;
+    mCenterY[index] = center.y;
+    mCenterZ[index] = center.z;
+    mHalfX[index]   = half.x;
+    mHalfY[index]   = half.y;
+    mHalfZ[index]   = half.z;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrustumCuller::SetPlane( uint32_t index, const float3 &normal, float d )
+{
+    assert( index < 6 );
+    mPlane[index][0] = normal.x;
+    mPlane[index][1] = normal.y;
+    mPlane[index][2] = normal.z;
+    mPlane[index][3] = d;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFrustumCuller::SetPlanes( const float3 *pNormals, const float3 &nearPoint, const float3 &farPoint )
+{
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        const float3 &point = ii < 3 ? nearPoint : farPoint;
+        SetPlane( ii, pNormals[ii], -dot3( pNormals[ii], point ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTFrustumCuller::CullScalar( uint32_t *pVisible ) const
+{
+    uint32_t visibleCount = 0;
+    for( uint32_t ii=0; ii<mCount; ii++ )
+    {
+        bool culled = false;
+        for( int pp=0; pp<6 && !culled; pp++ )
+        {
+            const float *pPlane = mPlane[pp];
+            float distance = pPlane[0]*mCenterX[ii] + pPlane[1]*mCenterY[ii] + pPlane[2]*mCenterZ[ii] + pPlane[3];
+            float radius   = fabsf(pPlane[0])*mHalfX[ii] + fabsf(pPlane[1])*mHalfY[ii] + fabsf(pPlane[2])*mHalfZ[ii];
+            culled = distance >= radius;
+        }
+        pVisible[visibleCount] = ii;
+        visibleCount += culled ? 0 : 1;
+    }
+    return visibleCount;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTFrustumCuller::Cull( uint32_t *pVisible ) const
+{
+    if( !mUseSIMD || 0 == mCount )
+    {
+        return CullScalar( pVisible );
+    }
+    const float *pCX = &mCenterX[0];
+    const float *pCY = &mCenterY[0];
+    const float *pCZ = &mCenterZ[0];
+    const float *pHX = &mHalfX[0];
+    const float *pHY = &mHalfY[0];
+    const float *pHZ = &mHalfZ[0];
+    uint32_t visibleCount = 0;
+
+#if defined(CPUT_CULL_AVX512)
+    __m512 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+    for( int pp=0; pp<6; pp++ )
+    {
+        nx[pp] = _mm512_set1_ps( mPlane[pp][0] );
+        ny[pp] = _mm512_set1_ps( mPlane[pp][1] );
+        nz[pp] = _mm512_set1_ps( mPlane[pp][2] );
+        d[pp]  = _mm512_set1_ps( mPlane[pp][3] );
+        ax[pp] = _mm512_set1_ps( fabsf(mPlane[pp][0]) );
+        ay[pp] = _mm512_set1_ps( fabsf(mPlane[pp][1]) );
+        az[pp] = _mm512_set1_ps( fabsf(mPlane[pp][2]) );
+    }
+    const __m512i laneIndex = _mm512_setr_epi32( 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 );
+    for( uint32_t ii=0; ii<mCount; ii+=16 )
+    {
+        __m512 cx = _mm512_loadu_ps( pCX + ii ), cy = _mm512_loadu_ps( pCY + ii ), cz = _mm512_loadu_ps( pCZ + ii );
+        __m512 hx = _mm512_loadu_ps( pHX + ii ), hy = _mm512_loadu_ps( pHY + ii ), hz = _mm512_loadu_ps( pHZ + ii );
+        __mmask16 culled = 0;
+        for( int pp=0; pp<6; pp++ )
+        {
+            __m512 distance = _mm512_add_ps( _mm512_add_ps( _mm512_mul_ps( nx[pp], cx ), _mm512_mul_ps( ny[pp], cy ) ),
+                                             _mm512_add_ps( _mm512_mul_ps( nz[pp], cz ), d[pp] ) );
+            __m512 radius   = _mm512_add_ps( _mm512_add_ps( _mm512_mul_ps( ax[pp], hx ), _mm512_mul_ps( ay[pp], hy ) ),
+                                             _mm512_mul_ps( az[pp], hz ) );
+            culled |= _mm512_cmp_ps_mask( distance, radius, _CMP_GE_OQ );
+        }
+        uint32_t remaining = mCount - ii;
+        __mmask16 visible = (__mmask16)(~culled & (remaining >= 16 ? 0xFFFF : ((1u << remaining) - 1)));
+        _mm512_mask_compressstoreu_epi32( pVisible + visibleCount, visible, _mm512_add_epi32( laneIndex, _mm512_set1_epi32( (int)ii ) ) );
+        visibleCount += CountBits16( visible );
+    }
+#elif defined(CPUT_CULL_AVX) || defined(CPUT_CULL_SSE)
+#   if defined(CPUT_CULL_AVX)
+#       define CULL_WIDTH          8
+#       define CULL_VEC            __m256
+#       define CULL_SET1(x)        _mm256_set1_ps(x)
+#       define CULL_LOAD(p)        _mm256_loadu_ps(p)
+#       define CULL_ADD(a,b)       _mm256_add_ps(a,b)
+#       define CULL_MUL(a,b)       _mm256_mul_ps(a,b)
+#       define CULL_OR(a,b)        _mm256_or_ps(a,b)
+#       define CULL_CMPGE(a,b)     _mm256_cmp_ps(a,b,_CMP_GE_OQ)
+#       define CULL_MOVEMASK(a)    _mm256_movemask_ps(a)
+#       define CULL_ZERO()         _mm256_setzero_ps()
+#   else
+#       define CULL_WIDTH          4
+#       define CULL_VEC            __m128
+#       define CULL_SET1(x)        _mm_set1_ps(x)
+#       define CULL_LOAD(p)        _mm_loadu_ps(p)
+#       define CULL_ADD(a,b)       _mm_add_ps(a,b)
+#       define CULL_MUL(a,b)       _mm_mul_ps(a,b)
+#       define CULL_OR(a,b)        _mm_or_ps(a,b)
+#       define CULL_CMPGE(a,b)     _mm_cmpge_ps(a,b)
+#       define CULL_MOVEMASK(a)    _mm_movemask_ps(a)
+#       define CULL_ZERO()         _mm_setzero_ps()
+#   endif
+    CULL_VEC nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+    for( int pp=0; pp<6; pp++ )
+    {
+        nx[pp] = CULL_SET1( mPlane[pp][0] );
+        ny[pp] = CULL_SET1( mPlane[pp][1] );
+        nz[pp] = CULL_SET1( mPlane[pp][2] );
+        d[pp]  = CULL_SET1( mPlane[pp][3] );
+        ax[pp] = CULL_SET1( fabsf(mPlane[pp][0]) );
+        ay[pp] = CULL_SET1( fabsf(mPlane[pp][1]) );
+        az[pp] = CULL_SET1( fabsf(mPlane[pp][2]) );
+    }
+    for( uint32_t ii=0; ii<mCount; ii+=CULL_WIDTH )
+    {
+        CULL_VEC cx = CULL_LOAD( pCX + ii ), cy = CULL_LOAD( pCY + ii ), cz = CULL_LOAD( pCZ + ii );
+        CULL_VEC hx = CULL_LOAD( pHX + ii ), hy = CULL_LOAD( pHY + ii ), hz = CULL_LOAD( pHZ + ii );
+        CULL_VEC culled = CULL_ZERO();
+        for( int pp=0; pp<6; pp++ )
+        {
+            CULL_VEC distance = CULL_ADD( CULL_ADD( CULL_MUL( nx[pp], cx ), CULL_MUL( ny[pp], cy ) ),
+                                          CULL_ADD( CULL_MUL( nz[pp], cz ), d[pp] ) );
+            CULL_VEC radius   = CULL_ADD( CULL_ADD( CULL_MUL( ax[pp], hx ), CULL_MUL( ay[pp], hy ) ),
+                                          CULL_MUL( az[pp], hz ) );
+            culled = CULL_OR( culled, CULL_CMPGE( distance, radius ) );
+        }
+        // Branch-free compaction.  Every lane writes its index, only visible lanes advance the cursor.
+        uint32_t visible   = ~(uint32_t)CULL_MOVEMASK( culled );
+        uint32_t laneCount = mCount - ii < CULL_WIDTH ? mCount - ii : CULL_WIDTH;
+        for( uint32_t lane=0; lane<laneCount; lane++ )
+        {
+            pVisible[visibleCount] = ii + lane;
+            visibleCount += (visible >> lane) & 1;
+        }
+    }
+#   undef CULL_WIDTH
+#   undef CULL_VEC
+#   undef CULL_SET1
+#   undef CULL_LOAD
+#   undef CULL_ADD
+#   undef CULL_MUL
+#   undef CULL_OR
+#   undef CULL_CMPGE
+#   undef CULL_MOVEMASK
+#   undef CULL_ZERO
+#else
+    (void)pCX; (void)pCY; (void)pCZ; (void)pHX; (void)pHY; (void)pHZ;
+    visibleCount = CullScalar( pVisible );
+#endif
+    return visibleCount;
+}
@@ -0,0 +1,75 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTFRUSTUMCULLER_H__
+#define __CPUTFRUSTUMCULLER_H__
+
+// Batched frustum culling.  World-space AABB centers and half-extents are kept
+// in struct-of-arrays form so a whole register of boxes (4 with SSE, 8 with AVX,
+// 16 with AVX-512) is tested against a plane at once.  Each plane uses the
+// center-extent test: a box is outside when
+//     dot(n, center) + d >= |n.x|*half.x + |n.y|*half.y + |n.z|*half.z
+// which gives the same answer as testing all eight corners (CPUTFrustum::IsVisible)
+// with one dot product per plane.
+//
+// Cull() writes the indices of the surviving boxes, in ascending order, to a
+// caller-supplied list.
+#include "CPUTMath.h"
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+class CPUTFrustumCuller
+{
+public:
+    enum { BATCH_SIZE = 16 }; // Storage is padded to a multiple of this (the widest batch)
+
+protected:
+    std::vector<float> mCenterX;
+    std::vector<float> mCenterY;
+    std::vector<float> mCenterZ;
+    std::vector<float> mHalfX;
+    std::vector<float> mHalfY;
+    std::vector<float> mHalfZ;
+    uint32_t           mCount;
+
+    // Outward-facing planes as (nx, ny, nz, d) with d = -dot(n, pointOnPlane)
+    float              mPlane[6][4];
+    bool               mUseSIMD;
+
+public:
+    CPUTFrustumCuller();
+    ~CPUTFrustumCuller() {}
+
+    void     Clear() { mCount = 0; }
+    void     Reserve( uint32_t count );
+    uint32_t AddBox( const float3 &center, const float3 &half );
+    void     SetBox( uint32_t index, const float3 &center, const float3 &half );
+    uint32_t GetCount() const { return mCount; }
+
+    // Planes in CPUTFrustum's layout: six outward normals (near, left, top, bottom, right, far).
+    // The first three planes pass through nearPoint, the last three through farPoint
+    // (CPUTFrustum::mpPosition[0] and mpPosition[6]).
+    void     SetPlanes( const float3 *pNormals, const float3 &nearPoint, const float3 &farPoint );
+    void     SetPlane( uint32_t index, const float3 &normal, float d );
+    const float *GetPlanes() const { return &mPlane[0][0]; } // 6 x (nx, ny, nz, d)
+
+    // pVisible must have room for GetCount() entries.  Returns the number of visible boxes.
+    uint32_t Cull( uint32_t *pVisible ) const;
+    uint32_t CullScalar( uint32_t *pVisible ) const;
+    void     SetUseSIMD( bool useSIMD ) { mUseSIMD = useSIMD; } // false always uses CullScalar() (for comparison)
+};
+
+#endif // __CPUTFRUSTUMCULLER_H__
@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTGlyphRun.h"
+#include "CPUTFont.h"
+
+//-----------------------------------------------------------------------------
+void CPUTGlyphRun::Swap( CPUTGlyphRun &other )
+{
+    mText.swap( other.mText );
+    mLeft.swap( other.mLeft );
+    mRight.swap( other.mRight );
+    mGlyph.swap( other.mGlyph );
+    std::swap( mWidth, other.mWidth );
+    std::swap( mHeight, other.mHeight );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTLayoutGlyphRun( const CPUTFont &font, const cString &text, const CPUTGlyphRun *pPrevious, CPUTGlyphRun *pRun )
+{
+    uint32_t length         = (uint32_t)text.size();
+    uint32_t previousLength = pPrevious ? pPrevious->GetLength() : 0;
+    uint32_t common         = length < previousLength ? length : previousLength;
+
+    // Characters shared with the previous string at the start and at the end
+    uint32_t prefix = 0;
+    uint32_t suffix = 0;
+    if( pPrevious )
+    {
+        while( prefix < common && text[prefix] == pPrevious->mText[prefix] )
+        {
+            prefix++;
+        }
+        while( suffix < common - prefix && text[length-1-suffix] == pPrevious->mText[previousLength-1-suffix] )
+        {
+            suffix++;
+        }
+    }
+
+    pRun->mText = text;
+    pRun->mLeft.resize( length );
+    pRun->mRight.resize( length );
+    pRun->mGlyph.resize( length );
+    for( uint32_t ii=0; ii<prefix; ii++ )
+    {
+        pRun->mLeft[ii]  = pPrevious->mLeft[ii];
+        pRun->mRight[ii] = pPrevious->mRight[ii];
+        pRun->mGlyph[ii] = pPrevious->mGlyph[ii];
+    }
+
+    float    position = prefix ? pRun->mRight[prefix-1] : 0.0f;
+    uint32_t ii       = prefix;
+    for( ; ii<length; ii++ )
+    {
+        // Once the shared tail starts where it used to, the rest of the layout is unchanged
+        // (tabs only depend on the position they start at)
+        if( ii == length - suffix && position == pPrevious->mLeft[previousLength - suffix] )
+        {
+            break;
+        }
+
+        int glyph   = font.GetGlyphIndex( text[ii] );
+        int advance = (glyph < 0) ? 0 : font.GetGlyphSizeByIndex( glyph ).width;
+        if( '\t' == text[ii] && advance > 0 )
+        {
+            // tabs advance to the next multiple of the tab glyph's width from the start of the string
+            advance -= (int)position % advance;
+        }
+        pRun->mLeft[ii]  = position;
+        pRun->mRight[ii] = position + (float)advance;
+        pRun->mGlyph[ii] = glyph;
+        position        += (float)advance;
+    }
+    uint32_t offset = previousLength - length;  // Unsigned wraparound is fine: ii + offset is in range
+    for( ; ii<length; ii++ )
+    {
+        pRun->mLeft[ii]  = pPrevious->mLeft[ii + offset];
+        pRun->mRight[ii] = pPrevious->mRight[ii + offset];
+        pRun->mGlyph[ii] = pPrevious->mGlyph[ii + offset];
+    }
+
+    pRun->mWidth  = length ? (int)pRun->mRight[length-1] : 0;
+    pRun->mHeight = 0;
+    for( ii=0; ii<length; ii++ )
+    {
+        if( pRun->mGlyph[ii] >= 0 && font.GetGlyphSizeByIndex( pRun->mGlyph[ii] ).height > pRun->mHeight )
+        {
+            pRun->mHeight = font.GetGlyphSizeByIndex( pRun->mGlyph[ii] ).height;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTCompareGlyphRuns( const CPUTGlyphRun &before, const CPUTGlyphRun &after, uint32_t *pPrefix, uint32_t *pSuffix )
+{
+    uint32_t beforeLength = before.GetLength();
+    uint32_t afterLength  = after.GetLength();
+    uint32_t common       = beforeLength < afterLength ? beforeLength : afterLength;
+
+    uint32_t prefix = 0;
+    while( prefix < common &&
+           before.mText[prefix] == after.mText[prefix] && before.mLeft[prefix] == after.mLeft[prefix] && before.mRight[prefix] == after.mRight[prefix] )
+    {
+        prefix++;
+    }
+    uint32_t suffix = 0;
+    while( suffix < common - prefix )
+    {
+        uint32_t b = beforeLength - 1 - suffix;
+        uint32_t a = afterLength - 1 - suffix;
+        if( before.mText[b] != after.mText[a] || before.mLeft[b] != after.mLeft[a] || before.mRight[b] != after.mRight[a] )
+        {
+            break;
+        }
+        suffix++;
+    }
+    *pPrefix = prefix;
+    *pSuffix = suffix;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTBuildGlyphQuads( const CPUTFont &font, const CPUTGlyphRun &run, uint32_t first, uint32_t last, float x, float y, float z, bool bEnabled, CPUTGUIVertex *pVertices )
+{
+    CPUTGUIVertex *pQuad = pVertices + 6 * first;
+    for( uint32_t ii=first; ii<last; ii++, pQuad += 6 )
+    {
+        // Everything comes from the run and two table reads; characters that aren't drawn
+        // collapse to zero width instead of branching around the vertex writes
+        int          glyph = run.mGlyph[ii] < 0 ? 0 : run.mGlyph[ii];
+        const float *pUV   = font.GetGlyphUVCoordsByIndex( glyph, bEnabled );
+        bool         drawn = run.mGlyph[ii] >= 0 && '\t' != run.mText[ii];
+        float        x1    = x + run.mLeft[ii];
+        float        x2    = drawn ? x + run.mRight[ii] : x1;
+        float        y2    = y + (float)font.GetGlyphSizeByIndex( glyph ).height;
+
+        pQuad[0].Pos = float3( x1, y,  z );  pQuad[0].UV = float2( pUV[0], pUV[1] );
+        pQuad[1].Pos = float3( x2, y,  z );  pQuad[1].UV = float2( pUV[2], pUV[1] );
+        pQuad[2].Pos = float3( x1, y2, z );  pQuad[2].UV = float2( pUV[0], pUV[3] );
+        pQuad[3].Pos = float3( x2, y,  z );  pQuad[3].UV = float2( pUV[2], pUV[1] );
+        pQuad[4].Pos = float3( x2, y2, z );  pQuad[4].UV = float2( pUV[2], pUV[3] );
+        pQuad[5].Pos = float3( x1, y2, z );  pQuad[5].UV = float2( pUV[0], pUV[3] );
+    }
+}
@@ -0,0 +1,58 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTGLYPHRUN_H__
+#define __CPUTGLYPHRUN_H__
+
+// Laid-out text: where each character of a string goes, in pixels from the start of
+// the string, and which glyph of the font draws it.  Fonts cache runs by the string's
+// hash (CPUTFont::LayoutText()), and a run can be laid out starting from the previous
+// string's run, so a numeric readout that changes a few digits only measures those.
+#include "CPUTGuiController.h"
+#include <stdint.h>
+#include <vector>
+
+class CPUTFont;
+
+//-----------------------------------------------------------------------------
+struct CPUTGlyphRun
+{
+    cString             mText;
+    std::vector<float>  mLeft;      // Per character: the span it advances over
+    std::vector<float>  mRight;
+    std::vector<int>    mGlyph;     // Font glyph index, or -1 if the font doesn't have the character
+    int                 mWidth;
+    int                 mHeight;    // Tallest glyph
+
+    CPUTGlyphRun() : mWidth(0), mHeight(0) {}
+    uint32_t GetLength() const { return (uint32_t)mGlyph.size(); }
+    void     Swap( CPUTGlyphRun &other );
+};
+
+// Lays out text in font.  If pPrevious is given, the characters before the first one that
+// differs from pPrevious->mText are copied rather than measured, and so are the trailing
+// characters the two strings share once the layout reaches them at the same position.
+void CPUTLayoutGlyphRun( const CPUTFont &font, const cString &text, const CPUTGlyphRun *pPrevious, CPUTGlyphRun *pRun );
+
+// Counts the leading and trailing characters laid out identically in before and after
+// (a character is never counted in both).  Their quads don't need rebuilding.
+void CPUTCompareGlyphRuns( const CPUTGlyphRun &before, const CPUTGlyphRun &after, uint32_t *pPrefix, uint32_t *pSuffix );
+
+// Writes one quad (6 vertices) per character in [first, last) of run, the string's top-left
+// corner at (x, y).  Tabs and characters the font lacks get zero-width quads, so
+// pVertices[6*ii] always belongs to character ii.
+void CPUTBuildGlyphQuads( const CPUTFont &font, const CPUTGlyphRun &run, uint32_t first, uint32_t last, float x, float y, float z, bool bEnabled, CPUTGUIVertex *pVertices );
+
+#endif // __CPUTGLYPHRUN_H__
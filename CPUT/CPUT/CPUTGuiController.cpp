@@ -555,7 +555,14 @@ void CPUTGuiController::RecalculateLayout()
             {
                 mControlPanelIDList[mActiveControlPanelSlotID]->mControlList[i]->GetDimensions(width, height);
                 x = windowRect.width - columnX - columnWidth - (columnNumber*GUI_WINDOW_PADDING);
-                mControlPanelIDList[mActiveControlPanelSlotID]->mControlList[i]->SetPosition(x,y);
+
+                // only move controls that moved: SetPosition() rebuilds the control's vertices
+                int currentX, currentY;
+                mControlPanelIDList[mActiveControlPanelSlotID]->mControlList[i]->GetPosition(currentX, currentY);
+                if(currentX != x || currentY != y)
+                {
+                    mControlPanelIDList[mActiveControlPanelSlotID]->mControlList[i]->SetPosition(x,y);
+                }
 
                 y = y + height + GUI_WINDOW_PADDING;
             }
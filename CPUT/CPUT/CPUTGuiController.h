@@ -66,7 +66,7 @@ public:
     void Resize();  
     void RecalculateLayout();                                                   // forces a recalculation of control positions
     void SetCallback(CPUTCallbackHandler *pHandler, bool ForceAll=false);       // sets the event handler callback on all registered controls
-    void ControlIsDirty() {mUberBufferDirty = true;}
+    void ControlIsDirty(CPUTControl *pControl) {pControl->SetGraphicsDirty(true); mUberBufferDirty = true;}  // only pControl's vertices are rebuilt
 
 protected:
     cString     mResourceDirectory;
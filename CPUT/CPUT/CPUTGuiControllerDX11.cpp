@@ -17,6 +17,7 @@
 #include "CPUT_DX11.h" // for CPUTSetRasterizerState()
 #include "CPUTTextureDX11.h"
 #include "CPUTFontDX11.h"
+#include "CPUTRenderBackendDX11.h"
 
 
 CPUTGuiControllerDX11* CPUTGuiControllerDX11::mguiController = NULL;
@@ -33,15 +34,15 @@ CPUTGuiControllerDX11::CPUTGuiControllerDX11():CPUTGuiController(),
     mpControlTextureAtlas(NULL),
     mpControlTextureAtlasView(NULL),
     mpUberBuffer(NULL),
-    mpMirrorBuffer(NULL),
-    mUberBufferIndex(0),
-    mUberBufferMax(CPUT_GUI_BUFFER_SIZE),
+    mControlArena(CPUT_GUI_VERTEX_BUFFER_SIZE),
+    mpControlScratchBuffer(NULL),
     mpFont(NULL),
     mpTextTextureAtlas(NULL),
     mpTextTextureAtlasView(NULL),
     mpTextUberBuffer(NULL),
-    mpTextMirrorBuffer(NULL),
-    mTextUberBufferIndex(0),
+    mTextArena(CPUT_GUI_BUFFER_STRING_SIZE),
+    mpTextScratchBuffer(NULL),
+    mpRangesFocusControl(NULL),
 
     mFocusedControlBufferIndex(0),
     mpFocusedControlBuffer(NULL),
@@ -57,8 +58,8 @@ CPUTGuiControllerDX11::CPUTGuiControllerDX11():CPUTGuiController(),
     mpFPSDirectXBuffer(NULL),
     mpFPSTimer(NULL)
 {
-    mpMirrorBuffer = new CPUTGUIVertex[CPUT_GUI_BUFFER_SIZE];
-    mpTextMirrorBuffer = new  CPUTGUIVertex[CPUT_GUI_BUFFER_STRING_SIZE];
+    mpControlScratchBuffer = new CPUTGUIVertex[CPUT_GUI_BUFFER_SIZE];
+    mpTextScratchBuffer = new  CPUTGUIVertex[CPUT_GUI_BUFFER_STRING_SIZE];
 
     mpFocusedControlMirrorBuffer = new CPUTGUIVertex[CPUT_GUI_BUFFER_SIZE];
     mpFocusedControlTextMirrorBuffer = new CPUTGUIVertex[CPUT_GUI_BUFFER_STRING_SIZE];
@@ -94,8 +95,8 @@ CPUTGuiControllerDX11::~CPUTGuiControllerDX11()
     SAFE_DELETE(mpFPSTimer);
 
     // delete arrays
-    SAFE_DELETE_ARRAY(mpTextMirrorBuffer);
-    SAFE_DELETE_ARRAY(mpMirrorBuffer);
+    SAFE_DELETE_ARRAY(mpTextScratchBuffer);
+    SAFE_DELETE_ARRAY(mpControlScratchBuffer);
     SAFE_DELETE_ARRAY(mpFocusedControlMirrorBuffer);
     SAFE_DELETE_ARRAY(mpFocusedControlTextMirrorBuffer);
     SAFE_DELETE_ARRAY(mpFPSMirrorBuffer);
@@ -338,6 +339,26 @@ CPUTResult CPUTGuiControllerDX11::DeleteControl(CPUTControlID controlID)
     return CPUT_SUCCESS;
 }
 
+// Upload and bind the vertex shader constants.  Uses the frame's upload ring when there is one.
+//--------------------------------------------------------------------------------
+void CPUTGuiControllerDX11::SetConstantBufferVS(CPUTRenderBackend *pBackend, const GUIConstantBufferVS &constants)
+{
+    CPUTUploadRing *pRing = CPUT_DX11::GetUploadRing();
+    UINT            offset;
+    void           *pMapped = pRing ? pRing->Allocate( sizeof(constants), &offset ) : NULL;
+    if( pMapped )
+    {
+        memcpy( pMapped, &constants, sizeof(constants) );
+        pRing->Flush();
+        pBackend->SetConstantBufferRange( CPUT_SHADER_STAGE_VERTEX, 0, pRing->GetBuffer(), offset, sizeof(constants) );
+    }
+    else
+    {
+        pBackend->UpdateBuffer( mpConstantBufferVS, &constants, sizeof(constants) );
+        pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_VERTEX, 0, 1, (CPUTBackendHandle*)&mpConstantBufferVS );
+    }
+}
+
 // DrawFPS - Should the GUI draw the FPS counter in the upper-left?
 //--------------------------------------------------------------------------------
 void CPUTGuiControllerDX11::DrawFPS(bool drawfps)
@@ -354,13 +375,13 @@ float CPUTGuiControllerDX11::GetFPS()
 
 // Draw - must be positioned after all the controls are defined
 //--------------------------------------------------------------------------------
-void CPUTGuiControllerDX11::Draw(ID3D11DeviceContext *pImmediateContext)
+void CPUTGuiControllerDX11::Draw(CPUTRenderBackend *pBackend)
 {
     HEAPCHECK;
 
     if( 0 != GetNumberOfControlsInPanel())
     {
-        SetGUIDrawingState(pImmediateContext);
+        SetGUIDrawingState(pBackend);
     }
     else
     {
@@ -370,81 +391,21 @@ void CPUTGuiControllerDX11::Draw(ID3D11DeviceContext *pImmediateContext)
     ID3D11VertexShader *pVertexShader = mpGUIVertexShader->GetNativeVertexShader();
     ID3D11PixelShader  *pPixelShader  = mpGUIPixelShader->GetNativePixelShader();
 
-    // if any of the controls have announced they are dirty, then rebuild the mirror buffer and rebind
+    // if any of the controls have announced they are dirty, rebuild just those controls' graphics
+    // and upload the parts of the uber-buffers they changed
     if(mUberBufferDirty)
     {
         
-        // if a resize was flagged, do it now.  
+        // if a resize was flagged, do it now.  Controls that move mark themselves dirty.
         if(mRecalculateLayout)
         {
             RecalculateLayout();
         }
 
-
-        // 'clear' the buffer by resetting the pointer to the head
-        mUberBufferIndex = 0;
-        mTextUberBufferIndex = 0;
-        mFocusedControlBufferIndex = 0;
-        mFocusedControlTextBufferIndex = 0;
-
-        int ii=0;
-        while(ii<GetNumberOfControlsInPanel())
-        {
-            CPUTControl *pControl = mControlPanelIDList[mActiveControlPanelSlotID]->mControlList[ii];
-
-            // don't draw the focus control - draw it last so it stays on 'top'
-            if(mpFocusControl != pControl)
-            {
-                switch(pControl->GetType())
-                {
-                case CPUT_BUTTON:
-                    ((CPUTButton*)pControl)->DrawIntoBuffer(mpMirrorBuffer, &mUberBufferIndex, mUberBufferMax, mpTextMirrorBuffer, &mTextUberBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);                    
-                    break;
-                case CPUT_CHECKBOX:
-                    ((CPUTCheckbox*)pControl)->DrawIntoBuffer(mpMirrorBuffer, &mUberBufferIndex, mUberBufferMax, mpTextMirrorBuffer, &mTextUberBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                    break;
-                case CPUT_SLIDER:
-                    ((CPUTSlider*)pControl)->DrawIntoBuffer(mpMirrorBuffer, &mUberBufferIndex, mUberBufferMax, mpTextMirrorBuffer, &mTextUberBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                    break;
-                case CPUT_DROPDOWN:
-                    ((CPUTDropdown*)pControl)->DrawIntoBuffer(mpMirrorBuffer, &mUberBufferIndex, mUberBufferMax, mpTextMirrorBuffer, &mTextUberBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                    break;
-
-                case CPUT_STATIC:
-                    ((CPUTText*)pControl)->DrawIntoBuffer(mpTextMirrorBuffer, &mTextUberBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                    break;
-                }
-            }
-            ii++;
-            HEAPCHECK
-        }
-
-        // do the 'focused' control last so it stays on top (i.e. dropdowns)
-        if(mpFocusControl)
-        {
-            switch(mpFocusControl->GetType())
-            {
-            case CPUT_BUTTON:
-                ((CPUTButton*)mpFocusControl)->DrawIntoBuffer(mpFocusedControlMirrorBuffer, &mFocusedControlBufferIndex, mUberBufferMax, mpFocusedControlTextMirrorBuffer, &mFocusedControlTextBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);                    
-                break;
-            case CPUT_CHECKBOX:
-                ((CPUTCheckbox*)mpFocusControl)->DrawIntoBuffer(mpFocusedControlMirrorBuffer, &mFocusedControlBufferIndex, mUberBufferMax, mpFocusedControlTextMirrorBuffer, &mFocusedControlTextBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                break;
-            case CPUT_SLIDER:
-                ((CPUTSlider*)mpFocusControl)->DrawIntoBuffer(mpFocusedControlMirrorBuffer, &mFocusedControlBufferIndex, mUberBufferMax, mpFocusedControlTextMirrorBuffer, &mFocusedControlTextBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                break;
-            case CPUT_DROPDOWN:
-                ((CPUTDropdown*)mpFocusControl)->DrawIntoBuffer(mpFocusedControlMirrorBuffer, &mFocusedControlBufferIndex, mUberBufferMax, mpFocusedControlTextMirrorBuffer, &mFocusedControlTextBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                break;
-            case CPUT_STATIC:
-                ((CPUTText*)mpFocusControl)->DrawIntoBuffer(mpFocusedControlMirrorBuffer, &mFocusedControlTextBufferIndex, CPUT_GUI_BUFFER_STRING_SIZE);
-                break;
-            }
-        }
-        
+        bool FocusedControlChanged = RebuildDirtyControls();
                 
         // update the uber-buffers with the control graphics
-        UpdateUberBuffers(pImmediateContext);
+        UpdateUberBuffers(pBackend, FocusedControlChanged);
 
         // Clear dirty flag on uberbuffer
         mUberBufferDirty = false;
@@ -483,7 +444,7 @@ void CPUTGuiControllerDX11::Draw(ID3D11DeviceContext *pImmediateContext)
 
         // update the DirectX vertex buffer
         ASSERT(CPUT_GUI_BUFFER_STRING_SIZE > mFocusedControlTextBufferIndex, _L("CPUT GUI: Too many strings for default-sized uber-buffer.  Increase CPUT_GUI_BUFFER_STRING_SIZE"));
-        pImmediateContext->UpdateSubresource(mpFPSDirectXBuffer, 0, NULL, mpFPSMirrorBuffer, mFPSBufferIndex*sizeof(CPUTGUIVertex), 0);
+        pBackend->UpdateBuffer(mpFPSDirectXBuffer, mpFPSMirrorBuffer, mFPSBufferIndex*sizeof(CPUTGUIVertex));
         
         // start next frame timer
         mpFPSTimer->StartTimer();
@@ -507,85 +468,190 @@ void CPUTGuiControllerDX11::Draw(ID3D11DeviceContext *pImmediateContext)
     ConstantBufferMatrices.Projection = XMMatrixTranspose( m );
 
     // set the vertex shader
-    pImmediateContext->VSSetShader( pVertexShader, NULL, 0 );
+    pBackend->SetShader( CPUT_SHADER_STAGE_VERTEX, pVertexShader );
     UINT VertexStride = sizeof(CPUTGUIVertex);
     UINT VertexOffset = 0;
-    pImmediateContext->IASetVertexBuffers( 0, 1, &mpUberBuffer, &VertexStride, &VertexOffset );
+    pBackend->SetVertexBuffer( 0, mpUberBuffer, VertexStride, VertexOffset );
 
     m = XMMatrixIdentity();
     ConstantBufferMatrices.Model = XMMatrixTranspose( m );
-    pImmediateContext->UpdateSubresource( mpConstantBufferVS, 0, NULL, &ConstantBufferMatrices, 0, 0 );
-    pImmediateContext->VSSetConstantBuffers( 0, 1, &mpConstantBufferVS );
+    SetConstantBufferVS( pBackend, ConstantBufferMatrices );
 
     // -- draw the normal controls --    
     // draw the control graphics
-    pImmediateContext->PSSetShader( pPixelShader, NULL, 0 );
-    pImmediateContext->PSSetShaderResources( 0, 1, &mpControlTextureAtlasView );    
-    pImmediateContext->Draw(mUberBufferIndex,0);
+    pBackend->SetShader( CPUT_SHADER_STAGE_PIXEL, pPixelShader );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 1, (CPUTBackendHandle*)&mpControlTextureAtlasView );    
+    pBackend->Draw(mControlArena.GetVertexCount(),0);
 
     // draw the control's text
-    pImmediateContext->PSSetShaderResources( 0, 1, &mpTextTextureAtlasView );
-    pImmediateContext->IASetVertexBuffers( 0, 1, &mpTextUberBuffer, &VertexStride, &VertexOffset );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 1, (CPUTBackendHandle*)&mpTextTextureAtlasView );
+    pBackend->SetVertexBuffer( 0, mpTextUberBuffer, VertexStride, VertexOffset );
     // draw the text uber-buffer
-    pImmediateContext->Draw(mTextUberBufferIndex,0);
+    pBackend->Draw(mTextArena.GetVertexCount(),0);
 
     // draw the FPS counter
     if(mbDrawFPS)
     {
-        pImmediateContext->IASetVertexBuffers( 0, 1, &mpFPSDirectXBuffer, &VertexStride, &VertexOffset );
-        pImmediateContext->Draw(mFPSBufferIndex, 0);
+        pBackend->SetVertexBuffer( 0, mpFPSDirectXBuffer, VertexStride, VertexOffset );
+        pBackend->Draw(mFPSBufferIndex, 0);
     }
     
     // -- draw the focused control --
     // Draw the focused control's graphics
-    pImmediateContext->PSSetShader( pPixelShader, NULL, 0 );
-    pImmediateContext->PSSetShaderResources( 0, 1, &mpControlTextureAtlasView );
-    pImmediateContext->IASetVertexBuffers( 0, 1, &mpFocusedControlBuffer, &VertexStride, &VertexOffset );
+    pBackend->SetShader( CPUT_SHADER_STAGE_PIXEL, pPixelShader );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 1, (CPUTBackendHandle*)&mpControlTextureAtlasView );
+    pBackend->SetVertexBuffer( 0, mpFocusedControlBuffer, VertexStride, VertexOffset );
     // draw the uber-buffer
-    pImmediateContext->Draw(mFocusedControlBufferIndex,0);
+    pBackend->Draw(mFocusedControlBufferIndex,0);
 
 
     // Draw the focused control's text
-    pImmediateContext->PSSetShaderResources( 0, 1, &mpTextTextureAtlasView );
-    pImmediateContext->IASetVertexBuffers( 0, 1, &mpFocusedControlTextBuffer, &VertexStride, &VertexOffset );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 1, (CPUTBackendHandle*)&mpTextTextureAtlasView );
+    pBackend->SetVertexBuffer( 0, mpFocusedControlTextBuffer, VertexStride, VertexOffset );
     // draw the text uber-buffer
-    pImmediateContext->Draw(mFocusedControlTextBufferIndex,0);
+    pBackend->Draw(mFocusedControlTextBufferIndex,0);
 
 
     // restore the drawing state
-    ClearGUIDrawingState(pImmediateContext);
+    ClearGUIDrawingState(pBackend);
     HEAPCHECK;
 }
 
-//
+// Regenerates the graphics of the active panel's dirty controls into their ranges
+// of the uber-buffer arenas.  Returns true if the focused control's buffers changed.
 //------------------------------------------------------------------------
-CPUTResult CPUTGuiControllerDX11::UpdateUberBuffers(ID3D11DeviceContext *pImmediateContext )
+bool CPUTGuiControllerDX11::RebuildDirtyControls()
 {
-    ASSERT(pImmediateContext, _L("CPUTGuiControllerDX11::UpdateUberBuffers - Context pointer is NULL"));
+    std::vector<CPUTControl*> &ControlList = mControlPanelIDList[mActiveControlPanelSlotID]->mControlList;
 
-    // get the device
-    ID3D11Device *pD3dDevice = NULL;
-    pImmediateContext->GetDevice(&pD3dDevice);
-    
+    // a different list of controls (added, removed, another panel) is placed from scratch
+    bool RebuildAll = (ControlList.size() != mControlRanges.size());
+    for(UINT ii=0; ii<ControlList.size() && !RebuildAll; ii++)
+    {
+        RebuildAll = (ControlList[ii] != mControlRanges[ii].mpControl);
+    }
 
-    // Update geometry to draw the control graphics
-    ASSERT(CPUT_GUI_VERTEX_BUFFER_SIZE > mUberBufferIndex, _L("CPUT GUI: Too many controls for default-sized uber-buffer.  Increase CPUT_GUI_VERTEX_BUFFER_SIZE"));
-    pImmediateContext->UpdateSubresource(mpUberBuffer, 0, NULL, (void*) mpMirrorBuffer, sizeof( CPUTGUIVertex )*(mUberBufferIndex+1), 0);
+    // the focused control is drawn on its own buffers, so a change of focus moves two controls
+    CPUTControl *pPreviousFocusControl = mpRangesFocusControl;
+    bool FocusedControlChanged = RebuildAll || (mpFocusControl != pPreviousFocusControl) ||
+                                 (mpFocusControl && mpFocusControl->IsGraphicsDirty());
 
-    // Update geometry to draw the controls' text
-    ASSERT(CPUT_GUI_BUFFER_STRING_SIZE > mTextUberBufferIndex, _L("CPUT GUI: Too many strings for default-sized uber-buffer.  Increase CPUT_GUI_BUFFER_STRING_SIZE"));
-    pImmediateContext->UpdateSubresource(mpTextUberBuffer, 0, NULL, (void*) mpTextMirrorBuffer, sizeof( CPUTGUIVertex )*(mTextUberBufferIndex+1), 0);
-    
-    // register the focused control's graphics
-    ASSERT(CPUT_GUI_VERTEX_BUFFER_SIZE > mUberBufferIndex, _L("CPUT GUI: Too many controls for default-sized uber-buffer.  Increase CPUT_GUI_VERTEX_BUFFER_SIZE"));
-    pImmediateContext->UpdateSubresource(mpFocusedControlBuffer, 0, NULL, (void*) mpFocusedControlMirrorBuffer, sizeof( CPUTGUIVertex )*(mFocusedControlBufferIndex+1), 0);
+    if(!PlaceControls(RebuildAll, pPreviousFocusControl))
+    {
+        // out of room - pack all the controls again, without the space left behind by controls that grew
+        bool Placed = !RebuildAll && PlaceControls(true, pPreviousFocusControl);
+        ASSERT(Placed, _L("CPUT GUI: Too many controls for default-sized uber-buffer.  Increase CPUT_GUI_VERTEX_BUFFER_SIZE and CPUT_GUI_BUFFER_STRING_SIZE"));
+    }
+    mpRangesFocusControl = mpFocusControl;
 
-    //register the focused control's text
-    ASSERT(CPUT_GUI_BUFFER_STRING_SIZE > mFocusedControlTextBufferIndex, _L("CPUT GUI: Too many strings for default-sized uber-buffer.  Increase CPUT_GUI_BUFFER_STRING_SIZE"));
-    pImmediateContext->UpdateSubresource(mpFocusedControlTextBuffer, 0, NULL, (void*) mpFocusedControlTextMirrorBuffer, sizeof( CPUTGUIVertex )*(mFocusedControlTextBufferIndex+1), 0);
+    // do the 'focused' control last so it stays on top (i.e. dropdowns)
+    if(FocusedControlChanged)
+    {
+        mFocusedControlBufferIndex = 0;
+        mFocusedControlTextBufferIndex = 0;
+        if(mpFocusControl)
+        {
+            DrawControlIntoBuffers(mpFocusControl, mpFocusedControlMirrorBuffer, &mFocusedControlBufferIndex, mpFocusedControlTextMirrorBuffer, &mFocusedControlTextBufferIndex);
+            mpFocusControl->SetGraphicsDirty(false);
+        }
+    }
+    return FocusedControlChanged;
+}
+
+// Writes the dirty controls (or all of them) into the arenas.  Returns false if they ran out of room.
+//------------------------------------------------------------------------
+bool CPUTGuiControllerDX11::PlaceControls(bool bRebuildAll, CPUTControl *pPreviousFocusControl)
+{
+    std::vector<CPUTControl*> &ControlList = mControlPanelIDList[mActiveControlPanelSlotID]->mControlList;
+    if(bRebuildAll)
+    {
+        mControlArena.Reset();
+        mTextArena.Reset();
+        mControlRanges.resize(ControlList.size());
+        for(UINT ii=0; ii<ControlList.size(); ii++)
+        {
+            ControlRange Empty = { ControlList[ii], 0, 0, 0, 0 };
+            mControlRanges[ii] = Empty;
+        }
+    }
+
+    bool FocusChanged = (mpFocusControl != pPreviousFocusControl);
+    for(UINT ii=0; ii<ControlList.size(); ii++)
+    {
+        CPUTControl *pControl = ControlList[ii];
+        if(!bRebuildAll && !pControl->IsGraphicsDirty() &&
+           !(FocusChanged && (pControl == mpFocusControl || pControl == pPreviousFocusControl)))
+        {
+            continue;
+        }
+
+        // the focused control keeps an empty range here - it's drawn last, from its own buffers
+        UINT VertexCount = 0;
+        UINT TextVertexCount = 0;
+        if(pControl != mpFocusControl)
+        {
+            DrawControlIntoBuffers(pControl, mpControlScratchBuffer, &VertexCount, mpTextScratchBuffer, &TextVertexCount);
+        }
+
+        ControlRange &Range = mControlRanges[ii];
+        if( !mControlArena.Place(&Range.mStart, &Range.mCount, mpControlScratchBuffer, VertexCount) ||
+            !mTextArena.Place(&Range.mTextStart, &Range.mTextCount, mpTextScratchBuffer, TextVertexCount) )
+        {
+            return false;
+        }
+        if(pControl != mpFocusControl)
+        {
+            pControl->SetGraphicsDirty(false);
+        }
+        HEAPCHECK
+    }
+    return true;
+}
 
-    // release the device pointer
-    SAFE_RELEASE(pD3dDevice);    
+//
+//------------------------------------------------------------------------
+void CPUTGuiControllerDX11::DrawControlIntoBuffers(CPUTControl *pControl, CPUTGUIVertex *pVertexBuffer, UINT *pInsertIndex, CPUTGUIVertex *pTextVertexBuffer, UINT *pTextInsertIndex)
+{
+    switch(pControl->GetType())
+    {
+    case CPUT_BUTTON:
+        ((CPUTButton*)pControl)->DrawIntoBuffer(pVertexBuffer, pInsertIndex, CPUT_GUI_BUFFER_SIZE, pTextVertexBuffer, pTextInsertIndex, CPUT_GUI_BUFFER_STRING_SIZE);
+        break;
+    case CPUT_CHECKBOX:
+        ((CPUTCheckbox*)pControl)->DrawIntoBuffer(pVertexBuffer, pInsertIndex, CPUT_GUI_BUFFER_SIZE, pTextVertexBuffer, pTextInsertIndex, CPUT_GUI_BUFFER_STRING_SIZE);
+        break;
+    case CPUT_SLIDER:
+        ((CPUTSlider*)pControl)->DrawIntoBuffer(pVertexBuffer, pInsertIndex, CPUT_GUI_BUFFER_SIZE, pTextVertexBuffer, pTextInsertIndex, CPUT_GUI_BUFFER_STRING_SIZE);
+        break;
+    case CPUT_DROPDOWN:
+        ((CPUTDropdown*)pControl)->DrawIntoBuffer(pVertexBuffer, pInsertIndex, CPUT_GUI_BUFFER_SIZE, pTextVertexBuffer, pTextInsertIndex, CPUT_GUI_BUFFER_STRING_SIZE);
+        break;
+    case CPUT_STATIC:
+        ((CPUTText*)pControl)->DrawIntoBuffer(pTextVertexBuffer, pTextInsertIndex, CPUT_GUI_BUFFER_STRING_SIZE);
+        break;
+    }
+}
+
+//
+//------------------------------------------------------------------------
+CPUTResult CPUTGuiControllerDX11::UpdateUberBuffers(CPUTRenderBackend *pBackend, bool bFocusedControlChanged)
+{
+    ASSERT(pBackend, _L("CPUTGuiControllerDX11::UpdateUberBuffers - Backend pointer is NULL"));
+
+    // Update the ranges of the control graphics and the controls' text that changed
+    mControlArena.Upload(pBackend, mpUberBuffer);
+    mTextArena.Upload(pBackend, mpTextUberBuffer);
+
+    if(bFocusedControlChanged)
+    {
+        // register the focused control's graphics
+        ASSERT(CPUT_GUI_VERTEX_BUFFER_SIZE > mFocusedControlBufferIndex, _L("CPUT GUI: Too many controls for default-sized uber-buffer.  Increase CPUT_GUI_VERTEX_BUFFER_SIZE"));
+        pBackend->UpdateBuffer(mpFocusedControlBuffer, (void*) mpFocusedControlMirrorBuffer, sizeof( CPUTGUIVertex )*(mFocusedControlBufferIndex+1));
+
+        //register the focused control's text
+        ASSERT(CPUT_GUI_BUFFER_STRING_SIZE > mFocusedControlTextBufferIndex, _L("CPUT GUI: Too many strings for default-sized uber-buffer.  Increase CPUT_GUI_BUFFER_STRING_SIZE"));
+        pBackend->UpdateBuffer(mpFocusedControlTextBuffer, (void*) mpFocusedControlTextMirrorBuffer, sizeof( CPUTGUIVertex )*(mFocusedControlTextBufferIndex+1));
+    }
 
     return CPUT_SUCCESS;
 
@@ -593,16 +659,19 @@ CPUTResult CPUTGuiControllerDX11::UpdateUberBuffers(ID3D11DeviceContext *pImmedi
 
 // Set the state for drawing the gui
 //-----------------------------------------------------------------------------
-void CPUTGuiControllerDX11::SetGUIDrawingState(ID3D11DeviceContext *pImmediateContext)
+void CPUTGuiControllerDX11::SetGUIDrawingState(CPUTRenderBackend *pBackend)
 {
     // set the GUI shaders as active
     ID3D11VertexShader *pVertexShader = mpGUIVertexShader->GetNativeVertexShader();
-    pImmediateContext->VSSetShader( pVertexShader, NULL, 0 );
+    pBackend->SetShader( CPUT_SHADER_STAGE_VERTEX, pVertexShader );
     
     //D3D11_VIEWPORT viewport  = { 0.0f, 0.0f, (float)mWidth, (float)mHeight, 0.0f, 1.0f };
     //((CPUTRenderParametersDX*)&renderParams)->mpContext->RSSetViewports( 1, &viewport );
     
 #ifdef SAVE_RESTORE_DS_HS_GS_SHADER_STATE
+    // Reading state back requires the native context, so this only works with the DX11 backend.
+    ASSERT( !pBackend->IsNull(), _L("SAVE_RESTORE_DS_HS_GS_SHADER_STATE requires the DX11 backend") );
+    ID3D11DeviceContext *pImmediateContext = ((CPUTRenderBackendDX11*)pBackend)->GetNativeContext();
     pImmediateContext->GSGetShader(&mpGeometryShaderState, &mpGeometryShaderClassInstances, &mGeometryShaderNumClassInstances);
     pImmediateContext->HSGetShader(&mpHullShaderState, &mpHullShaderClassInstances, &mHullShaderNumClassInstance);
     pImmediateContext->DSGetShader(&mpDomainShaderState, &mpDomainShaderClassIntances, &mDomainShaderNumClassInstances);
@@ -610,17 +679,17 @@ void CPUTGuiControllerDX11::SetGUIDrawingState(ID3D11DeviceContext *pImmediateCo
 
     // set the geometry, hull, and domain shaders to null (in case the user had set them)
     // since the GUI system doesn't need them
-    pImmediateContext->GSSetShader(NULL, NULL, 0);
-    pImmediateContext->HSSetShader(NULL, NULL, 0);
-    pImmediateContext->DSSetShader(NULL, NULL, 0);
+    pBackend->SetShader( CPUT_SHADER_STAGE_GEOMETRY, NULL );
+    pBackend->SetShader( CPUT_SHADER_STAGE_HULL, NULL );
+    pBackend->SetShader( CPUT_SHADER_STAGE_DOMAIN, NULL );
     
     // set topology to triangle list
-    pImmediateContext->IAGetPrimitiveTopology(&mTopology);
-    pImmediateContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    // Note: every CPUT draw path sets its own topology, so there is nothing to save/restore here.
+    pBackend->SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
         
     // Use CPUTRenderStateBlock to set the render state for GUI drawing
     CPUTRenderParametersDX renderParams;
-    renderParams.mpContext = pImmediateContext;
+    renderParams.mpBackend = pBackend;
     mpGUIRenderStateBlock->SetRenderStates(renderParams);
 
     // update the constant buffer matrices
@@ -628,28 +697,26 @@ void CPUTGuiControllerDX11::SetGUIDrawingState(ID3D11DeviceContext *pImmediateCo
     GUIConstantBufferVS cb;
     cb.Model = XMMatrixIdentity();
     cb.Projection = XMMatrixIdentity();
-    pImmediateContext->UpdateSubresource( mpConstantBufferVS, 0, NULL, &cb, 0, 0 );
-    pImmediateContext->VSSetConstantBuffers( 0, 1, &mpConstantBufferVS );
+    SetConstantBufferVS( pBackend, cb );
 
     // set the input layout
-    pImmediateContext->IASetInputLayout( mpVertexLayout );
+    pBackend->SetInputLayout( mpVertexLayout );
 
     // set the pixel shader
-    pImmediateContext->PSSetShader( mpGUIPixelShader->GetNativePixelShader(), NULL, 0 );
+    pBackend->SetShader( CPUT_SHADER_STAGE_PIXEL, mpGUIPixelShader->GetNativePixelShader() );
 
 }
 
 // Restores the previous state
 //-----------------------------------------------------------------------------
-void CPUTGuiControllerDX11::ClearGUIDrawingState(ID3D11DeviceContext *pImmediateContext)
+void CPUTGuiControllerDX11::ClearGUIDrawingState(CPUTRenderBackend *pBackend)
 {
-    // restore drawing topology mode that was in use before entering the gui drawing state
-    pImmediateContext->IASetPrimitiveTopology(mTopology);
-
 #ifdef SAVE_RESTORE_DS_HS_GS_SHADER_STATE
+    ID3D11DeviceContext *pImmediateContext = ((CPUTRenderBackendDX11*)pBackend)->GetNativeContext();
     pImmediateContext->GSSetShader(mpGeometryShaderState, (ID3D11ClassInstance* const*)&mpGeometryShaderClassInstances, mGeometryShaderNumClassInstances);
     pImmediateContext->HSSetShader(mpHullShaderState, (ID3D11ClassInstance* const*)&mpHullShaderClassInstances, mHullShaderNumClassInstance);
     pImmediateContext->DSSetShader(mpDomainShaderState, (ID3D11ClassInstance* const*)&mpDomainShaderClassIntances, mDomainShaderNumClassInstances);
+    pBackend->InvalidateStateCache(); // Restored behind the backend's back
 #endif
 
 }
@@ -797,7 +864,7 @@ CPUTResult CPUTGuiControllerDX11::RegisterGUIResources(ID3D11DeviceContext *pImm
     // initialization data (all 0's for now)
     D3D11_SUBRESOURCE_DATA InitData;
     ZeroMemory( &InitData, sizeof(InitData) );
-    InitData.pSysMem = mpMirrorBuffer;
+    InitData.pSysMem = pZeroedBuffer;
 
     // mpUberBuffer
     SAFE_RELEASE(mpUberBuffer);
@@ -836,6 +903,10 @@ CPUTResult CPUTGuiControllerDX11::RegisterGUIResources(ID3D11DeviceContext *pImm
     SAFE_RELEASE(pD3dDevice);
     SAFE_DELETE_ARRAY(pZeroedBuffer);    
 
+    // the new buffers are empty - place every control again on the next draw
+    mControlRanges.clear();
+    mUberBufferDirty = true;
+
 
     // 8. Register all GUI sub-resources
     // Walk all the controls/fonts and have them register all their required static resources
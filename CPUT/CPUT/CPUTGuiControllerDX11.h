@@ -27,6 +27,8 @@
 #include "CPUTVertexShaderDX11.h"
 #include "CPUTPixelShaderDX11.h"
 #include "CPUTRenderStateBlockDX11.h"
+#include "CPUTRenderBackend.h"
+#include "CPUTGuiVertexArena.h"
 
 //#define SAVE_RESTORE_DS_HS_GS_SHADER_STATE
 
@@ -59,6 +61,16 @@ class CPUTGuiControllerDX11:public CPUTGuiController
         XMMATRIX Model;
     };
 
+    // where a control of the active panel lives in the uber-buffers
+    struct ControlRange
+    {
+        CPUTControl *mpControl;     // only compared, to notice when the control list changes
+        uint32_t     mStart;
+        uint32_t     mCount;
+        uint32_t     mTextStart;
+        uint32_t     mTextCount;
+    };
+
 
 public:
     static CPUTGuiControllerDX11 *GetController();
@@ -78,7 +90,7 @@ public:
     CPUTResult DeleteControl(CPUTControlID controlID);
 
     // draw routines    
-    void Draw(ID3D11DeviceContext *pImmediateContext);
+    void Draw(CPUTRenderBackend *pBackend);
     void DrawFPS(bool drawfps);
     float GetFPS();
 
@@ -92,21 +104,26 @@ private:
     ID3D11Buffer         *mpConstantBufferVS;
     GUIConstantBufferVS   mModelViewMatrices;
 
+    void SetConstantBufferVS(CPUTRenderBackend *pBackend, const GUIConstantBufferVS &constants);
+
     // Texture atlas
     CPUTTextureDX11            *mpControlTextureAtlas;
     ID3D11ShaderResourceView   *mpControlTextureAtlasView;
     ID3D11Buffer               *mpUberBuffer;
-    CPUTGUIVertex              *mpMirrorBuffer;
-    UINT                        mUberBufferIndex;
-    UINT                        mUberBufferMax;
+    CPUTGuiVertexArena          mControlArena;
+    CPUTGUIVertex              *mpControlScratchBuffer;   // one control's graphics, before they're placed in the arena
     
     // Font atlas
     CPUTFontDX11               *mpFont;
     CPUTTextureDX11            *mpTextTextureAtlas;
     ID3D11ShaderResourceView   *mpTextTextureAtlasView;
     ID3D11Buffer               *mpTextUberBuffer;
-    CPUTGUIVertex              *mpTextMirrorBuffer;
-    UINT                        mTextUberBufferIndex;
+    CPUTGuiVertexArena          mTextArena;
+    CPUTGUIVertex              *mpTextScratchBuffer;
+
+    // per-control ranges in the arenas, parallel to the active panel's control list
+    std::vector<ControlRange>   mControlRanges;
+    CPUTControl                *mpRangesFocusControl;      // focused control when the ranges were last updated
 
     // Focused control buffers
     CPUTGUIVertex              *mpFocusedControlMirrorBuffer;
@@ -130,7 +147,10 @@ private:
 
     // render state
     CPUTRenderStateBlockDX11   *mpGUIRenderStateBlock;
-    CPUTResult UpdateUberBuffers(ID3D11DeviceContext *pImmediateContext );
+    bool RebuildDirtyControls();
+    bool PlaceControls(bool bRebuildAll, CPUTControl *pPreviousFocusControl);
+    void DrawControlIntoBuffers(CPUTControl *pControl, CPUTGUIVertex *pVertexBuffer, UINT *pInsertIndex, CPUTGUIVertex *pTextVertexBuffer, UINT *pTextInsertIndex);
+    CPUTResult UpdateUberBuffers(CPUTRenderBackend *pBackend, bool bFocusedControlChanged);
 
 #ifdef SAVE_RESTORE_DS_HS_GS_SHADER_STATE
     ID3D11GeometryShader   *mpGeometryShaderState;
@@ -146,16 +166,12 @@ private:
     UINT                    mDomainShaderNumClassInstances;
 #endif
 
-
-    // members for saving render state before/after drawing gui
-    D3D11_PRIMITIVE_TOPOLOGY    mTopology;
-
     // helper functions
     CPUTGuiControllerDX11();    // singleton
     ~CPUTGuiControllerDX11();
     CPUTResult RegisterGUIResources(ID3D11DeviceContext *pImmediateContext, cString VertexShaderFilename, cString RenderStateFile, cString PixelShaderFilename, cString DefaultFontFilename, cString ControlTextureAtlas);
-    void SetGUIDrawingState(ID3D11DeviceContext *pImmediateContext);
-    void ClearGUIDrawingState(ID3D11DeviceContext *pImmediateContext);
+    void SetGUIDrawingState(CPUTRenderBackend *pBackend);
+    void ClearGUIDrawingState(CPUTRenderBackend *pBackend);
 };
 
 
@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTGuiVertexArena.h"
+#include <algorithm>
+
+// Dirty ranges closer than this (in vertices) are uploaded together
+const uint32_t CPUT_GUI_ARENA_MERGE_GAP = 48;
+
+//-----------------------------------------------------------------------------
+CPUTGuiVertexArena::CPUTGuiVertexArena( uint32_t capacity ) :
+    mHead(0),
+    mWasted(0)
+{
+    CPUTGUIVertex zero;
+    zero.Pos = float3( 0.0f, 0.0f, 0.0f );
+    zero.UV  = float2( 0.0f, 0.0f );
+    mVertices.resize( capacity, zero );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTGuiVertexArena::Write( uint32_t start, uint32_t rangeSize, const CPUTGUIVertex *pVertices, uint32_t count )
+{
+    if( 0 == rangeSize )
+    {
+        return;
+    }
+    std::copy( pVertices, pVertices + count, mVertices.begin() + start );
+
+    // Repeat one point for the rest of the range: zero-area triangles draw nothing
+    CPUTGUIVertex degenerate;
+    degenerate.Pos = float3( 0.0f, 0.0f, 0.0f );
+    degenerate.UV  = float2( 0.0f, 0.0f );
+    std::fill( mVertices.begin() + start + count, mVertices.begin() + start + rangeSize, degenerate );
+
+    Range range = { start, rangeSize };
+    mDirty.push_back( range );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTGuiVertexArena::Place( uint32_t *pStart, uint32_t *pRangeSize, const CPUTGUIVertex *pVertices, uint32_t count )
+{
+    if( count > *pRangeSize )
+    {
+        // Abandon the old range and take a new one with room to grow by half (in whole quads)
+        if( *pRangeSize )
+        {
+            Write( *pStart, *pRangeSize, NULL, 0 );
+            mWasted += *pRangeSize;
+            *pRangeSize = 0;
+        }
+        uint32_t available = GetCapacity() - mHead;
+        uint32_t size      = (count + count / 2 + 5) / 6 * 6;
+        if( size > available )
+        {
+            size = count;
+        }
+        if( size > available )
+        {
+            return false;
+        }
+        *pStart     = mHead;
+        *pRangeSize = size;
+        mHead      += size;
+    }
+    Write( *pStart, *pRangeSize, pVertices, count );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTGuiVertexArena::Upload( CPUTRenderBackend *pBackend, CPUTBackendHandle buffer )
+{
+    if( mDirty.empty() )
+    {
+        return 0;
+    }
+    std::sort( mDirty.begin(), mDirty.end() );
+
+    uint32_t bytes = 0;
+    uint32_t ii    = 0;
+    while( ii < mDirty.size() )
+    {
+        uint32_t start = mDirty[ii].mStart;
+        uint32_t end   = start + mDirty[ii].mCount;
+        for( ++ii; ii < mDirty.size() && mDirty[ii].mStart <= end + CPUT_GUI_ARENA_MERGE_GAP; ++ii )
+        {
+            end = std::max( end, mDirty[ii].mStart + mDirty[ii].mCount );
+        }
+        uint32_t size = (end - start) * sizeof(CPUTGUIVertex);
+        pBackend->UpdateBufferRange( buffer, start * sizeof(CPUTGUIVertex), &mVertices[start], size );
+        bytes += size;
+    }
+    mDirty.clear();
+    return bytes;
+}
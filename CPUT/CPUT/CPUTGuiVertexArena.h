@@ -0,0 +1,68 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTGUIVERTEXARENA_H__
+#define __CPUTGUIVERTEXARENA_H__
+
+// CPU mirror of a GUI vertex buffer in which each control owns a fixed range.
+// Place() rewrites one control's range (padding it with degenerate triangles, so the
+// whole arena can still be drawn with a single Draw()), and Upload() sends only the
+// ranges written since the last upload.  A control that outgrows its range gets a new
+// one, with headroom, at the end of the arena; the old range is left degenerate until
+// the next Reset().
+#include "CPUTGuiController.h"
+#include "CPUTRenderBackend.h"
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+class CPUTGuiVertexArena
+{
+protected:
+    struct Range
+    {
+        uint32_t mStart;
+        uint32_t mCount;
+        bool operator<( const Range &other ) const { return mStart < other.mStart; }
+    };
+
+    std::vector<CPUTGUIVertex>  mVertices;
+    uint32_t                    mHead;      // Vertices handed out.  Everything past it is free.
+    uint32_t                    mWasted;    // Vertices in ranges abandoned by Place()
+    std::vector<Range>          mDirty;     // Written since the last Upload()
+
+    void Write( uint32_t start, uint32_t rangeSize, const CPUTGUIVertex *pVertices, uint32_t count );
+
+public:
+    CPUTGuiVertexArena( uint32_t capacity );
+
+    // Frees every range.  Callers must Place() all their controls again.
+    void     Reset() { mHead = mWasted = 0; mDirty.clear(); }
+
+    // Writes count vertices to the range [*pStart, *pStart + *pRangeSize), moving the range
+    // if they don't fit.  Pass *pRangeSize == 0 for a control that has no range yet.
+    // Returns false, leaving the range empty, if the arena is full: Reset() and place everything again.
+    bool     Place( uint32_t *pStart, uint32_t *pRangeSize, const CPUTGUIVertex *pVertices, uint32_t count );
+
+    // Copies the ranges written since the last call into buffer.  Returns the bytes uploaded.
+    uint32_t Upload( CPUTRenderBackend *pBackend, CPUTBackendHandle buffer );
+
+    uint32_t             GetVertexCount() const { return mHead; }   // Draw this many vertices
+    uint32_t             GetCapacity() const    { return (uint32_t)mVertices.size(); }
+    uint32_t             GetWasted() const      { return mWasted; }
+    const CPUTGUIVertex *GetVertices() const    { return &mVertices[0]; }
+};
+
+#endif // __CPUTGUIVERTEXARENA_H__
@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTHASH_H__
+#define __CPUTHASH_H__
+
+// 64-bit FNV-1a hashing, and a flat (open addressing) map keyed by such hashes.
+//
+// The map stores entries in one array with linear probing and grows at half load, so
+// lookups touch one or two cache lines.  Keys are full 64-bit hashes; two different
+// objects hashing to the same key are treated as equal.  There is no erase.
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+const uint64_t CPUT_HASH_SEED = 0xCBF29CE484222325ull;
+
+//-----------------------------------------------------------------------------
+inline uint64_t CPUTHashBytes( const void *pData, size_t size, uint64_t hash = CPUT_HASH_SEED )
+{
+    const uint8_t *pBytes = (const uint8_t*)pData;
+    for( size_t ii=0; ii<size; ii++ )
+    {
+        hash = (hash ^ pBytes[ii]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Includes the terminator, so "ab"+"c" and "a"+"bc" differ.  NULL hashes like "".
+//-----------------------------------------------------------------------------
+inline uint64_t CPUTHashString( const char *pString, uint64_t hash = CPUT_HASH_SEED )
+{
+    return pString ? CPUTHashBytes( pString, strlen(pString) + 1, hash ) : CPUTHashBytes( "", 1, hash );
+}
+
+//-----------------------------------------------------------------------------
+template<class T> class CPUTFlatHashMap
+{
+protected:
+    struct Entry
+    {
+        uint64_t mKey;
+        T        mValue;
+        bool     mUsed;
+        Entry() : mKey(0), mValue(), mUsed(false) {}
+    };
+    std::vector<Entry> mEntries; // Size is 0 or a power of two
+    uint32_t           mCount;
+
+    uint32_t Slot( uint64_t key ) const
+    {
+        // The low bits of FNV are weak; fold the high half in
+        uint32_t mask = (uint32_t)mEntries.size() - 1;
+        uint32_t slot = (uint32_t)(key ^ (key >> 32)) & mask;
+        while( mEntries[slot].mUsed && mEntries[slot].mKey != key )
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void Grow()
+    {
+        std::vector<Entry> old;
+        old.swap( mEntries );
+        mEntries.resize( old.empty() ? 16 : old.size() * 2 );
+        for( size_t ii=0; ii<old.size(); ii++ )
+        {
+            if( old[ii].mUsed )
+            {
+                mEntries[Slot( old[ii].mKey )] = old[ii];
+            }
+        }
+    }
+
+public:
+    CPUTFlatHashMap() : mCount(0) {}
+
+    T *Find( uint64_t key )
+    {
+        if( !mCount )
+        {
+            return 0;
+        }
+        Entry &entry = mEntries[Slot( key )];
+        return entry.mUsed ? &entry.mValue : 0;
+    }
+
+    // Replaces the value if the key exists
+    T &Insert( uint64_t key, const T &value )
+    {
+        if( 2 * (mCount + 1) > mEntries.size() )
+        {
+            Grow();
+        }
+        Entry &entry = mEntries[Slot( key )];
+        if( !entry.mUsed )
+        {
+            entry.mUsed = true;
+            entry.mKey  = key;
+            mCount++;
+        }
+        entry.mValue = value;
+        return entry.mValue;
+    }
+
+    void     Clear()          { mEntries.clear(); mCount = 0; }
+    uint32_t GetCount() const { return mCount; }
+
+    // For iterating over every value: slots 0..GetCapacity()-1 where IsUsed()
+    uint32_t GetCapacity() const       { return (uint32_t)mEntries.size(); }
+    bool     IsUsed( uint32_t slot ) const { return mEntries[slot].mUsed; }
+    T       &GetValue( uint32_t slot ) { return mEntries[slot].mValue; }
+};
+
+#endif // __CPUTHASH_H__
@@ -16,21 +16,20 @@
 #include "CPUTInputLayoutCacheDX11.h"
 #include "CPUTVertexShaderDX11.h"
 
-extern const cString *gpDXGIFormatNames;
-
 CPUTInputLayoutCacheDX11* CPUTInputLayoutCacheDX11::mpInputLayoutCache = NULL;
 
 //-----------------------------------------------------------------------------
 void CPUTInputLayoutCacheDX11::ClearLayoutCache()
 {
 	// iterate over the entire map - and release each layout object
-    std::map<cString, ID3D11InputLayout*>::iterator mapIterator;
-
-    for(mapIterator = mLayoutList.begin(); mapIterator != mLayoutList.end(); mapIterator++)
+    for( uint32_t ii=0; ii<mLayoutList.GetCapacity(); ii++ )
     {
-        mapIterator->second->Release();  // release the ID3D11InputLayout*
+        if( mLayoutList.IsUsed(ii) )
+        {
+            mLayoutList.GetValue(ii)->Release();  // release the ID3D11InputLayout*
+        }
     }
-    mLayoutList.clear();
+    mLayoutList.Clear();
 }
 
 // singleton retriever
@@ -61,20 +60,19 @@ CPUTResult CPUTInputLayoutCacheDX11::DeleteInputLayoutCache()
 CPUTResult CPUTInputLayoutCacheDX11::GetLayout(
     ID3D11Device *pDevice,
     D3D11_INPUT_ELEMENT_DESC *pDXLayout,
+    uint64_t layoutHash,
     CPUTVertexShaderDX11 *pVertexShader,
     ID3D11InputLayout **ppInputLayout
 ){
-    // Generate the vertex layout pattern portion of the key
-    cString layoutKey = GenerateLayoutKey(pDXLayout);
-
-    // Append the vertex shader pointer to the key for layout<->vertex shader relationship
-    cString address = ptoc(pVertexShader);
-    layoutKey += address;
+    // The layout only has to match the shader's input signature
+    uint64_t signatureHash = pVertexShader->GetInputSignatureHash();
+    uint64_t layoutKey     = CPUTHashBytes( &signatureHash, sizeof(signatureHash), layoutHash );
 
     // Do we already have one like this?
-    if( mLayoutList[layoutKey] )
+    ID3D11InputLayout **ppExisting = mLayoutList.Find( layoutKey );
+    if( ppExisting )
     {
-        *ppInputLayout = mLayoutList[layoutKey];
+        *ppInputLayout = *ppExisting;
 		(*ppInputLayout)->AddRef();
         return CPUT_SUCCESS;
     }
@@ -91,10 +89,15 @@ CPUTResult CPUTInputLayoutCacheDX11::GetLayout(
     ID3DBlob *pBlob = pVertexShader->GetBlob();
     hr = pDevice->CreateInputLayout( pDXLayout, numInputLayoutElements, pBlob->GetBufferPointer(), pBlob->GetBufferSize(), ppInputLayout );
     ASSERT( SUCCEEDED(hr), _L("Error creating input layout.") );
+    if( FAILED(hr) )
+    {
+        *ppInputLayout = NULL;
+        return CPUT_ERROR_VERTEX_LAYOUT_PROBLEM;
+    }
 	CPUTSetDebugName( *ppInputLayout, _L("CPUTInputLayoutCacheDX11::GetLayout()") );
 
     // Store this layout object in our map
-    mLayoutList[layoutKey] = *ppInputLayout;
+    mLayoutList.Insert( layoutKey, *ppInputLayout );
 
     // Addref for storing it in our map as well as returning it (count should be = 2 at this point)
     (*ppInputLayout)->AddRef();
@@ -102,28 +105,16 @@ CPUTResult CPUTInputLayoutCacheDX11::GetLayout(
     return CPUT_SUCCESS;
 }
 
-// Generate a string version of the vertex-buffer's layout.  Allows us to search, compare, etc...
 //-----------------------------------------------------------------------------
-cString CPUTInputLayoutCacheDX11::GenerateLayoutKey(D3D11_INPUT_ELEMENT_DESC *pDXLayout)
+uint64_t CPUTInputLayoutCacheDX11::HashLayout(const D3D11_INPUT_ELEMENT_DESC *pDXLayout)
 {
-    // TODO:  Duh!  We can simply memcmp the DX layouts == use the layout input description directly as the key.
-    //        We just need to know how many elements, or NULL terminate it.
-    //        Uses less memory, faster, etc...
-    //        Duh!
-
-    if( !pDXLayout[0].SemanticName )
-    {
-        return _L("");
-    }
-    // TODO: Use shorter names, etc...
-    ASSERT( (pDXLayout[0].Format>=0) && (pDXLayout[0].Format<=DXGI_FORMAT_BC7_UNORM_SRGB), _L("Invalid DXGI Format.") );
-    // Start first layout entry and no comma.
-    cString layoutKey = s2ws(pDXLayout[0].SemanticName) + _L(":") + gpDXGIFormatNames[pDXLayout[0].Format];
-    for( int index=1; NULL != pDXLayout[index].SemanticName; index++ )
+    uint64_t hash = CPUT_HASH_SEED;
+    for( int index=0; NULL != pDXLayout[index].SemanticName; index++ )
     {
-        ASSERT( (pDXLayout[index].Format>=0) && (pDXLayout[index].Format<=DXGI_FORMAT_BC7_UNORM_SRGB), _L("Invalid DXGI Format.") );
-        // Add a comma and the next layout entry
-        layoutKey = layoutKey + _L(",") + s2ws(pDXLayout[index].SemanticName) + _L(":") + gpDXGIFormatNames[pDXLayout[index].Format];
+        const D3D11_INPUT_ELEMENT_DESC &element = pDXLayout[index];
+        UINT fields[6] = { element.SemanticIndex, element.Format, element.InputSlot, element.AlignedByteOffset, element.InputSlotClass, element.InstanceDataStepRate };
+        hash = CPUTHashString( element.SemanticName, hash );
+        hash = CPUTHashBytes( fields, sizeof(fields), hash );
     }
-    return layoutKey;
+    return hash;
 }
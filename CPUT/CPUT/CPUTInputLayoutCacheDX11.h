@@ -19,9 +19,12 @@
 #include "CPUTInputLayoutCache.h"
 #include "CPUTOSServicesWin.h"
 #include "CPUTVertexShaderDX11.h"
+#include "CPUTHash.h"
 #include <D3D11.h> // D3D11_INPUT_ELEMENT_DESC
-#include <map>
 
+// Layouts are keyed by a hash of the element descriptions and of the vertex shader's
+// input signature, so shaders with the same inputs share a layout.  Meshes keep the
+// layouts they get, so the cache is only used at load time.
 class CPUTInputLayoutCacheDX11:public CPUTInputLayoutCache
 {
 public:
@@ -31,20 +34,27 @@ public:
     }
     static CPUTInputLayoutCacheDX11 *GetInputLayoutCache();
     static CPUTResult DeleteInputLayoutCache();
-    CPUTResult GetLayout(ID3D11Device *pDevice, D3D11_INPUT_ELEMENT_DESC *pDXLayout, CPUTVertexShaderDX11 *pVertexShader, ID3D11InputLayout **ppInputLayout);
+
+    // Hash of every field of a NULL-terminated element array.  Callers that look up the
+    // same array repeatedly can hash it once and use the second GetLayout().
+    static uint64_t HashLayout(const D3D11_INPUT_ELEMENT_DESC *pDXLayout);
+
+    CPUTResult GetLayout(ID3D11Device *pDevice, D3D11_INPUT_ELEMENT_DESC *pDXLayout, CPUTVertexShaderDX11 *pVertexShader, ID3D11InputLayout **ppInputLayout)
+    {
+        return GetLayout(pDevice, pDXLayout, HashLayout(pDXLayout), pVertexShader, ppInputLayout);
+    }
+    CPUTResult GetLayout(ID3D11Device *pDevice, D3D11_INPUT_ELEMENT_DESC *pDXLayout, uint64_t layoutHash, CPUTVertexShaderDX11 *pVertexShader, ID3D11InputLayout **ppInputLayout);
 	void ClearLayoutCache();
+    uint32_t GetLayoutCount() const { return mLayoutList.GetCount(); }
 
 private:
     // singleton
-    CPUTInputLayoutCacheDX11() { mLayoutList.clear(); }
-
-    // convert the D3D11_INPUT_ELEMENT_DESC to string key
-    cString GenerateLayoutKey(D3D11_INPUT_ELEMENT_DESC *pDXLayout);
+    CPUTInputLayoutCacheDX11() {}
 
     CPUTResult VerifyLayoutCompatibility(D3D11_INPUT_ELEMENT_DESC *pDXLayout, ID3DBlob *pVertexShaderBlob);
 
     static CPUTInputLayoutCacheDX11 *mpInputLayoutCache;
-    std::map<cString, ID3D11InputLayout*> mLayoutList;
+    CPUTFlatHashMap<ID3D11InputLayout*> mLayoutList;
 };
 
 #endif //#define __CPUTINPUTLAYOUTCACHERDX11_H__
\ No newline at end of file
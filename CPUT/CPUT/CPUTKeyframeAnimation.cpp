@@ -169,7 +169,7 @@ void CPUTKeyframeAnimation::GetKeyframeAnimationTransform(const int frame, CPUTM
 //-----------------------------------------------------------------------------
 void CPUTKeyframeAnimation::GetKeyframeAnimationTransform(double fTime, CPUTMatrix* pMatrix, unsigned int animationChannel )
 {
-    if( animationChannel >= m_KeyframeAnimations[animationChannel].size() || !pMatrix )//out of bounds protection
+    if( animationChannel >= m_KeyframeAnimations.size() || !pMatrix )//out of bounds protection
     {
         // todo: potentially return identity matrix?
         return;
@@ -278,7 +278,7 @@ void CPUTKeyframeAnimation::SLERP(	const float &timeBottom,
 	float norm = 0.0f;
     if ( timeTop - timeBottom )
     {
-		parameter =  timeInTheMiddle - timeBottom / (timeTop - timeBottom);
+		parameter = ( timeInTheMiddle - timeBottom ) / ( timeTop - timeBottom );
      ////////The following came from http://stackoverflow.com/questions/4099369/interpolate-between-rotation-matrices/4099423#4099423
 		float cosHalfTheta = bottomTransform[3] * topTransform[3] + bottomTransform[0] * topTransform[0] + bottomTransform[1] * topTransform[1] + bottomTransform[2] * topTransform[2];
 		// if qa=qb or qa=-qb then theta = 0 and we can return qa
@@ -0,0 +1,69 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTLateLatch.h"
+#include <algorithm>
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+void CPUTLatencyStats::AddSample( double seconds )
+{
+    mSeconds[mNext] = seconds;
+    mNext = (mNext + 1) % CPUT_LATENCY_WINDOW;
+    mCount = mCount < CPUT_LATENCY_WINDOW ? mCount + 1 : CPUT_LATENCY_WINDOW;
+}
+
+//-----------------------------------------------------------------------------
+double CPUTLatencyStats::GetLast() const
+{
+    return mCount ? mSeconds[(mNext + CPUT_LATENCY_WINDOW - 1) % CPUT_LATENCY_WINDOW] : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+double CPUTLatencyStats::GetAverage() const
+{
+    double sum = 0.0;
+    for( uint32_t ii=0; ii<mCount; ii++ )
+    {
+        sum += mSeconds[ii];
+    }
+    return mCount ? sum / mCount : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+double CPUTLatencyStats::GetMax() const
+{
+    double maximum = 0.0;
+    for( uint32_t ii=0; ii<mCount; ii++ )
+    {
+        maximum = mSeconds[ii] > maximum ? mSeconds[ii] : maximum;
+    }
+    return maximum;
+}
+
+//-----------------------------------------------------------------------------
+double CPUTLatencyStats::GetPercentile( double percent ) const
+{
+    if( 0 == mCount )
+    {
+        return 0.0;
+    }
+    double sorted[CPUT_LATENCY_WINDOW];
+    std::copy( mSeconds, mSeconds + mCount, sorted );
+    std::sort( sorted, sorted + mCount );
+    double   rank  = ceil( percent / 100.0 * mCount );
+    uint32_t index = rank < 1.0 ? 0 : (uint32_t)rank - 1;
+    return sorted[index < mCount ? index : mCount - 1];
+}
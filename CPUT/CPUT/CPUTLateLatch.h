@@ -0,0 +1,65 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTLATELATCH_H__
+#define __CPUTLATELATCH_H__
+
+// Late latching of input.  A frame is culled and queued with the input read in Update(),
+// but its per-model constants and instance data are only written when the render queue
+// builds its draws.  A CPUTLateLatch set in CPUTRenderParameters::mpLateLatch is called
+// by CPUTRenderQueue::Submit() just before that, so it can read the newest input and
+// move whatever depends on it (a world matrix, a camera).  Only the constants see the
+// move: culling and sorting keep the Update() input.
+#include <stdint.h>
+
+class CPUTRenderParameters;
+
+//-----------------------------------------------------------------------------
+class CPUTLateLatch
+{
+public:
+    virtual ~CPUTLateLatch() {}
+
+    // Called once per Submit() that has this latch, after sorting and before any constant is written
+    virtual void Latch( CPUTRenderParameters &renderParams ) = 0;
+};
+
+// Latency of the last CPUT_LATENCY_WINDOW samples, e.g. from an input's timestamp to the
+// Submit() that used it
+//-----------------------------------------------------------------------------
+const uint32_t CPUT_LATENCY_WINDOW = 128;
+
+class CPUTLatencyStats
+{
+protected:
+    double   mSeconds[CPUT_LATENCY_WINDOW];
+    uint32_t mCount;
+    uint32_t mNext;
+
+public:
+    CPUTLatencyStats() { Reset(); }
+
+    void     Reset() { mCount = 0; mNext = 0; }
+    void     AddSample( double seconds );
+    uint32_t GetCount() const { return mCount; }
+
+    // Over the window.  0 without samples.
+    double   GetLast() const;
+    double   GetAverage() const;
+    double   GetMax() const;
+    double   GetPercentile( double percent ) const;   // Nearest rank
+};
+
+#endif // __CPUTLATELATCH_H__
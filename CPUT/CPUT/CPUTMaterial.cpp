@@ -38,10 +38,21 @@ CPUTMaterial *CPUTMaterial::CreateMaterial( const cString &absolutePathAndFilena
     CPUTResult result = pMaterial->LoadMaterial(absolutePathAndFilename, modelSuffix, meshSuffix);
     ASSERT( CPUTSUCCESS(result), _L("\nError - CPUTAssetLibrary::GetMaterial() - Error in material file: '")+absolutePathAndFilename+_L("'") );
 
+    // If another file already gave us an identical material, use that one under this name too
+    CPUTAssetLibrary *pAssetLibrary = CPUTAssetLibrary::GetAssetLibrary();
+    CPUTMaterial *pIdentical = pAssetLibrary->FindIdenticalMaterial( pMaterial );
+
     // add material to material library list
     // cString finalName = pMaterial->MaterialRequiresPerModelPayload() ? absolutePathAndFilename +  modelSuffix + meshSuffix : absolutePathAndFilename;
     // CPUTAssetLibrary::GetAssetLibrary()->AddMaterial( finalName, pMaterial );
-    CPUTAssetLibrary::GetAssetLibrary()->AddMaterial( absolutePathAndFilename, pMaterial );
+    if( pIdentical )
+    {
+        pAssetLibrary->AddMaterial( absolutePathAndFilename, pIdentical );
+        pIdentical->AddRef();
+        pMaterial->Release();
+        return pIdentical;
+    }
+    pAssetLibrary->AddMaterial( absolutePathAndFilename, pMaterial );
 
     return pMaterial;
 }
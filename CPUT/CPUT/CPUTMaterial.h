@@ -17,6 +17,7 @@
 #define __CPUTMATERIAL_H__
 
 #include <stdio.h>
+#include <vector>
 #include "CPUT.h"
 #include "CPUTRefCount.h"
 #include "CPUTConfigBlock.h"
@@ -51,6 +52,11 @@ protected:
     CPUTBuffer           *mpUAV[CPUT_MATERIAL_MAX_UAV_SLOTS];
     CPUTBuffer           *mpConstantBuffer[CPUT_MATERIAL_MAX_CONSTANT_BUFFER_SLOTS];
 
+    // Render queue sort key fields (see CPUTRenderQueue).  Set when the material is loaded.
+    UINT                  mShaderSortId;
+    UINT                  mStateSortId;
+    UINT                  mMaterialSortId;
+
     // Destructor is not public.  Must release instead of delete.
     virtual ~CPUTMaterial(){
 		// The following are allocated in the derived class.  So, release there too.
@@ -66,7 +72,10 @@ public:
 
     CPUTMaterial() :
 		mpRenderStateBlock(NULL),
-		mBufferCount(0)
+		mBufferCount(0),
+		mShaderSortId(0),
+		mStateSortId(0),
+		mMaterialSortId(0)
 	{
         for( UINT ii=0; ii<CPUT_MATERIAL_MAX_TEXTURE_SLOTS; ii++ )         { mpTexture[ii]       = NULL; }
         for( UINT ii=0; ii<CPUT_MATERIAL_MAX_BUFFER_SLOTS; ii++ )          { mpBuffer[ii]        = NULL; }
@@ -79,9 +88,26 @@ public:
     virtual CPUTResult    LoadMaterial(const cString &fileName, const cString &modelSuffix, const cString &meshSuffix) = 0;
     virtual void          ReleaseTexturesAndBuffers() = 0;
     virtual void          RebindTexturesAndBuffers() = 0;
+    // Rebinds only the texture slots that hold one of textures (sorted by address)
+    virtual void          RebindTextures(const std::vector<CPUTTexture*> &textures) { RebindTexturesAndBuffers(); }
     virtual void          SetRenderStates(CPUTRenderParameters &renderParams) { if( mpRenderStateBlock ) { mpRenderStateBlock->SetRenderStates(renderParams); } }
     virtual bool          MaterialRequiresPerModelPayload() = 0;
+
+    // Materials with an instanced vertex shader (InstancedVertexShaderMain) can be drawn instanced.
+    // SetInstancing() switches between the two vertex shaders, after SetRenderStates().
+    virtual bool          SupportsInstancing() { return false; }
+    virtual void          SetInstancing(CPUTRenderParameters &renderParams, bool instanced) {}
+    CPUTTexture          *GetTexture( UINT slot ) const { return mpTexture[slot]; } // NULL if the slot is empty
+    UINT                  GetShaderSortId() const   { return mShaderSortId; }
+    UINT                  GetStateSortId() const    { return mStateSortId; }
+    UINT                  GetMaterialSortId() const { return mMaterialSortId; }
     virtual CPUTMaterial *CloneMaterial( const cString &absolutePathAndFilename, const cString &modelSuffix, const cString &meshSuffix ) = 0;
+
+    // What the material binds (shaders, render state, resources and their slots), such that
+    // materials with equal keys draw identically.  The asset library shares such materials
+    // (see CPUTAssetLibrary::FindIdenticalMaterial()).  An empty key means don't share.
+    virtual void          GetContentKey( std::vector<const void*> *pKey ) { pKey->clear(); }
+    virtual size_t        GetMemoryUsage() { return sizeof(*this); }
 };
 
 #endif //#ifndef __CPUTMATERIAL_H__
@@ -25,6 +25,8 @@
 #include "CPUTGeometryShaderDX11.h"
 #include "CPUTDomainShaderDX11.h"
 #include "CPUTHullShaderDX11.h"
+#include "CPUTRenderQueue.h"
+#include <algorithm>
 
 CPUTConfigBlock CPUTMaterial::mGlobalProperties;
 
@@ -34,6 +36,7 @@ CPUTMaterialDX11::CPUTMaterialDX11() :
     mpPixelShader(NULL),
     mpComputeShader(NULL),
     mpVertexShader(NULL),
+    mpInstancedVertexShader(NULL),
     mpGeometryShader(NULL),
     mpHullShader(NULL),
     mpDomainShader(NULL)
@@ -61,6 +64,7 @@ CPUTMaterialDX11::~CPUTMaterialDX11()
     SAFE_RELEASE(mpPixelShader);
     SAFE_RELEASE(mpComputeShader);
     SAFE_RELEASE(mpVertexShader);
+    SAFE_RELEASE(mpInstancedVertexShader);
     SAFE_RELEASE(mpGeometryShader);
     SAFE_RELEASE(mpHullShader);
     SAFE_RELEASE(mpDomainShader);
@@ -70,68 +74,66 @@ CPUTMaterialDX11::~CPUTMaterialDX11()
 }
 
 //-----------------------------------------------------------------------------
-static ID3D11ShaderResourceView  *gpNullViews[CPUT_MATERIAL_MAX_TEXTURE_SLOTS] = {0};
-static ID3D11UnorderedAccessView *gpNullUAVs[CPUT_MATERIAL_MAX_TEXTURE_SLOTS] = {0};
+static CPUTBackendHandle gpNullUAVs[CPUT_MATERIAL_MAX_UAV_SLOTS] = {0};
 void CPUTMaterialDX11::SetRenderStates(CPUTRenderParameters &renderParams)
 {
-    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
-    pContext->VSSetShader( mpVertexShader   ? mpVertexShader->GetNativeVertexShader()    : NULL, NULL, 0 );
-    pContext->PSSetShader( mpPixelShader    ? mpPixelShader->GetNativePixelShader()      : NULL, NULL, 0 );
-    pContext->CSSetShader( mpComputeShader  ? mpComputeShader->GetNativeComputeShader()  : NULL, NULL, 0 );
-    pContext->GSSetShader( mpGeometryShader ? mpGeometryShader->GetNativeGeometryShader(): NULL, NULL, 0 );
-    pContext->HSSetShader( mpHullShader     ? mpHullShader->GetNativeHullShader()        : NULL, NULL, 0 );
-    pContext->DSSetShader( mpDomainShader   ? mpDomainShader->GetNativeDomainShader()    : NULL, NULL, 0 );
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
+    pBackend->SetShader( CPUT_SHADER_STAGE_VERTEX,   mpVertexShader   ? mpVertexShader->GetNativeVertexShader()    : NULL );
+    pBackend->SetShader( CPUT_SHADER_STAGE_PIXEL,    mpPixelShader    ? mpPixelShader->GetNativePixelShader()      : NULL );
+    pBackend->SetShader( CPUT_SHADER_STAGE_COMPUTE,  mpComputeShader  ? mpComputeShader->GetNativeComputeShader()  : NULL );
+    pBackend->SetShader( CPUT_SHADER_STAGE_GEOMETRY, mpGeometryShader ? mpGeometryShader->GetNativeGeometryShader(): NULL );
+    pBackend->SetShader( CPUT_SHADER_STAGE_HULL,     mpHullShader     ? mpHullShader->GetNativeHullShader()        : NULL );
+    pBackend->SetShader( CPUT_SHADER_STAGE_DOMAIN,   mpDomainShader   ? mpDomainShader->GetNativeDomainShader()    : NULL );
     // TODO: set other shaders (HULL, Domain, etc.)
 
-    // Set the per-material resources (i.e., leave setting the per-model resources to others)
-    pContext->PSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, gpNullViews );
-    pContext->CSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, gpNullViews );
-    pContext->VSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, gpNullViews );
-    pContext->GSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, gpNullViews );
-    pContext->HSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, gpNullViews );
-    pContext->DSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, gpNullViews );
-
 	// TODO: DX11 supports more UAV slots than <DX11.  TODO: make runtime value, based on device creation type.
-    pContext->CSSetUnorderedAccessViews(0, CPUT_MATERIAL_MAX_UAV_SLOTS, gpNullUAVs, NULL);
-	
-    pContext->PSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, mPixelShaderParameters.   mppBindViews );
-    pContext->CSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, mComputeShaderParameters. mppBindViews );
-    pContext->VSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, mVertexShaderParameters.  mppBindViews );
-    pContext->GSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, mGeometryShaderParameters.mppBindViews );
-    pContext->HSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, mHullShaderParameters.    mppBindViews );
-    pContext->DSSetShaderResources( 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, mDomainShaderParameters.  mppBindViews );
+    // Unbind the previous material's UAVs before binding views (the same resource may be read here).
+    if( !mComputeShaderParameters.mUAVCount )
+    {
+        pBackend->SetComputeUnorderedAccessViews( 0, CPUT_MATERIAL_MAX_UAV_SLOTS, gpNullUAVs );
+    }
+
+    // Set the per-material resources (i.e., leave setting the per-model resources to others).
+    // The bind arrays are NULL past the material's last view, so binding all slots also
+    // unbinds the previous material's views.  The backend drops the slots that don't change.
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL,    0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, (CPUTBackendHandle*)mPixelShaderParameters.   mppBindViews );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_COMPUTE,  0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, (CPUTBackendHandle*)mComputeShaderParameters. mppBindViews );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_VERTEX,   0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, (CPUTBackendHandle*)mVertexShaderParameters.  mppBindViews );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_GEOMETRY, 0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, (CPUTBackendHandle*)mGeometryShaderParameters.mppBindViews );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_HULL,     0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, (CPUTBackendHandle*)mHullShaderParameters.    mppBindViews );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_DOMAIN,   0, CPUT_MATERIAL_MAX_TEXTURE_SLOTS, (CPUTBackendHandle*)mDomainShaderParameters.  mppBindViews );
 
     // TODO: Store initial bindpoint so we don't always start at 0 ?
     if( mPixelShaderParameters.mConstantBufferCount )
     {
-        pContext->PSSetConstantBuffers(0, mPixelShaderParameters.mConstantBufferCount,    mPixelShaderParameters.mppBindConstantBuffers );
+        pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_PIXEL,    0, mPixelShaderParameters.mConstantBufferCount,    (CPUTBackendHandle*)mPixelShaderParameters.mppBindConstantBuffers );
     }
     if( mComputeShaderParameters.mConstantBufferCount )
     {
-        pContext->CSSetConstantBuffers(0, mComputeShaderParameters.mConstantBufferCount,  mComputeShaderParameters.mppBindConstantBuffers );
+        pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_COMPUTE,  0, mComputeShaderParameters.mConstantBufferCount,  (CPUTBackendHandle*)mComputeShaderParameters.mppBindConstantBuffers );
     }
     if( mVertexShaderParameters.mConstantBufferCount )
     {
-        pContext->VSSetConstantBuffers(0, mVertexShaderParameters.mConstantBufferCount,   mVertexShaderParameters.mppBindConstantBuffers );
+        pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_VERTEX,   0, mVertexShaderParameters.mConstantBufferCount,   (CPUTBackendHandle*)mVertexShaderParameters.mppBindConstantBuffers );
     }
     if( mGeometryShaderParameters.mConstantBufferCount )
     {
-        pContext->GSSetConstantBuffers(0, mGeometryShaderParameters.mConstantBufferCount, mGeometryShaderParameters.mppBindConstantBuffers );
+        pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_GEOMETRY, 0, mGeometryShaderParameters.mConstantBufferCount, (CPUTBackendHandle*)mGeometryShaderParameters.mppBindConstantBuffers );
     }
     if( mHullShaderParameters.mConstantBufferCount )
     {
-        pContext->HSSetConstantBuffers(0, mHullShaderParameters.mConstantBufferCount,     mHullShaderParameters.mppBindConstantBuffers );
+        pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_HULL,     0, mHullShaderParameters.mConstantBufferCount,     (CPUTBackendHandle*)mHullShaderParameters.mppBindConstantBuffers );
     }
     if( mDomainShaderParameters.mConstantBufferCount )
     {
-        pContext->DSSetConstantBuffers(0, mDomainShaderParameters.mConstantBufferCount,   mDomainShaderParameters.mppBindConstantBuffers );
+        pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_DOMAIN,   0, mDomainShaderParameters.mConstantBufferCount,   (CPUTBackendHandle*)mDomainShaderParameters.mppBindConstantBuffers );
     }
 	if( mComputeShaderParameters.mUAVCount )
 	{
 	    // TODO: Store initial bindpoint so we don't always start at 0 ?
 	    // Does PS require setting unordered access views when setting the render-target view?
 	    // pContext->PSSetUnorderedAccessViews(0, mPixelShaderParameters.mConstantBufferCount,    mPixelShaderParameters.mppBindConstantBuffers );
-	    pContext->CSSetUnorderedAccessViews(0, CPUT_MATERIAL_MAX_UAV_SLOTS,  mComputeShaderParameters.mppBindUAVs, NULL);
+	    pBackend->SetComputeUnorderedAccessViews( 0, CPUT_MATERIAL_MAX_UAV_SLOTS, (CPUTBackendHandle*)mComputeShaderParameters.mppBindUAVs );
 	}
 
     if( mpRenderStateBlock )
@@ -193,15 +195,16 @@ void CPUTMaterialDX11::ReadShaderSamplersAndTextures( ID3DBlob *pBlob, CPUTShade
     	hr = pReflector->GetResourceBindingDesc( ii++, &desc );
     }
 
-    pShaderParameter->mpTextureParameterName              = new cString[pShaderParameter->mTextureParameterCount];
+    pShaderParameter->mpTextureParameterName              = new CPUTStringID[pShaderParameter->mTextureParameterCount];
+    pShaderParameter->mpTextureParameterSRGBName          = new CPUTStringID[pShaderParameter->mTextureParameterCount];
     pShaderParameter->mpTextureParameterBindPoint         = new UINT[   pShaderParameter->mTextureParameterCount];
-    pShaderParameter->mpSamplerParameterName              = new cString[pShaderParameter->mSamplerParameterCount];
+    pShaderParameter->mpSamplerParameterName              = new CPUTStringID[pShaderParameter->mSamplerParameterCount];
     pShaderParameter->mpSamplerParameterBindPoint         = new UINT[   pShaderParameter->mSamplerParameterCount];
-    pShaderParameter->mpBufferParameterName               = new cString[pShaderParameter->mBufferParameterCount];
+    pShaderParameter->mpBufferParameterName               = new CPUTStringID[pShaderParameter->mBufferParameterCount];
     pShaderParameter->mpBufferParameterBindPoint          = new UINT[   pShaderParameter->mBufferParameterCount];
-    pShaderParameter->mpUAVParameterName                  = new cString[pShaderParameter->mUAVParameterCount];
+    pShaderParameter->mpUAVParameterName                  = new CPUTStringID[pShaderParameter->mUAVParameterCount];
     pShaderParameter->mpUAVParameterBindPoint             = new UINT[   pShaderParameter->mUAVParameterCount];
-    pShaderParameter->mpConstantBufferParameterName       = new cString[pShaderParameter->mConstantBufferParameterCount];
+    pShaderParameter->mpConstantBufferParameterName       = new CPUTStringID[pShaderParameter->mConstantBufferParameterCount];
     pShaderParameter->mpConstantBufferParameterBindPoint  = new UINT[   pShaderParameter->mConstantBufferParameterCount];
         
     // Start over.  This time, copy the names.
@@ -218,24 +221,25 @@ void CPUTMaterialDX11::ReadShaderSamplersAndTextures( ID3DBlob *pBlob, CPUTShade
         switch( desc.Type )
         {
         case D3D_SIT_TEXTURE:
-            pShaderParameter->mpTextureParameterName[textureIndex] = s2ws(desc.Name);
+            pShaderParameter->mpTextureParameterName[textureIndex] = CPUTStringTable::Intern( s2ws(desc.Name) );
+            pShaderParameter->mpTextureParameterSRGBName[textureIndex] = CPUTStringTable::Intern( s2ws(desc.Name) + _L("sRGB") );
             pShaderParameter->mpTextureParameterBindPoint[textureIndex] = desc.BindPoint;
             textureIndex++;
             break;
         case D3D_SIT_SAMPLER:
-            pShaderParameter->mpSamplerParameterName[samplerIndex] = s2ws(desc.Name);
+            pShaderParameter->mpSamplerParameterName[samplerIndex] = CPUTStringTable::Intern( s2ws(desc.Name) );
             pShaderParameter->mpSamplerParameterBindPoint[samplerIndex] = desc.BindPoint;
             samplerIndex++;
             break;
         case D3D_SIT_CBUFFER:
-            pShaderParameter->mpConstantBufferParameterName[constantBufferIndex] = s2ws(desc.Name);
+            pShaderParameter->mpConstantBufferParameterName[constantBufferIndex] = CPUTStringTable::Intern( s2ws(desc.Name) );
             pShaderParameter->mpConstantBufferParameterBindPoint[constantBufferIndex] = desc.BindPoint;
             constantBufferIndex++;
             break;
         case D3D_SIT_TBUFFER:
         case D3D_SIT_STRUCTURED:
         case D3D_SIT_BYTEADDRESS:
-            pShaderParameter->mpBufferParameterName[bufferIndex] = s2ws(desc.Name);
+            pShaderParameter->mpBufferParameterName[bufferIndex] = CPUTStringTable::Intern( s2ws(desc.Name) );
             pShaderParameter->mpBufferParameterBindPoint[bufferIndex] = desc.BindPoint;
             bufferIndex++;
             break;
@@ -245,7 +249,7 @@ void CPUTMaterialDX11::ReadShaderSamplersAndTextures( ID3DBlob *pBlob, CPUTShade
         case D3D_SIT_UAV_APPEND_STRUCTURED:
         case D3D_SIT_UAV_CONSUME_STRUCTURED:
         case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
-            pShaderParameter->mpUAVParameterName[uavIndex] = s2ws(desc.Name);
+            pShaderParameter->mpUAVParameterName[uavIndex] = CPUTStringTable::Intern( s2ws(desc.Name) );
             pShaderParameter->mpUAVParameterBindPoint[uavIndex] = desc.BindPoint;
             uavIndex++;
             break;
@@ -263,14 +267,14 @@ void CPUTMaterialDX11::BindTextures( CPUTShaderParameters &params, const cString
     {
         cString textureName;
         UINT textureCount = params.mTextureCount;
-        cString tagName = params.mpTextureParameterName[textureCount];
-        CPUTConfigEntry *pValue = mConfigBlock.GetValueByName(tagName);
+        CPUTStringID tagName = params.mpTextureParameterName[textureCount];
+        CPUTConfigEntry *pValue = mConfigBlock.GetValueByID(tagName);
         if( !pValue->IsValid() )
         {
             // We didn't find our property in the file.  Is it in the global config block?
-            pValue = mGlobalProperties.GetValueByName(tagName);
+            pValue = mGlobalProperties.GetValueByID(tagName);
         }
-        ASSERT( pValue->IsValid(), L"Can't find texture '" + tagName + L"'." ); //  TODO: fix message
+        ASSERT( pValue->IsValid(), L"Can't find texture '" + cString(CPUTStringTable::GetString(tagName)) + L"'." ); //  TODO: fix message
         textureName = pValue->ValueAsString();
         // If the texture name not specified.  Load default.dds instead
         if( 0 == textureName.length() ) { textureName = _L("default.dds"); }
@@ -281,7 +285,7 @@ void CPUTMaterialDX11::BindTextures( CPUTShaderParameters &params, const cString
         if( textureName[0] == '@' )
         {
             // This is a per-mesh value.  Add to per-mesh list.
-            textureName += modelSuffix + meshSuffix;
+            textureName.append( modelSuffix ).append( meshSuffix );
         } else if( textureName[0] == '#' )
         {
             // This is a per-mesh value.  Add to per-mesh list.
@@ -289,13 +293,13 @@ void CPUTMaterialDX11::BindTextures( CPUTShaderParameters &params, const cString
         }
 
         // Get the sRGB flag (default to true)
-        cString SRGBName = tagName+_L("sRGB");
-        CPUTConfigEntry *pSRGBValue = mConfigBlock.GetValueByName(SRGBName);
+        CPUTConfigEntry *pSRGBValue = mConfigBlock.GetValueByID(params.mpTextureParameterSRGBName[textureCount]);
         bool loadAsSRGB = pSRGBValue->IsValid() ?  loadAsSRGB = pSRGBValue->ValueAsBool() : true;
 
         if( !mpTexture[textureCount] )
         {
-            mpTexture[textureCount] = pAssetLibrary->GetTexture( textureName, false, loadAsSRGB );
+            // Material textures may stream.  GUI and font atlases can't: they need their full size up front.
+            mpTexture[textureCount] = pAssetLibrary->GetTexture( textureName, false, loadAsSRGB, true );
             ASSERT( mpTexture[textureCount], _L("Failed getting texture ") + textureName);
         }
 
@@ -316,15 +320,15 @@ void CPUTMaterialDX11::BindBuffers( CPUTShaderParameters &params, const cString
     {
         cString bufferName;
         UINT bufferCount = params.mBufferCount;
-        cString tagName = params.mpBufferParameterName[bufferCount];
+        CPUTStringID tagName = params.mpBufferParameterName[bufferCount];
         {
-            pValue = mConfigBlock.GetValueByName(tagName);
+            pValue = mConfigBlock.GetValueByID(tagName);
             if( !pValue->IsValid() )
             {
                 // We didn't find our property in the file.  Is it in the global config block?
-                pValue = mGlobalProperties.GetValueByName(tagName);
+                pValue = mGlobalProperties.GetValueByID(tagName);
             }
-            ASSERT( pValue->IsValid(), L"Can't find buffer '" + tagName + L"'." ); //  TODO: fix message
+            ASSERT( pValue->IsValid(), L"Can't find buffer '" + cString(CPUTStringTable::GetString(tagName)) + L"'." ); //  TODO: fix message
             bufferName = pValue->ValueAsString();
         }
         UINT bindPoint = params.mpBufferParameterBindPoint[bufferCount]; 
@@ -333,7 +337,7 @@ void CPUTMaterialDX11::BindBuffers( CPUTShaderParameters &params, const cString
         if( bufferName[0] == '@' )
         {
             // This is a per-mesh value.  Add to per-mesh list.
-            bufferName += modelSuffix + meshSuffix;
+            bufferName.append( modelSuffix ).append( meshSuffix );
         } else if( bufferName[0] == '#' )
         {
             // This is a per-mesh value.  Add to per-model list.
@@ -361,15 +365,15 @@ void CPUTMaterialDX11::BindUAVs( CPUTShaderParameters &params, const cString &mo
         cString uavName;
         UINT uavCount = params.mUAVCount;
 
-        cString tagName = params.mpUAVParameterName[uavCount];
+        CPUTStringID tagName = params.mpUAVParameterName[uavCount];
         {
-            pValue = mConfigBlock.GetValueByName(tagName);
+            pValue = mConfigBlock.GetValueByID(tagName);
             if( !pValue->IsValid() )
             {
                 // We didn't find our property in the file.  Is it in the global config block?
-                pValue = mGlobalProperties.GetValueByName(tagName);
+                pValue = mGlobalProperties.GetValueByID(tagName);
             }
-            ASSERT( pValue->IsValid(), L"Can't find UAV '" + tagName + L"'." ); //  TODO: fix message
+            ASSERT( pValue->IsValid(), L"Can't find UAV '" + cString(CPUTStringTable::GetString(tagName)) + L"'." ); //  TODO: fix message
             uavName = pValue->ValueAsString();
         }
         UINT bindPoint = params.mpUAVParameterBindPoint[uavCount];
@@ -378,7 +382,7 @@ void CPUTMaterialDX11::BindUAVs( CPUTShaderParameters &params, const cString &mo
         if( uavName[0] == '@' )
         {
             // This is a per-mesh value.  Add to per-mesh list.
-            uavName += modelSuffix + meshSuffix;
+            uavName.append( modelSuffix ).append( meshSuffix );
         } else if( uavName[0] == '#' )
         {
             // This is a per-mesh value.  Add to per-model list.
@@ -406,15 +410,15 @@ void CPUTMaterialDX11::BindConstantBuffers( CPUTShaderParameters &params, const
         cString constantBufferName;
         UINT constantBufferCount = params.mConstantBufferCount;
 
-        cString tagName = params.mpConstantBufferParameterName[constantBufferCount];
+        CPUTStringID tagName = params.mpConstantBufferParameterName[constantBufferCount];
         {
-            pValue = mConfigBlock.GetValueByName(tagName);
+            pValue = mConfigBlock.GetValueByID(tagName);
             if( !pValue->IsValid() )
             {
                 // We didn't find our property in the file.  Is it in the global config block?
-                pValue = mGlobalProperties.GetValueByName(tagName);
+                pValue = mGlobalProperties.GetValueByID(tagName);
             }
-            ASSERT( pValue->IsValid(), L"Can't find constant buffer '" + tagName + L"'." ); //  TODO: fix message
+            ASSERT( pValue->IsValid(), L"Can't find constant buffer '" + cString(CPUTStringTable::GetString(tagName)) + L"'." ); //  TODO: fix message
             constantBufferName = pValue->ValueAsString();
         }
         UINT bindPoint = params.mpConstantBufferParameterBindPoint[constantBufferCount];
@@ -422,7 +426,7 @@ void CPUTMaterialDX11::BindConstantBuffers( CPUTShaderParameters &params, const
 
         if( constantBufferName[0] == '@' )
         {
-            constantBufferName += modelSuffix + meshSuffix;
+            constantBufferName.append( modelSuffix ).append( meshSuffix );
         } else if( constantBufferName[0] == '#' )
         {
             constantBufferName += modelSuffix;
@@ -471,6 +475,13 @@ CPUTResult CPUTMaterialDX11::LoadMaterial(const cString &fileName, const cString
         pProfileName    = mConfigBlock.GetValueByName(_L("VertexShaderProfile"));
         pAssetLibrary->GetVertexShader(pValue->ValueAsString(), pD3dDevice, pEntryPointName->ValueAsString(), pProfileName->ValueAsString(), &mpVertexShader );
         ReadShaderSamplersAndTextures( mpVertexShader->GetBlob(), &mVertexShaderParameters );
+
+        // Optional instanced variant of the vertex shader.  Same file and profile, same resources.
+        pEntryPointName = mConfigBlock.GetValueByName(_L("InstancedVertexShaderMain"));
+        if( pEntryPointName->IsValid() )
+        {
+            pAssetLibrary->GetVertexShader(pValue->ValueAsString(), pD3dDevice, pEntryPointName->ValueAsString(), pProfileName->ValueAsString(), &mpInstancedVertexShader );
+        }
     }
 
     // load and store the pixel shader if it was specified
@@ -538,6 +549,7 @@ CPUTResult CPUTMaterialDX11::LoadMaterial(const cString &fileName, const cString
         BindUAVs(            **pCur, modelSuffix, meshSuffix );
         BindConstantBuffers( **pCur, modelSuffix, meshSuffix );
     }
+    UpdateSortIds();
 
     return result;
 }
@@ -551,6 +563,8 @@ CPUTMaterial *CPUTMaterialDX11::CloneMaterial(const cString &fileName, const cSt
     pMaterial->mpPixelShader                  = mpPixelShader;
     pMaterial->mpComputeShader                = mpComputeShader;
     pMaterial->mpVertexShader                 = mpVertexShader;
+    pMaterial->mpInstancedVertexShader        = mpInstancedVertexShader;
+    if( mpInstancedVertexShader ) { mpInstancedVertexShader->AddRef(); }
     pMaterial->mpGeometryShader               = mpGeometryShader;
     pMaterial->mpHullShader                   = mpHullShader;
     pMaterial->mpDomainShader                 = mpDomainShader;
@@ -579,10 +593,28 @@ CPUTMaterial *CPUTMaterialDX11::CloneMaterial(const cString &fileName, const cSt
         BindUAVs(            **pCur, modelSuffix, meshSuffix );
         BindConstantBuffers( **pCur, modelSuffix, meshSuffix );
     }
+    pMaterial->UpdateSortIds();
 
     return pMaterial;
 }
 
+// Switches between the regular and the instanced vertex shader.  SetRenderStates() binds the regular one.
+//-----------------------------------------------------------------------------
+void CPUTMaterialDX11::SetInstancing( CPUTRenderParameters &renderParams, bool instanced )
+{
+    CPUTVertexShaderDX11 *pVertexShader = (instanced && mpInstancedVertexShader) ? mpInstancedVertexShader : mpVertexShader;
+    renderParams.mpBackend->SetShader( CPUT_SHADER_STAGE_VERTEX, pVertexShader ? pVertexShader->GetNativeVertexShader() : NULL );
+}
+
+// Materials sharing shaders (or a render state block) get the same id, so the render queue draws them together
+//-----------------------------------------------------------------------------
+void CPUTMaterialDX11::UpdateSortIds()
+{
+    mShaderSortId   = CPUTRenderQueue::GetSortId( CPUT_SORT_FIELD_SHADER,   mpVertexShader, mpPixelShader );
+    mStateSortId    = CPUTRenderQueue::GetSortId( CPUT_SORT_FIELD_STATE,    mpRenderStateBlock );
+    mMaterialSortId = CPUTRenderQueue::GetSortId( CPUT_SORT_FIELD_MATERIAL, this );
+}
+
 //-----------------------------------------------------------------------------
 bool CPUTMaterialDX11::MaterialRequiresPerModelPayload()
 {
@@ -596,6 +628,55 @@ bool CPUTMaterialDX11::MaterialRequiresPerModelPayload()
         (mpDomainShader   && mpDomainShader  ->ShaderRequiresPerModelPayload(mConfigBlock));
 }
 
+// The views and buffers each stage binds stand in for the textures, buffers and constants
+// they come from: the library shares those by name, so equal pointers mean equal content.
+//-----------------------------------------------------------------------------
+void CPUTMaterialDX11::GetContentKey( std::vector<const void*> *pKey )
+{
+    pKey->clear();
+    if( MaterialRequiresPerModelPayload() )
+    {
+        // Each model gets its own clone of this material, so there's nothing to share
+        return;
+    }
+    pKey->reserve( 8 + (CPUT_NUM_SHADER_PARAMETER_LISTS-1) * (CPUT_MATERIAL_MAX_SRV_SLOTS + CPUT_MATERIAL_MAX_UAV_SLOTS + CPUT_MATERIAL_MAX_CONSTANT_BUFFER_SLOTS) );
+    pKey->push_back( mpPixelShader );
+    pKey->push_back( mpComputeShader );
+    pKey->push_back( mpVertexShader );
+    pKey->push_back( mpInstancedVertexShader );
+    pKey->push_back( mpGeometryShader );
+    pKey->push_back( mpHullShader );
+    pKey->push_back( mpDomainShader );
+    pKey->push_back( mpRenderStateBlock );
+    for( CPUTShaderParameters **pCur = mpShaderParametersList; *pCur; pCur++ )
+    {
+        pKey->insert( pKey->end(), (*pCur)->mppBindViews,           (*pCur)->mppBindViews           + CPUT_MATERIAL_MAX_SRV_SLOTS );
+        pKey->insert( pKey->end(), (*pCur)->mppBindUAVs,            (*pCur)->mppBindUAVs            + CPUT_MATERIAL_MAX_UAV_SLOTS );
+        pKey->insert( pKey->end(), (*pCur)->mppBindConstantBuffers, (*pCur)->mppBindConstantBuffers + CPUT_MATERIAL_MAX_CONSTANT_BUFFER_SLOTS );
+    }
+}
+
+// An estimate: the object, its parameter tables, and its name and config strings
+//-----------------------------------------------------------------------------
+size_t CPUTMaterialDX11::GetMemoryUsage()
+{
+    size_t bytes = sizeof(*this) + mMaterialName.capacity() * sizeof(cString::value_type);
+    for( int ii=0; ii<mConfigBlock.ValueCount(); ii++ )
+    {
+        bytes += sizeof(CPUTConfigEntry) + mConfigBlock.GetValue(ii)->ValueAsString().capacity() * sizeof(cString::value_type);
+    }
+    for( CPUTShaderParameters **pCur = mpShaderParametersList; *pCur; pCur++ )
+    {
+        const CPUTShaderParameters &params = **pCur;
+        bytes += params.mTextureParameterCount        * (2 * sizeof(CPUTStringID) + sizeof(UINT));
+        bytes += params.mSamplerParameterCount        * (sizeof(CPUTStringID) + sizeof(UINT));
+        bytes += params.mBufferParameterCount         * (sizeof(CPUTStringID) + sizeof(UINT));
+        bytes += params.mUAVParameterCount            * (sizeof(CPUTStringID) + sizeof(UINT));
+        bytes += params.mConstantBufferParameterCount * (sizeof(CPUTStringID) + sizeof(UINT));
+    }
+    return bytes;
+}
+
 //-----------------------------------------------------------------------------
 void CPUTMaterialDX11::RebindTexturesAndBuffers()
 {
@@ -604,6 +685,7 @@ void CPUTMaterialDX11::RebindTexturesAndBuffers()
         for( UINT ii=0; ii<(*pCur)->mTextureCount; ii++ )
         {
             UINT bindPoint = (*pCur)->mpTextureParameterBindPoint[ii];
+            SAFE_RELEASE((*pCur)->mppBindViews[bindPoint]); // A shared material is in the library more than once, so may be rebound twice
             (*pCur)->mppBindViews[bindPoint] = ((CPUTTextureDX11*)mpTexture[ii])->GetShaderResourceView();
 			(*pCur)->mppBindViews[bindPoint]->AddRef();
         }
@@ -624,6 +706,25 @@ void CPUTMaterialDX11::RebindTexturesAndBuffers()
     }
 }
 
+//-----------------------------------------------------------------------------
+void CPUTMaterialDX11::RebindTextures(const std::vector<CPUTTexture*> &textures)
+{
+    for( CPUTShaderParameters **pCur = mpShaderParametersList; *pCur; pCur++ )
+    {
+        for( UINT ii=0; ii<(*pCur)->mTextureCount; ii++ )
+        {
+            if( !std::binary_search( textures.begin(), textures.end(), mpTexture[ii] ) )
+            {
+                continue;
+            }
+            UINT bindPoint = (*pCur)->mpTextureParameterBindPoint[ii];
+            SAFE_RELEASE((*pCur)->mppBindViews[bindPoint]);
+            (*pCur)->mppBindViews[bindPoint] = ((CPUTTextureDX11*)mpTexture[ii])->GetShaderResourceView();
+            (*pCur)->mppBindViews[bindPoint]->AddRef();
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 void CPUTMaterialDX11::ReleaseTexturesAndBuffers()
 {
@@ -651,15 +752,16 @@ void CPUTMaterialDX11::ReleaseTexturesAndBuffers()
 //-----------------------------------------------------------------------------
 void CPUTShaderParameters::CloneShaderParameters( CPUTShaderParameters *pShaderParameter )
 {
-    pShaderParameter->mpTextureParameterName              = new cString[mTextureParameterCount];
+    pShaderParameter->mpTextureParameterName              = new CPUTStringID[mTextureParameterCount];
+    pShaderParameter->mpTextureParameterSRGBName          = new CPUTStringID[mTextureParameterCount];
     pShaderParameter->mpTextureParameterBindPoint         = new UINT[   mTextureParameterCount];
-    pShaderParameter->mpSamplerParameterName              = new cString[mSamplerParameterCount];
+    pShaderParameter->mpSamplerParameterName              = new CPUTStringID[mSamplerParameterCount];
     pShaderParameter->mpSamplerParameterBindPoint         = new UINT[   mSamplerParameterCount];
-    pShaderParameter->mpBufferParameterName               = new cString[mBufferParameterCount];
+    pShaderParameter->mpBufferParameterName               = new CPUTStringID[mBufferParameterCount];
     pShaderParameter->mpBufferParameterBindPoint          = new UINT[   mBufferParameterCount];
-    pShaderParameter->mpUAVParameterName                  = new cString[mUAVParameterCount];
+    pShaderParameter->mpUAVParameterName                  = new CPUTStringID[mUAVParameterCount];
     pShaderParameter->mpUAVParameterBindPoint             = new UINT[   mUAVParameterCount];
-    pShaderParameter->mpConstantBufferParameterName       = new cString[mConstantBufferParameterCount];
+    pShaderParameter->mpConstantBufferParameterName       = new CPUTStringID[mConstantBufferParameterCount];
     pShaderParameter->mpConstantBufferParameterBindPoint  = new UINT[   mConstantBufferParameterCount];
 
     pShaderParameter->mTextureCount = mTextureCount;
@@ -667,6 +769,7 @@ void CPUTShaderParameters::CloneShaderParameters( CPUTShaderParameters *pShaderP
     for(UINT ii=0; ii<mTextureParameterCount; ii++ )
     {
         pShaderParameter->mpTextureParameterName[ii]      = mpTextureParameterName[ii];
+        pShaderParameter->mpTextureParameterSRGBName[ii]  = mpTextureParameterSRGBName[ii];
         pShaderParameter->mpTextureParameterBindPoint[ii] = mpTextureParameterBindPoint[ii];
     }
     for(UINT ii=0; ii<mSamplerParameterCount; ii++ )
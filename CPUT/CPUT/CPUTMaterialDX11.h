@@ -29,29 +29,32 @@ class CPUTDomainShaderDX11;
 class CPUTShaderParameters
 {
 public:
+    // Parameter names are interned (see CPUTStringID.h), so binding looks them up in the
+    // material's config block without building or folding strings
     UINT                       mTextureCount;
-    cString                   *mpTextureParameterName;
+    CPUTStringID              *mpTextureParameterName;
+    CPUTStringID              *mpTextureParameterSRGBName; // The name with "sRGB" appended
     UINT                      *mpTextureParameterBindPoint;
     UINT                       mTextureParameterCount;
 
     // UINT                       mSamplerCount; // TODO: Why don't we need this? We should probably be rebinding samplers too
-    cString                   *mpSamplerParameterName;
+    CPUTStringID              *mpSamplerParameterName;
     UINT                      *mpSamplerParameterBindPoint;
     UINT                       mSamplerParameterCount;
 
     UINT                       mBufferCount;
     UINT                       mBufferParameterCount;
-    cString                   *mpBufferParameterName;
+    CPUTStringID              *mpBufferParameterName;
     UINT                      *mpBufferParameterBindPoint;
 
     UINT                       mUAVCount;
     UINT                       mUAVParameterCount;
-    cString                   *mpUAVParameterName;
+    CPUTStringID              *mpUAVParameterName;
     UINT                      *mpUAVParameterBindPoint;
 
     UINT                       mConstantBufferCount;
     UINT                       mConstantBufferParameterCount;
-    cString                   *mpConstantBufferParameterName;
+    CPUTStringID              *mpConstantBufferParameterName;
     UINT                      *mpConstantBufferParameterBindPoint;
 
     ID3D11ShaderResourceView  *mppBindViews[CPUT_MATERIAL_MAX_SRV_SLOTS];
@@ -62,6 +65,7 @@ public:
         mTextureCount(0),
         mTextureParameterCount(0),
         mpTextureParameterName(NULL),
+        mpTextureParameterSRGBName(NULL),
         mpTextureParameterBindPoint(NULL),
         mSamplerParameterCount(0),
         mpSamplerParameterName(NULL),
@@ -108,6 +112,7 @@ public:
             SAFE_RELEASE(mppBindConstantBuffers[ii]);
         }
         SAFE_DELETE_ARRAY(mpTextureParameterName);
+        SAFE_DELETE_ARRAY(mpTextureParameterSRGBName);
         SAFE_DELETE_ARRAY(mpTextureParameterBindPoint);
         SAFE_DELETE_ARRAY(mpSamplerParameterName);
         SAFE_DELETE_ARRAY(mpSamplerParameterBindPoint);
@@ -129,6 +134,7 @@ protected:
     CPUTPixelShaderDX11      *mpPixelShader;
     CPUTComputeShaderDX11    *mpComputeShader; // TODO: Do Compute Shaders belong in material?
     CPUTVertexShaderDX11     *mpVertexShader;
+    CPUTVertexShaderDX11     *mpInstancedVertexShader; // Optional.  Reads the world matrices from the CPUTInstanceData stream.
     CPUTGeometryShaderDX11   *mpGeometryShader;
     CPUTHullShaderDX11       *mpHullShader;
     CPUTDomainShaderDX11     *mpDomainShader;
@@ -152,6 +158,7 @@ protected:
     void BindBuffers(         CPUTShaderParameters &params, const cString &modelSuffix, const cString &meshSuffix );
     void BindUAVs(            CPUTShaderParameters &params, const cString &modelSuffix, const cString &meshSuffix );
     void BindConstantBuffers( CPUTShaderParameters &params, const cString &modelSuffix, const cString &meshSuffix );
+    void UpdateSortIds();
 
 public:
     CPUTMaterialDX11();
@@ -159,7 +166,9 @@ public:
     CPUTResult    LoadMaterial(const cString &fileName, const cString &modelSuffix, const cString &meshSuffix);
     void          ReleaseTexturesAndBuffers();
     void          RebindTexturesAndBuffers();
+    void          RebindTextures(const std::vector<CPUTTexture*> &textures);
     CPUTVertexShaderDX11   *GetVertexShader()   { return mpVertexShader; }
+    CPUTVertexShaderDX11   *GetInstancedVertexShader() { return mpInstancedVertexShader; }
     CPUTPixelShaderDX11    *GetPixelShader()    { return mpPixelShader; }
     CPUTGeometryShaderDX11 *GetGeometryShader() { return mpGeometryShader; }
     CPUTComputeShaderDX11  *GetComputeShader()  { return mpComputeShader; }
@@ -170,6 +179,10 @@ public:
     //  shaders, state, etc that this material represents
     void SetRenderStates( CPUTRenderParameters &renderParams );
     bool MaterialRequiresPerModelPayload();
+    void GetContentKey( std::vector<const void*> *pKey );
+    size_t GetMemoryUsage();
+    bool SupportsInstancing() { return NULL != mpInstancedVertexShader; }
+    void SetInstancing( CPUTRenderParameters &renderParams, bool instanced );
     CPUTMaterial *CloneMaterial( const cString &absolutePathAndFilename, const cString &modelSuffix, const cString &meshSuffix );
 };
 
@@ -18,6 +18,29 @@
 #define __CPUTMath_h__
 #include <math.h>
 
+/*
+ * SIMD backend: SSE on x86/x64, NEON on ARM, chosen at compile time.  Define
+ * CPUT_MATH_NO_SIMD before including this file to get the scalar code.  The vector
+ * paths do the same multiplies and adds in the same order as the scalar ones, except
+ * float4x4::invert(), which uses a cheaper method and agrees to within rounding.
+ * Array versions of the hot operations are in CPUTMathBatch.h.
+ */
+#if defined(_MSC_VER)
+#   define CPUT_ALIGN16 __declspec(align(16))
+#else
+#   define CPUT_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+#if !defined(CPUT_MATH_NO_SIMD)
+#   if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#       include <xmmintrin.h>
+#       define CPUT_MATH_SSE
+#   elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM) || defined(_M_ARM64)
+#       include <arm_neon.h>
+#       define CPUT_MATH_NEON
+#   endif
+#endif
+
 /*
  * Constants
  */
@@ -374,7 +397,7 @@ inline float3 normalize(const float3 &v)
 /**************************************\
 float4
 \**************************************/
-__declspec(align(16)) struct float4
+struct CPUT_ALIGN16 float4
 {
     union
     {
@@ -562,12 +585,9 @@ float3x3
 struct float4x4;
 struct float3x3
 {
-    struct
-    {
-        float3 r0;
-        float3 r1;
-        float3 r2;
-    };
+    float3 r0;
+    float3 r1;
+    float3 r2;
 
     /***************************************\
     |   Constructors                        |
@@ -828,13 +848,10 @@ float4x4
 \**************************************/
 struct float4x4
 {
-    struct
-    {
-        float4 r0;
-        float4 r1;
-        float4 r2;
-        float4 r3;
-    };
+    float4 r0;
+    float4 r1;
+    float4 r2;
+    float4 r3;
 
     /***************************************\
     |   Constructors                        |
@@ -873,18 +890,43 @@ struct float4x4
     |   Basic math operations               |
     \***************************************/
 
-    #define MTX4_INDEX(f,r,c) ((f)[(r*4)+c])
     inline float4x4 operator*(const float4x4 &r) const
     {
-        float4x4 m(1,0,0,0,
-                   0,1,0,0,
-                   0,0,1,0,
-                   0,0,0,1);
+        float4x4 m;
 
         const float* left     = (const float*)&this->r0;
         const float* right    = (const float*)&r.r0;
         float* result   = (float*)&m;
 
+#if defined(CPUT_MATH_SSE)
+        // each result row is a blend of the right-hand rows
+        __m128 b0 = _mm_loadu_ps(right+0);
+        __m128 b1 = _mm_loadu_ps(right+4);
+        __m128 b2 = _mm_loadu_ps(right+8);
+        __m128 b3 = _mm_loadu_ps(right+12);
+        for(int ii=0; ii<16; ii+=4)
+        {
+            __m128 row = _mm_mul_ps(_mm_set1_ps(left[ii+0]), b0);
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(left[ii+1]), b1));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(left[ii+2]), b2));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(left[ii+3]), b3));
+            _mm_storeu_ps(result+ii, row);
+        }
+#elif defined(CPUT_MATH_NEON)
+        float32x4_t b0 = vld1q_f32(right+0);
+        float32x4_t b1 = vld1q_f32(right+4);
+        float32x4_t b2 = vld1q_f32(right+8);
+        float32x4_t b3 = vld1q_f32(right+12);
+        for(int ii=0; ii<16; ii+=4)
+        {
+            float32x4_t row = vmulq_n_f32(b0, left[ii+0]);
+            row = vaddq_f32(row, vmulq_n_f32(b1, left[ii+1]));
+            row = vaddq_f32(row, vmulq_n_f32(b2, left[ii+2]));
+            row = vaddq_f32(row, vmulq_n_f32(b3, left[ii+3]));
+            vst1q_f32(result+ii, row);
+        }
+#else
+        #define MTX4_INDEX(f,r,c) ((f)[(r*4)+c])
         int ii, jj, kk;
         for(ii=0; ii<4; ++ii) /* row */
         {
@@ -898,9 +940,10 @@ struct float4x4
                 MTX4_INDEX(result,ii,jj) = sum;
             }
         }
+        #undef MTX4_INDEX
+#endif
         return m;
     }
-    #undef MTX4_INDEX
 
     inline float4 operator*(const float4 &v) const
     {
@@ -1023,6 +1066,61 @@ struct float4x4
 
     void invert(void)
     {
+#if defined(CPUT_MATH_SSE)
+        // Block inverse: with the 2x2 blocks | A B |, inverse = 1/det * | X Y |
+        //                                    | C D |                 | Z W |
+        // where X = adj(|D|A - B adj(D)C) etc.  Each 2x2 block is one register
+        // (row-major: 00 01 10 11).
+        #define CPUT_SWIZZLE(v,x,y,z,w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w,z,y,x))
+        #define CPUT_MAT2_MUL(a,b)      _mm_add_ps(_mm_mul_ps(a, CPUT_SWIZZLE(b,0,3,0,3)), _mm_mul_ps(CPUT_SWIZZLE(a,1,0,3,2), CPUT_SWIZZLE(b,2,1,2,1)))
+        #define CPUT_MAT2_ADJ_MUL(a,b)  _mm_sub_ps(_mm_mul_ps(CPUT_SWIZZLE(a,3,3,0,0), b), _mm_mul_ps(CPUT_SWIZZLE(a,1,1,2,2), CPUT_SWIZZLE(b,2,3,0,1)))
+        #define CPUT_MAT2_MUL_ADJ(a,b)  _mm_sub_ps(_mm_mul_ps(a, CPUT_SWIZZLE(b,3,0,3,0)), _mm_mul_ps(CPUT_SWIZZLE(a,1,0,3,2), CPUT_SWIZZLE(b,2,1,2,1)))
+        __m128 row0 = _mm_loadu_ps(r0.f);
+        __m128 row1 = _mm_loadu_ps(r1.f);
+        __m128 row2 = _mm_loadu_ps(r2.f);
+        __m128 row3 = _mm_loadu_ps(r3.f);
+        __m128 A = _mm_movelh_ps(row0, row1);
+        __m128 B = _mm_movehl_ps(row1, row0);
+        __m128 C = _mm_movelh_ps(row2, row3);
+        __m128 D = _mm_movehl_ps(row3, row2);
+
+        // (|A| |B| |C| |D|)
+        __m128 detSub = _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2,0,2,0)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3,1,3,1))),
+            _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3,1,3,1)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2,0,2,0))));
+        __m128 detA = CPUT_SWIZZLE(detSub,0,0,0,0);
+        __m128 detB = CPUT_SWIZZLE(detSub,1,1,1,1);
+        __m128 detC = CPUT_SWIZZLE(detSub,2,2,2,2);
+        __m128 detD = CPUT_SWIZZLE(detSub,3,3,3,3);
+
+        __m128 DC = CPUT_MAT2_ADJ_MUL(D, C);
+        __m128 AB = CPUT_MAT2_ADJ_MUL(A, B);
+        __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), CPUT_MAT2_MUL(B, DC));
+        __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), CPUT_MAT2_MUL(C, AB));
+        __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), CPUT_MAT2_MUL_ADJ(D, AB));
+        __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), CPUT_MAT2_MUL_ADJ(A, DC));
+
+        // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+        __m128 trace = _mm_mul_ps(AB, CPUT_SWIZZLE(DC,0,2,1,3));
+        trace = _mm_add_ps(trace, _mm_movehl_ps(trace, trace));
+        trace = _mm_add_ss(trace, CPUT_SWIZZLE(trace,1,1,1,1));
+        __m128 det = _mm_sub_ss(_mm_add_ss(_mm_mul_ss(detA, detD), _mm_mul_ss(detB, detC)), trace);
+        __m128 recip = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), CPUT_SWIZZLE(det,0,0,0,0));
+        X = _mm_mul_ps(X, recip);
+        Y = _mm_mul_ps(Y, recip);
+        Z = _mm_mul_ps(Z, recip);
+        W = _mm_mul_ps(W, recip);
+
+        // adjugate each block while putting the rows back together
+        _mm_storeu_ps(r0.f, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1,3,1,3)));
+        _mm_storeu_ps(r1.f, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0,2,0,2)));
+        _mm_storeu_ps(r2.f, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1,3,1,3)));
+        _mm_storeu_ps(r3.f, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0,2,0,2)));
+        #undef CPUT_MAT2_MUL_ADJ
+        #undef CPUT_MAT2_ADJ_MUL
+        #undef CPUT_MAT2_MUL
+        #undef CPUT_SWIZZLE
+#else
         float4x4 ret;
         float recip;
 
@@ -1139,6 +1237,7 @@ struct float4x4
         ret *= recip;
 
         *this = ret;
+#endif
     }
 
     // Axis access
@@ -1490,6 +1589,38 @@ inline quaternion quaternionIdentity(void)
     return quaternion(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
+// Shortest-arc interpolation between unit quaternions.  Uses the polynomial form of
+// slerp from Eberly's "A Fast and Accurate Algorithm for Computing SLERP" (no trig or
+// divides).  The weights are within 2e-5 of the exact ones for rotations 180 degrees
+// apart, and within 1e-6 for rotations up to 120 degrees apart.
+static const float kSlerpU[8] = { 1.0f/(1*3), 1.0f/(2*5), 1.0f/(3*7), 1.0f/(4*9), 1.0f/(5*11), 1.0f/(6*13), 1.0f/(7*15), 1.85298109f/(8*17) };
+static const float kSlerpV[8] = { 1.0f/3, 2.0f/5, 3.0f/7, 4.0f/9, 5.0f/11, 6.0f/13, 7.0f/15, 1.85298109f*8/17 };
+
+inline quaternion quaternionSlerp(const quaternion &a, const quaternion &b, float t)
+{
+    float cosTheta = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+    float sign = 1.0f;
+    if( cosTheta < 0.0f )
+    {
+        cosTheta = -cosTheta;
+        sign = -1.0f;
+    }
+    float xm1 = cosTheta - 1.0f;
+    float d   = 1.0f - t;
+    float tt  = t*t;
+    float dd  = d*d;
+    float wa  = 1.0f;
+    float wb  = 1.0f;
+    for( int ii=7; ii>=0; ii-- )
+    {
+        wa = 1.0f + (kSlerpU[ii]*dd - kSlerpV[ii]) * xm1 * wa;
+        wb = 1.0f + (kSlerpU[ii]*tt - kSlerpV[ii]) * xm1 * wb;
+    }
+    wa *= d;
+    wb *= t * sign;
+    return quaternion( a.x*wa + b.x*wb, a.y*wa + b.y*wb, a.z*wa + b.z*wb, a.w*wa + b.w*wb );
+}
+
 
 /**************************************\
 Plane
@@ -1546,10 +1677,24 @@ inline float4 operator*(const float4 &v, const float4x4 &m)
 {
     float4 result;
 
+#if defined(CPUT_MATH_SSE)
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m.r0.f), _mm_set1_ps(v.x));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.r1.f), _mm_set1_ps(v.y)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.r2.f), _mm_set1_ps(v.z)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.r3.f), _mm_set1_ps(v.w)));
+    _mm_storeu_ps(result.f, r);
+#elif defined(CPUT_MATH_NEON)
+    float32x4_t r = vmulq_n_f32(vld1q_f32(m.r0.f), v.x);
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m.r1.f), v.y));
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m.r2.f), v.z));
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m.r3.f), v.w));
+    vst1q_f32(result.f, r);
+#else
     result  = m.r0 * v.x;
     result += m.r1 * v.y;
     result += m.r2 * v.z;
     result += m.r3 * v.w;
+#endif
 
     return result;
 }
@@ -0,0 +1,244 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMathBatch.h"
+
+#if defined(CPUT_MATH_SSE) && defined(__AVX__)
+#   include <immintrin.h>
+#   define CPUT_MATH_AVX
+#endif
+
+//-----------------------------------------------------------------------------
+static inline void MultiplyRows( float *pDst, const float *pA, const float *pB )
+{
+#if defined(CPUT_MATH_AVX)
+    // Two result rows per iteration.  Each 128-bit lane holds one row.
+    __m128 b0 = _mm_loadu_ps( pB + 0 );
+    __m128 b1 = _mm_loadu_ps( pB + 4 );
+    __m128 b2 = _mm_loadu_ps( pB + 8 );
+    __m128 b3 = _mm_loadu_ps( pB + 12 );
+    __m256 bb0 = _mm256_insertf128_ps( _mm256_castps128_ps256(b0), b0, 1 );
+    __m256 bb1 = _mm256_insertf128_ps( _mm256_castps128_ps256(b1), b1, 1 );
+    __m256 bb2 = _mm256_insertf128_ps( _mm256_castps128_ps256(b2), b2, 1 );
+    __m256 bb3 = _mm256_insertf128_ps( _mm256_castps128_ps256(b3), b3, 1 );
+    for( int ii=0; ii<16; ii+=8 )
+    {
+        __m256 aa = _mm256_loadu_ps( pA + ii );
+        __m256 r  = _mm256_mul_ps( _mm256_shuffle_ps( aa, aa, _MM_SHUFFLE(0,0,0,0) ), bb0 );
+        r = _mm256_add_ps( r, _mm256_mul_ps( _mm256_shuffle_ps( aa, aa, _MM_SHUFFLE(1,1,1,1) ), bb1 ) );
+        r = _mm256_add_ps( r, _mm256_mul_ps( _mm256_shuffle_ps( aa, aa, _MM_SHUFFLE(2,2,2,2) ), bb2 ) );
+        r = _mm256_add_ps( r, _mm256_mul_ps( _mm256_shuffle_ps( aa, aa, _MM_SHUFFLE(3,3,3,3) ), bb3 ) );
+        _mm256_storeu_ps( pDst + ii, r );
+    }
+#elif defined(CPUT_MATH_SSE)
+    __m128 b0 = _mm_loadu_ps( pB + 0 );
+    __m128 b1 = _mm_loadu_ps( pB + 4 );
+    __m128 b2 = _mm_loadu_ps( pB + 8 );
+    __m128 b3 = _mm_loadu_ps( pB + 12 );
+    for( int ii=0; ii<16; ii+=4 )
+    {
+        __m128 r = _mm_mul_ps( _mm_set1_ps( pA[ii+0] ), b0 );
+        r = _mm_add_ps( r, _mm_mul_ps( _mm_set1_ps( pA[ii+1] ), b1 ) );
+        r = _mm_add_ps( r, _mm_mul_ps( _mm_set1_ps( pA[ii+2] ), b2 ) );
+        r = _mm_add_ps( r, _mm_mul_ps( _mm_set1_ps( pA[ii+3] ), b3 ) );
+        _mm_storeu_ps( pDst + ii, r );
+    }
+#elif defined(CPUT_MATH_NEON)
+    float32x4_t b0 = vld1q_f32( pB + 0 );
+    float32x4_t b1 = vld1q_f32( pB + 4 );
+    float32x4_t b2 = vld1q_f32( pB + 8 );
+    float32x4_t b3 = vld1q_f32( pB + 12 );
+    for( int ii=0; ii<16; ii+=4 )
+    {
+        float32x4_t r = vmulq_n_f32( b0, pA[ii+0] );
+        r = vaddq_f32( r, vmulq_n_f32( b1, pA[ii+1] ) );
+        r = vaddq_f32( r, vmulq_n_f32( b2, pA[ii+2] ) );
+        r = vaddq_f32( r, vmulq_n_f32( b3, pA[ii+3] ) );
+        vst1q_f32( pDst + ii, r );
+    }
+#else
+    for( int ii=0; ii<16; ii+=4 )
+    {
+        // Row ii of pA is read before row ii of pDst is written, so pDst may be pA
+        float a0 = pA[ii+0], a1 = pA[ii+1], a2 = pA[ii+2], a3 = pA[ii+3];
+        for( int jj=0; jj<4; jj++ )
+        {
+            pDst[ii+jj] = a0*pB[jj] + a1*pB[4+jj] + a2*pB[8+jj] + a3*pB[12+jj];
+        }
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMultiplyMatrix4x4( float4x4 *pOut, const float4x4 &a, const float4x4 &b )
+{
+    MultiplyRows( (float*)pOut, (const float*)&a, (const float*)&b );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMultiplyMatrices( float4x4 *pOut, const float4x4 *pA, const float4x4 *pB, uint32_t count )
+{
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        MultiplyRows( (float*)&pOut[ii], (const float*)&pA[ii], (const float*)&pB[ii] );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMultiplyMatrices( float4x4 *pOut, const float4x4 *pA, const float4x4 &b, uint32_t count )
+{
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        MultiplyRows( (float*)&pOut[ii], (const float*)&pA[ii], (const float*)&b );
+    }
+}
+
+// pOut = x*m.r0 + y*m.r1 + z*m.r2 (+ w*m.r3), for 'components' of 3 or 4 and w = 0 or 1
+//-----------------------------------------------------------------------------
+static inline void TransformArray( float *pOut, uint32_t outStride, const float *pIn, uint32_t inStride, uint32_t count, const float4x4 &m, uint32_t components, float w )
+{
+#if defined(CPUT_MATH_SSE)
+    __m128 m0 = _mm_loadu_ps( m.r0.f );
+    __m128 m1 = _mm_loadu_ps( m.r1.f );
+    __m128 m2 = _mm_loadu_ps( m.r2.f );
+    __m128 m3 = _mm_mul_ps( _mm_loadu_ps( m.r3.f ), _mm_set1_ps( w ) );
+    for( uint32_t ii=0; ii<count; ii++, pIn += inStride, pOut += outStride )
+    {
+        __m128 r = _mm_mul_ps( _mm_set1_ps( pIn[0] ), m0 );
+        r = _mm_add_ps( r, _mm_mul_ps( _mm_set1_ps( pIn[1] ), m1 ) );
+        r = _mm_add_ps( r, _mm_mul_ps( _mm_set1_ps( pIn[2] ), m2 ) );
+        if( 4 == components )
+        {
+            r = _mm_add_ps( r, _mm_mul_ps( _mm_set1_ps( pIn[3] ), m3 ) );
+            _mm_storeu_ps( pOut, r );
+        }
+        else
+        {
+            r = _mm_add_ps( r, m3 );
+            _mm_storel_pi( (__m64*)pOut, r );
+            _mm_store_ss( pOut + 2, _mm_movehl_ps( r, r ) );
+        }
+    }
+#elif defined(CPUT_MATH_NEON)
+    float32x4_t m0 = vld1q_f32( m.r0.f );
+    float32x4_t m1 = vld1q_f32( m.r1.f );
+    float32x4_t m2 = vld1q_f32( m.r2.f );
+    float32x4_t m3 = vmulq_n_f32( vld1q_f32( m.r3.f ), w );
+    for( uint32_t ii=0; ii<count; ii++, pIn += inStride, pOut += outStride )
+    {
+        float32x4_t r = vmulq_n_f32( m0, pIn[0] );
+        r = vaddq_f32( r, vmulq_n_f32( m1, pIn[1] ) );
+        r = vaddq_f32( r, vmulq_n_f32( m2, pIn[2] ) );
+        if( 4 == components )
+        {
+            r = vaddq_f32( r, vmulq_n_f32( m3, pIn[3] ) );
+            vst1q_f32( pOut, r );
+        }
+        else
+        {
+            r = vaddq_f32( r, m3 );
+            vst1_f32( pOut, vget_low_f32( r ) );
+            vst1q_lane_f32( pOut + 2, r, 2 );
+        }
+    }
+#else
+    for( uint32_t ii=0; ii<count; ii++, pIn += inStride, pOut += outStride )
+    {
+        float x = pIn[0], y = pIn[1], z = pIn[2];
+        float s = (4 == components) ? pIn[3] : 1.0f;
+        for( uint32_t jj=0; jj<components; jj++ )
+        {
+            pOut[jj] = x*m.r0.f[jj] + y*m.r1.f[jj] + z*m.r2.f[jj] + s*(m.r3.f[jj]*w);
+        }
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformPoints( float3 *pOut, const float3 *pIn, uint32_t count, const float4x4 &m )
+{
+    TransformArray( &pOut->x, 3, &pIn->x, 3, count, m, 3, 1.0f );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformVectors( float3 *pOut, const float3 *pIn, uint32_t count, const float4x4 &m )
+{
+    TransformArray( &pOut->x, 3, &pIn->x, 3, count, m, 3, 0.0f );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformFloat4s( float4 *pOut, const float4 *pIn, uint32_t count, const float4x4 &m )
+{
+    TransformArray( pOut->f, 4, pIn->f, 4, count, m, 4, 1.0f );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTNormalizeVectors( float3 *pOut, const float3 *pIn, uint32_t count )
+{
+    uint32_t ii = 0;
+#if defined(CPUT_MATH_SSE)
+    // Four vectors at a time: transpose 12 floats to x, y and z registers
+    for( ; ii+4<=count; ii+=4 )
+    {
+        const float *pSrc = &pIn[ii].x;
+        __m128 a = _mm_loadu_ps( pSrc + 0 );  // x0 y0 z0 x1
+        __m128 b = _mm_loadu_ps( pSrc + 4 );  // y1 z1 x2 y2
+        __m128 c = _mm_loadu_ps( pSrc + 8 );  // z2 x3 y3 z3
+        __m128 x = _mm_shuffle_ps( a, _mm_shuffle_ps( b, c, _MM_SHUFFLE(1,1,2,2) ), _MM_SHUFFLE(2,0,3,0) );
+        __m128 y = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE(0,0,1,1) ), _mm_shuffle_ps( b, c, _MM_SHUFFLE(2,2,3,3) ), _MM_SHUFFLE(2,0,2,0) );
+        __m128 z = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE(1,1,2,2) ), _mm_shuffle_ps( c, c, _MM_SHUFFLE(3,3,0,0) ), _MM_SHUFFLE(2,0,2,0) );
+        __m128 length = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) ) );
+        x = _mm_div_ps( x, length );
+        y = _mm_div_ps( y, length );
+        z = _mm_div_ps( z, length );
+
+        // And back
+        __m128 xy01 = _mm_unpacklo_ps( x, y );                                   // x0 y0 x1 y1
+        __m128 xy23 = _mm_unpackhi_ps( x, y );                                   // x2 y2 x3 y3
+        float *pDst = &pOut[ii].x;
+        _mm_storeu_ps( pDst + 0, _mm_shuffle_ps( xy01, _mm_shuffle_ps( z, xy01, _MM_SHUFFLE(2,2,0,0) ), _MM_SHUFFLE(2,0,1,0) ) );  // x0 y0 z0 x1
+        _mm_storeu_ps( pDst + 4, _mm_shuffle_ps( _mm_shuffle_ps( xy01, z, _MM_SHUFFLE(1,1,3,3) ), xy23, _MM_SHUFFLE(1,0,2,0) ) ); // y1 z1 x2 y2
+        _mm_storeu_ps( pDst + 8, _mm_shuffle_ps( _mm_shuffle_ps( z, xy23, _MM_SHUFFLE(2,2,2,2) ), _mm_shuffle_ps( xy23, z, _MM_SHUFFLE(3,3,3,3) ), _MM_SHUFFLE(2,0,2,0) ) ); // z2 x3 y3 z3
+    }
+#elif defined(CPUT_MATH_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    // (32-bit NEON has no vector square root or divide that matches sqrtf and '/')
+    for( ; ii+4<=count; ii+=4 )
+    {
+        float32x4x3_t v = vld3q_f32( &pIn[ii].x );
+        float32x4_t length = vsqrtq_f32( vaddq_f32( vaddq_f32( vmulq_f32( v.val[0], v.val[0] ), vmulq_f32( v.val[1], v.val[1] ) ), vmulq_f32( v.val[2], v.val[2] ) ) );
+        v.val[0] = vdivq_f32( v.val[0], length );
+        v.val[1] = vdivq_f32( v.val[1], length );
+        v.val[2] = vdivq_f32( v.val[2], length );
+        vst3q_f32( &pOut[ii].x, v );
+    }
+#endif
+    for( ; ii<count; ii++ )
+    {
+        pOut[ii] = normalize( pIn[ii] );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformBoxes( float3 *pCenterOut, float3 *pHalfOut, const float3 *pCenter, const float3 *pHalf, uint32_t count, const float4x4 &m )
+{
+    // The extent along each world axis is the sum of the half extents' absolute
+    // contributions to it, i.e. half * |m| without the translation.
+    float4x4 absolute( float4( fabsf(m.r0.x), fabsf(m.r0.y), fabsf(m.r0.z), 0.0f ),
+                       float4( fabsf(m.r1.x), fabsf(m.r1.y), fabsf(m.r1.z), 0.0f ),
+                       float4( fabsf(m.r2.x), fabsf(m.r2.y), fabsf(m.r2.z), 0.0f ),
+                       float4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+    TransformArray( &pHalfOut->x, 3, &pHalf->x, 3, count, absolute, 3, 0.0f );
+    TransformArray( &pCenterOut->x, 3, &pCenter->x, 3, count, m, 3, 1.0f );
+}
@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMATHBATCH_H__
+#define __CPUTMATHBATCH_H__
+
+// Array versions of the CPUTMath operations that culling, animation and transform
+// propagation run over many objects a frame.  They use the SIMD backend CPUTMath.h
+// selects (SSE, plus AVX where it helps, or NEON; scalar with CPUT_MATH_NO_SIMD) and do
+// the same multiplies and adds, in the same order, as the float4x4 operators, so the
+// results are identical unless the compiler fuses multiply-adds.
+//
+// Matrices use the row-vector convention: a point p transformed by m is float4(p,1) * m.
+// Outputs may be the inputs (in place) except where noted.
+#include "CPUTMath.h"
+#include <stdint.h>
+
+// out = a * b.  out must not alias a or b.
+void CPUTMultiplyMatrix4x4( float4x4 *pOut, const float4x4 &a, const float4x4 &b );
+
+// pOut[ii] = pA[ii] * pB[ii].  pOut may be pA, but not pB.
+void CPUTMultiplyMatrices( float4x4 *pOut, const float4x4 *pA, const float4x4 *pB, uint32_t count );
+
+// pOut[ii] = pA[ii] * b (e.g. every child of one parent).  b must not be in pOut.
+void CPUTMultiplyMatrices( float4x4 *pOut, const float4x4 *pA, const float4x4 &b, uint32_t count );
+
+// Points (w = 1; no divide by the result's w), directions (w = 0) and float4s
+void CPUTTransformPoints( float3 *pOut, const float3 *pIn, uint32_t count, const float4x4 &m );
+void CPUTTransformVectors( float3 *pOut, const float3 *pIn, uint32_t count, const float4x4 &m );
+void CPUTTransformFloat4s( float4 *pOut, const float4 *pIn, uint32_t count, const float4x4 &m );
+
+// pOut[ii] = normalize(pIn[ii])
+void CPUTNormalizeVectors( float3 *pOut, const float3 *pIn, uint32_t count );
+
+// World-space bounds (center and half extents) of object-space boxes moved by an affine
+// m.  Same box as transforming the eight corners and taking their min and max, to within
+// rounding.
+void CPUTTransformBoxes( float3 *pCenterOut, float3 *pHalfOut, const float3 *pCenter, const float3 *pHalf, uint32_t count, const float4x4 &m );
+
+#endif // __CPUTMATHBATCH_H__
@@ -40,7 +40,7 @@ void CPUTRawMeshData::Allocate(__int32 numElements)
     mVertexCount = numElements;
     mStride += mPaddingSize; // TODO: move this to stride computation
     mTotalVerticesSizeInBytes = mVertexCount * mStride;
-    mpVertices = (void*)new char[(UINT)mTotalVerticesSizeInBytes];
+    mpVertices = mpArena ? mpArena->Allocate( (size_t)mTotalVerticesSizeInBytes ) : (void*)new char[(UINT)mTotalVerticesSizeInBytes];
     ::memset( mpVertices, 0, (size_t)mTotalVerticesSizeInBytes );
 }
 
@@ -65,7 +65,7 @@ bool CPUTRawMeshData::Read(std::ifstream &modelFile)
     modelFile.read((char*)&mFormatDescriptorCount, sizeof(mFormatDescriptorCount));
     ASSERT( modelFile.good(), _L("Model file bad" ) );
 
-    mpElements = new CPUTVertexElementDesc[mFormatDescriptorCount];
+    mpElements = mpArena ? mpArena->AllocateArray<CPUTVertexElementDesc>( mFormatDescriptorCount ) : new CPUTVertexElementDesc[mFormatDescriptorCount];
     for( UINT ii=0; ii<mFormatDescriptorCount; ++ii )
     {
         mpElements[ii].Read(modelFile);
@@ -74,7 +74,7 @@ bool CPUTRawMeshData::Read(std::ifstream &modelFile)
     modelFile.read((char*)&mIndexType, sizeof(mIndexType));
     ASSERT( modelFile.good(), _L("Bad model file(1)." ) );
 
-    mpIndices = new UINT[mIndexCount];
+    mpIndices = mpArena ? mpArena->AllocateArray<UINT>( mIndexCount ) : new UINT[mIndexCount];
     if( mIndexCount != 0 )
     {
         modelFile.read((char*)mpIndices, mIndexCount * sizeof(UINT));
@@ -93,3 +93,135 @@ bool CPUTRawMeshData::Read(std::ifstream &modelFile)
 
     return modelFile.good();
 }
+
+//-----------------------------------------------------------------------------
+void CPUTVertexElementDesc::Write(std::ofstream &meshFile)
+{
+    meshFile.write((const char*)this, sizeof(*this));
+}
+
+// Writes the mesh as Read() reads it
+//-----------------------------------------------------------------------------
+bool CPUTRawMeshData::Write(std::ofstream &modelFile)
+{
+    const unsigned __int32 magicCookie = 1234;
+    UINT stride = mStride - mPaddingSize; // Read() adds the padding back
+
+    modelFile.write((const char*)&magicCookie,               sizeof(magicCookie));
+    modelFile.write((const char*)&stride,                    sizeof(stride));
+    modelFile.write((const char*)&mPaddingSize,              sizeof(mPaddingSize));
+    modelFile.write((const char*)&mTotalVerticesSizeInBytes, sizeof(mTotalVerticesSizeInBytes));
+    modelFile.write((const char*)&mVertexCount,              sizeof(mVertexCount));
+    modelFile.write((const char*)&mTopology,                 sizeof(mTopology));
+    modelFile.write((const char*)&mBboxCenter,               sizeof(mBboxCenter));
+    modelFile.write((const char*)&mBboxHalf,                 sizeof(mBboxHalf));
+
+    modelFile.write((const char*)&mFormatDescriptorCount, sizeof(mFormatDescriptorCount));
+    for( UINT ii=0; ii<mFormatDescriptorCount; ++ii )
+    {
+        mpElements[ii].Write(modelFile);
+    }
+    modelFile.write((const char*)&mIndexCount, sizeof(mIndexCount));
+    modelFile.write((const char*)&mIndexType, sizeof(mIndexType));
+    if( mIndexCount != 0 )
+    {
+        modelFile.write((const char*)mpIndices, mIndexCount * sizeof(UINT));
+    }
+    modelFile.write((const char*)&magicCookie, sizeof(magicCookie));
+
+    if ( 0 != mTotalVerticesSizeInBytes )
+    {
+        modelFile.write((const char*)mpVertices, mTotalVerticesSizeInBytes);
+    }
+    modelFile.write((const char*)&magicCookie, sizeof(magicCookie));
+
+    return modelFile.good();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRawMeshData::Optimize(const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats)
+{
+    // Models are always drawn as triangle lists (see CPUTModel::LoadModelPayload())
+    if( !mVertexCount || !mpVertices || mIndexCount < 3 || 0 != mIndexCount % 3 )
+    {
+        return;
+    }
+
+    // 16-bit indices are packed at the start of the index block.  The optimizer takes
+    // 32-bit ones: widen them in place, from the back.
+    if( tUINT32 != mIndexType )
+    {
+        const USHORT *pIndices16 = (const USHORT*)mpIndices;
+        for( UINT ii=mIndexCount; ii-- > 0; )
+        {
+            mpIndices[ii] = pIndices16[ii];
+        }
+    }
+
+    std::vector<CPUTMeshAttribute> attributes( mFormatDescriptorCount );
+    UINT offset = 0;
+    for( UINT ii=0; ii<mFormatDescriptorCount; ii++ )
+    {
+        const CPUTVertexElementDesc &element = mpElements[ii];
+        CPUTMeshAttribute &attribute = attributes[ii];
+        switch( element.mVertexElementSemantic )
+        {
+        case CPUT_VERTEX_ELEMENT_POSITON:      attribute.mKind = CPUT_MESH_ATTRIBUTE_POSITION;  break;
+        case CPUT_VERTEX_ELEMENT_NORMAL:
+        case CPUT_VERTEX_ELEMENT_TANGENT:
+        case CPUT_VERTEX_ELEMENT_BINORMAL:     attribute.mKind = CPUT_MESH_ATTRIBUTE_DIRECTION; break;
+        case CPUT_VERTEX_ELEMENT_TEXTURECOORD: attribute.mKind = CPUT_MESH_ATTRIBUTE_TEXCOORD;  break;
+        default:                               attribute.mKind = CPUT_MESH_ATTRIBUTE_OTHER;     break;
+        }
+        attribute.mSize = element.mElementSizeInBytes;
+        switch( element.mVertexElementType )
+        {
+        case tFLOAT:   attribute.mFormat = CPUT_MESH_FORMAT_FLOAT;   attribute.mComponents = attribute.mSize / 4; break;
+        case tFLOAT16: attribute.mFormat = CPUT_MESH_FORMAT_HALF;    attribute.mComponents = attribute.mSize / 2; break;
+        case tSNORM16: attribute.mFormat = CPUT_MESH_FORMAT_SNORM16; attribute.mComponents = attribute.mSize / 2; break;
+        case tSNORM8:  attribute.mFormat = CPUT_MESH_FORMAT_SNORM8;  attribute.mComponents = attribute.mSize;     break;
+        default:       attribute.mFormat = CPUT_MESH_FORMAT_RAW;     attribute.mComponents = attribute.mSize;     break;
+        }
+        // Packed in order, as LoadModelPayload() assumes
+        attribute.mOffset = offset;
+        offset += attribute.mSize;
+    }
+
+    CPUTMeshOptimizerMesh mesh;
+    mesh.mpVertices      = mpVertices;
+    mesh.mVertexCount    = mVertexCount;
+    mesh.mStride         = mStride;
+    mesh.mpIndices       = mpIndices;
+    mesh.mIndexCount     = mIndexCount;
+    mesh.mpAttributes    = &attributes[0];
+    mesh.mAttributeCount = mFormatDescriptorCount;
+    CPUTOptimizeMesh( &mesh, settings, pStats );
+
+    for( UINT ii=0; ii<mFormatDescriptorCount; ii++ )
+    {
+        CPUTVertexElementDesc &element = mpElements[ii];
+        switch( attributes[ii].mFormat )
+        {
+        case CPUT_MESH_FORMAT_FLOAT:   element.mVertexElementType = tFLOAT;   break;
+        case CPUT_MESH_FORMAT_HALF:    element.mVertexElementType = tFLOAT16; break;
+        case CPUT_MESH_FORMAT_SNORM16: element.mVertexElementType = tSNORM16; break;
+        case CPUT_MESH_FORMAT_SNORM8:  element.mVertexElementType = tSNORM8;  break;
+        default:                       break;
+        }
+        element.mElementSizeInBytes = attributes[ii].mSize;
+        element.mOffset             = attributes[ii].mOffset;
+    }
+    mVertexCount              = mesh.mVertexCount;
+    mStride                   = mesh.mStride;
+    mPaddingSize              = 0; // Now part of the stride, or dropped with the float attributes
+    mTotalVerticesSizeInBytes = (unsigned __int64)mVertexCount * mStride;
+
+    if( tUINT32 != mIndexType )
+    {
+        USHORT *pIndices16 = (USHORT*)mpIndices;
+        for( UINT ii=0; ii<mIndexCount; ii++ )
+        {
+            pIndices16[ii] = (USHORT)mpIndices[ii];
+        }
+    }
+}
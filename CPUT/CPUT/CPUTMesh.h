@@ -19,6 +19,7 @@
 #include "CPUTRefCount.h"
 #include <fstream>
 #include "CPUT.h"
+#include "CPUTMeshOptimizer.h"
 
 class CPUTRenderParameters;
 class CPUTMaterial;
@@ -61,6 +62,9 @@ enum eCPUT_VERTEX_ELEMENT_TYPE : UINT
     tWCHAR,     // 13 wchar_t  = 2 bytes
     tFLOAT,     // 14 float  = 4 bytes
     tDOUBLE,    // 15 double  = 8 bytes
+    tFLOAT16,   // 16 half = 2 bytes
+    tSNORM16,   // 17 signed normalized __int16 = 2 bytes
+    tSNORM8,    // 18 signed normalized __int8 = 1 byte
 
     // add new ones here
     tINVALID = 255
@@ -87,6 +91,9 @@ const CPUT_DATA_FORMAT_TYPE CPUT_FILE_ELEMENT_TYPE_TO_CPUT_TYPE_CONVERT[] =
     CPUT_U16,       // 13 wchar_t  = 2 bytes
     CPUT_F32,       // 14 float  = 4 bytes
     CPUT_DOUBLE,    // 15 double  = 8 bytes     
+    CPUT_F16,       // 16 half = 2 bytes
+    CPUT_SNORM16,   // 17 signed normalized __int16 = 2 bytes
+    CPUT_SNORM8,    // 18 signed normalized __int8 = 1 byte
 };
 
 //-----------------------------------------------------------------------------
@@ -110,6 +117,7 @@ struct CPUTVertexElementDesc
     UINT                          mOffset;   // what is the offset within the vertex data
 
     void Read(std::ifstream &meshFile);
+    void Write(std::ofstream &meshFile);
 };
 
 //-----------------------------------------------------------------------------
@@ -128,8 +136,11 @@ struct CPUTRawMeshData
     float3                     mBboxHalf;
     eCPUT_VERTEX_ELEMENT_TYPE  mIndexType;
     UINT                       mPaddingSize;
+    CPUTArena                 *mpArena; // Holds the arrays, if set.  Otherwise they're on the heap.
 
-    CPUTRawMeshData():
+    // Put the arrays in pArena (e.g., CPUTAssetLibrary::GetLoadArena() in a CPUTArenaScope) when
+    // they're only needed until the mesh's buffers are created
+    CPUTRawMeshData( CPUTArena *pArena = NULL ):
         mStride(0),
         mVertexCount(0),
         mpVertices(NULL),
@@ -142,17 +153,25 @@ struct CPUTRawMeshData
         mBboxCenter(0.0f),
         mIndexType(tUINT32),
         mBboxHalf(0.0f),
-        mPaddingSize(0)
+        mPaddingSize(0),
+        mpArena(pArena)
     {
     }
     ~CPUTRawMeshData()
     {
-        delete[] mpVertices;
-        delete[] mpElements;
-        delete[] mpIndices;
+        if( !mpArena )
+        {
+            delete[] (char*)mpVertices;
+            delete[] mpElements;
+            delete[] mpIndices;
+        }
     }
     void Allocate(__int32 numElements);
     bool Read(std::ifstream &mdlfile);
+    bool Write(std::ofstream &mdlfile);
+
+    // Reorders the triangles and vertices, and quantizes the vertices, in place (see CPUTMeshOptimizer.h)
+    void Optimize(const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats);
 };
 
 //-----------------------------------------------------------------------------
@@ -174,9 +193,10 @@ class CPUTMesh : public CPUTRefCount
 protected:
     eCPUT_MESH_TOPOLOGY mMeshTopology;
 	UINT mInstanceCount;
+    UINT mSortId; // CPUT_SORT_FIELD_MESH id, for meshes that can be drawn instanced
 
 public:
-    CPUTMesh() : mInstanceCount(1) {}
+    CPUTMesh() : mInstanceCount(1), mSortId(0) {}
     virtual ~CPUTMesh(){}
     // TODO: ? Change from virtual to #ifdef-controlled redirect to platform versions?
     // TODO: Use CPUT_MAPPED_SUBRESOURCE ??
@@ -199,6 +219,12 @@ public:
 
     virtual void Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel) = 0;
     virtual void DrawShadow(CPUTRenderParameters &renderParams, CPUTModel *pModel) = 0;
+
+    // Instanced drawing (see CPUTRenderQueue).  The caller binds the instance data to CPUT_INSTANCE_DATA_SLOT.
+    virtual bool SupportsInstancing(bool shadow) { return false; }
+    virtual void DrawInstanced(CPUTRenderParameters &renderParams, CPUTModel *pModel, UINT instanceCount, UINT firstInstance) {}
+    virtual void DrawShadowInstanced(CPUTRenderParameters &renderParams, CPUTModel *pModel, UINT instanceCount, UINT firstInstance) {}
+    UINT GetSortId() const { return mSortId; }
 	void IncrementInstanceCount() { mInstanceCount++; }
 	void DecrementInstanceCount() { mInstanceCount--; }
 };
@@ -18,6 +18,7 @@
 #include "CPUTMaterialDX11.h"
 #include "CPUTRenderParamsDX.h"
 #include "CPUTBufferDX11.h"
+#include "CPUTRenderQueue.h"
 
 //-----------------------------------------------------------------------------
 CPUTMeshDX11::CPUTMeshDX11():
@@ -37,9 +38,13 @@ CPUTMeshDX11::CPUTMeshDX11():
     mpStagingIndexBuffer(NULL),
     mpInputLayout(NULL),
     mpShadowInputLayout(NULL),
+    mpInstancedInputLayout(NULL),
+    mpShadowInstancedInputLayout(NULL),
     mNumberOfInputLayoutElements(0),
-    mpLayoutDescription(NULL)
+    mpLayoutDescription(NULL),
+    mLayoutHash(0)
 {
+    mSortId = CPUTRenderQueue::GetSortId( CPUT_SORT_FIELD_MESH, this );
 }
 
 //-----------------------------------------------------------------------------
@@ -60,6 +65,8 @@ void CPUTMeshDX11::ClearAllObjects()
     SAFE_RELEASE(mpVertexView);
     SAFE_RELEASE(mpInputLayout);
     SAFE_RELEASE(mpShadowInputLayout);
+    SAFE_RELEASE(mpInstancedInputLayout);
+    SAFE_RELEASE(mpShadowInstancedInputLayout);
 
     SAFE_DELETE_ARRAY(mpLayoutDescription);
 }
@@ -176,6 +183,7 @@ CPUTResult CPUTMeshDX11::CreateNativeResources(
     }
     // set the last 'dummy' element to null.  Not sure if this is required, as we also pass in count when using this list.
     memset( &mpLayoutDescription[vertexDataInfoArraySize], 0, sizeof(D3D11_INPUT_ELEMENT_DESC) );
+    mLayoutHash = CPUTInputLayoutCacheDX11::HashLayout( mpLayoutDescription );
 
     return result;
 }
@@ -190,15 +198,33 @@ void CPUTMeshDX11::Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel, I
 #ifdef CPUT_GPA_INSTRUMENTATION
     CPUTPerfTaskMarker marker = CPUTPerfTaskMarker(D3DCOLOR(0xff0000), _L("CPUT Draw Mesh"));
 #endif
-    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
-    pContext->IASetPrimitiveTopology( mD3DMeshTopology );
-    pContext->IASetVertexBuffers(0, 1, &mpVertexBuffer, &mVertexStride, &mVertexBufferOffset);
-    pContext->IASetIndexBuffer(mpIndexBuffer, mIndexBufferFormat, 0);
+    pBackend->SetPrimitiveTopology( mD3DMeshTopology );
+    pBackend->SetVertexBuffer( 0, mpVertexBuffer, mVertexStride, mVertexBufferOffset );
+    pBackend->SetIndexBuffer( mpIndexBuffer, mIndexBufferFormat, 0 );
 
-    pContext->IASetInputLayout( pInputLayout );
+    pBackend->SetInputLayout( pInputLayout );
 
-    pContext->DrawIndexed( mIndexCount, 0, 0 );
+    pBackend->DrawIndexed( mIndexCount, 0, 0 );
+}
+
+// Draws instanceCount copies of the mesh.  The caller binds the CPUTInstanceData stream
+// to CPUT_INSTANCE_DATA_SLOT.
+//-----------------------------------------------------------------------------
+void CPUTMeshDX11::DrawInstanced(CPUTRenderParameters &renderParams, ID3D11InputLayout *pInputLayout, UINT instanceCount, UINT firstInstance )
+{
+    if( !mIndexCount || !pInputLayout ) { return; }
+
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
+
+    pBackend->SetPrimitiveTopology( mD3DMeshTopology );
+    pBackend->SetVertexBuffer( 0, mpVertexBuffer, mVertexStride, mVertexBufferOffset );
+    pBackend->SetIndexBuffer( mpIndexBuffer, mIndexBufferFormat, 0 );
+
+    pBackend->SetInputLayout( pInputLayout );
+
+    pBackend->DrawIndexedInstanced( mIndexCount, instanceCount, 0, 0, firstInstance );
 }
 
 // Sets the mesh topology, and converts it to it's DX format
@@ -250,6 +276,39 @@ DXGI_FORMAT CPUTMeshDX11::ConvertToDirectXFormat(CPUT_DATA_FORMAT_TYPE dataForma
         };
         return componentCountToFormat[componentCount-1];
     }
+    case CPUT_F16:
+    {
+        ASSERT( 3 != componentCount, _L("Invalid vertex element count.") );
+        const DXGI_FORMAT componentCountToFormat[4] = {
+            DXGI_FORMAT_R16_FLOAT,
+            DXGI_FORMAT_R16G16_FLOAT,
+            DXGI_FORMAT_UNKNOWN, // Count of 3 is invalid for 16-bit type
+            DXGI_FORMAT_R16G16B16A16_FLOAT
+        };
+        return componentCountToFormat[componentCount-1];
+    }
+    case CPUT_SNORM16:
+    {
+        ASSERT( 3 != componentCount, _L("Invalid vertex element count.") );
+        const DXGI_FORMAT componentCountToFormat[4] = {
+            DXGI_FORMAT_R16_SNORM,
+            DXGI_FORMAT_R16G16_SNORM,
+            DXGI_FORMAT_UNKNOWN, // Count of 3 is invalid for 16-bit type
+            DXGI_FORMAT_R16G16B16A16_SNORM
+        };
+        return componentCountToFormat[componentCount-1];
+    }
+    case CPUT_SNORM8:
+    {
+        ASSERT( 3 != componentCount, _L("Invalid vertex element count.") );
+        const DXGI_FORMAT componentCountToFormat[4] = {
+            DXGI_FORMAT_R8_SNORM,
+            DXGI_FORMAT_R8G8_SNORM,
+            DXGI_FORMAT_UNKNOWN, // Count of 3 is invalid for 8-bit type
+            DXGI_FORMAT_R8G8B8A8_SNORM
+        };
+        return componentCountToFormat[componentCount-1];
+    }
     default:
     {
         // todo: add all the other data types you want to support
@@ -265,6 +324,34 @@ DXGI_FORMAT CPUTMeshDX11::ConvertToDirectXFormat(CPUT_DATA_FORMAT_TYPE dataForma
 void CPUTMeshDX11::BindVertexShaderLayout( CPUTMaterial *pMaterial, CPUTMaterial *pShadowCastMaterial )
 {
     ID3D11Device *pDevice = CPUT_DX11::GetDevice();
+    CPUTInputLayoutCacheDX11 *pCache = CPUTInputLayoutCacheDX11::GetInputLayoutCache();
+
+    // The instanced layouts append the CPUTInstanceData matrices (12 float4 rows,
+    // semantic INSTANCE0..11) as a per-instance stream.  Only built if a material has
+    // an instanced vertex shader.
+    CPUTVertexShaderDX11 *pInstancedVertexShader       = pMaterial           ? ((CPUTMaterialDX11*)pMaterial)->GetInstancedVertexShader()           : NULL;
+    CPUTVertexShaderDX11 *pShadowInstancedVertexShader = pShadowCastMaterial ? ((CPUTMaterialDX11*)pShadowCastMaterial)->GetInstancedVertexShader() : NULL;
+    D3D11_INPUT_ELEMENT_DESC *pInstancedLayout = NULL;
+    uint64_t instancedLayoutHash = 0;
+    if( pInstancedVertexShader || pShadowInstancedVertexShader )
+    {
+        const int instanceElementCount = sizeof(CPUTInstanceData) / (4*sizeof(float));
+        pInstancedLayout = new D3D11_INPUT_ELEMENT_DESC[mNumberOfInputLayoutElements + instanceElementCount + 1];
+        memcpy( pInstancedLayout, mpLayoutDescription, mNumberOfInputLayoutElements * sizeof(D3D11_INPUT_ELEMENT_DESC) );
+        for( int ii=0; ii<instanceElementCount; ii++ )
+        {
+            D3D11_INPUT_ELEMENT_DESC &element = pInstancedLayout[mNumberOfInputLayoutElements + ii];
+            element.SemanticName         = "INSTANCE";
+            element.SemanticIndex        = ii;
+            element.Format               = DXGI_FORMAT_R32G32B32A32_FLOAT;
+            element.InputSlot            = CPUT_INSTANCE_DATA_SLOT;
+            element.AlignedByteOffset    = ii * 4 * sizeof(float);
+            element.InputSlotClass       = D3D11_INPUT_PER_INSTANCE_DATA;
+            element.InstanceDataStepRate = 1;
+        }
+        memset( &pInstancedLayout[mNumberOfInputLayoutElements + instanceElementCount], 0, sizeof(D3D11_INPUT_ELEMENT_DESC) );
+        instancedLayoutHash = CPUTInputLayoutCacheDX11::HashLayout( pInstancedLayout );
+    }
 
     if( pMaterial )
     {
@@ -272,14 +359,27 @@ void CPUTMeshDX11::BindVertexShaderLayout( CPUTMaterial *pMaterial, CPUTMaterial
         // If already exists, then GetLayout() returns the existing layout for reuse.
         CPUTVertexShaderDX11 *pVertexShader = ((CPUTMaterialDX11*)pMaterial)->GetVertexShader();
 	    SAFE_RELEASE(mpInputLayout);
-        CPUTInputLayoutCacheDX11::GetInputLayoutCache()->GetLayout(pDevice, mpLayoutDescription, pVertexShader, &mpInputLayout);
+        pCache->GetLayout(pDevice, mpLayoutDescription, mLayoutHash, pVertexShader, &mpInputLayout);
+
+        SAFE_RELEASE(mpInstancedInputLayout);
+        if( pInstancedVertexShader )
+        {
+            pCache->GetLayout(pDevice, pInstancedLayout, instancedLayoutHash, pInstancedVertexShader, &mpInstancedInputLayout);
+        }
     }
     if( pShadowCastMaterial )
     {
         CPUTVertexShaderDX11 *pVertexShader = ((CPUTMaterialDX11*)pShadowCastMaterial)->GetVertexShader();
 	    SAFE_RELEASE(mpShadowInputLayout);
-        CPUTInputLayoutCacheDX11::GetInputLayoutCache()->GetLayout(pDevice, mpLayoutDescription, pVertexShader, &mpShadowInputLayout);
+        pCache->GetLayout(pDevice, mpLayoutDescription, mLayoutHash, pVertexShader, &mpShadowInputLayout);
+
+        SAFE_RELEASE(mpShadowInstancedInputLayout);
+        if( pShadowInstancedVertexShader )
+        {
+            pCache->GetLayout(pDevice, pInstancedLayout, instancedLayoutHash, pShadowInstancedVertexShader, &mpShadowInstancedInputLayout);
+        }
     }
+    SAFE_DELETE_ARRAY( pInstancedLayout );
 }
 
 //-----------------------------------------------------------------------------
@@ -36,8 +36,11 @@ class CPUTMeshDX11 : public CPUTMesh
     D3D_PRIMITIVE_TOPOLOGY    mD3DMeshTopology;
     D3D11_INPUT_ELEMENT_DESC *mpLayoutDescription;
     int                       mNumberOfInputLayoutElements;
+    uint64_t                  mLayoutHash; // CPUTInputLayoutCacheDX11::HashLayout( mpLayoutDescription )
     ID3D11InputLayout        *mpInputLayout;
     ID3D11InputLayout        *mpShadowInputLayout;
+    ID3D11InputLayout        *mpInstancedInputLayout;       // Mesh stream + CPUTInstanceData stream.  NULL unless the material has an instanced vertex shader.
+    ID3D11InputLayout        *mpShadowInstancedInputLayout;
     UINT                      mVertexStride;
 
     D3D11_BUFFER_DESC         mVertexBufferDesc;
@@ -71,6 +74,10 @@ public:
     void                      Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel)       { Draw(renderParams, pModel, mpInputLayout);}
     void                      DrawShadow(CPUTRenderParameters &renderParams, CPUTModel *pModel) { Draw(renderParams, pModel, mpShadowInputLayout);}
     void                      Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel, ID3D11InputLayout *pLayout);
+    bool                      SupportsInstancing(bool shadow) { return NULL != (shadow ? mpShadowInstancedInputLayout : mpInstancedInputLayout); }
+    void                      DrawInstanced(CPUTRenderParameters &renderParams, CPUTModel *pModel, UINT instanceCount, UINT firstInstance)       { DrawInstanced(renderParams, mpInstancedInputLayout, instanceCount, firstInstance); }
+    void                      DrawShadowInstanced(CPUTRenderParameters &renderParams, CPUTModel *pModel, UINT instanceCount, UINT firstInstance) { DrawInstanced(renderParams, mpShadowInstancedInputLayout, instanceCount, firstInstance); }
+    void                      DrawInstanced(CPUTRenderParameters &renderParams, ID3D11InputLayout *pLayout, UINT instanceCount, UINT firstInstance);
 
     D3D11_MAPPED_SUBRESOURCE  MapVertices(   CPUTRenderParameters &params, eCPUTMapType type, bool wait=true );
     D3D11_MAPPED_SUBRESOURCE  MapIndices(    CPUTRenderParameters &params, eCPUTMapType type, bool wait=true );
@@ -0,0 +1,848 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMeshOptimizer.h"
+#include <assert.h>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+#define CPUT_MESH_CACHE_SIZE            32      // LRU entries the vertex cache order is scored for
+#define CPUT_MESH_OVERDRAW_CACHE_SIZE   16      // FIFO entries the overdraw clusters are cut by
+#define CPUT_MESH_OVERDRAW_GRID         256     // Analysis raster size along each axis
+#define CPUT_MESH_FETCH_LINE_SIZE       64
+#define CPUT_MESH_FETCH_LINE_COUNT      2048    // A 128KB FIFO of cache lines
+
+static const uint32_t sUnused = 0xFFFFFFFF;
+
+//-----------------------------------------------------------------------------
+static inline const float *GetPosition( const void *pPositions, uint32_t stride, uint32_t vertex )
+{
+    return (const float*)((const char*)pPositions + (size_t)vertex * stride);
+}
+
+// A FIFO cache by timestamps: a vertex is cached if it was added within the last cacheSize
+// additions.  Adding cacheSize+1 to time empties it.  Returns the misses.
+//-----------------------------------------------------------------------------
+static inline uint32_t UpdateFIFO( const uint32_t *pTriangle, uint32_t cacheSize, uint32_t *pTimestamps, uint32_t &time )
+{
+    uint32_t misses = 0;
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        if( time - pTimestamps[pTriangle[ii]] > cacheSize )
+        {
+            pTimestamps[pTriangle[ii]] = time++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+//-----------------------------------------------------------------------------
+CPUTMeshOptimizerStats::CPUTMeshOptimizerStats()
+{
+    memset( this, 0, sizeof(*this) );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMeshOptimizerStats::Add( const CPUTMeshOptimizerStats &other )
+{
+    mMeshes                       += other.mMeshes;
+    mVerticesDropped              += other.mVerticesDropped;
+    mVertexBytesBefore            += other.mVertexBytesBefore;
+    mVertexBytesAfter             += other.mVertexBytesAfter;
+    mAttributesQuantized          += other.mAttributesQuantized;
+    mMaxDirectionError             = std::max( mMaxDirectionError, other.mMaxDirectionError );
+    mMaxTexCoordError              = std::max( mMaxTexCoordError,  other.mMaxTexCoordError );
+    mCacheBefore.mTriangles       += other.mCacheBefore.mTriangles;
+    mCacheBefore.mVertices        += other.mCacheBefore.mVertices;
+    mCacheBefore.mTransformed     += other.mCacheBefore.mTransformed;
+    mCacheAfter.mTriangles        += other.mCacheAfter.mTriangles;
+    mCacheAfter.mVertices         += other.mCacheAfter.mVertices;
+    mCacheAfter.mTransformed      += other.mCacheAfter.mTransformed;
+    mOverdrawBefore.mPixelsCovered += other.mOverdrawBefore.mPixelsCovered;
+    mOverdrawBefore.mPixelsShaded  += other.mOverdrawBefore.mPixelsShaded;
+    mOverdrawAfter.mPixelsCovered  += other.mOverdrawAfter.mPixelsCovered;
+    mOverdrawAfter.mPixelsShaded   += other.mOverdrawAfter.mPixelsShaded;
+    mFetchBefore.mBytesFetched    += other.mFetchBefore.mBytesFetched;
+    mFetchBefore.mBytesUsed       += other.mFetchBefore.mBytesUsed;
+    mFetchAfter.mBytesFetched     += other.mFetchAfter.mBytesFetched;
+    mFetchAfter.mBytesUsed        += other.mFetchAfter.mBytesUsed;
+}
+
+// Forsyth, "Linear-speed vertex cache optimisation".  Greedily emits the triangle with the
+// highest score, where a triangle's score is the sum of its vertices'.  A vertex scores
+// higher the more recently it was used, and the fewer triangles it has left, so lone
+// triangles get finished instead of stranded.  Only the triangles of vertices in the cache
+// change score, so only those are candidates for the next one.
+//-----------------------------------------------------------------------------
+void CPUTOptimizeVertexCache( uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount )
+{
+    assert( 0 == indexCount % 3 );
+    uint32_t triangleCount = indexCount / 3;
+    if( triangleCount < 2 )
+    {
+        return;
+    }
+
+    // Score tables: by position in the cache, and by triangles left (scores for more are tiny)
+    const uint32_t maxValence = 64;
+    float cacheScore[CPUT_MESH_CACHE_SIZE];
+    float valenceScore[maxValence];
+    for( uint32_t ii=0; ii<CPUT_MESH_CACHE_SIZE; ii++ )
+    {
+        // The last triangle's three vertices score the same, so the order they went in doesn't matter
+        cacheScore[ii] = ii < 3 ? 0.75f : powf( 1.0f - (float)(ii - 3) / (CPUT_MESH_CACHE_SIZE - 3), 1.5f );
+    }
+    valenceScore[0] = 0.0f;
+    for( uint32_t ii=1; ii<maxValence; ii++ )
+    {
+        valenceScore[ii] = 2.0f / sqrtf( (float)ii );
+    }
+
+    // Each vertex's triangles.  Emitted triangles are swapped past the end of the vertex's
+    // remaining ones.
+    std::vector<uint32_t> remaining( vertexCount, 0 );
+    for( uint32_t ii=0; ii<indexCount; ii++ )
+    {
+        assert( pIndices[ii] < vertexCount );
+        remaining[pIndices[ii]]++;
+    }
+    std::vector<uint32_t> first( vertexCount + 1, 0 );
+    for( uint32_t ii=0; ii<vertexCount; ii++ )
+    {
+        first[ii+1] = first[ii] + remaining[ii];
+    }
+    std::vector<uint32_t> triangles( indexCount );
+    std::vector<uint32_t> filled( first.begin(), first.end() - 1 );
+    for( uint32_t ii=0; ii<indexCount; ii++ )
+    {
+        triangles[filled[pIndices[ii]]++] = ii / 3;
+    }
+
+    std::vector<float>   vertexScore( vertexCount );
+    std::vector<int32_t> cachePosition( vertexCount, -1 );
+    for( uint32_t ii=0; ii<vertexCount; ii++ )
+    {
+        vertexScore[ii] = valenceScore[std::min( remaining[ii], maxValence - 1 )];
+    }
+    std::vector<float>   triangleScore( triangleCount );
+    std::vector<uint8_t> emitted( triangleCount, 0 );
+    uint32_t best = 0;
+    for( uint32_t ii=0; ii<triangleCount; ii++ )
+    {
+        const uint32_t *pTriangle = &pIndices[ii*3];
+        triangleScore[ii] = vertexScore[pTriangle[0]] + vertexScore[pTriangle[1]] + vertexScore[pTriangle[2]];
+        if( triangleScore[ii] > triangleScore[best] )
+        {
+            best = ii;
+        }
+    }
+
+    std::vector<uint32_t> output( indexCount );
+    uint32_t cache[CPUT_MESH_CACHE_SIZE + 3];
+    uint32_t newCache[CPUT_MESH_CACHE_SIZE + 3];
+    uint32_t cacheCount = 0;
+    uint32_t nextUnemitted = 0;
+    for( uint32_t out=0; out<triangleCount; out++ )
+    {
+        if( sUnused == best )
+        {
+            // Nothing in the cache has triangles left: start from the next one in the input
+            while( emitted[nextUnemitted] )
+            {
+                nextUnemitted++;
+            }
+            best = nextUnemitted;
+        }
+        const uint32_t *pTriangle = &pIndices[best*3];
+        output[out*3+0] = pTriangle[0];
+        output[out*3+1] = pTriangle[1];
+        output[out*3+2] = pTriangle[2];
+        emitted[best] = 1;
+
+        // Take it off its vertices' lists, and put its vertices at the front of the cache
+        uint32_t newCount = 0;
+        for( uint32_t ii=0; ii<3; ii++ )
+        {
+            uint32_t vertex = pTriangle[ii];
+            uint32_t *pList = &triangles[first[vertex]];
+            uint32_t *pFound = std::find( pList, pList + remaining[vertex], best );
+            assert( pFound != pList + remaining[vertex] );
+            std::swap( *pFound, pList[--remaining[vertex]] );
+            if( std::find( newCache, newCache + newCount, vertex ) == newCache + newCount )
+            {
+                newCache[newCount++] = vertex;
+            }
+        }
+        for( uint32_t ii=0; ii<cacheCount; ii++ )
+        {
+            if( cache[ii] != pTriangle[0] && cache[ii] != pTriangle[1] && cache[ii] != pTriangle[2] )
+            {
+                newCache[newCount++] = cache[ii];
+            }
+        }
+
+        // Rescore the vertices that moved (including those pushed out) and their triangles
+        for( uint32_t ii=0; ii<newCount; ii++ )
+        {
+            uint32_t vertex = newCache[ii];
+            cachePosition[vertex] = ii < CPUT_MESH_CACHE_SIZE ? (int32_t)ii : -1;
+            float score = 0.0f;
+            if( remaining[vertex] )
+            {
+                score = valenceScore[std::min( remaining[vertex], maxValence - 1 )];
+                if( cachePosition[vertex] >= 0 )
+                {
+                    score += cacheScore[cachePosition[vertex]];
+                }
+            }
+            float delta = score - vertexScore[vertex];
+            vertexScore[vertex] = score;
+            const uint32_t *pList = &triangles[first[vertex]];
+            for( uint32_t jj=0; jj<remaining[vertex]; jj++ )
+            {
+                triangleScore[pList[jj]] += delta;
+            }
+        }
+        cacheCount = std::min( newCount, (uint32_t)CPUT_MESH_CACHE_SIZE );
+        memcpy( cache, newCache, cacheCount * sizeof(uint32_t) );
+
+        best = sUnused;
+        float bestScore = -1.0f;
+        for( uint32_t ii=0; ii<cacheCount; ii++ )
+        {
+            const uint32_t *pList = &triangles[first[cache[ii]]];
+            for( uint32_t jj=0; jj<remaining[cache[ii]]; jj++ )
+            {
+                if( triangleScore[pList[jj]] > bestScore )
+                {
+                    bestScore = triangleScore[pList[jj]];
+                    best      = pList[jj];
+                }
+            }
+        }
+    }
+    memcpy( pIndices, &output[0], indexCount * sizeof(uint32_t) );
+}
+
+//-----------------------------------------------------------------------------
+struct CPUTMeshCluster
+{
+    uint32_t mFirst;        // Triangle
+    uint32_t mCount;
+    float    mSortKey;
+
+    bool operator<( const CPUTMeshCluster &other ) const { return mSortKey > other.mSortKey; }
+};
+
+// Cuts the triangle order into clusters that can be drawn in any order for little cache
+// cost, then sorts the clusters so the ones facing away from the mesh's center come first.
+// Those are the ones most likely to cover the others from any viewpoint.
+//-----------------------------------------------------------------------------
+void CPUTOptimizeOverdraw( uint32_t *pIndices, uint32_t indexCount, const void *pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold )
+{
+    assert( 0 == indexCount % 3 );
+    uint32_t triangleCount = indexCount / 3;
+    if( triangleCount < 2 )
+    {
+        return;
+    }
+    const uint32_t cacheSize = CPUT_MESH_OVERDRAW_CACHE_SIZE;
+    std::vector<uint32_t> timestamps( vertexCount, 0 );
+    uint32_t time = cacheSize + 1;
+
+    // Hard boundaries: a triangle none of whose vertices are cached starts a new patch of the
+    // mesh, so starting it later costs nothing
+    std::vector<uint32_t> hard;
+    for( uint32_t ii=0; ii<triangleCount; ii++ )
+    {
+        if( 3 == UpdateFIFO( &pIndices[ii*3], cacheSize, &timestamps[0], time ) || 0 == ii )
+        {
+            hard.push_back( ii );
+        }
+    }
+    hard.push_back( triangleCount );
+
+    // Soft boundaries: within each patch, cut wherever the triangles since the last cut,
+    // drawn from an empty cache, are within threshold of the patch's own ACMR
+    std::vector<uint32_t> cuts;
+    for( size_t hh=0; hh+1<hard.size(); hh++ )
+    {
+        uint32_t start = hard[hh];
+        uint32_t end   = hard[hh+1];
+        time += cacheSize + 1;
+        uint32_t misses = 0;
+        for( uint32_t ii=start; ii<end; ii++ )
+        {
+            misses += UpdateFIFO( &pIndices[ii*3], cacheSize, &timestamps[0], time );
+        }
+        float clusterThreshold = threshold * (float)misses / (float)(end - start);
+
+        cuts.push_back( start );
+        time += cacheSize + 1;
+        uint32_t runningMisses    = 0;
+        uint32_t runningTriangles = 0;
+        for( uint32_t ii=start; ii<end; ii++ )
+        {
+            runningMisses += UpdateFIFO( &pIndices[ii*3], cacheSize, &timestamps[0], time );
+            runningTriangles++;
+            if( (float)runningMisses <= clusterThreshold * runningTriangles )
+            {
+                cuts.push_back( ii + 1 );
+                time += cacheSize + 1;
+                runningMisses    = 0;
+                runningTriangles = 0;
+            }
+        }
+        // The triangles after the last cut didn't reach the target; they join the cluster before
+        // them (or, if there are none, the last cut is the patch's end)
+        if( cuts.back() != start )
+        {
+            cuts.pop_back();
+        }
+    }
+    cuts.push_back( triangleCount );
+
+    // The mesh's center, weighting vertices by use
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    for( uint32_t ii=0; ii<indexCount; ii++ )
+    {
+        const float *pPosition = GetPosition( pPositions, positionStride, pIndices[ii] );
+        center[0] += pPosition[0];
+        center[1] += pPosition[1];
+        center[2] += pPosition[2];
+    }
+    center[0] /= indexCount;
+    center[1] /= indexCount;
+    center[2] /= indexCount;
+
+    // Each cluster's key: how far its area-weighted centroid is out from the center, along its
+    // average normal
+    std::vector<CPUTMeshCluster> clusters( cuts.size() - 1 );
+    for( size_t cc=0; cc<clusters.size(); cc++ )
+    {
+        CPUTMeshCluster &cluster = clusters[cc];
+        cluster.mFirst = cuts[cc];
+        cluster.mCount = cuts[cc+1] - cuts[cc];
+        float centroid[3] = { 0.0f, 0.0f, 0.0f };
+        float normal[3]   = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for( uint32_t ii=cluster.mFirst; ii<cluster.mFirst + cluster.mCount; ii++ )
+        {
+            const float *p0 = GetPosition( pPositions, positionStride, pIndices[ii*3+0] );
+            const float *p1 = GetPosition( pPositions, positionStride, pIndices[ii*3+1] );
+            const float *p2 = GetPosition( pPositions, positionStride, pIndices[ii*3+2] );
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            // Clockwise front faces in a left-handed space (D3D's defaults) face along e1 x e2
+            float n[3]  = { e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0] };
+            float triangleArea = sqrtf( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+            for( uint32_t kk=0; kk<3; kk++ )
+            {
+                centroid[kk] += (p0[kk] + p1[kk] + p2[kk]) * (triangleArea / 3.0f);
+                normal[kk]   += n[kk];
+            }
+            area += triangleArea;
+        }
+        float normalLength = sqrtf( normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2] );
+        cluster.mSortKey = 0.0f;
+        if( area > 0.0f && normalLength > 0.0f )
+        {
+            for( uint32_t kk=0; kk<3; kk++ )
+            {
+                cluster.mSortKey += (centroid[kk] / area - center[kk]) * normal[kk] / normalLength;
+            }
+        }
+    }
+    std::stable_sort( clusters.begin(), clusters.end() );
+
+    std::vector<uint32_t> output( indexCount );
+    uint32_t out = 0;
+    for( size_t cc=0; cc<clusters.size(); cc++ )
+    {
+        memcpy( &output[out], &pIndices[clusters[cc].mFirst * 3], clusters[cc].mCount * 3 * sizeof(uint32_t) );
+        out += clusters[cc].mCount * 3;
+    }
+    assert( out == indexCount );
+    memcpy( pIndices, &output[0], indexCount * sizeof(uint32_t) );
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTOptimizeVertexFetch( void *pVertices, uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t stride )
+{
+    std::vector<uint32_t> remap( vertexCount, sUnused );
+    uint32_t used = 0;
+    for( uint32_t ii=0; ii<indexCount; ii++ )
+    {
+        uint32_t &vertex = remap[pIndices[ii]];
+        if( sUnused == vertex )
+        {
+            vertex = used++;
+        }
+        pIndices[ii] = vertex;
+    }
+
+    std::vector<char> original( (const char*)pVertices, (const char*)pVertices + (size_t)vertexCount * stride );
+    for( uint32_t ii=0; ii<vertexCount; ii++ )
+    {
+        if( sUnused != remap[ii] )
+        {
+            memcpy( (char*)pVertices + (size_t)remap[ii] * stride, &original[(size_t)ii * stride], stride );
+        }
+    }
+    return used;
+}
+
+// A component in format, in the low bits
+//-----------------------------------------------------------------------------
+static inline uint32_t Quantize( float value, CPUT_MESH_ATTRIBUTE_FORMAT format )
+{
+    switch( format )
+    {
+    case CPUT_MESH_FORMAT_HALF:    return CPUTFloatToHalf( value );
+    case CPUT_MESH_FORMAT_SNORM16: return (uint16_t)(int16_t)floorf( std::max( -1.0f, std::min( 1.0f, value ) ) * 32767.0f + 0.5f );
+    default:                       return (uint8_t)(int8_t)floorf( std::max( -1.0f, std::min( 1.0f, value ) ) * 127.0f + 0.5f );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static inline float Dequantize( uint32_t value, CPUT_MESH_ATTRIBUTE_FORMAT format )
+{
+    switch( format )
+    {
+    case CPUT_MESH_FORMAT_HALF:    return CPUTHalfToFloat( (uint16_t)value );
+    case CPUT_MESH_FORMAT_SNORM16: return (int16_t)(uint16_t)value / 32767.0f;
+    default:                       return (int8_t)(uint8_t)value / 127.0f;
+    }
+}
+
+//-----------------------------------------------------------------------------
+static uint32_t GetFormatSize( CPUT_MESH_ATTRIBUTE_FORMAT format, uint32_t components )
+{
+    switch( format )
+    {
+    case CPUT_MESH_FORMAT_FLOAT:   return components * 4;
+    case CPUT_MESH_FORMAT_HALF:    return components * 2;
+    case CPUT_MESH_FORMAT_SNORM16: return components * 2;
+    case CPUT_MESH_FORMAT_SNORM8:  return components;
+    default:                       return components;
+    }
+}
+
+// The most any component of a float attribute changes when quantized to format (which,
+// for the signed normalized formats, must not clamp it by more than a rounding error)
+//-----------------------------------------------------------------------------
+static float GetQuantizationError( const void *pVertices, uint32_t vertexCount, uint32_t stride, const CPUTMeshAttribute &attribute, CPUT_MESH_ATTRIBUTE_FORMAT format )
+{
+    float maxError = 0.0f;
+    for( uint32_t ii=0; ii<vertexCount; ii++ )
+    {
+        const float *pValue = (const float*)((const char*)pVertices + (size_t)ii * stride + attribute.mOffset);
+        for( uint32_t cc=0; cc<attribute.mComponents; cc++ )
+        {
+            float error = fabsf( Dequantize( Quantize( pValue[cc], format ), format ) - pValue[cc] );
+            if( !(error <= maxError) )
+            {
+                // Including NaN, which no format here keeps
+                maxError = error == error ? error : FLT_MAX;
+            }
+        }
+    }
+    return maxError;
+}
+
+// Quantized attributes get 2 or 4 components (there are no 3-component 16- or 8-bit
+// formats), which also keeps every one a multiple of 4 bytes.  The extras are 0.
+//-----------------------------------------------------------------------------
+uint32_t CPUTQuantizeVertices( void *pVertices, uint32_t vertexCount, uint32_t stride, CPUTMeshAttribute *pAttributes, uint32_t attributeCount,
+                               const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats )
+{
+    std::vector<CPUTMeshAttribute> quantized( pAttributes, pAttributes + attributeCount );
+    uint32_t newStride = 0;
+    uint32_t changed = 0;
+    for( uint32_t ii=0; ii<attributeCount; ii++ )
+    {
+        const CPUTMeshAttribute &attribute = pAttributes[ii];
+        CPUTMeshAttribute &result = quantized[ii];
+        if( CPUT_MESH_FORMAT_FLOAT == attribute.mFormat && attribute.mComponents <= 4 )
+        {
+            CPUT_MESH_ATTRIBUTE_FORMAT format = CPUT_MESH_FORMAT_FLOAT;
+            float maxError = 0.0f;
+            if( CPUT_MESH_ATTRIBUTE_DIRECTION == attribute.mKind )
+            {
+                format   = settings.mDirectionFormat;
+                maxError = settings.mMaxDirectionError;
+            }
+            else if( CPUT_MESH_ATTRIBUTE_TEXCOORD == attribute.mKind )
+            {
+                format   = settings.mTexCoordFormat;
+                maxError = settings.mMaxTexCoordError;
+            }
+            if( CPUT_MESH_FORMAT_FLOAT != format &&
+                GetQuantizationError( pVertices, vertexCount, stride, attribute, format ) > maxError )
+            {
+                format = CPUT_MESH_FORMAT_FLOAT;
+            }
+            if( CPUT_MESH_FORMAT_FLOAT != format )
+            {
+                result.mFormat     = format;
+                result.mComponents = (CPUT_MESH_FORMAT_SNORM8 == format || attribute.mComponents > 2) ? 4 : 2;
+                result.mSize       = GetFormatSize( format, result.mComponents );
+                changed++;
+            }
+        }
+        result.mOffset = newStride;
+        newStride += result.mSize;
+    }
+    if( !changed )
+    {
+        return stride;
+    }
+    assert( newStride <= stride );
+
+    // In place.  A vertex never moves up, and each is copied out before it's overwritten.
+    std::vector<char> vertex( stride );
+    for( uint32_t vv=0; vv<vertexCount; vv++ )
+    {
+        memcpy( &vertex[0], (const char*)pVertices + (size_t)vv * stride, stride );
+        char *pDestination = (char*)pVertices + (size_t)vv * newStride;
+        for( uint32_t ii=0; ii<attributeCount; ii++ )
+        {
+            const CPUTMeshAttribute &attribute = pAttributes[ii];
+            const CPUTMeshAttribute &result    = quantized[ii];
+            if( attribute.mFormat == result.mFormat )
+            {
+                memcpy( pDestination + result.mOffset, &vertex[attribute.mOffset], attribute.mSize );
+                continue;
+            }
+            const float *pValue = (const float*)&vertex[attribute.mOffset];
+            for( uint32_t cc=0; cc<result.mComponents; cc++ )
+            {
+                float value = cc < attribute.mComponents ? pValue[cc] : 0.0f;
+                uint32_t quantizedValue = Quantize( value, result.mFormat );
+                if( CPUT_MESH_FORMAT_SNORM8 == result.mFormat )
+                {
+                    pDestination[result.mOffset + cc] = (char)quantizedValue;
+                }
+                else
+                {
+                    uint16_t value16 = (uint16_t)quantizedValue;
+                    memcpy( pDestination + result.mOffset + cc * sizeof(value16), &value16, sizeof(value16) );
+                }
+                if( pStats )
+                {
+                    float &maxError = CPUT_MESH_ATTRIBUTE_DIRECTION == attribute.mKind ? pStats->mMaxDirectionError : pStats->mMaxTexCoordError;
+                    maxError = std::max( maxError, fabsf( Dequantize( quantizedValue, result.mFormat ) - value ) );
+                }
+            }
+        }
+    }
+    memcpy( pAttributes, &quantized[0], attributeCount * sizeof(CPUTMeshAttribute) );
+    if( pStats )
+    {
+        pStats->mAttributesQuantized += changed;
+    }
+    return newStride;
+}
+
+//-----------------------------------------------------------------------------
+static const CPUTMeshAttribute *FindPosition( const CPUTMeshOptimizerMesh &mesh )
+{
+    for( uint32_t ii=0; ii<mesh.mAttributeCount; ii++ )
+    {
+        const CPUTMeshAttribute &attribute = mesh.mpAttributes[ii];
+        if( CPUT_MESH_ATTRIBUTE_POSITION == attribute.mKind && CPUT_MESH_FORMAT_FLOAT == attribute.mFormat && attribute.mComponents >= 3 )
+        {
+            return &attribute;
+        }
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+static void Analyze( const CPUTMeshOptimizerMesh &mesh, const CPUTMeshOptimizerSettings &settings,
+                     CPUTMeshCacheStats *pCache, CPUTMeshOverdrawStats *pOverdraw, CPUTMeshFetchStats *pFetch )
+{
+    *pCache = CPUTAnalyzeVertexCache( mesh.mpIndices, mesh.mIndexCount, mesh.mVertexCount, settings.mAnalysisCacheSize );
+    *pFetch = CPUTAnalyzeVertexFetch( mesh.mpIndices, mesh.mIndexCount, mesh.mVertexCount, mesh.mStride );
+    const CPUTMeshAttribute *pPosition = FindPosition( mesh );
+    if( pPosition )
+    {
+        *pOverdraw = CPUTAnalyzeOverdraw( mesh.mpIndices, mesh.mIndexCount, (const char*)mesh.mpVertices + pPosition->mOffset, mesh.mStride, mesh.mVertexCount );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOptimizeMesh( CPUTMeshOptimizerMesh *pMesh, const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats )
+{
+    assert( 0 == pMesh->mIndexCount % 3 );
+    CPUTMeshOptimizerStats stats;
+    stats.mMeshes = 1;
+    stats.mVertexBytesBefore = (uint64_t)pMesh->mVertexCount * pMesh->mStride;
+    if( settings.mAnalyze )
+    {
+        Analyze( *pMesh, settings, &stats.mCacheBefore, &stats.mOverdrawBefore, &stats.mFetchBefore );
+    }
+
+    if( settings.mVertexCache )
+    {
+        CPUTOptimizeVertexCache( pMesh->mpIndices, pMesh->mIndexCount, pMesh->mVertexCount );
+    }
+    const CPUTMeshAttribute *pPosition = FindPosition( *pMesh );
+    if( settings.mOverdraw && pPosition )
+    {
+        CPUTOptimizeOverdraw( pMesh->mpIndices, pMesh->mIndexCount, (const char*)pMesh->mpVertices + pPosition->mOffset, pMesh->mStride,
+                              pMesh->mVertexCount, settings.mOverdrawThreshold );
+    }
+    if( settings.mVertexFetch )
+    {
+        uint32_t used = CPUTOptimizeVertexFetch( pMesh->mpVertices, pMesh->mpIndices, pMesh->mIndexCount, pMesh->mVertexCount, pMesh->mStride );
+        stats.mVerticesDropped = pMesh->mVertexCount - used;
+        pMesh->mVertexCount = used;
+    }
+    pMesh->mStride = CPUTQuantizeVertices( pMesh->mpVertices, pMesh->mVertexCount, pMesh->mStride, pMesh->mpAttributes, pMesh->mAttributeCount, settings, &stats );
+
+    stats.mVertexBytesAfter = (uint64_t)pMesh->mVertexCount * pMesh->mStride;
+    if( settings.mAnalyze )
+    {
+        Analyze( *pMesh, settings, &stats.mCacheAfter, &stats.mOverdrawAfter, &stats.mFetchAfter );
+    }
+    if( pStats )
+    {
+        pStats->Add( stats );
+    }
+}
+
+//-----------------------------------------------------------------------------
+CPUTMeshCacheStats CPUTAnalyzeVertexCache( const uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize )
+{
+    CPUTMeshCacheStats stats;
+    stats.mTriangles   = indexCount / 3;
+    stats.mVertices    = 0;
+    stats.mTransformed = 0;
+    std::vector<uint32_t> timestamps( vertexCount, 0 );
+    std::vector<uint8_t>  seen( vertexCount, 0 );
+    uint32_t time = cacheSize + 1;
+    for( uint32_t ii=0; ii+2<indexCount; ii+=3 )
+    {
+        stats.mTransformed += UpdateFIFO( &pIndices[ii], cacheSize, &timestamps[0], time );
+        for( uint32_t jj=0; jj<3; jj++ )
+        {
+            if( !seen[pIndices[ii+jj]] )
+            {
+                seen[pIndices[ii+jj]] = 1;
+                stats.mVertices++;
+            }
+        }
+    }
+    return stats;
+}
+
+// Draws the mesh, in order, onto a grid looking down each axis from both sides, with a
+// depth test and back faces culled.  Shaded pixels over covered pixels is the overdraw.
+//-----------------------------------------------------------------------------
+CPUTMeshOverdrawStats CPUTAnalyzeOverdraw( const uint32_t *pIndices, uint32_t indexCount, const void *pPositions, uint32_t positionStride, uint32_t vertexCount )
+{
+    (void)vertexCount; // Only asserted against
+    CPUTMeshOverdrawStats stats;
+    stats.mPixelsCovered = 0;
+    stats.mPixelsShaded  = 0;
+    if( indexCount < 3 )
+    {
+        return stats;
+    }
+
+    // Fit the mesh to the grid, keeping its proportions
+    float minimum[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for( uint32_t ii=0; ii<indexCount; ii++ )
+    {
+        assert( pIndices[ii] < vertexCount );
+        const float *pPosition = GetPosition( pPositions, positionStride, pIndices[ii] );
+        for( uint32_t kk=0; kk<3; kk++ )
+        {
+            minimum[kk] = std::min( minimum[kk], pPosition[kk] );
+            maximum[kk] = std::max( maximum[kk], pPosition[kk] );
+        }
+    }
+    float extent = std::max( maximum[0] - minimum[0], std::max( maximum[1] - minimum[1], maximum[2] - minimum[2] ) );
+    float scale  = extent > 0.0f ? (CPUT_MESH_OVERDRAW_GRID - 1) / extent : 0.0f;
+
+    const uint32_t grid = CPUT_MESH_OVERDRAW_GRID;
+    std::vector<float> depth( grid * grid );
+    for( uint32_t axis=0; axis<3; axis++ )
+    {
+        uint32_t u = (axis + 1) % 3;
+        uint32_t v = (axis + 2) % 3;
+        for( uint32_t side=0; side<2; side++ )
+        {
+            std::fill( depth.begin(), depth.end(), FLT_MAX );
+            float sign = side ? -1.0f : 1.0f;
+            for( uint32_t ii=0; ii+2<indexCount; ii+=3 )
+            {
+                float x[3], y[3], z[3];
+                for( uint32_t jj=0; jj<3; jj++ )
+                {
+                    const float *pPosition = GetPosition( pPositions, positionStride, pIndices[ii+jj] );
+                    x[jj] = (pPosition[u] - minimum[u]) * scale;
+                    y[jj] = (pPosition[v] - minimum[v]) * scale;
+                    z[jj] = (pPosition[axis] - minimum[axis]) * scale * sign;
+                }
+                // (u, v, axis) is right- or left-handed as (x, y, z) is, so this is the axis's
+                // component of e1 x e2, which is negative for a front face looking down the axis
+                float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if( area * sign >= 0.0f )
+                {
+                    continue;
+                }
+                int x0 = std::max( 0, (int)floorf( std::min( x[0], std::min( x[1], x[2] ) ) ) );
+                int x1 = std::min( (int)grid - 1, (int)ceilf( std::max( x[0], std::max( x[1], x[2] ) ) ) );
+                int y0 = std::max( 0, (int)floorf( std::min( y[0], std::min( y[1], y[2] ) ) ) );
+                int y1 = std::min( (int)grid - 1, (int)ceilf( std::max( y[0], std::max( y[1], y[2] ) ) ) );
+                float invArea = 1.0f / area;
+                for( int py=y0; py<=y1; py++ )
+                {
+                    float cy = py + 0.5f;
+                    for( int px=x0; px<=x1; px++ )
+                    {
+                        float cx = px + 0.5f;
+                        // Barycentrics; all the same sign as area inside the triangle
+                        float w0 = ((x[1] - cx) * (y[2] - cy) - (x[2] - cx) * (y[1] - cy)) * invArea;
+                        float w1 = ((x[2] - cx) * (y[0] - cy) - (x[0] - cx) * (y[2] - cy)) * invArea;
+                        float w2 = 1.0f - w0 - w1;
+                        if( w0 < 0.0f || w1 < 0.0f || w2 < 0.0f )
+                        {
+                            continue;
+                        }
+                        float pixelDepth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+                        float &stored = depth[py * grid + px];
+                        if( pixelDepth < stored )
+                        {
+                            stored = pixelDepth;
+                            stats.mPixelsShaded++;
+                        }
+                    }
+                }
+            }
+            for( uint32_t ii=0; ii<grid*grid; ii++ )
+            {
+                stats.mPixelsCovered += FLT_MAX != depth[ii];
+            }
+        }
+    }
+    return stats;
+}
+
+// Every index fetches its vertex's cache lines, unless they're among the most recent ones
+//-----------------------------------------------------------------------------
+CPUTMeshFetchStats CPUTAnalyzeVertexFetch( const uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t stride )
+{
+    CPUTMeshFetchStats stats;
+    stats.mBytesFetched = 0;
+    stats.mBytesUsed    = 0;
+    if( !stride )
+    {
+        return stats;
+    }
+    uint64_t lineCount = ((uint64_t)vertexCount * stride + CPUT_MESH_FETCH_LINE_SIZE - 1) / CPUT_MESH_FETCH_LINE_SIZE;
+    std::vector<uint32_t> timestamps( (size_t)lineCount, 0 );
+    std::vector<uint8_t>  seen( vertexCount, 0 );
+    uint32_t time = CPUT_MESH_FETCH_LINE_COUNT + 1;
+    for( uint32_t ii=0; ii<indexCount; ii++ )
+    {
+        uint32_t vertex = pIndices[ii];
+        uint64_t start  = (uint64_t)vertex * stride;
+        for( uint64_t line = start / CPUT_MESH_FETCH_LINE_SIZE; line <= (start + stride - 1) / CPUT_MESH_FETCH_LINE_SIZE; line++ )
+        {
+            if( time - timestamps[(size_t)line] > CPUT_MESH_FETCH_LINE_COUNT )
+            {
+                timestamps[(size_t)line] = time++;
+                stats.mBytesFetched += CPUT_MESH_FETCH_LINE_SIZE;
+            }
+        }
+        if( !seen[vertex] )
+        {
+            seen[vertex] = 1;
+            stats.mBytesUsed += stride;
+        }
+    }
+    return stats;
+}
+
+//-----------------------------------------------------------------------------
+uint16_t CPUTFloatToHalf( float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    uint32_t sign     = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if( 0xFF == exponent )
+    {
+        // Infinity stays infinity; NaN stays NaN
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    int halfExponent = (int)exponent - 127 + 15;
+    if( halfExponent >= 31 )
+    {
+        return (uint16_t)(sign | 0x7C00);
+    }
+    uint32_t half, remainder, halfway;
+    if( halfExponent <= 0 )
+    {
+        // Denormal, or too small for one
+        if( halfExponent < -10 )
+        {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - halfExponent);
+        half      = mantissa >> shift;
+        remainder = mantissa & ((1u << shift) - 1);
+        halfway   = 1u << (shift - 1);
+    }
+    else
+    {
+        half      = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+        remainder = mantissa & 0x1FFF;
+        halfway   = 0x1000;
+    }
+    // A carry out of the mantissa correctly rounds up to the next exponent (or infinity)
+    if( remainder > halfway || (remainder == halfway && (half & 1)) )
+    {
+        half++;
+    }
+    return (uint16_t)(sign | half);
+}
+
+//-----------------------------------------------------------------------------
+float CPUTHalfToFloat( uint16_t value )
+{
+    uint32_t sign     = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    if( 0 == exponent )
+    {
+        float result = ldexpf( (float)mantissa, -24 );
+        return sign ? -result : result;
+    }
+    uint32_t bits = 31 == exponent ? (sign | 0x7F800000 | (mantissa << 13))
+                                   : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float result;
+    memcpy( &result, &bits, sizeof(result) );
+    return result;
+}
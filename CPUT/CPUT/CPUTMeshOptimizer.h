@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMESHOPTIMIZER_H__
+#define __CPUTMESHOPTIMIZER_H__
+
+// Reorders and packs an indexed triangle list for the GPU's vertex pipeline.
+//
+// CPUTOptimizeMesh() runs these in order (each is also callable alone):
+//
+//   - Vertex cache: reorders triangles so ones sharing vertices are drawn close together,
+//     and the post-transform cache shades each vertex fewer times (Forsyth's linear-speed
+//     algorithm, for a 32-entry LRU cache).
+//   - Overdraw: cuts the cache-friendly order into clusters where doing so costs little
+//     cache efficiency (at most the threshold times the cluster's own ACMR), then draws
+//     clusters facing out from the mesh's center first, so they occlude the rest (after
+//     Sander et al., "Fast triangle reordering for vertex locality and reduced overdraw").
+//   - Vertex fetch: renumbers vertices in the order triangles first use them, so fetches
+//     walk the vertex buffer forward.  Vertices no triangle uses are dropped.
+//   - Quantization: normals, tangents and binormals become 16- or 8-bit signed normalized
+//     vectors, and texture coordinates half floats.  The input assembler expands these to
+//     floats, so shaders don't change.  Positions, and attributes that would change by more
+//     than the settings allow (a direction longer than 1, texture coordinates that tile far
+//     past 1), stay as they were.
+//
+// The Analyze functions measure the results: ACMR (vertices shaded per triangle) and
+// ATVR (vertices shaded per vertex; 1 is ideal) in a FIFO cache, overdraw from a small
+// software rasterizer looking along each axis, and vertex buffer bytes fetched through
+// 64-byte cache lines.  Nothing here touches a graphics API: meshes are optimized on the
+// CPU, when baking model files or while loading them.
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+enum CPUT_MESH_ATTRIBUTE_KIND
+{
+    CPUT_MESH_ATTRIBUTE_POSITION,
+    CPUT_MESH_ATTRIBUTE_DIRECTION,  // Normals, tangents and binormals: components in [-1,1]
+    CPUT_MESH_ATTRIBUTE_TEXCOORD,
+    CPUT_MESH_ATTRIBUTE_OTHER,      // Copied as is
+};
+
+//-----------------------------------------------------------------------------
+enum CPUT_MESH_ATTRIBUTE_FORMAT
+{
+    CPUT_MESH_FORMAT_FLOAT,
+    CPUT_MESH_FORMAT_HALF,
+    CPUT_MESH_FORMAT_SNORM16,
+    CPUT_MESH_FORMAT_SNORM8,
+    CPUT_MESH_FORMAT_RAW,           // Anything else; mComponents is its size in bytes
+};
+
+// One attribute of an interleaved vertex
+//-----------------------------------------------------------------------------
+struct CPUTMeshAttribute
+{
+    CPUT_MESH_ATTRIBUTE_KIND   mKind;
+    CPUT_MESH_ATTRIBUTE_FORMAT mFormat;
+    uint32_t                   mComponents;
+    uint32_t                   mOffset;
+    uint32_t                   mSize;      // In bytes
+};
+
+// A mesh to optimize in place.  Quantizing only shrinks vertices, so the arrays never grow.
+//-----------------------------------------------------------------------------
+struct CPUTMeshOptimizerMesh
+{
+    void              *mpVertices;
+    uint32_t           mVertexCount;
+    uint32_t           mStride;
+    uint32_t          *mpIndices;          // A triangle list
+    uint32_t           mIndexCount;
+    CPUTMeshAttribute *mpAttributes;
+    uint32_t           mAttributeCount;
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTMeshOptimizerSettings
+{
+    bool                       mVertexCache;
+    bool                       mOverdraw;
+    float                      mOverdrawThreshold;  // How much worse than the cache-optimized ACMR a cluster may get
+    bool                       mVertexFetch;
+    CPUT_MESH_ATTRIBUTE_FORMAT mDirectionFormat;    // SNORM16 or SNORM8; FLOAT leaves them
+    CPUT_MESH_ATTRIBUTE_FORMAT mTexCoordFormat;     // HALF; FLOAT leaves them
+    float                      mMaxDirectionError;  // An attribute any component of which would change more stays float
+    float                      mMaxTexCoordError;
+    bool                       mAnalyze;            // Fill in the statistics' before and after measurements
+    uint32_t                   mAnalysisCacheSize;  // FIFO entries for the ACMR and ATVR
+
+    CPUTMeshOptimizerSettings() :
+        mVertexCache(true),
+        mOverdraw(true),
+        mOverdrawThreshold(1.05f),
+        mVertexFetch(true),
+        mDirectionFormat(CPUT_MESH_FORMAT_SNORM16),
+        mTexCoordFormat(CPUT_MESH_FORMAT_HALF),
+        mMaxDirectionError(1.0f / 128.0f),
+        mMaxTexCoordError(1.0f / 2048.0f),          // Half a texel of a 1024 texture: coordinates within [-2,2]
+        mAnalyze(true),
+        mAnalysisCacheSize(16)
+    {
+    }
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTMeshCacheStats
+{
+    uint32_t mTriangles;
+    uint32_t mVertices;         // Used by the triangles
+    uint32_t mTransformed;      // Cache misses
+
+    float GetACMR() const { return mTriangles ? (float)mTransformed / mTriangles : 0.0f; }
+    float GetATVR() const { return mVertices  ? (float)mTransformed / mVertices  : 0.0f; }
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTMeshOverdrawStats
+{
+    uint64_t mPixelsCovered;
+    uint64_t mPixelsShaded;     // Passing the depth test when drawn
+
+    float GetOverdraw() const { return mPixelsCovered ? (float)mPixelsShaded / mPixelsCovered : 0.0f; }
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTMeshFetchStats
+{
+    uint64_t mBytesFetched;
+    uint64_t mBytesUsed;        // Of the vertices the triangles use
+
+    float GetOverfetch() const { return mBytesUsed ? (float)mBytesFetched / mBytesUsed : 0.0f; }
+};
+
+// Sums over every mesh optimized.  Before and after measurements only with mAnalyze.
+//-----------------------------------------------------------------------------
+struct CPUTMeshOptimizerStats
+{
+    uint32_t              mMeshes;
+    uint32_t              mVerticesDropped;
+    uint64_t              mVertexBytesBefore;
+    uint64_t              mVertexBytesAfter;
+    uint32_t              mAttributesQuantized;
+    float                 mMaxDirectionError;    // Largest change to a component
+    float                 mMaxTexCoordError;
+    CPUTMeshCacheStats    mCacheBefore;
+    CPUTMeshCacheStats    mCacheAfter;
+    CPUTMeshOverdrawStats mOverdrawBefore;
+    CPUTMeshOverdrawStats mOverdrawAfter;
+    CPUTMeshFetchStats    mFetchBefore;
+    CPUTMeshFetchStats    mFetchAfter;
+
+    CPUTMeshOptimizerStats();
+    void Add( const CPUTMeshOptimizerStats &other );
+};
+
+void     CPUTOptimizeVertexCache( uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount );
+void     CPUTOptimizeOverdraw( uint32_t *pIndices, uint32_t indexCount, const void *pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold );
+// Returns the new vertex count
+uint32_t CPUTOptimizeVertexFetch( void *pVertices, uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t stride );
+// Rewrites pAttributes and returns the new stride
+uint32_t CPUTQuantizeVertices( void *pVertices, uint32_t vertexCount, uint32_t stride, CPUTMeshAttribute *pAttributes, uint32_t attributeCount,
+                               const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats );
+// All of the above, as settings asks.  Needs a float position attribute to reduce overdraw.
+void     CPUTOptimizeMesh( CPUTMeshOptimizerMesh *pMesh, const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats );
+
+CPUTMeshCacheStats    CPUTAnalyzeVertexCache( const uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize );
+CPUTMeshOverdrawStats CPUTAnalyzeOverdraw( const uint32_t *pIndices, uint32_t indexCount, const void *pPositions, uint32_t positionStride, uint32_t vertexCount );
+CPUTMeshFetchStats    CPUTAnalyzeVertexFetch( const uint32_t *pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t stride );
+
+// IEEE half floats, rounded to nearest even
+uint16_t CPUTFloatToHalf( float value );
+float    CPUTHalfToFloat( uint16_t value );
+
+#endif // __CPUTMESHOPTIMIZER_H__
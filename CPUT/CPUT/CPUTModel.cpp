@@ -17,6 +17,9 @@
 #include "CPUTMaterial.h"
 #include "CPUTMesh.h"
 #include "CPUTAssetLibrary.h"
+#include "CPUTCamera.h"
+#include "CPUTRenderQueue.h"
+#include "CPUTMathBatch.h"
 
 //-----------------------------------------------------------------------------
 CPUTModel::~CPUTModel()
@@ -61,48 +64,29 @@ void CPUTModel::UpdateBoundsWorldSpace()
     // However, if it moves, then it's world-space bounding box does change.
     // Call this function when the model moves
 
-    float4x4 *pWorld =  GetWorldMatrix();
-    float4 center    =  float4(mBoundingBoxCenterObjectSpace, 1.0f); // W = 1 because we want the xlation (i.e., center is a position)
-    float4 half      =  float4(mBoundingBoxHalfObjectSpace,   0.0f); // W = 0 because we don't want xlation (i.e., half is a direction)
-
-    // TODO: optimize this
-    float4 positions[8] = {
-        center + float4( 1.0f, 1.0f, 1.0f, 0.0f ) * half,
-        center + float4( 1.0f, 1.0f,-1.0f, 0.0f ) * half,
-        center + float4( 1.0f,-1.0f, 1.0f, 0.0f ) * half,
-        center + float4( 1.0f,-1.0f,-1.0f, 0.0f ) * half,
-        center + float4(-1.0f, 1.0f, 1.0f, 0.0f ) * half,
-        center + float4(-1.0f, 1.0f,-1.0f, 0.0f ) * half,
-        center + float4(-1.0f,-1.0f, 1.0f, 0.0f ) * half,
-        center + float4(-1.0f,-1.0f,-1.0f, 0.0f ) * half
-    };
-
-    float4 minPosition( FLT_MAX,  FLT_MAX,  FLT_MAX, 1.0f );
-    float4 maxPosition(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f );
-    for( UINT ii=0; ii<8; ii++ )
-    {
-        float4 position = positions[ii] * *pWorld;
-        minPosition = Min( minPosition, position );
-        maxPosition = Max( maxPosition, position );
-    }
-    mBoundingBoxCenterWorldSpace = (maxPosition + minPosition) * 0.5f;
-    mBoundingBoxHalfWorldSpace   = (maxPosition - minPosition) * 0.5f;
+    // Same box as the min and max of the eight transformed corners, without transforming them
+    CPUTTransformBoxes( &mBoundingBoxCenterWorldSpace, &mBoundingBoxHalfWorldSpace,
+                        &mBoundingBoxCenterObjectSpace, &mBoundingBoxHalfObjectSpace, 1, *GetWorldMatrix() );
 }
 
 //-----------------------------------------------------------------------------
 CPUTResult CPUTModel::LoadModelPayload(const cString &File)
 {
     CPUTResult result = CPUT_SUCCESS;
+    mPayloadFilename = File;
 
     std::ifstream file(File.c_str(), std::ios::in | std::ios::binary);
     ASSERT( !file.fail(), _L("CPUTModelDX11::LoadModelPayload() - Could not find binary model file: ") + File );
 
-    // set up for mesh creation loop
+    // set up for mesh creation loop.  A mesh's file data is only needed until its buffers
+    // are created, so it goes in the load arena, and the next mesh reuses the memory.
     UINT meshIndex = 0;
+    CPUTArena *pArena = CPUTAssetLibrary::GetLoadArena();
     while(file.good() && !file.eof())
     {
         // TODO: rearrange while() to avoid if(eof).  Should perform only one branch per loop iteration, not two
-        CPUTRawMeshData vertexFormatDesc;
+        CPUTArenaScope scope( *pArena );
+        CPUTRawMeshData vertexFormatDesc( pArena );
         vertexFormatDesc.Read(file);
         if(file.eof())
         {
@@ -110,6 +94,11 @@ CPUTResult CPUTModel::LoadModelPayload(const cString &File)
             break;
         }
         ASSERT( meshIndex < mMeshCount, _L("Actual mesh count doesn't match stated mesh count"));
+        const CPUTMeshOptimizerSettings *pOptimizerSettings = CPUTAssetLibrary::GetMeshOptimizerSettings();
+        if( pOptimizerSettings )
+        {
+            vertexFormatDesc.Optimize( *pOptimizerSettings, CPUTAssetLibrary::GetMeshOptimizerStats() );
+        }
 
         // create the mesh.
         CPUTMesh *pMesh = mpMesh[meshIndex];
@@ -118,8 +107,7 @@ CPUTResult CPUTModel::LoadModelPayload(const cString &File)
         pMesh->SetMeshTopology(CPUT_TOPOLOGY_INDEXED_TRIANGLE_LIST);
 
         // get number of data blocks in the vertex element (pos,norm,uv,etc)
-        // YUCK! TODO: Use fixed-size array of elements
-        CPUTBufferInfo *pVertexElementInfo = new CPUTBufferInfo[vertexFormatDesc.mFormatDescriptorCount];
+        CPUTBufferInfo *pVertexElementInfo = pArena->AllocateArray<CPUTBufferInfo>( vertexFormatDesc.mFormatDescriptorCount );
         // pMesh->SetBounds(vertexFormatDesc.mBboxCenter, vertexFormatDesc.mBboxHalf);
 
         // running count of each type of  element
@@ -208,8 +196,6 @@ CPUTResult CPUTModel::LoadModelPayload(const cString &File)
                 return result;
             }
         }
-        delete [] pVertexElementInfo;
-        pVertexElementInfo = NULL;
         ++meshIndex;
     }
     ASSERT( file.eof(), _L("") );
@@ -220,6 +206,43 @@ CPUTResult CPUTModel::LoadModelPayload(const cString &File)
     return result;
 }
 
+//-----------------------------------------------------------------------------
+CPUTResult CPUTModel::OptimizeModelPayload(const cString &sourceFile, const cString &destinationFile,
+                                           const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats)
+{
+    std::ifstream source(sourceFile.c_str(), std::ios::in | std::ios::binary);
+    if( source.fail() )
+    {
+        return CPUT_ERROR_FILE_NOT_FOUND;
+    }
+    std::ofstream destination(destinationFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if( destination.fail() )
+    {
+        return CPUT_ERROR_FILE_IO_ERROR;
+    }
+
+    // One mesh at a time, as LoadModelPayload() reads them
+    CPUTArena *pArena = CPUTAssetLibrary::GetLoadArena();
+    while(source.good() && !source.eof())
+    {
+        CPUTArenaScope scope( *pArena );
+        CPUTRawMeshData meshData( pArena );
+        meshData.Read(source);
+        if(source.eof())
+        {
+            break;
+        }
+        meshData.Optimize( settings, pStats );
+        if( !meshData.Write(destination) )
+        {
+            return CPUT_ERROR_FILE_IO_ERROR;
+        }
+    }
+    source.close();
+    destination.close();
+    return destination.fail() ? CPUT_ERROR_FILE_IO_ERROR : CPUT_SUCCESS;
+}
+
 // Set the material associated with this mesh and create/re-use a
 //-----------------------------------------------------------------------------
 void CPUTModel::SetMaterial(UINT ii, CPUTMaterial *pMaterial)
@@ -236,6 +259,25 @@ void CPUTModel::SetMaterial(UINT ii, CPUTMaterial *pMaterial)
     }
 }
 
+// Queue one packet per mesh.  Packets are keyed by the mesh's material and the
+// model's distance from the camera, so opaque meshes draw front to back.
+//-----------------------------------------------------------------------------
+void CPUTModel::QueueMeshes(CPUTRenderParameters &renderParams, CPUT_RENDER_PASS pass)
+{
+    CPUTRenderQueue *pQueue  = renderParams.mpRenderQueue;
+    CPUTCamera      *pCamera = renderParams.mpCamera;
+    float distance = pCamera ? (mBoundingBoxCenterWorldSpace - pCamera->GetPosition()).length() : 0.0f;
+    UINT  depth    = CPUTRenderQueue::QuantizeDepth( distance );
+
+    for( UINT ii=0; ii<mMeshCount; ii++ )
+    {
+        CPUTMaterial *pMaterial = (CPUT_RENDER_PASS_SHADOW == pass) ? mpShadowCastMaterial : mpMaterial[ii];
+        UINT meshDepth = pMaterial->SupportsInstancing() ? CPUTRenderQueue::MakeInstancedDepth( mpMesh[ii]->GetSortId(), depth ) : depth;
+        uint64_t key = CPUTRenderQueue::MakeKey( pass, pMaterial->GetShaderSortId(), pMaterial->GetStateSortId(), pMaterial->GetMaterialSortId(), meshDepth );
+        pQueue->AddPacket( key, this, pMaterial, ii );
+    }
+}
+
 
 #ifdef SUPPORT_DRAWING_BOUNDING_BOXES
 // TODO:  We create a native mesh below.  Best way to do this?  Move the whole thing to CPUTModelDX11?  Add CPUTMesh::CreateNativeMesh() or equiv?
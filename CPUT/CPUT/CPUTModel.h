@@ -27,6 +27,7 @@
 
 class CPUTMaterial;
 class CPUTMesh;
+struct CPUTInstanceData;
 
 //-----------------------------------------------------------------------------
 class CPUTModel : public CPUTRenderNode
@@ -39,18 +40,21 @@ protected:
 
     UINT           mMeshCount;
     bool           mIsRenderable;
+    bool           mFrustumVisible; // Result of the last batched cull.  Only meaningful while CPUTRenderParameters::mModelsFrustumCulled is set.
     float3         mBoundingBoxCenterObjectSpace;
     float3         mBoundingBoxHalfObjectSpace;
     float3         mBoundingBoxCenterWorldSpace;
     float3         mBoundingBoxHalfWorldSpace;
     CPUTMesh      *mpBoundingBoxMesh;
     CPUTMaterial  *mpBoundingBoxMaterial;
+    cString        mPayloadFilename; // The .mdl file the meshes were loaded from (shared with the master model for instances)
 
 public:
     CPUTModel():
         mMeshCount(0),
         mpMesh(NULL),
         mIsRenderable(true),
+        mFrustumVisible(true),
         mBoundingBoxCenterObjectSpace(0.0f),
         mBoundingBoxHalfObjectSpace(0.0f),
         mBoundingBoxCenterWorldSpace(0.0f),
@@ -63,6 +67,8 @@ public:
 
     bool               IsRenderable() { return mIsRenderable; }
     void               SetRenderable(bool isRenderable) { mIsRenderable = isRenderable; }
+    bool               IsFrustumVisible() { return mFrustumVisible; }
+    void               SetFrustumVisible(bool isVisible) { mFrustumVisible = isVisible; }
     virtual bool       IsModel() { return true; }
     void               GetBoundsObjectSpace(float3 *pCenter, float3 *pHalf);
     void               GetBoundsWorldSpace(float3 *pCenter, float3 *pHalf);
@@ -71,7 +77,24 @@ public:
     CPUTMesh          *GetMesh( UINT ii ) { return mpMesh[ii]; }
     virtual CPUTResult LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel=NULL) = 0;
     CPUTResult         LoadModelPayload(const cString &File);
+    // Optimizes every mesh in a model file (see CPUTMeshOptimizer.h) into another, which loads
+    // like the original.  For baking; loading can also optimize (see CPUTAssetLibrary::SetMeshOptimizerSettings()).
+    static CPUTResult  OptimizeModelPayload(const cString &sourceFile, const cString &destinationFile,
+                                            const CPUTMeshOptimizerSettings &settings, CPUTMeshOptimizerStats *pStats);
+    const cString     &GetPayloadFilename() { return mPayloadFilename; }
     virtual void       SetMaterial(UINT ii, CPUTMaterial *pMaterial);
+
+    // Render queue support.  QueueMeshes() adds one packet per mesh to renderParams.mpRenderQueue.
+    // The queue calls SetQueuedRenderStates() before drawing a packet whose model differs from the last one's.
+    // With an upload ring, it first calls UploadQueuedConstants() once per model, with the same submitIndex.
+    // Returning false (ring full) makes the queue draw this Submit() without the ring.
+    // A multithreaded Submit() without the ring calls UpdateQueuedConstants() instead, on the submitting thread.
+    void               QueueMeshes(CPUTRenderParameters &renderParams, CPUT_RENDER_PASS pass);
+    virtual bool       UploadQueuedConstants(CPUTRenderParameters &renderParams, UINT submitIndex) { return true; }
+    virtual void       UpdateQueuedConstants(CPUTRenderParameters &renderParams, UINT submitIndex) {}
+    virtual void       SetQueuedRenderStates(CPUTRenderParameters &renderParams, UINT submitIndex) {}
+    // Instanced draws read the model's transforms from here instead of its constant buffer
+    virtual void       FillInstanceData(CPUTInstanceData *pData) {}
 #ifdef SUPPORT_DRAWING_BOUNDING_BOXES
     virtual void       DrawBoundingBox(CPUTRenderParameters &renderParams) = 0;
     void               CreateBoundingBoxMesh();
@@ -19,6 +19,8 @@
 #include "CPUTFrustum.h"
 #include "CPUTTextureDX11.h"
 #include "CPUTBufferDX11.h"
+#include "CPUTUploadRing.h"
+#include "CPUTRenderQueue.h"
 
 // Return the mesh at the given index (cast to the GFX api version of CPUTMeshDX11)
 //-----------------------------------------------------------------------------
@@ -32,62 +34,145 @@ float3 gLightDir = float3(0.7f, -0.5f, -0.1f);
 // Set the render state before drawing this object
 //-----------------------------------------------------------------------------
 void CPUTModelDX11::SetRenderStates(CPUTRenderParameters &renderParams)
+{
+    UpdateConstantBuffer(renderParams);
+    BindConstantBuffer(renderParams);
+}
+
+// The render queue draws a model's packets under several materials.  Each material
+// change rebinds the model's constant buffer, but it's only uploaded once per Submit().
+// A multithreaded Submit() uploads the constants (to the ring, or with UpdateQueuedConstants())
+// on the submitting thread before recording starts, so the recording threads only bind them
+// and never write the submit indices.
+//-----------------------------------------------------------------------------
+void CPUTModelDX11::SetQueuedRenderStates(CPUTRenderParameters &renderParams, UINT submitIndex)
+{
+    if( mRingSubmitIndex == submitIndex )
+    {
+        CPUTRenderBackend *pBackend = renderParams.mpBackend;
+        CPUTBackendHandle  buffer   = renderParams.mpUploadRing->GetBuffer();
+        pBackend->SetConstantBufferRange( CPUT_SHADER_STAGE_VERTEX, 0, buffer, mRingOffset, sizeof(CPUTModelConstantBuffer) );
+        pBackend->SetConstantBufferRange( CPUT_SHADER_STAGE_PIXEL,  0, buffer, mRingOffset, sizeof(CPUTModelConstantBuffer) );
+        return;
+    }
+    UpdateQueuedConstants(renderParams, submitIndex);
+    BindConstantBuffer(renderParams);
+}
+
+//-----------------------------------------------------------------------------
+void CPUTModelDX11::UpdateQueuedConstants(CPUTRenderParameters &renderParams, UINT submitIndex)
+{
+    if( mConstantsSubmitIndex != submitIndex )
+    {
+        UpdateConstantBuffer(renderParams);
+        mConstantsSubmitIndex = submitIndex;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTModelDX11::UploadQueuedConstants(CPUTRenderParameters &renderParams, UINT submitIndex)
+{
+    if( mRingSubmitIndex == submitIndex )
+    {
+        return true;
+    }
+    UINT  offset;
+    void *pMapped = renderParams.mpUploadRing->Allocate( sizeof(CPUTModelConstantBuffer), &offset );
+    if( !pMapped )
+    {
+        return false;
+    }
+    FillConstantBuffer( (CPUTModelConstantBuffer*)pMapped );
+    mRingSubmitIndex = submitIndex;
+    mRingOffset      = offset;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTModelDX11::UpdateConstantBuffer(CPUTRenderParameters &renderParams)
 {
     // TODO: need to update the constant buffer only when the model moves.
     // But, requires individual, per-model constant buffers
-    ID3D11DeviceContext *pContext  = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
-
-    CPUTModelConstantBuffer *pCb;
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
     // update parameters of constant buffer
-    D3D11_MAPPED_SUBRESOURCE mapInfo;
-    pContext->Map( mpModelConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapInfo );
+    void *pMapped = pBackend->Map( mpModelConstantBuffer );
+    FillConstantBuffer( (CPUTModelConstantBuffer*)pMapped );
+    pBackend->Unmap( mpModelConstantBuffer, sizeof(CPUTModelConstantBuffer) );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTModelDX11::FillConstantBuffer(CPUTModelConstantBuffer *pCb)
+{
+    // TODO: remove construction of XMM type
+    XMMATRIX    world((float*)GetWorldMatrix());
+    XMVECTOR    determinant = XMMatrixDeterminant(world);
+    CPUTCamera *pCamera     = gpSample->GetCamera();
+    XMMATRIX    view((float*)pCamera->GetViewMatrix());
+    XMMATRIX    projection((float*)pCamera->GetProjectionMatrix());
+    float      *pCameraPos = (float*)&pCamera->GetPosition();
+    XMVECTOR    cameraPos = XMLoadFloat3(&XMFLOAT3( pCameraPos[0], pCameraPos[1], pCameraPos[2] ));
+
+    pCb->World               = world;
+    pCb->ViewProjection      = view  *projection;
+    pCb->WorldViewProjection = world  *pCb->ViewProjection;
+    pCb->InverseWorld        = XMMatrixInverse(&determinant, XMMatrixTranspose(world));
+    // pCb->LightDirection      = XMVector3Transform(gLightDir, pCb->InverseWorld );
+    // pCb->EyePosition         = XMVector3Transform(cameraPos, pCb->InverseWorld );
+    // TODO: Tell the lights to set their render states
+
+    XMVECTOR lightDirection = XMLoadFloat3(&XMFLOAT3( gLightDir.x, gLightDir.y, gLightDir.z ));
+    pCb->LightDirection      = XMVector3Normalize(lightDirection);
+    pCb->EyePosition         = cameraPos;
+    float *bbCWS = (float*)&mBoundingBoxCenterWorldSpace;
+    float *bbHWS = (float*)&mBoundingBoxHalfWorldSpace;
+    float *bbCOS = (float*)&mBoundingBoxCenterObjectSpace;
+    float *bbHOS = (float*)&mBoundingBoxHalfObjectSpace;
+    pCb->BoundingBoxCenterWorldSpace  = XMLoadFloat3(&XMFLOAT3( bbCWS[0], bbCWS[1], bbCWS[2] )); ;
+    pCb->BoundingBoxHalfWorldSpace    = XMLoadFloat3(&XMFLOAT3( bbHWS[0], bbHWS[1], bbHWS[2] )); ;
+    pCb->BoundingBoxCenterObjectSpace = XMLoadFloat3(&XMFLOAT3( bbCOS[0], bbCOS[1], bbCOS[2] )); ;
+    pCb->BoundingBoxHalfObjectSpace   = XMLoadFloat3(&XMFLOAT3( bbHOS[0], bbHOS[1], bbHOS[2] )); ;
+
+    // Shadow camera
+    XMMATRIX    shadowView, shadowProjection;
+    CPUTCamera *pShadowCamera = gpSample->GetShadowCamera();
+    if( pShadowCamera )
     {
-        // TODO: remove construction of XMM type
-        XMMATRIX    world((float*)GetWorldMatrix());
-        XMVECTOR    determinant = XMMatrixDeterminant(world);
-        CPUTCamera *pCamera     = gpSample->GetCamera();
-        XMMATRIX    view((float*)pCamera->GetViewMatrix());
-        XMMATRIX    projection((float*)pCamera->GetProjectionMatrix());
-        float      *pCameraPos = (float*)&pCamera->GetPosition();
-        XMVECTOR    cameraPos = XMLoadFloat3(&XMFLOAT3( pCameraPos[0], pCameraPos[1], pCameraPos[2] ));
-
-        pCb = (CPUTModelConstantBuffer*)mapInfo.pData;
-        pCb->World               = world;
-        pCb->ViewProjection      = view  *projection;
-        pCb->WorldViewProjection = world  *pCb->ViewProjection;
-        pCb->InverseWorld        = XMMatrixInverse(&determinant, XMMatrixTranspose(world));
-        // pCb->LightDirection      = XMVector3Transform(gLightDir, pCb->InverseWorld );
-        // pCb->EyePosition         = XMVector3Transform(cameraPos, pCb->InverseWorld );
-        // TODO: Tell the lights to set their render states
-
-        XMVECTOR lightDirection = XMLoadFloat3(&XMFLOAT3( gLightDir.x, gLightDir.y, gLightDir.z ));
-        pCb->LightDirection      = XMVector3Normalize(lightDirection);
-        pCb->EyePosition         = cameraPos;
-        float *bbCWS = (float*)&mBoundingBoxCenterWorldSpace;
-        float *bbHWS = (float*)&mBoundingBoxHalfWorldSpace;
-        float *bbCOS = (float*)&mBoundingBoxCenterObjectSpace;
-        float *bbHOS = (float*)&mBoundingBoxHalfObjectSpace;
-        pCb->BoundingBoxCenterWorldSpace  = XMLoadFloat3(&XMFLOAT3( bbCWS[0], bbCWS[1], bbCWS[2] )); ;
-        pCb->BoundingBoxHalfWorldSpace    = XMLoadFloat3(&XMFLOAT3( bbHWS[0], bbHWS[1], bbHWS[2] )); ;
-        pCb->BoundingBoxCenterObjectSpace = XMLoadFloat3(&XMFLOAT3( bbCOS[0], bbCOS[1], bbCOS[2] )); ;
-        pCb->BoundingBoxHalfObjectSpace   = XMLoadFloat3(&XMFLOAT3( bbHOS[0], bbHOS[1], bbHOS[2] )); ;
-
-        // Shadow camera
-        XMMATRIX    shadowView, shadowProjection;
-        CPUTCamera *pShadowCamera = gpSample->GetShadowCamera();
-        if( pShadowCamera )
-        {
-            shadowView = XMMATRIX((float*)pShadowCamera->GetViewMatrix());
-            shadowProjection = XMMATRIX((float*)pShadowCamera->GetProjectionMatrix());
-            pCb->LightWorldViewProjection = world * shadowView * shadowProjection;
-        }
+        shadowView = XMMATRIX((float*)pShadowCamera->GetViewMatrix());
+        shadowProjection = XMMATRIX((float*)pShadowCamera->GetProjectionMatrix());
+        pCb->LightWorldViewProjection = world * shadowView * shadowProjection;
     }
-    pContext->Unmap(mpModelConstantBuffer,0);
+}
+
+// The per-instance subset of FillConstantBuffer(), for the instanced vertex shaders
+//-----------------------------------------------------------------------------
+void CPUTModelDX11::FillInstanceData(CPUTInstanceData *pData)
+{
+    XMMATRIX    world((float*)GetWorldMatrix());
+    CPUTCamera *pCamera = gpSample->GetCamera();
+    XMMATRIX    view((float*)pCamera->GetViewMatrix());
+    XMMATRIX    projection((float*)pCamera->GetProjectionMatrix());
+
+    XMStoreFloat4x4( (XMFLOAT4X4*)pData->mWorld,               world );
+    XMStoreFloat4x4( (XMFLOAT4X4*)pData->mWorldViewProjection, world * view * projection );
+
+    CPUTCamera *pShadowCamera = gpSample->GetShadowCamera();
+    if( pShadowCamera )
+    {
+        XMMATRIX shadowView((float*)pShadowCamera->GetViewMatrix());
+        XMMATRIX shadowProjection((float*)pShadowCamera->GetProjectionMatrix());
+        XMStoreFloat4x4( (XMFLOAT4X4*)pData->mLightWorldViewProjection, world * shadowView * shadowProjection );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTModelDX11::BindConstantBuffer(CPUTRenderParameters &renderParams)
+{
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
     // set constant buffer 1 as model constant buffer
-    pContext->VSSetConstantBuffers( 0, 1, &mpModelConstantBuffer );
-    pContext->PSSetConstantBuffers( 0, 1, &mpModelConstantBuffer );
+    pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_VERTEX, 0, 1, (CPUTBackendHandle*)&mpModelConstantBuffer );
+    pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_PIXEL,  0, 1, (CPUTBackendHandle*)&mpModelConstantBuffer );
 }
 
 // Render - render this model (only)
@@ -105,8 +190,14 @@ void CPUTModelDX11::Render(CPUTRenderParameters &renderParams)
 #endif
     if( !renderParams.mDrawModels ) { return; }
 
-    // TODO: add world-space bounding box to model so we don't need to do that work every frame
-    if( !pParams->mRenderOnlyVisibleModels || !pCamera || pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace ) )
+    // The asset set normally culls all of its models in one batch before rendering them.  Fall back to testing this model alone.
+    bool visible = !pParams->mRenderOnlyVisibleModels || !pCamera ||
+        (pParams->mModelsFrustumCulled ? mFrustumVisible : pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace ));
+    if( visible && pParams->mpRenderQueue )
+    {
+        QueueMeshes( renderParams, renderParams.mRenderPass );
+    }
+    else if( visible )
     {
         // loop over all meshes in this model and draw them
         for(UINT ii=0; ii<mMeshCount; ii++)
@@ -141,8 +232,14 @@ void CPUTModelDX11::RenderShadow(CPUTRenderParameters &renderParams)
 #endif
     if( !renderParams.mDrawModels ) { return; }
 
-    // TODO: add world-space bounding box to model so we don't need to do that work every frame
-    if( !pParams->mRenderOnlyVisibleModels || !pCamera || pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace ) )
+    // The asset set normally culls all of its models in one batch before rendering them.  Fall back to testing this model alone.
+    bool visible = !pParams->mRenderOnlyVisibleModels || !pCamera ||
+        (pParams->mModelsFrustumCulled ? mFrustumVisible : pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace ));
+    if( visible && pParams->mpRenderQueue )
+    {
+        QueueMeshes( renderParams, CPUT_RENDER_PASS_SHADOW );
+    }
+    else if( visible )
     {
         // loop over all meshes in this model and draw them
         for(UINT ii=0; ii<mMeshCount; ii++)
@@ -236,6 +333,7 @@ CPUTResult CPUTModelDX11::LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPU
             // Reference the master model's mesh.  Don't create a new one.
             mpMesh[ii] = pMasterModelDX->mpMesh[ii];
             mpMesh[ii]->AddRef();
+            mPayloadFilename = pMasterModelDX->mPayloadFilename;
         }
         else
         {
@@ -44,18 +44,32 @@ class CPUTModelDX11 : public CPUTModel
 {
 protected:
     ID3D11Buffer      *mpModelConstantBuffer;
+    UINT               mConstantsSubmitIndex; // Render queue Submit() that last uploaded mpModelConstantBuffer
+    UINT               mRingSubmitIndex;      // Render queue Submit() that last uploaded to the upload ring
+    UINT               mRingOffset;           // Where, in the upload ring's buffer
+
+    void          FillConstantBuffer(CPUTModelConstantBuffer *pCb);
+    void          FillInstanceData(CPUTInstanceData *pData);
+    void          UpdateConstantBuffer(CPUTRenderParameters &renderParams);
+    void          BindConstantBuffer(CPUTRenderParameters &renderParams);
 
     // Destructor is not public.  Must release instead of delete.
     ~CPUTModelDX11(){ SAFE_RELEASE(mpModelConstantBuffer); }
 
 public:
     CPUTModelDX11() :
-        mpModelConstantBuffer(NULL)
+        mpModelConstantBuffer(NULL),
+        mConstantsSubmitIndex(0),
+        mRingSubmitIndex(0),
+        mRingOffset(0)
     {}
 
     CPUTMeshDX11 *GetMesh(const UINT index) const;
     CPUTResult    LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel=NULL);
     void          SetRenderStates(CPUTRenderParameters &renderParams);
+    bool          UploadQueuedConstants(CPUTRenderParameters &renderParams, UINT submitIndex);
+    void          UpdateQueuedConstants(CPUTRenderParameters &renderParams, UINT submitIndex);
+    void          SetQueuedRenderStates(CPUTRenderParameters &renderParams, UINT submitIndex);
     void          Render(CPUTRenderParameters &renderParams);
     void          RenderShadow(CPUTRenderParameters &renderParams);
     void          SetMaterial(UINT ii, CPUTMaterial *pMaterial);
@@ -0,0 +1,513 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTOcclusionCuller.h"
+#include "CPUTProfiler.h"
+#include "CPUTThreadPool.h"
+#include "CPUTAllocator.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#   include <xmmintrin.h>
+#   define CPUT_OCCLUSION_SSE
+#endif
+
+#define OCCLUSION_TEST_BATCH 64
+
+//-----------------------------------------------------------------------------
+static void MultiplyMatrix( float *pOut, const float *pA, const float *pB )
+{
+    for( int ii=0; ii<4; ii++ )
+    {
+        for( int jj=0; jj<4; jj++ )
+        {
+            pOut[ii*4+jj] = pA[ii*4+0]*pB[jj] + pA[ii*4+1]*pB[4+jj] + pA[ii*4+2]*pB[8+jj] + pA[ii*4+3]*pB[12+jj];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static inline void TransformPoint( float *pClip, const float *pPosition, const float *pMatrix )
+{
+    for( int jj=0; jj<4; jj++ )
+    {
+        pClip[jj] = pPosition[0]*pMatrix[jj] + pPosition[1]*pMatrix[4+jj] + pPosition[2]*pMatrix[8+jj] + pMatrix[12+jj];
+    }
+}
+
+//-----------------------------------------------------------------------------
+class CPUTOcclusionRasterTask : public CPUTTask
+{
+public:
+    CPUTOcclusionCuller *mpCuller;
+    uint32_t             mRowsPerBand;
+
+    void Execute( uint32_t taskIndex, uint32_t /*threadIndex*/ )
+    {
+        mpCuller->RasterizeBand( taskIndex * mRowsPerBand, mRowsPerBand );
+    }
+};
+
+//-----------------------------------------------------------------------------
+class CPUTOcclusionTestTask : public CPUTTask
+{
+public:
+    const CPUTOcclusionCuller *mpCuller;
+    const float3              *mpCenters;
+    const float3              *mpHalves;
+    uint32_t                   mCount;
+    uint8_t                   *mpVisible;
+    std::vector<uint32_t>      mCulled; // Per task
+
+    void Execute( uint32_t taskIndex, uint32_t /*threadIndex*/ )
+    {
+        uint32_t first = taskIndex * OCCLUSION_TEST_BATCH;
+        uint32_t count = mCount - first < OCCLUSION_TEST_BATCH ? mCount - first : OCCLUSION_TEST_BATCH;
+        mCulled[taskIndex] = mpCuller->TestBoxRange( mpCenters, mpHalves, first, count, mpVisible );
+    }
+};
+
+//-----------------------------------------------------------------------------
+CPUTOcclusionCuller::CPUTOcclusionCuller( uint32_t width, uint32_t height ) :
+    mNearW(0.0f),
+    mpThreadPool(NULL)
+{
+    // Whole tiles only
+    mTilesX = (width  + TILE_WIDTH  - 1) / TILE_WIDTH;
+    mTilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    mWidth  = mTilesX * TILE_WIDTH;
+    mHeight = mTilesY * TILE_HEIGHT;
+    mDepth.resize( mWidth * mHeight, 0.0f );
+    mTileDepth.resize( mTilesX * mTilesY, 0.0f );
+    memset( mViewProjection, 0, sizeof(mViewProjection) );
+    memset( &mStats, 0, sizeof(mStats) );
+}
+
+//-----------------------------------------------------------------------------
+CPUTOcclusionCuller::~CPUTOcclusionCuller()
+{
+    ClearOccluders();
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTOcclusionCuller::AddOccluder( const float3 *pPositions, uint32_t vertexCount, const uint32_t *pIndices, uint32_t indexCount, const float4x4 &world )
+{
+    Occluder *pOccluder = new Occluder();
+    pOccluder->mPositions.resize( vertexCount * 3 );
+    for( uint32_t ii=0; ii<vertexCount; ii++ )
+    {
+        pOccluder->mPositions[ii*3+0] = pPositions[ii].x;
+        pOccluder->mPositions[ii*3+1] = pPositions[ii].y;
+        pOccluder->mPositions[ii*3+2] = pPositions[ii].z;
+    }
+    pOccluder->mIndices.assign( pIndices, pIndices + indexCount - indexCount % 3 );
+    memcpy( pOccluder->mWorld, &world, sizeof(pOccluder->mWorld) );
+    pOccluder->mEnabled = true;
+    mOccluders.push_back( pOccluder );
+    return (uint32_t)mOccluders.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::SetOccluderWorld( uint32_t occluder, const float4x4 &world )
+{
+    assert( occluder < mOccluders.size() );
+    memcpy( mOccluders[occluder]->mWorld, &world, sizeof(mOccluders[occluder]->mWorld) );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::SetOccluderEnabled( uint32_t occluder, bool enabled )
+{
+    assert( occluder < mOccluders.size() );
+    mOccluders[occluder]->mEnabled = enabled;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::ClearOccluders()
+{
+    for( size_t ii=0; ii<mOccluders.size(); ii++ )
+    {
+        delete mOccluders[ii];
+    }
+    mOccluders.clear();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::BeginFrame( const float4x4 &viewProjection, float nearClipDistance )
+{
+    memcpy( mViewProjection, &viewProjection, sizeof(mViewProjection) );
+    mNearW = nearClipDistance > 0.0f ? nearClipDistance : 1e-4f;
+    memset( &mStats, 0, sizeof(mStats) );
+    mTriangles.clear();
+}
+
+// Clips a clip-space triangle against the near plane (w >= near) and sets up the pieces.
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::ClipAndSetupTriangle( const float *pClip0, const float *pClip1, const float *pClip2 )
+{
+    const float *pIn[3] = { pClip0, pClip1, pClip2 };
+    int insideCount = (pClip0[3] >= mNearW) + (pClip1[3] >= mNearW) + (pClip2[3] >= mNearW);
+    if( 3 == insideCount )
+    {
+        SetupTriangle( pClip0, pClip1, pClip2 );
+        return;
+    }
+    if( 0 == insideCount )
+    {
+        return;
+    }
+
+    float polygon[4][4];
+    int   vertexCount = 0;
+    for( int ii=0; ii<3; ii++ )
+    {
+        const float *pA = pIn[ii];
+        const float *pB = pIn[(ii+1)%3];
+        bool aInside = pA[3] >= mNearW;
+        bool bInside = pB[3] >= mNearW;
+        if( aInside )
+        {
+            memcpy( polygon[vertexCount++], pA, 4 * sizeof(float) );
+        }
+        if( aInside != bInside )
+        {
+            float t = (mNearW - pA[3]) / (pB[3] - pA[3]);
+            for( int jj=0; jj<4; jj++ )
+            {
+                polygon[vertexCount][jj] = pA[jj] + (pB[jj] - pA[jj]) * t;
+            }
+            polygon[vertexCount++][3] = mNearW;
+        }
+    }
+    for( int ii=1; ii+1<vertexCount; ii++ )
+    {
+        SetupTriangle( polygon[0], polygon[ii], polygon[ii+1] );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::SetupTriangle( const float *pClip0, const float *pClip1, const float *pClip2 )
+{
+    const float *pClip[3] = { pClip0, pClip1, pClip2 };
+    float x[3], y[3], invW[3];
+    for( int ii=0; ii<3; ii++ )
+    {
+        invW[ii] = 1.0f / pClip[ii][3];
+        x[ii]    = (pClip[ii][0] * invW[ii] *  0.5f + 0.5f) * mWidth;
+        y[ii]    = (pClip[ii][1] * invW[ii] * -0.5f + 0.5f) * mHeight;
+    }
+
+    float minX = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+    float maxX = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+    float minY = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+    float maxY = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+    if( maxX < 0.0f || maxY < 0.0f || minX >= (float)mWidth || minY >= (float)mHeight )
+    {
+        return;
+    }
+    float area = (x[1]-x[0])*(y[2]-y[0]) - (x[2]-x[0])*(y[1]-y[0]);
+    if( fabsf(area) < 1e-6f )
+    {
+        return;
+    }
+
+    Triangle triangle;
+    triangle.mMinX = minX < 0.0f ? 0 : (int)minX;
+    triangle.mMinY = minY < 0.0f ? 0 : (int)minY;
+    triangle.mMaxX = maxX >= (float)(mWidth-1)  ? (int)mWidth  - 1 : (int)maxX;
+    triangle.mMaxY = maxY >= (float)(mHeight-1) ? (int)mHeight - 1 : (int)maxY;
+
+    // Edge ii runs from vertex ii to ii+1.  Its value at the opposite vertex is the (signed) area.
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    float invArea = 1.0f / area;
+    float depthA = 0.0f, depthB = 0.0f, depthC = 0.0f;
+    for( int ii=0; ii<3; ii++ )
+    {
+        int jj = (ii+1) % 3;
+        int kk = (ii+2) % 3; // Opposite vertex
+        float a = y[ii] - y[jj];
+        float b = x[jj] - x[ii];
+        float c = x[ii]*y[jj] - x[jj]*y[ii];
+        depthA += a * invW[kk];
+        depthB += b * invW[kk];
+        depthC += c * invW[kk];
+        triangle.mEdge[ii][0] = a * sign;
+        triangle.mEdge[ii][1] = b * sign;
+        triangle.mEdge[ii][2] = c * sign;
+    }
+    triangle.mDepth[0] = depthA * invArea;
+    triangle.mDepth[1] = depthB * invArea;
+    triangle.mDepth[2] = depthC * invArea;
+    mTriangles.push_back( triangle );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::RenderOccluders( CPUTArena *pFrameArena )
+{
+    CPUT_PROFILE_ZONE("Render occluders");
+    CPUTArena  localArena;
+    CPUTArena *pArena = pFrameArena ? pFrameArena : &localArena;
+
+    // Transform and set up every occluder triangle
+    for( size_t oo=0; oo<mOccluders.size(); oo++ )
+    {
+        const Occluder *pOccluder = mOccluders[oo];
+        if( !pOccluder->mEnabled )
+        {
+            continue;
+        }
+        float worldViewProjection[16];
+        MultiplyMatrix( worldViewProjection, pOccluder->mWorld, mViewProjection );
+
+        uint32_t vertexCount = (uint32_t)pOccluder->mPositions.size() / 3;
+        CPUTArenaScope scope( *pArena );
+        float *pClip = pArena->AllocateArray<float>( vertexCount * 4 );
+        for( uint32_t ii=0; ii<vertexCount; ii++ )
+        {
+            TransformPoint( &pClip[ii*4], &pOccluder->mPositions[ii*3], worldViewProjection );
+        }
+        const uint32_t *pIndices = pOccluder->mIndices.empty() ? NULL : &pOccluder->mIndices[0];
+        for( size_t ii=0; ii<pOccluder->mIndices.size(); ii+=3 )
+        {
+            ClipAndSetupTriangle( &pClip[pIndices[ii]*4], &pClip[pIndices[ii+1]*4], &pClip[pIndices[ii+2]*4] );
+        }
+    }
+    mStats.mOccluderTriangles = (uint32_t)mTriangles.size();
+    CPUT_PROFILE_COUNTER("Occluder triangles", mStats.mOccluderTriangles);
+
+    // Rasterize in bands of whole tile rows
+    uint32_t bandCount   = mpThreadPool ? mpThreadPool->GetThreadCount() * 2 : 1;
+    bandCount            = bandCount > mTilesY ? mTilesY : bandCount;
+    uint32_t tileRows    = (mTilesY + bandCount - 1) / bandCount;
+    bandCount            = (mTilesY + tileRows - 1) / tileRows;
+
+    CPUTOcclusionRasterTask task;
+    task.mpCuller     = this;
+    task.mRowsPerBand = tileRows * TILE_HEIGHT;
+    if( mpThreadPool )
+    {
+        mpThreadPool->ParallelFor( &task, bandCount );
+    }
+    else
+    {
+        for( uint32_t ii=0; ii<bandCount; ii++ )
+        {
+            task.Execute( ii, 0 );
+        }
+    }
+}
+
+// Clears, rasterizes and reduces rows [firstRow, firstRow + rowCount).  Bands start on a tile row.
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::RasterizeBand( uint32_t firstRow, uint32_t rowCount )
+{
+    if( firstRow >= mHeight )
+    {
+        return;
+    }
+    CPUT_PROFILE_ZONE("Rasterize occluder band");
+    rowCount = firstRow + rowCount > mHeight ? mHeight - firstRow : rowCount;
+    int lastRow = (int)(firstRow + rowCount) - 1;
+    memset( &mDepth[firstRow * mWidth], 0, rowCount * mWidth * sizeof(float) );
+
+    for( size_t tt=0; tt<mTriangles.size(); tt++ )
+    {
+        const Triangle &tri = mTriangles[tt];
+        int y0 = tri.mMinY > (int)firstRow ? tri.mMinY : (int)firstRow;
+        int y1 = tri.mMaxY < lastRow ? tri.mMaxY : lastRow;
+        if( y0 > y1 )
+        {
+            continue;
+        }
+        // Start on a multiple of four so whole groups of four pixels stay inside the row
+        int x0 = tri.mMinX & ~3;
+        int x1 = tri.mMaxX;
+        for( int yy=y0; yy<=y1; yy++ )
+        {
+            float  fy   = (float)yy + 0.5f;
+            float  fx   = (float)x0 + 0.5f;
+            float *pRow = &mDepth[yy * mWidth];
+            float  e0   = tri.mEdge[0][0]*fx + tri.mEdge[0][1]*fy + tri.mEdge[0][2];
+            float  e1   = tri.mEdge[1][0]*fx + tri.mEdge[1][1]*fy + tri.mEdge[1][2];
+            float  e2   = tri.mEdge[2][0]*fx + tri.mEdge[2][1]*fy + tri.mEdge[2][2];
+            float  z    = tri.mDepth[0]*fx   + tri.mDepth[1]*fy   + tri.mDepth[2];
+#if defined(CPUT_OCCLUSION_SSE)
+            const __m128 lane   = _mm_setr_ps( 0.0f, 1.0f, 2.0f, 3.0f );
+            const __m128 zero   = _mm_setzero_ps();
+            __m128 edge0  = _mm_add_ps( _mm_set1_ps(e0), _mm_mul_ps( lane, _mm_set1_ps(tri.mEdge[0][0]) ) );
+            __m128 edge1  = _mm_add_ps( _mm_set1_ps(e1), _mm_mul_ps( lane, _mm_set1_ps(tri.mEdge[1][0]) ) );
+            __m128 edge2  = _mm_add_ps( _mm_set1_ps(e2), _mm_mul_ps( lane, _mm_set1_ps(tri.mEdge[2][0]) ) );
+            __m128 depth  = _mm_add_ps( _mm_set1_ps(z),  _mm_mul_ps( lane, _mm_set1_ps(tri.mDepth[0]) ) );
+            __m128 step0  = _mm_set1_ps( tri.mEdge[0][0] * 4.0f );
+            __m128 step1  = _mm_set1_ps( tri.mEdge[1][0] * 4.0f );
+            __m128 step2  = _mm_set1_ps( tri.mEdge[2][0] * 4.0f );
+            __m128 stepZ  = _mm_set1_ps( tri.mDepth[0]   * 4.0f );
+            for( int xx=x0; xx<=x1; xx+=4 )
+            {
+                __m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( edge0, zero ), _mm_cmpge_ps( edge1, zero ) ), _mm_cmpge_ps( edge2, zero ) );
+                if( _mm_movemask_ps( inside ) )
+                {
+                    __m128 old = _mm_loadu_ps( pRow + xx );
+                    _mm_storeu_ps( pRow + xx, _mm_or_ps( _mm_and_ps( inside, _mm_max_ps( old, depth ) ), _mm_andnot_ps( inside, old ) ) );
+                }
+                edge0 = _mm_add_ps( edge0, step0 );
+                edge1 = _mm_add_ps( edge1, step1 );
+                edge2 = _mm_add_ps( edge2, step2 );
+                depth = _mm_add_ps( depth, stepZ );
+            }
+#else
+            for( int xx=x0; xx<=x1; xx++ )
+            {
+                if( e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f && z > pRow[xx] )
+                {
+                    pRow[xx] = z;
+                }
+                e0 += tri.mEdge[0][0];
+                e1 += tri.mEdge[1][0];
+                e2 += tri.mEdge[2][0];
+                z  += tri.mDepth[0];
+            }
+#endif
+        }
+    }
+
+    // Reduce to the farthest depth in each tile
+    for( uint32_t ty=firstRow/TILE_HEIGHT; ty<(firstRow+rowCount)/TILE_HEIGHT; ty++ )
+    {
+        for( uint32_t tx=0; tx<mTilesX; tx++ )
+        {
+            float farthest = mDepth[ty*TILE_HEIGHT*mWidth + tx*TILE_WIDTH];
+            for( uint32_t yy=0; yy<TILE_HEIGHT; yy++ )
+            {
+                const float *pRow = &mDepth[(ty*TILE_HEIGHT + yy)*mWidth + tx*TILE_WIDTH];
+                for( uint32_t xx=0; xx<TILE_WIDTH; xx++ )
+                {
+                    farthest = pRow[xx] < farthest ? pRow[xx] : farthest;
+                }
+            }
+            mTileDepth[ty*mTilesX + tx] = farthest;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTOcclusionCuller::IsVisible( const float3 &center, const float3 &half ) const
+{
+    // Corner clip positions are the center's plus/minus the half-extent's axis contributions
+    float c[4], hx[4], hy[4], hz[4];
+    TransformPoint( c, center.f, mViewProjection );
+    for( int jj=0; jj<4; jj++ )
+    {
+        hx[jj] = half.x * mViewProjection[jj];
+        hy[jj] = half.y * mViewProjection[4+jj];
+        hz[jj] = half.z * mViewProjection[8+jj];
+    }
+
+    float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f, nearest = 0.0f;
+    for( int ii=0; ii<8; ii++ )
+    {
+        float sx = ii & 1 ? 1.0f : -1.0f;
+        float sy = ii & 2 ? 1.0f : -1.0f;
+        float sz = ii & 4 ? 1.0f : -1.0f;
+        float w  = c[3] + sx*hx[3] + sy*hy[3] + sz*hz[3];
+        if( w < mNearW )
+        {
+            return true; // Crosses the near plane
+        }
+        float invW = 1.0f / w;
+        float x = ((c[0] + sx*hx[0] + sy*hy[0] + sz*hz[0]) * invW *  0.5f + 0.5f) * mWidth;
+        float y = ((c[1] + sx*hx[1] + sy*hy[1] + sz*hz[1]) * invW * -0.5f + 0.5f) * mHeight;
+        minX = x < minX ? x : minX;  maxX = x > maxX ? x : maxX;
+        minY = y < minY ? y : minY;  maxY = y > maxY ? y : maxY;
+        nearest = invW > nearest ? invW : nearest;
+    }
+    if( maxX < 0.0f || maxY < 0.0f || minX >= (float)mWidth || minY >= (float)mHeight )
+    {
+        return true; // Off screen.  That's the frustum culler's call.
+    }
+    int px0 = minX < 0.0f ? 0 : (int)minX;
+    int py0 = minY < 0.0f ? 0 : (int)minY;
+    int px1 = maxX >= (float)(mWidth-1)  ? (int)mWidth  - 1 : (int)maxX;
+    int py1 = maxY >= (float)(mHeight-1) ? (int)mHeight - 1 : (int)maxY;
+
+    for( int ty=py0/TILE_HEIGHT; ty<=py1/TILE_HEIGHT; ty++ )
+    {
+        for( int tx=px0/TILE_WIDTH; tx<=px1/TILE_WIDTH; tx++ )
+        {
+            if( mTileDepth[ty*mTilesX + tx] > nearest )
+            {
+                continue; // Everything in this tile is in front of the box
+            }
+            int y0 = ty*TILE_HEIGHT > py0 ? ty*TILE_HEIGHT : py0;
+            int y1 = ty*TILE_HEIGHT + TILE_HEIGHT - 1 < py1 ? ty*TILE_HEIGHT + TILE_HEIGHT - 1 : py1;
+            int x0 = tx*TILE_WIDTH > px0 ? tx*TILE_WIDTH : px0;
+            int x1 = tx*TILE_WIDTH + TILE_WIDTH - 1 < px1 ? tx*TILE_WIDTH + TILE_WIDTH - 1 : px1;
+            for( int yy=y0; yy<=y1; yy++ )
+            {
+                const float *pRow = &mDepth[yy*mWidth];
+                for( int xx=x0; xx<=x1; xx++ )
+                {
+                    if( pRow[xx] <= nearest )
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTOcclusionCuller::TestBoxRange( const float3 *pCenters, const float3 *pHalves, uint32_t first, uint32_t count, uint8_t *pVisible ) const
+{
+    uint32_t culled = 0;
+    for( uint32_t ii=first; ii<first+count; ii++ )
+    {
+        bool visible = IsVisible( pCenters[ii], pHalves[ii] );
+        pVisible[ii] = visible ? 1 : 0;
+        culled += visible ? 0 : 1;
+    }
+    return culled;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOcclusionCuller::TestBoxes( const float3 *pCenters, const float3 *pHalves, uint32_t count, uint8_t *pVisible )
+{
+    uint32_t culled = 0;
+    if( mpThreadPool && count > OCCLUSION_TEST_BATCH )
+    {
+        CPUTOcclusionTestTask task;
+        task.mpCuller  = this;
+        task.mpCenters = pCenters;
+        task.mpHalves  = pHalves;
+        task.mCount    = count;
+        task.mpVisible = pVisible;
+        uint32_t taskCount = (count + OCCLUSION_TEST_BATCH - 1) / OCCLUSION_TEST_BATCH;
+        task.mCulled.resize( taskCount, 0 );
+        mpThreadPool->ParallelFor( &task, taskCount );
+        for( uint32_t ii=0; ii<taskCount; ii++ )
+        {
+            culled += task.mCulled[ii];
+        }
+    }
+    else
+    {
+        culled = TestBoxRange( pCenters, pHalves, 0, count, pVisible );
+    }
+    mStats.mOccludeesTested += count;
+    mStats.mOccludeesCulled += culled;
+}
@@ -0,0 +1,127 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTOCCLUSIONCULLER_H__
+#define __CPUTOCCLUSIONCULLER_H__
+
+// Software occlusion culling.  Occluder meshes are rasterized on the CPU into a
+// small depth buffer, which is then reduced to one farthest-depth value per tile.
+// Occludee bounding boxes are tested against the tiles first and only touch
+// individual pixels in tiles that aren't fully in front of them.
+//
+// Depth is stored as 1/w (larger is nearer, 0 is empty) so results don't depend
+// on the projection's depth mapping (e.g., CPUT's reversed-Z cameras).
+//
+// Typical frame:
+//     culler.BeginFrame( view * projection, camera near distance );
+//     culler.RenderOccluders();
+//     visible = culler.IsVisible( center, half );   // or TestBoxes()
+//
+// Rasterization is split into horizontal bands, and box tests into batches,
+// across an optional CPUTThreadPool.
+#include "CPUTMath.h"
+#include <stdint.h>
+#include <vector>
+
+class CPUTArena;
+class CPUTThreadPool;
+
+//-----------------------------------------------------------------------------
+struct CPUTOcclusionStats
+{
+    uint32_t mOccluderTriangles;  // Triangles rasterized (after near-plane clipping and trivial rejection)
+    uint32_t mOccludeesTested;
+    uint32_t mOccludeesCulled;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTOcclusionCuller
+{
+public:
+    enum
+    {
+        TILE_WIDTH  = 8,
+        TILE_HEIGHT = 8,
+    };
+
+protected:
+    struct Occluder
+    {
+        std::vector<float>    mPositions; // x, y, z per vertex
+        std::vector<uint32_t> mIndices;
+        float                 mWorld[16];
+        bool                  mEnabled;
+    };
+
+    // Set-up screen-space triangle
+    struct Triangle
+    {
+        float mEdge[3][3];  // A, B, C: A*x + B*y + C >= 0 inside
+        float mDepth[3];    // 1/w = a*x + b*y + c
+        int   mMinX, mMaxX, mMinY, mMaxY;
+    };
+
+    uint32_t               mWidth;
+    uint32_t               mHeight;
+    uint32_t               mTilesX;
+    uint32_t               mTilesY;
+    std::vector<float>     mDepth;      // 1/w per pixel
+    std::vector<float>     mTileDepth;  // Farthest (smallest) 1/w in each tile
+    std::vector<Occluder*> mOccluders;
+    std::vector<Triangle>  mTriangles;
+    float                  mViewProjection[16];
+    float                  mNearW;
+    CPUTThreadPool        *mpThreadPool;
+    CPUTOcclusionStats     mStats;
+
+    void SetupTriangle( const float *pClip0, const float *pClip1, const float *pClip2 );
+    void ClipAndSetupTriangle( const float *pClip0, const float *pClip1, const float *pClip2 );
+
+public:
+    CPUTOcclusionCuller( uint32_t width = 320, uint32_t height = 192 );
+    ~CPUTOcclusionCuller();
+
+    // Occluders are copied.  pPositions holds vertexCount float3s in object space.
+    uint32_t AddOccluder( const float3 *pPositions, uint32_t vertexCount, const uint32_t *pIndices, uint32_t indexCount, const float4x4 &world );
+    void     SetOccluderWorld( uint32_t occluder, const float4x4 &world );
+    void     SetOccluderEnabled( uint32_t occluder, bool enabled );
+    void     ClearOccluders();
+    uint32_t GetOccluderCount() const { return (uint32_t)mOccluders.size(); }
+
+    void     SetThreadPool( CPUTThreadPool *pThreadPool ) { mpThreadPool = pThreadPool; }
+
+    // viewProjection uses CPUT's row-vector convention (clip = float4(p,1) * viewProjection)
+    void     BeginFrame( const float4x4 &viewProjection, float nearClipDistance );
+    // The transformed vertices go in pFrameArena if given (see CPUT::GetFrameArena())
+    void     RenderOccluders( CPUTArena *pFrameArena = NULL );
+
+    // Boxes that straddle the near plane or are off-screen are reported visible.
+    bool     IsVisible( const float3 &center, const float3 &half ) const;
+    // pVisible[ii] is set to 0 or 1.  Updates the frame's statistics.
+    void     TestBoxes( const float3 *pCenters, const float3 *pHalves, uint32_t count, uint8_t *pVisible );
+
+    // Counters since the last BeginFrame()
+    const CPUTOcclusionStats &GetStats() const { return mStats; }
+
+    // Task bodies (see CPUTThreadPool).  Not for general use.
+    void     RasterizeBand( uint32_t firstRow, uint32_t rowCount );
+    uint32_t TestBoxRange( const float3 *pCenters, const float3 *pHalves, uint32_t first, uint32_t count, uint8_t *pVisible ) const;
+
+    uint32_t     GetWidth() const  { return mWidth; }
+    uint32_t     GetHeight() const { return mHeight; }
+    const float *GetDepth() const  { return &mDepth[0]; } // For debug display
+};
+
+#endif // __CPUTOCCLUSIONCULLER_H__
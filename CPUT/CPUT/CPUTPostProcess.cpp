@@ -21,6 +21,74 @@
 #include "CPUTMaterial.h"
 #include "CPUTSprite.h"
 
+// For the render graph's memory estimates.  Render target formats only.
+//-----------------------------------------
+static UINT BytesPerPixel( DXGI_FORMAT format )
+{
+    if( format <= DXGI_FORMAT_R32G32B32A32_SINT ) { return 16; }
+    if( format <= DXGI_FORMAT_R32G32B32_SINT )    { return 12; }
+    if( format <= DXGI_FORMAT_X32_TYPELESS_G8X24_UINT ) { return 8; }
+    if( format <= DXGI_FORMAT_X24_TYPELESS_G8_UINT )    { return 4; }
+    if( format <= DXGI_FORMAT_R16_SINT )          { return 2; }
+    if( format <= DXGI_FORMAT_A8_UNORM )          { return 1; }
+    return 4;
+}
+
+#ifdef _DEBUG
+// The passes' reads were declared by hand, and the graph culls and aliases by them.  Check
+// them against the loaded materials: each graph texture a material binds must be read by
+// its pass, and each read must be bound, unless the pass also writes it (it blends).
+// Aliased resources share a texture, so the checks go by texture.
+//-----------------------------------------
+static void CheckPassReads( const CPUTRenderGraph &graph, uint32_t pass, const CPUTMaterial &material, const CPUTRenderGraphResource *pResources, UINT resourceCount )
+{
+    for( UINT ii=0; ii<resourceCount; ii++ )
+    {
+        CPUTRenderTargetColor *pTarget = (CPUTRenderTargetColor*)graph.GetTexture( pResources[ii] );
+        if( !pTarget || !graph.HasAccess( pass, pResources[ii], false ) || graph.HasAccess( pass, pResources[ii], true ) )
+        {
+            continue;
+        }
+        bool bound = false;
+        for( UINT jj=0; jj<CPUT_MATERIAL_MAX_TEXTURE_SLOTS; jj++ )
+        {
+            bound |= material.GetTexture( jj ) == pTarget->GetColorTexture();
+        }
+        ASSERT( bound, _L("A post process pass reads a texture its material doesn't bind") );
+    }
+    for( UINT jj=0; jj<CPUT_MATERIAL_MAX_TEXTURE_SLOTS; jj++ )
+    {
+        CPUTTexture *pTexture = material.GetTexture( jj );
+        bool inGraph = false, read = false;
+        for( UINT ii=0; pTexture && ii<resourceCount; ii++ )
+        {
+            CPUTRenderTargetColor *pTarget = (CPUTRenderTargetColor*)graph.GetTexture( pResources[ii] );
+            if( pTarget && pTarget->GetColorTexture() == pTexture )
+            {
+                inGraph = true;
+                read   |= graph.HasAccess( pass, pResources[ii], false );
+            }
+        }
+        ASSERT( read || !inGraph, _L("A post process material binds a graph texture its pass doesn't read") );
+    }
+}
+#endif
+
+//-----------------------------------------
+void CPUTPostProcessPass::Execute( CPUTRenderGraph &graph, void *pContext )
+{
+    CPUTRenderParameters &renderParams = *(CPUTRenderParameters*)pContext;
+    if( CPUT_RENDER_GRAPH_NONE == mTarget )
+    {
+        mpSprite->DrawSprite( renderParams, *mpMaterial );
+        return;
+    }
+    CPUTRenderTargetColor *pTarget = (CPUTRenderTargetColor*)graph.GetTexture( mTarget );
+    pTarget->SetRenderTarget( renderParams );
+    mpSprite->DrawSprite( renderParams, *mpMaterial );
+    pTarget->RestoreRenderTarget( renderParams );
+}
+
 //-----------------------------------------
 CPUTPostProcess::~CPUTPostProcess() {
     SAFE_DELETE( mpFullScreenSprite );
@@ -34,11 +102,8 @@ CPUTPostProcess::~CPUTPostProcess() {
     SAFE_RELEASE( mpMaterialDownSampleBackBuffer4x4 );
     SAFE_RELEASE( mpMaterialSpriteNoAlpha );
 
+    mGraph.Reset(); // Deletes the transient targets
     SAFE_DELETE(mpRT1x1 );
-    SAFE_DELETE(mpRT4x4 );
-    SAFE_DELETE(mpRT64x64 );
-    SAFE_DELETE(mpRTDownSample4x4PingPong );
-    SAFE_DELETE(mpRTDownSample4x4 );
     // SAFE_DELETE(mpRTSourceRenderTarget ); // We don't allocate this.  Don't delete it.
 }
 
@@ -52,18 +117,64 @@ void CPUTPostProcess::CreatePostProcess(
     UINT sourceWidth          = mpRTSourceRenderTarget->GetWidth();
     UINT sourceHeight         = mpRTSourceRenderTarget->GetHeight();
 
-    mpRTDownSample4x4         = new CPUTRenderTargetColor();
-    mpRTDownSample4x4PingPong = new CPUTRenderTargetColor();
-    mpRT64x64                 = new CPUTRenderTargetColor();
-    mpRT4x4                   = new CPUTRenderTargetColor();
     mpRT1x1                   = new CPUTRenderTargetColor();
-
-    mpRTDownSample4x4->CreateRenderTarget(         _L("$PostProcessDownsample4x4"),         sourceWidth/4, sourceHeight/4,          sourceFormat );
-    mpRTDownSample4x4PingPong->CreateRenderTarget( _L("$PostProcessDownsample4x4PingPong"), sourceWidth/4, sourceHeight/4,          sourceFormat );
-    mpRT64x64->CreateRenderTarget(                 _L("$PostProcessRT64x64"),                          64,             64, DXGI_FORMAT_R32_FLOAT ); 
-    mpRT4x4->CreateRenderTarget(                   _L("$PostProcessRT4x4"),                             8,              8, DXGI_FORMAT_R32_FLOAT ); 
     mpRT1x1->CreateRenderTarget(                   _L("$PostProcessRT1x1"),                             1,              1, DXGI_FORMAT_R32_FLOAT );
 
+    // The transients.  Materials bind them by these names, so compile before loading the materials.
+    CPUTRenderGraphTextureDesc downSampleDesc = { sourceWidth/4, sourceHeight/4, sourceFormat, BytesPerPixel(sourceFormat), 1, 0 };
+    CPUTRenderGraphTextureDesc desc64x64      = { 64, 64, DXGI_FORMAT_R32_FLOAT, 4, 1, 0 };
+    CPUTRenderGraphTextureDesc desc4x4        = {  8,  8, DXGI_FORMAT_R32_FLOAT, 4, 1, 0 };
+    CPUTRenderGraphResource source            = mGraph.ImportTexture( CPUTStringTable::Intern(_L("$PostProcessSource")), mpRTSourceRenderTarget );
+    CPUTRenderGraphResource rt1x1             = mGraph.ImportTexture( CPUTStringTable::Intern(_L("$PostProcessRT1x1")),  mpRT1x1 );
+    CPUTRenderGraphResource downSample4x4     = mGraph.CreateTexture( CPUTStringTable::Intern(_L("$PostProcessDownsample4x4")),         downSampleDesc );
+    CPUTRenderGraphResource pingPong          = mGraph.CreateTexture( CPUTStringTable::Intern(_L("$PostProcessDownsample4x4PingPong")), downSampleDesc );
+    CPUTRenderGraphResource rt64x64           = mGraph.CreateTexture( CPUTStringTable::Intern(_L("$PostProcessRT64x64")),               desc64x64 );
+    CPUTRenderGraphResource rt4x4             = mGraph.CreateTexture( CPUTStringTable::Intern(_L("$PostProcessRT4x4")),                 desc4x4 );
+
+    // Passes are added in CPUT_POST_PROCESS_PASS order.  The reads are checked against the
+    // materials once they're loaded.
+    uint32_t pass = mGraph.AddPass( "Post: downsample", &mPasses[CPUT_POST_PROCESS_DOWNSAMPLE] );
+    mGraph.Read( pass, source );
+    mGraph.Write( pass, downSample4x4 );
+    mPasses[CPUT_POST_PROCESS_DOWNSAMPLE].mTarget = downSample4x4;
+
+    // Compute average of log of luminance by downsampling log to 64x64, then 4x4, then 1x1
+    pass = mGraph.AddPass( "Post: log luminance", &mPasses[CPUT_POST_PROCESS_LOG_LUMINANCE] );
+    mGraph.Read( pass, downSample4x4 );
+    mGraph.Write( pass, rt64x64 );
+    mPasses[CPUT_POST_PROCESS_LOG_LUMINANCE].mTarget = rt64x64;
+
+    pass = mGraph.AddPass( "Post: luminance 4x4", &mPasses[CPUT_POST_PROCESS_LUMINANCE_4X4] );
+    mGraph.Read( pass, rt64x64 );
+    mGraph.Write( pass, rt4x4 );
+    mPasses[CPUT_POST_PROCESS_LUMINANCE_4X4].mTarget = rt4x4;
+
+    // Partially blend with previous to smooth result over time
+    pass = mGraph.AddPass( "Post: luminance 1x1", &mPasses[CPUT_POST_PROCESS_LUMINANCE_1X1] );
+    mGraph.Read( pass, rt4x4 );
+    mGraph.Read( pass, rt1x1 );
+    mGraph.Write( pass, rt1x1 );
+    mPasses[CPUT_POST_PROCESS_LUMINANCE_1X1].mTarget = rt1x1;
+
+    // Better blur for bloom
+    pass = mGraph.AddPass( "Post: blur horizontal", &mPasses[CPUT_POST_PROCESS_BLUR_HORIZONTAL] );
+    mGraph.Read( pass, downSample4x4 );
+    mGraph.Write( pass, pingPong );
+    mPasses[CPUT_POST_PROCESS_BLUR_HORIZONTAL].mTarget = pingPong;
+
+    pass = mGraph.AddPass( "Post: blur vertical", &mPasses[CPUT_POST_PROCESS_BLUR_VERTICAL] );
+    mGraph.Read( pass, pingPong );
+    mGraph.Write( pass, downSample4x4 );
+    mPasses[CPUT_POST_PROCESS_BLUR_VERTICAL].mTarget = downSample4x4;
+
+    // Into whatever target is bound when PerformPostProcess() is called
+    pass = mGraph.AddPass( "Post: composite", &mPasses[CPUT_POST_PROCESS_COMPOSITE], true );
+    mGraph.Read( pass, source );
+    mGraph.Read( pass, downSample4x4 );
+    mGraph.Read( pass, rt1x1 );
+
+    mGraph.Compile( &mAllocator );
+
     CPUTAssetLibrary *pLibrary = CPUTAssetLibrary::GetAssetLibrary();
     mpMaterialDownSampleBackBuffer4x4 = pLibrary->GetMaterial(_L("PostProcess/DownSampleBackBuffer4x4"));
     mpMaterialDownSample4x4           = pLibrary->GetMaterial(_L("PostProcess/DownSample4x4"));
@@ -76,41 +187,31 @@ void CPUTPostProcess::CreatePostProcess(
 
     mpFullScreenSprite = new CPUTSprite();
     mpFullScreenSprite->CreateSprite( -1.0f, -1.0f, 2.0f, 2.0f, _L("Sprite") );
+
+    mPasses[CPUT_POST_PROCESS_DOWNSAMPLE].mpMaterial        = mpMaterialDownSampleBackBuffer4x4;
+    mPasses[CPUT_POST_PROCESS_LOG_LUMINANCE].mpMaterial     = mpMaterialDownSampleLogLum;
+    mPasses[CPUT_POST_PROCESS_LUMINANCE_4X4].mpMaterial     = mpMaterialDownSample4x4;
+    mPasses[CPUT_POST_PROCESS_LUMINANCE_1X1].mpMaterial     = mpMaterialDownSample4x4Alpha;
+    mPasses[CPUT_POST_PROCESS_BLUR_HORIZONTAL].mpMaterial   = mpMaterialBlurHorizontal;
+    mPasses[CPUT_POST_PROCESS_BLUR_VERTICAL].mpMaterial     = mpMaterialBlurVertical;
+    mPasses[CPUT_POST_PROCESS_COMPOSITE].mpMaterial         = mpMaterialComposite;
+    for( UINT ii=0; ii<CPUT_POST_PROCESS_PASS_COUNT; ii++ )
+    {
+        mPasses[ii].mpSprite = mpFullScreenSprite;
+    }
+
+#ifdef _DEBUG
+    const CPUTRenderGraphResource resources[] = { source, rt1x1, downSample4x4, pingPong, rt64x64, rt4x4 };
+    for( UINT ii=0; ii<CPUT_POST_PROCESS_PASS_COUNT; ii++ )
+    {
+        CheckPassReads( mGraph, ii, *mPasses[ii].mpMaterial, resources, sizeof(resources)/sizeof(resources[0]) );
+    }
+#endif
 }
 
 UINT gPostProcessingMode = 0;
 //-----------------------------------------
 void CPUTPostProcess::PerformPostProcess( CPUTRenderParameters &renderParams )
 {
-    mpRTDownSample4x4->SetRenderTarget( renderParams);
-    mpFullScreenSprite->DrawSprite( renderParams, *mpMaterialDownSampleBackBuffer4x4 );
-    mpRTDownSample4x4->RestoreRenderTarget( renderParams );
-
-    // Compute average of log of luminance by downsampling log to 64x64, then 4x4, then 1x1
-    mpRT64x64->SetRenderTarget(renderParams);
-    mpFullScreenSprite->DrawSprite(renderParams, *mpMaterialDownSampleLogLum);
-    mpRT64x64->RestoreRenderTarget( renderParams );
-
-    mpRT4x4->SetRenderTarget(renderParams);
-    mpFullScreenSprite->DrawSprite(renderParams, *mpMaterialDownSample4x4);
-    mpRT4x4->RestoreRenderTarget( renderParams );
-
-    mpRT1x1->SetRenderTarget(renderParams);
-    mpFullScreenSprite->DrawSprite( renderParams, *mpMaterialDownSample4x4Alpha ); // Partially blend with previous to smooth result over time
-    mpRT1x1->RestoreRenderTarget( renderParams );
-
-    // Better blur for bloom
-    UINT ii;
-    UINT numBlurs = 1; // TODO: expose as a config param
-    for( ii=0; ii<numBlurs; ii++ )
-    {
-        mpRTDownSample4x4PingPong->SetRenderTarget(renderParams);
-        mpFullScreenSprite->DrawSprite( renderParams, *mpMaterialBlurHorizontal );
-        mpRTDownSample4x4PingPong->RestoreRenderTarget( renderParams );
-
-        mpRTDownSample4x4->SetRenderTarget( renderParams);
-        mpFullScreenSprite->DrawSprite( renderParams, *mpMaterialBlurVertical );
-        mpRTDownSample4x4->RestoreRenderTarget( renderParams );
-    }
-    mpFullScreenSprite->DrawSprite(renderParams, *mpMaterialComposite);
+    mGraph.Execute( &renderParams );
 }
@@ -16,21 +16,53 @@
 #ifndef _CPUTPOSTPROCESS_H
 #define _CPUTPOSTPROCESS_H
 
+#include "CPUTRenderGraphDX11.h"
+
 class CPUTRenderTargetColor;
 class CPUTMaterial;
 class CPUTRenderParameters;
 class CPUTSprite;
 
+// Draws the full-screen sprite with a material, into a graph texture or (with
+// CPUT_RENDER_GRAPH_NONE) the target that's bound
+//-----------------------------------------------------------------------------
+class CPUTPostProcessPass : public CPUTRenderPass
+{
+public:
+    CPUTSprite             *mpSprite;
+    CPUTMaterial           *mpMaterial;
+    CPUTRenderGraphResource mTarget;
+
+    CPUTPostProcessPass() : mpSprite(NULL), mpMaterial(NULL), mTarget(CPUT_RENDER_GRAPH_NONE) {}
+    void Execute( CPUTRenderGraph &graph, void *pContext );
+};
+
+enum CPUT_POST_PROCESS_PASS
+{
+    CPUT_POST_PROCESS_DOWNSAMPLE,
+    CPUT_POST_PROCESS_LOG_LUMINANCE,
+    CPUT_POST_PROCESS_LUMINANCE_4X4,
+    CPUT_POST_PROCESS_LUMINANCE_1X1,
+    CPUT_POST_PROCESS_BLUR_HORIZONTAL,
+    CPUT_POST_PROCESS_BLUR_VERTICAL,
+    CPUT_POST_PROCESS_COMPOSITE,
+    CPUT_POST_PROCESS_PASS_COUNT
+};
+
+// The intermediate targets are render graph transients (see CPUTRenderGraph.h), created
+// by CreatePostProcess() and aliased where their lifetimes allow.  The 1x1 average
+// luminance blends with the previous frame's, so it persists and is imported.
+//-----------------------------------------------------------------------------
 class CPUTPostProcess
 {
 protected:
     CPUTRenderTargetColor *mpRTSourceRenderTarget;
-    CPUTRenderTargetColor *mpRTDownSample4x4;
-    CPUTRenderTargetColor *mpRTDownSample4x4PingPong;
-    CPUTRenderTargetColor *mpRT64x64;
-    CPUTRenderTargetColor *mpRT4x4;
     CPUTRenderTargetColor *mpRT1x1;
 
+    CPUTRenderGraphAllocatorDX11  mAllocator;      // Before the graph, which releases into it
+    CPUTRenderGraph               mGraph;
+    CPUTPostProcessPass           mPasses[CPUT_POST_PROCESS_PASS_COUNT];
+
     CPUTMaterial *mpMaterialSpriteNoAlpha;
     CPUTMaterial *mpMaterialDownSampleBackBuffer4x4;
     CPUTMaterial *mpMaterialDownSample4x4;
@@ -45,10 +77,6 @@ protected:
 public:
     CPUTPostProcess() :
         mpRTSourceRenderTarget(NULL),
-        mpRTDownSample4x4(NULL),
-        mpRTDownSample4x4PingPong(NULL),
-        mpRT64x64(NULL),
-        mpRT4x4(NULL),
         mpRT1x1(NULL),
         mpMaterialSpriteNoAlpha(NULL),
         mpMaterialDownSampleBackBuffer4x4(NULL),
@@ -64,6 +92,7 @@ public:
 
     void CreatePostProcess( CPUTRenderTargetColor *pSourceRenderTarget );
     void PerformPostProcess(CPUTRenderParameters &renderParams);
+    const CPUTRenderGraphStats &GetGraphStats() const { return mGraph.GetStats(); }
 };
 
 #endif // _CPUTPOSTPROCESS_H
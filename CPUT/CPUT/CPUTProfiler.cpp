@@ -0,0 +1,497 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTProfiler.h"
+#include <map>
+#include <stdio.h>
+#include <vector>
+
+// A thread publishes an event (or a new chunk) with a release store of the count (or
+// link), so a reader that loads them with acquire sees the data written before.
+#ifdef _WIN32
+#   include <windows.h>
+#   define PROFILER_THREAD_LOCAL            __declspec(thread)
+#   define PROFILER_PUBLISH(dest, value)    ( _WriteBarrier(), (dest) = (value) )
+#   define PROFILER_READ(value)             ( _ReadBarrier(), (value) )
+#   define PROFILER_INCREMENT(value)        InterlockedIncrement( &(value) )
+#   define PROFILER_DECREMENT(value)        InterlockedDecrement( &(value) )
+static SRWLOCK gRegistrationLock = SRWLOCK_INIT;
+#   define PROFILER_LOCK()                  AcquireSRWLockExclusive( &gRegistrationLock )
+#   define PROFILER_UNLOCK()                ReleaseSRWLockExclusive( &gRegistrationLock )
+#else
+#   include <pthread.h>
+#   include <time.h>
+#   define PROFILER_THREAD_LOCAL            __thread
+#   define PROFILER_PUBLISH(dest, value)    __atomic_store_n( &(dest), (value), __ATOMIC_RELEASE )
+#   define PROFILER_READ(value)             __atomic_load_n( &(value), __ATOMIC_ACQUIRE )
+#   define PROFILER_INCREMENT(value)        __sync_add_and_fetch( &(value), 1 )
+#   define PROFILER_DECREMENT(value)        __sync_sub_and_fetch( &(value), 1 )
+static pthread_mutex_t gRegistrationLock = PTHREAD_MUTEX_INITIALIZER;
+#   define PROFILER_LOCK()                  pthread_mutex_lock( &gRegistrationLock )
+#   define PROFILER_UNLOCK()                pthread_mutex_unlock( &gRegistrationLock )
+#endif
+
+static PROFILER_THREAD_LOCAL CPUTProfileThread *tpThread = NULL;
+
+volatile uint32_t  CPUTProfiler::sCapturing     = 0;
+CPUTProfileThread *CPUTProfiler::spThreads      = NULL;
+uint32_t           CPUTProfiler::sThreadCount   = 0;
+volatile long      CPUTProfiler::sChunkCount    = 0;
+long               CPUTProfiler::sMaxChunks     = 1024;   // 2M events, 64 MB on x64
+volatile long      CPUTProfiler::sDroppedEvents = 0;
+uint64_t           CPUTProfiler::sCaptureStart  = 0;
+int64_t            CPUTProfiler::sFrameNumber   = 0;
+uint32_t           CPUTProfiler::sFramesLeft    = 0;
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTProfiler::GetTicks()
+{
+#ifdef _WIN32
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter( &ticks );
+    return (uint64_t)ticks.QuadPart;
+#else
+    timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTProfiler::GetTicksPerSecond()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency( &frequency );
+    return (uint64_t)frequency.QuadPart;
+#else
+    return 1000000000;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+CPUTProfileThread *CPUTProfiler::GetThread()
+{
+    if( !tpThread )
+    {
+        CPUTProfileThread *pThread = new CPUTProfileThread;
+        pThread->mpName       = NULL;
+        pThread->mpFirstChunk = NULL;
+        pThread->mpLastChunk  = NULL;
+        PROFILER_LOCK();
+        pThread->mIndex = ++sThreadCount;
+        pThread->mpNext = spThreads;
+        spThreads = pThread;
+        PROFILER_UNLOCK();
+        tpThread = pThread;
+    }
+    return tpThread;
+}
+
+// Returns the chunk to write the next event to, or NULL if the memory cap is reached
+//-----------------------------------------------------------------------------
+CPUTProfileChunk *CPUTProfiler::AddChunk( CPUTProfileThread *pThread )
+{
+    CPUTProfileChunk *pLast = pThread->mpLastChunk;
+    if( pLast && pLast->mpNext )
+    {
+        // Reuse a chunk kept by Clear()
+        pThread->mpLastChunk = pLast->mpNext;
+        return pThread->mpLastChunk;
+    }
+    if( PROFILER_INCREMENT(sChunkCount) > sMaxChunks )
+    {
+        PROFILER_DECREMENT(sChunkCount);
+        return NULL;
+    }
+    CPUTProfileChunk *pChunk = new CPUTProfileChunk;
+    pChunk->mpNext = NULL;
+    pChunk->mCount = 0;
+    if( pLast )
+    {
+        PROFILER_PUBLISH( pLast->mpNext, pChunk );
+    }
+    else
+    {
+        PROFILER_LOCK(); // Readers find the first chunk through the thread list
+        pThread->mpFirstChunk = pChunk;
+        PROFILER_UNLOCK();
+    }
+    pThread->mpLastChunk = pChunk;
+    return pChunk;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::Record( CPUT_PROFILE_EVENT_TYPE type, const char *pName, int64_t value )
+{
+    CPUTProfileThread *pThread = GetThread();
+    CPUTProfileChunk  *pChunk  = pThread->mpLastChunk;
+    if( !pChunk || CPUTProfileChunk::EVENT_COUNT == pChunk->mCount )
+    {
+        pChunk = AddChunk( pThread );
+        if( !pChunk )
+        {
+            PROFILER_INCREMENT(sDroppedEvents);
+            return;
+        }
+    }
+    uint32_t count = pChunk->mCount;
+    CPUTProfileEvent *pEvent = &pChunk->mEvents[count];
+    pEvent->mTicks  = GetTicks();
+    pEvent->mpName  = pName;
+    pEvent->mValue  = value;
+    pEvent->mType   = type;
+    PROFILER_PUBLISH( pChunk->mCount, count + 1 );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::SetThreadName( const char *pName )
+{
+    GetThread()->mpName = pName;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::Frame()
+{
+    if( sCapturing )
+    {
+        Record( CPUT_PROFILE_FRAME, "Frame", sFrameNumber++ );
+        if( sFramesLeft && 0 == --sFramesLeft )
+        {
+            EndCapture();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::BeginCapture( uint32_t frameCount )
+{
+    Clear();
+    sFrameNumber  = 0;
+    sFramesLeft   = frameCount;
+    sCaptureStart = GetTicks();
+    PROFILER_PUBLISH( sCapturing, 1u );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::EndCapture()
+{
+    PROFILER_PUBLISH( sCapturing, 0u );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::Clear()
+{
+    PROFILER_LOCK();
+    for( CPUTProfileThread *pThread = spThreads; pThread; pThread = pThread->mpNext )
+    {
+        for( CPUTProfileChunk *pChunk = pThread->mpFirstChunk; pChunk; pChunk = pChunk->mpNext )
+        {
+            pChunk->mCount = 0;
+        }
+        pThread->mpLastChunk = pThread->mpFirstChunk;
+    }
+    PROFILER_UNLOCK();
+    sDroppedEvents = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::ReleaseMemory()
+{
+    PROFILER_LOCK();
+    for( CPUTProfileThread *pThread = spThreads; pThread; pThread = pThread->mpNext )
+    {
+        CPUTProfileChunk *pChunk = pThread->mpFirstChunk;
+        while( pChunk )
+        {
+            CPUTProfileChunk *pNext = pChunk->mpNext;
+            delete pChunk;
+            pChunk = pNext;
+        }
+        pThread->mpFirstChunk = NULL;
+        pThread->mpLastChunk  = NULL;
+    }
+    sChunkCount = 0;
+    PROFILER_UNLOCK();
+    sDroppedEvents = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTProfiler::SetMaxEvents( uint64_t maxEvents )
+{
+    uint64_t chunks = (maxEvents + CPUTProfileChunk::EVENT_COUNT - 1) / CPUTProfileChunk::EVENT_COUNT;
+    sMaxChunks = chunks > 0x7FFFFFFF ? 0x7FFFFFFF : (long)chunks;
+}
+
+// Calls visitor.Thread() for every thread, then visitor.Event() for each of its
+// completed events in order
+//-----------------------------------------------------------------------------
+template<class Visitor> static void VisitEvents( CPUTProfileThread *pThreads, Visitor *pVisitor )
+{
+    for( CPUTProfileThread *pThread = pThreads; pThread; pThread = pThread->mpNext )
+    {
+        pVisitor->Thread( *pThread );
+        for( CPUTProfileChunk *pChunk = pThread->mpFirstChunk; pChunk; pChunk = PROFILER_READ(pChunk->mpNext) )
+        {
+            uint32_t count = PROFILER_READ(pChunk->mCount);
+            for( uint32_t ii=0; ii<count; ii++ )
+            {
+                pVisitor->Event( pChunk->mEvents[ii] );
+            }
+            if( count < CPUTProfileChunk::EVENT_COUNT )
+            {
+                break; // Later chunks were kept by Clear() and hold nothing from this capture
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+struct CPUTProfileCountVisitor
+{
+    uint64_t mCount;
+    void Thread( const CPUTProfileThread & ) {}
+    void Event( const CPUTProfileEvent & ) { mCount++; }
+};
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTProfiler::GetEventCount()
+{
+    CPUTProfileCountVisitor visitor;
+    visitor.mCount = 0;
+    PROFILER_LOCK();
+    VisitEvents( spThreads, &visitor );
+    PROFILER_UNLOCK();
+    return visitor.mCount;
+}
+
+//-----------------------------------------------------------------------------
+static void WriteJSONString( FILE *pFile, const char *pString )
+{
+    fputc( '"', pFile );
+    for( const char *pChar = pString; *pChar; pChar++ )
+    {
+        unsigned char c = (unsigned char)*pChar;
+        if( '"' == c || '\\' == c )
+        {
+            fputc( '\\', pFile );
+            fputc( c, pFile );
+        }
+        else if( c < 0x20 )
+        {
+            fprintf( pFile, "\\u%04x", c );
+        }
+        else
+        {
+            fputc( c, pFile );
+        }
+    }
+    fputc( '"', pFile );
+}
+
+// Timestamps are microseconds, with three decimals for nanosecond resolution
+//-----------------------------------------------------------------------------
+struct CPUTProfileChromeVisitor
+{
+    FILE    *mpFile;
+    uint64_t mStart;
+    double   mMicrosecondsPerTick;
+    uint32_t mThreadIndex;
+    bool     mFirst;
+
+    void Separate()
+    {
+        fputs( mFirst ? "\n" : ",\n", mpFile );
+        mFirst = false;
+    }
+    void Thread( const CPUTProfileThread &thread )
+    {
+        mThreadIndex = thread.mIndex;
+        if( thread.mpName )
+        {
+            Separate();
+            fprintf( mpFile, "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", mThreadIndex );
+            WriteJSONString( mpFile, thread.mpName );
+            fputs( "}}", mpFile );
+        }
+    }
+    void Event( const CPUTProfileEvent &event )
+    {
+        static const char *pPhases[] = { "B", "E", "i", "C" };
+        double time = event.mTicks > mStart ? (double)(event.mTicks - mStart) * mMicrosecondsPerTick : 0.0;
+        Separate();
+        fprintf( mpFile, "{\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":", pPhases[event.mType], mThreadIndex, time );
+        WriteJSONString( mpFile, event.mpName );
+        if( CPUT_PROFILE_FRAME == event.mType )
+        {
+            fprintf( mpFile, ",\"s\":\"g\",\"args\":{\"frame\":%lld}", (long long)event.mValue );
+        }
+        else if( CPUT_PROFILE_COUNTER == event.mType )
+        {
+            fprintf( mpFile, ",\"args\":{\"value\":%lld}", (long long)event.mValue );
+        }
+        fputc( '}', mpFile );
+    }
+};
+
+//-----------------------------------------------------------------------------
+bool CPUTProfiler::WriteChromeTrace( const std::string &fileName )
+{
+    FILE *pFile = fopen( fileName.c_str(), "wb" );
+    if( !pFile )
+    {
+        return false;
+    }
+    CPUTProfileChromeVisitor visitor;
+    visitor.mpFile               = pFile;
+    visitor.mStart               = sCaptureStart;
+    visitor.mMicrosecondsPerTick = 1000000.0 / (double)GetTicksPerSecond();
+    visitor.mThreadIndex         = 0;
+    visitor.mFirst               = true;
+    fputs( "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", pFile );
+    PROFILER_LOCK();
+    VisitEvents( spThreads, &visitor );
+    PROFILER_UNLOCK();
+    fputs( "\n]}\n", pFile );
+    bool success = !ferror( pFile );
+    return 0 == fclose( pFile ) && success;
+}
+
+//-----------------------------------------------------------------------------
+static void AppendBytes( std::vector<uint8_t> *pOut, const void *pData, size_t size )
+{
+    pOut->insert( pOut->end(), (const uint8_t*)pData, (const uint8_t*)pData + size );
+}
+
+//-----------------------------------------------------------------------------
+static void AppendVarint( std::vector<uint8_t> *pOut, uint64_t value )
+{
+    while( value >= 0x80 )
+    {
+        pOut->push_back( (uint8_t)(value | 0x80) );
+        value >>= 7;
+    }
+    pOut->push_back( (uint8_t)value );
+}
+
+// Builds the string table and the per-thread event streams
+//-----------------------------------------------------------------------------
+struct CPUTProfileBinaryVisitor
+{
+    std::map<const char*, uint32_t>   mStringOfPointer;  // Most names are seen many times
+    std::map<std::string, uint32_t>   mStringOfText;     // Equal literals can have different addresses
+    std::vector<const char*>          mStrings;
+    std::vector<uint8_t>              mThreads;
+    std::vector<uint8_t>              mEvents;
+    uint64_t                          mEventCount;
+    uint64_t                          mPreviousTicks;
+    uint64_t                          mStart;
+    uint32_t                          mThreadIndex;
+    uint32_t                          mThreadName;
+
+    uint32_t GetString( const char *pString )
+    {
+        std::map<const char*, uint32_t>::iterator found = mStringOfPointer.find( pString );
+        if( found != mStringOfPointer.end() )
+        {
+            return found->second;
+        }
+        std::map<std::string, uint32_t>::iterator text = mStringOfText.find( pString );
+        uint32_t index = (uint32_t)mStrings.size();
+        if( text != mStringOfText.end() )
+        {
+            index = text->second;
+        }
+        else
+        {
+            mStringOfText[pString] = index;
+            mStrings.push_back( pString );
+        }
+        mStringOfPointer[pString] = index;
+        return index;
+    }
+    void FinishThread()
+    {
+        if( mThreadIndex )
+        {
+            AppendBytes( &mThreads, &mThreadIndex, sizeof(mThreadIndex) );
+            AppendBytes( &mThreads, &mThreadName, sizeof(mThreadName) );
+            AppendBytes( &mThreads, &mEventCount, sizeof(mEventCount) );
+            mThreads.insert( mThreads.end(), mEvents.begin(), mEvents.end() );
+        }
+        mEvents.clear();
+        mEventCount = 0;
+    }
+    void Thread( const CPUTProfileThread &thread )
+    {
+        FinishThread();
+        mThreadIndex   = thread.mIndex;
+        mThreadName    = thread.mpName ? GetString( thread.mpName ) : 0xFFFFFFFF;
+        mPreviousTicks = mStart;
+    }
+    void Event( const CPUTProfileEvent &event )
+    {
+        mEvents.push_back( (uint8_t)event.mType );
+        AppendVarint( &mEvents, GetString( event.mpName ) );
+        AppendVarint( &mEvents, event.mTicks > mPreviousTicks ? event.mTicks - mPreviousTicks : 0 );
+        mPreviousTicks = event.mTicks > mPreviousTicks ? event.mTicks : mPreviousTicks;
+        if( CPUT_PROFILE_FRAME == event.mType || CPUT_PROFILE_COUNTER == event.mType )
+        {
+            AppendVarint( &mEvents, ((uint64_t)event.mValue << 1) ^ (uint64_t)(event.mValue >> 63) );
+        }
+        mEventCount++;
+    }
+};
+
+//-----------------------------------------------------------------------------
+bool CPUTProfiler::WriteBinary( const std::string &fileName )
+{
+    CPUTProfileBinaryVisitor visitor;
+    visitor.mEventCount    = 0;
+    visitor.mPreviousTicks = 0;
+    visitor.mStart         = sCaptureStart;
+    visitor.mThreadIndex   = 0;
+    visitor.mThreadName    = 0xFFFFFFFF;
+    PROFILER_LOCK();
+    uint32_t threadCount = sThreadCount;
+    VisitEvents( spThreads, &visitor );
+    PROFILER_UNLOCK();
+    visitor.FinishThread();
+
+    std::vector<uint8_t> header;
+    AppendBytes( &header, "CPUTPRF1", 8 );
+    uint64_t ticksPerSecond = GetTicksPerSecond();
+    AppendBytes( &header, &ticksPerSecond, sizeof(ticksPerSecond) );
+    AppendBytes( &header, &sCaptureStart, sizeof(sCaptureStart) );
+    uint32_t stringCount = (uint32_t)visitor.mStrings.size();
+    AppendBytes( &header, &stringCount, sizeof(stringCount) );
+    for( uint32_t ii=0; ii<stringCount; ii++ )
+    {
+        std::string text( visitor.mStrings[ii] );
+        uint16_t length = (uint16_t)(text.size() < 0xFFFF ? text.size() : 0xFFFF);
+        AppendBytes( &header, &length, sizeof(length) );
+        AppendBytes( &header, text.c_str(), length );
+    }
+    AppendBytes( &header, &threadCount, sizeof(threadCount) );
+
+    FILE *pFile = fopen( fileName.c_str(), "wb" );
+    if( !pFile )
+    {
+        return false;
+    }
+    bool success = header.size() == fwrite( &header[0], 1, header.size(), pFile ) &&
+                   (visitor.mThreads.empty() || visitor.mThreads.size() == fwrite( &visitor.mThreads[0], 1, visitor.mThreads.size(), pFile ));
+    return 0 == fclose( pFile ) && success;
+}
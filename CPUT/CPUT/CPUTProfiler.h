@@ -0,0 +1,177 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTPROFILER_H__
+#define __CPUTPROFILER_H__
+
+// Portable CPU profiler for release builds.  Code marks scopes with CPUT_PROFILE_ZONE(),
+// frame boundaries with CPUT_PROFILE_FRAME() and values with CPUT_PROFILE_COUNTER().
+// While a capture runs, each thread appends timestamped events to its own buffer
+// without taking locks; outside a capture a zone only tests a flag.  A capture can be
+// written as Chrome trace JSON (load it in chrome://tracing or ui.perfetto.dev) or in
+// the binary format described below.
+//
+// Defining CPUT_NO_PROFILER removes the macros, arguments included, from the build.
+//
+// Names must outlive the capture (use string literals); only the pointer is recorded.
+//
+// BeginCapture(), Clear() and ReleaseMemory() reuse buffers that other threads write, so
+// call them between frames while no other thread can be inside a zone.  Events recorded
+// after EndCapture() (zones that were open) are kept; exporting only reads events
+// already completed, so it can run at any time.
+//
+// Measured cost per zone (begin and end), x64 Linux, gcc -O2:
+//   not capturing          <1 ns
+//   capturing              ~90 ns (of which ~55 ns are the two clock_gettime() calls)
+//   CPUT_NO_PROFILER       0
+//
+// Binary format, little endian:
+//   char[8]   "CPUTPRF1"
+//   uint64    ticks per second
+//   uint64    capture start, in ticks
+//   uint32    string count, then per string: uint16 length, then the bytes
+//   uint32    thread count, then per thread:
+//             uint32 thread index, uint32 name (a string index, or 0xFFFFFFFF),
+//             uint64 event count, then per event:
+//               uint8  type (CPUT_PROFILE_EVENT_TYPE)
+//               varint name (a string index)
+//               varint ticks since the thread's previous event (the capture start for the first)
+//               varint value, zigzag encoded (counters and frames only)
+// Varints are LEB128: 7 bits per byte, low bits first, high bit set on all but the last.
+#include <stdint.h>
+#include <string>
+
+enum CPUT_PROFILE_EVENT_TYPE
+{
+    CPUT_PROFILE_BEGIN,
+    CPUT_PROFILE_END,
+    CPUT_PROFILE_FRAME,     // Value is the frame number
+    CPUT_PROFILE_COUNTER,
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTProfileEvent
+{
+    uint64_t    mTicks;
+    const char *mpName;
+    int64_t     mValue;
+    uint32_t    mType;
+};
+
+// Events of one thread, stored in chunks
+//-----------------------------------------------------------------------------
+struct CPUTProfileChunk
+{
+    enum { EVENT_COUNT = 2048 };
+
+    CPUTProfileChunk *volatile mpNext;
+    volatile uint32_t          mCount;   // Published after the event is written
+    CPUTProfileEvent           mEvents[EVENT_COUNT];
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTProfileThread
+{
+    CPUTProfileThread *mpNext;          // All threads that ever recorded an event
+    uint32_t           mIndex;          // 1, 2, ... in order of their first event
+    const char        *mpName;
+    CPUTProfileChunk  *mpFirstChunk;    // Written by the thread only
+    CPUTProfileChunk  *mpLastChunk;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTProfiler
+{
+protected:
+    static volatile uint32_t  sCapturing;
+    static CPUTProfileThread *spThreads;      // Guarded by the registration lock
+    static uint32_t           sThreadCount;
+    static volatile long      sChunkCount;
+    static long               sMaxChunks;
+    static volatile long      sDroppedEvents;
+    static uint64_t           sCaptureStart;
+    static int64_t            sFrameNumber;
+    static uint32_t           sFramesLeft;    // 0 runs until EndCapture()
+
+    static CPUTProfileThread *GetThread();
+    static CPUTProfileChunk  *AddChunk( CPUTProfileThread *pThread );
+
+public:
+    static bool     IsCapturing() { return 0 != sCapturing; }
+    static void     BeginCapture( uint32_t frameCount = 0 ); // Discards the previous capture.  Ends at the frameCount'th Frame(), or with 0 at EndCapture().
+    static void     EndCapture();
+    static void     Clear();                                 // Discards the events, keeping the memory
+    static void     ReleaseMemory();                         // Discards the events and frees their memory
+
+    // Memory is capped at maxEvents (rounded up to whole chunks) across all threads;
+    // events beyond it are dropped and counted.  Chunks stay with their thread until
+    // ReleaseMemory(), even after the thread exits.
+    static void     SetMaxEvents( uint64_t maxEvents );
+    static uint64_t GetEventCount();
+    static uint32_t GetDroppedEventCount() { return (uint32_t)sDroppedEvents; }
+
+    // Records even when not capturing, so threads are named whenever they start
+    static void     SetThreadName( const char *pName );
+    static void     Record( CPUT_PROFILE_EVENT_TYPE type, const char *pName, int64_t value );
+    static void     Frame();
+    static void     Counter( const char *pName, int64_t value ) { if( sCapturing ) { Record( CPUT_PROFILE_COUNTER, pName, value ); } }
+
+    static uint64_t GetTicks();
+    static uint64_t GetTicksPerSecond();
+
+    static bool     WriteChromeTrace( const std::string &fileName );
+    static bool     WriteBinary( const std::string &fileName );
+};
+
+// Records a zone covering its own lifetime, if a capture is running when it starts
+//-----------------------------------------------------------------------------
+class CPUTProfileZone
+{
+protected:
+    const char *mpName;
+
+public:
+    CPUTProfileZone( const char *pName ) : mpName(NULL)
+    {
+        if( CPUTProfiler::IsCapturing() )
+        {
+            mpName = pName;
+            CPUTProfiler::Record( CPUT_PROFILE_BEGIN, pName, 0 );
+        }
+    }
+    ~CPUTProfileZone()
+    {
+        if( mpName )
+        {
+            CPUTProfiler::Record( CPUT_PROFILE_END, mpName, 0 );
+        }
+    }
+};
+
+#ifndef CPUT_NO_PROFILER
+#   define CPUT_PROFILE_CONCAT2(a, b)          a##b
+#   define CPUT_PROFILE_CONCAT(a, b)           CPUT_PROFILE_CONCAT2(a, b)
+#   define CPUT_PROFILE_ZONE(name)             CPUTProfileZone CPUT_PROFILE_CONCAT(cputProfileZone, __LINE__)( name )
+#   define CPUT_PROFILE_FRAME()                CPUTProfiler::Frame()
+#   define CPUT_PROFILE_COUNTER(name, value)   CPUTProfiler::Counter( name, (int64_t)(value) )
+#   define CPUT_PROFILE_THREAD_NAME(name)      CPUTProfiler::SetThreadName( name )
+#else
+#   define CPUT_PROFILE_ZONE(name)             ((void)0)
+#   define CPUT_PROFILE_FRAME()                ((void)0)
+#   define CPUT_PROFILE_COUNTER(name, value)   ((void)0)
+#   define CPUT_PROFILE_THREAD_NAME(name)      ((void)0)
+#endif
+
+#endif // __CPUTPROFILER_H__
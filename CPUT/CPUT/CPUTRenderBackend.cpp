@@ -0,0 +1,317 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderBackend.h"
+
+//-----------------------------------------------------------------------------
+CPUTRenderBackend::CPUTRenderBackend() :
+    mFilterRedundantState(true)
+{
+    InvalidateStateCache();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackend::InvalidateStateCache()
+{
+    // 0xFF bytes make every handle CPUT_BACKEND_UNKNOWN, every integer ~0 and the blend factor NaN
+    memset( &mState, 0xFF, sizeof(mState) );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackend::InvalidateShaderResources()
+{
+    memset( mState.mShaderResources, 0xFF, sizeof(mState.mShaderResources) );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackend::InvalidateResourceBindings()
+{
+    InvalidateShaderResources();
+    memset( mState.mUAVs, 0xFF, sizeof(mState.mUAVs) );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterShader( CPUT_SHADER_STAGE stage, CPUTBackendHandle shader )
+{
+    return FilterHandle( &mState.mShader[stage], shader );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterSlots( CPUTBackendHandle *pBound, uint32_t boundCount, uint32_t &startSlot, uint32_t &count, CPUTBackendHandle const *&pHandles )
+{
+    if( !count )
+    {
+        return true;
+    }
+    if( !pHandles || startSlot + count > boundCount )
+    {
+        // Not something we track.  Forget what we knew about the affected slots and let it through.
+        for( uint32_t ii=startSlot; ii<boundCount && ii<startSlot+count; ii++ )
+        {
+            pBound[ii] = CPUT_BACKEND_UNKNOWN;
+        }
+        return true;
+    }
+    if( !mFilterRedundantState )
+    {
+        // Still track the bindings, for InheritState()
+        memcpy( pBound + startSlot, pHandles, count * sizeof(CPUTBackendHandle) );
+        return true;
+    }
+
+    pBound += startSlot;
+    uint32_t first = 0;
+    while( first < count && pBound[first] == pHandles[first] )
+    {
+        first++;
+    }
+    if( first == count )
+    {
+        mStats.mRedundantCallsSkipped++;
+        mStats.mRedundantSlotsSkipped += count;
+        return false;
+    }
+    uint32_t last = count - 1;
+    while( pBound[last] == pHandles[last] )
+    {
+        last--;
+    }
+    uint32_t changed = last - first + 1;
+    memcpy( pBound + first, pHandles + first, changed * sizeof(CPUTBackendHandle) );
+
+    mStats.mRedundantSlotsSkipped += count - changed;
+    startSlot += first;
+    pHandles  += first;
+    count      = changed;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterBlendState( CPUTBackendHandle state, const float *pBlendFactor, uint32_t sampleMask )
+{
+    static const float defaultBlendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; // What D3D uses for NULL
+    if( !pBlendFactor )
+    {
+        pBlendFactor = defaultBlendFactor;
+    }
+    if( mFilterRedundantState &&
+        state == mState.mBlendState && sampleMask == mState.mSampleMask &&
+        0 == memcmp( pBlendFactor, mState.mBlendFactor, sizeof(mState.mBlendFactor) ) )
+    {
+        mStats.mRedundantCallsSkipped++;
+        return false;
+    }
+    mState.mBlendState = state;
+    mState.mSampleMask = sampleMask;
+    memcpy( mState.mBlendFactor, pBlendFactor, sizeof(mState.mBlendFactor) );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterDepthStencilState( CPUTBackendHandle state, uint32_t stencilRef )
+{
+    if( mFilterRedundantState && state == mState.mDepthStencilState && stencilRef == mState.mStencilRef )
+    {
+        mStats.mRedundantCallsSkipped++;
+        return false;
+    }
+    mState.mDepthStencilState = state;
+    mState.mStencilRef        = stencilRef;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterHandle( CPUTBackendHandle *pBound, CPUTBackendHandle handle )
+{
+    if( mFilterRedundantState && handle == *pBound )
+    {
+        mStats.mRedundantCallsSkipped++;
+        return false;
+    }
+    *pBound = handle;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterTopology( uint32_t topology )
+{
+    if( mFilterRedundantState && topology == mState.mTopology )
+    {
+        mStats.mRedundantCallsSkipped++;
+        return false;
+    }
+    mState.mTopology = topology;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterVertexBuffer( uint32_t slot, CPUTBackendHandle buffer, uint32_t stride, uint32_t offset )
+{
+    if( slot >= CPUT_BACKEND_MAX_VERTEX_BUFFER_SLOTS )
+    {
+        return true;
+    }
+    if( mFilterRedundantState && buffer == mState.mVertexBuffer[slot] &&
+        stride == mState.mVertexStride[slot] && offset == mState.mVertexOffset[slot] )
+    {
+        mStats.mRedundantCallsSkipped++;
+        return false;
+    }
+    mState.mVertexBuffer[slot] = buffer;
+    mState.mVertexStride[slot] = stride;
+    mState.mVertexOffset[slot] = offset;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackend::FilterIndexBuffer( CPUTBackendHandle buffer, uint32_t format, uint32_t offset )
+{
+    if( mFilterRedundantState && buffer == mState.mIndexBuffer &&
+        format == mState.mIndexFormat && offset == mState.mIndexOffset )
+    {
+        mStats.mRedundantCallsSkipped++;
+        return false;
+    }
+    mState.mIndexBuffer = buffer;
+    mState.mIndexFormat = format;
+    mState.mIndexOffset = offset;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackend::TrackConstantBufferRange( CPUT_SHADER_STAGE stage, uint32_t slot )
+{
+    if( slot < CPUT_BACKEND_MAX_CONSTANT_BUFFER_SLOTS )
+    {
+        mState.mConstantBuffers[stage][slot] = CPUT_BACKEND_UNKNOWN;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackend::TrackRenderTargets( uint32_t count, CPUTBackendHandle const *pRenderTargetViews, CPUTBackendHandle depthStencilView )
+{
+    if( count > CPUT_BACKEND_MAX_RENDER_TARGETS || (count && !pRenderTargetViews) )
+    {
+        mState.mRenderTargetCount = ~0u;
+        return;
+    }
+    memcpy( mState.mRenderTargets, pRenderTargetViews, count * sizeof(CPUTBackendHandle) );
+    mState.mRenderTargetCount = count;
+    mState.mDepthStencilView  = depthStencilView;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackend::TrackViewport( const CPUTBackendViewport &viewport )
+{
+    mState.mViewport      = viewport;
+    mState.mViewportKnown = 1;
+}
+
+// Binds each run of known slots with one call
+//-----------------------------------------------------------------------------
+typedef void (CPUTRenderBackend::*CPUTSetSlotsFunction)( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pHandles );
+static void SetKnownSlots( CPUTRenderBackend *pBackend, CPUTSetSlotsFunction setSlots, CPUT_SHADER_STAGE stage, const CPUTBackendHandle *pBound, uint32_t boundCount )
+{
+    uint32_t slot = 0;
+    while( slot < boundCount )
+    {
+        if( CPUT_BACKEND_UNKNOWN == pBound[slot] )
+        {
+            slot++;
+            continue;
+        }
+        uint32_t end = slot + 1;
+        while( end < boundCount && CPUT_BACKEND_UNKNOWN != pBound[end] )
+        {
+            end++;
+        }
+        (pBackend->*setSlots)( stage, slot, end - slot, pBound + slot );
+        slot = end;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackend::InheritState( const CPUTRenderBackend &source )
+{
+    // Copy first: binding render targets and UAVs invalidates parts of the cache, and source may be this
+    CPUTBackendStateCache state = source.mState;
+
+    // Outputs first, since binding them unbinds shader resources
+    if( ~0u != state.mRenderTargetCount )
+    {
+        SetRenderTargets( state.mRenderTargetCount, state.mRenderTargets, state.mDepthStencilView );
+    }
+    if( 1 == state.mViewportKnown )
+    {
+        SetViewport( state.mViewport );
+    }
+    uint32_t slot = 0;
+    while( slot < CPUT_BACKEND_MAX_UAV_SLOTS )
+    {
+        uint32_t end = slot;
+        while( end < CPUT_BACKEND_MAX_UAV_SLOTS && CPUT_BACKEND_UNKNOWN != state.mUAVs[end] )
+        {
+            end++;
+        }
+        if( end > slot )
+        {
+            SetComputeUnorderedAccessViews( slot, end - slot, state.mUAVs + slot );
+        }
+        slot = end + 1;
+    }
+
+    for( uint32_t stage=0; stage<CPUT_SHADER_STAGE_COUNT; stage++ )
+    {
+        if( CPUT_BACKEND_UNKNOWN != state.mShader[stage] )
+        {
+            SetShader( (CPUT_SHADER_STAGE)stage, state.mShader[stage] );
+        }
+        SetKnownSlots( this, &CPUTRenderBackend::SetConstantBuffers, (CPUT_SHADER_STAGE)stage, state.mConstantBuffers[stage], CPUT_BACKEND_MAX_CONSTANT_BUFFER_SLOTS );
+        SetKnownSlots( this, &CPUTRenderBackend::SetShaderResources, (CPUT_SHADER_STAGE)stage, state.mShaderResources[stage], CPUT_BACKEND_MAX_SLOTS );
+        SetKnownSlots( this, &CPUTRenderBackend::SetSamplers,        (CPUT_SHADER_STAGE)stage, state.mSamplers[stage],        CPUT_BACKEND_MAX_SAMPLER_SLOTS );
+    }
+
+    if( CPUT_BACKEND_UNKNOWN != state.mBlendState )
+    {
+        SetBlendState( state.mBlendState, state.mBlendFactor, state.mSampleMask );
+    }
+    if( CPUT_BACKEND_UNKNOWN != state.mDepthStencilState )
+    {
+        SetDepthStencilState( state.mDepthStencilState, state.mStencilRef );
+    }
+    if( CPUT_BACKEND_UNKNOWN != state.mRasterizerState )
+    {
+        SetRasterizerState( state.mRasterizerState );
+    }
+    if( CPUT_BACKEND_UNKNOWN != state.mInputLayout )
+    {
+        SetInputLayout( state.mInputLayout );
+    }
+    if( ~0u != state.mTopology )
+    {
+        SetPrimitiveTopology( state.mTopology );
+    }
+    for( uint32_t ii=0; ii<CPUT_BACKEND_MAX_VERTEX_BUFFER_SLOTS; ii++ )
+    {
+        if( CPUT_BACKEND_UNKNOWN != state.mVertexBuffer[ii] )
+        {
+            SetVertexBuffer( ii, state.mVertexBuffer[ii], state.mVertexStride[ii], state.mVertexOffset[ii] );
+        }
+    }
+    if( CPUT_BACKEND_UNKNOWN != state.mIndexBuffer )
+    {
+        SetIndexBuffer( state.mIndexBuffer, state.mIndexFormat, state.mIndexOffset );
+    }
+}
@@ -0,0 +1,304 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTRENDERBACKEND_H__
+#define __CPUTRENDERBACKEND_H__
+
+// The render backend is the narrow waist between CPUT's rendering classes and the
+// graphics API.  Everything the frame loop submits (state, bindings, constant
+// uploads, draws) goes through this interface so that it can be redirected to the
+// null/recording backend for headless runs and CPU-side profiling.
+//
+// Only submission goes through it.  Textures, shaders, states and views are still
+// created on the D3D11 device, so the sample's headless mode ("-headless true") runs
+// without a GPU (on WARP) but not without Windows.  The backend interface, the null
+// backend and what's built only on them (the upload ring, the render graph) are
+// portable, and are tested on Linux by driving the null backend directly (see CPUT/Tests).
+//
+// Note: this header is intentionally free of any D3D or Windows includes.
+#include <string.h>
+#include <stdint.h>
+
+// As CPUT.h and winnt.h define it, for the files that build without them
+#ifndef UNREFERENCED_PARAMETER
+#   ifdef _WIN32
+#       define UNREFERENCED_PARAMETER(P) (P)
+#   else
+#       define UNREFERENCED_PARAMETER(P) (void)(P)
+#   endif
+#endif
+
+// Opaque handle to a backend object.  On DX11 this is the native ID3D11* pointer.
+// On the null backend it is a synthetic value that is never dereferenced.
+typedef void *CPUTBackendHandle;
+
+//-----------------------------------------------------------------------------
+enum CPUT_SHADER_STAGE
+{
+    CPUT_SHADER_STAGE_VERTEX = 0,
+    CPUT_SHADER_STAGE_PIXEL,
+    CPUT_SHADER_STAGE_GEOMETRY,
+    CPUT_SHADER_STAGE_HULL,
+    CPUT_SHADER_STAGE_DOMAIN,
+    CPUT_SHADER_STAGE_COMPUTE,
+    CPUT_SHADER_STAGE_COUNT
+};
+
+// Bind flags.  The values match D3D11_BIND_FLAG so the DX11 backend can pass them through.
+enum CPUT_BACKEND_BIND_FLAG
+{
+    CPUT_BIND_VERTEX_BUFFER   = 0x1,
+    CPUT_BIND_INDEX_BUFFER    = 0x2,
+    CPUT_BIND_CONSTANT_BUFFER = 0x4,
+    CPUT_BIND_SHADER_RESOURCE = 0x8,
+};
+
+// Clear flags.  The values match D3D11_CLEAR_FLAG.
+enum CPUT_BACKEND_CLEAR_FLAG
+{
+    CPUT_CLEAR_DEPTH   = 0x1,
+    CPUT_CLEAR_STENCIL = 0x2,
+};
+
+const unsigned int CPUT_BACKEND_MAX_SLOTS = 128; // D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT
+
+// Slots tracked by the redundant state filter.  Binds beyond these pass through unfiltered.
+const unsigned int CPUT_BACKEND_MAX_CONSTANT_BUFFER_SLOTS = 14; // D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT
+const unsigned int CPUT_BACKEND_MAX_SAMPLER_SLOTS         = 16; // D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT
+const unsigned int CPUT_BACKEND_MAX_UAV_SLOTS             = 8;  // D3D11_PS_CS_UAV_REGISTER_COUNT
+const unsigned int CPUT_BACKEND_MAX_VERTEX_BUFFER_SLOTS   = 32; // D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT
+const unsigned int CPUT_BACKEND_MAX_RENDER_TARGETS        = 8;  // D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT
+
+// Constant buffer ranges start on multiples of this (16 constants, as D3D11.1 requires)
+const unsigned int CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT = 256;
+
+//-----------------------------------------------------------------------------
+struct CPUTBackendViewport
+{
+    float mTopLeftX;
+    float mTopLeftY;
+    float mWidth;
+    float mHeight;
+    float mMinDepth;
+    float mMaxDepth;
+};
+
+// Per-frame counters.  Every backend updates these, so the numbers from a headless
+// run are directly comparable to the numbers from a GPU run.
+//-----------------------------------------------------------------------------
+struct CPUTBackendStats
+{
+    uint32_t mDrawCalls;          // Draw + DrawIndexed + DrawIndexedInstanced
+    uint32_t mInstancesDrawn;     // Sum of instance counts (1 for non-instanced draws)
+    uint64_t mIndicesSubmitted;   // Sum of index/vertex counts over all draws
+    uint32_t mShaderChanges;      // SetShader calls
+    uint32_t mStateChanges;       // Blend, depth-stencil, rasterizer, input layout, topology
+    uint32_t mResourceBindings;   // SRV, UAV, sampler and constant buffer slot bindings
+    uint32_t mBufferBindings;     // Vertex and index buffer bindings
+    uint32_t mRenderTargetChanges;
+    uint32_t mClears;
+    uint32_t mMaps;
+    uint32_t mBufferUpdates;      // UpdateBuffer calls
+    uint64_t mBytesUploaded;      // Bytes written through Map/Unmap and UpdateBuffer
+    uint32_t mResourcesCreated;
+    uint64_t mBytesAllocated;
+    uint32_t mPresents;
+    uint32_t mRedundantCallsSkipped; // Calls the state filter dropped because they changed nothing
+    uint32_t mRedundantSlotsSkipped; // Slots the state filter trimmed off (or dropped with) resource binds
+
+    CPUTBackendStats() { Reset(); }
+    void Reset() { memset( this, 0, sizeof(*this) ); }
+    void Accumulate( const CPUTBackendStats &other )
+    {
+        mDrawCalls             += other.mDrawCalls;
+        mInstancesDrawn        += other.mInstancesDrawn;
+        mIndicesSubmitted      += other.mIndicesSubmitted;
+        mShaderChanges         += other.mShaderChanges;
+        mStateChanges          += other.mStateChanges;
+        mResourceBindings      += other.mResourceBindings;
+        mBufferBindings        += other.mBufferBindings;
+        mRenderTargetChanges   += other.mRenderTargetChanges;
+        mClears                += other.mClears;
+        mMaps                  += other.mMaps;
+        mBufferUpdates         += other.mBufferUpdates;
+        mBytesUploaded         += other.mBytesUploaded;
+        mResourcesCreated      += other.mResourcesCreated;
+        mBytesAllocated        += other.mBytesAllocated;
+        mPresents              += other.mPresents;
+        mRedundantCallsSkipped += other.mRedundantCallsSkipped;
+        mRedundantSlotsSkipped += other.mRedundantSlotsSkipped;
+    }
+    uint32_t GetTotalAPICalls() const
+    {
+        return mDrawCalls + mShaderChanges + mStateChanges + mResourceBindings + mBufferBindings
+             + mRenderTargetChanges + mClears + mMaps + mBufferUpdates;
+    }
+};
+
+// What the backend last bound, so redundant binds can be skipped and so the state can be
+// handed on to a deferred backend (see InheritState()).
+// CPUT_BACKEND_UNKNOWN (and ~0 for the integer fields) means "not known", which never matches.
+//-----------------------------------------------------------------------------
+struct CPUTBackendStateCache
+{
+    CPUTBackendHandle mShader[CPUT_SHADER_STAGE_COUNT];
+    CPUTBackendHandle mConstantBuffers[CPUT_SHADER_STAGE_COUNT][CPUT_BACKEND_MAX_CONSTANT_BUFFER_SLOTS];
+    CPUTBackendHandle mShaderResources[CPUT_SHADER_STAGE_COUNT][CPUT_BACKEND_MAX_SLOTS];
+    CPUTBackendHandle mSamplers[CPUT_SHADER_STAGE_COUNT][CPUT_BACKEND_MAX_SAMPLER_SLOTS];
+    CPUTBackendHandle mUAVs[CPUT_BACKEND_MAX_UAV_SLOTS];
+    CPUTBackendHandle mBlendState;
+    float             mBlendFactor[4];
+    uint32_t          mSampleMask;
+    CPUTBackendHandle mDepthStencilState;
+    uint32_t          mStencilRef;
+    CPUTBackendHandle mRasterizerState;
+    CPUTBackendHandle mInputLayout;
+    uint32_t          mTopology;
+    CPUTBackendHandle mVertexBuffer[CPUT_BACKEND_MAX_VERTEX_BUFFER_SLOTS];
+    uint32_t          mVertexStride[CPUT_BACKEND_MAX_VERTEX_BUFFER_SLOTS];
+    uint32_t          mVertexOffset[CPUT_BACKEND_MAX_VERTEX_BUFFER_SLOTS];
+    CPUTBackendHandle mIndexBuffer;
+    uint32_t          mIndexFormat;
+    uint32_t          mIndexOffset;
+
+    // Tracked for InheritState() only.  Never filtered.
+    CPUTBackendHandle   mRenderTargets[CPUT_BACKEND_MAX_RENDER_TARGETS];
+    uint32_t            mRenderTargetCount;
+    CPUTBackendHandle   mDepthStencilView;
+    CPUTBackendViewport mViewport;
+    uint32_t            mViewportKnown;
+};
+
+const CPUTBackendHandle CPUT_BACKEND_UNKNOWN = (CPUTBackendHandle)~(uintptr_t)0;
+
+//-----------------------------------------------------------------------------
+class CPUTRenderBackend
+{
+protected:
+    CPUTBackendStats      mStats;
+    CPUTBackendStateCache mState;
+    bool                  mFilterRedundantState;
+
+    // Redundant state filtering, called first thing by every backend's Set*() methods.  They return
+    // false when the call changes nothing and should be dropped.  FilterSlots() also trims
+    // startSlot/count/pHandles down to the range of slots that actually change.
+    bool FilterShader( CPUT_SHADER_STAGE stage, CPUTBackendHandle shader );
+    bool FilterSlots( CPUTBackendHandle *pBound, uint32_t boundCount, uint32_t &startSlot, uint32_t &count, CPUTBackendHandle const *&pHandles );
+    bool FilterBlendState( CPUTBackendHandle state, const float *pBlendFactor, uint32_t sampleMask );
+    bool FilterDepthStencilState( CPUTBackendHandle state, uint32_t stencilRef );
+    bool FilterHandle( CPUTBackendHandle *pBound, CPUTBackendHandle handle );
+    bool FilterTopology( uint32_t topology );
+    bool FilterVertexBuffer( uint32_t slot, CPUTBackendHandle buffer, uint32_t stride, uint32_t offset );
+    bool FilterIndexBuffer( CPUTBackendHandle buffer, uint32_t format, uint32_t offset );
+
+    // D3D unbinds shader resources that get bound as outputs, behind our back.  Called when render targets or UAVs change.
+    void InvalidateShaderResources();
+    void InvalidateResourceBindings();
+
+    // Range binds aren't filtered.  Forget what's bound in the slot, so the next whole-buffer bind isn't dropped.
+    void TrackConstantBufferRange( CPUT_SHADER_STAGE stage, uint32_t slot );
+
+    // Remember output state for InheritState()
+    void TrackRenderTargets( uint32_t count, CPUTBackendHandle const *pRenderTargetViews, CPUTBackendHandle depthStencilView );
+    void TrackViewport( const CPUTBackendViewport &viewport );
+
+public:
+    CPUTRenderBackend();
+    virtual ~CPUTRenderBackend() {}
+
+    const CPUTBackendStats &GetStats() const { return mStats; }
+    void                    ResetStats()     { mStats.Reset(); }
+    virtual bool            IsNull() const   { return false; }
+
+    // Redundant state filtering is on by default.  Call InvalidateStateCache() after changing
+    // pipeline state without going through the backend (e.g., ClearState() on the native context).
+    void                    SetStateFiltering( bool enable ) { mFilterRedundantState = enable; InvalidateStateCache(); }
+    bool                    GetStateFiltering() const        { return mFilterRedundantState; }
+    void                    InvalidateStateCache();
+
+    // Binds everything pSource's state cache knows about.  Used to start a deferred backend
+    // from the immediate backend's state, and to restore the immediate state after executing one.
+    void                    InheritState( const CPUTRenderBackend &source );
+
+    // Multithreaded recording.  CreateDeferred() returns a new backend whose calls are recorded
+    // rather than executed (NULL if this backend can't record).  Each deferred backend may be used
+    // by one thread at a time.  ExecuteDeferred() plays back, and then clears, what pDeferred
+    // recorded since its last execution, on this backend's thread.  The deferred backend's
+    // state is reset afterwards (as a D3D11 deferred context's is), and this backend is left in the
+    // state the recording ended in.  The recorded calls are counted in this backend's stats.
+    virtual CPUTRenderBackend *CreateDeferred() { return 0; }
+    virtual void               ExecuteDeferred( CPUTRenderBackend *pDeferred ) = 0;
+
+    // Resource creation.  pInitialData may be NULL.  Dynamic buffers may be mapped for write-discard.
+    virtual CPUTBackendHandle CreateBuffer( uint32_t byteWidth, uint32_t bindFlags, bool dynamic, const void *pInitialData ) = 0;
+    virtual void              ReleaseBuffer( CPUTBackendHandle buffer ) = 0;
+
+    // Uploads.  Map() always discards the previous contents.  Pass the number of bytes actually
+    // written to Unmap() so upload traffic can be measured (0 means "whole buffer").
+    virtual void *Map( CPUTBackendHandle buffer ) = 0;
+    virtual void  Unmap( CPUTBackendHandle buffer, uint32_t bytesWritten ) = 0;
+    virtual void  UpdateBuffer( CPUTBackendHandle buffer, const void *pData, uint32_t byteCount ) = 0;
+
+    // Writes byteCount bytes at offset and leaves the rest of the buffer alone.  Not for dynamic buffers.
+    virtual void  UpdateBufferRange( CPUTBackendHandle buffer, uint32_t offset, const void *pData, uint32_t byteCount ) = 0;
+
+    // Suballocated uploads (see CPUTUploadRing).  MapNoOverwrite() keeps the previous contents: the
+    // caller promises not to write bytes the GPU may still read.  UnmapRange() takes the bytes written.
+    virtual void *MapNoOverwrite( CPUTBackendHandle buffer ) = 0;
+    virtual void  UnmapRange( CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount ) = 0;
+
+    // Fences.  A signaled fence completes once the GPU has executed everything submitted before it.
+    virtual CPUTBackendHandle CreateFence() = 0;
+    virtual void              ReleaseFence( CPUTBackendHandle fence ) = 0;
+    virtual void              SignalFence( CPUTBackendHandle fence ) = 0;
+    virtual bool              IsFenceComplete( CPUTBackendHandle fence ) = 0;
+
+    // Pipeline state
+    virtual void SetShader( CPUT_SHADER_STAGE stage, CPUTBackendHandle shader ) = 0;
+    virtual void SetConstantBuffers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pBuffers ) = 0;
+
+    // Binds byteCount bytes of buffer, starting at offset, as a constant buffer.  offset must be a
+    // multiple of CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT.  Only valid if SupportsConstantBufferRanges().
+    virtual bool SupportsConstantBufferRanges() const = 0;
+    virtual void SetConstantBufferRange( CPUT_SHADER_STAGE stage, uint32_t slot, CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount ) = 0;
+    virtual void SetShaderResources( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pViews ) = 0;
+    virtual void SetSamplers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pSamplers ) = 0;
+    virtual void SetComputeUnorderedAccessViews( uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pUAVs ) = 0;
+    virtual void SetBlendState( CPUTBackendHandle state, const float *pBlendFactor, uint32_t sampleMask ) = 0;
+    virtual void SetDepthStencilState( CPUTBackendHandle state, uint32_t stencilRef ) = 0;
+    virtual void SetRasterizerState( CPUTBackendHandle state ) = 0;
+
+    // Input assembly
+    virtual void SetInputLayout( CPUTBackendHandle layout ) = 0;
+    virtual void SetPrimitiveTopology( uint32_t topology ) = 0;
+    virtual void SetVertexBuffer( uint32_t slot, CPUTBackendHandle buffer, uint32_t stride, uint32_t offset ) = 0;
+    virtual void SetIndexBuffer( CPUTBackendHandle buffer, uint32_t format, uint32_t offset ) = 0;
+
+    // Output merger
+    virtual void SetRenderTargets( uint32_t count, CPUTBackendHandle const *pRenderTargetViews, CPUTBackendHandle depthStencilView ) = 0;
+    virtual void SetViewport( const CPUTBackendViewport &viewport ) = 0;
+    virtual void ClearRenderTarget( CPUTBackendHandle renderTargetView, const float *pColor ) = 0;
+    virtual void ClearDepthStencil( CPUTBackendHandle depthStencilView, uint32_t clearFlags, float depth, uint8_t stencil ) = 0;
+
+    // Draws
+    virtual void Draw( uint32_t vertexCount, uint32_t startVertex ) = 0;
+    virtual void DrawIndexed( uint32_t indexCount, uint32_t startIndex, int32_t baseVertex ) = 0;
+    virtual void DrawIndexedInstanced( uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance ) = 0;
+
+    // Frame boundary
+    virtual void Present( uint32_t syncInterval ) = 0;
+};
+
+#endif // __CPUTRENDERBACKEND_H__
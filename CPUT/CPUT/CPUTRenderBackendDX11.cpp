@@ -0,0 +1,447 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderBackendDX11.h"
+#include "CPUT.h"
+
+//-----------------------------------------------------------------------------
+CPUTRenderBackendDX11::~CPUTRenderBackendDX11()
+{
+#ifdef CPUT_FOR_DX11_1
+    SAFE_RELEASE(mpContext1);
+#endif
+    if( mOwnsContext )
+    {
+        SAFE_RELEASE(mpContext);
+    }
+}
+
+// Constant buffer ranges need D3D11.1 and a driver that can offset constant buffers
+// (and map them with no-overwrite)
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::QueryContext1()
+{
+#ifdef CPUT_FOR_DX11_1
+    mpContext1 = NULL;
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+    ZeroMemory( &options, sizeof(options) );
+    HRESULT hr = mpDevice->CheckFeatureSupport( D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options) );
+    if( SUCCEEDED(hr) && options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer )
+    {
+        mpContext->QueryInterface( __uuidof(ID3D11DeviceContext1), (void**)&mpContext1 );
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackendDX11::SupportsConstantBufferRanges() const
+{
+#ifdef CPUT_FOR_DX11_1
+    return NULL != mpContext1;
+#else
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+CPUTRenderBackend *CPUTRenderBackendDX11::CreateDeferred()
+{
+    ID3D11DeviceContext *pDeferredContext = NULL;
+    HRESULT hr = mpDevice->CreateDeferredContext( 0, &pDeferredContext );
+    if( FAILED(hr) )
+    {
+        return NULL;
+    }
+    CPUTSetDebugName( pDeferredContext, _L("Deferred context") );
+
+    CPUTRenderBackendDX11 *pDeferred = new CPUTRenderBackendDX11( mpDevice, pDeferredContext, NULL );
+    pDeferred->mOwnsContext = true;
+    return pDeferred;
+}
+
+// Runs on the immediate context.  Executing a command list without restoring the
+// immediate context's state leaves it in the default state, so the deferred
+// backend's final state is rebound afterwards.
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::ExecuteDeferred( CPUTRenderBackend *pDeferred )
+{
+    ASSERT( !pDeferred->IsNull() && pDeferred != this, _L("ExecuteDeferred() needs a deferred DX11 backend") );
+    CPUTRenderBackendDX11 *pDeferredDX11 = (CPUTRenderBackendDX11*)pDeferred;
+
+    ID3D11CommandList *pCommandList = NULL;
+    HRESULT hr = pDeferredDX11->mpContext->FinishCommandList( FALSE, &pCommandList );
+    ASSERT( SUCCEEDED(hr), _L("Failed finishing command list") );
+    UNREFERENCED_PARAMETER(hr);
+    if( pCommandList )
+    {
+        mpContext->ExecuteCommandList( pCommandList, FALSE );
+        SAFE_RELEASE(pCommandList);
+    }
+    mStats.Accumulate( pDeferredDX11->mStats );
+    pDeferredDX11->mStats.Reset();
+
+    InvalidateStateCache();
+    InheritState( *pDeferredDX11 );
+    pDeferredDX11->InvalidateStateCache();
+}
+
+//-----------------------------------------------------------------------------
+CPUTBackendHandle CPUTRenderBackendDX11::CreateBuffer( uint32_t byteWidth, uint32_t bindFlags, bool dynamic, const void *pInitialData )
+{
+    D3D11_BUFFER_DESC desc = {0};
+    desc.ByteWidth      = byteWidth;
+    desc.BindFlags      = bindFlags;
+    desc.Usage          = dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+    desc.CPUAccessFlags = dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
+
+    D3D11_SUBRESOURCE_DATA data = {0};
+    data.pSysMem = pInitialData;
+
+    ID3D11Buffer *pBuffer = NULL;
+    HRESULT hr = mpDevice->CreateBuffer( &desc, pInitialData ? &data : NULL, &pBuffer );
+    ASSERT( SUCCEEDED(hr), _L("Failed creating buffer") );
+    UNREFERENCED_PARAMETER(hr);
+
+    mStats.mResourcesCreated++;
+    mStats.mBytesAllocated += byteWidth;
+    return pBuffer;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::ReleaseBuffer( CPUTBackendHandle buffer )
+{
+    ID3D11Buffer *pBuffer = (ID3D11Buffer*)buffer;
+    SAFE_RELEASE(pBuffer);
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTRenderBackendDX11::Map( CPUTBackendHandle buffer )
+{
+    mStats.mMaps++;
+    D3D11_MAPPED_SUBRESOURCE mapInfo;
+    HRESULT hr = mpContext->Map( (ID3D11Buffer*)buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapInfo );
+    return SUCCEEDED(hr) ? mapInfo.pData : NULL;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::Unmap( CPUTBackendHandle buffer, uint32_t bytesWritten )
+{
+    if( 0 == bytesWritten )
+    {
+        D3D11_BUFFER_DESC desc;
+        ((ID3D11Buffer*)buffer)->GetDesc( &desc );
+        bytesWritten = desc.ByteWidth;
+    }
+    mStats.mBytesUploaded += bytesWritten;
+    mpContext->Unmap( (ID3D11Buffer*)buffer, 0 );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::UpdateBuffer( CPUTBackendHandle buffer, const void *pData, uint32_t byteCount )
+{
+    mStats.mBufferUpdates++;
+    mStats.mBytesUploaded += byteCount;
+    mpContext->UpdateSubresource( (ID3D11Buffer*)buffer, 0, NULL, pData, 0, 0 );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::UpdateBufferRange( CPUTBackendHandle buffer, uint32_t offset, const void *pData, uint32_t byteCount )
+{
+    mStats.mBufferUpdates++;
+    mStats.mBytesUploaded += byteCount;
+    D3D11_BOX box = { offset, 0, 0, offset + byteCount, 1, 1 };
+    mpContext->UpdateSubresource( (ID3D11Buffer*)buffer, 0, &box, pData, 0, 0 );
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTRenderBackendDX11::MapNoOverwrite( CPUTBackendHandle buffer )
+{
+    mStats.mMaps++;
+    D3D11_MAPPED_SUBRESOURCE mapInfo;
+    HRESULT hr = mpContext->Map( (ID3D11Buffer*)buffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapInfo );
+    return SUCCEEDED(hr) ? mapInfo.pData : NULL;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::UnmapRange( CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount )
+{
+    UNREFERENCED_PARAMETER(offset);
+    mStats.mBytesUploaded += byteCount;
+    mpContext->Unmap( (ID3D11Buffer*)buffer, 0 );
+}
+
+// Fences are event queries
+//-----------------------------------------------------------------------------
+CPUTBackendHandle CPUTRenderBackendDX11::CreateFence()
+{
+    D3D11_QUERY_DESC desc = { D3D11_QUERY_EVENT, 0 };
+    ID3D11Query *pQuery = NULL;
+    HRESULT hr = mpDevice->CreateQuery( &desc, &pQuery );
+    ASSERT( SUCCEEDED(hr), _L("Failed creating fence query") );
+    UNREFERENCED_PARAMETER(hr);
+    return pQuery;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::ReleaseFence( CPUTBackendHandle fence )
+{
+    ID3D11Query *pQuery = (ID3D11Query*)fence;
+    SAFE_RELEASE(pQuery);
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SignalFence( CPUTBackendHandle fence )
+{
+    mpContext->End( (ID3D11Query*)fence );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackendDX11::IsFenceComplete( CPUTBackendHandle fence )
+{
+    // Flushes, so polling in a loop can't wait on commands the driver hasn't submitted yet
+    return S_OK == mpContext->GetData( (ID3D11Query*)fence, NULL, 0, 0 );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetShader( CPUT_SHADER_STAGE stage, CPUTBackendHandle shader )
+{
+    if( !FilterShader( stage, shader ) ) { return; }
+    mStats.mShaderChanges++;
+    switch( stage )
+    {
+    case CPUT_SHADER_STAGE_VERTEX:   mpContext->VSSetShader( (ID3D11VertexShader*)  shader, NULL, 0 ); break;
+    case CPUT_SHADER_STAGE_PIXEL:    mpContext->PSSetShader( (ID3D11PixelShader*)   shader, NULL, 0 ); break;
+    case CPUT_SHADER_STAGE_GEOMETRY: mpContext->GSSetShader( (ID3D11GeometryShader*)shader, NULL, 0 ); break;
+    case CPUT_SHADER_STAGE_HULL:     mpContext->HSSetShader( (ID3D11HullShader*)    shader, NULL, 0 ); break;
+    case CPUT_SHADER_STAGE_DOMAIN:   mpContext->DSSetShader( (ID3D11DomainShader*)  shader, NULL, 0 ); break;
+    case CPUT_SHADER_STAGE_COMPUTE:  mpContext->CSSetShader( (ID3D11ComputeShader*) shader, NULL, 0 ); break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetConstantBuffers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pBuffers )
+{
+    if( !FilterSlots( mState.mConstantBuffers[stage], CPUT_BACKEND_MAX_CONSTANT_BUFFER_SLOTS, startSlot, count, pBuffers ) ) { return; }
+    mStats.mResourceBindings += count;
+    ID3D11Buffer *const *ppBuffers = (ID3D11Buffer *const *)pBuffers;
+    switch( stage )
+    {
+    case CPUT_SHADER_STAGE_VERTEX:   mpContext->VSSetConstantBuffers( startSlot, count, ppBuffers ); break;
+    case CPUT_SHADER_STAGE_PIXEL:    mpContext->PSSetConstantBuffers( startSlot, count, ppBuffers ); break;
+    case CPUT_SHADER_STAGE_GEOMETRY: mpContext->GSSetConstantBuffers( startSlot, count, ppBuffers ); break;
+    case CPUT_SHADER_STAGE_HULL:     mpContext->HSSetConstantBuffers( startSlot, count, ppBuffers ); break;
+    case CPUT_SHADER_STAGE_DOMAIN:   mpContext->DSSetConstantBuffers( startSlot, count, ppBuffers ); break;
+    case CPUT_SHADER_STAGE_COMPUTE:  mpContext->CSSetConstantBuffers( startSlot, count, ppBuffers ); break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetConstantBufferRange( CPUT_SHADER_STAGE stage, uint32_t slot, CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount )
+{
+#ifdef CPUT_FOR_DX11_1
+    ASSERT( mpContext1 && 0 == offset % CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT, _L("Constant buffer ranges aren't supported, or offset is misaligned") );
+    TrackConstantBufferRange( stage, slot );
+    mStats.mResourceBindings++;
+
+    // In constants (16 bytes), rounded up to a multiple of 16 constants
+    ID3D11Buffer *pBuffer       = (ID3D11Buffer*)buffer;
+    UINT          firstConstant = offset / 16;
+    UINT          numConstants  = ((byteCount + CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT - 1) / CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT) * 16;
+    switch( stage )
+    {
+    case CPUT_SHADER_STAGE_VERTEX:   mpContext1->VSSetConstantBuffers1( slot, 1, &pBuffer, &firstConstant, &numConstants ); break;
+    case CPUT_SHADER_STAGE_PIXEL:    mpContext1->PSSetConstantBuffers1( slot, 1, &pBuffer, &firstConstant, &numConstants ); break;
+    case CPUT_SHADER_STAGE_GEOMETRY: mpContext1->GSSetConstantBuffers1( slot, 1, &pBuffer, &firstConstant, &numConstants ); break;
+    case CPUT_SHADER_STAGE_HULL:     mpContext1->HSSetConstantBuffers1( slot, 1, &pBuffer, &firstConstant, &numConstants ); break;
+    case CPUT_SHADER_STAGE_DOMAIN:   mpContext1->DSSetConstantBuffers1( slot, 1, &pBuffer, &firstConstant, &numConstants ); break;
+    case CPUT_SHADER_STAGE_COMPUTE:  mpContext1->CSSetConstantBuffers1( slot, 1, &pBuffer, &firstConstant, &numConstants ); break;
+    }
+#else
+    UNREFERENCED_PARAMETER(stage); UNREFERENCED_PARAMETER(slot); UNREFERENCED_PARAMETER(buffer);
+    UNREFERENCED_PARAMETER(offset); UNREFERENCED_PARAMETER(byteCount);
+    ASSERT( false, _L("Constant buffer ranges need CPUT_FOR_DX11_1") );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetShaderResources( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pViews )
+{
+    if( !FilterSlots( mState.mShaderResources[stage], CPUT_BACKEND_MAX_SLOTS, startSlot, count, pViews ) ) { return; }
+    mStats.mResourceBindings += count;
+    ID3D11ShaderResourceView *const *ppViews = (ID3D11ShaderResourceView *const *)pViews;
+    switch( stage )
+    {
+    case CPUT_SHADER_STAGE_VERTEX:   mpContext->VSSetShaderResources( startSlot, count, ppViews ); break;
+    case CPUT_SHADER_STAGE_PIXEL:    mpContext->PSSetShaderResources( startSlot, count, ppViews ); break;
+    case CPUT_SHADER_STAGE_GEOMETRY: mpContext->GSSetShaderResources( startSlot, count, ppViews ); break;
+    case CPUT_SHADER_STAGE_HULL:     mpContext->HSSetShaderResources( startSlot, count, ppViews ); break;
+    case CPUT_SHADER_STAGE_DOMAIN:   mpContext->DSSetShaderResources( startSlot, count, ppViews ); break;
+    case CPUT_SHADER_STAGE_COMPUTE:  mpContext->CSSetShaderResources( startSlot, count, ppViews ); break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetSamplers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pSamplers )
+{
+    if( !FilterSlots( mState.mSamplers[stage], CPUT_BACKEND_MAX_SAMPLER_SLOTS, startSlot, count, pSamplers ) ) { return; }
+    mStats.mResourceBindings += count;
+    ID3D11SamplerState *const *ppSamplers = (ID3D11SamplerState *const *)pSamplers;
+    switch( stage )
+    {
+    case CPUT_SHADER_STAGE_VERTEX:   mpContext->VSSetSamplers( startSlot, count, ppSamplers ); break;
+    case CPUT_SHADER_STAGE_PIXEL:    mpContext->PSSetSamplers( startSlot, count, ppSamplers ); break;
+    case CPUT_SHADER_STAGE_GEOMETRY: mpContext->GSSetSamplers( startSlot, count, ppSamplers ); break;
+    case CPUT_SHADER_STAGE_HULL:     mpContext->HSSetSamplers( startSlot, count, ppSamplers ); break;
+    case CPUT_SHADER_STAGE_DOMAIN:   mpContext->DSSetSamplers( startSlot, count, ppSamplers ); break;
+    case CPUT_SHADER_STAGE_COMPUTE:  mpContext->CSSetSamplers( startSlot, count, ppSamplers ); break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetComputeUnorderedAccessViews( uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pUAVs )
+{
+    if( !FilterSlots( mState.mUAVs, CPUT_BACKEND_MAX_UAV_SLOTS, startSlot, count, pUAVs ) ) { return; }
+    InvalidateShaderResources();
+    mStats.mResourceBindings += count;
+    mpContext->CSSetUnorderedAccessViews( startSlot, count, (ID3D11UnorderedAccessView *const *)pUAVs, NULL );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetBlendState( CPUTBackendHandle state, const float *pBlendFactor, uint32_t sampleMask )
+{
+    if( !FilterBlendState( state, pBlendFactor, sampleMask ) ) { return; }
+    mStats.mStateChanges++;
+    mpContext->OMSetBlendState( (ID3D11BlendState*)state, pBlendFactor, sampleMask );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetDepthStencilState( CPUTBackendHandle state, uint32_t stencilRef )
+{
+    if( !FilterDepthStencilState( state, stencilRef ) ) { return; }
+    mStats.mStateChanges++;
+    mpContext->OMSetDepthStencilState( (ID3D11DepthStencilState*)state, stencilRef );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetRasterizerState( CPUTBackendHandle state )
+{
+    if( !FilterHandle( &mState.mRasterizerState, state ) ) { return; }
+    mStats.mStateChanges++;
+    mpContext->RSSetState( (ID3D11RasterizerState*)state );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetInputLayout( CPUTBackendHandle layout )
+{
+    if( !FilterHandle( &mState.mInputLayout, layout ) ) { return; }
+    mStats.mStateChanges++;
+    mpContext->IASetInputLayout( (ID3D11InputLayout*)layout );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetPrimitiveTopology( uint32_t topology )
+{
+    if( !FilterTopology( topology ) ) { return; }
+    mStats.mStateChanges++;
+    mpContext->IASetPrimitiveTopology( (D3D11_PRIMITIVE_TOPOLOGY)topology );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetVertexBuffer( uint32_t slot, CPUTBackendHandle buffer, uint32_t stride, uint32_t offset )
+{
+    if( !FilterVertexBuffer( slot, buffer, stride, offset ) ) { return; }
+    mStats.mBufferBindings++;
+    ID3D11Buffer *pBuffer = (ID3D11Buffer*)buffer;
+    UINT          strides = stride;
+    UINT          offsets = offset;
+    mpContext->IASetVertexBuffers( slot, 1, &pBuffer, &strides, &offsets );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetIndexBuffer( CPUTBackendHandle buffer, uint32_t format, uint32_t offset )
+{
+    if( !FilterIndexBuffer( buffer, format, offset ) ) { return; }
+    mStats.mBufferBindings++;
+    mpContext->IASetIndexBuffer( (ID3D11Buffer*)buffer, (DXGI_FORMAT)format, offset );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetRenderTargets( uint32_t count, CPUTBackendHandle const *pRenderTargetViews, CPUTBackendHandle depthStencilView )
+{
+    InvalidateResourceBindings();
+    TrackRenderTargets( count, pRenderTargetViews, depthStencilView );
+    mStats.mRenderTargetChanges++;
+    mpContext->OMSetRenderTargets( count, (ID3D11RenderTargetView *const *)pRenderTargetViews, (ID3D11DepthStencilView*)depthStencilView );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::SetViewport( const CPUTBackendViewport &viewport )
+{
+    TrackViewport( viewport );
+    mStats.mStateChanges++;
+    D3D11_VIEWPORT vp = { viewport.mTopLeftX, viewport.mTopLeftY, viewport.mWidth, viewport.mHeight, viewport.mMinDepth, viewport.mMaxDepth };
+    mpContext->RSSetViewports( 1, &vp );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::ClearRenderTarget( CPUTBackendHandle renderTargetView, const float *pColor )
+{
+    mStats.mClears++;
+    mpContext->ClearRenderTargetView( (ID3D11RenderTargetView*)renderTargetView, pColor );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::ClearDepthStencil( CPUTBackendHandle depthStencilView, uint32_t clearFlags, float depth, uint8_t stencil )
+{
+    mStats.mClears++;
+    mpContext->ClearDepthStencilView( (ID3D11DepthStencilView*)depthStencilView, clearFlags, depth, stencil );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::Draw( uint32_t vertexCount, uint32_t startVertex )
+{
+    mStats.mDrawCalls++;
+    mStats.mInstancesDrawn++;
+    mStats.mIndicesSubmitted += vertexCount;
+    mpContext->Draw( vertexCount, startVertex );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::DrawIndexed( uint32_t indexCount, uint32_t startIndex, int32_t baseVertex )
+{
+    mStats.mDrawCalls++;
+    mStats.mInstancesDrawn++;
+    mStats.mIndicesSubmitted += indexCount;
+    mpContext->DrawIndexed( indexCount, startIndex, baseVertex );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::DrawIndexedInstanced( uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance )
+{
+    mStats.mDrawCalls++;
+    mStats.mInstancesDrawn += instanceCount;
+    mStats.mIndicesSubmitted += (uint64_t)indexCount * instanceCount;
+    mpContext->DrawIndexedInstanced( indexCount, instanceCount, startIndex, baseVertex, startInstance );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendDX11::Present( uint32_t syncInterval )
+{
+    mStats.mPresents++;
+    if( mpSwapChain )
+    {
+        mpSwapChain->Present( syncInterval, 0 );
+    }
+}
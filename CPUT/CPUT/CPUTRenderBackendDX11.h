@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTRENDERBACKENDDX11_H__
+#define __CPUTRENDERBACKENDDX11_H__
+
+#include "CPUTRenderBackend.h"
+#include <d3d11.h>
+#ifdef CPUT_FOR_DX11_1
+#   include <d3d11_1.h> // Constant buffer ranges.  Needs the Windows 8 SDK.
+#endif
+
+// DX11 backend: forwards every call to an ID3D11DeviceContext and counts it.
+// Handles are the native ID3D11* pointers.  Deferred backends (see CreateDeferred())
+// wrap a deferred context of their own.  Constant buffer ranges need CPUT_FOR_DX11_1 and
+// a driver that supports constant buffer offsetting.
+//
+// Note: none of the projects define CPUT_FOR_DX11_1.  It needs d3d11_1.h from the Windows 8
+// SDK, and they build against the DirectX SDK.  So on DX11 builds SupportsConstantBufferRanges()
+// is false, CPUTUploadRing::Create() fails, and the render queue uploads each model's own
+// constant buffer instead.  To use the ring, define CPUT_FOR_DX11_1 in CPUT-DX11.vcxproj and
+// the sample's project and build with the Windows 8 SDK; QueryContext1() then turns ranges on
+// where the device reports ConstantBufferOffsetting.
+//-----------------------------------------------------------------------------
+class CPUTRenderBackendDX11 : public CPUTRenderBackend
+{
+protected:
+    ID3D11Device        *mpDevice;
+    ID3D11DeviceContext *mpContext;
+    IDXGISwapChain      *mpSwapChain;
+    bool                 mOwnsContext; // Deferred backends own their deferred context
+#ifdef CPUT_FOR_DX11_1
+    ID3D11DeviceContext1 *mpContext1;  // NULL unless constant buffer ranges are supported
+#endif
+
+    void QueryContext1();
+
+public:
+    // Note: doesn't AddRef().  The owner (CPUT_DX11) outlives the backend.
+    CPUTRenderBackendDX11( ID3D11Device *pDevice, ID3D11DeviceContext *pContext, IDXGISwapChain *pSwapChain ) :
+        mpDevice(pDevice),
+        mpContext(pContext),
+        mpSwapChain(pSwapChain),
+        mOwnsContext(false)
+    {
+        QueryContext1();
+    }
+    virtual ~CPUTRenderBackendDX11();
+
+    ID3D11DeviceContext *GetNativeContext() { return mpContext; }
+    void                 SetSwapChain( IDXGISwapChain *pSwapChain ) { mpSwapChain = pSwapChain; }
+
+    // CPUTRenderBackend
+    CPUTRenderBackend *CreateDeferred();
+    void               ExecuteDeferred( CPUTRenderBackend *pDeferred );
+
+    CPUTBackendHandle CreateBuffer( uint32_t byteWidth, uint32_t bindFlags, bool dynamic, const void *pInitialData );
+    void              ReleaseBuffer( CPUTBackendHandle buffer );
+    void             *Map( CPUTBackendHandle buffer );
+    void              Unmap( CPUTBackendHandle buffer, uint32_t bytesWritten );
+    void              UpdateBuffer( CPUTBackendHandle buffer, const void *pData, uint32_t byteCount );
+    void              UpdateBufferRange( CPUTBackendHandle buffer, uint32_t offset, const void *pData, uint32_t byteCount );
+    void             *MapNoOverwrite( CPUTBackendHandle buffer );
+    void              UnmapRange( CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount );
+
+    CPUTBackendHandle CreateFence();
+    void              ReleaseFence( CPUTBackendHandle fence );
+    void              SignalFence( CPUTBackendHandle fence );
+    bool              IsFenceComplete( CPUTBackendHandle fence );
+
+    void SetShader( CPUT_SHADER_STAGE stage, CPUTBackendHandle shader );
+    void SetConstantBuffers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pBuffers );
+    bool SupportsConstantBufferRanges() const;
+    void SetConstantBufferRange( CPUT_SHADER_STAGE stage, uint32_t slot, CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount );
+    void SetShaderResources( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pViews );
+    void SetSamplers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pSamplers );
+    void SetComputeUnorderedAccessViews( uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pUAVs );
+    void SetBlendState( CPUTBackendHandle state, const float *pBlendFactor, uint32_t sampleMask );
+    void SetDepthStencilState( CPUTBackendHandle state, uint32_t stencilRef );
+    void SetRasterizerState( CPUTBackendHandle state );
+
+    void SetInputLayout( CPUTBackendHandle layout );
+    void SetPrimitiveTopology( uint32_t topology );
+    void SetVertexBuffer( uint32_t slot, CPUTBackendHandle buffer, uint32_t stride, uint32_t offset );
+    void SetIndexBuffer( CPUTBackendHandle buffer, uint32_t format, uint32_t offset );
+
+    void SetRenderTargets( uint32_t count, CPUTBackendHandle const *pRenderTargetViews, CPUTBackendHandle depthStencilView );
+    void SetViewport( const CPUTBackendViewport &viewport );
+    void ClearRenderTarget( CPUTBackendHandle renderTargetView, const float *pColor );
+    void ClearDepthStencil( CPUTBackendHandle depthStencilView, uint32_t clearFlags, float depth, uint8_t stencil );
+
+    void Draw( uint32_t vertexCount, uint32_t startVertex );
+    void DrawIndexed( uint32_t indexCount, uint32_t startIndex, int32_t baseVertex );
+    void DrawIndexedInstanced( uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance );
+
+    void Present( uint32_t syncInterval );
+};
+
+#endif // __CPUTRENDERBACKENDDX11_H__
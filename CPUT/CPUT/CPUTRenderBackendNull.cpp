@@ -0,0 +1,473 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderBackendNull.h"
+
+//-----------------------------------------------------------------------------
+CPUTRenderBackendNull::CPUTRenderBackendNull() :
+    mNextHandle(1),
+    mRecording(false),
+    mFencesSignaled(0),
+    mFencesCompleted(0),
+    mFenceLatency(0)
+{
+    mScratch.resize( CPUT_NULL_BACKEND_SCRATCH_SIZE );
+}
+
+// Append a command (and its payload) to the recording.  Returns a dummy command when not recording.
+//-----------------------------------------------------------------------------
+CPUTBackendCommand &CPUTRenderBackendNull::Record( uint32_t type, CPUTBackendHandle handle, const void *pPayload, uint32_t payloadSize )
+{
+    if( !mRecording )
+    {
+        return mIgnored;
+    }
+    CPUTBackendCommand command;
+    memset( &command, 0, sizeof(command) );
+    command.mType          = type;
+    command.mHandle        = handle;
+    command.mPayloadOffset = (uint32_t)mPayload.size();
+    command.mPayloadSize   = payloadSize;
+    if( payloadSize )
+    {
+        const uint8_t *pBytes = (const uint8_t*)pPayload;
+        mPayload.insert( mPayload.end(), pBytes, pBytes + payloadSize );
+    }
+    mCommands.push_back( command );
+    return mCommands.back();
+}
+
+//-----------------------------------------------------------------------------
+CPUTBackendHandle CPUTRenderBackendNull::CreateBuffer( uint32_t byteWidth, uint32_t bindFlags, bool dynamic, const void *pInitialData )
+{
+    UNREFERENCED_PARAMETER(bindFlags);
+    UNREFERENCED_PARAMETER(dynamic);
+    CPUTBackendHandle handle = (CPUTBackendHandle)mNextHandle++;
+    std::vector<uint8_t> &shadow = mBuffers[handle];
+    shadow.resize( byteWidth );
+    if( pInitialData && byteWidth )
+    {
+        memcpy( &shadow[0], pInitialData, byteWidth );
+    }
+    mStats.mResourcesCreated++;
+    mStats.mBytesAllocated += byteWidth;
+    return handle;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::ReleaseBuffer( CPUTBackendHandle buffer )
+{
+    mBuffers.erase( buffer );
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTRenderBackendNull::Map( CPUTBackendHandle buffer )
+{
+    mStats.mMaps++;
+    std::map<CPUTBackendHandle, std::vector<uint8_t> >::iterator it = mBuffers.find( buffer );
+    if( it == mBuffers.end() || it->second.empty() )
+    {
+        // Not one of ours.  Hand out scratch memory so callers can still write their data.
+        return &mScratch[0];
+    }
+    return &it->second[0];
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::Unmap( CPUTBackendHandle buffer, uint32_t bytesWritten )
+{
+    std::map<CPUTBackendHandle, std::vector<uint8_t> >::iterator it = mBuffers.find( buffer );
+    const uint8_t *pData = &mScratch[0];
+    uint32_t       size  = CPUT_NULL_BACKEND_SCRATCH_SIZE;
+    if( it != mBuffers.end() && !it->second.empty() )
+    {
+        pData = &it->second[0];
+        size  = (uint32_t)it->second.size();
+    }
+    if( bytesWritten == 0 || bytesWritten > size )
+    {
+        bytesWritten = size;
+    }
+    mStats.mBytesUploaded += bytesWritten;
+
+    // A map/unmap pair is recorded as a buffer update so the recording is self-contained.
+    Record( CPUT_BACKEND_CMD_UPDATE_BUFFER, buffer, pData, bytesWritten );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::UpdateBuffer( CPUTBackendHandle buffer, const void *pData, uint32_t byteCount )
+{
+    std::map<CPUTBackendHandle, std::vector<uint8_t> >::iterator it = mBuffers.find( buffer );
+    if( it != mBuffers.end() && byteCount )
+    {
+        uint32_t size = (uint32_t)it->second.size();
+        memcpy( &it->second[0], pData, byteCount < size ? byteCount : size );
+    }
+    mStats.mBufferUpdates++;
+    mStats.mBytesUploaded += byteCount;
+    Record( CPUT_BACKEND_CMD_UPDATE_BUFFER, buffer, pData, byteCount );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::UpdateBufferRange( CPUTBackendHandle buffer, uint32_t offset, const void *pData, uint32_t byteCount )
+{
+    // Like UpdateBuffer(), counted and recorded even for buffers this backend didn't create
+    std::map<CPUTBackendHandle, std::vector<uint8_t> >::iterator it = mBuffers.find( buffer );
+    if( it != mBuffers.end() && byteCount && offset + byteCount <= it->second.size() )
+    {
+        memcpy( &it->second[offset], pData, byteCount );
+    }
+    mStats.mBufferUpdates++;
+    mStats.mBytesUploaded += byteCount;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_UPDATE_BUFFER, buffer, pData, byteCount );
+    command.mArg[0] = offset;
+    command.mArg[1] = 2;
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTRenderBackendNull::MapNoOverwrite( CPUTBackendHandle buffer )
+{
+    // The shadow copy is never discarded, so this is the same as Map()
+    return Map( buffer );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::UnmapRange( CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount )
+{
+    std::map<CPUTBackendHandle, std::vector<uint8_t> >::iterator it = mBuffers.find( buffer );
+    if( it == mBuffers.end() || offset + byteCount > it->second.size() )
+    {
+        return;
+    }
+    mStats.mBytesUploaded += byteCount;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_UPDATE_BUFFER, buffer, byteCount ? &it->second[offset] : 0, byteCount );
+    command.mArg[0] = offset;
+    command.mArg[1] = 1;
+}
+
+//-----------------------------------------------------------------------------
+CPUTBackendHandle CPUTRenderBackendNull::CreateFence()
+{
+    CPUTBackendHandle fence = (CPUTBackendHandle)mNextHandle++;
+    mFences[fence] = 0;
+    return fence;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::ReleaseFence( CPUTBackendHandle fence )
+{
+    mFences.erase( fence );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SignalFence( CPUTBackendHandle fence )
+{
+    mFences[fence] = ++mFencesSignaled;
+    if( mFencesSignaled > mFenceLatency + mFencesCompleted )
+    {
+        mFencesCompleted = mFencesSignaled - mFenceLatency;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderBackendNull::IsFenceComplete( CPUTBackendHandle fence )
+{
+    if( mFences[fence] <= mFencesCompleted )
+    {
+        return true;
+    }
+    mFencesCompleted++;
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetShader( CPUT_SHADER_STAGE stage, CPUTBackendHandle shader )
+{
+    if( !FilterShader( stage, shader ) ) { return; }
+    mStats.mShaderChanges++;
+    Record( CPUT_BACKEND_CMD_SET_SHADER, shader ).mArg[0] = stage;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetConstantBuffers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pBuffers )
+{
+    if( !FilterSlots( mState.mConstantBuffers[stage], CPUT_BACKEND_MAX_CONSTANT_BUFFER_SLOTS, startSlot, count, pBuffers ) ) { return; }
+    mStats.mResourceBindings += count;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_SET_CONSTANT_BUFFERS, 0, pBuffers, count * sizeof(CPUTBackendHandle) );
+    command.mArg[0] = stage;
+    command.mArg[1] = startSlot;
+    command.mArg[2] = count;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetConstantBufferRange( CPUT_SHADER_STAGE stage, uint32_t slot, CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount )
+{
+    TrackConstantBufferRange( stage, slot );
+    mStats.mResourceBindings++;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_SET_CONSTANT_BUFFER_RANGE, buffer );
+    command.mArg[0] = stage;
+    command.mArg[1] = slot;
+    command.mArg[2] = offset;
+    command.mArg[3] = byteCount;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetShaderResources( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pViews )
+{
+    if( !FilterSlots( mState.mShaderResources[stage], CPUT_BACKEND_MAX_SLOTS, startSlot, count, pViews ) ) { return; }
+    mStats.mResourceBindings += count;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_SET_SHADER_RESOURCES, 0, pViews, count * sizeof(CPUTBackendHandle) );
+    command.mArg[0] = stage;
+    command.mArg[1] = startSlot;
+    command.mArg[2] = count;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetSamplers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pSamplers )
+{
+    if( !FilterSlots( mState.mSamplers[stage], CPUT_BACKEND_MAX_SAMPLER_SLOTS, startSlot, count, pSamplers ) ) { return; }
+    mStats.mResourceBindings += count;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_SET_SAMPLERS, 0, pSamplers, count * sizeof(CPUTBackendHandle) );
+    command.mArg[0] = stage;
+    command.mArg[1] = startSlot;
+    command.mArg[2] = count;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetComputeUnorderedAccessViews( uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pUAVs )
+{
+    if( !FilterSlots( mState.mUAVs, CPUT_BACKEND_MAX_UAV_SLOTS, startSlot, count, pUAVs ) ) { return; }
+    InvalidateShaderResources();
+    mStats.mResourceBindings += count;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_SET_UAVS, 0, pUAVs, count * sizeof(CPUTBackendHandle) );
+    command.mArg[1] = startSlot;
+    command.mArg[2] = count;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetBlendState( CPUTBackendHandle state, const float *pBlendFactor, uint32_t sampleMask )
+{
+    if( !FilterBlendState( state, pBlendFactor, sampleMask ) ) { return; }
+    mStats.mStateChanges++;
+    static const float sDefaultFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    Record( CPUT_BACKEND_CMD_SET_BLEND_STATE, state, pBlendFactor ? pBlendFactor : sDefaultFactor, 4 * sizeof(float) ).mArg[0] = sampleMask;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetDepthStencilState( CPUTBackendHandle state, uint32_t stencilRef )
+{
+    if( !FilterDepthStencilState( state, stencilRef ) ) { return; }
+    mStats.mStateChanges++;
+    Record( CPUT_BACKEND_CMD_SET_DEPTH_STENCIL_STATE, state ).mArg[0] = stencilRef;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetRasterizerState( CPUTBackendHandle state )
+{
+    if( !FilterHandle( &mState.mRasterizerState, state ) ) { return; }
+    mStats.mStateChanges++;
+    Record( CPUT_BACKEND_CMD_SET_RASTERIZER_STATE, state );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetInputLayout( CPUTBackendHandle layout )
+{
+    if( !FilterHandle( &mState.mInputLayout, layout ) ) { return; }
+    mStats.mStateChanges++;
+    Record( CPUT_BACKEND_CMD_SET_INPUT_LAYOUT, layout );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetPrimitiveTopology( uint32_t topology )
+{
+    if( !FilterTopology( topology ) ) { return; }
+    mStats.mStateChanges++;
+    Record( CPUT_BACKEND_CMD_SET_PRIMITIVE_TOPOLOGY ).mArg[0] = topology;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetVertexBuffer( uint32_t slot, CPUTBackendHandle buffer, uint32_t stride, uint32_t offset )
+{
+    if( !FilterVertexBuffer( slot, buffer, stride, offset ) ) { return; }
+    mStats.mBufferBindings++;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_SET_VERTEX_BUFFER, buffer );
+    command.mArg[0] = slot;
+    command.mArg[1] = stride;
+    command.mArg[2] = offset;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetIndexBuffer( CPUTBackendHandle buffer, uint32_t format, uint32_t offset )
+{
+    if( !FilterIndexBuffer( buffer, format, offset ) ) { return; }
+    mStats.mBufferBindings++;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_SET_INDEX_BUFFER, buffer );
+    command.mArg[0] = format;
+    command.mArg[1] = offset;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetRenderTargets( uint32_t count, CPUTBackendHandle const *pRenderTargetViews, CPUTBackendHandle depthStencilView )
+{
+    InvalidateResourceBindings();
+    TrackRenderTargets( count, pRenderTargetViews, depthStencilView );
+    mStats.mRenderTargetChanges++;
+    Record( CPUT_BACKEND_CMD_SET_RENDER_TARGETS, depthStencilView, pRenderTargetViews, count * sizeof(CPUTBackendHandle) ).mArg[0] = count;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::SetViewport( const CPUTBackendViewport &viewport )
+{
+    TrackViewport( viewport );
+    mStats.mStateChanges++;
+    Record( CPUT_BACKEND_CMD_SET_VIEWPORT, 0, &viewport, sizeof(viewport) );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::ClearRenderTarget( CPUTBackendHandle renderTargetView, const float *pColor )
+{
+    mStats.mClears++;
+    Record( CPUT_BACKEND_CMD_CLEAR_RENDER_TARGET, renderTargetView, pColor, 4 * sizeof(float) );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::ClearDepthStencil( CPUTBackendHandle depthStencilView, uint32_t clearFlags, float depth, uint8_t stencil )
+{
+    mStats.mClears++;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_CLEAR_DEPTH_STENCIL, depthStencilView, &depth, sizeof(depth) );
+    command.mArg[0] = clearFlags;
+    command.mArg[1] = stencil;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::Draw( uint32_t vertexCount, uint32_t startVertex )
+{
+    mStats.mDrawCalls++;
+    mStats.mInstancesDrawn++;
+    mStats.mIndicesSubmitted += vertexCount;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_DRAW );
+    command.mArg[0] = vertexCount;
+    command.mArg[1] = startVertex;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::DrawIndexed( uint32_t indexCount, uint32_t startIndex, int32_t baseVertex )
+{
+    mStats.mDrawCalls++;
+    mStats.mInstancesDrawn++;
+    mStats.mIndicesSubmitted += indexCount;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_DRAW_INDEXED );
+    command.mArg[0] = indexCount;
+    command.mArg[1] = startIndex;
+    command.mArg[2] = (uint32_t)baseVertex;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::DrawIndexedInstanced( uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance )
+{
+    mStats.mDrawCalls++;
+    mStats.mInstancesDrawn += instanceCount;
+    mStats.mIndicesSubmitted += (uint64_t)indexCount * instanceCount;
+    CPUTBackendCommand &command = Record( CPUT_BACKEND_CMD_DRAW_INDEXED_INSTANCED );
+    command.mArg[0] = indexCount;
+    command.mArg[1] = instanceCount;
+    command.mArg[2] = startIndex;
+    command.mArg[3] = (uint32_t)baseVertex;
+    command.mArg[4] = startInstance;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::Present( uint32_t syncInterval )
+{
+    mStats.mPresents++;
+    Record( CPUT_BACKEND_CMD_PRESENT ).mArg[0] = syncInterval;
+}
+
+// Re-issue the recorded command stream, in order, on another backend.
+// A deferred null backend records, and executing it replays the recording here
+//-----------------------------------------------------------------------------
+CPUTRenderBackend *CPUTRenderBackendNull::CreateDeferred()
+{
+    CPUTRenderBackendNull *pDeferred = new CPUTRenderBackendNull();
+    pDeferred->SetRecording( true );
+    return pDeferred;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::ExecuteDeferred( CPUTRenderBackend *pDeferred )
+{
+    // Replay() goes through this backend's Set*() methods, which count the calls (again)
+    CPUTRenderBackendNull *pDeferredNull = (CPUTRenderBackendNull*)pDeferred;
+    pDeferredNull->Replay( this );
+    pDeferredNull->ClearRecording();
+    pDeferredNull->ResetStats();
+    pDeferredNull->InvalidateStateCache();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderBackendNull::Replay( CPUTRenderBackend *pTarget ) const
+{
+    for( size_t ii=0; ii<mCommands.size(); ii++ )
+    {
+        const CPUTBackendCommand &cmd      = mCommands[ii];
+        const void               *pPayload = GetRecordedPayload( cmd );
+        CPUT_SHADER_STAGE         stage    = (CPUT_SHADER_STAGE)cmd.mArg[0];
+        CPUTBackendHandle const  *pHandles = (CPUTBackendHandle const*)pPayload;
+
+        switch( cmd.mType )
+        {
+        case CPUT_BACKEND_CMD_UPDATE_BUFFER:
+            if( 1 == cmd.mArg[1] )
+            {
+                uint8_t *pMapped = (uint8_t*)pTarget->MapNoOverwrite( cmd.mHandle );
+                if( pMapped && cmd.mPayloadSize )
+                {
+                    memcpy( pMapped + cmd.mArg[0], pPayload, cmd.mPayloadSize );
+                }
+                pTarget->UnmapRange( cmd.mHandle, cmd.mArg[0], cmd.mPayloadSize );
+            }
+            else if( 2 == cmd.mArg[1] )
+            {
+                pTarget->UpdateBufferRange( cmd.mHandle, cmd.mArg[0], pPayload, cmd.mPayloadSize );
+            }
+            else
+            {
+                pTarget->UpdateBuffer( cmd.mHandle, pPayload, cmd.mPayloadSize );
+            }
+            break;
+        case CPUT_BACKEND_CMD_SET_SHADER:              pTarget->SetShader( stage, cmd.mHandle ); break;
+        case CPUT_BACKEND_CMD_SET_CONSTANT_BUFFERS:    pTarget->SetConstantBuffers( stage, cmd.mArg[1], cmd.mArg[2], pHandles ); break;
+        case CPUT_BACKEND_CMD_SET_CONSTANT_BUFFER_RANGE: pTarget->SetConstantBufferRange( stage, cmd.mArg[1], cmd.mHandle, cmd.mArg[2], cmd.mArg[3] ); break;
+        case CPUT_BACKEND_CMD_SET_SHADER_RESOURCES:    pTarget->SetShaderResources( stage, cmd.mArg[1], cmd.mArg[2], pHandles ); break;
+        case CPUT_BACKEND_CMD_SET_SAMPLERS:            pTarget->SetSamplers( stage, cmd.mArg[1], cmd.mArg[2], pHandles ); break;
+        case CPUT_BACKEND_CMD_SET_UAVS:                pTarget->SetComputeUnorderedAccessViews( cmd.mArg[1], cmd.mArg[2], pHandles ); break;
+        case CPUT_BACKEND_CMD_SET_BLEND_STATE:         pTarget->SetBlendState( cmd.mHandle, (const float*)pPayload, cmd.mArg[0] ); break;
+        case CPUT_BACKEND_CMD_SET_DEPTH_STENCIL_STATE: pTarget->SetDepthStencilState( cmd.mHandle, cmd.mArg[0] ); break;
+        case CPUT_BACKEND_CMD_SET_RASTERIZER_STATE:    pTarget->SetRasterizerState( cmd.mHandle ); break;
+        case CPUT_BACKEND_CMD_SET_INPUT_LAYOUT:        pTarget->SetInputLayout( cmd.mHandle ); break;
+        case CPUT_BACKEND_CMD_SET_PRIMITIVE_TOPOLOGY:  pTarget->SetPrimitiveTopology( cmd.mArg[0] ); break;
+        case CPUT_BACKEND_CMD_SET_VERTEX_BUFFER:       pTarget->SetVertexBuffer( cmd.mArg[0], cmd.mHandle, cmd.mArg[1], cmd.mArg[2] ); break;
+        case CPUT_BACKEND_CMD_SET_INDEX_BUFFER:        pTarget->SetIndexBuffer( cmd.mHandle, cmd.mArg[0], cmd.mArg[1] ); break;
+        case CPUT_BACKEND_CMD_SET_RENDER_TARGETS:      pTarget->SetRenderTargets( cmd.mArg[0], pHandles, cmd.mHandle ); break;
+        case CPUT_BACKEND_CMD_SET_VIEWPORT:            pTarget->SetViewport( *(const CPUTBackendViewport*)pPayload ); break;
+        case CPUT_BACKEND_CMD_CLEAR_RENDER_TARGET:     pTarget->ClearRenderTarget( cmd.mHandle, (const float*)pPayload ); break;
+        case CPUT_BACKEND_CMD_CLEAR_DEPTH_STENCIL:     pTarget->ClearDepthStencil( cmd.mHandle, cmd.mArg[0], *(const float*)pPayload, (uint8_t)cmd.mArg[1] ); break;
+        case CPUT_BACKEND_CMD_DRAW:                    pTarget->Draw( cmd.mArg[0], cmd.mArg[1] ); break;
+        case CPUT_BACKEND_CMD_DRAW_INDEXED:            pTarget->DrawIndexed( cmd.mArg[0], cmd.mArg[1], (int32_t)cmd.mArg[2] ); break;
+        case CPUT_BACKEND_CMD_DRAW_INDEXED_INSTANCED:  pTarget->DrawIndexedInstanced( cmd.mArg[0], cmd.mArg[1], cmd.mArg[2], (int32_t)cmd.mArg[3], cmd.mArg[4] ); break;
+        case CPUT_BACKEND_CMD_PRESENT:                 pTarget->Present( cmd.mArg[0] ); break;
+        }
+    }
+}
@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTRENDERBACKENDNULL_H__
+#define __CPUTRENDERBACKENDNULL_H__
+
+#include "CPUTRenderBackend.h"
+#include <vector>
+#include <map>
+
+// Largest block Map() will hand out for a buffer the null backend didn't create
+// (e.g., a constant buffer created directly on the device).  D3D11 caps constant buffers at 64KB.
+const uint32_t CPUT_NULL_BACKEND_SCRATCH_SIZE = 65536;
+
+//-----------------------------------------------------------------------------
+enum CPUT_BACKEND_COMMAND_TYPE
+{
+    CPUT_BACKEND_CMD_UPDATE_BUFFER = 0,     // mArg[0] = offset, mArg[1] = 1 for a MapNoOverwrite()/UnmapRange() pair, 2 for UpdateBufferRange()
+    CPUT_BACKEND_CMD_SET_SHADER,
+    CPUT_BACKEND_CMD_SET_CONSTANT_BUFFERS,
+    CPUT_BACKEND_CMD_SET_CONSTANT_BUFFER_RANGE,
+    CPUT_BACKEND_CMD_SET_SHADER_RESOURCES,
+    CPUT_BACKEND_CMD_SET_SAMPLERS,
+    CPUT_BACKEND_CMD_SET_UAVS,
+    CPUT_BACKEND_CMD_SET_BLEND_STATE,
+    CPUT_BACKEND_CMD_SET_DEPTH_STENCIL_STATE,
+    CPUT_BACKEND_CMD_SET_RASTERIZER_STATE,
+    CPUT_BACKEND_CMD_SET_INPUT_LAYOUT,
+    CPUT_BACKEND_CMD_SET_PRIMITIVE_TOPOLOGY,
+    CPUT_BACKEND_CMD_SET_VERTEX_BUFFER,
+    CPUT_BACKEND_CMD_SET_INDEX_BUFFER,
+    CPUT_BACKEND_CMD_SET_RENDER_TARGETS,
+    CPUT_BACKEND_CMD_SET_VIEWPORT,
+    CPUT_BACKEND_CMD_CLEAR_RENDER_TARGET,
+    CPUT_BACKEND_CMD_CLEAR_DEPTH_STENCIL,
+    CPUT_BACKEND_CMD_DRAW,
+    CPUT_BACKEND_CMD_DRAW_INDEXED,
+    CPUT_BACKEND_CMD_DRAW_INDEXED_INSTANCED,
+    CPUT_BACKEND_CMD_PRESENT,
+};
+
+// One recorded command.  Variable-sized arguments (handle arrays, upload data,
+// colors, viewports) live in the owning backend's payload buffer.
+//-----------------------------------------------------------------------------
+struct CPUTBackendCommand
+{
+    uint32_t          mType;
+    uint32_t          mArg[5];
+    CPUTBackendHandle mHandle;
+    uint32_t          mPayloadOffset;
+    uint32_t          mPayloadSize;
+};
+
+// Null backend: accepts every call, creates synthetic handles, keeps CPU-side
+// shadow copies of buffers it created, and updates the same counters as the real
+// backends.  Optionally records the command stream so a frame can be inspected
+// or replayed into another backend.
+//-----------------------------------------------------------------------------
+class CPUTRenderBackendNull : public CPUTRenderBackend
+{
+protected:
+    uintptr_t                                           mNextHandle;
+    std::map<CPUTBackendHandle, std::vector<uint8_t> >  mBuffers;
+    std::vector<uint8_t>                                mScratch;
+    bool                                                mRecording;
+    std::vector<CPUTBackendCommand>                     mCommands;
+    std::vector<uint8_t>                                mPayload;
+    CPUTBackendCommand                                  mIgnored; // Written to (and ignored) when not recording
+
+    // Simulated GPU progress for fences.  Signaled fences get increasing values, and the "GPU" stays
+    // mFenceLatency fences behind.  Polling an incomplete fence lets it catch up by one.
+    std::map<CPUTBackendHandle, uint64_t>               mFences;
+    uint64_t                                            mFencesSignaled;
+    uint64_t                                            mFencesCompleted;
+    uint32_t                                            mFenceLatency;
+
+    CPUTBackendCommand &Record( uint32_t type, CPUTBackendHandle handle = 0, const void *pPayload = 0, uint32_t payloadSize = 0 );
+
+public:
+    CPUTRenderBackendNull();
+    virtual ~CPUTRenderBackendNull() {}
+
+    virtual bool IsNull() const { return true; }
+
+    // Recording
+    void     SetRecording( bool recording ) { mRecording = recording; }
+    bool     IsRecording() const            { return mRecording; }
+    void     ClearRecording()               { mCommands.clear(); mPayload.clear(); }
+    uint32_t GetRecordedCommandCount() const { return (uint32_t)mCommands.size(); }
+    const CPUTBackendCommand &GetRecordedCommand( uint32_t index ) const { return mCommands[index]; }
+    const void *GetRecordedPayload( const CPUTBackendCommand &command ) const { return command.mPayloadSize ? &mPayload[command.mPayloadOffset] : 0; }
+    void     Replay( CPUTRenderBackend *pTarget ) const;
+
+    uint32_t GetLiveBufferCount() const { return (uint32_t)mBuffers.size(); }
+    void     SetFenceLatency( uint32_t fences ) { mFenceLatency = fences; }
+
+    // CPUTRenderBackend
+    CPUTRenderBackend *CreateDeferred();
+    void               ExecuteDeferred( CPUTRenderBackend *pDeferred );
+
+    CPUTBackendHandle CreateBuffer( uint32_t byteWidth, uint32_t bindFlags, bool dynamic, const void *pInitialData );
+    void              ReleaseBuffer( CPUTBackendHandle buffer );
+    void             *Map( CPUTBackendHandle buffer );
+    void              Unmap( CPUTBackendHandle buffer, uint32_t bytesWritten );
+    void              UpdateBuffer( CPUTBackendHandle buffer, const void *pData, uint32_t byteCount );
+    void              UpdateBufferRange( CPUTBackendHandle buffer, uint32_t offset, const void *pData, uint32_t byteCount );
+    void             *MapNoOverwrite( CPUTBackendHandle buffer );
+    void              UnmapRange( CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount );
+
+    CPUTBackendHandle CreateFence();
+    void              ReleaseFence( CPUTBackendHandle fence );
+    void              SignalFence( CPUTBackendHandle fence );
+    bool              IsFenceComplete( CPUTBackendHandle fence );
+
+    void SetShader( CPUT_SHADER_STAGE stage, CPUTBackendHandle shader );
+    void SetConstantBuffers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pBuffers );
+    bool SupportsConstantBufferRanges() const { return true; }
+    void SetConstantBufferRange( CPUT_SHADER_STAGE stage, uint32_t slot, CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount );
+    void SetShaderResources( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pViews );
+    void SetSamplers( CPUT_SHADER_STAGE stage, uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pSamplers );
+    void SetComputeUnorderedAccessViews( uint32_t startSlot, uint32_t count, CPUTBackendHandle const *pUAVs );
+    void SetBlendState( CPUTBackendHandle state, const float *pBlendFactor, uint32_t sampleMask );
+    void SetDepthStencilState( CPUTBackendHandle state, uint32_t stencilRef );
+    void SetRasterizerState( CPUTBackendHandle state );
+
+    void SetInputLayout( CPUTBackendHandle layout );
+    void SetPrimitiveTopology( uint32_t topology );
+    void SetVertexBuffer( uint32_t slot, CPUTBackendHandle buffer, uint32_t stride, uint32_t offset );
+    void SetIndexBuffer( CPUTBackendHandle buffer, uint32_t format, uint32_t offset );
+
+    void SetRenderTargets( uint32_t count, CPUTBackendHandle const *pRenderTargetViews, CPUTBackendHandle depthStencilView );
+    void SetViewport( const CPUTBackendViewport &viewport );
+    void ClearRenderTarget( CPUTBackendHandle renderTargetView, const float *pColor );
+    void ClearDepthStencil( CPUTBackendHandle depthStencilView, uint32_t clearFlags, float depth, uint8_t stencil );
+
+    void Draw( uint32_t vertexCount, uint32_t startVertex );
+    void DrawIndexed( uint32_t indexCount, uint32_t startIndex, int32_t baseVertex );
+    void DrawIndexedInstanced( uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance );
+
+    void Present( uint32_t syncInterval );
+};
+
+#endif // __CPUTRENDERBACKENDNULL_H__
@@ -0,0 +1,409 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderGraph.h"
+#include "CPUTProfiler.h"
+#include <assert.h>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+CPUTBackendHandle CPUTRenderGraphAllocatorNull::CreateTexture( const CPUTRenderGraphTextureDesc &desc, const CPUTStringID *pNames, uint32_t nameCount )
+{
+    UNREFERENCED_PARAMETER(pNames);
+    UNREFERENCED_PARAMETER(nameCount);
+    CPUTBackendHandle handle = (CPUTBackendHandle)mNextHandle++;
+    mHandles.push_back( handle );
+    mBytes.push_back( desc.GetBytes() );
+    mLiveBytes += desc.GetBytes();
+    return handle;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraphAllocatorNull::ReleaseTexture( CPUTBackendHandle texture )
+{
+    for( size_t ii=0; ii<mHandles.size(); ii++ )
+    {
+        if( mHandles[ii] == texture )
+        {
+            mLiveBytes -= mBytes[ii];
+            mHandles.erase( mHandles.begin() + ii );
+            mBytes.erase( mBytes.begin() + ii );
+            return;
+        }
+    }
+    assert( !"Released a texture the null allocator didn't create" );
+}
+
+//-----------------------------------------------------------------------------
+CPUTRenderGraph::CPUTRenderGraph() :
+    mpAllocator(NULL),
+    mCompiled(false)
+{
+    memset( &mStats, 0, sizeof(mStats) );
+}
+
+//-----------------------------------------------------------------------------
+CPUTRenderGraph::~CPUTRenderGraph()
+{
+    ReleaseTextures();
+}
+
+//-----------------------------------------------------------------------------
+CPUTRenderGraphResource CPUTRenderGraph::CreateTexture( CPUTStringID name, const CPUTRenderGraphTextureDesc &desc )
+{
+    Resource resource;
+    memset( &resource, 0, sizeof(resource) );
+    resource.mName     = name;
+    resource.mDesc     = desc;
+    resource.mImported = false;
+    mResources.push_back( resource );
+    mCompiled = false;
+    return (CPUTRenderGraphResource)mResources.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+CPUTRenderGraphResource CPUTRenderGraph::ImportTexture( CPUTStringID name, CPUTBackendHandle texture )
+{
+    Resource resource;
+    memset( &resource, 0, sizeof(resource) );
+    resource.mName     = name;
+    resource.mImported = true;
+    resource.mTexture  = texture;
+    mResources.push_back( resource );
+    mCompiled = false;
+    return (CPUTRenderGraphResource)mResources.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTRenderGraph::AddPass( const char *pName, CPUTRenderPass *pPass, bool neverCull )
+{
+    Pass pass;
+    pass.mpName       = pName;
+    pass.mpPass       = pPass;
+    pass.mNeverCull   = neverCull;
+    pass.mCulled      = false;
+    pass.mFirstAccess = (uint32_t)mAccesses.size();
+    pass.mAccessCount = 0;
+    mPasses.push_back( pass );
+    mCompiled = false;
+    return (uint32_t)mPasses.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::AddAccess( uint32_t pass, CPUTRenderGraphResource resource, bool write )
+{
+    assert( pass == mPasses.size() - 1 && "Declare a pass's reads and writes before adding the next pass" );
+    assert( resource < mResources.size() );
+    Access access;
+    access.mResource = resource;
+    access.mWrite    = write;
+    mAccesses.push_back( access );
+    mPasses[pass].mAccessCount++;
+    mCompiled = false;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTRenderGraph::HasAccess( uint32_t pass, CPUTRenderGraphResource resource, bool write ) const
+{
+    const Pass &declared = mPasses[pass];
+    for( uint32_t ii=0; ii<declared.mAccessCount; ii++ )
+    {
+        const Access &access = mAccesses[declared.mFirstAccess + ii];
+        if( access.mResource == resource && access.mWrite == write )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Walks the passes backwards, tracking which resources a later running pass (or, for
+// imported ones, the world after the graph) still needs
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::Cull()
+{
+    std::vector<bool> needed( mResources.size() );
+    for( size_t ii=0; ii<mResources.size(); ii++ )
+    {
+        needed[ii] = mResources[ii].mImported;
+    }
+    for( size_t pp=mPasses.size(); pp--; )
+    {
+        Pass &pass = mPasses[pp];
+        const Access *pAccesses = pass.mAccessCount ? &mAccesses[pass.mFirstAccess] : NULL;
+        bool run = pass.mNeverCull;
+        for( uint32_t ii=0; ii<pass.mAccessCount && !run; ii++ )
+        {
+            run = pAccesses[ii].mWrite && needed[pAccesses[ii].mResource];
+        }
+        pass.mCulled = !run;
+        if( run )
+        {
+            // What it writes, earlier passes needn't; what it reads, they must (in that
+            // order, for a pass that both reads and writes a resource)
+            for( uint32_t ii=0; ii<pass.mAccessCount; ii++ )
+            {
+                if( pAccesses[ii].mWrite && !mResources[pAccesses[ii].mResource].mImported )
+                {
+                    needed[pAccesses[ii].mResource] = false;
+                }
+            }
+            for( uint32_t ii=0; ii<pass.mAccessCount; ii++ )
+            {
+                if( !pAccesses[ii].mWrite )
+                {
+                    needed[pAccesses[ii].mResource] = true;
+                }
+            }
+        }
+    }
+
+    mOrder.clear();
+    for( uint32_t pp=0; pp<mPasses.size(); pp++ )
+    {
+        if( !mPasses[pp].mCulled )
+        {
+            mOrder.push_back( pp );
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::ComputeLifetimes()
+{
+    for( size_t ii=0; ii<mResources.size(); ii++ )
+    {
+        mResources[ii].mFirstUse = 1;
+        mResources[ii].mLastUse  = 0;
+    }
+    for( uint32_t position=0; position<mOrder.size(); position++ )
+    {
+        const Pass &pass = mPasses[mOrder[position]];
+        for( uint32_t ii=0; ii<pass.mAccessCount; ii++ )
+        {
+            const Access &access = mAccesses[pass.mFirstAccess + ii];
+            Resource &resource = mResources[access.mResource];
+            if( resource.mFirstUse > resource.mLastUse )
+            {
+                // A transient has no contents until a pass writes it
+                assert( (resource.mImported || access.mWrite) && "A pass reads a transient texture before any pass writes it" );
+                resource.mFirstUse = position;
+            }
+            resource.mLastUse = position;
+        }
+    }
+}
+
+// Greedy, in order of first use: take a free texture with the same description, or make one
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::AssignTextures()
+{
+    std::vector< std::pair<uint32_t, CPUTRenderGraphResource> > byFirstUse;
+    for( uint32_t ii=0; ii<mResources.size(); ii++ )
+    {
+        mResources[ii].mTextureIndex = CPUT_RENDER_GRAPH_NONE;
+        if( !mResources[ii].mImported && IsUsed( ii ) )
+        {
+            byFirstUse.push_back( std::make_pair( mResources[ii].mFirstUse, ii ) );
+        }
+    }
+    std::sort( byFirstUse.begin(), byFirstUse.end() );
+
+    for( size_t ii=0; ii<byFirstUse.size(); ii++ )
+    {
+        Resource &resource = mResources[byFirstUse[ii].second];
+        uint32_t textureIndex = CPUT_RENDER_GRAPH_NONE;
+        for( uint32_t tt=0; tt<mTextures.size(); tt++ )
+        {
+            if( mTextures[tt].mLastUse < resource.mFirstUse && mTextures[tt].mDesc == resource.mDesc )
+            {
+                textureIndex = tt;
+                break;
+            }
+        }
+        if( CPUT_RENDER_GRAPH_NONE == textureIndex )
+        {
+            Texture texture;
+            texture.mDesc   = resource.mDesc;
+            texture.mHandle = NULL;
+            textureIndex = (uint32_t)mTextures.size();
+            mTextures.push_back( texture );
+            mStats.mTextureBytes += resource.mDesc.GetBytes();
+        }
+        mTextures[textureIndex].mLastUse = resource.mLastUse;
+        resource.mTextureIndex = textureIndex;
+        mStats.mTransients++;
+        mStats.mTransientBytes += resource.mDesc.GetBytes();
+    }
+    mStats.mTextures = (uint32_t)mTextures.size();
+}
+
+// Largest first, each at the lowest offset clear of those already placed that are live
+// at the same time
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::PlaceInHeap()
+{
+    std::vector< std::pair<uint64_t, CPUTRenderGraphResource> > bySize;
+    for( uint32_t ii=0; ii<mResources.size(); ii++ )
+    {
+        if( CPUT_RENDER_GRAPH_NONE != mResources[ii].mTextureIndex )
+        {
+            uint64_t size = (mResources[ii].mDesc.GetBytes() + CPUT_RENDER_GRAPH_HEAP_ALIGNMENT - 1) & ~(CPUT_RENDER_GRAPH_HEAP_ALIGNMENT - 1);
+            bySize.push_back( std::make_pair( ~size, ii ) ); // ~size sorts largest first
+        }
+    }
+    std::sort( bySize.begin(), bySize.end() );
+
+    std::vector<CPUTRenderGraphResource> placed;
+    std::vector<uint64_t>                candidates;
+    for( size_t ii=0; ii<bySize.size(); ii++ )
+    {
+        Resource &resource = mResources[bySize[ii].second];
+        uint64_t  size     = ~bySize[ii].first;
+
+        // It goes at 0 or right after something live at the same time
+        candidates.clear();
+        candidates.push_back( 0 );
+        for( size_t pp=0; pp<placed.size(); pp++ )
+        {
+            const Resource &other = mResources[placed[pp]];
+            if( other.mFirstUse <= resource.mLastUse && resource.mFirstUse <= other.mLastUse )
+            {
+                uint64_t otherSize = (other.mDesc.GetBytes() + CPUT_RENDER_GRAPH_HEAP_ALIGNMENT - 1) & ~(CPUT_RENDER_GRAPH_HEAP_ALIGNMENT - 1);
+                candidates.push_back( other.mHeapOffset + otherSize );
+            }
+        }
+        std::sort( candidates.begin(), candidates.end() );
+
+        for( size_t cc=0; cc<candidates.size(); cc++ )
+        {
+            uint64_t offset = candidates[cc];
+            bool fits = true;
+            for( size_t pp=0; pp<placed.size() && fits; pp++ )
+            {
+                const Resource &other = mResources[placed[pp]];
+                uint64_t otherSize = (other.mDesc.GetBytes() + CPUT_RENDER_GRAPH_HEAP_ALIGNMENT - 1) & ~(CPUT_RENDER_GRAPH_HEAP_ALIGNMENT - 1);
+                fits = !( other.mFirstUse <= resource.mLastUse && resource.mFirstUse <= other.mLastUse &&
+                          other.mHeapOffset < offset + size && offset < other.mHeapOffset + otherSize );
+            }
+            if( fits )
+            {
+                resource.mHeapOffset = offset;
+                break;
+            }
+        }
+        placed.push_back( bySize[ii].second );
+        mStats.mHeapBytes = std::max( mStats.mHeapBytes, resource.mHeapOffset + size );
+    }
+
+    for( uint32_t position=0; position<mOrder.size(); position++ )
+    {
+        uint64_t live = 0;
+        for( size_t pp=0; pp<placed.size(); pp++ )
+        {
+            const Resource &resource = mResources[placed[pp]];
+            if( resource.mFirstUse <= position && position <= resource.mLastUse )
+            {
+                live += resource.mDesc.GetBytes();
+            }
+        }
+        mStats.mPeakBytes = std::max( mStats.mPeakBytes, live );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::Compile( CPUTRenderGraphAllocator *pAllocator )
+{
+    ReleaseTextures();
+    memset( &mStats, 0, sizeof(mStats) );
+
+    Cull();
+    ComputeLifetimes();
+    AssignTextures();
+    PlaceInHeap();
+    mStats.mPasses       = (uint32_t)mPasses.size();
+    mStats.mPassesCulled = (uint32_t)(mPasses.size() - mOrder.size());
+
+    mpAllocator = pAllocator;
+    if( mpAllocator )
+    {
+        std::vector<CPUTStringID> names;
+        for( uint32_t tt=0; tt<mTextures.size(); tt++ )
+        {
+            names.clear();
+            for( size_t ii=0; ii<mResources.size(); ii++ )
+            {
+                if( tt == mResources[ii].mTextureIndex )
+                {
+                    names.push_back( mResources[ii].mName );
+                }
+            }
+            mTextures[tt].mHandle = mpAllocator->CreateTexture( mTextures[tt].mDesc, &names[0], (uint32_t)names.size() );
+        }
+    }
+    for( size_t ii=0; ii<mResources.size(); ii++ )
+    {
+        Resource &resource = mResources[ii];
+        if( !resource.mImported )
+        {
+            resource.mTexture = (CPUT_RENDER_GRAPH_NONE != resource.mTextureIndex) ? mTextures[resource.mTextureIndex].mHandle : NULL;
+        }
+    }
+    mCompiled = true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::Execute( void *pContext )
+{
+    assert( mCompiled && "Compile() the graph after changing it" );
+    for( size_t ii=0; ii<mOrder.size(); ii++ )
+    {
+        const Pass &pass = mPasses[mOrder[ii]];
+        CPUT_PROFILE_ZONE( pass.mpName );
+        pass.mpPass->Execute( *this, pContext );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::ReleaseTextures()
+{
+    for( size_t tt=0; tt<mTextures.size(); tt++ )
+    {
+        if( mTextures[tt].mHandle )
+        {
+            mpAllocator->ReleaseTexture( mTextures[tt].mHandle );
+        }
+    }
+    mTextures.clear();
+    for( size_t ii=0; ii<mResources.size(); ii++ )
+    {
+        if( !mResources[ii].mImported )
+        {
+            mResources[ii].mTexture = NULL;
+        }
+    }
+    mCompiled = false;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraph::Reset()
+{
+    ReleaseTextures();
+    mResources.clear();
+    mPasses.clear();
+    mAccesses.clear();
+    mOrder.clear();
+    memset( &mStats, 0, sizeof(mStats) );
+}
@@ -0,0 +1,215 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTRENDERGRAPH_H__
+#define __CPUTRENDERGRAPH_H__
+
+// A frame's passes, declared up front with the textures each reads and writes.
+//
+// Textures are transient (created by the graph, with contents that only live between
+// the passes that write and read them) or imported (created elsewhere, such as the back
+// buffer, and read after the graph runs).  Compile():
+//
+//   - Culls passes whose output nothing reads: a pass runs if it's marked never-cull,
+//     or writes an imported texture, or writes a transient a running pass reads later.
+//     A write replaces the whole texture; a pass that blends or depth-tests into one
+//     also declares a read of it.
+//   - Orders the passes that run.  A pass reads what the passes added before it wrote,
+//     so the order they were added in already satisfies every dependency, and is kept.
+//   - Gives each transient a lifetime (its first and last pass), and aliases transients
+//     whose lifetimes don't overlap, in two ways.  Transients with the same description
+//     share one texture: that's what DX11 can do, and what the allocator creates.  And
+//     each gets an offset in one heap that any transients may share, as APIs with
+//     placed resources allow; GetStats() reports that heap's size next to the rest.
+//
+// The graph doesn't know the graphics API.  Textures come from a CPUTRenderGraphAllocator
+// (CPUTRenderGraphAllocatorNull hands out synthetic handles), and passes get whatever
+// context the caller gives Execute(), so graphs compile and run headless.
+#include "CPUTRenderBackend.h"
+#include "CPUTStringID.h"
+#include <vector>
+
+typedef uint32_t CPUTRenderGraphResource;
+const CPUTRenderGraphResource CPUT_RENDER_GRAPH_NONE = 0xFFFFFFFF;
+
+// Placed resources start on multiples of this (the D3D12 default)
+const uint64_t CPUT_RENDER_GRAPH_HEAP_ALIGNMENT = 65536;
+
+//-----------------------------------------------------------------------------
+enum CPUT_RENDER_GRAPH_TEXTURE_FLAG
+{
+    CPUT_RENDER_GRAPH_DEPTH = 0x1,          // A depth-stencil target (else a color target)
+    CPUT_RENDER_GRAPH_UAV   = 0x2,
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTRenderGraphTextureDesc
+{
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mFormat;           // The API's format (a DXGI_FORMAT on DX11)
+    uint32_t mBytesPerPixel;    // For the memory estimates
+    uint32_t mSampleCount;
+    uint32_t mFlags;            // CPUT_RENDER_GRAPH_TEXTURE_FLAG
+
+    uint64_t GetBytes() const { return (uint64_t)mWidth * mHeight * mBytesPerPixel * mSampleCount; }
+    bool operator==( const CPUTRenderGraphTextureDesc &other ) const { return 0 == memcmp( this, &other, sizeof(*this) ); }
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTRenderGraphStats
+{
+    uint32_t mPasses;
+    uint32_t mPassesCulled;
+    uint32_t mTransients;       // Used by passes that run
+    uint32_t mTextures;         // Created for them
+    uint64_t mTransientBytes;   // One texture per transient: no aliasing
+    uint64_t mTextureBytes;     // Transients with the same description sharing textures
+    uint64_t mHeapBytes;        // Transients placed in one heap
+    uint64_t mPeakBytes;        // Most transient bytes live during any one pass: the least any aliasing could need
+};
+
+class CPUTRenderGraph;
+
+//-----------------------------------------------------------------------------
+class CPUTRenderPass
+{
+public:
+    virtual ~CPUTRenderPass() {}
+
+    // pContext is what was passed to CPUTRenderGraph::Execute()
+    virtual void Execute( CPUTRenderGraph &graph, void *pContext ) = 0;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTRenderGraphAllocator
+{
+public:
+    virtual ~CPUTRenderGraphAllocator() {}
+
+    // One texture for the transients named in pNames, which share it
+    virtual CPUTBackendHandle CreateTexture( const CPUTRenderGraphTextureDesc &desc, const CPUTStringID *pNames, uint32_t nameCount ) = 0;
+    virtual void              ReleaseTexture( CPUTBackendHandle texture ) = 0;
+};
+
+// Synthetic handles, and a count of the bytes they'd take
+//-----------------------------------------------------------------------------
+class CPUTRenderGraphAllocatorNull : public CPUTRenderGraphAllocator
+{
+protected:
+    uintptr_t                         mNextHandle;
+    std::vector<CPUTBackendHandle>    mHandles;
+    std::vector<uint64_t>             mBytes;
+    uint64_t                          mLiveBytes;
+
+public:
+    CPUTRenderGraphAllocatorNull() : mNextHandle(1), mLiveBytes(0) {}
+
+    CPUTBackendHandle CreateTexture( const CPUTRenderGraphTextureDesc &desc, const CPUTStringID *pNames, uint32_t nameCount );
+    void              ReleaseTexture( CPUTBackendHandle texture );
+
+    uint32_t GetLiveTextureCount() const { return (uint32_t)mHandles.size(); }
+    uint64_t GetLiveBytes() const        { return mLiveBytes; }
+};
+
+//-----------------------------------------------------------------------------
+class CPUTRenderGraph
+{
+protected:
+    struct Resource
+    {
+        CPUTStringID                mName;
+        CPUTRenderGraphTextureDesc  mDesc;
+        bool                        mImported;
+        CPUTBackendHandle           mTexture;
+        uint32_t                    mFirstUse;      // Positions in mOrder.  mFirstUse > mLastUse if unused.
+        uint32_t                    mLastUse;
+        uint32_t                    mTextureIndex;  // Into mTextures, for transients
+        uint64_t                    mHeapOffset;
+    };
+    struct Access
+    {
+        CPUTRenderGraphResource     mResource;
+        bool                        mWrite;
+    };
+    struct Pass
+    {
+        const char                 *mpName;         // A string literal: it names the pass's profiler zone
+        CPUTRenderPass             *mpPass;
+        bool                        mNeverCull;
+        bool                        mCulled;
+        uint32_t                    mFirstAccess;
+        uint32_t                    mAccessCount;
+    };
+    struct Texture
+    {
+        CPUTRenderGraphTextureDesc  mDesc;
+        CPUTBackendHandle           mHandle;
+        uint32_t                    mLastUse;
+    };
+
+    std::vector<Resource>           mResources;
+    std::vector<Pass>               mPasses;
+    std::vector<Access>             mAccesses;
+    std::vector<uint32_t>           mOrder;         // Passes that run, in order
+    std::vector<Texture>            mTextures;
+    CPUTRenderGraphAllocator       *mpAllocator;
+    CPUTRenderGraphStats            mStats;
+    bool                            mCompiled;
+
+    void AddAccess( uint32_t pass, CPUTRenderGraphResource resource, bool write );
+    void Cull();
+    void ComputeLifetimes();
+    void AssignTextures();
+    void PlaceInHeap();
+    void ReleaseTextures();
+
+    CPUTRenderGraph( const CPUTRenderGraph & );
+    CPUTRenderGraph &operator=( const CPUTRenderGraph & );
+
+public:
+    CPUTRenderGraph();
+    ~CPUTRenderGraph();
+
+    // Declaring.  Declare a pass's reads and writes right after adding it.
+    CPUTRenderGraphResource CreateTexture( CPUTStringID name, const CPUTRenderGraphTextureDesc &desc );
+    CPUTRenderGraphResource ImportTexture( CPUTStringID name, CPUTBackendHandle texture );
+    uint32_t                AddPass( const char *pName, CPUTRenderPass *pPass, bool neverCull = false );
+    void                    Read(  uint32_t pass, CPUTRenderGraphResource resource ) { AddAccess( pass, resource, false ); }
+    void                    Write( uint32_t pass, CPUTRenderGraphResource resource ) { AddAccess( pass, resource, true ); }
+
+    // Culls, orders and aliases, then creates the transients' textures with pAllocator.
+    // With pAllocator NULL, only plans.  Releases textures from an earlier Compile().
+    void Compile( CPUTRenderGraphAllocator *pAllocator );
+
+    // Runs the passes that weren't culled, in order
+    void Execute( void *pContext );
+
+    // Releases the textures and forgets every pass and resource
+    void Reset();
+
+    // Results of Compile()
+    CPUTBackendHandle GetTexture( CPUTRenderGraphResource resource ) const { return mResources[resource].mTexture; }
+    uint32_t          GetTextureIndex( CPUTRenderGraphResource resource ) const { return mResources[resource].mTextureIndex; }
+    uint64_t          GetHeapOffset( CPUTRenderGraphResource resource ) const { return mResources[resource].mHeapOffset; }
+    bool              IsUsed( CPUTRenderGraphResource resource ) const { return mResources[resource].mFirstUse <= mResources[resource].mLastUse; }
+    bool              IsCulled( uint32_t pass ) const { return mPasses[pass].mCulled; }
+    bool              HasAccess( uint32_t pass, CPUTRenderGraphResource resource, bool write ) const; // As declared
+    uint32_t          GetOrderedPassCount() const { return (uint32_t)mOrder.size(); }
+    uint32_t          GetOrderedPass( uint32_t index ) const { return mOrder[index]; }
+    const CPUTRenderGraphStats &GetStats() const { return mStats; }
+};
+
+#endif // __CPUTRENDERGRAPH_H__
@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUT_DX11.h"
+#include "CPUTRenderGraphDX11.h"
+#include "CPUTRenderTarget.h"
+#include "CPUTAssetLibrary.h"
+#include "CPUTTexture.h"
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+CPUTBackendHandle CPUTRenderGraphAllocatorDX11::CreateTexture( const CPUTRenderGraphTextureDesc &desc, const CPUTStringID *pNames, uint32_t nameCount )
+{
+    CPUTAssetLibrary *pAssetLibrary = CPUTAssetLibrary::GetAssetLibrary();
+    cString name( CPUTStringTable::GetString( pNames[0] ) );
+    CPUTTexture *pTexture;
+    CPUTBackendHandle handle;
+    HRESULT hr;
+    if( desc.mFlags & CPUT_RENDER_GRAPH_DEPTH )
+    {
+        CPUTRenderTargetDepth *pTarget = new CPUTRenderTargetDepth();
+        hr = pTarget->CreateRenderTarget( name, desc.mWidth, desc.mHeight, (DXGI_FORMAT)desc.mFormat, desc.mSampleCount );
+        ASSERT( SUCCEEDED(hr), _L("Failed creating render graph depth target ") + name );
+        pTexture = pTarget->GetDepthTexture();
+        handle   = pTarget;
+        mDepthTargets.push_back( handle );
+    }
+    else
+    {
+        CPUTRenderTargetColor *pTarget = new CPUTRenderTargetColor();
+        hr = pTarget->CreateRenderTarget( name, desc.mWidth, desc.mHeight, (DXGI_FORMAT)desc.mFormat, desc.mSampleCount, 0 != (desc.mFlags & CPUT_RENDER_GRAPH_UAV) );
+        ASSERT( SUCCEEDED(hr), _L("Failed creating render graph color target ") + name );
+        pTexture = pTarget->GetColorTexture();
+        handle   = pTarget;
+    }
+    UNREFERENCED_PARAMETER(hr);
+
+    // The other transients aliased to this texture
+    for( uint32_t ii=1; ii<nameCount; ii++ )
+    {
+        pAssetLibrary->AddTexture( cString( CPUTStringTable::GetString( pNames[ii] ) ), pTexture );
+    }
+    return handle;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderGraphAllocatorDX11::ReleaseTexture( CPUTBackendHandle texture )
+{
+    std::vector<CPUTBackendHandle>::iterator it = std::find( mDepthTargets.begin(), mDepthTargets.end(), texture );
+    if( it != mDepthTargets.end() )
+    {
+        mDepthTargets.erase( it );
+        delete (CPUTRenderTargetDepth*)texture;
+    }
+    else
+    {
+        delete (CPUTRenderTargetColor*)texture;
+    }
+}
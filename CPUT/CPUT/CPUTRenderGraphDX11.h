@@ -0,0 +1,39 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTRENDERGRAPHDX11_H__
+#define __CPUTRENDERGRAPHDX11_H__
+
+#include "CPUTRenderGraph.h"
+
+class CPUTRenderTargetColor;
+class CPUTRenderTargetDepth;
+
+// Creates a CPUTRenderTargetColor for each color texture and a CPUTRenderTargetDepth for
+// each depth texture; that's what their CPUTBackendHandles point to.  The texture is in
+// the asset library under every name that shares it, so materials can bind it by any of
+// them.  Compile the graph before loading the materials that do.
+//-----------------------------------------------------------------------------
+class CPUTRenderGraphAllocatorDX11 : public CPUTRenderGraphAllocator
+{
+protected:
+    std::vector<CPUTBackendHandle> mDepthTargets;
+
+public:
+    CPUTBackendHandle CreateTexture( const CPUTRenderGraphTextureDesc &desc, const CPUTStringID *pNames, uint32_t nameCount );
+    void              ReleaseTexture( CPUTBackendHandle texture );
+};
+
+#endif // __CPUTRENDERGRAPHDX11_H__
@@ -17,6 +17,46 @@
 
 #include "CPUTOSServicesWin.h" // for OutputDebugString();
 
+// Made by the first node and never destroyed (like the string table), so nodes can be
+// created and deleted while other files' statics are constructed or destroyed.
+static CPUTPoolSet *volatile spNodePools = NULL;
+
+//-----------------------------------------------------------------------------
+static CPUTPoolSet *GetNodePools()
+{
+    CPUTPoolSet *pPools = spNodePools;
+    if( !pPools )
+    {
+        // 64-byte size classes up to 1KB, which covers models, cameras, lights and null nodes.
+        // If two threads make the first nodes at once, the loser's pools are thrown away.
+        pPools = new CPUTPoolSet( 64, 1024, 32 );
+        CPUTPoolSet *pExisting = (CPUTPoolSet*)InterlockedCompareExchangePointer( (PVOID volatile*)&spNodePools, pPools, NULL );
+        if( pExisting )
+        {
+            delete pPools;
+            pPools = pExisting;
+        }
+    }
+    return pPools;
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTRenderNode::operator new( size_t size )
+{
+    return GetNodePools()->Allocate( size );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderNode::operator delete( void *pNode, size_t size )
+{
+    GetNodePools()->Free( pNode, size );
+}
+
+//-----------------------------------------------------------------------------
+CPUTPoolStats CPUTRenderNode::GetPoolStats()
+{
+    return GetNodePools()->GetStats();
+}
 
 // Constructor
 //-----------------------------------------------------------------------------
@@ -25,12 +65,8 @@ CPUTRenderNode::CPUTRenderNode():
     mpChild(NULL),
     mpSibling(NULL)
 {
-    // set transform to identity
-    mWorldMatrix  = float4x4Identity();
-    mParentMatrix = float4x4Identity();
-
-    // always create with everything dirty
-    mWorldMatrixDirty = true;
+    // New transforms start as identity roots
+    mTransform = CPUTTransformHierarchy::GetDefaultHierarchy()->Allocate();
 }
 
 // Destructor
@@ -40,6 +76,7 @@ CPUTRenderNode::~CPUTRenderNode()
     SAFE_RELEASE(mpParent);
     SAFE_RELEASE(mpChild);
     SAFE_RELEASE(mpSibling);
+    CPUTTransformHierarchy::GetDefaultHierarchy()->Free(mTransform);
 }
 
 //-----------------------------------------------------------------------------
@@ -100,6 +137,7 @@ void CPUTRenderNode::SetParent(CPUTRenderNode *pParent)
         pParent->AddRef();
     }
     mpParent = pParent;
+    CPUTTransformHierarchy::GetDefaultHierarchy()->SetParent(mTransform, pParent ? pParent->mTransform : CPUT_INVALID_TRANSFORM);
 }
 
 //-----------------------------------------------------------------------------
@@ -133,44 +171,12 @@ void CPUTRenderNode::AddSibling(CPUTRenderNode *pNode )
     }
 }
 
-// Return the model's cumulative transform
-//-----------------------------------------------------------------------------
-float4x4* CPUTRenderNode::GetWorldMatrix()
-{
-    if(mWorldMatrixDirty)
-    {
-        if(NULL!=mpParent)
-        {
-            float4x4 *pParentWorldMatrix = mpParent->GetWorldMatrix();
-            mWorldMatrix = mParentMatrix * *pParentWorldMatrix;
-        }
-        else
-        {
-            mWorldMatrix = mParentMatrix;
-        }
-       mWorldMatrixDirty = false;
-    }
-
-    // copy it
-    return &mWorldMatrix;
-}
-
-// Recursively visit all sub-nodes in breadth-first mode and mark their
-// cumulative transforms as dirty
+// Flag this node's transform as changed.  The hierarchy recomputes it and
+// everything below it on the next GetWorldMatrix() (one linear pass).
 //-----------------------------------------------------------------------------
 void CPUTRenderNode::MarkDirty()
 {
-    mWorldMatrixDirty = true;
-
-    if(mpSibling)
-    {
-        mpSibling->MarkDirty();
-    }
-
-    if(mpChild)
-    {
-        mpChild->MarkDirty();
-    }
+    CPUTTransformHierarchy::GetDefaultHierarchy()->MarkDirty(mTransform);
 }
 
 // Update - recursively visit all sub-nodes in breadth-first mode
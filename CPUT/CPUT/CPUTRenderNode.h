@@ -20,6 +20,8 @@
 #include "CPUTRefCount.h"
 #include "CPUTMath.h"
 #include "CPUTConfigBlock.h"
+#include "CPUTTransformHierarchy.h"
+#include "CPUTAllocator.h"
 
 // forward declarations
 class CPUTCamera;
@@ -31,15 +33,19 @@ protected:
     CPUTRenderNode     *mpParent;
     CPUTRenderNode     *mpChild;
     CPUTRenderNode     *mpSibling;
-    bool                mWorldMatrixDirty;
-    float4x4            mWorldMatrix; // transform of this object combined with it's parent(s) transform(s)
-    float4x4            mParentMatrix;   // transform of this object relative to it's parent
+    CPUTTransformHandle mTransform;    // parent-relative and world transforms live in the default CPUTTransformHierarchy
     cString             mPrefix;
     ~CPUTRenderNode(); // Destructor is not public.  Must release instead of delete.
 
 public:
     CPUTRenderNode();
 
+    // Nodes, and everything derived from them, come from pools by size (see CPUTAllocator.h).
+    // The virtual destructor makes delete pass the derived class's size.
+    static void *operator new( size_t size );
+    static void  operator delete( void *pNode, size_t size );
+    static CPUTPoolStats GetPoolStats();
+
     void Scale(float xx, float yy, float zz)
     {
         float4x4 scale(
@@ -48,7 +54,8 @@ public:
             0.0f, 0.0f,   zz, 0.0f,
             0.0f, 0.0f, 0.0f,    1
         );
-        mParentMatrix = mParentMatrix * scale;
+        float4x4 *pParentMatrix = GetParentMatrix();
+        *pParentMatrix = *pParentMatrix * scale;
         MarkDirty();
     }
     void Scale(float xx)
@@ -59,51 +66,57 @@ public:
          0.0f, 0.0f,   xx, 0.0f,
          0.0f, 0.0f, 0.0f,    1
         );
-        mParentMatrix = mParentMatrix * scale;
+        float4x4 *pParentMatrix = GetParentMatrix();
+        *pParentMatrix = *pParentMatrix * scale;
         MarkDirty();
     }
     void SetPosition(float x, float y, float z)
     {
-        mParentMatrix.r3.x = x;
-        mParentMatrix.r3.y = y;
-        mParentMatrix.r3.z = z;
+        float4x4 *pParentMatrix = GetParentMatrix();
+        pParentMatrix->r3.x = x;
+        pParentMatrix->r3.y = y;
+        pParentMatrix->r3.z = z;
         MarkDirty();
     }
     void SetPosition(float3 &position)
     {
-        mParentMatrix.r3.x = position.x;
-        mParentMatrix.r3.y = position.y;
-        mParentMatrix.r3.z = position.z;
+        float4x4 *pParentMatrix = GetParentMatrix();
+        pParentMatrix->r3.x = position.x;
+        pParentMatrix->r3.y = position.y;
+        pParentMatrix->r3.z = position.z;
         MarkDirty();
     }
     void GetPosition(float *pX, float *pY, float *pZ)
     {
-        *pX = mParentMatrix.r3.x;
-        *pY = mParentMatrix.r3.y;
-        *pZ = mParentMatrix.r3.z;
+        float4x4 *pParentMatrix = GetParentMatrix();
+        *pX = pParentMatrix->r3.x;
+        *pY = pParentMatrix->r3.y;
+        *pZ = pParentMatrix->r3.z;
     }
     void GetPosition(float3 *pPosition)
     {
-        pPosition->x = mParentMatrix.r3.x;
-        pPosition->y = mParentMatrix.r3.y;
-        pPosition->z = mParentMatrix.r3.z;
+        float4x4 *pParentMatrix = GetParentMatrix();
+        pPosition->x = pParentMatrix->r3.x;
+        pPosition->y = pParentMatrix->r3.y;
+        pPosition->z = pParentMatrix->r3.z;
     }
     float3 GetPosition()
     {
-        float3 ret = float3( mParentMatrix.r3.x, mParentMatrix.r3.y, mParentMatrix.r3.z);
+        float4x4 *pParentMatrix = GetParentMatrix();
+        float3 ret = float3( pParentMatrix->r3.x, pParentMatrix->r3.y, pParentMatrix->r3.z);
         return ret;
     }
     float3 GetLook()
     {
-        return mParentMatrix.getZAxis();
+        return GetParentMatrix()->getZAxis();
     }
     float3 GetUp()
     {
-        return mParentMatrix.getYAxis();
+        return GetParentMatrix()->getYAxis();
     }
     float3 GetLook( float *pX, float *pY, float *pZ )
     {
-        float3 look = mParentMatrix.getZAxis();
+        float3 look = GetParentMatrix()->getZAxis();
         *pX = look.x;
         *pY = look.y;
         *pZ = look.z;
@@ -119,8 +132,10 @@ public:
     cString         &GetPrefix()       { return mPrefix; }
     void             SetPrefix( cString &prefix ) { mPrefix = prefix; }
     virtual bool     IsModel()         { return false; }
-    float4x4        *GetParentMatrix() { return &mParentMatrix; }
-    float4x4        *GetWorldMatrix();
+    // Valid until the next render node is created or reparented (see CPUTTransformHierarchy.h)
+    float4x4        *GetParentMatrix() { return CPUTTransformHierarchy::GetDefaultHierarchy()->GetLocal(mTransform); }
+    float4x4        *GetWorldMatrix()  { return CPUTTransformHierarchy::GetDefaultHierarchy()->GetWorld(mTransform); }
+    CPUTTransformHandle GetTransformHandle() { return mTransform; }
     void             MarkDirty();
     void             AddChild(CPUTRenderNode *pNode);
     void             AddSibling(CPUTRenderNode *pNode);
@@ -132,8 +147,7 @@ public:
     virtual void     RenderShadowRecursive(CPUTRenderParameters &renderParams);
     void             SetParentMatrix(const float4x4 &parentMatrix)
     {
-        mParentMatrix = parentMatrix;
-        MarkDirty();
+        CPUTTransformHierarchy::GetDefaultHierarchy()->SetLocal(mTransform, parentMatrix);
     }
     void LoadParentMatrixFromParameterBlock( CPUTConfigBlock *pBlock )
     {
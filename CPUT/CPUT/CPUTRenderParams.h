@@ -18,6 +18,22 @@
 
 // TODO:  Change name to CPUTRenderContext?
 class CPUTCamera;
+class CPUTRenderBackend;
+class CPUTOcclusionCuller;
+class CPUTRenderQueue;
+class CPUTUploadRing;
+class CPUTLateLatch;
+class CPUTArena;
+
+// Passes, in submission order.  The pass is the most significant field of a render queue sort key.
+enum CPUT_RENDER_PASS
+{
+    CPUT_RENDER_PASS_SHADOW = 0,
+    CPUT_RENDER_PASS_OPAQUE,
+    CPUT_RENDER_PASS_SKY,
+    CPUT_RENDER_PASS_GUI,
+    CPUT_RENDER_PASS_COUNT
+};
 
 class CPUTRenderParameters
 {
@@ -25,13 +41,29 @@ public:
     bool         mShowBoundingBoxes;
     bool         mDrawModels;
     bool         mRenderOnlyVisibleModels;
+    bool         mModelsFrustumCulled; // Models' frustum visibility was already computed against mpCamera (see CPUTAssetSet::CullModels())
     CPUTCamera  *mpCamera;
+    CPUTRenderBackend *mpBackend; // Everything submitted while rendering goes through here
+    CPUTOcclusionCuller *mpOcclusionCuller; // Optional.  Models that pass frustum culling are also tested against it.
+    CPUTRenderQueue *mpRenderQueue; // Optional.  When set, models queue their meshes here instead of drawing them.
+    CPUT_RENDER_PASS mRenderPass;   // Pass models are queued into by Render() (RenderShadow() always uses CPUT_RENDER_PASS_SHADOW)
+    CPUTUploadRing *mpUploadRing;   // Optional.  The render queue suballocates per-model constants from it.
+    CPUTLateLatch *mpLateLatch;     // Optional.  Submit() calls it before writing any constants (see CPUTLateLatch.h).
+    CPUTArena *mpFrameArena;        // Optional.  Scratch memory that lives until the end of the frame (see CPUT::GetFrameArena()).
 
     CPUTRenderParameters() :
         mShowBoundingBoxes(false),
         mDrawModels(true),
         mRenderOnlyVisibleModels(true),
-        mpCamera(0)
+        mModelsFrustumCulled(false),
+        mpCamera(0),
+        mpBackend(0),
+        mpOcclusionCuller(0),
+        mpRenderQueue(0),
+        mRenderPass(CPUT_RENDER_PASS_OPAQUE),
+        mpUploadRing(0),
+        mpLateLatch(0),
+        mpFrameArena(0)
     {}
     ~CPUTRenderParameters(){}
 private:
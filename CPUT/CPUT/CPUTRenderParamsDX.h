@@ -20,6 +20,7 @@
 #include <d3d11.h>
 #include <xnamath.h>
 #include "CPUTRenderParams.h"
+#include "CPUTRenderBackend.h"
 
 class CPUTRenderParametersDX : public CPUTRenderParameters
 {
@@ -0,0 +1,480 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderQueue.h"
+#include "CPUTModel.h"
+#include "CPUTMaterial.h"
+#include "CPUTLateLatch.h"
+#include "CPUTMesh.h"
+#include "CPUTProfiler.h"
+#include "CPUTRenderBackend.h"
+#include "CPUTThreadPool.h"
+#include "CPUTTransformHierarchy.h"
+#include "CPUTUploadRing.h"
+#include <map>
+#include <string.h>
+
+const uint32_t CPUT_SORT_MATERIAL_SHIFT = CPUT_SORT_DEPTH_BITS;
+const uint32_t CPUT_SORT_STATE_SHIFT    = CPUT_SORT_MATERIAL_SHIFT + CPUT_SORT_MATERIAL_BITS;
+const uint32_t CPUT_SORT_SHADER_SHIFT   = CPUT_SORT_STATE_SHIFT    + CPUT_SORT_STATE_BITS;
+const uint32_t CPUT_SORT_PASS_SHIFT     = CPUT_SORT_SHADER_SHIFT   + CPUT_SORT_SHADER_BITS;
+
+const uint32_t CPUT_NOT_INSTANCED = 0xFFFFFFFF;
+
+uint32_t CPUTRenderQueue::mSubmitCount = 0;
+
+static std::map<std::pair<const void*, const void*>, uint32_t> gSortIds[CPUT_SORT_FIELD_COUNT];
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTRenderQueue::MakeKey( CPUT_RENDER_PASS pass, uint32_t shaderId, uint32_t stateId, uint32_t materialId, uint32_t depth )
+{
+    return ((uint64_t)pass                                                  << CPUT_SORT_PASS_SHIFT)
+         | ((uint64_t)(shaderId   & ((1u << CPUT_SORT_SHADER_BITS)   - 1)) << CPUT_SORT_SHADER_SHIFT)
+         | ((uint64_t)(stateId    & ((1u << CPUT_SORT_STATE_BITS)    - 1)) << CPUT_SORT_STATE_SHIFT)
+         | ((uint64_t)(materialId & ((1u << CPUT_SORT_MATERIAL_BITS) - 1)) << CPUT_SORT_MATERIAL_SHIFT)
+         |  (uint64_t)(depth      & ((1u << CPUT_SORT_DEPTH_BITS)    - 1));
+}
+
+// Non-negative floats order the same as their bit patterns.  Keep the top
+// CPUT_SORT_DEPTH_BITS of the 31 non-sign bits.
+//-----------------------------------------------------------------------------
+uint32_t CPUTRenderQueue::QuantizeDepth( float distance )
+{
+    if( !(distance > 0.0f) ) { return 0; } // Also catches NaN
+    uint32_t bits;
+    memcpy( &bits, &distance, sizeof(bits) );
+    return bits >> (31 - CPUT_SORT_DEPTH_BITS);
+}
+
+// The mesh id keeps instances of a mesh together.  The remaining bits still order
+// the instances (and the runs of different meshes) front to back.
+//-----------------------------------------------------------------------------
+uint32_t CPUTRenderQueue::MakeInstancedDepth( uint32_t meshId, uint32_t depth )
+{
+    const uint32_t depthBits = CPUT_SORT_DEPTH_BITS - CPUT_SORT_INSTANCED_MESH_BITS;
+    return ((meshId & ((1u << CPUT_SORT_INSTANCED_MESH_BITS) - 1)) << depthBits) | (depth >> CPUT_SORT_INSTANCED_MESH_BITS);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTRenderQueue::GetSortId( CPUT_SORT_FIELD field, const void *pObject0, const void *pObject1 )
+{
+    std::map<std::pair<const void*, const void*>, uint32_t> &ids = gSortIds[field];
+    std::pair<const void*, const void*> objects( pObject0, pObject1 );
+    std::map<std::pair<const void*, const void*>, uint32_t>::iterator it = ids.find( objects );
+    if( it != ids.end() )
+    {
+        return it->second;
+    }
+    uint32_t id = (uint32_t)ids.size();
+    ids[objects] = id;
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::AddPacket( uint64_t key, CPUTModel *pModel, CPUTMaterial *pMaterial, uint32_t meshIndex )
+{
+    CPUTDrawPacket packet;
+    packet.mpModel    = pModel;
+    packet.mpMaterial = pMaterial;
+    packet.mMeshIndex = meshIndex;
+
+    SortItem item;
+    item.mKey    = key;
+    item.mPacket = (uint32_t)mPackets.size();
+
+    mPackets.push_back( packet );
+    mItems.push_back( item );
+}
+
+// LSD radix sort, one byte per pass.  All eight histograms are built in a single
+// sweep, and passes where every key has the same byte are skipped (the pass and
+// shader bytes often are).
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::Sort()
+{
+    CPUT_PROFILE_ZONE("Sort render queue");
+    uint32_t count = (uint32_t)mItems.size();
+    if( count < 2 )
+    {
+        return;
+    }
+    mScratch.resize( count );
+
+    uint32_t histogram[8][256];
+    memset( histogram, 0, sizeof(histogram) );
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        uint64_t key = mItems[ii].mKey;
+        for( uint32_t bb=0; bb<8; bb++ )
+        {
+            histogram[bb][(key >> (bb*8)) & 0xFF]++;
+        }
+    }
+
+    SortItem *pSrc = &mItems[0];
+    SortItem *pDst = &mScratch[0];
+    for( uint32_t bb=0; bb<8; bb++ )
+    {
+        uint32_t shift = bb*8;
+        uint32_t *pCount = histogram[bb];
+        if( pCount[(pSrc[0].mKey >> shift) & 0xFF] == count )
+        {
+            continue;
+        }
+        uint32_t offset = 0;
+        for( uint32_t ii=0; ii<256; ii++ )
+        {
+            uint32_t bucketCount = pCount[ii];
+            pCount[ii] = offset;
+            offset += bucketCount;
+        }
+        for( uint32_t ii=0; ii<count; ii++ )
+        {
+            pDst[pCount[(pSrc[ii].mKey >> shift) & 0xFF]++] = pSrc[ii];
+        }
+        SortItem *pTemp = pSrc; pSrc = pDst; pDst = pTemp;
+    }
+    if( pSrc != &mItems[0] )
+    {
+        memcpy( &mItems[0], pSrc, count * sizeof(SortItem) );
+    }
+}
+
+// Records one range of the sorted packets on its own deferred backend
+//-----------------------------------------------------------------------------
+class CPUTRenderQueueRecordTask : public CPUTTask
+{
+public:
+    CPUTRenderQueue            *mpQueue;
+    const CPUTRenderParameters *mpRenderParams;
+    uint32_t                    mCount;
+    uint32_t                    mRangeCount;
+    uint32_t                    mSubmitIndex;
+
+    void Execute( uint32_t taskIndex, uint32_t /*threadIndex*/ )
+    {
+        CPUTRenderBackend *pDeferred = mpQueue->mDeferred[taskIndex];
+        pDeferred->InheritState( *mpRenderParams->mpBackend );
+
+        CPUTRenderParameters renderParams = *mpRenderParams;
+        renderParams.mpBackend     = pDeferred;
+        renderParams.mpRenderQueue = 0;
+        uint32_t first = (uint32_t)((uint64_t)mCount *  taskIndex    / mRangeCount);
+        uint32_t end   = (uint32_t)((uint64_t)mCount * (taskIndex+1) / mRangeCount);
+        mpQueue->DrawRange( renderParams, first, end, mSubmitIndex, &mpQueue->mRangeStats[taskIndex] );
+    }
+};
+
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::SetThreadPool( CPUTThreadPool *pThreadPool, uint32_t threadCount )
+{
+    mpThreadPool = pThreadPool;
+    if( !pThreadPool )
+    {
+        mThreadCount = 1;
+    }
+    else
+    {
+        mThreadCount = (threadCount && threadCount < pThreadPool->GetThreadCount()) ? threadCount : pThreadPool->GetThreadCount();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::ReleaseResources()
+{
+    ReleaseDeferredBackends();
+    if( mInstanceBuffer )
+    {
+        mpInstanceBackend->ReleaseBuffer( mInstanceBuffer );
+        mInstanceBuffer = 0;
+    }
+    mpInstanceBackend = 0;
+    mInstanceCapacity = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::ReleaseDeferredBackends()
+{
+    for( size_t ii=0; ii<mDeferred.size(); ii++ )
+    {
+        delete mDeferred[ii];
+    }
+    mDeferred.clear();
+    mpDeferredParent = 0;
+}
+
+// Returns false if pImmediate can't record
+//-----------------------------------------------------------------------------
+bool CPUTRenderQueue::CreateDeferredBackends( CPUTRenderBackend *pImmediate, uint32_t count )
+{
+    if( pImmediate != mpDeferredParent )
+    {
+        ReleaseDeferredBackends();
+        mpDeferredParent = pImmediate;
+    }
+    while( mDeferred.size() < count )
+    {
+        CPUTRenderBackend *pDeferred = pImmediate->CreateDeferred();
+        if( !pDeferred )
+        {
+            return false;
+        }
+        pDeferred->SetStateFiltering( pImmediate->GetStateFiltering() );
+        mDeferred.push_back( pDeferred );
+    }
+    return true;
+}
+
+// Groups the sorted packets into draws: runs of packets sharing an instanced material,
+// a mesh and a pass become one instanced draw, anything else is drawn alone.  Then
+// writes the instance data of all instanced draws with a single Map().
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::BuildDraws( CPUTRenderParameters &renderParams )
+{
+    CPUT_PROFILE_ZONE("Build draws");
+    mDraws.clear();
+    uint32_t count         = (uint32_t)mItems.size();
+    uint32_t instanceCount = 0;
+    for( uint32_t ii=0; ii<count; )
+    {
+        const CPUTDrawPacket &packet = mPackets[mItems[ii].mPacket];
+        uint64_t  pass   = mItems[ii].mKey >> CPUT_SORT_PASS_SHIFT;
+        CPUTMesh *pMesh  = packet.mpModel->GetMesh( packet.mMeshIndex );
+        uint32_t  end    = ii + 1;
+        if( packet.mpMaterial->SupportsInstancing() && pMesh->SupportsInstancing( CPUT_RENDER_PASS_SHADOW == pass ) )
+        {
+            while( end < count )
+            {
+                const CPUTDrawPacket &next = mPackets[mItems[end].mPacket];
+                if( next.mpMaterial != packet.mpMaterial || (mItems[end].mKey >> CPUT_SORT_PASS_SHIFT) != pass ||
+                    next.mpModel->GetMesh( next.mMeshIndex ) != pMesh )
+                {
+                    break;
+                }
+                end++;
+            }
+        }
+        Draw draw;
+        draw.mFirst         = ii;
+        draw.mCount         = end - ii;
+        draw.mFirstInstance = CPUT_NOT_INSTANCED;
+        if( draw.mCount > 1 )
+        {
+            draw.mFirstInstance = instanceCount;
+            instanceCount += draw.mCount;
+        }
+        mDraws.push_back( draw );
+        ii = end;
+    }
+    if( !instanceCount )
+    {
+        return;
+    }
+
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
+    if( instanceCount > mInstanceCapacity || pBackend != mpInstanceBackend )
+    {
+        if( mInstanceBuffer )
+        {
+            mpInstanceBackend->ReleaseBuffer( mInstanceBuffer );
+        }
+        mInstanceCapacity = instanceCount + instanceCount/2;
+        mInstanceBuffer   = pBackend->CreateBuffer( mInstanceCapacity * sizeof(CPUTInstanceData), CPUT_BIND_VERTEX_BUFFER, true, 0 );
+        mpInstanceBackend = pBackend;
+    }
+    CPUTInstanceData *pInstances = (CPUTInstanceData*)pBackend->Map( mInstanceBuffer );
+    for( size_t dd=0; dd<mDraws.size(); dd++ )
+    {
+        const Draw &draw = mDraws[dd];
+        for( uint32_t ii=0; CPUT_NOT_INSTANCED != draw.mFirstInstance && ii<draw.mCount; ii++ )
+        {
+            mPackets[mItems[draw.mFirst + ii].mPacket].mpModel->FillInstanceData( &pInstances[draw.mFirstInstance + ii] );
+        }
+    }
+    pBackend->Unmap( mInstanceBuffer, instanceCount * sizeof(CPUTInstanceData) );
+}
+
+// Writes the constants of every model that starts a draw into the upload ring.  Returns
+// false if the ring filled up.
+//-----------------------------------------------------------------------------
+bool CPUTRenderQueue::UploadConstants( CPUTRenderParameters &renderParams, uint32_t submitIndex )
+{
+    CPUTModel *pLastModel = NULL;
+    bool       uploaded   = true;
+    for( uint32_t dd=0; dd<mDraws.size() && uploaded; dd++ )
+    {
+        CPUTModel *pModel = mPackets[mItems[mDraws[dd].mFirst].mPacket].mpModel;
+        if( pModel != pLastModel )
+        {
+            uploaded   = pModel->UploadQueuedConstants( renderParams, submitIndex );
+            pLastModel = pModel;
+            mStats.mRingUploads++;
+        }
+    }
+    renderParams.mpUploadRing->Flush();
+    if( !uploaded )
+    {
+        mStats.mRingOverflows++;
+    }
+    return uploaded;
+}
+
+// Without the ring, uploads the constant buffer of every model that starts a draw
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::UpdateConstants( CPUTRenderParameters &renderParams, uint32_t submitIndex )
+{
+    CPUT_PROFILE_ZONE("Update model constants");
+    CPUTModel *pLastModel = NULL;
+    for( uint32_t dd=0; dd<mDraws.size(); dd++ )
+    {
+        CPUTModel *pModel = mPackets[mItems[mDraws[dd].mFirst].mPacket].mpModel;
+        if( pModel != pLastModel )
+        {
+            pModel->UpdateQueuedConstants( renderParams, submitIndex );
+            pLastModel = pModel;
+        }
+    }
+}
+
+// An instanced draw takes everything but the per-instance data from its first model
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::DrawRange( CPUTRenderParameters &renderParams, uint32_t first, uint32_t end, uint32_t submitIndex, CPUTRenderQueueStats *pStats )
+{
+    CPUT_PROFILE_ZONE("Draw range");
+    CPUTMaterial *pLastMaterial = NULL;
+    CPUTModel    *pLastModel    = NULL;
+    bool          instancing    = false;
+    for( uint32_t dd=first; dd<end; dd++ )
+    {
+        const Draw           &draw      = mDraws[dd];
+        const CPUTDrawPacket &packet    = mPackets[mItems[draw.mFirst].mPacket];
+        bool                  instanced = CPUT_NOT_INSTANCED != draw.mFirstInstance;
+        if( packet.mpMaterial != pLastMaterial )
+        {
+            packet.mpMaterial->SetRenderStates( renderParams );
+            pLastMaterial = packet.mpMaterial;
+            pLastModel    = NULL; // The material's constant buffer bindings overwrite the model's
+            instancing    = false;
+            pStats->mMaterialChanges++;
+        }
+        if( instanced != instancing )
+        {
+            packet.mpMaterial->SetInstancing( renderParams, instanced );
+            instancing = instanced;
+        }
+        if( packet.mpModel != pLastModel )
+        {
+            packet.mpModel->SetQueuedRenderStates( renderParams, submitIndex );
+            pLastModel = packet.mpModel;
+            pStats->mModelChanges++;
+        }
+
+        CPUTMesh *pMesh  = packet.mpModel->GetMesh( packet.mMeshIndex );
+        bool      shadow = CPUT_RENDER_PASS_SHADOW == (mItems[draw.mFirst].mKey >> CPUT_SORT_PASS_SHIFT);
+        if( instanced )
+        {
+            renderParams.mpBackend->SetVertexBuffer( CPUT_INSTANCE_DATA_SLOT, mInstanceBuffer, sizeof(CPUTInstanceData), 0 );
+            if( shadow )
+            {
+                pMesh->DrawShadowInstanced( renderParams, packet.mpModel, draw.mCount, draw.mFirstInstance );
+            }
+            else
+            {
+                pMesh->DrawInstanced( renderParams, packet.mpModel, draw.mCount, draw.mFirstInstance );
+            }
+            pStats->mInstancedDraws++;
+            pStats->mInstances += draw.mCount;
+        }
+        else if( shadow )
+        {
+            pMesh->DrawShadow( renderParams, packet.mpModel );
+        }
+        else
+        {
+            pMesh->Draw( renderParams, packet.mpModel );
+        }
+        pStats->mPackets += draw.mCount;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderQueue::Submit( CPUTRenderParameters &renderParams )
+{
+    CPUT_PROFILE_ZONE("Submit render queue");
+    Sort();
+    if( renderParams.mpLateLatch )
+    {
+        // Nothing written so far depends on the models' transforms
+        renderParams.mpLateLatch->Latch( renderParams );
+    }
+    // Latching can move nodes.  Bring the world matrices up to date here, on one thread;
+    // otherwise the first GetWorldMatrix() on each recording thread would run Update() at once.
+    CPUTTransformHierarchy::GetDefaultHierarchy()->Update();
+    BuildDraws( renderParams );
+
+    uint32_t count      = (uint32_t)mDraws.size();
+    CPUT_PROFILE_COUNTER("Queued draws", count);
+    uint32_t rangeCount = count / CPUT_RENDER_QUEUE_MIN_PACKETS_PER_THREAD;
+    if( rangeCount > mThreadCount )
+    {
+        rangeCount = mThreadCount;
+    }
+
+    // Models whose constants made it into the ring bind them by matching this submit index.
+    // If the ring fills up, the index is dropped and models upload their own constants instead.
+    bool ringUploaded = false;
+    if( renderParams.mpUploadRing && renderParams.mpUploadRing->IsEnabled() && count )
+    {
+        ringUploaded = UploadConstants( renderParams, ++mSubmitCount );
+    }
+
+    if( rangeCount < 2 || !CreateDeferredBackends( renderParams.mpBackend, rangeCount ) )
+    {
+        // Lets models upload their constants once per Submit(), however many of their packets are drawn
+        DrawRange( renderParams, 0, count, ringUploaded ? mSubmitCount : ++mSubmitCount, &mStats );
+        Clear();
+        return;
+    }
+
+    // Without the ring, the models' constant buffers are uploaded here, on the immediate backend,
+    // before any range records.  The command lists execute after these uploads, so every range
+    // just binds the buffers, and the recording threads never write a model's upload state
+    // (a model can be drawn by several ranges).
+    if( !ringUploaded )
+    {
+        UpdateConstants( renderParams, ++mSubmitCount );
+    }
+    CPUTRenderQueueRecordTask task;
+    task.mpQueue        = this;
+    task.mpRenderParams = &renderParams;
+    task.mCount         = count;
+    task.mRangeCount    = rangeCount;
+    task.mSubmitIndex   = mSubmitCount;
+    mRangeStats.assign( rangeCount, CPUTRenderQueueStats() );
+    mpThreadPool->ParallelFor( &task, rangeCount );
+
+    for( uint32_t ii=0; ii<rangeCount; ii++ )
+    {
+        renderParams.mpBackend->ExecuteDeferred( mDeferred[ii] );
+        mStats.mPackets         += mRangeStats[ii].mPackets;
+        mStats.mMaterialChanges += mRangeStats[ii].mMaterialChanges;
+        mStats.mModelChanges    += mRangeStats[ii].mModelChanges;
+        mStats.mInstancedDraws  += mRangeStats[ii].mInstancedDraws;
+        mStats.mInstances       += mRangeStats[ii].mInstances;
+    }
+    mStats.mRecordedRanges += rangeCount;
+
+    Clear();
+}
@@ -0,0 +1,197 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTRENDERQUEUE_H__
+#define __CPUTRENDERQUEUE_H__
+
+// Sort-keyed render queue.  Models queue one packet per mesh instead of drawing
+// immediately.  Submit() radix-sorts the packets by their 64-bit key and draws
+// them in that order, setting a material's states only when the material changes
+// and a model's constant buffer only when the model (or material) changes.
+//
+// Key layout, most significant bits first:
+//   63..61  pass      (CPUT_RENDER_PASS)
+//   60..49  shader    (vertex/pixel shader pair)
+//   48..41  state     (render state block)
+//   40..25  material
+//   24..0   depth     (camera distance, front to back)
+// The state block sits above the material because a material always uses the same block.
+// Ids wider than their field wrap around.  That only costs sort quality: submission
+// compares the actual material and model pointers.
+//
+// With a thread pool, Submit() splits the sorted packets into contiguous ranges, one per
+// thread.  Each range is recorded on its own deferred backend (a deferred context on DX11,
+// a recording on the null backend) that starts from the immediate backend's state.  The
+// recordings are then executed on the calling thread in order, so the result is the same
+// as a serial submit.
+//
+// With an upload ring (CPUTRenderParameters::mpUploadRing), Submit() first writes every
+// model's constants into the ring on the calling thread, so recording only binds ranges.
+//
+// No constants are written before Submit() has sorted the packets and called
+// CPUTRenderParameters::mpLateLatch, which may still move models and cameras.
+//
+// Instancing: for materials with an instanced vertex shader, the depth field holds the
+// mesh id above a coarser depth (see MakeInstancedDepth()), so the packets of models
+// sharing a mesh (e.g., instances loaded from an asset set) sort next to each other.
+// Submit() turns each such run into one instanced draw.  Every model in the run writes
+// a CPUTInstanceData into a per-queue instance buffer, bound to vertex buffer slot 1.
+#include "CPUTRenderParams.h"
+#include "CPUTRenderBackend.h"
+#include <stdint.h>
+#include <vector>
+
+class CPUTModel;
+class CPUTMaterial;
+class CPUTThreadPool;
+
+// Below this many draws per thread, Submit() records fewer ranges (or draws serially)
+const uint32_t CPUT_RENDER_QUEUE_MIN_PACKETS_PER_THREAD = 256;
+
+// Instanced vertex shaders read these from vertex buffer slot 1 (semantic INSTANCE0..11)
+const uint32_t CPUT_INSTANCE_DATA_SLOT = 1;
+
+const uint32_t CPUT_SORT_SHADER_BITS   = 12;
+const uint32_t CPUT_SORT_STATE_BITS    = 8;
+const uint32_t CPUT_SORT_MATERIAL_BITS = 16;
+const uint32_t CPUT_SORT_DEPTH_BITS    = 25;
+
+// Key fields that are assigned ids (see CPUTRenderQueue::GetSortId())
+enum CPUT_SORT_FIELD
+{
+    CPUT_SORT_FIELD_SHADER = 0,
+    CPUT_SORT_FIELD_STATE,
+    CPUT_SORT_FIELD_MATERIAL,
+    CPUT_SORT_FIELD_MESH,     // Instanced materials only (see MakeInstancedDepth())
+    CPUT_SORT_FIELD_COUNT
+};
+
+// Mesh id bits at the top of the depth field for instanced materials
+const uint32_t CPUT_SORT_INSTANCED_MESH_BITS = 13;
+
+// Per-instance data.  Row-major, the same layout as the matrices in the model constant buffer.
+//-----------------------------------------------------------------------------
+struct CPUTInstanceData
+{
+    float mWorld[16];
+    float mWorldViewProjection[16];
+    float mLightWorldViewProjection[16];
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTDrawPacket
+{
+    CPUTModel    *mpModel;
+    CPUTMaterial *mpMaterial;
+    uint32_t      mMeshIndex;
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTRenderQueueStats
+{
+    uint32_t mPackets;         // Packets submitted
+    uint32_t mMaterialChanges; // CPUTMaterial::SetRenderStates() calls
+    uint32_t mModelChanges;    // CPUTModel::SetQueuedRenderStates() calls
+    uint32_t mRecordedRanges;  // Ranges recorded on deferred backends (0 for serial submits)
+    uint32_t mRingUploads;     // CPUTModel::UploadQueuedConstants() calls
+    uint32_t mRingOverflows;   // Submit()s that ran out of upload ring space (and fell back to per-model uploads)
+    uint32_t mInstancedDraws;  // Draws that covered more than one packet
+    uint32_t mInstances;       // Packets drawn by those
+
+    CPUTRenderQueueStats() { Reset(); }
+    void Reset() { mPackets = mMaterialChanges = mModelChanges = mRecordedRanges = mRingUploads = mRingOverflows = mInstancedDraws = mInstances = 0; }
+};
+
+//-----------------------------------------------------------------------------
+class CPUTRenderQueue
+{
+protected:
+    struct SortItem
+    {
+        uint64_t mKey;
+        uint32_t mPacket;
+    };
+
+    // A run of sorted packets drawn with one call.  mFirstInstance is ~0 for a single, non-instanced packet.
+    struct Draw
+    {
+        uint32_t mFirst;
+        uint32_t mCount;
+        uint32_t mFirstInstance;
+    };
+
+    static uint32_t             mSubmitCount;
+
+    std::vector<CPUTDrawPacket> mPackets;
+    std::vector<SortItem>       mItems;
+    std::vector<SortItem>       mScratch;
+    std::vector<Draw>           mDraws;
+    CPUTRenderQueueStats        mStats;
+
+    CPUTRenderBackend          *mpInstanceBackend; // Backend mInstanceBuffer was created on
+    CPUTBackendHandle           mInstanceBuffer;
+    uint32_t                    mInstanceCapacity;
+
+    CPUTThreadPool                    *mpThreadPool;
+    uint32_t                           mThreadCount;
+    CPUTRenderBackend                 *mpDeferredParent; // Backend mDeferred were created from
+    std::vector<CPUTRenderBackend*>    mDeferred;
+    std::vector<CPUTRenderQueueStats>  mRangeStats;
+
+    friend class CPUTRenderQueueRecordTask;
+
+    void Sort();
+    void BuildDraws( CPUTRenderParameters &renderParams );
+    bool UploadConstants( CPUTRenderParameters &renderParams, uint32_t submitIndex );
+    void UpdateConstants( CPUTRenderParameters &renderParams, uint32_t submitIndex );
+    bool CreateDeferredBackends( CPUTRenderBackend *pImmediate, uint32_t count );
+
+    // Draws mDraws [first, end)
+    void DrawRange( CPUTRenderParameters &renderParams, uint32_t first, uint32_t end, uint32_t submitIndex, CPUTRenderQueueStats *pStats );
+
+public:
+    CPUTRenderQueue() : mpInstanceBackend(0), mInstanceBuffer(0), mInstanceCapacity(0), mpThreadPool(0), mThreadCount(1), mpDeferredParent(0) {}
+    ~CPUTRenderQueue() { ReleaseResources(); }
+
+    static uint64_t MakeKey( CPUT_RENDER_PASS pass, uint32_t shaderId, uint32_t stateId, uint32_t materialId, uint32_t depth );
+    static uint32_t QuantizeDepth( float distance );
+    static uint32_t MakeInstancedDepth( uint32_t meshId, uint32_t depth );
+
+    // Returns a small id for an object (or pair of objects), used to build sort keys.
+    // Each field hands out its own ids in first-come order.  Not thread safe.  Call at load time.
+    static uint32_t GetSortId( CPUT_SORT_FIELD field, const void *pObject0, const void *pObject1=0 );
+
+    void     AddPacket( uint64_t key, CPUTModel *pModel, CPUTMaterial *pMaterial, uint32_t meshIndex );
+    uint32_t GetPacketCount() const { return (uint32_t)mPackets.size(); }
+    void     Clear() { mPackets.clear(); mItems.clear(); mDraws.clear(); }
+
+    // Sorts and draws everything queued since the last Submit(), then clears the queue.
+    void     Submit( CPUTRenderParameters &renderParams );
+
+    // Record Submit()s on up to threadCount threads (0 means all of the pool's).  A NULL pool,
+    // or a thread count of 1, submits serially on the calling thread.
+    void     SetThreadPool( CPUTThreadPool *pThreadPool, uint32_t threadCount = 0 );
+    uint32_t GetThreadCount() const { return mThreadCount; }
+    void     ReleaseDeferredBackends();
+
+    // Releases the deferred backends and the instance buffer.  Call before the backend is destroyed.
+    void     ReleaseResources();
+
+    // Counters accumulate over Submit() calls until ResetStats()
+    const CPUTRenderQueueStats &GetStats() const { return mStats; }
+    void                        ResetStats()     { mStats.Reset(); }
+};
+
+#endif // __CPUTRENDERQUEUE_H__
@@ -233,12 +233,12 @@ void CPUTRenderStateBlockDX11::CreateNativeResources()
 //-----------------------------------------------------------------------------
 void CPUTRenderStateBlockDX11::SetRenderStates( CPUTRenderParameters &renderParams )
 {
-    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
-
-    pContext->OMSetBlendState( mpBlendState, mStateDesc.BlendFactor, mStateDesc.SampleMask );
-    pContext->OMSetDepthStencilState( mpDepthStencilState, 0 ); // TODO: read stecil ref from config file
-    pContext->RSSetState( mpRasterizerState );
-    pContext->PSSetSamplers( 0, mNumSamplers, mpSamplerState );
-    pContext->VSSetSamplers( 0, mNumSamplers, mpSamplerState );
-    pContext->GSSetSamplers( 0, mNumSamplers, mpSamplerState );
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
+
+    pBackend->SetBlendState( mpBlendState, mStateDesc.BlendFactor, mStateDesc.SampleMask );
+    pBackend->SetDepthStencilState( mpDepthStencilState, 0 ); // TODO: read stecil ref from config file
+    pBackend->SetRasterizerState( mpRasterizerState );
+    pBackend->SetSamplers( CPUT_SHADER_STAGE_PIXEL,    0, mNumSamplers, (CPUTBackendHandle*)mpSamplerState );
+    pBackend->SetSamplers( CPUT_SHADER_STAGE_VERTEX,   0, mNumSamplers, (CPUTBackendHandle*)mpSamplerState );
+    pBackend->SetSamplers( CPUT_SHADER_STAGE_GEOMETRY, 0, mNumSamplers, (CPUTBackendHandle*)mpSamplerState );
 } // CPUTRenderStateBlockDX11::SetRenderState()
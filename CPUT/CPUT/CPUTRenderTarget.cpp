@@ -320,36 +320,36 @@ void CPUTRenderTargetColor::SetRenderTarget(
     CPUTRenderTargetDepth::SetActiveWidthHeight( mWidth, mHeight );
 
     // TODO: support multiple render target views (i.e., MRT)
-    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
     // Make sure this render target isn't currently bound as a texture.
-    static ID3D11ShaderResourceView *pSRV[16] = {0};
-    pContext->PSSetShaderResources( 0, 16, pSRV );
+    static CPUTBackendHandle pSRV[16] = {0};
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 16, pSRV );
 
     // Clear the shader resources to avoid a hazard warning
-    ID3D11ShaderResourceView *pNullResources[16] = {0};
-    pContext->PSSetShaderResources(0, 16, pNullResources );
-    pContext->VSSetShaderResources(0, 16, pNullResources );
+    CPUTBackendHandle pNullResources[16] = {0};
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL,  0, 16, pNullResources );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_VERTEX, 0, 16, pNullResources );
 
     // ****************************
     // Set the new render target states
     // ****************************
     ID3D11DepthStencilView *pDepthStencilView = pDepthBuffer ? pDepthBuffer->GetDepthBufferView() : NULL;
-    pContext->OMSetRenderTargets( 1, &mpColorRenderTargetView, pDepthStencilView );
+    pBackend->SetRenderTargets( 1, (CPUTBackendHandle*)&mpColorRenderTargetView, pDepthStencilView );
 
     CPUTRenderTargetColor::SetActiveRenderTargetView(mpColorRenderTargetView);
     CPUTRenderTargetDepth::SetActiveDepthStencilView(pDepthStencilView);
 
     if( clear )
     {
-        pContext->ClearRenderTargetView( mpColorRenderTargetView, pClearColor );
+        pBackend->ClearRenderTarget( mpColorRenderTargetView, pClearColor );
         if( pDepthStencilView )
         {
-            pContext->ClearDepthStencilView( pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, zClearVal, 0 );
+            pBackend->ClearDepthStencil( pDepthStencilView, CPUT_CLEAR_DEPTH | CPUT_CLEAR_STENCIL, zClearVal, 0 );
         }
     }
-    D3D11_VIEWPORT viewport  = { 0.0f, 0.0f, (float)mWidth, (float)mHeight, 0.0f, 1.0f };
-    ((CPUTRenderParametersDX*)&renderParams)->mpContext->RSSetViewports( 1, &viewport );
+    CPUTBackendViewport viewport  = { 0.0f, 0.0f, (float)mWidth, (float)mHeight, 0.0f, 1.0f };
+    pBackend->SetViewport( viewport );
 
     mRenderTargetSet = true;
 } // CPUTRenderTargetColor::SetRenderTarget()
@@ -372,36 +372,36 @@ void CPUTRenderTargetDepth::SetRenderTarget(
     CPUTRenderTargetDepth::SetActiveWidthHeight( mWidth, mHeight );
 
     // TODO: support multiple render target views (i.e., MRT)
-    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
     // Make sure this render target isn't currently bound as a texture.
-    static ID3D11ShaderResourceView *pSRV[16] = {0};
-    pContext->PSSetShaderResources( 0, 16, pSRV );
+    static CPUTBackendHandle pSRV[16] = {0};
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 16, pSRV );
 
     // Save the color and depth views so we can restore them later.
     mpSavedColorRenderTargetView = CPUTRenderTargetColor::GetActiveRenderTargetView();
     mpSavedDepthStencilView      = CPUTRenderTargetDepth::GetActiveDepthStencilView();
 
     // Clear the shader resources to avoid a hazard warning
-    ID3D11ShaderResourceView *pNullResources[16] = {0};
-    pContext->PSSetShaderResources(0, 16, pNullResources );
-    pContext->VSSetShaderResources(0, 16, pNullResources );
+    CPUTBackendHandle pNullResources[16] = {0};
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL,  0, 16, pNullResources );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_VERTEX, 0, 16, pNullResources );
 
     // ****************************
     // Set the new render target states
     // ****************************
-    ID3D11RenderTargetView *pView[1] = {NULL};
-    pContext->OMSetRenderTargets( 1, pView, mpDepthStencilView );
+    CPUTBackendHandle pView[1] = {NULL};
+    pBackend->SetRenderTargets( 1, pView, mpDepthStencilView );
 
     CPUTRenderTargetColor::SetActiveRenderTargetView( NULL );
     CPUTRenderTargetDepth::SetActiveDepthStencilView( mpDepthStencilView );
 
     if( clear )
     {
-        pContext->ClearDepthStencilView( mpDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, zClearVal, 0 );
+        pBackend->ClearDepthStencil( mpDepthStencilView, CPUT_CLEAR_DEPTH | CPUT_CLEAR_STENCIL, zClearVal, 0 );
     }
-    D3D11_VIEWPORT viewport  = { 0.0f, 0.0f, (float)mWidth, (float)mHeight, 0.0f, 1.0f };
-    ((CPUTRenderParametersDX*)&renderParams)->mpContext->RSSetViewports( 1, &viewport );
+    CPUTBackendViewport viewport  = { 0.0f, 0.0f, (float)mWidth, (float)mHeight, 0.0f, 1.0f };
+    pBackend->SetViewport( viewport );
 
     mRenderTargetSet = true;
 } // CPUTRenderTargetDepth::SetRenderTarget()
@@ -423,9 +423,9 @@ void CPUTRenderTargetColor::RestoreRenderTarget( CPUTRenderParameters &renderPar
         Resolve( renderParams );
     }
 
-    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
-    pContext->OMSetRenderTargets( 1, &mpSavedColorRenderTargetView, mpSavedDepthStencilView );
+    pBackend->SetRenderTargets( 1, (CPUTBackendHandle*)&mpSavedColorRenderTargetView, mpSavedDepthStencilView );
 
     CPUTRenderTargetColor::SetActiveWidthHeight( mSavedWidth, mSavedHeight );
     CPUTRenderTargetDepth::SetActiveWidthHeight( mSavedWidth, mSavedHeight );
@@ -433,8 +433,8 @@ void CPUTRenderTargetColor::RestoreRenderTarget( CPUTRenderParameters &renderPar
     CPUTRenderTargetDepth::SetActiveDepthStencilView( mpSavedDepthStencilView );
 
     // TODO: save/restore original VIEWPORT settings, not assume full-screen viewport.
-    D3D11_VIEWPORT viewport  = { 0.0f, 0.0f, (float)mSavedWidth, (float)mSavedHeight, 0.0f, 1.0f };
-    ((CPUTRenderParametersDX*)&renderParams)->mpContext->RSSetViewports( 1, &viewport );
+    CPUTBackendViewport viewport  = { 0.0f, 0.0f, (float)mSavedWidth, (float)mSavedHeight, 0.0f, 1.0f };
+    pBackend->SetViewport( viewport );
 
     mRenderTargetSet = false;
 } // CPUTRenderTarget::RestoreRenderTarget()
@@ -445,9 +445,9 @@ void CPUTRenderTargetDepth::RestoreRenderTarget( CPUTRenderParameters &renderPar
 {
     ASSERT( mRenderTargetSet, _L("Render target restored without calling SetRenderTarget()"));
 
-    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+    CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
-    pContext->OMSetRenderTargets( 1, &mpSavedColorRenderTargetView, mpSavedDepthStencilView );
+    pBackend->SetRenderTargets( 1, (CPUTBackendHandle*)&mpSavedColorRenderTargetView, mpSavedDepthStencilView );
 
     CPUTRenderTargetColor::SetActiveWidthHeight( mSavedWidth, mSavedHeight );
     CPUTRenderTargetDepth::SetActiveWidthHeight( mSavedWidth, mSavedHeight );
@@ -455,8 +455,8 @@ void CPUTRenderTargetDepth::RestoreRenderTarget( CPUTRenderParameters &renderPar
     CPUTRenderTargetDepth::SetActiveDepthStencilView( mpSavedDepthStencilView );
 
     // TODO: save/restore original VIEWPORT settings, not assume full-screen viewport.
-    D3D11_VIEWPORT viewport  = { 0.0f, 0.0f, (float)mSavedWidth, (float)mSavedHeight, 0.0f, 1.0f };
-    ((CPUTRenderParametersDX*)&renderParams)->mpContext->RSSetViewports( 1, &viewport );
+    CPUTBackendViewport viewport  = { 0.0f, 0.0f, (float)mSavedWidth, (float)mSavedHeight, 0.0f, 1.0f };
+    pBackend->SetViewport( viewport );
 
     mRenderTargetSet = false;
 } // CPUTRenderTarget::RestoreRenderTarget()
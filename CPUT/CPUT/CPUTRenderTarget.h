@@ -219,6 +219,7 @@ public:
     void RestoreRenderTarget( CPUTRenderParameters &renderParams );
 
     ID3D11DepthStencilView   *GetDepthBufferView()   { return mpDepthStencilView; }
+    CPUTTexture              *GetDepthTexture()      { return mpDepthTexture; }
     ID3D11ShaderResourceView *GetDepthResourceView() { return mpDepthResourceView; }
     UINT                      GetWidth()             { return mWidth; }
     UINT                      GetHeight()            { return mHeight; }
@@ -0,0 +1,171 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTShaderCache.h"
+#include "CPUTHash.h"
+#include <stdio.h>
+#include <string.h>
+
+const uint32_t CPUT_SHADER_CACHE_MAGIC   = 0x43535043; // "CPSC"
+const uint32_t CPUT_SHADER_CACHE_VERSION = 1;
+
+//-----------------------------------------------------------------------------
+struct CPUTShaderCacheHeader
+{
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint64_t mKey;
+    uint32_t mBytecodeSize;
+    uint32_t mChecksum;     // Low half of the FNV-1a hash of the bytecode
+};
+
+//-----------------------------------------------------------------------------
+void CPUTShaderCache::SetDirectory( const std::string &directory )
+{
+    mDirectory = directory;
+    if( !mDirectory.empty() && '/' != mDirectory[mDirectory.size()-1] && '\\' != mDirectory[mDirectory.size()-1] )
+    {
+        mDirectory += '/';
+    }
+}
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTShaderCache::MakeKey( const std::string &preprocessed, const CPUTShaderMacro *pMacros, const char *pEntryPoint, const char *pProfile ) const
+{
+    uint64_t hash = CPUTHashBytes( preprocessed.data(), preprocessed.size() );
+    hash = CPUTHashString( pEntryPoint, hash );
+    hash = CPUTHashString( pProfile, hash );
+    for( const CPUTShaderMacro *pMacro = pMacros; pMacro && pMacro->mpName; pMacro++ )
+    {
+        hash = CPUTHashString( pMacro->mpName, hash );
+        hash = CPUTHashString( pMacro->mpDefinition, hash );
+    }
+    return CPUTHashString( mpCompiler->GetVersion(), hash );
+}
+
+//-----------------------------------------------------------------------------
+std::string CPUTShaderCache::GetPath( uint64_t key ) const
+{
+    char name[32];
+    sprintf( name, "%08x%08x.cso", (uint32_t)(key >> 32), (uint32_t)key );
+    return mDirectory + name;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTShaderCache::GetBytecode(
+    const char            *pSource,
+    uint32_t               sourceSize,
+    const char            *pSourceName,
+    const CPUTShaderMacro *pMacros,
+    const char            *pEntryPoint,
+    const char            *pProfile,
+    std::vector<uint8_t>  *pBytecode,
+    std::string           *pErrors
+)
+{
+    mStats.mLookups++;
+    if( mDirectory.empty() )
+    {
+        mStats.mCompiles++;
+        return mpCompiler->Compile( pSource, sourceSize, pSourceName, pMacros, pEntryPoint, pProfile, pBytecode, pErrors );
+    }
+
+    // Preprocessing is a small fraction of a compile, and is the only way to see every include
+    std::string preprocessed;
+    if( !mpCompiler->Preprocess( pSource, sourceSize, pSourceName, pMacros, &preprocessed, pErrors ) )
+    {
+        return false;
+    }
+    uint64_t key = MakeKey( preprocessed, pMacros, pEntryPoint, pProfile );
+    if( Load( key, pBytecode ) )
+    {
+        mStats.mHits++;
+        return true;
+    }
+
+    mStats.mCompiles++;
+    if( !mpCompiler->Compile( pSource, sourceSize, pSourceName, pMacros, pEntryPoint, pProfile, pBytecode, pErrors ) )
+    {
+        return false;
+    }
+    Store( key, *pBytecode );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTShaderCache::Load( uint64_t key, std::vector<uint8_t> *pBytecode )
+{
+    FILE *pFile = fopen( GetPath(key).c_str(), "rb" );
+    if( !pFile )
+    {
+        return false;
+    }
+    CPUTShaderCacheHeader header;
+    bool valid = 1 == fread( &header, sizeof(header), 1, pFile ) &&
+                 CPUT_SHADER_CACHE_MAGIC   == header.mMagic &&
+                 CPUT_SHADER_CACHE_VERSION == header.mVersion &&
+                 key == header.mKey &&
+                 0 != header.mBytecodeSize;
+    if( valid )
+    {
+        pBytecode->resize( header.mBytecodeSize );
+        valid = header.mBytecodeSize == fread( &(*pBytecode)[0], 1, header.mBytecodeSize, pFile ) &&
+                header.mChecksum == (uint32_t)CPUTHashBytes( &(*pBytecode)[0], header.mBytecodeSize );
+    }
+    fclose( pFile );
+    if( !valid )
+    {
+        mStats.mRejectedFiles++;
+        pBytecode->clear();
+        return false;
+    }
+    mStats.mBytesRead += sizeof(header) + header.mBytecodeSize;
+    return true;
+}
+
+// Writes to a temporary file first, so a crash (or a second instance) never leaves a
+// truncated file under the real name
+//-----------------------------------------------------------------------------
+void CPUTShaderCache::Store( uint64_t key, const std::vector<uint8_t> &bytecode )
+{
+    if( bytecode.empty() )
+    {
+        return;
+    }
+    CPUTShaderCacheHeader header;
+    header.mMagic        = CPUT_SHADER_CACHE_MAGIC;
+    header.mVersion      = CPUT_SHADER_CACHE_VERSION;
+    header.mKey          = key;
+    header.mBytecodeSize = (uint32_t)bytecode.size();
+    header.mChecksum     = (uint32_t)CPUTHashBytes( &bytecode[0], bytecode.size() );
+
+    std::string path     = GetPath( key );
+    std::string tempPath = path + ".tmp";
+    FILE *pFile = fopen( tempPath.c_str(), "wb" );
+    bool written = pFile &&
+                   1 == fwrite( &header, sizeof(header), 1, pFile ) &&
+                   bytecode.size() == fwrite( &bytecode[0], 1, bytecode.size(), pFile );
+    if( pFile )
+    {
+        written = (0 == fclose( pFile )) && written;
+    }
+    // rename() won't replace an existing file on Windows
+    remove( path.c_str() );
+    if( !written || 0 != rename( tempPath.c_str(), path.c_str() ) )
+    {
+        remove( tempPath.c_str() );
+        mStats.mWriteFailures++;
+    }
+}
@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTSHADERCACHE_H__
+#define __CPUTSHADERCACHE_H__
+
+// On-disk cache of compiled shader bytecode.  The key is a 64-bit hash of the
+// preprocessed source (so every included file and macro is covered), the entry point,
+// the profile, the macros and the compiler's version string.  Editing a shader or
+// anything it includes changes the key, so stale files are never read; they are simply
+// left behind.  Files are validated on load (magic, format, key, size, checksum) and
+// recompiled if anything doesn't match.
+//
+// Compiling and preprocessing go through CPUTShaderCompiler, so the cache itself has no
+// API dependencies.  Not thread safe.
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Same layout as D3D10_SHADER_MACRO.  Arrays end with a { NULL, NULL } entry.
+struct CPUTShaderMacro
+{
+    const char *mpName;
+    const char *mpDefinition;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTShaderCompiler
+{
+public:
+    virtual ~CPUTShaderCompiler() {}
+
+    // Identifies the compiler and its flags.  Part of every key.
+    virtual const char *GetVersion() const = 0;
+
+    // Expands includes (relative to pSourceName) and macros.
+    virtual bool Preprocess( const char *pSource, uint32_t sourceSize, const char *pSourceName, const CPUTShaderMacro *pMacros,
+                             std::string *pOutput, std::string *pErrors ) = 0;
+
+    virtual bool Compile( const char *pSource, uint32_t sourceSize, const char *pSourceName, const CPUTShaderMacro *pMacros,
+                          const char *pEntryPoint, const char *pProfile, std::vector<uint8_t> *pBytecode, std::string *pErrors ) = 0;
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTShaderCacheStats
+{
+    uint32_t mLookups;
+    uint32_t mHits;           // Loaded from disk
+    uint32_t mCompiles;
+    uint32_t mRejectedFiles;  // Present but truncated, corrupt or for another key
+    uint32_t mWriteFailures;
+    uint64_t mBytesRead;
+
+    CPUTShaderCacheStats() { Reset(); }
+    void Reset() { mLookups = mHits = mCompiles = mRejectedFiles = mWriteFailures = 0; mBytesRead = 0; }
+};
+
+//-----------------------------------------------------------------------------
+class CPUTShaderCache
+{
+protected:
+    CPUTShaderCompiler   *mpCompiler;
+    std::string           mDirectory;  // Ends with a separator.  Empty disables the disk cache.
+    CPUTShaderCacheStats  mStats;
+
+    bool Load(  uint64_t key, std::vector<uint8_t> *pBytecode );
+    void Store( uint64_t key, const std::vector<uint8_t> &bytecode );
+
+public:
+    CPUTShaderCache() : mpCompiler(0) {}
+
+    // Doesn't take ownership
+    void                SetCompiler( CPUTShaderCompiler *pCompiler ) { mpCompiler = pCompiler; }
+    CPUTShaderCompiler *GetCompiler() const { return mpCompiler; }
+
+    // The directory must exist.  Pass "" to always compile.
+    void               SetDirectory( const std::string &directory );
+    const std::string &GetDirectory() const { return mDirectory; }
+
+    // Returns false (with the compiler's messages in pErrors) if the shader doesn't compile
+    bool GetBytecode( const char *pSource, uint32_t sourceSize, const char *pSourceName, const CPUTShaderMacro *pMacros,
+                      const char *pEntryPoint, const char *pProfile, std::vector<uint8_t> *pBytecode, std::string *pErrors );
+
+    uint64_t    MakeKey( const std::string &preprocessed, const CPUTShaderMacro *pMacros, const char *pEntryPoint, const char *pProfile ) const;
+    std::string GetPath( uint64_t key ) const;
+
+    const CPUTShaderCacheStats &GetStats() const { return mStats; }
+    void                        ResetStats()     { mStats.Reset(); }
+};
+
+#endif // __CPUTSHADERCACHE_H__
@@ -0,0 +1,129 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTShaderCompilerDX11.h"
+#include <D3DCompiler.h>
+#include <stdio.h>
+
+// Opens includes relative to the directory of the top-level source file
+//-----------------------------------------------------------------------------
+class CPUTShaderIncludeDX11 : public ID3DInclude
+{
+protected:
+    std::string mDirectory;
+
+public:
+    CPUTShaderIncludeDX11( const char *pSourceName )
+    {
+        const char *pSlash = pSourceName ? strrchr( pSourceName, '\\' ) : NULL;
+        const char *pForwardSlash = pSourceName ? strrchr( pSourceName, '/' ) : NULL;
+        if( pForwardSlash > pSlash ) { pSlash = pForwardSlash; }
+        if( pSlash ) { mDirectory.assign( pSourceName, pSlash + 1 ); }
+    }
+
+    STDMETHOD(Open)( D3D_INCLUDE_TYPE includeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID *ppData, UINT *pBytes )
+    {
+        FILE *pFile = NULL;
+        if( fopen_s( &pFile, (mDirectory + pFileName).c_str(), "rb" ) )
+        {
+            return E_FAIL;
+        }
+        fseek( pFile, 0, SEEK_END );
+        long size = ftell( pFile );
+        fseek( pFile, 0, SEEK_SET );
+        char *pData = new char[size > 0 ? size : 1];
+        *pBytes = (UINT)fread( pData, 1, size, pFile );
+        *ppData = pData;
+        fclose( pFile );
+        return S_OK;
+    }
+
+    STDMETHOD(Close)( LPCVOID pData )
+    {
+        delete [] (char*)pData;
+        return S_OK;
+    }
+};
+
+//-----------------------------------------------------------------------------
+static void CopyErrors( ID3DBlob *pErrorBlob, std::string *pErrors )
+{
+    if( pErrorBlob )
+    {
+        if( pErrors ) { pErrors->assign( (const char*)pErrorBlob->GetBufferPointer(), pErrorBlob->GetBufferSize() ); }
+        pErrorBlob->Release();
+    }
+}
+
+//-----------------------------------------------------------------------------
+CPUTShaderCompilerDX11::CPUTShaderCompilerDX11( UINT flags ) :
+    mFlags(flags)
+{
+    char version[64];
+    sprintf_s( version, sizeof(version), "d3dcompiler_%d flags %x", D3D_COMPILER_VERSION, flags );
+    mVersion = version;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTShaderCompilerDX11::Preprocess(
+    const char            *pSource,
+    uint32_t               sourceSize,
+    const char            *pSourceName,
+    const CPUTShaderMacro *pMacros,
+    std::string           *pOutput,
+    std::string           *pErrors
+)
+{
+    CPUTShaderIncludeDX11 include( pSourceName );
+    ID3DBlob *pOutputBlob = NULL;
+    ID3DBlob *pErrorBlob  = NULL;
+    HRESULT hr = D3DPreprocess( pSource, sourceSize, pSourceName, (const D3D10_SHADER_MACRO*)pMacros, &include, &pOutputBlob, &pErrorBlob );
+    CopyErrors( pErrorBlob, pErrors );
+    if( FAILED(hr) )
+    {
+        return false;
+    }
+    pOutput->assign( (const char*)pOutputBlob->GetBufferPointer(), pOutputBlob->GetBufferSize() );
+    pOutputBlob->Release();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTShaderCompilerDX11::Compile(
+    const char            *pSource,
+    uint32_t               sourceSize,
+    const char            *pSourceName,
+    const CPUTShaderMacro *pMacros,
+    const char            *pEntryPoint,
+    const char            *pProfile,
+    std::vector<uint8_t>  *pBytecode,
+    std::string           *pErrors
+)
+{
+    CPUTShaderIncludeDX11 include( pSourceName );
+    ID3DBlob *pCodeBlob  = NULL;
+    ID3DBlob *pErrorBlob = NULL;
+    HRESULT hr = D3DCompile( pSource, sourceSize, pSourceName, (const D3D10_SHADER_MACRO*)pMacros, &include,
+                             pEntryPoint, pProfile, mFlags, 0, &pCodeBlob, &pErrorBlob );
+    CopyErrors( pErrorBlob, pErrors );
+    if( FAILED(hr) )
+    {
+        return false;
+    }
+    const uint8_t *pCode = (const uint8_t*)pCodeBlob->GetBufferPointer();
+    pBytecode->assign( pCode, pCode + pCodeBlob->GetBufferSize() );
+    pCodeBlob->Release();
+    return true;
+}
@@ -0,0 +1,41 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTSHADERCOMPILERDX11_H__
+#define __CPUTSHADERCOMPILERDX11_H__
+
+#include "CPUTShaderCache.h"
+#include <d3d11.h>
+
+// CPUTShaderCompiler on top of D3DPreprocess()/D3DCompile().  #include "file" resolves
+// relative to the directory of the source file.
+//-----------------------------------------------------------------------------
+class CPUTShaderCompilerDX11 : public CPUTShaderCompiler
+{
+protected:
+    UINT        mFlags;   // D3DCOMPILE_* flags.  Part of the version string.
+    std::string mVersion;
+
+public:
+    CPUTShaderCompilerDX11( UINT flags = 0 );
+
+    const char *GetVersion() const { return mVersion.c_str(); }
+    bool Preprocess( const char *pSource, uint32_t sourceSize, const char *pSourceName, const CPUTShaderMacro *pMacros,
+                     std::string *pOutput, std::string *pErrors );
+    bool Compile( const char *pSource, uint32_t sourceSize, const char *pSourceName, const CPUTShaderMacro *pMacros,
+                  const char *pEntryPoint, const char *pProfile, std::vector<uint8_t> *pBytecode, std::string *pErrors );
+};
+
+#endif // __CPUTSHADERCOMPILERDX11_H__
@@ -32,12 +32,12 @@ bool CPUTShaderDX11::ShaderRequiresPerModelPayload( CPUTConfigBlock &properties
 	HRESULT hr = pReflector->GetResourceBindingDesc( ii++, &desc );
 	while( SUCCEEDED(hr) )
 	{
-        cString tagName = s2ws(desc.Name);
-        CPUTConfigEntry *pValue = properties.GetValueByName(tagName);
+        CPUTStringID tagName = CPUTStringTable::Find( s2ws(desc.Name) );
+        CPUTConfigEntry *pValue = properties.GetValueByID(tagName);
         if( !pValue->IsValid() )
         {
             // We didn't find our property in the file.  Is it in the global config block?
-            pValue = CPUTMaterial::mGlobalProperties.GetValueByName(tagName);
+            pValue = CPUTMaterial::mGlobalProperties.GetValueByID(tagName);
         }
         cString boundName = pValue->ValueAsString();
         if( (boundName.length() > 0) && ((boundName[0] == '@') || (boundName[0] == '#')) )
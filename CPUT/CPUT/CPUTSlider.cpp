@@ -527,9 +527,9 @@ void CPUTSlider::SetText(const cString ControlText)
     else
     {
 #ifdef CPUT_FOR_DX11
-        CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+        CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-        CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+        CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
         #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif 
@@ -880,9 +880,9 @@ void CPUTSlider::Recalculate()
     }
 
 #ifdef CPUT_FOR_DX11
-        CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+        CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-        CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+        CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
         #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif
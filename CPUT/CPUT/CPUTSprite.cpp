@@ -106,21 +106,21 @@ void CPUTSprite::DrawSprite(
     // If it doesn't draw, make sure you created it with createDebugSprite == true
     if( mpVertexBuffer )
     {
-        ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+        CPUTRenderBackend *pBackend = renderParams.mpBackend;
 
         material.SetRenderStates(renderParams);
 
         UINT stride = sizeof( SpriteVertex );
         UINT offset = 0;
-        pContext->IASetVertexBuffers( 0, 1, &mpVertexBuffer, &stride, &offset );
+        pBackend->SetVertexBuffer( 0, mpVertexBuffer, stride, offset );
 
         // Set the input layout
-        pContext->IASetInputLayout( mpInputLayout );
+        pBackend->SetInputLayout( mpInputLayout );
 
         // Set primitive topology
-        pContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+        pBackend->SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
 
-        pContext->Draw( 6, 0 );
+        pBackend->Draw( 6, 0 );
     }
 } // CPUTSprite::DrawSprite()
 
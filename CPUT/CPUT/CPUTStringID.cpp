@@ -0,0 +1,302 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTStringID.h"
+#include "CPUTAllocator.h"
+#include "CPUTHash.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+static SRWLOCK sStringLock = SRWLOCK_INIT;
+#   define STRING_READ_LOCK()               AcquireSRWLockShared( &sStringLock )
+#   define STRING_READ_UNLOCK()             ReleaseSRWLockShared( &sStringLock )
+#   define STRING_WRITE_LOCK()              AcquireSRWLockExclusive( &sStringLock )
+#   define STRING_WRITE_UNLOCK()            ReleaseSRWLockExclusive( &sStringLock )
+#   define STRING_INCREMENT(value)          InterlockedIncrement64( &(value) )
+static volatile LONGLONG sInterns = 0;
+static volatile LONGLONG sFinds   = 0;
+#else
+#   include <pthread.h>
+static pthread_rwlock_t sStringLock = PTHREAD_RWLOCK_INITIALIZER;
+#   define STRING_READ_LOCK()               pthread_rwlock_rdlock( &sStringLock )
+#   define STRING_READ_UNLOCK()             pthread_rwlock_unlock( &sStringLock )
+#   define STRING_WRITE_LOCK()              pthread_rwlock_wrlock( &sStringLock )
+#   define STRING_WRITE_UNLOCK()            pthread_rwlock_unlock( &sStringLock )
+#   define STRING_INCREMENT(value)          __sync_add_and_fetch( &(value), 1 )
+static volatile int64_t  sInterns = 0;
+static volatile int64_t  sFinds   = 0;
+#endif
+
+// Only plain pointers and integers here: they need no constructor, so strings can be
+// interned while other files' statics are constructed, and stay valid while they're destroyed.
+//-----------------------------------------------------------------------------
+struct CPUTStringEntry
+{
+    const CPUTStringChar *mpString;
+    uint64_t              mHash;
+    uint32_t              mLength;
+};
+
+static const CPUTStringChar sEmptyString[1] = { 0 };
+static CPUTStringEntry *spEntries       = NULL;   // Indexed by ID.  Entry 0 is CPUT_STRING_ID_NONE.
+static uint32_t         sEntryCount     = 0;
+static uint32_t         sEntryCapacity  = 0;
+static CPUTStringID    *spIndex         = NULL;   // Open addressing by hash; CPUT_STRING_ID_NONE is a free slot
+static uint32_t         sIndexCapacity  = 0;      // 0 or a power of two
+static CPUTArena       *spStrings       = NULL;   // Never freed
+static uint64_t         sStringBytes    = 0;
+
+//-----------------------------------------------------------------------------
+static inline CPUTStringChar FoldCase( CPUTStringChar c )
+{
+    return (c >= 'A' && c <= 'Z') ? (CPUTStringChar)(c + ('a' - 'A')) : c;
+}
+
+//-----------------------------------------------------------------------------
+static bool EqualFolded( const CPUTStringChar *pA, const CPUTStringChar *pB, size_t length )
+{
+    for( size_t ii=0; ii<length; ii++ )
+    {
+        if( FoldCase( pA[ii] ) != FoldCase( pB[ii] ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static inline uint32_t FirstSlot( uint64_t hash )
+{
+    // The low bits of FNV are weak; fold the high half in (as CPUTFlatHashMap does)
+    return (uint32_t)(hash ^ (hash >> 32)) & (sIndexCapacity - 1);
+}
+
+// Call with the lock held.  Returns CPUT_STRING_ID_NONE, and the free slot where the
+// string would go, if it isn't there.
+//-----------------------------------------------------------------------------
+static CPUTStringID Lookup( const CPUTStringChar *pString, size_t length, uint64_t hash, uint32_t *pSlot )
+{
+    if( !sIndexCapacity )
+    {
+        return CPUT_STRING_ID_NONE;
+    }
+    uint32_t slot = FirstSlot( hash );
+    for( ;; )
+    {
+        CPUTStringID id = spIndex[slot];
+        if( CPUT_STRING_ID_NONE == id )
+        {
+            *pSlot = slot;
+            return CPUT_STRING_ID_NONE;
+        }
+        const CPUTStringEntry &entry = spEntries[id];
+        if( entry.mHash == hash && entry.mLength == length && EqualFolded( entry.mpString, pString, length ) )
+        {
+            return id;
+        }
+        slot = (slot + 1) & (sIndexCapacity - 1);
+    }
+}
+
+// Call with the write lock held.  Keeps the index at most half full.
+//-----------------------------------------------------------------------------
+static void Reserve( uint32_t count )
+{
+    if( count > sEntryCapacity )
+    {
+        uint32_t capacity = sEntryCapacity ? sEntryCapacity * 2 : 256;
+        CPUTStringEntry *pEntries = (CPUTStringEntry*)malloc( capacity * sizeof(CPUTStringEntry) );
+        if( sEntryCount )
+        {
+            memcpy( pEntries, spEntries, sEntryCount * sizeof(CPUTStringEntry) );
+        }
+        free( spEntries );
+        spEntries      = pEntries;
+        sEntryCapacity = capacity;
+    }
+    if( 2 * count > sIndexCapacity )
+    {
+        free( spIndex );
+        sIndexCapacity = sIndexCapacity ? sIndexCapacity * 2 : 512;
+        spIndex = (CPUTStringID*)calloc( sIndexCapacity, sizeof(CPUTStringID) );
+        for( uint32_t id=1; id<sEntryCount; id++ )
+        {
+            uint32_t slot = FirstSlot( spEntries[id].mHash );
+            while( spIndex[slot] )
+            {
+                slot = (slot + 1) & (sIndexCapacity - 1);
+            }
+            spIndex[slot] = id;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTStringTable::Hash( const CPUTStringChar *pString, size_t length )
+{
+    uint64_t hash = CPUT_HASH_SEED;
+    for( size_t ii=0; ii<length; ii++ )
+    {
+        CPUTStringChar c = FoldCase( pString[ii] );
+        hash = CPUTHashBytes( &c, sizeof(c), hash );
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+CPUTStringID CPUTStringTable::Intern( const CPUTStringChar *pString, size_t length )
+{
+    STRING_INCREMENT( sInterns );
+    if( !length )
+    {
+        return CPUT_STRING_ID_NONE;
+    }
+    uint64_t hash = Hash( pString, length );
+    uint32_t slot;
+
+    STRING_READ_LOCK();
+    CPUTStringID id = Lookup( pString, length, hash, &slot );
+    STRING_READ_UNLOCK();
+    if( CPUT_STRING_ID_NONE != id )
+    {
+        return id;
+    }
+
+    STRING_WRITE_LOCK();
+    // Another thread may have added it since we looked
+    id = Lookup( pString, length, hash, &slot );
+    if( CPUT_STRING_ID_NONE == id )
+    {
+        uint32_t capacity = sIndexCapacity;
+        if( !spStrings )
+        {
+            spStrings = new CPUTArena( 64 * 1024 );
+            Reserve( 1 );
+            sEntryCount = 1;
+            spEntries[0].mpString = sEmptyString;
+            spEntries[0].mHash    = Hash( sEmptyString, 0 );
+            spEntries[0].mLength  = 0;
+        }
+        Reserve( sEntryCount + 1 );
+        if( capacity != sIndexCapacity )
+        {
+            // The index was rehashed (or just made): find the free slot again
+            Lookup( pString, length, hash, &slot );
+        }
+
+        size_t bytes = (length + 1) * sizeof(CPUTStringChar);
+        CPUTStringChar *pCopy = (CPUTStringChar*)spStrings->Allocate( bytes, sizeof(CPUTStringChar) );
+        memcpy( pCopy, pString, length * sizeof(CPUTStringChar) );
+        pCopy[length] = 0;
+        sStringBytes += bytes;
+
+        id = sEntryCount++;
+        spEntries[id].mpString = pCopy;
+        spEntries[id].mHash    = hash;
+        spEntries[id].mLength  = (uint32_t)length;
+        spIndex[slot] = id;
+    }
+    STRING_WRITE_UNLOCK();
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+CPUTStringID CPUTStringTable::Intern( const CPUTStringChar *pString )
+{
+    return Intern( pString, std::char_traits<CPUTStringChar>::length( pString ) );
+}
+
+//-----------------------------------------------------------------------------
+CPUTStringID CPUTStringTable::Find( const CPUTStringChar *pString, size_t length )
+{
+    STRING_INCREMENT( sFinds );
+    if( !length )
+    {
+        return CPUT_STRING_ID_NONE;
+    }
+    uint64_t hash = Hash( pString, length );
+    uint32_t slot;
+
+    STRING_READ_LOCK();
+    CPUTStringID id = Lookup( pString, length, hash, &slot );
+    STRING_READ_UNLOCK();
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+CPUTStringID CPUTStringTable::Find( const CPUTStringChar *pString )
+{
+    return Find( pString, std::char_traits<CPUTStringChar>::length( pString ) );
+}
+
+//-----------------------------------------------------------------------------
+const CPUTStringChar *CPUTStringTable::GetString( CPUTStringID id )
+{
+    if( CPUT_STRING_ID_NONE == id )
+    {
+        return sEmptyString;
+    }
+    STRING_READ_LOCK();
+    assert( id < sEntryCount );
+    const CPUTStringChar *pString = spEntries[id].mpString;
+    STRING_READ_UNLOCK();
+    return pString;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTStringTable::GetLength( CPUTStringID id )
+{
+    if( CPUT_STRING_ID_NONE == id )
+    {
+        return 0;
+    }
+    STRING_READ_LOCK();
+    assert( id < sEntryCount );
+    uint32_t length = spEntries[id].mLength;
+    STRING_READ_UNLOCK();
+    return length;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTStringTable::GetHash( CPUTStringID id )
+{
+    if( CPUT_STRING_ID_NONE == id )
+    {
+        return Hash( sEmptyString, 0 );
+    }
+    STRING_READ_LOCK();
+    assert( id < sEntryCount );
+    uint64_t hash = spEntries[id].mHash;
+    STRING_READ_UNLOCK();
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+CPUTStringTableStats CPUTStringTable::GetStats()
+{
+    CPUTStringTableStats stats;
+    STRING_READ_LOCK();
+    stats.mStrings     = sEntryCount ? sEntryCount - 1 : 0;
+    stats.mStringBytes = sStringBytes;
+    stats.mTableBytes  = (uint64_t)sEntryCapacity * sizeof(CPUTStringEntry) + (uint64_t)sIndexCapacity * sizeof(CPUTStringID);
+    STRING_READ_UNLOCK();
+    stats.mInterns     = (uint64_t)sInterns;
+    stats.mFinds       = (uint64_t)sFinds;
+    return stats;
+}
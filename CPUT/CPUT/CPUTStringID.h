@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTSTRINGID_H__
+#define __CPUTSTRINGID_H__
+
+// Interned strings.
+//
+// CPUTStringTable keeps one copy of every string interned in it, and names each by a
+// CPUTStringID: a small integer that stays valid until the process exits.  Strings that
+// differ only in the case of ASCII letters get the same ID (as with _wcsicmp()), so code
+// that looks names up by ID compares one integer instead of folding and comparing strings.
+// The asset library, config blocks and shader parameter tables are keyed this way.
+//
+// Each string's case-folded hash is computed once, when it's interned.  Intern() adds
+// strings; Find() only looks, so a name nobody interned can be rejected without adding
+// it.  Interned strings are never freed: intern names, not data.
+//
+// Thread safe.  Lookups share a reader lock.
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#if defined(UNICODE) || defined(_UNICODE)
+typedef wchar_t CPUTStringChar;
+#else
+typedef char    CPUTStringChar;
+#endif
+
+typedef uint32_t CPUTStringID;
+const CPUTStringID CPUT_STRING_ID_NONE = 0;     // The empty string; also what Find() returns for one never interned
+
+//-----------------------------------------------------------------------------
+struct CPUTStringTableStats
+{
+    uint32_t mStrings;
+    uint64_t mStringBytes;      // Characters and terminators
+    uint64_t mTableBytes;       // The entries and the index
+    uint64_t mInterns;          // Calls to Intern()
+    uint64_t mFinds;            // Calls to Find()
+};
+
+//-----------------------------------------------------------------------------
+class CPUTStringTable
+{
+public:
+    static CPUTStringID Intern( const CPUTStringChar *pString, size_t length );
+    static CPUTStringID Intern( const CPUTStringChar *pString );
+    static CPUTStringID Intern( const std::basic_string<CPUTStringChar> &string ) { return Intern( string.data(), string.length() ); }
+
+    static CPUTStringID Find( const CPUTStringChar *pString, size_t length );
+    static CPUTStringID Find( const CPUTStringChar *pString );
+    static CPUTStringID Find( const std::basic_string<CPUTStringChar> &string ) { return Find( string.data(), string.length() ); }
+
+    // The string, in the case it was first interned with
+    static const CPUTStringChar *GetString( CPUTStringID id );
+    static uint32_t              GetLength( CPUTStringID id );
+    static uint64_t              GetHash( CPUTStringID id );
+
+    // 64-bit FNV-1a of the string with ASCII letters in lower case
+    static uint64_t Hash( const CPUTStringChar *pString, size_t length );
+
+    static CPUTStringTableStats GetStats();
+};
+
+#endif // __CPUTSTRINGID_H__
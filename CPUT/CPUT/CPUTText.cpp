@@ -86,6 +86,11 @@ void CPUTText::InitialStateSet()
     mPosition.x=0; mPosition.y=0;
     mQuadSize.width=0; mQuadSize.height=0;
     mDimensions.x=0; mDimensions.y=0; mDimensions.width=0; mDimensions.height=0;
+
+    mMirrorBufferCapacity = 0;
+    mBuiltPosition.x=0; mBuiltPosition.y=0;
+    mBuiltEnabled = false;
+    mBuiltZDepth = 0.0f;
 }
 
 // Destructor
@@ -156,6 +161,7 @@ void CPUTText::SetEnable(bool in_bEnabled)
 void CPUTText::ReleaseInstanceData()
 {
     SAFE_DELETE_ARRAY(mpMirrorBuffer);
+    mMirrorBufferCapacity = 0;
 }
 
 //--------------------------------------------------------------------------------
@@ -251,10 +257,7 @@ int CPUTText::GetOutputVertexCount()
 //--------------------------------------------------------------------------------
 void CPUTText::Recalculate()
 {
-    SAFE_DELETE_ARRAY(mpMirrorBuffer);
-
-    mNumCharsInString = (int) mStaticText.size();
-    mpMirrorBuffer = new CPUTGUIVertex[(mNumCharsInString+1)*6];
+    CPUT_SIZE previousSize = mQuadSize;
 
     bool Enabled = false;
     if(CPUT_CONTROL_ACTIVE == mControlState)
@@ -262,55 +265,66 @@ void CPUTText::Recalculate()
         Enabled = true;
     }
 
-    // walk each character and build a quad from it
-    float characterPosition=0;
-    for(int ii=0; ii<mNumCharsInString; ii++)
+    // lay out the string.  The font caches layouts, and measures only what changed
+    // since the last string.
+    mPreviousGlyphRun.Swap(mGlyphRun);
+    mGlyphRun = mpFont->LayoutText(mStaticText, &mPreviousGlyphRun);
+    int PreviousNumChars = mNumCharsInString;
+    mNumCharsInString = (int) mGlyphRun.GetLength();
+
+    // only rebuild the quads of the characters that moved or changed, unless
+    // everything moved or the mirror buffer has to grow
+    uint32_t First = 0;
+    uint32_t Last = mNumCharsInString;
+    bool RebuildAll = !mpMirrorBuffer || mNumCharsInString > mMirrorBufferCapacity ||
+                      mBuiltPosition.x != mPosition.x || mBuiltPosition.y != mPosition.y ||
+                      mBuiltEnabled != Enabled || mBuiltZDepth != mZDepth;
+    if(RebuildAll)
     {
-        // todo: unsafe cast from wchar_t to char!  Some other way???
-        char character = (char) mStaticText[ii];
-        float3 UV1, UV2;
-        CPUT_SIZE size = mpFont->GetGlyphSize(character);
-        mpFont->GetGlyphUVS(character, Enabled, UV1, UV2);
-        if('\t'!=character)
+        if(mNumCharsInString > mMirrorBufferCapacity)
         {
-            AddQuadIntoMirrorBuffer(mpMirrorBuffer, ii*6, (float)mPosition.x+characterPosition, (float)mPosition.y, (float)size.width, (float)size.height, UV1, UV2);
+            // leave room for the string to grow a little before reallocating again
+            SAFE_DELETE_ARRAY(mpMirrorBuffer);
+            mMirrorBufferCapacity = mNumCharsInString + mNumCharsInString/2 + 1;
+            mpMirrorBuffer = new CPUTGUIVertex[mMirrorBufferCapacity*6];
         }
-        else
-        {   
-            // calculate tab width = # pixels to get to next tabstop
-            // Tabs are relative from BEGINNNING of the string, not absolute based on x-position of string.  So in order for columns to line
-            // up, you need the starts of the strings to line up too.
-            // If you want 'absolute' x alignment behavior, use this:
-            //size.width = size.width - ((mPosition.x+characterPosition) % size.width);
-
-            // simply skip the amount of space indicated in the font's tab slot
-            int CurrentPositionForNextGlyph = (int) characterPosition;
-            size.width = size.width - (CurrentPositionForNextGlyph % size.width);            
+    }
+    else
+    {
+        uint32_t Suffix = 0;
+        CPUTCompareGlyphRuns(mPreviousGlyphRun, mGlyphRun, &First, &Suffix);
+        if(Suffix && PreviousNumChars != mNumCharsInString)
+        {
+            // unchanged tail: slide its quads to their new index
+            memmove(&mpMirrorBuffer[6*(mNumCharsInString-Suffix)], &mpMirrorBuffer[6*(PreviousNumChars-Suffix)], sizeof(CPUTGUIVertex)*6*Suffix);
         }
-        
-        // store the max height of the string
-        mQuadSize.height = max(mQuadSize.height, size.height);
-
-        // step to next X location for next character
-        characterPosition+=size.width;
+        Last = mNumCharsInString - Suffix;
     }
+    CPUTBuildGlyphQuads(*mpFont, mGlyphRun, First, Last, (float)mPosition.x, (float)mPosition.y, mZDepth, Enabled, mpMirrorBuffer);
+    mBuiltPosition = mPosition;
+    mBuiltEnabled = Enabled;
+    mBuiltZDepth = mZDepth;
+
+    // store the max height of the string
+    mQuadSize.height = max(mQuadSize.height, mGlyphRun.mHeight);
 
     // store the total width of the string 
-    mQuadSize.width = (int)characterPosition;   // width of string in pixels
+    mQuadSize.width = mGlyphRun.mWidth;   // width of string in pixels
 
     // tell gui system this control image is now dirty
     // and needs to rebuild it's draw list
 #ifdef CPUT_FOR_DX11
-        CPUTGuiControllerDX11::GetController()->ControlIsDirty();
+        CPUTGuiControllerDX11::GetController()->ControlIsDirty(this);
 #elif defined(CPUT_FOR_OGLES)
-        CPUTGuiControllerOGLES::GetController()->ControlIsDirty();
+        CPUTGuiControllerOGLES::GetController()->ControlIsDirty(this);
 #else    
         #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
 #endif 
 
-    // position or size may move - force a recalculation of this control's location
-    // if it is managed by the auto-arrange function
-    if(this->IsAutoArranged())
+    // if the size changed, force a recalculation of this control's location
+    // if it is managed by the auto-arrange function.  Text that changes every
+    // frame but keeps its size (counters, readouts) then only rebuilds itself.
+    if(this->IsAutoArranged() && (previousSize.width != mQuadSize.width || previousSize.height != mQuadSize.height))
     {
 #ifdef CPUT_FOR_DX11
         CPUTGuiControllerDX11::GetController()->Resize();
@@ -324,7 +338,7 @@ void CPUTText::Recalculate()
 
 // Register quad for drawing string on
 //--------------------------------------------------------------------------------
-CPUTResult CPUTText::SetText(const cString String, float depth)
+CPUTResult CPUTText::SetText(const cString &String, float depth)
 {    
     HEAPCHECK;
 
@@ -338,35 +352,3 @@ CPUTResult CPUTText::SetText(const cString String, float depth)
     HEAPCHECK;
     return CPUT_SUCCESS;
 }
-
-// This generates a quad with the supplied coordinates/uv's/etc.
-//------------------------------------------------------------------------
-void CPUTText::AddQuadIntoMirrorBuffer(CPUTGUIVertex *pMirrorBuffer,
-    int index,
-    float x, 
-    float y, 
-    float w, 
-    float h, 
-    float3 uv1, 
-    float3 uv2 )
-{
-    pMirrorBuffer[index+0].Pos = float3( x + 0.0f, y + 0.0f, mZDepth);
-    pMirrorBuffer[index+0].UV = float2(uv1.x, uv1.y);
-
-    pMirrorBuffer[index+1].Pos = float3( x + w, y + 0.0f, mZDepth);
-    pMirrorBuffer[index+1].UV = float2(uv2.x, uv1.y);
-
-    pMirrorBuffer[index+2].Pos = float3( x + 0.0f, y + h, mZDepth);
-    pMirrorBuffer[index+2].UV = float2(uv1.x, uv2.y);
-
-
-    pMirrorBuffer[index+3].Pos = float3( x + w, y + 0.0f, mZDepth);
-    pMirrorBuffer[index+3].UV = float2(uv2.x, uv1.y);
-
-    pMirrorBuffer[index+4].Pos = float3( x + w, y + h, mZDepth);
-    pMirrorBuffer[index+4].UV = float2(uv2.x, uv2.y);
-
-    pMirrorBuffer[index+5].Pos = float3( x + 0.0f, y +h, mZDepth);
-    pMirrorBuffer[index+5].UV = float2(uv1.x, uv2.y);
-}
-
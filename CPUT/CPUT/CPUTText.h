@@ -18,6 +18,7 @@
 
 #include "CPUTControl.h"
 #include "CPUTGuiController.h"
+#include "CPUTGlyphRun.h"
 
 class CPUTFont;
 
@@ -50,7 +51,7 @@ public:
     bool ContainsPoint(int x, int y) {UNREFERENCED_PARAMETER(x);UNREFERENCED_PARAMETER(y);return false;}
 
     // CPUTText
-    CPUTResult SetText(const cString String, float depth=0.5f);
+    CPUTResult SetText(const cString &String, float depth=0.5f);
     int GetOutputVertexCount();
 
     // Register assets
@@ -78,6 +79,14 @@ protected:
     float mZDepth;
     CPUTGUIVertex *mpMirrorBuffer;
     int mNumCharsInString;
+    int mMirrorBufferCapacity;      // in characters
+    CPUTGlyphRun mGlyphRun;         // layout of mStaticText
+    CPUTGlyphRun mPreviousGlyphRun; // the last layout, kept so updates reuse its memory
+
+    // what the quads in mpMirrorBuffer were built with
+    CPUT_POINT mBuiltPosition;
+    bool mBuiltEnabled;
+    float mBuiltZDepth;
     static CPUT_SIZE mpStaticIdleImageSizeList[500]; // todo: size for #chars in font
     static CPUT_SIZE mpStaticDisabledImageSizeList[500]; // todo: size for #chars in font
     
@@ -86,7 +95,6 @@ protected:
     void InitialStateSet();
     void ReleaseInstanceData();
     void Recalculate();
-    void AddQuadIntoMirrorBuffer(CPUTGUIVertex *pMirrorBuffer, int index, float x, float y, float w, float h, float3 uv1, float3 uv2 );
 
 };
 
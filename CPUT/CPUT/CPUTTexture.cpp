@@ -24,12 +24,12 @@
 #endif
 
 
-CPUTTexture *CPUTTexture::CreateTexture( const cString &name, const cString absolutePathAndFilename, bool loadAsSRGB )
+CPUTTexture *CPUTTexture::CreateTexture( const cString &name, const cString absolutePathAndFilename, bool loadAsSRGB, bool allowStreaming )
 {
     // TODO: accept DX11/OGL param to control which platform we generate.
     // TODO: be sure to support the case where we want to support only one of them
 #ifdef CPUT_FOR_DX11
-    return CPUTTextureDX11::CreateTexture( name, absolutePathAndFilename, loadAsSRGB );
+    return CPUTTextureDX11::CreateTexture( name, absolutePathAndFilename, loadAsSRGB, allowStreaming );
 #elif defined(CPUT_FOR_OGLES)
     return CPUTTextureOGLES::CreateTexture( name, absolutePathAndFilename, loadAsSRGB );
 #else    
@@ -123,8 +123,18 @@ const cString gDXGIFormatNames[] =
 const cString *gpDXGIFormatNames = gDXGIFormatNames;
 
 //-----------------------------------------------------------------------------
-CPUTTexture *CPUTTextureDX11::CreateTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB )
+CPUTTexture *CPUTTextureDX11::CreateTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB, bool allowStreaming )
 {
+    if( allowStreaming )
+    {
+        CPUTTextureDX11 *pStreamedTexture = CreateStreamedTexture( name, absolutePathAndFilename, loadAsSRGB );
+        if( pStreamedTexture )
+        {
+            CPUTAssetLibrary::GetAssetLibrary()->AddTexture( absolutePathAndFilename, pStreamedTexture );
+            return pStreamedTexture;
+        }
+    }
+
     // TODO:  Delegate to derived class.  We don't currently have CPUTTextureDX11
     ID3D11ShaderResourceView *pShaderResourceView = NULL;
     ID3D11Resource *pTexture = NULL;
@@ -143,6 +153,145 @@ CPUTTexture *CPUTTextureDX11::CreateTexture( const cString &name, const cString
     return pNewTexture;
 }
 
+// Returns NULL if the file can't be streamed (not a 2D DDS/KTX file in a supported format),
+// in which case the caller loads it with D3DX.  Only the mip tail is loaded here.
+//-----------------------------------------------------------------------------
+CPUTTextureDX11 *CPUTTextureDX11::CreateStreamedTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB )
+{
+    CPUTTextureStreamer *pStreamer = CPUT_DX11::GetTextureStreamer();
+    char pFileName[MAX_PATH];
+    size_t count;
+    if( !pStreamer || 0 != wcstombs_s( &count, pFileName, absolutePathAndFilename.c_str(), MAX_PATH ) ||
+        !CPUTTextureFile::HasTextureFileExtension( pFileName ) )
+    {
+        return NULL;
+    }
+    CPUTTextureFile *pFile = new CPUTTextureFile();
+    if( !pFile->Open( pFileName ) || CPUTTextureFile::DIMENSION_2D != pFile->GetDimension() )
+    {
+        delete pFile;
+        return NULL;
+    }
+    DXGI_FORMAT format = (DXGI_FORMAT)pFile->GetFormat();
+    if( loadAsSRGB )
+    {
+        DXGI_FORMAT sRGBFormat;
+        if( CPUTFAILED( GetSRGBEquivalent( format, sRGBFormat ) ) )
+        {
+            delete pFile; // The D3DX path reports the error
+            return NULL;
+        }
+        format = sRGBFormat;
+    }
+
+    CPUTTextureDX11 *pNewTexture = new CPUTTextureDX11();
+    pNewTexture->mName            = name;
+    pNewTexture->mStreamingFormat = format;
+    pNewTexture->mStreamingHandle = pStreamer->Register( pNewTexture, pFile ); // Takes pFile
+    if( CPUT_INVALID_STREAMING_HANDLE == pNewTexture->mStreamingHandle )
+    {
+        pNewTexture->Release();
+        return NULL;
+    }
+    return pNewTexture;
+}
+
+// Recreates the texture with mips [topMip, mipCount) of the file.  Levels that were
+// already resident are copied on the GPU; new ones are uploaded from ppMipData.
+//-----------------------------------------------------------------------------
+bool CPUTTextureDX11::SetResidentMips( const CPUTTextureFile &file, uint32_t topMip, const uint8_t *const *ppMipData )
+{
+    ID3D11Device *pD3dDevice = CPUT_DX11::GetDevice();
+    const CPUTTextureSubresource &top = file.GetSubresource( topMip, 0 );
+    UINT mipCount  = file.GetMipCount() - topMip;
+    UINT arraySize = file.GetArraySize();
+
+    D3D11_TEXTURE2D_DESC desc;
+    desc.Width              = top.mWidth;
+    desc.Height             = top.mHeight;
+    desc.MipLevels          = mipCount;
+    desc.ArraySize          = arraySize;
+    desc.Format             = mStreamingFormat;
+    desc.SampleDesc.Count   = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage              = D3D11_USAGE_DEFAULT;
+    desc.BindFlags          = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags     = 0;
+    desc.MiscFlags          = file.IsCubeMap() ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+    HRESULT hr;
+    ID3D11Texture2D *pTexture = NULL;
+    if( !mpTexture )
+    {
+        // First call (the mip tail): every level is new
+        D3D11_SUBRESOURCE_DATA *pInitialData = new D3D11_SUBRESOURCE_DATA[mipCount * arraySize];
+        for( UINT mip=0; mip<mipCount; mip++ )
+        {
+            const uint8_t *pSource = ppMipData[mip];
+            for( UINT slice=0; slice<arraySize; slice++ )
+            {
+                const CPUTTextureSubresource &subresource = file.GetSubresource( topMip + mip, slice );
+                D3D11_SUBRESOURCE_DATA &data = pInitialData[D3D11CalcSubresource( mip, slice, mipCount )];
+                data.pSysMem          = pSource;
+                data.SysMemPitch      = subresource.mRowPitch;
+                data.SysMemSlicePitch = subresource.mSlicePitch;
+                pSource += subresource.mSize;
+            }
+        }
+        hr = pD3dDevice->CreateTexture2D( &desc, pInitialData, &pTexture );
+        delete [] pInitialData;
+    }
+    else
+    {
+        hr = pD3dDevice->CreateTexture2D( &desc, NULL, &pTexture );
+        if( SUCCEEDED(hr) )
+        {
+            ID3D11DeviceContext *pContext;
+            pD3dDevice->GetImmediateContext( &pContext );
+            UINT oldMipCount = file.GetMipCount() - mStreamingTopMip;
+            for( UINT mip=0; mip<mipCount; mip++ )
+            {
+                const uint8_t *pSource = ppMipData[mip];
+                for( UINT slice=0; slice<arraySize; slice++ )
+                {
+                    UINT destination = D3D11CalcSubresource( mip, slice, mipCount );
+                    if( pSource )
+                    {
+                        const CPUTTextureSubresource &subresource = file.GetSubresource( topMip + mip, slice );
+                        pContext->UpdateSubresource( pTexture, destination, NULL, pSource, subresource.mRowPitch, subresource.mSlicePitch );
+                        pSource += subresource.mSize;
+                    }
+                    else
+                    {
+                        UINT source = D3D11CalcSubresource( topMip + mip - mStreamingTopMip, slice, oldMipCount );
+                        pContext->CopySubresourceRegion( pTexture, destination, 0, 0, 0, mpTexture, source, NULL );
+                    }
+                }
+            }
+            pContext->Release();
+        }
+    }
+    if( FAILED(hr) )
+    {
+        return false;
+    }
+
+    ID3D11ShaderResourceView *pShaderResourceView = NULL;
+    hr = pD3dDevice->CreateShaderResourceView( pTexture, NULL, &pShaderResourceView );
+    if( FAILED(hr) )
+    {
+        pTexture->Release();
+        return false;
+    }
+    CPUTSetDebugName( pTexture, mName );
+    CPUTSetDebugName( pShaderResourceView, mName );
+    SetTextureAndShaderResourceView( pTexture, pShaderResourceView );
+    pTexture->Release();
+    pShaderResourceView->Release();
+    mStreamingTopMip = topMip;
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 CPUTResult CPUTTextureDX11::CreateNativeTexture(
     ID3D11Device *pD3dDevice,
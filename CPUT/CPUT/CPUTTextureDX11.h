@@ -18,10 +18,14 @@
 
 #include "CPUTTexture.h"
 #include "CPUT_DX11.h"
+#include "CPUTTextureStreamer.h"
 #include <d3d11.h>
 #include <d3DX11.h>
 
-class CPUTTextureDX11 : public CPUTTexture
+// Material textures in .dds/.ktx files are streamed (see CPUTTextureStreamer): the
+// texture and its view are recreated each time mips are added or evicted, so the view
+// returned by GetShaderResourceView() changes.
+class CPUTTextureDX11 : public CPUTTexture, public CPUTStreamedTexture
 {
 private:
     // resource view pointer
@@ -29,19 +33,29 @@ private:
     ID3D11ShaderResourceView *mpShaderResourceView;
     ID3D11Resource           *mpTexture;
     ID3D11Resource           *mpTextureStaging;
+    CPUTStreamingHandle       mStreamingHandle;
+    DXGI_FORMAT               mStreamingFormat;
+    uint32_t                  mStreamingTopMip;  // File mip that is mip 0 of mpTexture
 
     // Destructor is not public.  Must release instead of delete.
     ~CPUTTextureDX11() {
+        CPUTTextureStreamer *pStreamer = CPUT_DX11::GetTextureStreamer();
+        if( pStreamer && CPUT_INVALID_STREAMING_HANDLE != mStreamingHandle )
+        {
+            pStreamer->Unregister( mStreamingHandle );
+        }
         SAFE_RELEASE( mpShaderResourceView );
         SAFE_RELEASE( mpTexture );
         SAFE_RELEASE( mpTextureStaging );
     }
 
+    static CPUTTextureDX11 *CreateStreamedTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB );
+
 public:
     static const cString &GetDXGIFormatString(DXGI_FORMAT Format);
     static CPUTResult     GetSRGBEquivalent(DXGI_FORMAT inFormat, DXGI_FORMAT& sRGBFormat);
     static bool           DoesExistEquivalentSRGBFormat(DXGI_FORMAT inFormat);
-    static CPUTTexture   *CreateTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB );
+    static CPUTTexture   *CreateTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB, bool allowStreaming=false );
     static CPUTResult     CreateNativeTexture(
                               ID3D11Device *pD3dDevice,
                               const cString &fileName,
@@ -53,16 +67,25 @@ public:
     CPUTTextureDX11() :
         mpShaderResourceView(NULL),
         mpTexture(NULL),
-        mpTextureStaging(NULL)
+        mpTextureStaging(NULL),
+        mStreamingHandle(CPUT_INVALID_STREAMING_HANDLE),
+        mStreamingFormat(DXGI_FORMAT_UNKNOWN),
+        mStreamingTopMip(0)
     {}
     CPUTTextureDX11(cString &name) :
         mpShaderResourceView(NULL),
         mpTexture(NULL),
         mpTextureStaging(NULL),
+        mStreamingHandle(CPUT_INVALID_STREAMING_HANDLE),
+        mStreamingFormat(DXGI_FORMAT_UNKNOWN),
+        mStreamingTopMip(0),
         CPUTTexture(name)
     {}
     CPUTTextureDX11(cString &name, ID3D11Resource *pTextureResource, ID3D11ShaderResourceView *pSrv ) :
         mpTextureStaging(NULL),
+        mStreamingHandle(CPUT_INVALID_STREAMING_HANDLE),
+        mStreamingFormat(DXGI_FORMAT_UNKNOWN),
+        mStreamingTopMip(0),
         CPUTTexture(name)
     {
         mpShaderResourceView = pSrv;
@@ -103,6 +126,10 @@ public:
     }
     D3D11_MAPPED_SUBRESOURCE  MapTexture(   CPUTRenderParameters &params, eCPUTMapType type, bool wait=true );
     void                      UnmapTexture( CPUTRenderParameters &params );
+
+    // CPUTStreamedTexture
+    bool                      SetResidentMips( const CPUTTextureFile &file, uint32_t topMip, const uint8_t *const *ppMipData );
+    CPUTStreamingHandle       GetStreamingHandle() const { return mStreamingHandle; } // CPUT_INVALID_STREAMING_HANDLE if not streamed
 };
 
 #endif //_CPUTTEXTUREDX11_H
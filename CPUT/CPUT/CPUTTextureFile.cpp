@@ -0,0 +1,571 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTextureFile.h"
+#include <string.h>
+
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+// D3D11 limits.  Larger files are rejected rather than risking overflow.
+const uint32_t CPUT_TEXTURE_FILE_MAX_SIZE       = 16384;
+const uint32_t CPUT_TEXTURE_FILE_MAX_DEPTH      = 2048;
+const uint32_t CPUT_TEXTURE_FILE_MAX_ARRAY_SIZE = 2048;
+
+const uint32_t DDS_MAGIC               = 0x20534444; // "DDS "
+const uint32_t DDS_HEADER_SIZE         = 124;
+const uint32_t DDS_HEADER_DX10_SIZE    = 20;
+const uint32_t DDS_PIXEL_FORMAT_SIZE   = 32;
+const uint32_t DDSD_MIPMAPCOUNT        = 0x20000;
+const uint32_t DDSCAPS2_CUBEMAP        = 0x200;
+const uint32_t DDSCAPS2_CUBEMAP_ALL    = 0xFC00;
+const uint32_t DDSCAPS2_VOLUME         = 0x200000;
+const uint32_t DDPF_ALPHA              = 0x2;
+const uint32_t DDPF_FOURCC             = 0x4;
+const uint32_t DDPF_RGB                = 0x40;
+const uint32_t DDPF_LUMINANCE          = 0x20000;
+const uint32_t DDS_RESOURCE_MISC_CUBE  = 0x4;
+
+const uint32_t KTX_HEADER_SIZE         = 64;
+const uint32_t KTX_ENDIANNESS          = 0x04030201;
+const uint8_t  KTX_IDENTIFIER[12]      = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+//-----------------------------------------------------------------------------
+static uint32_t ReadUint32( const uint8_t *pData )
+{
+    // Both containers are little endian (KTX files written big endian are rejected)
+    return (uint32_t)pData[0] | ((uint32_t)pData[1] << 8) | ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24);
+}
+
+//-----------------------------------------------------------------------------
+static uint32_t MakeFourCC( char a, char b, char c, char d )
+{
+    return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTGetTextureFormatBlockSize( uint32_t format, bool *pCompressed )
+{
+    *pCompressed = false;
+    if( format >=  1 && format <=  4 ) { return 16; } // R32G32B32A32
+    if( format >=  5 && format <=  8 ) { return 12; } // R32G32B32
+    if( format >=  9 && format <= 22 ) { return  8; } // R16G16B16A16, R32G32, R32G8X24
+    if( format >= 23 && format <= 47 ) { return  4; } // R10G10B10A2 .. X24_TYPELESS_G8
+    if( format >= 48 && format <= 59 ) { return  2; } // R8G8, R16
+    if( format >= 60 && format <= 65 ) { return  1; } // R8, A8
+    if( format == 67 )                 { return  4; } // R9G9B9E5_SHAREDEXP
+    if( format == 85 || format == 86 ) { return  2; } // B5G6R5, B5G5R5A1
+    if( format >= 87 && format <= 93 ) { return  4; } // B8G8R8A8, B8G8R8X8, R10G10B10_XR_BIAS_A2
+    *pCompressed = true;
+    if( (format >= 70 && format <= 72) || (format >= 79 && format <= 81) ) { return 8; }  // BC1, BC4
+    if( (format >= 73 && format <= 78) || (format >= 82 && format <= 84) ) { return 16; } // BC2, BC3, BC5
+    if( format >= 94 && format <= 99 ) { return 16; } // BC6H, BC7
+    *pCompressed = false;
+    return 0; // R1, packed 4:2:2, video formats, ...
+}
+
+//-----------------------------------------------------------------------------
+CPUTMappedFile::CPUTMappedFile() :
+    mpData(0),
+    mSize(0)
+#ifdef _WIN32
+    , mFile(INVALID_HANDLE_VALUE),
+    mMapping(NULL)
+#endif
+{
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTMappedFile::Open( const std::string &fileName )
+{
+    Close();
+#ifdef _WIN32
+    mFile = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if( INVALID_HANDLE_VALUE == mFile )
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( mFile, &size ) || 0 == size.QuadPart )
+    {
+        Close();
+        return false;
+    }
+    mMapping = CreateFileMappingA( mFile, NULL, PAGE_READONLY, 0, 0, NULL );
+    if( NULL == mMapping )
+    {
+        Close();
+        return false;
+    }
+    mpData = (const uint8_t*)MapViewOfFile( mMapping, FILE_MAP_READ, 0, 0, 0 );
+    if( !mpData )
+    {
+        Close();
+        return false;
+    }
+    mSize = (uint64_t)size.QuadPart;
+#else
+    int file = open( fileName.c_str(), O_RDONLY );
+    if( file < 0 )
+    {
+        return false;
+    }
+    struct stat info;
+    if( 0 != fstat( file, &info ) || 0 == info.st_size )
+    {
+        close( file );
+        return false;
+    }
+    void *pMapped = mmap( 0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+    close( file ); // The mapping keeps the file open
+    if( MAP_FAILED == pMapped )
+    {
+        return false;
+    }
+    mpData = (const uint8_t*)pMapped;
+    mSize  = (uint64_t)info.st_size;
+#endif
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMappedFile::Close()
+{
+#ifdef _WIN32
+    if( mpData )                       { UnmapViewOfFile( mpData ); }
+    if( mMapping )                     { CloseHandle( mMapping ); mMapping = NULL; }
+    if( INVALID_HANDLE_VALUE != mFile ) { CloseHandle( mFile ); mFile = INVALID_HANDLE_VALUE; }
+#else
+    if( mpData )                       { munmap( (void*)mpData, (size_t)mSize ); }
+#endif
+    mpData = 0;
+    mSize  = 0;
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureFile::CPUTTextureFile() :
+    mpData(0),
+    mSize(0),
+    mContainer(CONTAINER_DDS),
+    mDimension(DIMENSION_2D),
+    mFormat(CPUT_TEXTURE_FORMAT_UNKNOWN),
+    mWidth(0),
+    mHeight(0),
+    mDepth(0),
+    mMipCount(0),
+    mArraySize(0),
+    mCubeMap(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTTextureFile::HasTextureFileExtension( const std::string &fileName )
+{
+    if( fileName.size() < 4 )
+    {
+        return false;
+    }
+    char extension[5];
+    for( int ii=0; ii<4; ii++ )
+    {
+        char c = fileName[fileName.size() - 4 + ii];
+        extension[ii] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+    extension[4] = 0;
+    return 0 == strcmp( extension, ".dds" ) || 0 == strcmp( extension, ".ktx" );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTTextureFile::Open( const std::string &fileName )
+{
+    if( !mFile.Open( fileName ) )
+    {
+        return Fail( "Can't open or map the file" );
+    }
+    return Parse( mFile.GetData(), mFile.GetSize() );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTTextureFile::Parse( const uint8_t *pData, uint64_t size )
+{
+    mpData = pData;
+    mSize  = size;
+    mSubresources.clear();
+    mError.clear();
+
+    if( size >= 4 && DDS_MAGIC == ReadUint32( pData ) )
+    {
+        mContainer = CONTAINER_DDS;
+        return ParseDDS();
+    }
+    if( size >= sizeof(KTX_IDENTIFIER) && 0 == memcmp( pData, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER) ) )
+    {
+        mContainer = CONTAINER_KTX;
+        return ParseKTX();
+    }
+    return Fail( "Not a DDS or KTX file" );
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTTextureFile::SetFormat( uint32_t format )
+{
+    bool compressed;
+    mFormat = format;
+    return 0 != CPUTGetTextureFormatBlockSize( format, &compressed );
+}
+
+// Fills in the size and pitch of one subresource.  rowAlignment is 1 for DDS, 4 for KTX.
+//-----------------------------------------------------------------------------
+bool CPUTTextureFile::SetSubresource( uint32_t mip, uint32_t slice, uint64_t offset, uint32_t rowAlignment )
+{
+    bool compressed;
+    uint32_t blockSize = CPUTGetTextureFormatBlockSize( mFormat, &compressed );
+
+    CPUTTextureSubresource &subresource = mSubresources[mip + slice * mMipCount];
+    subresource.mOffset = offset;
+    subresource.mWidth  = (mWidth  >> mip) ? (mWidth  >> mip) : 1;
+    subresource.mHeight = (mHeight >> mip) ? (mHeight >> mip) : 1;
+    subresource.mDepth  = (mDepth  >> mip) ? (mDepth  >> mip) : 1;
+
+    uint32_t rows;
+    if( compressed )
+    {
+        subresource.mRowPitch = ((subresource.mWidth + 3) / 4) * blockSize;
+        rows                  =  (subresource.mHeight + 3) / 4;
+    }
+    else
+    {
+        subresource.mRowPitch = (subresource.mWidth * blockSize + rowAlignment - 1) / rowAlignment * rowAlignment;
+        rows                  = subresource.mHeight;
+    }
+    // The size limits keep the pitch within 32 bits, but not always the slice or volume
+    uint64_t slicePitch = (uint64_t)subresource.mRowPitch * rows;
+    uint64_t size       = slicePitch * subresource.mDepth;
+    subresource.mSlicePitch = (uint32_t)slicePitch;
+    subresource.mSize       = (uint32_t)size;
+    return size <= 0xFFFFFFFFull;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTTextureFile::ParseDDS()
+{
+    if( mSize < 4 + DDS_HEADER_SIZE )
+    {
+        return Fail( "Truncated DDS header" );
+    }
+    const uint8_t *pHeader = mpData + 4;
+    uint32_t header[DDS_HEADER_SIZE / 4];
+    for( uint32_t ii=0; ii<DDS_HEADER_SIZE/4; ii++ )
+    {
+        header[ii] = ReadUint32( pHeader + ii*4 );
+    }
+    const uint32_t *pPixelFormat = &header[18];
+    if( DDS_HEADER_SIZE != header[0] || DDS_PIXEL_FORMAT_SIZE != pPixelFormat[0] )
+    {
+        return Fail( "Bad DDS header size" );
+    }
+    uint32_t flags  = header[1];
+    uint32_t caps2  = header[27];
+    uint64_t offset = 4 + DDS_HEADER_SIZE;
+
+    mHeight    = header[2];
+    mWidth     = header[3];
+    mDepth     = 1;
+    mMipCount  = ((flags & DDSD_MIPMAPCOUNT) && header[6]) ? header[6] : 1;
+    mArraySize = 1;
+    mCubeMap   = false;
+    mDimension = DIMENSION_2D;
+
+    uint32_t pixelFlags = pPixelFormat[1];
+    uint32_t fourCC     = pPixelFormat[2];
+    if( (pixelFlags & DDPF_FOURCC) && MakeFourCC( 'D', 'X', '1', '0' ) == fourCC )
+    {
+        if( mSize < offset + DDS_HEADER_DX10_SIZE )
+        {
+            return Fail( "Truncated DDS DX10 header" );
+        }
+        const uint8_t *pHeader10 = mpData + offset;
+        offset += DDS_HEADER_DX10_SIZE;
+        if( !SetFormat( ReadUint32( pHeader10 ) ) )
+        {
+            return Fail( "Unsupported DXGI format" );
+        }
+        uint32_t resourceDimension = ReadUint32( pHeader10 + 4 );
+        uint32_t miscFlags         = ReadUint32( pHeader10 + 8 );
+        mArraySize                 = ReadUint32( pHeader10 + 12 );
+        switch( resourceDimension )
+        {
+        case 2: mDimension = DIMENSION_1D; mHeight = 1; break;
+        case 3: mDimension = DIMENSION_2D; break;
+        case 4: mDimension = DIMENSION_3D; mDepth = header[5]; break;
+        default: return Fail( "Bad DDS resource dimension" );
+        }
+        if( miscFlags & DDS_RESOURCE_MISC_CUBE )
+        {
+            if( mArraySize > CPUT_TEXTURE_FILE_MAX_ARRAY_SIZE / 6 )
+            {
+                return Fail( "Bad DDS dimensions" ); // Before multiplying, which could wrap around
+            }
+            mCubeMap    = true;
+            mArraySize *= 6;
+        }
+    }
+    else
+    {
+        uint32_t bitCount = pPixelFormat[3];
+        uint32_t r = pPixelFormat[4], g = pPixelFormat[5], b = pPixelFormat[6], a = pPixelFormat[7];
+        uint32_t format = CPUT_TEXTURE_FORMAT_UNKNOWN;
+        if( pixelFlags & DDPF_FOURCC )
+        {
+            if(      MakeFourCC( 'D', 'X', 'T', '1' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC1_UNORM; }
+            else if( MakeFourCC( 'D', 'X', 'T', '2' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC2_UNORM; }
+            else if( MakeFourCC( 'D', 'X', 'T', '3' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC2_UNORM; }
+            else if( MakeFourCC( 'D', 'X', 'T', '4' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC3_UNORM; }
+            else if( MakeFourCC( 'D', 'X', 'T', '5' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC3_UNORM; }
+            else if( MakeFourCC( 'A', 'T', 'I', '1' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC4_UNORM; }
+            else if( MakeFourCC( 'B', 'C', '4', 'U' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC4_UNORM; }
+            else if( MakeFourCC( 'B', 'C', '4', 'S' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC4_SNORM; }
+            else if( MakeFourCC( 'A', 'T', 'I', '2' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC5_UNORM; }
+            else if( MakeFourCC( 'B', 'C', '5', 'U' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC5_UNORM; }
+            else if( MakeFourCC( 'B', 'C', '5', 'S' ) == fourCC ) { format = CPUT_TEXTURE_FORMAT_BC5_SNORM; }
+            // D3DFORMAT values stored as FourCCs
+            else if( 36  == fourCC ) { format = CPUT_TEXTURE_FORMAT_R16G16B16A16_UNORM; }
+            else if( 111 == fourCC ) { format = CPUT_TEXTURE_FORMAT_R16_FLOAT; }
+            else if( 112 == fourCC ) { format = CPUT_TEXTURE_FORMAT_R16G16_FLOAT; }
+            else if( 113 == fourCC ) { format = CPUT_TEXTURE_FORMAT_R16G16B16A16_FLOAT; }
+            else if( 114 == fourCC ) { format = CPUT_TEXTURE_FORMAT_R32_FLOAT; }
+            else if( 115 == fourCC ) { format = CPUT_TEXTURE_FORMAT_R32G32_FLOAT; }
+            else if( 116 == fourCC ) { format = CPUT_TEXTURE_FORMAT_R32G32B32A32_FLOAT; }
+        }
+        else if( (pixelFlags & DDPF_RGB) && 32 == bitCount )
+        {
+            if(      0x000000FF == r && 0x0000FF00 == g && 0x00FF0000 == b && 0xFF000000 == a ) { format = CPUT_TEXTURE_FORMAT_R8G8B8A8_UNORM; }
+            else if( 0x00FF0000 == r && 0x0000FF00 == g && 0x000000FF == b && 0xFF000000 == a ) { format = CPUT_TEXTURE_FORMAT_B8G8R8A8_UNORM; }
+            else if( 0x00FF0000 == r && 0x0000FF00 == g && 0x000000FF == b && 0          == a ) { format = CPUT_TEXTURE_FORMAT_B8G8R8X8_UNORM; }
+            else if( 0x000003FF == r && 0x000FFC00 == g && 0x3FF00000 == b )                    { format = CPUT_TEXTURE_FORMAT_R10G10B10A2_UNORM; }
+            else if( 0x0000FFFF == r && 0xFFFF0000 == g )                                       { format = CPUT_TEXTURE_FORMAT_R16G16_UNORM; }
+        }
+        else if( (pixelFlags & DDPF_RGB) && 16 == bitCount )
+        {
+            if(      0xF800 == r && 0x07E0 == g && 0x001F == b )                 { format = CPUT_TEXTURE_FORMAT_B5G6R5_UNORM; }
+            else if( 0x7C00 == r && 0x03E0 == g && 0x001F == b && 0x8000 == a )  { format = CPUT_TEXTURE_FORMAT_B5G5R5A1_UNORM; }
+        }
+        else if( pixelFlags & DDPF_LUMINANCE )
+        {
+            if(      8  == bitCount && 0xFF   == r ) { format = CPUT_TEXTURE_FORMAT_R8_UNORM; }
+            else if( 16 == bitCount && 0xFFFF == r ) { format = CPUT_TEXTURE_FORMAT_R16_UNORM; }
+        }
+        else if( (pixelFlags & DDPF_ALPHA) && 8 == bitCount )
+        {
+            format = CPUT_TEXTURE_FORMAT_A8_UNORM;
+        }
+        if( !SetFormat( format ) )
+        {
+            return Fail( "Unsupported DDS pixel format" );
+        }
+        if( caps2 & DDSCAPS2_CUBEMAP )
+        {
+            if( DDSCAPS2_CUBEMAP_ALL != (caps2 & DDSCAPS2_CUBEMAP_ALL) )
+            {
+                return Fail( "Partial cube maps aren't supported" );
+            }
+            mCubeMap   = true;
+            mArraySize = 6;
+        }
+        else if( caps2 & DDSCAPS2_VOLUME )
+        {
+            mDimension = DIMENSION_3D;
+            mDepth     = header[5];
+        }
+    }
+
+    if( 0 == mWidth || 0 == mHeight || 0 == mDepth || 0 == mArraySize ||
+        mWidth > CPUT_TEXTURE_FILE_MAX_SIZE || mHeight > CPUT_TEXTURE_FILE_MAX_SIZE ||
+        mDepth > CPUT_TEXTURE_FILE_MAX_DEPTH || mArraySize > CPUT_TEXTURE_FILE_MAX_ARRAY_SIZE ||
+        (mDimension == DIMENSION_3D && mArraySize > 1) || (mCubeMap && mWidth != mHeight) )
+    {
+        return Fail( "Bad DDS dimensions" );
+    }
+    uint32_t maxDimension = mWidth > mHeight ? mWidth : mHeight;
+    maxDimension = maxDimension > mDepth ? maxDimension : mDepth;
+    if( mMipCount > 32 || (maxDimension >> (mMipCount - 1)) == 0 )
+    {
+        return Fail( "Bad DDS mip count" );
+    }
+
+    // Slice-major: every mip of slice 0, then every mip of slice 1, ...
+    mSubresources.resize( mMipCount * mArraySize );
+    for( uint32_t slice=0; slice<mArraySize; slice++ )
+    {
+        for( uint32_t mip=0; mip<mMipCount; mip++ )
+        {
+            if( !SetSubresource( mip, slice, offset, 1 ) )
+            {
+                return Fail( "Bad DDS dimensions" );
+            }
+            offset += GetSubresource( mip, slice ).mSize;
+        }
+    }
+    if( offset > mSize )
+    {
+        return Fail( "Truncated DDS data" );
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTTextureFile::ParseKTX()
+{
+    if( mSize < KTX_HEADER_SIZE )
+    {
+        return Fail( "Truncated KTX header" );
+    }
+    const uint8_t *pHeader = mpData + sizeof(KTX_IDENTIFIER);
+    if( KTX_ENDIANNESS != ReadUint32( pHeader ) )
+    {
+        return Fail( "Big endian KTX files aren't supported" );
+    }
+    uint32_t internalFormat = ReadUint32( pHeader + 16 );
+    uint32_t pixelWidth     = ReadUint32( pHeader + 24 );
+    uint32_t pixelHeight    = ReadUint32( pHeader + 28 );
+    uint32_t pixelDepth     = ReadUint32( pHeader + 32 );
+    uint32_t arrayElements  = ReadUint32( pHeader + 36 );
+    uint32_t faces          = ReadUint32( pHeader + 40 );
+    uint32_t mipLevels      = ReadUint32( pHeader + 44 );
+    uint32_t keyValueBytes  = ReadUint32( pHeader + 48 );
+
+    uint32_t format = CPUT_TEXTURE_FORMAT_UNKNOWN;
+    switch( internalFormat )
+    {
+    case 0x83F0: // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    case 0x83F1: format = CPUT_TEXTURE_FORMAT_BC1_UNORM;           break; // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+    case 0x83F2: format = CPUT_TEXTURE_FORMAT_BC2_UNORM;           break; // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+    case 0x83F3: format = CPUT_TEXTURE_FORMAT_BC3_UNORM;           break; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    case 0x8C4C: // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+    case 0x8C4D: format = CPUT_TEXTURE_FORMAT_BC1_UNORM_SRGB;      break; // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+    case 0x8C4E: format = CPUT_TEXTURE_FORMAT_BC2_UNORM_SRGB;      break; // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+    case 0x8C4F: format = CPUT_TEXTURE_FORMAT_BC3_UNORM_SRGB;      break; // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+    case 0x8DBB: format = CPUT_TEXTURE_FORMAT_BC4_UNORM;           break; // GL_COMPRESSED_RED_RGTC1
+    case 0x8DBC: format = CPUT_TEXTURE_FORMAT_BC4_SNORM;           break; // GL_COMPRESSED_SIGNED_RED_RGTC1
+    case 0x8DBD: format = CPUT_TEXTURE_FORMAT_BC5_UNORM;           break; // GL_COMPRESSED_RG_RGTC2
+    case 0x8DBE: format = CPUT_TEXTURE_FORMAT_BC5_SNORM;           break; // GL_COMPRESSED_SIGNED_RG_RGTC2
+    case 0x8E8C: format = CPUT_TEXTURE_FORMAT_BC7_UNORM;           break; // GL_COMPRESSED_RGBA_BPTC_UNORM
+    case 0x8E8D: format = CPUT_TEXTURE_FORMAT_BC7_UNORM_SRGB;      break; // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+    case 0x8E8E: format = CPUT_TEXTURE_FORMAT_BC6H_SF16;           break; // GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+    case 0x8E8F: format = CPUT_TEXTURE_FORMAT_BC6H_UF16;           break; // GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+    case 0x8058: format = CPUT_TEXTURE_FORMAT_R8G8B8A8_UNORM;      break; // GL_RGBA8
+    case 0x8C43: format = CPUT_TEXTURE_FORMAT_R8G8B8A8_UNORM_SRGB; break; // GL_SRGB8_ALPHA8
+    case 0x8059: format = CPUT_TEXTURE_FORMAT_R10G10B10A2_UNORM;   break; // GL_RGB10_A2
+    case 0x881A: format = CPUT_TEXTURE_FORMAT_R16G16B16A16_FLOAT;  break; // GL_RGBA16F
+    case 0x8814: format = CPUT_TEXTURE_FORMAT_R32G32B32A32_FLOAT;  break; // GL_RGBA32F
+    case 0x8229: format = CPUT_TEXTURE_FORMAT_R8_UNORM;            break; // GL_R8
+    case 0x822B: format = CPUT_TEXTURE_FORMAT_R8G8_UNORM;          break; // GL_RG8
+    case 0x822A: format = CPUT_TEXTURE_FORMAT_R16_UNORM;           break; // GL_R16
+    case 0x822D: format = CPUT_TEXTURE_FORMAT_R16_FLOAT;           break; // GL_R16F
+    case 0x822F: format = CPUT_TEXTURE_FORMAT_R16G16_FLOAT;        break; // GL_RG16F
+    case 0x822E: format = CPUT_TEXTURE_FORMAT_R32_FLOAT;           break; // GL_R32F
+    case 0x8230: format = CPUT_TEXTURE_FORMAT_R32G32_FLOAT;        break; // GL_RG32F
+    }
+    if( !SetFormat( format ) )
+    {
+        return Fail( "Unsupported KTX internal format" );
+    }
+
+    mWidth     = pixelWidth;
+    mHeight    = pixelHeight ? pixelHeight : 1;
+    mDepth     = pixelDepth  ? pixelDepth  : 1;
+    mDimension = pixelDepth ? DIMENSION_3D : (pixelHeight ? DIMENSION_2D : DIMENSION_1D);
+    mMipCount  = mipLevels ? mipLevels : 1; // 0 asks the loader to generate mips.  We just use the top level.
+    mCubeMap   = 6 == faces;
+    uint32_t elementCount = arrayElements ? arrayElements : 1;
+    if( (1 != faces && 6 != faces) || 0 == mWidth || mWidth > CPUT_TEXTURE_FILE_MAX_SIZE || mHeight > CPUT_TEXTURE_FILE_MAX_SIZE ||
+        mDepth > CPUT_TEXTURE_FILE_MAX_DEPTH || elementCount > CPUT_TEXTURE_FILE_MAX_ARRAY_SIZE / 6 ||
+        (mDimension == DIMENSION_3D && elementCount > 1) || (mCubeMap && (mWidth != mHeight || mDimension != DIMENSION_2D)) )
+    {
+        return Fail( "Bad KTX dimensions" );
+    }
+    mArraySize = elementCount * faces;
+    uint32_t maxDimension = mWidth > mHeight ? mWidth : mHeight;
+    maxDimension = maxDimension > mDepth ? maxDimension : mDepth;
+    if( mMipCount > 32 || (maxDimension >> (mMipCount - 1)) == 0 )
+    {
+        return Fail( "Bad KTX mip count" );
+    }
+
+    // Mip-major: imageSize, then every array element and face of that mip, then padding
+    uint64_t offset = (uint64_t)KTX_HEADER_SIZE + keyValueBytes;
+    bool     cubePadding = mCubeMap && 0 == arrayElements;
+    mSubresources.resize( mMipCount * mArraySize );
+    for( uint32_t mip=0; mip<mMipCount; mip++ )
+    {
+        if( offset + 4 > mSize )
+        {
+            return Fail( "Truncated KTX data" );
+        }
+        uint32_t imageSize = ReadUint32( mpData + offset );
+        offset += 4;
+        uint64_t mipStart = offset;
+        for( uint32_t slice=0; slice<mArraySize; slice++ )
+        {
+            if( !SetSubresource( mip, slice, offset, 4 ) )
+            {
+                return Fail( "Bad KTX dimensions" );
+            }
+            offset += GetSubresource( mip, slice ).mSize;
+            if( cubePadding )
+            {
+                offset = (offset + 3) & ~3ull;
+            }
+        }
+        // Non-array cube maps store the size of one face
+        uint64_t expectedSize = cubePadding ? GetSubresource( mip, 0 ).mSize : offset - mipStart;
+        if( imageSize != expectedSize )
+        {
+            return Fail( "KTX imageSize doesn't match the format and dimensions" );
+        }
+        offset = (offset + 3) & ~3ull;
+    }
+    if( offset > mSize )
+    {
+        return Fail( "Truncated KTX data" );
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTTextureFile::GetMipSize( uint32_t mip ) const
+{
+    uint64_t size = 0;
+    for( uint32_t slice=0; slice<mArraySize; slice++ )
+    {
+        size += GetSubresource( mip, slice ).mSize;
+    }
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureFile::CopyMip( uint32_t mip, uint8_t *pDest ) const
+{
+    for( uint32_t slice=0; slice<mArraySize; slice++ )
+    {
+        const CPUTTextureSubresource &subresource = GetSubresource( mip, slice );
+        memcpy( pDest, mpData + subresource.mOffset, subresource.mSize );
+        pDest += subresource.mSize;
+    }
+}
@@ -0,0 +1,174 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTEXTUREFILE_H__
+#define __CPUTTEXTUREFILE_H__
+
+// Platform-neutral reader for DDS (legacy and DX10 headers) and KTX 1.1 texture
+// containers.  The file is memory-mapped; parsing only reads the header and computes
+// where every subresource (mip level of an array slice or cube face) lives in the
+// mapping, so nothing is copied until the caller asks for it.
+//
+// Formats are reported as DXGI_FORMAT values.  Only formats with a fixed block or
+// pixel size are accepted (BC1-7 and the common uncompressed ones); anything else
+// fails to parse and the caller should fall back to another loader.
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#   include <windows.h>
+#endif
+
+// The DXGI_FORMAT values the parser produces (same numbers, so they cast directly)
+enum CPUT_TEXTURE_FORMAT
+{
+    CPUT_TEXTURE_FORMAT_UNKNOWN             = 0,
+    CPUT_TEXTURE_FORMAT_R32G32B32A32_FLOAT  = 2,
+    CPUT_TEXTURE_FORMAT_R16G16B16A16_FLOAT  = 10,
+    CPUT_TEXTURE_FORMAT_R16G16B16A16_UNORM  = 11,
+    CPUT_TEXTURE_FORMAT_R32G32_FLOAT        = 16,
+    CPUT_TEXTURE_FORMAT_R10G10B10A2_UNORM   = 24,
+    CPUT_TEXTURE_FORMAT_R8G8B8A8_UNORM      = 28,
+    CPUT_TEXTURE_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+    CPUT_TEXTURE_FORMAT_R16G16_FLOAT        = 34,
+    CPUT_TEXTURE_FORMAT_R16G16_UNORM        = 35,
+    CPUT_TEXTURE_FORMAT_R32_FLOAT           = 41,
+    CPUT_TEXTURE_FORMAT_R8G8_UNORM          = 49,
+    CPUT_TEXTURE_FORMAT_R16_FLOAT           = 54,
+    CPUT_TEXTURE_FORMAT_R16_UNORM           = 56,
+    CPUT_TEXTURE_FORMAT_R8_UNORM            = 61,
+    CPUT_TEXTURE_FORMAT_A8_UNORM            = 65,
+    CPUT_TEXTURE_FORMAT_BC1_UNORM           = 71,
+    CPUT_TEXTURE_FORMAT_BC1_UNORM_SRGB      = 72,
+    CPUT_TEXTURE_FORMAT_BC2_UNORM           = 74,
+    CPUT_TEXTURE_FORMAT_BC2_UNORM_SRGB      = 75,
+    CPUT_TEXTURE_FORMAT_BC3_UNORM           = 77,
+    CPUT_TEXTURE_FORMAT_BC3_UNORM_SRGB      = 78,
+    CPUT_TEXTURE_FORMAT_BC4_UNORM           = 80,
+    CPUT_TEXTURE_FORMAT_BC4_SNORM           = 81,
+    CPUT_TEXTURE_FORMAT_BC5_UNORM           = 83,
+    CPUT_TEXTURE_FORMAT_BC5_SNORM           = 84,
+    CPUT_TEXTURE_FORMAT_B5G6R5_UNORM        = 85,
+    CPUT_TEXTURE_FORMAT_B5G5R5A1_UNORM      = 86,
+    CPUT_TEXTURE_FORMAT_B8G8R8A8_UNORM      = 87,
+    CPUT_TEXTURE_FORMAT_B8G8R8X8_UNORM      = 88,
+    CPUT_TEXTURE_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+    CPUT_TEXTURE_FORMAT_B8G8R8X8_UNORM_SRGB = 93,
+    CPUT_TEXTURE_FORMAT_BC6H_UF16           = 95,
+    CPUT_TEXTURE_FORMAT_BC6H_SF16           = 96,
+    CPUT_TEXTURE_FORMAT_BC7_UNORM           = 98,
+    CPUT_TEXTURE_FORMAT_BC7_UNORM_SRGB      = 99,
+};
+
+// Bytes per 4x4 block for block-compressed formats, else bytes per pixel.  0 if unsupported.
+uint32_t CPUTGetTextureFormatBlockSize( uint32_t format, bool *pCompressed );
+
+//-----------------------------------------------------------------------------
+class CPUTMappedFile
+{
+protected:
+    const uint8_t *mpData;
+    uint64_t       mSize;
+#ifdef _WIN32
+    HANDLE         mFile;
+    HANDLE         mMapping;
+#endif
+
+public:
+    CPUTMappedFile();
+    ~CPUTMappedFile() { Close(); }
+
+    bool           Open( const std::string &fileName ); // Read only
+    void           Close();
+    const uint8_t *GetData() const { return mpData; }
+    uint64_t       GetSize() const { return mSize; }
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTTextureSubresource
+{
+    uint64_t mOffset;     // From the start of the file
+    uint32_t mSize;       // Bytes, all depth slices
+    uint32_t mRowPitch;   // Bytes per row of pixels (or of 4x4 blocks)
+    uint32_t mSlicePitch; // Bytes per depth slice
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mDepth;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTTextureFile
+{
+public:
+    enum CONTAINER   { CONTAINER_DDS, CONTAINER_KTX };
+    enum DIMENSION   { DIMENSION_1D = 1, DIMENSION_2D, DIMENSION_3D };
+
+protected:
+    CPUTMappedFile                       mFile;
+    const uint8_t                       *mpData;     // The mapping, or the caller's buffer passed to Parse()
+    uint64_t                             mSize;
+    CONTAINER                            mContainer;
+    DIMENSION                            mDimension;
+    uint32_t                             mFormat;
+    uint32_t                             mWidth;
+    uint32_t                             mHeight;
+    uint32_t                             mDepth;
+    uint32_t                             mMipCount;
+    uint32_t                             mArraySize;  // Including cube faces (6 per cube)
+    bool                                 mCubeMap;
+    std::vector<CPUTTextureSubresource>  mSubresources; // Indexed like D3D11: mip + slice * mipCount
+    std::string                          mError;
+
+    bool Fail( const char *pError ) { mError = pError; mSubresources.clear(); return false; }
+    bool SetFormat( uint32_t format );
+    bool ParseDDS();
+    bool ParseKTX();
+    bool SetSubresource( uint32_t mip, uint32_t slice, uint64_t offset, uint32_t rowAlignment ); // false if it doesn't fit in 32 bits
+
+public:
+    CPUTTextureFile();
+
+    // Maps the file and parses it.  On failure, GetError() says why.
+    bool Open( const std::string &fileName );
+
+    // Parses a DDS or KTX image already in memory.  The buffer must outlive this object.
+    bool Parse( const uint8_t *pData, uint64_t size );
+
+    // True if the name ends in .dds or .ktx (case insensitive)
+    static bool HasTextureFileExtension( const std::string &fileName );
+
+    CONTAINER   GetContainer() const  { return mContainer; }
+    DIMENSION   GetDimension() const  { return mDimension; }
+    uint32_t    GetFormat() const     { return mFormat; }
+    uint32_t    GetWidth() const      { return mWidth; }
+    uint32_t    GetHeight() const     { return mHeight; }
+    uint32_t    GetDepth() const      { return mDepth; }
+    uint32_t    GetMipCount() const   { return mMipCount; }
+    uint32_t    GetArraySize() const  { return mArraySize; }
+    bool        IsCubeMap() const     { return mCubeMap; }
+    const char *GetError() const      { return mError.c_str(); }
+
+    const CPUTTextureSubresource &GetSubresource( uint32_t mip, uint32_t slice ) const { return mSubresources[mip + slice * mMipCount]; }
+    const uint8_t                *GetSubresourceData( uint32_t mip, uint32_t slice ) const { return mpData + GetSubresource( mip, slice ).mOffset; }
+
+    // Bytes of one mip level, summed over all array slices
+    uint64_t GetMipSize( uint32_t mip ) const;
+
+    // Copies one mip level of every array slice, slice after slice, to pDest (GetMipSize() bytes)
+    void CopyMip( uint32_t mip, uint8_t *pDest ) const;
+};
+
+#endif // __CPUTTEXTUREFILE_H__
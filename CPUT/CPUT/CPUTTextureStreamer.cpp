@@ -0,0 +1,434 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTextureStreamer.h"
+#include "CPUTProfiler.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#   define STREAMER_LOCK()      EnterCriticalSection( &mLock )
+#   define STREAMER_UNLOCK()    LeaveCriticalSection( &mLock )
+#   define STREAMER_WAIT()      SleepConditionVariableCS( &mWake, &mLock, INFINITE )
+#   define STREAMER_SIGNAL()    WakeConditionVariable( &mWake )
+#else
+#   define STREAMER_LOCK()      pthread_mutex_lock( &mLock )
+#   define STREAMER_UNLOCK()    pthread_mutex_unlock( &mLock )
+#   define STREAMER_WAIT()      pthread_cond_wait( &mWake, &mLock )
+#   define STREAMER_SIGNAL()    pthread_cond_signal( &mWake )
+#endif
+
+const uint32_t CPUT_TEXTURE_STREAMING_MAX_MIPS = 32;
+
+// Orders load candidates: highest priority first, then the blurriest (largest top mip)
+//-----------------------------------------------------------------------------
+struct CPUTStreamingCandidateOrder
+{
+    float    mPriority;
+    uint32_t mTopMip;
+    uint32_t mHandle;
+
+    bool operator<( const CPUTStreamingCandidateOrder &other ) const
+    {
+        if( mPriority != other.mPriority ) { return mPriority > other.mPriority; }
+        if( mTopMip   != other.mTopMip )   { return mTopMip   > other.mTopMip; }
+        return mHandle < other.mHandle;
+    }
+};
+
+//-----------------------------------------------------------------------------
+static uint64_t GetResidentSize( const CPUTTextureFile &file, uint32_t topMip )
+{
+    uint64_t size = 0;
+    for( uint32_t mip=topMip; mip<file.GetMipCount(); mip++ )
+    {
+        size += file.GetMipSize( mip );
+    }
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureStreamer::CPUTTextureStreamer( bool useThread ) :
+    mLoadsInFlight(0),
+    mMaxLoadsInFlight(4),
+    mBudget(CPUT_TEXTURE_STREAMING_DEFAULT_BUDGET),
+    mTailSize(CPUT_TEXTURE_STREAMING_TAIL_SIZE),
+    mUseThread(useThread),
+    mQuit(false)
+{
+#ifdef _WIN32
+    InitializeCriticalSection( &mLock );
+    InitializeConditionVariable( &mWake );
+    mThread = mUseThread ? CreateThread( NULL, 0, LoaderEntry, this, 0, NULL ) : NULL;
+#else
+    pthread_mutex_init( &mLock, NULL );
+    pthread_cond_init( &mWake, NULL );
+    if( mUseThread )
+    {
+        pthread_create( &mThread, NULL, LoaderEntry, this );
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureStreamer::~CPUTTextureStreamer()
+{
+    STREAMER_LOCK();
+    mQuit = true;
+    STREAMER_SIGNAL();
+    STREAMER_UNLOCK();
+    if( mUseThread )
+    {
+#ifdef _WIN32
+        WaitForSingleObject( mThread, INFINITE );
+        CloseHandle( mThread );
+#else
+        pthread_join( mThread, NULL );
+#endif
+    }
+#ifdef _WIN32
+    DeleteCriticalSection( &mLock );
+#else
+    pthread_cond_destroy( &mWake );
+    pthread_mutex_destroy( &mLock );
+#endif
+
+    for( size_t ii=0; ii<mRequests.size(); ii++ )  { delete mRequests[ii]; }
+    for( size_t ii=0; ii<mCompleted.size(); ii++ ) { delete mCompleted[ii]; }
+    for( size_t ii=0; ii<mEntries.size(); ii++ )   { delete mEntries[ii].mpFile; }
+}
+
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+DWORD WINAPI CPUTTextureStreamer::LoaderEntry( void *pStreamer )
+{
+    ((CPUTTextureStreamer*)pStreamer)->LoaderLoop();
+    return 0;
+}
+#else
+void *CPUTTextureStreamer::LoaderEntry( void *pStreamer )
+{
+    ((CPUTTextureStreamer*)pStreamer)->LoaderLoop();
+    return NULL;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+void CPUTTextureStreamer::LoaderLoop()
+{
+    CPUT_PROFILE_THREAD_NAME("Texture loader");
+    for(;;)
+    {
+        STREAMER_LOCK();
+        while( mRequests.empty() && !mQuit )
+        {
+            STREAMER_WAIT();
+        }
+        if( mQuit )
+        {
+            STREAMER_UNLOCK();
+            return;
+        }
+        Load *pLoad = TakeRequest();
+        STREAMER_UNLOCK();
+
+        // This is where the file is actually read: the copy faults in the mapped pages
+        {
+            CPUT_PROFILE_ZONE("Load mip");
+            pLoad->mData.resize( (size_t)pLoad->mpFile->GetMipSize( pLoad->mMip ) );
+            pLoad->mpFile->CopyMip( pLoad->mMip, &pLoad->mData[0] );
+        }
+
+        STREAMER_LOCK();
+        mCompleted.push_back( pLoad );
+        STREAMER_UNLOCK();
+    }
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureStreamer::Load *CPUTTextureStreamer::TakeRequest()
+{
+    if( mRequests.empty() )
+    {
+        return NULL;
+    }
+    size_t best = 0;
+    for( size_t ii=1; ii<mRequests.size(); ii++ )
+    {
+        if( mRequests[ii]->mPriority > mRequests[best]->mPriority )
+        {
+            best = ii;
+        }
+    }
+    Load *pLoad = mRequests[best];
+    mRequests.erase( mRequests.begin() + best );
+    return pLoad;
+}
+
+//-----------------------------------------------------------------------------
+CPUTStreamingHandle CPUTTextureStreamer::Register( CPUTStreamedTexture *pTexture, CPUTTextureFile *pFile, float priority )
+{
+    uint32_t mipCount = pFile->GetMipCount();
+    uint32_t tailMip  = mipCount - 1;
+    while( tailMip > 0 ) // CPUTTextureFile limits mipCount to CPUT_TEXTURE_STREAMING_MAX_MIPS
+    {
+        const CPUTTextureSubresource &next = pFile->GetSubresource( tailMip - 1, 0 );
+        if( next.mWidth > mTailSize || next.mHeight > mTailSize )
+        {
+            break;
+        }
+        tailMip--;
+    }
+
+    // The tail is small, so it is copied right here
+    std::vector<uint8_t> tail( (size_t)GetResidentSize( *pFile, tailMip ) );
+    const uint8_t *pMipData[CPUT_TEXTURE_STREAMING_MAX_MIPS];
+    uint8_t *pDest = &tail[0];
+    for( uint32_t mip=tailMip; mip<mipCount; mip++ )
+    {
+        pMipData[mip - tailMip] = pDest;
+        pFile->CopyMip( mip, pDest );
+        pDest += pFile->GetMipSize( mip );
+    }
+    if( !pTexture->SetResidentMips( *pFile, tailMip, pMipData ) )
+    {
+        delete pFile;
+        return CPUT_INVALID_STREAMING_HANDLE;
+    }
+
+    CPUTStreamingHandle handle;
+    if( mFreeHandles.empty() )
+    {
+        handle = (CPUTStreamingHandle)mEntries.size();
+        mEntries.resize( mEntries.size() + 1 );
+    }
+    else
+    {
+        handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+    }
+    Entry &entry     = mEntries[handle];
+    entry.mpTexture  = pTexture;
+    entry.mpFile     = pFile;
+    entry.mPriority  = priority;
+    entry.mTailMip   = tailMip;
+    entry.mTopMip    = tailMip;
+    entry.mLoading   = false;
+
+    mStats.mTextures++;
+    mStats.mResidentBytes += tail.size();
+    return handle;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureStreamer::Unregister( CPUTStreamingHandle handle )
+{
+    Entry &entry = mEntries[handle];
+    mStats.mTextures--;
+    mStats.mResidentBytes -= GetResidentSize( *entry.mpFile, entry.mTopMip );
+    entry.mpTexture = NULL;
+
+    // A load in flight still reads the file.  ApplyCompletedLoads() frees the entry when it's done.
+    if( !entry.mLoading )
+    {
+        FreeEntry( handle );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureStreamer::FreeEntry( CPUTStreamingHandle handle )
+{
+    Entry &entry = mEntries[handle];
+    delete entry.mpFile;
+    entry.mpFile = NULL;
+    mFreeHandles.push_back( handle );
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTTextureStreamer::Update()
+{
+    mChanged.clear();
+    uint32_t changeCount = ApplyCompletedLoads();
+    changeCount += ScheduleLoads();
+    if( !mUseThread )
+    {
+        STREAMER_LOCK();
+        for( Load *pLoad = TakeRequest(); pLoad; pLoad = TakeRequest() )
+        {
+            pLoad->mData.resize( (size_t)pLoad->mpFile->GetMipSize( pLoad->mMip ) );
+            pLoad->mpFile->CopyMip( pLoad->mMip, &pLoad->mData[0] );
+            mCompleted.push_back( pLoad );
+        }
+        STREAMER_UNLOCK();
+        changeCount += ApplyCompletedLoads();
+    }
+    std::sort( mChanged.begin(), mChanged.end() );
+    mChanged.erase( std::unique( mChanged.begin(), mChanged.end() ), mChanged.end() );
+    return changeCount;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTTextureStreamer::ApplyCompletedLoads()
+{
+    std::vector<Load*> completed;
+    STREAMER_LOCK();
+    completed.swap( mCompleted );
+    STREAMER_UNLOCK();
+
+    uint32_t changeCount = 0;
+    for( size_t ii=0; ii<completed.size(); ii++ )
+    {
+        Load  *pLoad = completed[ii];
+        Entry &entry = mEntries[pLoad->mHandle];
+        mLoadsInFlight--;
+        mStats.mPendingBytes -= pLoad->mData.size();
+        entry.mLoading = false;
+
+        if( !entry.mpTexture )
+        {
+            FreeEntry( pLoad->mHandle ); // Unregistered while loading
+        }
+        else
+        {
+            // Textures with a load in flight are never evicted, so this is always the next level up
+            const uint8_t *pMipData[CPUT_TEXTURE_STREAMING_MAX_MIPS] = { 0 };
+            pMipData[0] = &pLoad->mData[0];
+            if( pLoad->mMip + 1 == entry.mTopMip && entry.mpTexture->SetResidentMips( *entry.mpFile, pLoad->mMip, pMipData ) )
+            {
+                entry.mTopMip = pLoad->mMip;
+                mStats.mResidentBytes += pLoad->mData.size();
+                mStats.mBytesLoaded   += pLoad->mData.size();
+                mStats.mLoads++;
+                mChanged.push_back( entry.mpTexture );
+                changeCount++;
+            }
+        }
+        delete pLoad;
+    }
+    return changeCount;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTTextureStreamer::ScheduleLoads()
+{
+    std::vector<CPUTStreamingCandidateOrder> candidates;
+    for( uint32_t ii=0; ii<mEntries.size(); ii++ )
+    {
+        const Entry &entry = mEntries[ii];
+        if( entry.mpTexture && !entry.mLoading && entry.mTopMip > 0 && entry.mPriority > 0.0f )
+        {
+            CPUTStreamingCandidateOrder candidate = { entry.mPriority, entry.mTopMip, ii };
+            candidates.push_back( candidate );
+        }
+    }
+    std::sort( candidates.begin(), candidates.end() );
+
+    uint32_t changeCount = 0;
+    std::vector<Load*> requests;
+    for( size_t ii=0; ii<candidates.size() && mLoadsInFlight < mMaxLoadsInFlight; ii++ )
+    {
+        CPUTStreamingHandle handle = candidates[ii].mHandle;
+        Entry   &entry = mEntries[handle];
+        uint32_t mip   = entry.mTopMip - 1;
+        uint64_t size  = entry.mpFile->GetMipSize( mip );
+        if( mStats.mResidentBytes + mStats.mPendingBytes + size > mBudget &&
+            !EvictFor( entry.mPriority, mip, size, handle, &changeCount ) )
+        {
+            // Everything after this has the same or lower priority, so it wouldn't fit either
+            mStats.mBudgetStalls++;
+            break;
+        }
+        Load *pLoad      = new Load();
+        pLoad->mHandle   = handle;
+        pLoad->mMip      = mip;
+        pLoad->mPriority = entry.mPriority;
+        pLoad->mpFile    = entry.mpFile;
+        requests.push_back( pLoad );
+
+        entry.mLoading = true;
+        mStats.mPendingBytes += size;
+        mLoadsInFlight++;
+    }
+
+    if( !requests.empty() )
+    {
+        STREAMER_LOCK();
+        mRequests.insert( mRequests.end(), requests.begin(), requests.end() );
+        STREAMER_SIGNAL();
+        STREAMER_UNLOCK();
+    }
+    return changeCount;
+}
+
+// Evicts the most detailed levels of other textures until size more bytes fit.  A
+// texture can lose a level if its priority is lower, or if it is equal and the texture
+// would still be more detailed than the one being loaded (so equal priorities converge
+// instead of trading the same level back and forth).  The victims are all picked before
+// any is evicted, so that nothing is dropped for a load that still wouldn't fit.
+//-----------------------------------------------------------------------------
+bool CPUTTextureStreamer::EvictFor( float priority, uint32_t mip, uint64_t size, CPUTStreamingHandle except, uint32_t *pChangeCount )
+{
+    std::vector<uint32_t> topMips( mEntries.size() );
+    for( uint32_t ii=0; ii<mEntries.size(); ii++ )
+    {
+        topMips[ii] = mEntries[ii].mTopMip;
+    }
+    std::vector<CPUTStreamingHandle> victims;
+    uint64_t used = mStats.mResidentBytes + mStats.mPendingBytes;
+    while( used + size > mBudget )
+    {
+        CPUTStreamingHandle victim = CPUT_INVALID_STREAMING_HANDLE;
+        for( uint32_t ii=0; ii<mEntries.size(); ii++ )
+        {
+            const Entry &entry = mEntries[ii];
+            if( !entry.mpTexture || entry.mLoading || ii == except || topMips[ii] >= entry.mTailMip )
+            {
+                continue;
+            }
+            if( entry.mPriority > priority || (entry.mPriority == priority && topMips[ii] + 1 > mip) )
+            {
+                continue;
+            }
+            if( CPUT_INVALID_STREAMING_HANDLE == victim ||
+                entry.mPriority < mEntries[victim].mPriority ||
+                (entry.mPriority == mEntries[victim].mPriority && topMips[ii] < topMips[victim]) )
+            {
+                victim = ii;
+            }
+        }
+        if( CPUT_INVALID_STREAMING_HANDLE == victim )
+        {
+            return false;
+        }
+        used -= mEntries[victim].mpFile->GetMipSize( topMips[victim] );
+        topMips[victim]++;
+        victims.push_back( victim );
+    }
+
+    for( size_t ii=0; ii<victims.size(); ii++ )
+    {
+        Entry &entry = mEntries[victims[ii]];
+        const uint8_t *pNoData[CPUT_TEXTURE_STREAMING_MAX_MIPS] = { 0 };
+        if( !entry.mpTexture->SetResidentMips( *entry.mpFile, entry.mTopMip + 1, pNoData ) )
+        {
+            return false;
+        }
+        mStats.mResidentBytes -= entry.mpFile->GetMipSize( entry.mTopMip );
+        mStats.mEvictions++;
+        entry.mTopMip++;
+        mChanged.push_back( entry.mpTexture );
+        (*pChangeCount)++;
+    }
+    return true;
+}
@@ -0,0 +1,162 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTEXTURESTREAMER_H__
+#define __CPUTTEXTURESTREAMER_H__
+
+// Mip streaming for textures read with CPUTTextureFile.
+//
+// Register() makes the mip tail (every level no larger than the tail size) resident
+// straight away, so a texture is usable as soon as it is created.  Higher mips are then
+// copied out of the file on a background thread, one level per texture at a time:
+// highest priority first and, between textures of equal priority, the blurriest first.
+// Update() (called once a frame, on the thread that owns the graphics device) hands
+// finished levels to the texture and schedules more.
+//
+// Resident plus in-flight bytes are kept under a budget.  When a load doesn't fit,
+// the most detailed level of a lower priority texture is evicted; if there is none the
+// load waits.  Tails are never evicted, so they can exceed the budget.
+#include "CPUTTextureFile.h"
+#include <stdint.h>
+#include <vector>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#endif
+
+// Mips up to this size (in both dimensions) are loaded by Register()
+const uint32_t CPUT_TEXTURE_STREAMING_TAIL_SIZE      = 64;
+const uint64_t CPUT_TEXTURE_STREAMING_DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+typedef uint32_t CPUTStreamingHandle;
+const CPUTStreamingHandle CPUT_INVALID_STREAMING_HANDLE = 0xFFFFFFFF;
+
+//-----------------------------------------------------------------------------
+class CPUTStreamedTexture
+{
+protected:
+    virtual ~CPUTStreamedTexture() {} // The streamer never deletes textures
+
+public:
+    // Makes mips [topMip, file.GetMipCount()) resident.  ppMipData[mip - topMip] is a new
+    // level (laid out by CPUTTextureFile::CopyMip()), or NULL for a level that is already
+    // resident and must be kept.  Evicting passes a larger topMip and no data.  Return
+    // false if the texture can't be changed; the previous levels then stay resident.
+    // Only called from CPUTTextureStreamer::Register() and Update().
+    virtual bool SetResidentMips( const CPUTTextureFile &file, uint32_t topMip, const uint8_t *const *ppMipData ) = 0;
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTTextureStreamerStats
+{
+    uint32_t mTextures;
+    uint64_t mResidentBytes;
+    uint64_t mPendingBytes;    // Scheduled or being copied
+    uint32_t mLoads;           // Levels made resident by Update()
+    uint64_t mBytesLoaded;
+    uint32_t mEvictions;       // Levels dropped to stay under the budget
+    uint32_t mBudgetStalls;    // Update()s that left a load unscheduled for lack of budget
+
+    CPUTTextureStreamerStats() { mTextures = 0; mResidentBytes = mPendingBytes = mBytesLoaded = 0; mLoads = mEvictions = mBudgetStalls = 0; }
+};
+
+//-----------------------------------------------------------------------------
+class CPUTTextureStreamer
+{
+protected:
+    struct Entry
+    {
+        CPUTStreamedTexture *mpTexture;   // NULL if the slot is free or unregistered
+        CPUTTextureFile     *mpFile;      // Owned
+        float                mPriority;
+        uint32_t             mTailMip;    // Most detailed level of the tail
+        uint32_t             mTopMip;     // Most detailed resident level
+        bool                 mLoading;    // Level mTopMip-1 is scheduled or being copied
+    };
+    struct Load
+    {
+        CPUTStreamingHandle   mHandle;
+        uint32_t              mMip;
+        float                 mPriority;
+        const CPUTTextureFile *mpFile;
+        std::vector<uint8_t>  mData;
+    };
+
+    std::vector<Entry>                mEntries;      // Indexed by handle.  Only touched by the Update() thread.
+    std::vector<CPUTStreamingHandle>  mFreeHandles;
+    std::vector<Load*>                mRequests;     // Shared with the loader thread
+    std::vector<Load*>                mCompleted;    // Shared with the loader thread
+    std::vector<CPUTStreamedTexture*> mChanged;      // Textures whose resident mips changed in the last Update()
+    uint32_t                          mLoadsInFlight;
+    uint32_t                          mMaxLoadsInFlight;
+    uint64_t                          mBudget;
+    uint32_t                          mTailSize;
+    bool                              mUseThread;
+    bool                              mQuit;
+    CPUTTextureStreamerStats          mStats;
+
+#ifdef _WIN32
+    HANDLE                            mThread;
+    CRITICAL_SECTION                  mLock;
+    CONDITION_VARIABLE                mWake;
+    static DWORD WINAPI               LoaderEntry( void *pStreamer );
+#else
+    pthread_t                         mThread;
+    pthread_mutex_t                   mLock;
+    pthread_cond_t                    mWake;
+    static void                      *LoaderEntry( void *pStreamer );
+#endif
+
+    void     LoaderLoop();
+    Load    *TakeRequest();                 // Highest priority request, or NULL.  Call with mLock held.
+    uint32_t ApplyCompletedLoads();
+    uint32_t ScheduleLoads();
+    bool     EvictFor( float priority, uint32_t mip, uint64_t size, CPUTStreamingHandle except, uint32_t *pChangeCount );
+    void     FreeEntry( CPUTStreamingHandle handle );
+
+public:
+    // useThread == false copies scheduled levels inside Update() instead (deterministic, for testing)
+    CPUTTextureStreamer( bool useThread = true );
+    ~CPUTTextureStreamer();
+
+    // Takes ownership of pFile, and makes the mip tail resident through pTexture.
+    // Returns CPUT_INVALID_STREAMING_HANDLE (and deletes pFile) if the texture rejected it.
+    CPUTStreamingHandle Register( CPUTStreamedTexture *pTexture, CPUTTextureFile *pFile, float priority = 1.0f );
+    void                Unregister( CPUTStreamingHandle handle );
+
+    // Higher streams first.  0 or less never streams beyond the tail.
+    void                SetPriority( CPUTStreamingHandle handle, float priority ) { mEntries[handle].mPriority = priority; }
+    uint32_t            GetTopMip( CPUTStreamingHandle handle ) const            { return mEntries[handle].mTopMip; }
+
+    void                SetBudget( uint64_t bytes )           { mBudget = bytes; }
+    uint64_t            GetBudget() const                     { return mBudget; }
+    void                SetTailSize( uint32_t size )          { mTailSize = size; }   // Affects later Register() calls
+    void                SetMaxLoadsInFlight( uint32_t count ) { mMaxLoadsInFlight = count ? count : 1; }
+
+    // Applies finished loads and schedules new ones.  Returns how many times a texture's
+    // resident mips changed; if not 0, callers holding views of the textures must rebind them.
+    uint32_t Update();
+    bool     IsIdle() const { return 0 == mLoadsInFlight; }
+
+    // The textures that changed in the last Update(), sorted by address with no duplicates.
+    // Only these need rebinding.
+    const std::vector<CPUTStreamedTexture*> &GetChangedTextures() const { return mChanged; }
+
+    const CPUTTextureStreamerStats &GetStats() const { return mStats; }
+};
+
+#endif // __CPUTTEXTURESTREAMER_H__
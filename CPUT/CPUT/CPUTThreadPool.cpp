@@ -0,0 +1,216 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTThreadPool.h"
+#include "CPUTProfiler.h"
+#include <assert.h>
+
+#ifdef _WIN32
+#   define POOL_LOCK(pool)          EnterCriticalSection( &(pool)->mLock )
+#   define POOL_UNLOCK(pool)        LeaveCriticalSection( &(pool)->mLock )
+#   define POOL_WAIT(pool, cond)    SleepConditionVariableCS( &(pool)->cond, &(pool)->mLock, INFINITE )
+#   define POOL_SIGNAL_ALL(cond)    WakeAllConditionVariable( &cond )
+#   define POOL_SIGNAL(cond)        WakeConditionVariable( &cond )
+#   define POOL_NEXT_TASK(pool)     ((uint32_t)InterlockedIncrement( &(pool)->mNextTask ) - 1)
+#else
+#   include <unistd.h>
+#   define POOL_LOCK(pool)          pthread_mutex_lock( &(pool)->mLock )
+#   define POOL_UNLOCK(pool)        pthread_mutex_unlock( &(pool)->mLock )
+#   define POOL_WAIT(pool, cond)    pthread_cond_wait( &(pool)->cond, &(pool)->mLock )
+#   define POOL_SIGNAL_ALL(cond)    pthread_cond_broadcast( &cond )
+#   define POOL_SIGNAL(cond)        pthread_cond_signal( &cond )
+#   define POOL_NEXT_TASK(pool)     ((uint32_t)__sync_fetch_and_add( &(pool)->mNextTask, 1 ))
+#endif
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTThreadPool::GetHardwareThreadCount()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return info.dwNumberOfProcessors ? (uint32_t)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return count > 0 ? (uint32_t)count : 1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+CPUTThreadPool::CPUTThreadPool( uint32_t workerCount ) :
+    mWorkerCount(workerCount),
+    mpWorkerStart(NULL),
+    mpTask(NULL),
+    mTaskCount(0),
+    mNextTask(0),
+    mActiveWorkers(0),
+    mGeneration(0),
+    mQuit(false),
+    mpThreads(NULL)
+{
+    if( 0 == mWorkerCount )
+    {
+        mWorkerCount = GetHardwareThreadCount() - 1;
+    }
+#ifdef _WIN32
+    InitializeCriticalSection( &mLock );
+    InitializeConditionVariable( &mWake );
+    InitializeConditionVariable( &mDone );
+    mpThreads = new HANDLE[mWorkerCount + 1];
+#else
+    pthread_mutex_init( &mLock, NULL );
+    pthread_cond_init( &mWake, NULL );
+    pthread_cond_init( &mDone, NULL );
+    mpThreads = new pthread_t[mWorkerCount + 1];
+#endif
+    mpWorkerStart = new WorkerStart[mWorkerCount + 1];
+    for( uint32_t ii=0; ii<mWorkerCount; ii++ )
+    {
+        mpWorkerStart[ii].mpPool       = this;
+        mpWorkerStart[ii].mThreadIndex = ii + 1;
+#ifdef _WIN32
+        mpThreads[ii] = CreateThread( NULL, 0, WorkerEntry, &mpWorkerStart[ii], 0, NULL );
+#else
+        pthread_create( &mpThreads[ii], NULL, WorkerEntry, &mpWorkerStart[ii] );
+#endif
+    }
+}
+
+//-----------------------------------------------------------------------------
+CPUTThreadPool::~CPUTThreadPool()
+{
+    POOL_LOCK(this);
+    mQuit = true;
+    POOL_SIGNAL_ALL(mWake);
+    POOL_UNLOCK(this);
+
+    for( uint32_t ii=0; ii<mWorkerCount; ii++ )
+    {
+#ifdef _WIN32
+        WaitForSingleObject( mpThreads[ii], INFINITE );
+        CloseHandle( mpThreads[ii] );
+#else
+        pthread_join( mpThreads[ii], NULL );
+#endif
+    }
+#ifdef _WIN32
+    DeleteCriticalSection( &mLock );
+#else
+    pthread_cond_destroy( &mDone );
+    pthread_cond_destroy( &mWake );
+    pthread_mutex_destroy( &mLock );
+#endif
+    delete [] mpThreads;
+    delete [] mpWorkerStart;
+}
+
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+DWORD WINAPI CPUTThreadPool::WorkerEntry( void *pStart )
+{
+    WorkerStart *pWorkerStart = (WorkerStart*)pStart;
+    pWorkerStart->mpPool->WorkerLoop( pWorkerStart->mThreadIndex );
+    return 0;
+}
+#else
+void *CPUTThreadPool::WorkerEntry( void *pStart )
+{
+    WorkerStart *pWorkerStart = (WorkerStart*)pStart;
+    pWorkerStart->mpPool->WorkerLoop( pWorkerStart->mThreadIndex );
+    return NULL;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+void CPUTThreadPool::WorkerLoop( uint32_t threadIndex )
+{
+    CPUT_PROFILE_THREAD_NAME("Thread pool worker");
+    uint32_t generation = 0;
+    for(;;)
+    {
+        POOL_LOCK(this);
+        while( generation == mGeneration && !mQuit )
+        {
+            POOL_WAIT(this, mWake);
+        }
+        generation = mGeneration;
+        bool quit  = mQuit;
+        POOL_UNLOCK(this);
+        if( quit )
+        {
+            return;
+        }
+
+        RunTasks( threadIndex );
+
+        POOL_LOCK(this);
+        if( 0 == --mActiveWorkers )
+        {
+            POOL_SIGNAL(mDone);
+        }
+        POOL_UNLOCK(this);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTThreadPool::RunTasks( uint32_t threadIndex )
+{
+    CPUT_PROFILE_ZONE("Tasks");
+    for(;;)
+    {
+        uint32_t taskIndex = POOL_NEXT_TASK(this);
+        if( taskIndex >= mTaskCount )
+        {
+            return;
+        }
+        mpTask->Execute( taskIndex, threadIndex );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTThreadPool::ParallelFor( CPUTTask *pTask, uint32_t taskCount )
+{
+    if( 0 == taskCount )
+    {
+        return;
+    }
+    if( 0 == mWorkerCount || 1 == taskCount )
+    {
+        for( uint32_t ii=0; ii<taskCount; ii++ )
+        {
+            pTask->Execute( ii, 0 );
+        }
+        return;
+    }
+
+    POOL_LOCK(this);
+    assert( 0 == mActiveWorkers && "CPUTThreadPool::ParallelFor() isn't reentrant" );
+    mpTask         = pTask;
+    mTaskCount     = taskCount;
+    mNextTask      = 0;
+    mActiveWorkers = mWorkerCount;
+    mGeneration++;
+    POOL_SIGNAL_ALL(mWake);
+    POOL_UNLOCK(this);
+
+    RunTasks( 0 );
+
+    POOL_LOCK(this);
+    while( mActiveWorkers )
+    {
+        POOL_WAIT(this, mDone);
+    }
+    mpTask = NULL;
+    POOL_UNLOCK(this);
+}
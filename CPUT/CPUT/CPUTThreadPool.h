@@ -0,0 +1,86 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTHREADPOOL_H__
+#define __CPUTTHREADPOOL_H__
+
+// Fixed set of worker threads for data-parallel loops.  ParallelFor() hands out
+// task indices to the workers and to the calling thread, and returns once every
+// index has executed.  Only one ParallelFor() may run at a time.
+#include <stdint.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#endif
+
+//-----------------------------------------------------------------------------
+class CPUTTask
+{
+public:
+    virtual ~CPUTTask() {}
+
+    // threadIndex is 0 for the calling thread, 1..GetThreadCount()-1 for the workers.
+    virtual void Execute( uint32_t taskIndex, uint32_t threadIndex ) = 0;
+};
+
+//-----------------------------------------------------------------------------
+class CPUTThreadPool
+{
+protected:
+    struct WorkerStart
+    {
+        CPUTThreadPool *mpPool;
+        uint32_t        mThreadIndex;
+    };
+
+    uint32_t             mWorkerCount;
+    WorkerStart         *mpWorkerStart;
+    CPUTTask            *mpTask;
+    uint32_t             mTaskCount;
+    volatile long        mNextTask;
+    uint32_t             mActiveWorkers;
+    uint32_t             mGeneration;
+    bool                 mQuit;
+
+#ifdef _WIN32
+    HANDLE              *mpThreads;
+    CRITICAL_SECTION     mLock;
+    CONDITION_VARIABLE   mWake;
+    CONDITION_VARIABLE   mDone;
+    static DWORD WINAPI  WorkerEntry( void *pStart );
+#else
+    pthread_t           *mpThreads;
+    pthread_mutex_t      mLock;
+    pthread_cond_t       mWake;
+    pthread_cond_t       mDone;
+    static void         *WorkerEntry( void *pStart );
+#endif
+
+    void WorkerLoop( uint32_t threadIndex );
+    void RunTasks( uint32_t threadIndex );
+
+public:
+    // workerCount == 0 creates one worker per hardware thread, less one for the caller.
+    CPUTThreadPool( uint32_t workerCount = 0 );
+    ~CPUTThreadPool();
+
+    uint32_t        GetThreadCount() const { return mWorkerCount + 1; } // Including the caller
+    void            ParallelFor( CPUTTask *pTask, uint32_t taskCount );
+    static uint32_t GetHardwareThreadCount();
+};
+
+#endif // __CPUTTHREADPOOL_H__
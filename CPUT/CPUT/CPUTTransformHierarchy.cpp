@@ -0,0 +1,277 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTransformHierarchy.h"
+#include <assert.h>
+
+CPUTTransformHierarchy *CPUTTransformHierarchy::mpDefaultHierarchy = NULL;
+
+//-----------------------------------------------------------------------------
+CPUTTransformHierarchy::CPUTTransformHierarchy() :
+    mFirstDirtySlot(CPUT_INVALID_TRANSFORM),
+    mOrderDirty(false),
+    mUseSIMD(true),
+    mLastUpdateCount(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+CPUTTransformHierarchy *CPUTTransformHierarchy::GetDefaultHierarchy()
+{
+    if( NULL == mpDefaultHierarchy )
+    {
+        mpDefaultHierarchy = new CPUTTransformHierarchy();
+    }
+    return mpDefaultHierarchy;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::DeleteDefaultHierarchy()
+{
+    delete mpDefaultHierarchy;
+    mpDefaultHierarchy = NULL;
+}
+
+// New transforms are roots with identity local and world matrices.  Appending
+// keeps the parent-before-child order, so no re-sort is needed.
+//-----------------------------------------------------------------------------
+CPUTTransformHandle CPUTTransformHierarchy::Allocate()
+{
+    CPUTTransformHandle handle;
+    if( !mFreeHandles.empty() )
+    {
+        handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+    }
+    else
+    {
+        handle = (CPUTTransformHandle)mSlotOfHandle.size();
+        mSlotOfHandle.push_back( CPUT_INVALID_TRANSFORM );
+    }
+
+    uint32_t slot = (uint32_t)mFlags.size();
+    mLocal.push_back( float4x4Identity() );
+    mWorld.push_back( float4x4Identity() );
+    mParentSlot.push_back( CPUT_INVALID_TRANSFORM );
+    mFlags.push_back( 0 );
+    mHandleOfSlot.push_back( handle );
+    mSlotOfHandle[handle] = slot;
+    return handle;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::Free( CPUTTransformHandle handle )
+{
+    if( handle >= mSlotOfHandle.size() || CPUT_INVALID_TRANSFORM == mSlotOfHandle[handle] )
+    {
+        return;
+    }
+    uint32_t slot = mSlotOfHandle[handle];
+    mFlags[slot]        = TRANSFORM_FREE;
+    mParentSlot[slot]   = CPUT_INVALID_TRANSFORM;
+    mHandleOfSlot[slot] = CPUT_INVALID_TRANSFORM;
+    mSlotOfHandle[handle] = CPUT_INVALID_TRANSFORM;
+    mFreeHandles.push_back( handle );
+    mOrderDirty = true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::SetParent( CPUTTransformHandle handle, CPUTTransformHandle parent )
+{
+    uint32_t slot       = mSlotOfHandle[handle];
+    uint32_t parentSlot = (CPUT_INVALID_TRANSFORM == parent) ? CPUT_INVALID_TRANSFORM : mSlotOfHandle[parent];
+    assert( parentSlot != slot );
+
+    mParentSlot[slot] = parentSlot;
+    if( CPUT_INVALID_TRANSFORM != parentSlot && parentSlot > slot )
+    {
+        mOrderDirty = true;
+    }
+    MarkDirty( handle );
+}
+
+//-----------------------------------------------------------------------------
+CPUTTransformHandle CPUTTransformHierarchy::GetParent( CPUTTransformHandle handle ) const
+{
+    uint32_t parentSlot = mParentSlot[mSlotOfHandle[handle]];
+    return (CPUT_INVALID_TRANSFORM == parentSlot) ? CPUT_INVALID_TRANSFORM : mHandleOfSlot[parentSlot];
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::SetLocal( CPUTTransformHandle handle, const float4x4 &local )
+{
+    mLocal[mSlotOfHandle[handle]] = local;
+    MarkDirty( handle );
+}
+
+// Only the node itself is flagged.  Its descendants are picked up by Update()
+// because they follow it in the arrays.
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::MarkDirty( CPUTTransformHandle handle )
+{
+    uint32_t slot = mSlotOfHandle[handle];
+    mFlags[slot] |= TRANSFORM_DIRTY;
+    if( CPUT_INVALID_TRANSFORM == mFirstDirtySlot || slot < mFirstDirtySlot )
+    {
+        mFirstDirtySlot = slot;
+    }
+}
+
+//-----------------------------------------------------------------------------
+float4x4 *CPUTTransformHierarchy::GetWorld( CPUTTransformHandle handle )
+{
+    if( IsDirty() )
+    {
+        Update();
+    }
+    return &mWorld[mSlotOfHandle[handle]];
+}
+
+// Single linear pass.  A slot is recomputed if its own local matrix changed or
+// its parent's world matrix was recomputed earlier in this same pass.
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::Update()
+{
+    if( mOrderDirty )
+    {
+        Reorder();
+    }
+    mLastUpdateCount = 0;
+    if( CPUT_INVALID_TRANSFORM == mFirstDirtySlot )
+    {
+        return;
+    }
+
+    const uint32_t count       = (uint32_t)mFlags.size();
+    const uint32_t first       = mFirstDirtySlot;
+    uint8_t       *pFlags      = &mFlags[0];
+    const uint32_t *pParent    = &mParentSlot[0];
+    float4x4      *pLocal      = &mLocal[0];
+    float4x4      *pWorld      = &mWorld[0];
+    uint32_t       updateCount = 0;
+
+    for( uint32_t ii=first; ii<count; ii++ )
+    {
+        uint8_t  flags  = pFlags[ii];
+        uint32_t parent = pParent[ii];
+        bool parentChanged = (CPUT_INVALID_TRANSFORM != parent) && (pFlags[parent] & TRANSFORM_CHANGED);
+        if( !(flags & TRANSFORM_DIRTY) && !parentChanged )
+        {
+            continue;
+        }
+        if( CPUT_INVALID_TRANSFORM == parent )
+        {
+            pWorld[ii] = pLocal[ii];
+        }
+        else if( mUseSIMD )
+        {
+            CPUTMultiplyMatrix4x4( &pWorld[ii], pLocal[ii], pWorld[parent] );
+        }
+        else
+        {
+            pWorld[ii] = pLocal[ii] * pWorld[parent];
+        }
+        pFlags[ii] = (uint8_t)((flags & ~TRANSFORM_DIRTY) | TRANSFORM_CHANGED);
+        updateCount++;
+    }
+    for( uint32_t ii=first; ii<count; ii++ )
+    {
+        pFlags[ii] &= ~TRANSFORM_CHANGED;
+    }
+
+    mFirstDirtySlot  = CPUT_INVALID_TRANSFORM;
+    mLastUpdateCount = updateCount;
+}
+
+// Re-sort the slots by depth (stable, so siblings keep their relative order) and
+// compact away freed slots.  Only needed after re-parenting or freeing, which
+// happens at load/unload time, not per frame.
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::Reorder()
+{
+    const uint32_t count = (uint32_t)mFlags.size();
+
+    // Depth of every live slot.  Walk up until we hit a slot whose depth is known.
+    std::vector<uint32_t> depth( count, CPUT_INVALID_TRANSFORM );
+    std::vector<uint32_t> path;
+    uint32_t maxDepth = 0;
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        if( mFlags[ii] & TRANSFORM_FREE ) { continue; }
+        uint32_t slot = ii;
+        while( CPUT_INVALID_TRANSFORM == depth[slot] )
+        {
+            path.push_back( slot );
+            uint32_t parent = mParentSlot[slot];
+            if( CPUT_INVALID_TRANSFORM == parent || (mFlags[parent] & TRANSFORM_FREE) )
+            {
+                break; // Root, or its parent went away first.  Treat it as a root.
+            }
+            slot = parent;
+        }
+        uint32_t d = (CPUT_INVALID_TRANSFORM == depth[slot]) ? 0 : depth[slot] + 1;
+        while( !path.empty() )
+        {
+            uint32_t s = path.back();
+            path.pop_back();
+            if( CPUT_INVALID_TRANSFORM == depth[s] )
+            {
+                depth[s] = d++;
+            }
+        }
+        if( depth[ii] > maxDepth ) { maxDepth = depth[ii]; }
+    }
+
+    // Counting sort by depth
+    std::vector<uint32_t> start( maxDepth + 2, 0 );
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        if( CPUT_INVALID_TRANSFORM != depth[ii] ) { start[depth[ii]+1]++; }
+    }
+    for( uint32_t dd=1; dd<start.size(); dd++ )
+    {
+        start[dd] += start[dd-1];
+    }
+    const uint32_t liveCount = start[maxDepth+1];
+    std::vector<uint32_t> newSlotOfOld( count, CPUT_INVALID_TRANSFORM );
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        if( CPUT_INVALID_TRANSFORM != depth[ii] ) { newSlotOfOld[ii] = start[depth[ii]]++; }
+    }
+
+    std::vector<float4x4> local( liveCount, float4x4Identity() ), world( liveCount, float4x4Identity() );
+    std::vector<uint32_t> parentSlot( liveCount ), handleOfSlot( liveCount );
+    std::vector<uint8_t>  flags( liveCount );
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        uint32_t slot = newSlotOfOld[ii];
+        if( CPUT_INVALID_TRANSFORM == slot ) { continue; }
+        uint32_t parent    = mParentSlot[ii];
+        local[slot]        = mLocal[ii];
+        world[slot]        = mWorld[ii];
+        parentSlot[slot]   = (CPUT_INVALID_TRANSFORM == parent) ? CPUT_INVALID_TRANSFORM : newSlotOfOld[parent]; // Freed parents map to CPUT_INVALID_TRANSFORM
+        handleOfSlot[slot] = mHandleOfSlot[ii];
+        flags[slot]        = TRANSFORM_DIRTY; // Cheap compared to the sort, and avoids tracking dirty state across the move.
+        mSlotOfHandle[mHandleOfSlot[ii]] = slot;
+    }
+    mLocal.swap( local );
+    mWorld.swap( world );
+    mParentSlot.swap( parentSlot );
+    mHandleOfSlot.swap( handleOfSlot );
+    mFlags.swap( flags );
+
+    mFirstDirtySlot = liveCount ? 0 : CPUT_INVALID_TRANSFORM;
+    mOrderDirty     = false;
+}
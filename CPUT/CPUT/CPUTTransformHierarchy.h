@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTRANSFORMHIERARCHY_H__
+#define __CPUTTRANSFORMHIERARCHY_H__
+
+// Flattened transform hierarchy.  Local (parent-relative) and world matrices for
+// every node live in contiguous arrays, sorted so that a parent always precedes
+// its children.  World matrices are then brought up to date with a single linear
+// pass that only touches dirty nodes and the subtrees below them.
+//
+// Nodes refer to their transform with a stable handle.  Slots (array positions)
+// move when the arrays are re-sorted, handles don't.
+//
+// Note: pointers returned by GetLocal()/GetWorld() are only valid until the next
+// Allocate(), Free(), SetParent() or Update().  Allocate() can grow (and so move) the
+// arrays, and Update() (which GetWorld() calls) re-sorts them with Reorder() after
+// parents change.  That includes the pointers CPUTRenderNode::GetParentMatrix() and
+// GetWorldMatrix() return: creating any render node, or reparenting one, moves every
+// node's matrices.  Copy the matrix, or call again, rather than keeping the pointer.
+#include "CPUTMathBatch.h"
+#include <stdint.h>
+#include <vector>
+
+typedef uint32_t CPUTTransformHandle;
+const CPUTTransformHandle CPUT_INVALID_TRANSFORM = 0xFFFFFFFF;
+
+//-----------------------------------------------------------------------------
+class CPUTTransformHierarchy
+{
+public:
+    enum
+    {
+        TRANSFORM_DIRTY   = 0x1, // Local matrix changed since the last Update()
+        TRANSFORM_CHANGED = 0x2, // World matrix was recomputed during the current Update()
+        TRANSFORM_FREE    = 0x4, // Slot is unused (compacted away by the next re-sort)
+    };
+
+protected:
+    static CPUTTransformHierarchy *mpDefaultHierarchy;
+
+    // Indexed by slot.  Parents always have a lower slot than their children.
+    std::vector<float4x4>  mLocal;
+    std::vector<float4x4>  mWorld;
+    std::vector<uint32_t>  mParentSlot;   // CPUT_INVALID_TRANSFORM for roots
+    std::vector<uint8_t>   mFlags;
+    std::vector<uint32_t>  mHandleOfSlot;
+
+    // Indexed by handle
+    std::vector<uint32_t>  mSlotOfHandle;
+    std::vector<uint32_t>  mFreeHandles;
+
+    uint32_t               mFirstDirtySlot; // Update() starts here.  CPUT_INVALID_TRANSFORM when clean.
+    bool                   mOrderDirty;     // A parent was moved after a child, or a slot was freed
+    bool                   mUseSIMD;
+    uint32_t               mLastUpdateCount;
+
+    void Reorder();
+
+public:
+    CPUTTransformHierarchy();
+    ~CPUTTransformHierarchy() {}
+
+    // The hierarchy shared by all CPUTRenderNodes
+    static CPUTTransformHierarchy *GetDefaultHierarchy();
+    static void                    DeleteDefaultHierarchy();
+
+    CPUTTransformHandle Allocate();
+    void                Free( CPUTTransformHandle handle );
+    void                SetParent( CPUTTransformHandle handle, CPUTTransformHandle parent );
+    CPUTTransformHandle GetParent( CPUTTransformHandle handle ) const;
+
+    // Writing through GetLocal() requires a call to MarkDirty() afterwards.
+    float4x4 *GetLocal( CPUTTransformHandle handle ) { return &mLocal[mSlotOfHandle[handle]]; }
+    void      SetLocal( CPUTTransformHandle handle, const float4x4 &local );
+    void      MarkDirty( CPUTTransformHandle handle );
+
+    // Brings all world matrices up to date (if needed) before returning.
+    float4x4 *GetWorld( CPUTTransformHandle handle );
+    void      Update();
+    bool      IsDirty() const { return mOrderDirty || CPUT_INVALID_TRANSFORM != mFirstDirtySlot; }
+
+    uint32_t  GetSlotCount() const       { return (uint32_t)mFlags.size(); }
+    uint32_t  GetLastUpdateCount() const { return mLastUpdateCount; } // World matrices recomputed by the last Update()
+    void      SetUseSIMD( bool useSIMD ) { mUseSIMD = useSIMD; }       // false uses float4x4::operator* (for comparison)
+};
+
+#endif // __CPUTTRANSFORMHIERARCHY_H__
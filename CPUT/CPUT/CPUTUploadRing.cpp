@@ -0,0 +1,176 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTUploadRing.h"
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <sched.h>
+#endif
+
+//-----------------------------------------------------------------------------
+CPUTUploadRing::CPUTUploadRing() :
+    mpBackend(0),
+    mBuffer(0),
+    mFrameSize(0),
+    mFrameCount(0),
+    mFrame(0),
+    mHead(0),
+    mFlushed(0),
+    mpMapped(0),
+    mFrameOpen(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTUploadRing::Create( CPUTRenderBackend *pBackend, uint32_t frameSize, uint32_t frameCount )
+{
+    Release();
+    if( !pBackend->SupportsConstantBufferRanges() || 0 == frameCount )
+    {
+        return false;
+    }
+    mpBackend  = pBackend;
+    mFrameSize = (frameSize + CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT - 1) & ~(CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT - 1);
+    mFrameCount = frameCount;
+    mBuffer    = mpBackend->CreateBuffer( mFrameSize * mFrameCount, CPUT_BIND_CONSTANT_BUFFER, true, 0 );
+    if( !mBuffer )
+    {
+        return false;
+    }
+    // The first map of a dynamic buffer must discard
+    mpBackend->Map( mBuffer );
+    mpBackend->Unmap( mBuffer, 0 );
+
+    mFences.resize( mFrameCount );
+    mFenceSignaled.assign( mFrameCount, false );
+    for( uint32_t ii = 0; ii < mFrameCount; ii++ )
+    {
+        mFences[ii] = mpBackend->CreateFence();
+    }
+    mFrame     = 0;
+    mHead      = 0;
+    mFlushed   = 0;
+    mFrameOpen = false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTUploadRing::Release()
+{
+    if( !mpBackend )
+    {
+        return;
+    }
+    Flush();
+    for( uint32_t ii = 0; ii < mFences.size(); ii++ )
+    {
+        mpBackend->ReleaseFence( mFences[ii] );
+    }
+    mFences.clear();
+    mFenceSignaled.clear();
+    if( mBuffer )
+    {
+        mpBackend->ReleaseBuffer( mBuffer );
+        mBuffer = 0;
+    }
+    mpBackend = 0;
+}
+
+// Moves to the next frame, waiting until the GPU has finished reading it.  Fences can
+// only be polled, so the wait gives up the rest of the time slice between polls.
+//-----------------------------------------------------------------------------
+void CPUTUploadRing::BeginFrame()
+{
+    if( !mBuffer )
+    {
+        return;
+    }
+    Flush();
+    mFrame     = (mFrame + 1) % mFrameCount;
+    mHead      = 0;
+    mFlushed   = 0;
+    mFrameOpen = true;
+    if( mFenceSignaled[mFrame] )
+    {
+        if( !mpBackend->IsFenceComplete( mFences[mFrame] ) )
+        {
+            mStats.mFenceWaits++;
+            while( !mpBackend->IsFenceComplete( mFences[mFrame] ) )
+            {
+#ifdef _WIN32
+                SwitchToThread();
+#else
+                sched_yield();
+#endif
+            }
+        }
+        mFenceSignaled[mFrame] = false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTUploadRing::EndFrame()
+{
+    if( !mFrameOpen )
+    {
+        return;
+    }
+    Flush();
+    mpBackend->SignalFence( mFences[mFrame] );
+    mFenceSignaled[mFrame] = true;
+    mFrameOpen = false;
+}
+
+//-----------------------------------------------------------------------------
+void *CPUTUploadRing::Allocate( uint32_t byteCount, uint32_t *pOffset )
+{
+    uint32_t alignedCount = (byteCount + CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT - 1) & ~(CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT - 1);
+    if( !mFrameOpen || alignedCount > mFrameSize - mHead )
+    {
+        mStats.mFailedAllocations++;
+        return 0;
+    }
+    if( !mpMapped )
+    {
+        mpMapped = (uint8_t*)mpBackend->MapNoOverwrite( mBuffer );
+        if( !mpMapped )
+        {
+            mStats.mFailedAllocations++;
+            return 0;
+        }
+        mStats.mMaps++;
+    }
+    uint32_t offset = mFrame * mFrameSize + mHead;
+    mHead += alignedCount;
+    mStats.mAllocations++;
+    mStats.mBytesAllocated += alignedCount;
+    *pOffset = offset;
+    return mpMapped + offset;
+}
+
+// Unmaps, so the allocations so far can be drawn with
+//-----------------------------------------------------------------------------
+void CPUTUploadRing::Flush()
+{
+    if( !mpMapped )
+    {
+        return;
+    }
+    mpBackend->UnmapRange( mBuffer, mFrame * mFrameSize + mFlushed, mHead - mFlushed );
+    mFlushed = mHead;
+    mpMapped = 0;
+}
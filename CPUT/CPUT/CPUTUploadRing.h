@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTUPLOADRING_H__
+#define __CPUTUPLOADRING_H__
+
+// Per-frame linear allocator for constant buffer uploads.  One dynamic buffer holds
+// frameCount frames back to back.  Each frame the buffer is mapped once (no-overwrite),
+// per-draw constants are bump-allocated at CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT offsets
+// and bound with SetConstantBufferRange().  A fence signaled at the end of each frame
+// tells BeginFrame() when the GPU is done with the frame it is about to reuse.
+//
+// Usage per frame: BeginFrame(), Allocate()... Flush() before drawing with the
+// allocations, EndFrame().  Allocate() returns NULL when the frame is full (or outside
+// BeginFrame()/EndFrame()); callers fall back to their own constant buffer.  Not thread safe.
+//
+// Create() fails if the backend doesn't support constant buffer ranges, which is always the
+// case for DX11 builds without CPUT_FOR_DX11_1 (see CPUTRenderBackendDX11.h).
+#include "CPUTRenderBackend.h"
+#include <stdint.h>
+#include <vector>
+
+// Room for a few thousand models' constants per frame
+const uint32_t CPUT_UPLOAD_RING_DEFAULT_FRAME_SIZE = 4 * 1024 * 1024;
+
+//-----------------------------------------------------------------------------
+struct CPUTUploadRingStats
+{
+    uint32_t mAllocations;
+    uint64_t mBytesAllocated;   // Including alignment padding
+    uint32_t mMaps;
+    uint32_t mFailedAllocations;
+    uint32_t mFenceWaits;       // BeginFrame() calls that had to poll the fence more than once
+
+    CPUTUploadRingStats() { Reset(); }
+    void Reset() { memset( this, 0, sizeof(*this) ); }
+};
+
+//-----------------------------------------------------------------------------
+class CPUTUploadRing
+{
+protected:
+    CPUTRenderBackend              *mpBackend;
+    CPUTBackendHandle               mBuffer;
+    std::vector<CPUTBackendHandle>  mFences;
+    std::vector<bool>               mFenceSignaled;
+    uint32_t                        mFrameSize;
+    uint32_t                        mFrameCount;
+    uint32_t                        mFrame;      // Frame being written
+    uint32_t                        mHead;       // Next free byte in the current frame
+    uint32_t                        mFlushed;    // Bytes of the current frame handed to UnmapRange()
+    uint8_t                        *mpMapped;    // Start of the buffer while mapped, else NULL
+    bool                            mFrameOpen;  // Between BeginFrame() and EndFrame()
+    CPUTUploadRingStats             mStats;
+
+public:
+    CPUTUploadRing();
+    ~CPUTUploadRing() { Release(); }
+
+    // Returns false (and stays disabled) if the backend can't bind constant buffer ranges.
+    // frameSize is rounded up to the alignment.
+    bool Create( CPUTRenderBackend *pBackend, uint32_t frameSize, uint32_t frameCount = 3 );
+    void Release();
+    bool IsEnabled() const { return 0 != mBuffer; }
+
+    void BeginFrame();
+    void EndFrame();
+
+    // Returns where to write byteCount bytes, and their offset in GetBuffer().  The pointer
+    // is only valid until the next Flush().
+    void *Allocate( uint32_t byteCount, uint32_t *pOffset );
+    void  Flush();
+
+    CPUTBackendHandle          GetBuffer() const     { return mBuffer; }
+    uint32_t                   GetFrameSize() const  { return mFrameSize; }
+    uint32_t                   GetBytesUsed() const  { return mHead; }
+    const CPUTUploadRingStats &GetStats() const      { return mStats; }
+    void                       ResetStats()          { mStats.Reset(); }
+};
+
+#endif // __CPUTUPLOADRING_H__
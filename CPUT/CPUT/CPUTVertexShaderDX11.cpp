@@ -16,6 +16,8 @@
 
 #include "CPUTVertexShaderDX11.h"
 #include "CPUTAssetLibraryDX11.h"
+#include "CPUTHash.h"
+#include <D3DCompiler.h> // D3DGetInputSignatureBlob()
 
 CPUTVertexShaderDX11 *CPUTVertexShaderDX11::CreateVertexShader(
     const cString        &name,
@@ -80,3 +82,24 @@ CPUTVertexShaderDX11 *CPUTVertexShaderDX11::CreateVertexShaderFromMemory(
     // return the shader (and blob)
     return pNewCPUTVertexShader;
 }
+
+// Hash of the input signature (the part of the bytecode an input layout is validated
+// against).  Falls back to the whole bytecode if the signature can't be extracted.
+//--------------------------------------------------------------------------------------
+uint64_t CPUTVertexShaderDX11::GetInputSignatureHash()
+{
+    if( !mInputSignatureHash )
+    {
+        ID3DBlob *pSignature = NULL;
+        if( SUCCEEDED( D3DGetInputSignatureBlob( mpBlob->GetBufferPointer(), mpBlob->GetBufferSize(), &pSignature ) ) )
+        {
+            mInputSignatureHash = CPUTHashBytes( pSignature->GetBufferPointer(), pSignature->GetBufferSize() );
+            pSignature->Release();
+        }
+        else
+        {
+            mInputSignatureHash = CPUTHashBytes( mpBlob->GetBufferPointer(), mpBlob->GetBufferSize() );
+        }
+    }
+    return mInputSignatureHash;
+}
@@ -18,11 +18,13 @@
 
 #include "CPUT.h"
 #include "CPUTShaderDX11.h"
+#include <stdint.h>
 
 class CPUTVertexShaderDX11 : public CPUTShaderDX11
 {
 protected:
     ID3D11VertexShader *mpVertexShader;
+    uint64_t            mInputSignatureHash; // 0 until GetInputSignatureHash() computes it
 
     // Destructor is not public.  Must release instead of delete.
     ~CPUTVertexShaderDX11(){ SAFE_RELEASE(mpVertexShader) }
@@ -42,9 +44,12 @@ static CPUTVertexShaderDX11 *CreateVertexShaderFromMemory(
         const char           *pShaderSource
     );
 
-    CPUTVertexShaderDX11() : mpVertexShader(NULL), CPUTShaderDX11(NULL) {}
-    CPUTVertexShaderDX11(ID3D11VertexShader *pD3D11VertexShader, ID3DBlob *pBlob) : mpVertexShader(pD3D11VertexShader), CPUTShaderDX11(pBlob) {}
+    CPUTVertexShaderDX11() : mpVertexShader(NULL), mInputSignatureHash(0), CPUTShaderDX11(NULL) {}
+    CPUTVertexShaderDX11(ID3D11VertexShader *pD3D11VertexShader, ID3DBlob *pBlob) : mpVertexShader(pD3D11VertexShader), mInputSignatureHash(0), CPUTShaderDX11(pBlob) {}
     ID3D11VertexShader *GetNativeVertexShader() { return mpVertexShader; }
+
+    // Shaders with the same inputs can share input layouts
+    uint64_t GetInputSignatureHash();
 };
 
 #endif //_CPUTVERTEXSHADER_H
@@ -691,7 +691,56 @@ CPUTMouseState CPUTWindowWin::ConvertMouseState(WPARAM wParam)
     return eState;
 }
 
-// Main message pump
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+typedef UINT (WINAPI *pTBP)(UINT period);
+
+// The frame scheduler's sleeps wait on a high resolution timer (Windows 10 1803 and
+// later).  Elsewhere they fall back to a message wait timeout, with the system timer
+// raised to 1 ms (winmm's timeBeginPeriod()).  Returns NULL for the fallback.
+//-----------------------------------------------------------------------------
+static HANDLE CreateFrameTimer()
+{
+    HANDLE hTimer = CreateWaitableTimerExW( NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+    if( !hTimer )
+    {
+        HMODULE hWinmm = LoadLibrary( TEXT("winmm.dll") );
+        pTBP    timeBeginPeriodProc = hWinmm ? (pTBP)GetProcAddress( hWinmm, "timeBeginPeriod" ) : NULL;
+        if( timeBeginPeriodProc )
+        {
+            timeBeginPeriodProc( 1 );
+        }
+    }
+    return hTimer;
+}
+
+// Sleeps until a message arrives or seconds pass.  Returns true if a message arrived.
+//-----------------------------------------------------------------------------
+static bool WaitForMessages( HANDLE hTimer, double seconds )
+{
+    if( hTimer )
+    {
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -(LONGLONG)(seconds * 10000000.0); // Relative, in 100 ns units
+        SetWaitableTimer( hTimer, &dueTime, 0, NULL, NULL, FALSE );
+        return WAIT_OBJECT_0 + 1 == MsgWaitForMultipleObjectsEx( 1, &hTimer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE );
+    }
+    // Whole milliseconds: the loop polls through the last fraction of one
+    DWORD milliseconds = (DWORD)(seconds * 1000.0);
+    return WAIT_OBJECT_0 == MsgWaitForMultipleObjectsEx( 0, NULL, milliseconds, QS_ALLINPUT, MWMO_INPUTAVAILABLE );
+}
+
+//-----------------------------------------------------------------------------
+static bool IsInputMessage( UINT message )
+{
+    return (message >= WM_KEYFIRST && message <= WM_KEYLAST) ||
+           (message >= WM_MOUSEFIRST && message <= WM_MOUSELAST) ||
+           WM_INPUT == message || WM_TOUCH == message;
+}
+
+// Main message pump.  The frame scheduler decides when InnerExecutionLoop() runs; in
+// between, the thread sleeps until the next frame or message.
 //-----------------------------------------------------------------------------
 int CPUTWindowWin::StartMessageLoop()
 {
@@ -700,6 +749,9 @@ int CPUTWindowWin::StartMessageLoop()
 	//
     MSG msg = { 0 };
 	bool fRunning = true;
+    CPUTFrameScheduler *pScheduler = mCPUT->GetFrameScheduler();
+    HANDLE              hTimer     = CreateFrameTimer();
+    pScheduler->Reset( CPUTFrameScheduler::GetSeconds() );
     while(fRunning)
     {
         // PeekMessage() is a passthru on no events
@@ -711,14 +763,41 @@ int CPUTWindowWin::StartMessageLoop()
 				PostQuitMessage(0);
 				fRunning = false;
 			}
+            if( IsInputMessage(msg.message) )
+            {
+                pScheduler->ReportActivity( CPUTFrameScheduler::GetSeconds() );
+            }
             TranslateMessage( &msg );
             DispatchMessage( &msg );
-        } else
-		{
-            // trigger render and other calls
-            mCPUT->InnerExecutionLoop();
+            continue;
+        }
+
+        double now = CPUTFrameScheduler::GetSeconds();
+        double waitSeconds;
+        switch( pScheduler->GetAction( now, &waitSeconds ) )
+        {
+        case CPUT_FRAME_RENDER:
+            {
+                double cpuSeconds = CPUTFrameScheduler::GetThreadCPUSeconds();
+                pScheduler->BeginFrame( now );
+                // trigger render and other calls
+                mCPUT->InnerExecutionLoop();
+                pScheduler->EndFrame( CPUTFrameScheduler::GetThreadCPUSeconds() - cpuSeconds );
+            }
+            break;
+        case CPUT_FRAME_POLL:
+            pScheduler->Polled( now );
+            mCPUT->PollActivity();
+            break;
+        default:
+            pScheduler->Woke( WaitForMessages( hTimer, waitSeconds ) );
+            break;
         }
     }
+    if( hTimer )
+    {
+        CloseHandle( hTimer );
+    }
 	
 	//
 	// Drain out the rest of the message queue.
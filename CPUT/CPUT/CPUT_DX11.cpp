@@ -17,9 +17,17 @@
 #include "CPUTRenderStateBlockDX11.h"
 #include "CPUTBufferDX11.h"
 #include "CPUTTextureDX11.h"
+#include "CPUTRenderBackendDX11.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTUploadRing.h"
+#include "CPUTProfiler.h"
+#include <algorithm>
 
 // static initializers
 ID3D11Device* CPUT_DX11::mpD3dDevice = NULL;
+CPUTRenderBackend* CPUT_DX11::mpBackend = NULL;
+CPUTUploadRing* CPUT_DX11::mpUploadRing = NULL;
+CPUTTextureStreamer* CPUT_DX11::mpTextureStreamer = NULL;
 CPUT_DX11 *gpSample;
 
 // Destructor
@@ -201,6 +209,14 @@ CPUTResult CPUT_DX11::CreateDXContext(CPUTContextCreation ContextParams )
     };
     UINT numDriverTypes = ARRAYSIZE( driverTypes );
 
+    // Headless runs don't submit anything to the device; it exists only so resources can be created.
+    // Prefer the WARP device so no GPU is needed.
+    if( ContextParams.headless )
+    {
+        driverTypes[0] = D3D_DRIVER_TYPE_WARP;
+        driverTypes[1] = D3D_DRIVER_TYPE_HARDWARE;
+    }
+
     // SRV's (shader resource views) require Structured Buffer
     // usage (D3D11_RESOURCE_MISC_BUFFER_STRUCTURED) which was 
     // introduced in shader model 5 (directx 11.0)
@@ -284,6 +300,23 @@ CPUTResult CPUT_DX11::CreateDXContext(CPUTContextCreation ContextParams )
     // we throw up a dialog right after drawing the loading screen in CPUTCreateWindowAndContext
     // warning about that perf problem
 
+    // Create the render backend.  Everything the frame loop submits goes through it.
+    if( ContextParams.headless )
+    {
+        mpBackend = new CPUTRenderBackendNull();
+    }
+    else
+    {
+        mpBackend = new CPUTRenderBackendDX11( mpD3dDevice, mpContext, mpSwapChain );
+    }
+    // Only the null backend, or DX11 built with CPUT_FOR_DX11_1, supports the ring (see CPUTRenderBackendDX11.h)
+    mpUploadRing = new CPUTUploadRing();
+    if( !mpUploadRing->Create( mpBackend, CPUT_UPLOAD_RING_DEFAULT_FRAME_SIZE ) )
+    {
+        SAFE_DELETE( mpUploadRing );
+    }
+    mpTextureStreamer = new CPUTTextureStreamer();
+
     // call the DeviceCreated callback/backbuffer/etc creation
     result = CreateContext();
 
@@ -387,14 +420,8 @@ CPUTResult CPUT_DX11::CreateContext()
     ASSERT( SUCCEEDED(hr), _L("Failed creating and binding depth buffer.") );
 
     // Setup the viewport
-    D3D11_VIEWPORT vp;
-    vp.Width = (FLOAT)width;
-    vp.Height = (FLOAT)height;
-    vp.MinDepth = 0.0f;
-    vp.MaxDepth = 1.0f;
-    vp.TopLeftX = 0;
-    vp.TopLeftY = 0;
-    mpContext->RSSetViewports( 1, &vp );
+    CPUTBackendViewport viewport = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
+    mpBackend->SetViewport( viewport );
 
     return CPUT_SUCCESS;
 }
@@ -412,6 +439,9 @@ CPUTResult CPUT_DX11::DestroyDXContext()
     SAFE_RELEASE( mpDepthStencilBuffer );
     SAFE_RELEASE( mpDepthStencilState );
     SAFE_RELEASE( mpDepthStencilView );
+    SAFE_DELETE( mpUploadRing );
+    SAFE_DELETE( mpTextureStreamer );
+    SAFE_DELETE( mpBackend );
     SAFE_RELEASE( mpContext );
     SAFE_RELEASE( mpD3dDevice );
     SAFE_RELEASE( mpSwapChain );
@@ -548,7 +578,7 @@ CPUTResult CPUT_DX11::CreateAndBindDepthBuffer(int width, int height)
     // Create the depth stencil state.
     hr = mpD3dDevice->CreateDepthStencilState(&depthStencilDesc, &mpDepthStencilState);
     ASSERT( SUCCEEDED(hr), _L("Failed to create depth-stencil state.") );
-    mpContext->OMSetDepthStencilState(mpDepthStencilState, 1);
+    mpBackend->SetDepthStencilState( mpDepthStencilState, 1 );
 
     // Create shader resource view
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
@@ -571,7 +601,7 @@ CPUTResult CPUT_DX11::CreateAndBindDepthBuffer(int width, int height)
     CPUTSetDebugName( mpDepthStencilView, _L("DepthStencilView") );
 
     // Bind the render target view and depth stencil buffer to the output render pipeline.
-    mpContext->OMSetRenderTargets(1, &mpBackBufferRTV, mpDepthStencilView);
+    mpBackend->SetRenderTargets( 1, (CPUTBackendHandle*)&mpBackBufferRTV, mpDepthStencilView );
 
     CPUTRenderTargetColor::SetActiveRenderTargetView( mpBackBufferRTV );
     CPUTRenderTargetDepth::SetActiveDepthStencilView( mpDepthStencilView );
@@ -595,6 +625,7 @@ void CPUT_DX11::ResizeWindow(UINT width, UINT height)
 
     // Make sure we don't have any buffers bound.
     mpContext->ClearState();
+    mpBackend->InvalidateStateCache();
     Present();
     mpContext->Flush();
 
@@ -694,14 +725,8 @@ void CPUT_DX11::ResizeWindow(UINT width, UINT height)
     // if(mpDepthStencilSRV) mpDepthStencilSRV->Release();;
 
     // set the viewport
-    D3D11_VIEWPORT vp;
-    vp.Width = (FLOAT) windowWidth;
-    vp.Height = (FLOAT)windowHeight;
-    vp.MinDepth = 0.0f;
-    vp.MaxDepth = 1.0f;
-    vp.TopLeftX = 0;
-    vp.TopLeftY = 0;
-    mpContext->RSSetViewports( 1, &vp );
+    CPUTBackendViewport viewport = { 0.0f, 0.0f, (float)windowWidth, (float)windowHeight, 0.0f, 1.0f };
+    mpBackend->SetViewport( viewport );
 
     // trigger the GUI manager to resize
     CPUTGuiControllerDX11::GetController()->Resize();
@@ -727,11 +752,10 @@ void CPUT_DX11::SetPerFrameConstantBuffer( double totalSeconds )
         ID3D11Buffer *pBuffer = mpPerFrameConstantBuffer->GetNativeBuffer();
 
         // update parameters of constant buffer
-        D3D11_MAPPED_SUBRESOURCE mapInfo;
-        mpContext->Map( pBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapInfo );
+        void *pMapped = mpBackend->Map( pBuffer );
         {
             // TODO: remove construction of XMM type
-            CPUTFrameConstantBuffer *pCb = (CPUTFrameConstantBuffer*)mapInfo.pData;
+            CPUTFrameConstantBuffer *pCb = (CPUTFrameConstantBuffer*)pMapped;
             CPUTCamera *pCamera     = gpSample->GetCamera();
             if( pCamera )
             {
@@ -743,7 +767,7 @@ void CPUT_DX11::SetPerFrameConstantBuffer( double totalSeconds )
             pCb->TotalSeconds       = XMLoadFloat(&totalSecondsFloat);
             pCb->AmbientColor       = XMLoadFloat3(&XMFLOAT3((float*)&mAmbientColor));
         }
-        mpContext->Unmap(pBuffer,0);
+        mpBackend->Unmap( pBuffer, sizeof(CPUTFrameConstantBuffer) );
     }
 }
 
@@ -754,15 +778,57 @@ void CPUT_DX11::InnerExecutionLoop()
 #ifdef CPUT_GPA_INSTRUMENTATION
     D3DPERF_BeginEvent(D3DCOLOR(0xff0000), L"CPUT User's Render() ");
 #endif
+    CPUT_PROFILE_FRAME();
     if(!mbShutdown)
     {
+        CPUTHeapCounters heapStart = CPUTGetHeapCounters();
+        mFrameArena.Reset();
+
 		double deltaSeconds = mpTimer->GetElapsedTime();
-		Update(deltaSeconds);
-        Present(); // Note: Presenting immediately before Rendering minimizes CPU stalls (i.e., execute Update() before Present() stalls)
+        {
+            CPUT_PROFILE_ZONE("Update");
+            Update(deltaSeconds);
+        }
+        if( mpTextureStreamer )
+        {
+            CPUT_PROFILE_ZONE("Texture streaming");
+            if( mpTextureStreamer->Update() )
+            {
+                // Streamed textures were recreated with more (or fewer) mips.  Materials hold their
+                // views, so rebind the slots holding those textures (not every material's every view).
+                const std::vector<CPUTStreamedTexture*> &changed = mpTextureStreamer->GetChangedTextures();
+                std::vector<CPUTTexture*> textures( changed.size() );
+                for( UINT ii=0; ii<changed.size(); ii++ )
+                {
+                    textures[ii] = static_cast<CPUTTextureDX11*>( changed[ii] );
+                }
+                std::sort( textures.begin(), textures.end() ); // Base pointers don't keep the streamer's order
+                CPUTAssetLibrary::GetAssetLibrary()->RebindTextures( textures );
+            }
+        }
+        {
+            CPUT_PROFILE_ZONE("Present");
+            Present(); // Note: Presenting immediately before Rendering minimizes CPU stalls (i.e., execute Update() before Present() stalls)
+        }
 
         double totalSeconds = mpTimer->GetTotalTime();
-        SetPerFrameConstantBuffer(totalSeconds);
-        Render(deltaSeconds);
+        {
+            CPUT_PROFILE_ZONE("Render");
+            if( mpUploadRing ) { mpUploadRing->BeginFrame(); }
+            SetPerFrameConstantBuffer(totalSeconds);
+            Render(deltaSeconds);
+            if( mpUploadRing ) { mpUploadRing->EndFrame(); }
+        }
+
+        const CPUTArenaStats &arenaStats = mFrameArena.GetStats();
+        CPUTHeapCounters      heapEnd    = CPUTGetHeapCounters();
+        mFrameAllocations.mHeapAllocations  = heapEnd.mAllocations - heapStart.mAllocations;
+        mFrameAllocations.mHeapBytes        = heapEnd.mBytes - heapStart.mBytes;
+        mFrameAllocations.mArenaAllocations = arenaStats.mAllocations;
+        mFrameAllocations.mArenaBytes       = arenaStats.mBytes;
+        CPUT_PROFILE_COUNTER("Heap allocations", mFrameAllocations.mHeapAllocations);
+        CPUT_PROFILE_COUNTER("Frame arena bytes", mFrameAllocations.mArenaBytes);
+
         if(!CPUTOSServices::GetOSServices()->DoesWindowHaveFocus())
         {
             Sleep(100);
@@ -787,9 +853,10 @@ void CPUT_DX11::CPUTDrawGUI()
     D3DPERF_BeginEvent(D3DCOLOR(0xff0000), L"CPUT Draw GUI");
 #endif
 
+    CPUT_PROFILE_ZONE("GUI");
     // draw all the Gui controls
     HEAPCHECK;
-        CPUTGuiControllerDX11::GetController()->Draw(mpContext);
+        CPUTGuiControllerDX11::GetController()->Draw(mpBackend);
     HEAPCHECK;
 
 #ifdef CPUT_GPA_INSTRUMENTATION
@@ -876,6 +943,16 @@ CPUTResult CPUT_DX11::CPUTParseCommandLine(cString commandLine, CPUTWindowCreati
                         pWindowParams->deviceParams.refreshRate = 30;
                     }
                 }
+                else if(0==ParameterName.compare(_L("headless")))
+                {
+                    // get the bool 
+                    token = wcstok_s(NULL, separators, &nextToken); 
+                    cString boolString(token);
+                    if(0==boolString.compare(_L("true")))
+                    {
+                        pWindowParams->deviceParams.headless = true;
+                    }
+                }
                 else if(0==ParameterName.compare(_L("xpos")))
                 {
                     // get the next value
@@ -943,6 +1020,21 @@ CPUTResult CPUT_DX11::CPUTCreateWindowAndContext(const cString WindowTitle, CPUT
     }
 
     HEAPCHECK;
+
+    // Cache compiled shaders next to the executable.  Without the directory every shader is compiled.
+    CPUTTimerWin startupTimer;
+    startupTimer.StartTimer();
+    cString shaderCacheDirectory;
+    CPUTOSServices::GetOSServices()->GetExecutableDirectory(&shaderCacheDirectory);
+    shaderCacheDirectory += _L("ShaderCache\\");
+    if( CreateDirectory( shaderCacheDirectory.c_str(), NULL ) || (ERROR_ALREADY_EXISTS == GetLastError()) )
+    {
+        char pDirectoryAsChar[MAX_PATH];
+        size_t count;
+        wcstombs_s( &count, pDirectoryAsChar, shaderCacheDirectory.c_str(), MAX_PATH );
+        ((CPUTAssetLibraryDX11*)CPUTAssetLibrary::GetAssetLibrary())->GetShaderCache()->SetDirectory( pDirectoryAsChar );
+    }
+
 #define ENABLE_GUI
 #ifdef ENABLE_GUI
     // initialize the gui controller 
@@ -963,7 +1055,7 @@ CPUTResult CPUT_DX11::CPUTCreateWindowAndContext(const cString WindowTitle, CPUT
     HEAPCHECK;
     
     // warn the user they are using the software rasterizer
-    if((D3D_DRIVER_TYPE_REFERENCE == mdriverType) || (D3D_DRIVER_TYPE_WARP == mdriverType))
+    if(!mpBackend->IsNull() && ((D3D_DRIVER_TYPE_REFERENCE == mdriverType) || (D3D_DRIVER_TYPE_WARP == mdriverType)))
     {
         CPUTOSServices::GetOSServices()->OpenMessageBox(_L("Performance warning"), _L("Your graphics hardware does not support the DirectX features required by this sample. The sample is now running using the DirectX software rasterizer."));
     }
@@ -974,6 +1066,12 @@ CPUTResult CPUT_DX11::CPUTCreateWindowAndContext(const cString WindowTitle, CPUT
     Create();
     HEAPCHECK;
 
+    const CPUTShaderCacheStats &shaderStats = ((CPUTAssetLibraryDX11*)CPUTAssetLibrary::GetAssetLibrary())->GetShaderCache()->GetStats();
+    TCHAR startupMessage[256];
+    swprintf( startupMessage, 256, _L("Startup: %.0f ms.  Shaders: %d from cache, %d compiled, %d stale cache files\n"),
+        startupTimer.StopTimer() * 1000.0, shaderStats.mHits, shaderStats.mCompiles, shaderStats.mRejectedFiles );
+    OutputDebugString( startupMessage );
+
 	//
 	// Start the timer after everything is initialized and assets have been loaded
 	//
@@ -997,8 +1095,8 @@ CPUTResult CPUT_DX11::CPUTCreateWindowAndContext(const cString WindowTitle, CPUT
 
     // fill first frame with clear values so render order later is ok
     const float srgbClearColor[] = { 0.0993f, 0.0993f, 0.0993f, 1.0f };
-    mpContext->ClearRenderTargetView( mpBackBufferRTV, srgbClearColor );
-    mpContext->ClearDepthStencilView(mpDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 0.0f, 0);
+    mpBackend->ClearRenderTarget( mpBackBufferRTV, srgbClearColor );
+    mpBackend->ClearDepthStencil( mpDepthStencilView, CPUT_CLEAR_DEPTH | CPUT_CLEAR_STENCIL, 0.0f, 0 );
 
     // trigger a 'resize' event
     int x,y,width,height;
@@ -1014,8 +1112,8 @@ void CPUT_DX11::DrawLoadingFrame()
 {
     // fill first frame with clear values so render order later is ok
     const float srgbClearColor[] = { 0.0993f, 0.0993f, 0.0993f, 1.0f };
-    mpContext->ClearRenderTargetView( mpBackBufferRTV, srgbClearColor );
-    mpContext->ClearDepthStencilView(mpDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 0.0f, 0);
+    mpBackend->ClearRenderTarget( mpBackBufferRTV, srgbClearColor );
+    mpBackend->ClearDepthStencil( mpDepthStencilView, CPUT_CLEAR_DEPTH | CPUT_CLEAR_STENCIL, 0.0f, 0 );
 
     // get center
     int x,y,width,height;
@@ -1030,12 +1128,12 @@ void CPUT_DX11::DrawLoadingFrame()
     pText->GetDimensions(textWidth, textHeight);
     pText->SetPosition(width/2-textWidth/2, height/2);
 
-    pGUIController->Draw(mpContext);
+    pGUIController->Draw(mpBackend);
     pGUIController->DeleteAllControls();
     pGUIController->EnableAutoLayout(true);
     
     // present loading screen
-    mpSwapChain->Present( mSyncInterval, 0 );
+    mpBackend->Present( mSyncInterval );
 }
 
 // Pop up a message box with specified title/text
@@ -1053,6 +1151,7 @@ int CPUT_DX11::CPUTMessageLoop()
     D3DPERF_BeginEvent(D3DCOLOR(0xff0000), L"CPUTMessageLoop");
 #endif
 
+    CPUT_PROFILE_THREAD_NAME("Main");
     return mpWindow->StartMessageLoop();
 
 #ifdef CPUT_GPA_INSTRUMENTATION
@@ -1125,6 +1224,7 @@ void CPUT_DX11::ShutdownAndDestroy()
     CPUTInputLayoutCacheDX11::DeleteInputLayoutCache();
     CPUTAssetLibraryDX11::DeleteAssetLibrary();
     CPUTGuiControllerDX11::DeleteController();
+    CPUTTransformHierarchy::DeleteDefaultHierarchy();
 
 // #ifdef _DEBUG
 #if 0
@@ -33,6 +33,9 @@
 #include "CPUTCamera.h"
 #include "CPUTLight.h"
 #include "CPUTMaterialDX11.h"
+#include "CPUTRenderBackend.h"
+#include "CPUTUploadRing.h"
+#include "CPUTTextureStreamer.h"
 
 // include all DX11 headers needed
 #include <d3d11.h>
@@ -48,6 +51,7 @@ struct CPUTContextCreation
     int swapChainBufferCount;
     DXGI_FORMAT swapChainFormat;
     DXGI_USAGE swapChainUsage;
+    bool headless; // Submit through the null backend (and prefer the WARP device).  No GPU work is issued, but resources are still created on the D3D11 device.
 };
 
 // window creation parameters
@@ -59,7 +63,7 @@ struct CPUTWindowCreationParams
     int windowPositionX;
     int windowPositionY;
     CPUTContextCreation deviceParams;
-    CPUTWindowCreationParams() : startFullscreen(false), windowWidth(1280), windowHeight(720), windowPositionX(0), windowPositionY(0) {}
+    CPUTWindowCreationParams() : startFullscreen(false), windowWidth(1280), windowHeight(720), windowPositionX(0), windowPositionY(0) { deviceParams.headless = false; }
 };
 
 // Types of message boxes you can create
@@ -88,10 +92,16 @@ extern CPUT_DX11 *gpSample;
 class CPUT_DX11:public CPUT
 {
 protected:
-    static ID3D11Device *mpD3dDevice;
+    static ID3D11Device      *mpD3dDevice;
+    static CPUTRenderBackend *mpBackend;
+    static CPUTUploadRing    *mpUploadRing; // NULL if the backend can't bind constant buffer ranges
+    static CPUTTextureStreamer *mpTextureStreamer;
 
 public:
-    static ID3D11Device *GetDevice();
+    static ID3D11Device      *GetDevice();
+    static CPUTRenderBackend *GetBackend() { return mpBackend; }
+    static CPUTUploadRing    *GetUploadRing() { return mpUploadRing; }
+    static CPUTTextureStreamer *GetTextureStreamer() { return mpTextureStreamer; }
 
 protected:
     CPUTWindowWin             *mpWindow;
@@ -159,7 +169,7 @@ public:
 
     // events
     virtual void Update(double deltaSeconds) {}
-    virtual void Present() { mpSwapChain->Present( mSyncInterval, 0 ); }
+    virtual void Present() { mpBackend->Present( mSyncInterval ); }
     virtual void Render(double deltaSeconds) = 0;
     virtual void Create()=0;
     virtual void Shutdown();
@@ -0,0 +1,157 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTAllocator.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// CPUT's allocators against new and delete.  Transient data: 20k allocations a frame of
+// 16 to 512 bytes, freed at the end of the frame, from the frame arena or the heap.
+// Render nodes: 20k blocks in four of the node pools' size classes, created and released
+// as an asset set loads and unloads, then churned as a level streams, from a CPUTPoolSet
+// or the heap.  This target is built with CPUT_COUNT_HEAP_ALLOCATIONS, so each line also
+// gives the heap allocations it made.
+
+static const uint32_t kAllocations = 20000;
+static const uint32_t kFrames      = 100;
+
+static volatile uint8_t sSink;
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, double seconds, uint64_t operations, uint64_t heapAllocations, uint32_t frames )
+{
+    printf( "  %-32s %6.1f ns/allocation  %8.0f heap allocations/frame\n", pName,
+            seconds * 1e9 / (double)operations, (double)heapAllocations / frames );
+}
+
+//-----------------------------------------------------------------------------
+static void BenchTransient( const std::vector<size_t> &sizes )
+{
+    std::vector<uint8_t*> blocks( kAllocations, (uint8_t*)NULL );
+    {
+        uint64_t heapAllocations = CPUTGetHeapCounters().mAllocations;
+        double start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t ff=0; ff<kFrames; ff++ )
+        {
+            for( uint32_t ii=0; ii<kAllocations; ii++ )
+            {
+                blocks[ii] = new uint8_t[sizes[ii]];
+                blocks[ii][0] = (uint8_t)ii;
+            }
+            for( uint32_t ii=0; ii<kAllocations; ii++ )
+            {
+                sSink = blocks[ii][0];
+                delete [] blocks[ii];
+            }
+        }
+        double seconds = CPUTFrameScheduler::GetSeconds() - start;
+        Report( "Transient, heap", seconds, (uint64_t)kAllocations * kFrames, CPUTGetHeapCounters().mAllocations - heapAllocations, kFrames );
+    }
+    {
+        CPUTArena arena;
+        uint64_t heapAllocations = CPUTGetHeapCounters().mAllocations;
+        double start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t ff=0; ff<kFrames; ff++ )
+        {
+            for( uint32_t ii=0; ii<kAllocations; ii++ )
+            {
+                blocks[ii] = (uint8_t*)arena.Allocate( sizes[ii] );
+                blocks[ii][0] = (uint8_t)ii;
+            }
+            for( uint32_t ii=0; ii<kAllocations; ii++ )
+            {
+                sSink = blocks[ii][0];
+            }
+            arena.Reset();
+        }
+        double seconds = CPUTFrameScheduler::GetSeconds() - start;
+        Report( "Transient, frame arena", seconds, (uint64_t)kAllocations * kFrames, CPUTGetHeapCounters().mAllocations - heapAllocations, kFrames );
+        printf( "  %-32s %.1f KB held by the arena\n", "", arena.GetStats().mCapacity / 1024.0 );
+    }
+}
+
+// Loads and unloads the nodes, then replaces a tenth of them a frame.  Heap or pool.
+//-----------------------------------------------------------------------------
+static void BenchNodes( const char *pName, const std::vector<size_t> &sizes, CPUTPoolSet *pPools )
+{
+    std::vector<uint8_t*> nodes( kAllocations, (uint8_t*)NULL );
+    CPUTTestRandom random( 2 );
+    uint64_t heapAllocations = CPUTGetHeapCounters().mAllocations;
+    double start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ff=0; ff<kFrames; ff++ )
+    {
+        for( uint32_t ii=0; ii<kAllocations; ii++ )
+        {
+            nodes[ii] = pPools ? (uint8_t*)pPools->Allocate( sizes[ii] ) : new uint8_t[sizes[ii]];
+            nodes[ii][0] = (uint8_t)ii;
+        }
+        for( uint32_t ii=0; ii<kAllocations; ii++ )
+        {
+            sSink = nodes[ii][0];
+            if( pPools ) { pPools->Free( nodes[ii], sizes[ii] ); } else { delete [] nodes[ii]; }
+        }
+    }
+    double seconds = CPUTFrameScheduler::GetSeconds() - start;
+    char name[64];
+    sprintf( name, "Load and release, %s", pName );
+    Report( name, seconds, (uint64_t)kAllocations * kFrames, CPUTGetHeapCounters().mAllocations - heapAllocations, kFrames );
+
+    for( uint32_t ii=0; ii<kAllocations; ii++ )
+    {
+        nodes[ii] = pPools ? (uint8_t*)pPools->Allocate( sizes[ii] ) : new uint8_t[sizes[ii]];
+    }
+    heapAllocations = CPUTGetHeapCounters().mAllocations;
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ff=0; ff<kFrames; ff++ )
+    {
+        for( uint32_t ii=0; ii<kAllocations / 10; ii++ )
+        {
+            uint32_t index = random.Index( kAllocations );
+            sSink = nodes[index][0];
+            if( pPools ) { pPools->Free( nodes[index], sizes[index] ); } else { delete [] nodes[index]; }
+            nodes[index] = pPools ? (uint8_t*)pPools->Allocate( sizes[index] ) : new uint8_t[sizes[index]];
+            nodes[index][0] = (uint8_t)index;
+        }
+    }
+    seconds = CPUTFrameScheduler::GetSeconds() - start;
+    sprintf( name, "Streaming, %s", pName );
+    Report( name, seconds, (uint64_t)kAllocations / 10 * kFrames, CPUTGetHeapCounters().mAllocations - heapAllocations, kFrames );
+    for( uint32_t ii=0; ii<kAllocations; ii++ )
+    {
+        if( pPools ) { pPools->Free( nodes[ii], sizes[ii] ); } else { delete [] nodes[ii]; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTTestRandom random( 46 );
+    std::vector<size_t> transientSizes( kAllocations ), nodeSizes( kAllocations );
+    // Four size classes, as the node classes spread over the pools
+    const size_t nodeClassSizes[4] = { 176, 320, 448, 272 };
+    for( uint32_t ii=0; ii<kAllocations; ii++ )
+    {
+        transientSizes[ii] = 16 + random.Index( 497 );
+        nodeSizes[ii]      = nodeClassSizes[random.Index( 4 )];
+    }
+    BenchTransient( transientSizes );
+
+    // As CPUTRenderNode's pools
+    CPUTPoolSet pools( 64, 1024, 32 );
+    BenchNodes( "heap", nodeSizes, NULL );
+    BenchNodes( "node pools", nodeSizes, &pools );
+    return 0;
+}
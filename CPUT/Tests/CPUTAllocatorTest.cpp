@@ -0,0 +1,289 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTAllocator.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <vector>
+
+// CPUTArena: alignment, that allocations don't overlap, marks and scopes, and that Reset()
+// folds the chunks a frame needed into one so the next frame makes no heap allocations.
+// CPUTPool and CPUTPoolSet: block size and alignment, that freed blocks are handed out
+// again before a new chunk is taken, and which sizes each pool serves.
+
+//-----------------------------------------------------------------------------
+static bool IsAligned( const void *pMemory, size_t alignment )
+{
+    return 0 == ((uintptr_t)pMemory & (alignment - 1));
+}
+
+// Fills each allocation with its index, then checks none was overwritten by another
+//-----------------------------------------------------------------------------
+struct CPUTTestAllocations
+{
+    std::vector<uint8_t*> mBlocks;
+    std::vector<size_t>   mSizes;
+
+    void Add( void *pMemory, size_t size )
+    {
+        memset( pMemory, (int)(mBlocks.size() & 0xff), size );
+        mBlocks.push_back( (uint8_t*)pMemory );
+        mSizes.push_back( size );
+    }
+    bool Intact() const
+    {
+        for( size_t ii=0; ii<mBlocks.size(); ii++ )
+        {
+            for( size_t jj=0; jj<mSizes[ii]; jj++ )
+            {
+                if( mBlocks[ii][jj] != (uint8_t)(ii & 0xff) )
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+//-----------------------------------------------------------------------------
+static void TestArenaAlignment()
+{
+    CPUTArena arena( 4096 );
+    CPUTTestRandom random( 46 );
+    CPUTTestAllocations allocations;
+    size_t bytes = 0;
+    for( uint32_t ii=0; ii<2000; ii++ )
+    {
+        size_t size      = 1 + random.Index( 300 );
+        size_t alignment = (size_t)1 << random.Index( 9 );
+        void  *pMemory   = arena.Allocate( size, alignment );
+        CPUT_CHECK( IsAligned( pMemory, alignment ) );
+        allocations.Add( pMemory, size );
+        bytes += size;
+    }
+    CPUT_CHECK( allocations.Intact() );
+    const CPUTArenaStats &stats = arena.GetStats();
+    CPUT_CHECK( 2000 == stats.mAllocations );
+    CPUT_CHECK( stats.mBytes >= bytes && stats.mUsed == stats.mBytes && stats.mPeak == stats.mUsed );
+    CPUT_CHECK( stats.mCapacity >= stats.mUsed );
+
+    // Larger than a chunk: a chunk of its own, and the next small one still fits
+    uint64_t chunks = stats.mChunkAllocations;
+    void *pLarge = arena.Allocate( 10000, 64 );
+    CPUT_CHECK( IsAligned( pLarge, 64 ) );
+    CPUT_CHECK( chunks + 1 == arena.GetStats().mChunkAllocations );
+    memset( pLarge, 0xcd, 10000 );
+    CPUT_CHECK( allocations.Intact() );
+
+    // The default alignment is 16, and arrays get it too
+    CPUT_CHECK( IsAligned( arena.Allocate( 3 ), 16 ) );
+    CPUT_CHECK( IsAligned( arena.AllocateArray<float>( 3 ), 16 ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestArenaReset()
+{
+    CPUTArena arena( 1024 );
+    CPUTArena untouched;
+    CPUT_CHECK( 0 == untouched.GetStats().mChunkAllocations && 0 == untouched.GetStats().mCapacity );
+
+    // The first frame needs several chunks; Reset() swaps them for one that holds them all
+    std::vector<void*> firstFrame;
+    for( uint32_t ii=0; ii<100; ii++ )
+    {
+        firstFrame.push_back( arena.Allocate( 100 ) );
+    }
+    uint64_t chunks = arena.GetStats().mChunkAllocations;
+    size_t   used   = arena.GetStats().mUsed;
+    CPUT_CHECK( chunks > 1 );
+    arena.Reset();
+    CPUT_CHECK( chunks + 1 == arena.GetStats().mChunkAllocations );
+    CPUT_CHECK( arena.GetStats().mCapacity >= used );
+    CPUT_CHECK( 0 == arena.GetStats().mUsed && 0 == arena.GetStats().mAllocations && 0 == arena.GetStats().mBytes );
+    CPUT_CHECK( used == arena.GetStats().mPeak );
+
+    // Every later frame of the same allocations fits, and gets the same addresses
+    chunks = arena.GetStats().mChunkAllocations;
+    for( uint32_t ff=0; ff<3; ff++ )
+    {
+        void *pFirst = arena.Allocate( 100 );
+        for( uint32_t ii=1; ii<100; ii++ )
+        {
+            arena.Allocate( 100 );
+        }
+        CPUT_CHECK( chunks == arena.GetStats().mChunkAllocations );
+        void *pNext = arena.Allocate( 1 );
+        arena.Reset();
+        CPUT_CHECK( pFirst == arena.Allocate( 100 ) );
+        CPUT_CHECK( (uint8_t*)pNext > (uint8_t*)pFirst );
+        arena.Reset();
+    }
+
+    arena.ReleaseMemory();
+    CPUT_CHECK( 0 == arena.GetStats().mCapacity && 0 == arena.GetStats().mUsed );
+    CPUT_CHECK( NULL != arena.Allocate( 100 ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestArenaScope()
+{
+    CPUTArena arena( 1024 );
+    void *pBefore = arena.Allocate( 100 );
+    size_t used   = arena.GetStats().mUsed;
+    void *pInside;
+    {
+        CPUTArenaScope scope( arena );
+        pInside = arena.Allocate( 64 );
+        // Spill into more chunks, which the scope gives back too
+        for( uint32_t ii=0; ii<50; ii++ )
+        {
+            arena.Allocate( 100 );
+        }
+        CPUT_CHECK( arena.GetStats().mUsed > 1024 );
+    }
+    CPUT_CHECK( used == arena.GetStats().mUsed );
+    CPUT_CHECK( pInside == arena.Allocate( 64 ) );
+
+    // Nested: the inner scope leaves the outer one's allocations alone
+    CPUTArena::Mark mark = arena.GetMark();
+    void *pOuter = arena.Allocate( 32 );
+    memset( pOuter, 0x5a, 32 );
+    {
+        CPUTArenaScope scope( arena );
+        memset( arena.Allocate( 2000 ), 0, 2000 );
+    }
+    CPUT_CHECK( 0x5a == ((uint8_t*)pOuter)[31] );
+    CPUT_CHECK( (uint8_t*)arena.Allocate( 1, 1 ) == (uint8_t*)pOuter + 32 );
+    arena.Rewind( mark );
+    CPUT_CHECK( pOuter == arena.Allocate( 32 ) );
+    CPUT_CHECK( pBefore != pOuter );
+}
+
+//-----------------------------------------------------------------------------
+static void TestPool()
+{
+    CPUTPool pool( 40, 8 );
+    CPUT_CHECK( 48 == pool.GetBlockSize() );
+
+    // A chunk's blocks come out in address order, aligned and a block apart
+    std::vector<void*> blocks;
+    for( uint32_t ii=0; ii<8; ii++ )
+    {
+        blocks.push_back( pool.Allocate() );
+        CPUT_CHECK( IsAligned( blocks[ii], 16 ) );
+        if( ii )
+        {
+            CPUT_CHECK( (uint8_t*)blocks[ii] == (uint8_t*)blocks[ii - 1] + 48 );
+        }
+    }
+    CPUT_CHECK( 1 == pool.GetStats().mHeapAllocations );
+    void *pNinth = pool.Allocate();
+    CPUT_CHECK( 2 == pool.GetStats().mHeapAllocations );
+
+    // Freed blocks are reused, most recent first, without another chunk
+    pool.Free( blocks[3] );
+    pool.Free( blocks[5] );
+    CPUT_CHECK( blocks[5] == pool.Allocate() );
+    CPUT_CHECK( blocks[3] == pool.Allocate() );
+    CPUT_CHECK( 2 == pool.GetStats().mHeapAllocations );
+    pool.Free( NULL );
+
+    CPUTPoolStats stats = pool.GetStats();
+    CPUT_CHECK( 11 == stats.mAllocations );
+    CPUT_CHECK( 9 == stats.mLive && 9 == stats.mPeak );
+
+    // Churn at a steady count never goes back to the heap
+    CPUTTestRandom random( 7 );
+    for( uint32_t ii=0; ii<10000; ii++ )
+    {
+        uint32_t index = random.Index( 8 );
+        pool.Free( blocks[index] );
+        blocks[index] = pool.Allocate();
+        memset( blocks[index], (int)index, 48 );
+    }
+    CPUT_CHECK( 2 == pool.GetStats().mHeapAllocations && 9 == pool.GetStats().mLive && 9 == pool.GetStats().mPeak );
+    for( uint32_t ii=0; ii<8; ii++ )
+    {
+        CPUT_CHECK( (uint8_t)ii == ((uint8_t*)blocks[ii])[47] );
+        pool.Free( blocks[ii] );
+    }
+    pool.Free( pNinth );
+    CPUT_CHECK( 0 == pool.GetStats().mLive );
+}
+
+//-----------------------------------------------------------------------------
+static void TestPoolSet()
+{
+    // As CPUTRenderNode's: pools of 64, 128, ... 1024 bytes
+    CPUTPoolSet pools( 64, 1024, 4 );
+    void *p1   = pools.Allocate( 1 );
+    void *p64  = pools.Allocate( 64 );
+    void *p65  = pools.Allocate( 65 );
+    void *pBig = pools.Allocate( 1025 );
+    CPUT_CHECK( IsAligned( p1, 16 ) && IsAligned( p65, 16 ) );
+    memset( pBig, 0, 1025 );
+
+    // 1 and 64 share a pool, so the second block follows the first.  65 is in the next.
+    CPUT_CHECK( (uint8_t*)p64 == (uint8_t*)p1 + 64 );
+    CPUTPoolStats stats = pools.GetStats();
+    CPUT_CHECK( 4 == stats.mAllocations && 4 == stats.mLive );
+    CPUT_CHECK( 3 == stats.mHeapAllocations );   // Two chunks and the large block
+
+    // A freed node's block goes to the next node of its size class
+    pools.Free( p65, 65 );
+    CPUT_CHECK( p65 == pools.Allocate( 128 ) );
+    pools.Free( p64, 64 );
+    CPUT_CHECK( p64 == pools.Allocate( 50 ) );
+    pools.Free( pBig, 1025 );
+    stats = pools.GetStats();
+    CPUT_CHECK( 3 == stats.mLive && 3 == stats.mHeapAllocations );
+
+    // Filling a pool's chunk takes one more chunk from the heap, and no more than that
+    std::vector<void*> blocks;
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        blocks.push_back( pools.Allocate( 200 ) );
+    }
+    CPUT_CHECK( 5 == pools.GetStats().mHeapAllocations );
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        pools.Free( blocks[ii], 200 );
+    }
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        blocks[ii] = pools.Allocate( 200 );
+    }
+    CPUT_CHECK( 5 == pools.GetStats().mHeapAllocations );
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        pools.Free( blocks[ii], 200 );
+    }
+    pools.Free( p1, 1 );
+    pools.Free( p64, 50 );
+    pools.Free( p65, 128 );
+    CPUT_CHECK( 0 == pools.GetStats().mLive );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestArenaAlignment();
+    TestArenaReset();
+    TestArenaScope();
+    TestPool();
+    TestPoolSet();
+    return CPUTTestResult();
+}
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTAnimation.h"
+#include "CPUTThreadPool.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// Channels sampled per millisecond: 2000 channels of 60 keys, uncompressed and fully
+// compressed, played back at 60 frames a second (the cursors find the keys) and at
+// random times (a search every sample), on the calling thread and on a thread pool.
+
+static const uint32_t kChannels = 2000;
+static const uint32_t kKeys     = 60;
+static const uint32_t kFrames   = 500;
+
+static volatile float sSink;
+
+//-----------------------------------------------------------------------------
+static void AddChannels( CPUTAnimationClip *pClip )
+{
+    CPUTTestRandom random( 42 );
+    std::vector<float>      times( kKeys );
+    std::vector<float3>     translations( kKeys, float3(0.0f) ), scales( kKeys, float3(1.0f) );
+    std::vector<quaternion> rotations( kKeys, quaternionIdentity() );
+    for( uint32_t ii=0; ii<kChannels; ii++ )
+    {
+        for( uint32_t kk=0; kk<kKeys; kk++ )
+        {
+            times[kk]        = kk / 30.0f;
+            translations[kk] = float3( random.Float( -1.0f, 1.0f ), random.Float( -1.0f, 1.0f ), random.Float( -1.0f, 1.0f ) );
+            float3 axis( random.Float( -1.0f, 1.0f ), random.Float( -1.0f, 1.0f ), 1.0f );
+            rotations[kk]    = quaternion( axis, random.Float( -1.0f, 1.0f ) );
+        }
+        pClip->AddChannel( kKeys, &times[0], &translations[0], &rotations[0], &scales[0] );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void Run( const char *pName, const CPUTAnimationClip &clip, CPUTThreadPool *pPool )
+{
+    CPUTAnimationSampler sampler( &clip );
+    std::vector<float4x4> matrices( kChannels, float4x4Identity() );
+    for( uint32_t seek=0; seek<2; seek++ )
+    {
+        CPUTTestRandom random( 1 );
+        double start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t ff=0; ff<kFrames; ff++ )
+        {
+            double time = seek ? random.Float( 0.0f, clip.GetDuration() ) : ff / 60.0;
+            sampler.Evaluate( time, true, &matrices[0], pPool );
+            sSink = matrices[ff % kChannels].r3.x;
+        }
+        double milliseconds = (CPUTFrameScheduler::GetSeconds() - start) * 1000.0;
+        printf( "  %-32s %-8s %10.0f channels/ms\n", pName, seek ? "seeking" : "playing", (double)kChannels * kFrames / milliseconds );
+    }
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTAnimationClip uncompressed;
+    CPUTAnimationClip compressed( CPUT_ANIMATION_VECTOR_FIXED16, CPUT_ANIMATION_ROTATION_SMALLEST_THREE, CPUT_ANIMATION_VECTOR_FLOAT16 );
+    AddChannels( &uncompressed );
+    AddChannels( &compressed );
+    printf( "  %u channels of %u keys: %.1f MB uncompressed, %.1f MB compressed\n", kChannels, kKeys,
+            uncompressed.GetKeyDataSize() / 1048576.0, compressed.GetKeyDataSize() / 1048576.0 );
+
+    CPUTThreadPool pool;
+    Run( "Float32", uncompressed, NULL );
+    Run( "Compressed", compressed, NULL );
+    char name[64];
+    sprintf( name, "Float32, %u threads", pool.GetThreadCount() );
+    Run( name, uncompressed, &pool );
+    sprintf( name, "Compressed, %u threads", pool.GetThreadCount() );
+    Run( name, compressed, &pool );
+    return 0;
+}
@@ -0,0 +1,367 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTAnimation.h"
+#include "CPUTThreadPool.h"
+#include "CPUTTest.h"
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+// Checks quaternionSlerp() against slerp in doubles, then builds clips in every key
+// format and checks that sampling (at the keys, between them and outside the tracks)
+// matches the uncompressed keys within the format's quantization error.  A cursor kept
+// through playback, backwards playback and seeks must give the same samples as a fresh
+// one, and Evaluate() on a thread pool the same matrices as Sample().
+
+struct CPUTTestTrack
+{
+    std::vector<float>      mTimes;
+    std::vector<float3>     mTranslations;
+    std::vector<quaternion> mRotations;
+    std::vector<float3>     mScales;
+};
+
+//-----------------------------------------------------------------------------
+static quaternion RandomRotation( CPUTTestRandom &random )
+{
+    float3 axis( random.Float( -1.0f, 1.0f ), random.Float( -1.0f, 1.0f ), random.Float( -1.0f, 1.0f ) + 2.0f );
+    return quaternion( axis, random.Float( -3.14159f, 3.14159f ) );
+}
+
+// Exact slerp along the shorter arc, in doubles
+//-----------------------------------------------------------------------------
+static void ReferenceSlerp( const quaternion &a, const quaternion &b, double t, double *pResult )
+{
+    double qa[4] = { a.x, a.y, a.z, a.w };
+    double qb[4] = { b.x, b.y, b.z, b.w };
+    double cosTheta = qa[0]*qb[0] + qa[1]*qb[1] + qa[2]*qb[2] + qa[3]*qb[3];
+    double sign = cosTheta < 0.0 ? -1.0 : 1.0;
+    cosTheta = cosTheta * sign;
+    double wa = 1.0 - t, wb = t;
+    if( cosTheta < 1.0 - 1e-12 )
+    {
+        double theta = acos( cosTheta );
+        wa = sin( (1.0 - t) * theta ) / sin( theta );
+        wb = sin( t * theta ) / sin( theta );
+    }
+    for( uint32_t ii=0; ii<4; ii++ )
+    {
+        pResult[ii] = qa[ii] * wa + qb[ii] * wb * sign;
+    }
+}
+
+// Largest difference between components of a and b, or a and -b (the same rotation)
+//-----------------------------------------------------------------------------
+static double RotationError( const quaternion &a, const double *pB )
+{
+    double plus = 0.0, minus = 0.0;
+    for( uint32_t ii=0; ii<4; ii++ )
+    {
+        plus  = std::max( plus,  fabs( a.f[ii] - pB[ii] ) );
+        minus = std::max( minus, fabs( a.f[ii] + pB[ii] ) );
+    }
+    return std::min( plus, minus );
+}
+
+//-----------------------------------------------------------------------------
+static void TestSlerp()
+{
+    CPUTTestRandom random( 42 );
+    double worst = 0.0, worstNear = 0.0;
+    for( uint32_t ii=0; ii<20000; ii++ )
+    {
+        quaternion a = RandomRotation( random );
+        quaternion b = RandomRotation( random );
+        float t = 0 == (ii & 15) ? (float)(ii & 16 ? 1 : 0) : random.Float( 0.0f, 1.0f );
+        double expected[4];
+        ReferenceSlerp( a, b, t, expected );
+        double error = RotationError( quaternionSlerp( a, b, t ), expected );
+        double cosTheta = fabs( (double)a.x*b.x + (double)a.y*b.y + (double)a.z*b.z + (double)a.w*b.w );
+        worst = std::max( worst, error );
+        if( cosTheta >= 0.5 ) // Rotations within 120 degrees
+        {
+            worstNear = std::max( worstNear, error );
+        }
+    }
+    // Each weight can be off by the documented error, so a component by up to twice it
+    CPUT_CHECK( worst <= 4e-5 );
+    CPUT_CHECK( worstNear <= 2e-6 );
+
+    // Opposite signs of the same rotation, and the same rotation twice
+    quaternion a = RandomRotation( random );
+    quaternion negated( -a.x, -a.y, -a.z, -a.w );
+    double expected[4] = { a.x, a.y, a.z, a.w };
+    CPUT_CHECK( RotationError( quaternionSlerp( a, negated, 0.3f ), expected ) <= 1e-6 );
+    CPUT_CHECK( RotationError( quaternionSlerp( a, a, 0.7f ), expected ) <= 1e-6 );
+}
+
+// Keys at irregular times, each rotation within 90 degrees of the last, as exported
+// animation would be
+//-----------------------------------------------------------------------------
+static void MakeTrack( CPUTTestRandom &random, uint32_t keyCount, CPUTTestTrack *pTrack )
+{
+    float time = random.Float( 0.0f, 0.5f );
+    quaternion rotation = RandomRotation( random );
+    for( uint32_t ii=0; ii<keyCount; ii++ )
+    {
+        pTrack->mTimes.push_back( time );
+        pTrack->mTranslations.push_back( float3( random.Float( -50.0f, 50.0f ), random.Float( -50.0f, 50.0f ), random.Float( -5.0f, 5.0f ) ) );
+        pTrack->mRotations.push_back( rotation );
+        pTrack->mScales.push_back( float3( random.Float( 0.5f, 2.0f ), 1.0f, random.Float( 0.9f, 1.1f ) ) );
+        time += random.Float( 0.01f, 0.2f );
+        float3 axis( random.Float( -1.0f, 1.0f ), random.Float( -1.0f, 1.0f ) + 2.0f, random.Float( -1.0f, 1.0f ) );
+        rotation = quaternionMultiply( rotation, quaternion( axis, random.Float( -1.57f, 1.57f ) ) );
+        rotation.normalize();
+    }
+}
+
+// The most a decoded component can be off by, for a value in [lo, hi]
+//-----------------------------------------------------------------------------
+static double VectorTolerance( CPUT_ANIMATION_VECTOR_FORMAT format, float lo, float hi )
+{
+    double magnitude = std::max( fabs( lo ), fabs( hi ) );
+    if( CPUT_ANIMATION_VECTOR_FLOAT16 == format )
+    {
+        return magnitude / 2048.0 + 1e-7;   // Half a unit in the last of 11 bits
+    }
+    if( CPUT_ANIMATION_VECTOR_FIXED16 == format )
+    {
+        return (hi - lo) / 65535.0 * 0.5 + magnitude * 1e-6;
+    }
+    return magnitude * 1e-6;
+}
+
+//-----------------------------------------------------------------------------
+static void CheckVector( const float3 &value, const float3 &expected, const float3 &lo, const float3 &hi, CPUT_ANIMATION_VECTOR_FORMAT format, double *pWorst )
+{
+    for( uint32_t cc=0; cc<3; cc++ )
+    {
+        double tolerance = VectorTolerance( format, lo.f[cc], hi.f[cc] );
+        double error = fabs( (double)value.f[cc] - expected.f[cc] );
+        CPUT_CHECK( error <= tolerance );
+        *pWorst = std::max( *pWorst, error / tolerance );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void TestFormat( CPUT_ANIMATION_VECTOR_FORMAT translationFormat, CPUT_ANIMATION_ROTATION_FORMAT rotationFormat, CPUT_ANIMATION_VECTOR_FORMAT scaleFormat )
+{
+    CPUTTestRandom random( 7 + translationFormat * 3 + rotationFormat * 9 + scaleFormat );
+    CPUTAnimationClip clip( translationFormat, rotationFormat, scaleFormat );
+    std::vector<CPUTTestTrack> tracks( 40 );
+    for( uint32_t ii=0; ii<tracks.size(); ii++ )
+    {
+        uint32_t keyCount = ii < 2 ? ii + 1 : 2 + random.Index( 40 );
+        MakeTrack( random, keyCount, &tracks[ii] );
+        const CPUTTestTrack &track = tracks[ii];
+        CPUT_CHECK( ii == clip.AddChannel( keyCount, &track.mTimes[0], &track.mTranslations[0], &track.mRotations[0], &track.mScales[0] ) );
+    }
+
+    // Smallest three keeps 15 bits of components within +-1/sqrt(2), and the largest one
+    // is rebuilt from them.  Interpolating between keys adds the slerp's error.
+    double rotationTolerance = CPUT_ANIMATION_ROTATION_FLOAT32 == rotationFormat ? 2e-6 : 1e-4;
+    double worstTranslation = 0.0, worstScale = 0.0, worstRotation = 0.0;
+    for( uint32_t ii=0; ii<tracks.size(); ii++ )
+    {
+        const CPUTTestTrack &track = tracks[ii];
+        uint32_t keyCount = (uint32_t)track.mTimes.size();
+        float3 translationLo = track.mTranslations[0], translationHi = translationLo;
+        float3 scaleLo = track.mScales[0], scaleHi = scaleLo;
+        for( uint32_t kk=1; kk<keyCount; kk++ )
+        {
+            for( uint32_t cc=0; cc<3; cc++ )
+            {
+                translationLo.f[cc] = std::min( translationLo.f[cc], track.mTranslations[kk].f[cc] );
+                translationHi.f[cc] = std::max( translationHi.f[cc], track.mTranslations[kk].f[cc] );
+                scaleLo.f[cc] = std::min( scaleLo.f[cc], track.mScales[kk].f[cc] );
+                scaleHi.f[cc] = std::max( scaleHi.f[cc], track.mScales[kk].f[cc] );
+            }
+        }
+
+        // At each key, halfway to the next one, at random times, and before and after the track
+        for( uint32_t ss=0; ss<keyCount*3 + 2; ss++ )
+        {
+            uint32_t key = std::min( ss / 3, keyCount - 1 );
+            float t = 0.0f;
+            if( ss == keyCount*3 )
+            {
+                key = 0;
+            }
+            else if( ss == keyCount*3 + 1 )
+            {
+                key = keyCount - 1;
+            }
+            else if( 1 == ss % 3 && key + 1 < keyCount )
+            {
+                t = 0.5f;
+            }
+            else if( 2 == ss % 3 && key + 1 < keyCount )
+            {
+                t = random.Float( 0.0f, 1.0f );
+            }
+            uint32_t next = std::min( key + 1, keyCount - 1 );
+            float time = track.mTimes[key] + (track.mTimes[next] - track.mTimes[key]) * t;
+            time = ss == keyCount*3 ? track.mTimes[0] - 1.0f : (ss == keyCount*3 + 1 ? track.mTimes[keyCount-1] + 1.0f : time);
+            // The fraction the clip will compute from the time
+            if( key + 1 < keyCount )
+            {
+                t = (time - track.mTimes[key]) / (track.mTimes[next] - track.mTimes[key]);
+                t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+            }
+
+            uint32_t cursor = 0;
+            float3 translation, scale;
+            quaternion rotation;
+            clip.Sample( ii, time, &cursor, &translation, &rotation, &scale );
+
+            float3 expectedTranslation = track.mTranslations[key] + (track.mTranslations[next] - track.mTranslations[key]) * t;
+            float3 expectedScale       = track.mScales[key] + (track.mScales[next] - track.mScales[key]) * t;
+            CheckVector( translation, expectedTranslation, translationLo, translationHi, translationFormat, &worstTranslation );
+            CheckVector( scale, expectedScale, scaleLo, scaleHi, scaleFormat, &worstScale );
+            double expectedRotation[4];
+            ReferenceSlerp( track.mRotations[key], track.mRotations[next], t, expectedRotation );
+            double error = RotationError( rotation, expectedRotation );
+            CPUT_CHECK( error <= rotationTolerance );
+            worstRotation = std::max( worstRotation, error / rotationTolerance );
+        }
+    }
+    printf( "  formats %d %d %d: worst errors %.2f, %.2f, %.2f of the tolerance, %u key bytes\n",
+            translationFormat, rotationFormat, scaleFormat, worstTranslation, worstRotation, worstScale, (uint32_t)clip.GetKeyDataSize() );
+}
+
+//-----------------------------------------------------------------------------
+static bool SameSample( const CPUTAnimationClip &clip, uint32_t channel, float time, uint32_t *pCursor )
+{
+    float3 translation[2], scale[2];
+    quaternion rotation[2];
+    uint32_t fresh = 0;
+    clip.Sample( channel, time, pCursor, &translation[0], &rotation[0], &scale[0] );
+    clip.Sample( channel, time, &fresh,  &translation[1], &rotation[1], &scale[1] );
+    return *pCursor == fresh &&
+           0 == memcmp( &translation[0], &translation[1], sizeof(float3) ) &&
+           0 == memcmp( &rotation[0], &rotation[1], sizeof(quaternion) ) &&
+           0 == memcmp( &scale[0], &scale[1], sizeof(float3) );
+}
+
+// A cursor kept between samples only changes where the search starts
+//-----------------------------------------------------------------------------
+static void TestCursor()
+{
+    CPUTTestRandom random( 3 );
+    CPUTAnimationClip clip( CPUT_ANIMATION_VECTOR_FIXED16, CPUT_ANIMATION_ROTATION_SMALLEST_THREE, CPUT_ANIMATION_VECTOR_FLOAT16 );
+    for( uint32_t ii=0; ii<20; ii++ )
+    {
+        CPUTTestTrack track;
+        MakeTrack( random, ii < 2 ? ii + 1 : 2 + random.Index( 60 ), &track );
+        clip.AddChannel( (uint32_t)track.mTimes.size(), &track.mTimes[0], &track.mTranslations[0], &track.mRotations[0], &track.mScales[0] );
+    }
+    float duration = clip.GetDuration();
+    uint32_t mismatches = 0;
+    for( uint32_t ii=0; ii<clip.GetChannelCount(); ii++ )
+    {
+        // Forwards at 60 and 15 frames a second, backwards, and seeks
+        const float steps[3] = { 1.0f / 60.0f, 1.0f / 15.0f, -1.0f / 30.0f };
+        for( uint32_t ss=0; ss<3; ss++ )
+        {
+            uint32_t cursor = 0;
+            for( float time = steps[ss] > 0.0f ? -0.5f : duration + 0.5f; time >= -0.5f && time <= duration + 0.5f; time += steps[ss] )
+            {
+                mismatches += SameSample( clip, ii, time, &cursor ) ? 0 : 1;
+            }
+        }
+        uint32_t cursor = 0;
+        for( uint32_t ss=0; ss<200; ss++ )
+        {
+            mismatches += SameSample( clip, ii, random.Float( -0.5f, duration + 0.5f ), &cursor ) ? 0 : 1;
+        }
+    }
+    CPUT_CHECK( 0 == mismatches );
+}
+
+// scale * rotation * translation, from Sample()
+//-----------------------------------------------------------------------------
+static float4x4 ReferenceMatrix( const CPUTAnimationClip &clip, uint32_t channel, float time )
+{
+    uint32_t cursor = 0;
+    float3 translation, scale;
+    quaternion rotation;
+    clip.Sample( channel, time, &cursor, &translation, &rotation, &scale );
+    float3x3 r = rotation.getMatrix();
+    float4x4 matrix;
+    matrix.r0 = float4( r.r0 * scale.x, 0.0f );
+    matrix.r1 = float4( r.r1 * scale.y, 0.0f );
+    matrix.r2 = float4( r.r2 * scale.z, 0.0f );
+    matrix.r3 = float4( translation, 1.0f );
+    return matrix;
+}
+
+//-----------------------------------------------------------------------------
+static void TestEvaluate()
+{
+    CPUTTestRandom random( 5 );
+    CPUTAnimationClip clip( CPUT_ANIMATION_VECTOR_FLOAT32, CPUT_ANIMATION_ROTATION_SMALLEST_THREE, CPUT_ANIMATION_VECTOR_FIXED16 );
+    // Enough channels for several batches, and a partial one
+    const uint32_t channelCount = CPUT_ANIMATION_BATCH_SIZE * 4 + 13;
+    for( uint32_t ii=0; ii<channelCount; ii++ )
+    {
+        CPUTTestTrack track;
+        MakeTrack( random, 1 + random.Index( 30 ), &track );
+        clip.AddChannel( (uint32_t)track.mTimes.size(), &track.mTimes[0], &track.mTranslations[0], &track.mRotations[0], &track.mScales[0] );
+    }
+    CPUT_CHECK_NEAR( clip.WrapTime( clip.GetDuration() * 2.25 ), clip.GetDuration() * 0.25f, 1e-5 );
+    CPUT_CHECK_NEAR( clip.WrapTime( -clip.GetDuration() * 0.25 ), clip.GetDuration() * 0.75f, 1e-5 );
+
+    CPUTThreadPool pool( 3 );
+    CPUTAnimationSampler serial( &clip ), threaded( &clip );
+    std::vector<float4x4> serialMatrices( channelCount, float4x4Identity() ), threadedMatrices( channelCount, float4x4Identity() );
+    for( uint32_t ff=0; ff<100; ff++ )
+    {
+        double time = ff * 0.05;
+        serial.Evaluate( time, true, &serialMatrices[0] );
+        threaded.Evaluate( time, true, &threadedMatrices[0], &pool );
+        CPUT_CHECK( 0 == memcmp( &serialMatrices[0], &threadedMatrices[0], channelCount * sizeof(float4x4) ) );
+        if( ff % 10 )
+        {
+            continue;
+        }
+        float wrapped = clip.WrapTime( time );
+        for( uint32_t ii=0; ii<channelCount; ii++ )
+        {
+            float4x4 expected = ReferenceMatrix( clip, ii, wrapped );
+            const float *pExpected = (const float*)&expected;
+            const float *pMatrix   = (const float*)&serialMatrices[ii];
+            for( uint32_t ee=0; ee<16; ee++ )
+            {
+                CPUT_CHECK_NEAR( pMatrix[ee], pExpected[ee], 1e-5 * (1.0 + fabs( pExpected[ee] )) );
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestSlerp();
+    const CPUT_ANIMATION_VECTOR_FORMAT vectorFormats[3] = { CPUT_ANIMATION_VECTOR_FLOAT32, CPUT_ANIMATION_VECTOR_FLOAT16, CPUT_ANIMATION_VECTOR_FIXED16 };
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        TestFormat( vectorFormats[ii], CPUT_ANIMATION_ROTATION_FLOAT32, vectorFormats[(ii + 1) % 3] );
+        TestFormat( vectorFormats[ii], CPUT_ANIMATION_ROTATION_SMALLEST_THREE, vectorFormats[ii] );
+    }
+    TestCursor();
+    TestEvaluate();
+    return CPUTTestResult();
+}
@@ -0,0 +1,161 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTBVH.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <float.h>
+
+// Build, refit and query times for a CPUTBVH over 100k boxes, with frustum and box queries
+// next to testing every box.  The rays are cast against the boxes, with no primitive tester.
+
+static const uint32_t kCount   = 100000;
+static const uint32_t kQueries = 1000;
+static const uint32_t kRays    = 100000;
+
+static volatile uint32_t sSink;
+
+//-----------------------------------------------------------------------------
+static double Milliseconds( double startSeconds )
+{
+    return (CPUTFrameScheduler::GetSeconds() - startSeconds) * 1000.0;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTTestRandom random( 29 );
+    std::vector<float3> centers( kCount, float3(0.0f) ), halves( kCount, float3(0.0f) );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        centers[ii] = float3( random.Float( -1000.0f, 1000.0f ), random.Float( -100.0f, 100.0f ), random.Float( -1000.0f, 1000.0f ) );
+        halves[ii]  = float3( random.Float( 0.5f, 5.0f ), random.Float( 0.5f, 5.0f ), random.Float( 0.5f, 5.0f ) );
+    }
+
+    CPUTBVH bvh;
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        bvh.AddPrimitive( centers[ii], halves[ii] );
+    }
+    double start = CPUTFrameScheduler::GetSeconds();
+    bvh.Build();
+    printf( "  %-32s %8.2f ms (%u nodes, cost %.1f)\n", "Build", Milliseconds( start ), bvh.GetNodeCount(), bvh.GetCost() );
+
+    // One box in ten moves a little, as animated props would
+    for( uint32_t ii=0; ii<kCount; ii += 10 )
+    {
+        centers[ii] = centers[ii] + float3( random.Float( -1.0f, 1.0f ), 0.0f, random.Float( -1.0f, 1.0f ) );
+        bvh.SetPrimitive( ii, centers[ii], halves[ii] );
+    }
+    start = CPUTFrameScheduler::GetSeconds();
+    bvh.Refit();
+    printf( "  %-32s %8.2f ms (cost %.1f)\n", "Refit", Milliseconds( start ), bvh.GetCost() );
+
+    // A 90 degree frustum from the middle, looking along +z (about a quarter of the boxes)
+    const float s = 0.70710678f;
+    const float planes[6*4] =
+    {
+        -s, 0.0f, -s, 0.0f,     s, 0.0f, -s, 0.0f,
+        0.0f, -s, -s, 0.0f,     0.0f, s, -s, 0.0f,
+        0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, -1000.0f,
+    };
+    std::vector<uint32_t> results;
+    results.reserve( kCount );
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t qq=0; qq<100; qq++ )
+    {
+        results.clear();
+        bvh.QueryFrustum( planes, 6, results );
+    }
+    printf( "  %-32s %8.3f ms, %u boxes\n", "QueryFrustum", Milliseconds( start ) / 100, (uint32_t)results.size() );
+    start = CPUTFrameScheduler::GetSeconds();
+    uint32_t visible = 0;
+    for( uint32_t qq=0; qq<10; qq++ )
+    {
+        visible = 0;
+        for( uint32_t ii=0; ii<kCount; ii++ )
+        {
+            bool culled = false;
+            for( uint32_t pp=0; pp<6 && !culled; pp++ )
+            {
+                const float *pPlane = planes + pp*4;
+                float distance = pPlane[0]*centers[ii].x + pPlane[1]*centers[ii].y + pPlane[2]*centers[ii].z + pPlane[3];
+                culled = distance >= fabsf(pPlane[0])*halves[ii].x + fabsf(pPlane[1])*halves[ii].y + fabsf(pPlane[2])*halves[ii].z;
+            }
+            visible += culled ? 0 : 1;
+        }
+    }
+    printf( "  %-32s %8.3f ms, %u boxes\n", "Frustum test on every box", Milliseconds( start ) / 10, visible );
+
+    // Boxes the size of a room, and points
+    std::vector<float3> queryCenters( kQueries, float3(0.0f) );
+    for( uint32_t qq=0; qq<kQueries; qq++ )
+    {
+        queryCenters[qq] = float3( random.Float( -1000.0f, 1000.0f ), random.Float( -100.0f, 100.0f ), random.Float( -1000.0f, 1000.0f ) );
+    }
+    const float3 queryHalf( 20.0f, 20.0f, 20.0f );
+    uint32_t found = 0;
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t qq=0; qq<kQueries; qq++ )
+    {
+        results.clear();
+        found += bvh.QueryBox( queryCenters[qq], queryHalf, results );
+    }
+    printf( "  %-32s %8.2f us, %.1f boxes each\n", "QueryBox", Milliseconds( start ) * 1000.0 / kQueries, (float)found / kQueries );
+    found = 0;
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t qq=0; qq<kQueries; qq++ )
+    {
+        results.clear();
+        found += bvh.QueryPoint( queryCenters[qq], results );
+    }
+    printf( "  %-32s %8.2f us, %.2f boxes each\n", "QueryPoint", Milliseconds( start ) * 1000.0 / kQueries, (float)found / kQueries );
+    found = 0;
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t qq=0; qq<kQueries / 10; qq++ )
+    {
+        for( uint32_t ii=0; ii<kCount; ii++ )
+        {
+            found += (fabsf( centers[ii].x - queryCenters[qq].x ) <= halves[ii].x + queryHalf.x &&
+                      fabsf( centers[ii].y - queryCenters[qq].y ) <= halves[ii].y + queryHalf.y &&
+                      fabsf( centers[ii].z - queryCenters[qq].z ) <= halves[ii].z + queryHalf.z) ? 1 : 0;
+        }
+    }
+    printf( "  %-32s %8.2f us, %.1f boxes each\n", "Box test on every box", Milliseconds( start ) * 1000.0 / (kQueries / 10), (float)found / (kQueries / 10) );
+
+    // Rays from above, down through the boxes, and level rays along the axes
+    uint32_t hits = 0;
+    CPUTBVHRayHit hit;
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRays; rr++ )
+    {
+        float3 origin( random.Float( -1000.0f, 1000.0f ), 200.0f, random.Float( -1000.0f, 1000.0f ) );
+        float3 direction = normalize( float3( random.Float( -1.0f, 1.0f ), -1.0f, random.Float( -1.0f, 1.0f ) ) );
+        hits += bvh.Raycast( origin, direction, 2000.0f, NULL, &hit ) ? 1 : 0;
+    }
+    printf( "  %-32s %8.2f ms per %u, %u hit\n", "Raycast (down)", Milliseconds( start ), kRays, hits );
+    hits = 0;
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRays; rr++ )
+    {
+        float3 origin( random.Float( -1000.0f, 1000.0f ), random.Float( -100.0f, 100.0f ), random.Float( -1000.0f, 1000.0f ) );
+        float3 direction( 0.0f, 0.0f, 0.0f );
+        direction.f[(rr & 1) * 2] = (rr & 2) ? -1.0f : 1.0f;
+        hits += bvh.Raycast( origin, direction, 2000.0f, NULL, &hit ) ? 1 : 0;
+    }
+    printf( "  %-32s %8.2f ms per %u, %u hit\n", "Raycast (along x or z)", Milliseconds( start ), kRays, hits );
+    sSink = hits + found + visible;
+    return 0;
+}
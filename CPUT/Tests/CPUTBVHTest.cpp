@@ -0,0 +1,332 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTBVH.h"
+#include "CPUTTest.h"
+#include <float.h>
+#include <algorithm>
+
+// CPUTBVH's queries against a scan over every box, after Build() and again after the boxes
+// move and Refit() or Update() adjusts the tree.  Plus rays along the axes that start on a
+// box's face, as the level collision casts do against walls.
+
+static const uint32_t kBoxCount = 5000;
+
+//-----------------------------------------------------------------------------
+struct CPUTTestBoxes
+{
+    std::vector<float3> mCenters;
+    std::vector<float3> mHalves;
+
+    void Randomize( CPUTTestRandom &random, uint32_t count, float range )
+    {
+        mCenters.resize( count, float3(0.0f) );
+        mHalves.resize( count, float3(0.0f) );
+        for( uint32_t ii=0; ii<count; ii++ )
+        {
+            mCenters[ii] = float3( random.Float( -range, range ), random.Float( -range, range ), random.Float( -range, range ) );
+            mHalves[ii]  = float3( random.Float( 0.0f, 4.0f ), random.Float( 0.0f, 4.0f ), random.Float( 0.0f, 4.0f ) );
+        }
+        // Some flat boxes and a point, like walls, floors and markers
+        mHalves[0].x = 0.0f;
+        mHalves[1].y = 0.0f;
+        mHalves[2]   = float3(0.0f);
+    }
+};
+
+//-----------------------------------------------------------------------------
+static std::vector<uint32_t> Sorted( std::vector<uint32_t> results )
+{
+    std::sort( results.begin(), results.end() );
+    return results;
+}
+
+// As CPUTBVH tests a box against a plane, so that boxes touching it agree
+//-----------------------------------------------------------------------------
+static bool InFrontOf( const float *pPlane, const float3 &center, const float3 &half )
+{
+    float3 boxMin = center - half, boxMax = center + half;
+    float cx = (boxMax.x + boxMin.x) * 0.5f, hx = (boxMax.x - boxMin.x) * 0.5f;
+    float cy = (boxMax.y + boxMin.y) * 0.5f, hy = (boxMax.y - boxMin.y) * 0.5f;
+    float cz = (boxMax.z + boxMin.z) * 0.5f, hz = (boxMax.z - boxMin.z) * 0.5f;
+    float distance = pPlane[0]*cx + pPlane[1]*cy + pPlane[2]*cz + pPlane[3];
+    float radius   = fabsf(pPlane[0])*hx + fabsf(pPlane[1])*hy + fabsf(pPlane[2])*hz;
+    return distance >= radius;
+}
+
+// Where the ray enters the box (0 if it starts inside), or FLT_MAX.  Divides rather than
+// multiplying by a reciprocal, and treats an axis the ray doesn't move along separately.
+//-----------------------------------------------------------------------------
+static float RayBoxDistance( const float3 &center, const float3 &half, const float3 &origin, const float3 &direction, float maxDistance )
+{
+    float3 boxMin = center - half, boxMax = center + half;
+    float tNear = 0.0f, tFar = maxDistance;
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        if( 0.0f == direction.f[ii] )
+        {
+            if( origin.f[ii] < boxMin.f[ii] || origin.f[ii] > boxMax.f[ii] )
+            {
+                return FLT_MAX;
+            }
+            continue;
+        }
+        float t0 = (boxMin.f[ii] - origin.f[ii]) / direction.f[ii];
+        float t1 = (boxMax.f[ii] - origin.f[ii]) / direction.f[ii];
+        tNear = std::max( tNear, std::min( t0, t1 ) );
+        tFar  = std::min( tFar,  std::max( t0, t1 ) );
+    }
+    return tNear <= tFar ? tNear : FLT_MAX;
+}
+
+// Every query against the scan
+//-----------------------------------------------------------------------------
+static void CheckQueries( const CPUTBVH &bvh, const CPUTTestBoxes &boxes, CPUTTestRandom &random )
+{
+    uint32_t count = (uint32_t)boxes.mCenters.size();
+    for( uint32_t qq=0; qq<20; qq++ )
+    {
+        // Six random planes, roughly a box around a random point
+        float planes[6*4];
+        float3 focus( random.Float( -50.0f, 50.0f ), random.Float( -50.0f, 50.0f ), random.Float( -50.0f, 50.0f ) );
+        for( uint32_t pp=0; pp<6; pp++ )
+        {
+            float3 normal( random.Float( -0.3f, 0.3f ), random.Float( -0.3f, 0.3f ), random.Float( -0.3f, 0.3f ) );
+            normal.f[pp/2] = (pp & 1) ? -1.0f : 1.0f;
+            normal = normalize( normal );
+            float3 onPlane = focus + normal * random.Float( 5.0f, 40.0f );
+            planes[pp*4+0] = normal.x;  planes[pp*4+1] = normal.y;  planes[pp*4+2] = normal.z;
+            planes[pp*4+3] = -dot3( normal, onPlane );
+        }
+        std::vector<uint32_t> results, expected;
+        uint32_t found = bvh.QueryFrustum( planes, 6, results );
+        CPUT_CHECK( found == results.size() );
+        for( uint32_t ii=0; ii<count; ii++ )
+        {
+            bool culled = false;
+            for( uint32_t pp=0; pp<6 && !culled; pp++ )
+            {
+                culled = InFrontOf( planes + pp*4, boxes.mCenters[ii], boxes.mHalves[ii] );
+            }
+            if( !culled )
+            {
+                expected.push_back( ii );
+            }
+        }
+        CPUT_CHECK( Sorted( results ) == expected );
+
+        // A box, and a point on a box's corner
+        float3 center( random.Float( -60.0f, 60.0f ), random.Float( -60.0f, 60.0f ), random.Float( -60.0f, 60.0f ) );
+        float3 half( random.Float( 0.0f, 10.0f ), random.Float( 0.0f, 10.0f ), random.Float( 0.0f, 10.0f ) );
+        float3 point = boxes.mCenters[qq] + boxes.mHalves[qq];
+        for( uint32_t isPoint=0; isPoint<2; isPoint++ )
+        {
+            float3 queryMin = isPoint ? point : center - half;
+            float3 queryMax = isPoint ? point : center + half;
+            results.clear();
+            expected.clear();
+            found = isPoint ? bvh.QueryPoint( point, results ) : bvh.QueryBox( center, half, results );
+            CPUT_CHECK( found == results.size() );
+            for( uint32_t ii=0; ii<count; ii++ )
+            {
+                float3 boxMin = boxes.mCenters[ii] - boxes.mHalves[ii], boxMax = boxes.mCenters[ii] + boxes.mHalves[ii];
+                if( boxMin.x <= queryMax.x && boxMax.x >= queryMin.x && boxMin.y <= queryMax.y && boxMax.y >= queryMin.y &&
+                    boxMin.z <= queryMax.z && boxMax.z >= queryMin.z )
+                {
+                    expected.push_back( ii );
+                }
+            }
+            CPUT_CHECK( Sorted( results ) == expected );
+            CPUT_CHECK( !isPoint || !results.empty() ); // At least the box it's on
+        }
+
+        // A ray from outside everything, and one from inside
+        for( uint32_t inside=0; inside<2; inside++ )
+        {
+            float3 origin = inside ? boxes.mCenters[qq] : float3( random.Float( -60.0f, 60.0f ), 200.0f, random.Float( -60.0f, 60.0f ) );
+            float3 target( random.Float( -40.0f, 40.0f ), random.Float( -40.0f, 40.0f ), random.Float( -40.0f, 40.0f ) );
+            float3 direction = normalize( target - origin );
+            float closest = FLT_MAX;
+            for( uint32_t ii=0; ii<count; ii++ )
+            {
+                closest = std::min( closest, RayBoxDistance( boxes.mCenters[ii], boxes.mHalves[ii], origin, direction, 1000.0f ) );
+            }
+            CPUTBVHRayHit hit;
+            bool isHit = bvh.Raycast( origin, direction, 1000.0f, NULL, &hit );
+            CPUT_CHECK( isHit == (FLT_MAX != closest) );
+            if( isHit && FLT_MAX != closest )
+            {
+                CPUT_CHECK_NEAR( hit.mDistance, closest, 1e-3 );
+                CPUT_CHECK_NEAR( RayBoxDistance( boxes.mCenters[hit.mPrimitive], boxes.mHalves[hit.mPrimitive], origin, direction, 1000.0f ), closest, 1e-3 );
+            }
+            CPUT_CHECK( !inside || (isHit && 0.0f == hit.mDistance) );
+        }
+    }
+}
+
+// Build, then move the boxes and refit, then move them far enough that Update() rebuilds
+//-----------------------------------------------------------------------------
+static void TestAgainstScan()
+{
+    CPUTTestRandom random( 29 );
+    CPUTTestBoxes boxes;
+    boxes.Randomize( random, kBoxCount, 50.0f );
+    CPUTBVH bvh;
+    for( uint32_t ii=0; ii<kBoxCount; ii++ )
+    {
+        CPUT_CHECK( ii == bvh.AddPrimitive( boxes.mCenters[ii], boxes.mHalves[ii] ) );
+    }
+    bvh.Update();
+    CPUT_CHECK( kBoxCount == bvh.GetPrimitiveCount() && bvh.GetNodeCount() > kBoxCount / 4 );
+    float buildCost = bvh.GetCost();
+    CheckQueries( bvh, boxes, random );
+
+    // A little movement: the refitted tree answers the same as the scan
+    for( uint32_t ii=0; ii<kBoxCount; ii += 3 )
+    {
+        boxes.mCenters[ii] = boxes.mCenters[ii] + float3( random.Float( -2.0f, 2.0f ), random.Float( -2.0f, 2.0f ), random.Float( -2.0f, 2.0f ) );
+        bvh.SetPrimitive( ii, boxes.mCenters[ii], boxes.mHalves[ii] );
+    }
+    bvh.Refit();
+    CPUT_CHECK( !bvh.NeedsRebuild() && bvh.GetCost() >= buildCost * 0.9f );
+    CheckQueries( bvh, boxes, random );
+
+    // Scattering the boxes makes the old tree much worse than a new one
+    CPUTTestBoxes scattered;
+    scattered.Randomize( random, kBoxCount, 50.0f );
+    for( uint32_t ii=0; ii<kBoxCount; ii++ )
+    {
+        bvh.SetPrimitive( ii, scattered.mCenters[ii], scattered.mHalves[ii] );
+    }
+    bvh.Refit();
+    CPUT_CHECK( bvh.NeedsRebuild() );
+    CheckQueries( bvh, scattered, random ); // Slow, but still right
+    bvh.SetPrimitive( 0, scattered.mCenters[0], scattered.mHalves[0] );
+    bvh.Update();
+    CPUT_CHECK( !bvh.NeedsRebuild() && bvh.GetCost() < buildCost * 1.5f );
+    CheckQueries( bvh, scattered, random );
+
+    // Adding a box after a build rebuilds
+    scattered.mCenters.push_back( float3( 500.0f, 0.0f, 0.0f ) );
+    scattered.mHalves.push_back( float3( 1.0f ) );
+    bvh.AddPrimitive( scattered.mCenters.back(), scattered.mHalves.back() );
+    bvh.Update();
+    float3 center, half;
+    bvh.GetBounds( &center, &half );
+    CPUT_CHECK( center.x + half.x == 501.0f );
+    CheckQueries( bvh, scattered, random );
+}
+
+// Counts the tester's calls, and hits a primitive's box only when the primitive is odd
+//-----------------------------------------------------------------------------
+class CPUTTestOddTester : public CPUTBVHRayTester
+{
+public:
+    const CPUTTestBoxes *mpBoxes;
+    uint32_t             mCalls;
+
+    CPUTTestOddTester( const CPUTTestBoxes *pBoxes ) : mpBoxes(pBoxes), mCalls(0) {}
+    bool IntersectRay( uint32_t primitive, const float3 &origin, const float3 &direction, float maxDistance, float *pDistance )
+    {
+        mCalls++;
+        *pDistance = RayBoxDistance( mpBoxes->mCenters[primitive], mpBoxes->mHalves[primitive], origin, direction, maxDistance );
+        return (primitive & 1) && FLT_MAX != *pDistance;
+    }
+};
+
+// A wall of boxes, hit by rays along the axes whose origins lie on the boxes' faces, with
+// +0 and -0 in the directions' other components.  Also a primitive tester.
+//-----------------------------------------------------------------------------
+static void TestAxisAlignedRays()
+{
+    CPUTTestBoxes wall;
+    CPUTBVH bvh;
+    bvh.SetMaxLeafSize( 2 );
+    for( uint32_t ii=0; ii<10; ii++ )
+    {
+        for( uint32_t jj=0; jj<10; jj++ )
+        {
+            // 10x10 cells covering x, y in [0, 100], between z = 50 and z = 52
+            wall.mCenters.push_back( float3( ii * 10.0f + 5.0f, jj * 10.0f + 5.0f, 51.0f ) );
+            wall.mHalves.push_back( float3( 5.0f, 5.0f, 1.0f ) );
+            bvh.AddPrimitive( wall.mCenters.back(), wall.mHalves.back() );
+        }
+    }
+    bvh.Build();
+
+    const float zeros[2] = { 0.0f, -0.0f };
+    const float edges[3] = { 0.0f, 40.0f, 100.0f }; // The wall's sides, and a face between cells
+    for( uint32_t ee=0; ee<3; ee++ )
+    {
+        for( uint32_t zz=0; zz<4; zz++ )
+        {
+            for( uint32_t forward=0; forward<2; forward++ )
+            {
+                float  z = forward ? 0.0f : 100.0f;
+                float3 origin( edges[ee], edges[2-ee] + (0 == ee ? 0.0f : 5.0f), z );
+                float3 direction( zeros[zz & 1], zeros[zz >> 1], forward ? 1.0f : -1.0f );
+                float  expected = forward ? 50.0f : 48.0f;
+                CPUTBVHRayHit hit;
+                bool isHit = bvh.Raycast( origin, direction, 1000.0f, NULL, &hit );
+                CPUT_CHECK( isHit );
+                if( isHit )
+                {
+                    CPUT_CHECK( expected == hit.mDistance );
+                    CPUT_CHECK( 0.0f == RayBoxDistance( wall.mCenters[hit.mPrimitive], wall.mHalves[hit.mPrimitive], origin + direction * expected, direction, 1.0f ) );
+                }
+
+                // Just outside the wall misses
+                origin.x = -0.001f;
+                CPUT_CHECK( !bvh.Raycast( origin, direction, 1000.0f, NULL, &hit ) );
+            }
+        }
+    }
+
+    // Along the wall's face, inside it, and too short to reach it
+    CPUTBVHRayHit hit;
+    CPUT_CHECK( bvh.Raycast( float3( -10.0f, 5.0f, 50.0f ), float3( 1.0f, 0.0f, 0.0f ), 1000.0f, NULL, &hit ) && 10.0f == hit.mDistance );
+    CPUT_CHECK( bvh.Raycast( float3( 55.0f, 55.0f, 51.0f ), float3( 0.0f, -1.0f, 0.0f ), 1000.0f, NULL, &hit ) && 0.0f == hit.mDistance );
+    CPUT_CHECK( !bvh.Raycast( float3( 5.0f, 5.0f, 0.0f ), float3( 0.0f, 0.0f, 1.0f ), 49.0f, NULL, &hit ) );
+
+    // With a tester, the closest primitive it accepts
+    CPUTTestOddTester tester( &wall );
+    CPUT_CHECK( bvh.Raycast( float3( -10.0f, 15.0f, 51.0f ), float3( 1.0f, 0.0f, 0.0f ), 1000.0f, &tester, &hit ) );
+    CPUT_CHECK( 1 == hit.mPrimitive && 10.0f == hit.mDistance ); // Cells 1, 11, 21 ... are along y = 15
+    CPUT_CHECK( tester.mCalls > 0 && tester.mCalls < 100 );
+    CPUT_CHECK( !bvh.Raycast( float3( -10.0f, 5.0f, 51.0f ), float3( 1.0f, 0.0f, 0.0f ), 1000.0f, &tester, &hit ) ); // Only even cells
+}
+
+//-----------------------------------------------------------------------------
+static void TestEmpty()
+{
+    CPUTBVH bvh;
+    bvh.Update();
+    std::vector<uint32_t> results;
+    CPUTBVHRayHit hit;
+    CPUT_CHECK( 0 == bvh.QueryPoint( float3(0.0f), results ) && results.empty() );
+    CPUT_CHECK( !bvh.Raycast( float3(0.0f), float3( 1.0f, 0.0f, 0.0f ), 10.0f, NULL, &hit ) );
+    float3 center( 1.0f ), half( 1.0f );
+    bvh.GetBounds( &center, &half );
+    CPUT_CHECK( 0.0f == center.x && 0.0f == half.x );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestAgainstScan();
+    TestAxisAlignedRays();
+    TestEmpty();
+    return CPUTTestResult();
+}
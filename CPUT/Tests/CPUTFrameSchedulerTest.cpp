@@ -0,0 +1,229 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// CPUTFrameScheduler against a virtual clock.  The loop below does what the message loop
+// does, except that a frame takes a fixed time, a wait takes exactly as long as asked
+// unless a message arrives first, and messages arrive at given times.
+
+static const double kTolerance = 1e-9;
+
+//-----------------------------------------------------------------------------
+struct CPUTVirtualLoop
+{
+    CPUTFrameScheduler  mScheduler;
+    double              mNow;
+    double              mFrameSeconds;      // How long each frame takes
+    bool                mMotion;            // Each frame reports activity
+    std::vector<double> mFrames;            // When each frame began
+    std::vector<double> mMessages;          // When messages arrive, ascending
+    size_t              mNextMessage;
+    double              mLongestIdleWait;
+
+    CPUTVirtualLoop() : mNow(0.0), mFrameSeconds(0.004), mMotion(true), mNextMessage(0), mLongestIdleWait(0.0) {}
+
+    void Run( double until )
+    {
+        while( mNow < until )
+        {
+            double wait = 0.0;
+            switch( mScheduler.GetAction( mNow, &wait ) )
+            {
+            case CPUT_FRAME_RENDER:
+                mScheduler.BeginFrame( mNow );
+                mFrames.push_back( mNow );
+                if( mMotion )
+                {
+                    mScheduler.ReportActivity( mNow );
+                }
+                mNow += mFrameSeconds;
+                mScheduler.EndFrame( 0.5 * mFrameSeconds );
+                break;
+            case CPUT_FRAME_POLL:
+                mScheduler.Polled( mNow );
+                break;
+            case CPUT_FRAME_WAIT:
+            {
+                CPUT_CHECK( wait > 0.0 );
+                if( mScheduler.IsIdle( mNow ) )
+                {
+                    mLongestIdleWait = wait > mLongestIdleWait ? wait : mLongestIdleWait;
+                }
+                bool byMessage = mNextMessage < mMessages.size() && mMessages[mNextMessage] < mNow + wait;
+                mNow = byMessage ? mMessages[mNextMessage++] : mNow + wait;
+                mScheduler.Woke( byMessage );
+                if( byMessage )
+                {
+                    mScheduler.ReportActivity( mNow ); // Input messages count as activity
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    uint32_t CountFrames( double start, double end ) const
+    {
+        uint32_t count = 0;
+        for( size_t ii=0; ii<mFrames.size(); ii++ )
+        {
+            count += (mFrames[ii] >= start && mFrames[ii] < end) ? 1 : 0;
+        }
+        return count;
+    }
+};
+
+// Frames land on the 60 Hz grid, and activity while active doesn't disturb it
+//-----------------------------------------------------------------------------
+static void TestTargetRate()
+{
+    CPUTVirtualLoop loop;
+    loop.mScheduler.SetTargetRate( 60.0 );
+    CPUT_CHECK_NEAR( loop.mScheduler.GetTargetRate(), 60.0, kTolerance );
+    loop.mScheduler.Reset( 0.0 );
+    loop.Run( 1.0 - 0.001 );
+
+    CPUT_CHECK( 60 == loop.mFrames.size() );
+    for( size_t ii=0; ii<loop.mFrames.size(); ii++ )
+    {
+        CPUT_CHECK_NEAR( loop.mFrames[ii], ii / 60.0, kTolerance );
+    }
+    const CPUTFrameSchedulerStats &stats = loop.mScheduler.GetStats();
+    CPUT_CHECK( 60 == stats.mFrames );
+    CPUT_CHECK( 0 == stats.mIdleFrames && 0 == stats.mPolls && 0 == stats.mActivityWakeups );
+    CPUT_CHECK( 60 == stats.mWakeups && 0 == stats.mEventWakeups ); // One after each frame
+    CPUT_CHECK_NEAR( stats.GetCPUSecondsPerFrame(), 0.002, kTolerance );
+    CPUT_CHECK_NEAR( stats.mLastCPUSeconds, 0.002, kTolerance );
+
+    loop.mScheduler.ResetStats();
+    CPUT_CHECK( 0 == loop.mScheduler.GetStats().mFrames );
+    CPUT_CHECK_NEAR( loop.mScheduler.GetStats().GetCPUSecondsPerFrame(), 0.0, kTolerance );
+}
+
+// A frame that overruns by less than a period makes the next one late, but the one after
+// is back on the grid.  One that overruns by more restarts the grid when the next begins.
+//-----------------------------------------------------------------------------
+static void TestLateFrames()
+{
+    const double period = 1.0 / 60.0;
+    const double lateSeconds[2] = { 0.025, 0.040 };
+    for( uint32_t ll=0; ll<2; ll++ )
+    {
+        CPUTFrameScheduler scheduler;
+        scheduler.SetTargetRate( 60.0 );
+        scheduler.Reset( 0.0 );
+        std::vector<double> frames;
+        double now = 0.0;
+        while( frames.size() < 16 )
+        {
+            double wait = 0.0;
+            if( CPUT_FRAME_RENDER == scheduler.GetAction( now, &wait ) )
+            {
+                scheduler.BeginFrame( now );
+                frames.push_back( now );
+                now += 11 == frames.size() ? lateSeconds[ll] : 0.004;
+            }
+            else
+            {
+                now += wait;
+            }
+        }
+        CPUT_CHECK_NEAR( frames[10], 10 * period, kTolerance );
+        CPUT_CHECK_NEAR( frames[11], 10 * period + lateSeconds[ll], kTolerance ); // Starts as soon as 10 ends
+        double gridStart = 0 == ll ? 0.0 : frames[11] - 11 * period;
+        for( uint32_t ii=12; ii<frames.size(); ii++ )
+        {
+            CPUT_CHECK_NEAR( frames[ii], gridStart + ii * period, kTolerance );
+        }
+    }
+}
+
+// Motion stops at 0.  After the idle delay frames drop to 4 Hz with polls at 30 Hz in
+// between, until a message at 4.11 s makes a frame due at once.  The delay is a little
+// under 2 s, so that the frame on the grid at 2 s is the first idle one.
+//-----------------------------------------------------------------------------
+static void TestIdleThrottling()
+{
+    CPUTVirtualLoop loop;
+    CPUTFrameScheduler &scheduler = loop.mScheduler;
+    scheduler.SetTargetRate( 60.0 );
+    scheduler.SetIdleThrottling( true );
+    scheduler.SetIdleRate( 4.0 );
+    scheduler.SetPollRate( 30.0 );
+    scheduler.SetIdleDelay( 1.995 );
+    scheduler.Reset( 0.0 );
+    loop.mMotion = false;
+    loop.mMessages.push_back( 4.11 );
+    loop.Run( 5.0 - 0.001 );
+
+    CPUT_CHECK( 120 == loop.CountFrames( 0.0, 1.99 ) );
+    CPUT_CHECK( 9   == loop.CountFrames( 1.99, 4.1 ) );    // 2.0, 2.25 ... 4.0
+    for( uint32_t ii=0; ii<9; ii++ )
+    {
+        CPUT_CHECK_NEAR( loop.mFrames[120 + ii], 2.0 + ii * 0.25, kTolerance );
+    }
+    CPUT_CHECK_NEAR( loop.mFrames[129], 4.11, kTolerance ); // The message's frame doesn't wait for the grid
+    CPUT_CHECK_NEAR( loop.mFrames[130], 4.11 + 1.0 / 60.0, kTolerance );
+    CPUT_CHECK( 54 == loop.CountFrames( 4.1, 5.0 ) );     // 60 Hz again
+    CPUT_CHECK( loop.mLongestIdleWait <= 1.0 / 30.0 + kTolerance );
+
+    const CPUTFrameSchedulerStats &stats = scheduler.GetStats();
+    CPUT_CHECK( 9 == stats.mIdleFrames );
+    CPUT_CHECK( 8 * 7 + 3 == stats.mPolls ); // Seven between idle frames, three after 4.0 before the message
+    CPUT_CHECK( 1 == stats.mEventWakeups );
+    CPUT_CHECK( 1 == stats.mActivityWakeups );
+    CPUT_CHECK( !scheduler.IsIdle( 4.2 ) );
+    CPUT_CHECK( scheduler.IsIdle( 7.0 ) );
+
+    // Activity while active doesn't move the next frame
+    double wait = 0.0;
+    scheduler.ReportActivity( 4.99 );
+    CPUT_CHECK( CPUT_FRAME_WAIT == scheduler.GetAction( 4.991, &wait ) );
+    CPUT_CHECK( 1 == scheduler.GetStats().mActivityWakeups );
+
+    // Throttling off: never idle, however long since the last activity
+    scheduler.SetIdleThrottling( false );
+    CPUT_CHECK( !scheduler.IsIdle( 100.0 ) );
+}
+
+// No target rate renders whenever asked
+//-----------------------------------------------------------------------------
+static void TestUnlimited()
+{
+    CPUTFrameScheduler scheduler;
+    CPUT_CHECK_NEAR( scheduler.GetTargetRate(), 0.0, kTolerance );
+    scheduler.Reset( 0.0 );
+    for( uint32_t ii=0; ii<10; ii++ )
+    {
+        double wait = -1.0;
+        CPUT_CHECK( CPUT_FRAME_RENDER == scheduler.GetAction( ii * 0.001, &wait ) );
+        CPUT_CHECK( -1.0 == wait ); // Untouched unless waiting
+        scheduler.BeginFrame( ii * 0.001 );
+    }
+    CPUT_CHECK( 10 == scheduler.GetStats().mFrames );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestTargetRate();
+    TestLateFrames();
+    TestIdleThrottling();
+    TestUnlimited();
+    return CPUTTestResult();
+}
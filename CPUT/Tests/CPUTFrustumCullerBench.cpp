@@ -0,0 +1,83 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFrustumCuller.h"
+#include "CPUTFrustum.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// Time to cull 100k boxes with CPUTFrustumCuller (SIMD and scalar), next to calling
+// CPUTFrustum::IsVisible on each.  About one box in eight is visible.
+
+static const uint32_t kCount       = 100000;
+static const uint32_t kRepetitions = 50;
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, double startSeconds, uint32_t visibleCount )
+{
+    double seconds = (CPUTFrameScheduler::GetSeconds() - startSeconds) / kRepetitions;
+    printf( "  %-28s %7.3f ms per %u boxes (%.2f ns/box), %u visible\n", pName, seconds * 1e3, kCount, seconds * 1e9 / kCount, visibleCount );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTTestRandom random( 3 );
+    CPUTFrustum frustum;
+    frustum.InitializeFrustum( 1.0f, 500.0f, 1.6f, 1.0f, float3( 3.0f, 2.0f, 1.0f ), float3( 0.6f, 0.0f, 0.8f ), float3( 0.0f, 1.0f, 0.0f ) );
+
+    CPUTFrustumCuller culler;
+    culler.SetPlanes( frustum.mpNormal, frustum.mpPosition[0], frustum.mpPosition[6] );
+    culler.Reserve( kCount );
+    const float3 zero( 0.0f, 0.0f, 0.0f );
+    std::vector<float3> centers( kCount, zero ), halves( kCount, zero );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        centers[ii] = float3( random.Float(-600.0f, 600.0f), random.Float(-200.0f, 200.0f), random.Float(-600.0f, 600.0f) );
+        halves[ii]  = float3( random.Float(0.0f, 10.0f), random.Float(0.0f, 10.0f), random.Float(0.0f, 10.0f) );
+        culler.AddBox( centers[ii], halves[ii] );
+    }
+    std::vector<uint32_t> visible( kCount );
+
+#if defined(__AVX512F__)
+    printf( "AVX-512 build\n" );
+#elif defined(__AVX__)
+    printf( "AVX build\n" );
+#elif defined(CPUT_MATH_SSE)
+    printf( "SSE build\n" );
+#endif
+
+    uint32_t visibleCount = 0;
+    double start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { visibleCount = culler.Cull( &visible[0] ); }
+    Report( "CPUTFrustumCuller::Cull", start, visibleCount );
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { visibleCount = culler.CullScalar( &visible[0] ); }
+    Report( "CPUTFrustumCuller::CullScalar", start, visibleCount );
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ )
+    {
+        visibleCount = 0;
+        for( uint32_t ii=0; ii<kCount; ii++ )
+        {
+            visibleCount += frustum.IsVisible( centers[ii], halves[ii] ) ? 1 : 0;
+        }
+    }
+    Report( "CPUTFrustum::IsVisible", start, visibleCount );
+    return 0;
+}
@@ -0,0 +1,172 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFrustumCuller.h"
+#include "CPUTFrustum.h"
+#include "CPUTCamera.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// CPUTFrustumCuller against CPUTFrustum::IsVisible (eight corners per plane), for the
+// SIMD and scalar paths.  The two tests are the same in exact arithmetic; in floating
+// point they can disagree on boxes that touch a plane, so a disagreement only counts when
+// the box is clearly inside or outside.
+
+static const float kBoundaryTolerance = 1e-3f;
+
+//-----------------------------------------------------------------------------
+static void InitializeFrustum( CPUTFrustum *pFrustum, const float3 &position, const float3 &look )
+{
+    float3 right = normalize( cross3( float3( 0.0f, 1.0f, 0.0f ), look ) );
+    float3 up    = cross3( look, right );
+    pFrustum->InitializeFrustum( 1.0f, 500.0f, 1.6f, 1.0f, position, look, up );
+}
+
+// How close (relative to its size and distance) the box is to touching any plane
+//-----------------------------------------------------------------------------
+static float DistanceToBoundary( const CPUTFrustumCuller &culler, const float3 &center, const float3 &half )
+{
+    const float *pPlane = culler.GetPlanes();
+    float closest = 1e30f;
+    for( uint32_t ii=0; ii<6; ii++, pPlane += 4 )
+    {
+        float distance = pPlane[0]*center.x + pPlane[1]*center.y + pPlane[2]*center.z + pPlane[3];
+        float extent   = fabsf( pPlane[0] )*half.x + fabsf( pPlane[1] )*half.y + fabsf( pPlane[2] )*half.z;
+        float margin   = fabsf( distance - extent ) / (1.0f + fabsf( distance ) + extent);
+        closest = margin < closest ? margin : closest;
+    }
+    return closest;
+}
+
+// Culls the culler's boxes and checks the result against IsVisible
+//-----------------------------------------------------------------------------
+static void CheckAgainstFrustum( CPUTFrustumCuller &culler, CPUTFrustum &frustum, const std::vector<float3> &centers, const std::vector<float3> &halves, bool useSIMD )
+{
+    uint32_t count = (uint32_t)centers.size();
+    std::vector<uint32_t> visible( count + 1, 0xFFFFFFFF );
+    culler.SetUseSIMD( useSIMD );
+    uint32_t visibleCount = culler.Cull( &visible[0] );
+    CPUT_CHECK( visibleCount <= count );
+    CPUT_CHECK( 0xFFFFFFFF == visible[count] ); // Nothing written past the end
+
+    uint32_t next = 0, disagreements = 0;
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        bool culled   = !(next < visibleCount && visible[next] == ii);
+        bool expected = frustum.IsVisible( centers[ii], halves[ii] );
+        if( !culled )
+        {
+            next++;
+        }
+        if( culled == expected && DistanceToBoundary( culler, centers[ii], halves[ii] ) > kBoundaryTolerance )
+        {
+            disagreements++;
+        }
+    }
+    CPUT_CHECK( next == visibleCount ); // Ascending, and every index was a real box
+    CPUT_CHECK( 0 == disagreements );
+}
+
+//-----------------------------------------------------------------------------
+static void TestRandomBoxes()
+{
+    CPUTTestRandom random( 11 );
+    const float3 position( 3.0f, 2.0f, 1.0f );
+    const float3 looks[3] = { float3( 0.6f, 0.0f, 0.8f ), normalize( float3( -0.3f, 0.5f, -0.8f ) ), float3( 0.0f, 0.0f, 1.0f ) };
+    for( uint32_t ll=0; ll<3; ll++ )
+    {
+        CPUTFrustum frustum;
+        InitializeFrustum( &frustum, position, looks[ll] );
+
+        // Counts around the batch sizes, so the partial last batch is covered
+        const uint32_t counts[] = { 0, 1, 3, 4, 7, 8, 15, 16, 17, 33, 1000 };
+        for( uint32_t cc=0; cc<sizeof(counts)/sizeof(counts[0]); cc++ )
+        {
+            std::vector<float3> centers, halves;
+            CPUTFrustumCuller culler;
+            culler.SetPlanes( frustum.mpNormal, frustum.mpPosition[0], frustum.mpPosition[6] );
+            for( uint32_t ii=0; ii<counts[cc]; ii++ )
+            {
+                centers.push_back( float3( random.Float(-600.0f, 600.0f), random.Float(-200.0f, 200.0f), random.Float(-600.0f, 600.0f) ) );
+                halves.push_back( float3( random.Float(0.0f, 20.0f), random.Float(0.0f, 20.0f), random.Float(0.0f, 20.0f) ) );
+                CPUT_CHECK( ii == culler.AddBox( centers[ii], halves[ii] ) );
+            }
+            CPUT_CHECK( counts[cc] == culler.GetCount() );
+            CheckAgainstFrustum( culler, frustum, centers, halves, true );
+            CheckAgainstFrustum( culler, frustum, centers, halves, false );
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void TestKnownBoxes()
+{
+    CPUTFrustum frustum;
+    InitializeFrustum( &frustum, float3( 0.0f, 0.0f, 0.0f ), float3( 0.0f, 0.0f, 1.0f ) );
+    CPUTFrustumCuller culler;
+    culler.SetPlanes( frustum.mpNormal, frustum.mpPosition[0], frustum.mpPosition[6] );
+
+    const float3 unit( 1.0f, 1.0f, 1.0f );
+    culler.AddBox( float3(    0.0f, 0.0f,   10.0f ), unit );                      // 0: in front
+    culler.AddBox( float3(    0.0f, 0.0f,  -10.0f ), unit );                      // 1: behind
+    culler.AddBox( float3(    0.0f, 0.0f,  600.0f ), unit );                      // 2: past the far plane
+    culler.AddBox( float3( -200.0f, 0.0f,   10.0f ), unit );                      // 3: far off to one side
+    culler.AddBox( float3(    0.0f, 0.0f,  -10.0f ), float3( 1.0f, 1.0f, 20.0f ) ); // 4: behind, but reaches in front
+    culler.AddBox( float3(    0.0f, 0.0f,  250.0f ), float3( 1000.0f, 1000.0f, 1000.0f ) ); // 5: contains the frustum
+
+    uint32_t visible[6];
+    for( uint32_t simd=0; simd<2; simd++ )
+    {
+        culler.SetUseSIMD( 0 != simd );
+        CPUT_CHECK( 3 == culler.Cull( visible ) );
+        CPUT_CHECK( 0 == visible[0] && 4 == visible[1] && 5 == visible[2] );
+    }
+    CPUT_CHECK( 3 == culler.CullScalar( visible ) );
+
+    // Moving a box
+    culler.SetBox( 1, float3( 0.0f, 0.0f, 20.0f ), unit );
+    CPUT_CHECK( 4 == culler.Cull( visible ) );
+    CPUT_CHECK( 0 == visible[0] && 1 == visible[1] && 4 == visible[2] && 5 == visible[3] );
+
+    culler.Clear();
+    CPUT_CHECK( 0 == culler.GetCount() );
+    CPUT_CHECK( 0 == culler.Cull( visible ) );
+}
+
+// The camera overload builds the same frustum
+//-----------------------------------------------------------------------------
+static void TestCameraFrustum()
+{
+    const float3 look( 0.0f, 0.0f, 1.0f );
+    CPUTCamera camera( 1.0f, 500.0f, 1.6f, 1.0f, float3( 1.0f, 2.0f, 3.0f ), look, float3( 0.0f, 1.0f, 0.0f ) );
+    CPUTFrustum fromCamera, direct;
+    fromCamera.InitializeFrustum( &camera );
+    InitializeFrustum( &direct, float3( 1.0f, 2.0f, 3.0f ), look );
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        CPUT_CHECK_NEAR( fromCamera.mpNormal[ii].x, direct.mpNormal[ii].x, 1e-5f );
+        CPUT_CHECK_NEAR( fromCamera.mpNormal[ii].y, direct.mpNormal[ii].y, 1e-5f );
+        CPUT_CHECK_NEAR( fromCamera.mpNormal[ii].z, direct.mpNormal[ii].z, 1e-5f );
+    }
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestRandomBoxes();
+    TestKnownBoxes();
+    TestCameraFrustum();
+    return CPUTTestResult();
+}
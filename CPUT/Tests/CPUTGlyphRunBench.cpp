@@ -0,0 +1,133 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFont.h"
+#include "CPUTGlyphRun.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// Glyphs laid out per second for readouts like WindowsSensors' raw data label, whose
+// numbers change every frame: laid out from scratch with every quad built, laid out from
+// the previous string with only the changed quads built (CPUTText::Recalculate() on a new
+// string), and from the font's cache (the same strings again).  The font is the stand-in
+// in Shims/CPUTFontDX11.h.
+
+static const uint32_t kStrings = 256;
+static const uint32_t kPasses  = 400;
+
+static volatile float sSink;
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, double seconds, uint64_t glyphs, uint64_t quads )
+{
+    printf( "  %-32s %7.1f M glyphs/s  %5.1f%% of quads built\n", pName, glyphs / seconds / 1e6, 100.0 * quads / glyphs );
+}
+
+// As CPUTText::Recalculate(): builds the quads between the unchanged start and end
+//-----------------------------------------------------------------------------
+static uint32_t RebuildQuads( const CPUTFont &font, const CPUTGlyphRun &before, const CPUTGlyphRun &after, CPUTGUIVertex *pVertices )
+{
+    uint32_t first, suffix;
+    CPUTCompareGlyphRuns( before, after, &first, &suffix );
+    if( suffix && before.GetLength() != after.GetLength() )
+    {
+        CPUTGUIVertex *pFrom = &pVertices[6*(before.GetLength()-suffix)], *pTo = &pVertices[6*(after.GetLength()-suffix)];
+        if( pTo > pFrom ) { std::copy_backward( pFrom, pFrom + 6*suffix, pTo + 6*suffix ); }
+        else              { std::copy( pFrom, pFrom + 6*suffix, pTo ); }
+    }
+    uint32_t last = after.GetLength() - suffix;
+    CPUTBuildGlyphQuads( font, after, first, last, 10.0f, 20.0f, 0.5f, true, pVertices );
+    return last - first;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTFont *pFont = CPUTFont::CreateFont( _L("Bench"), _L("") );
+    CPUTTestRandom random( 40 );
+    std::vector<cString> strings;
+    char text[128];
+    for( uint32_t ii=0; ii<kStrings; ii++ )
+    {
+        sprintf( text, "Raw:\t%.2f\t%.2f\t%.2f", 1.0f + random.Float( -0.05f, 0.05f ), -2.0f + random.Float( -0.05f, 0.05f ), 9.81f + random.Float( -0.05f, 0.05f ) );
+        strings.push_back( cString( text, text + strlen( text ) ) );
+    }
+    CPUTGUIVertex zero;
+    zero.Pos = float3( 0.0f, 0.0f, 0.0f );
+    zero.UV  = float2( 0.0f, 0.0f );
+    std::vector<CPUTGUIVertex> vertices( 6 * 128, zero );
+    printf( "  %u readouts, like \"%s\"\n", kStrings, text );
+
+    // From scratch
+    {
+        CPUTGlyphRun run;
+        uint64_t glyphs = 0;
+        double start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t pp=0; pp<kPasses; pp++ )
+        {
+            for( uint32_t ii=0; ii<kStrings; ii++ )
+            {
+                CPUTLayoutGlyphRun( *pFont, strings[ii], NULL, &run );
+                CPUTBuildGlyphQuads( *pFont, run, 0, run.GetLength(), 10.0f, 20.0f, 0.5f, true, &vertices[0] );
+                glyphs += run.GetLength();
+            }
+            sSink = vertices[6].Pos.x;
+        }
+        Report( "Layout and all quads", CPUTFrameScheduler::GetSeconds() - start, glyphs, glyphs );
+    }
+
+    // A new string each frame, as a sensor readout is: the cache misses
+    {
+        CPUTGlyphRun previous, run;
+        uint64_t glyphs = 0, quads = 0;
+        double start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t pp=0; pp<kPasses; pp++ )
+        {
+            for( uint32_t ii=0; ii<kStrings; ii++ )
+            {
+                CPUTLayoutGlyphRun( *pFont, strings[ii], &previous, &run );
+                quads  += RebuildQuads( *pFont, previous, run, &vertices[0] );
+                glyphs += run.GetLength();
+                previous.Swap( run );
+            }
+            sSink = vertices[6].Pos.x;
+        }
+        Report( "From the previous string", CPUTFrameScheduler::GetSeconds() - start, glyphs, quads );
+    }
+
+    // The same strings again: every layout comes from the cache
+    {
+        CPUTGlyphRun previous, run;
+        uint64_t glyphs = 0, quads = 0;
+        double start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t pp=0; pp<kPasses; pp++ )
+        {
+            for( uint32_t ii=0; ii<kStrings; ii++ )
+            {
+                run    = pFont->LayoutText( strings[ii], &previous );
+                quads += RebuildQuads( *pFont, previous, run, &vertices[0] );
+                glyphs += run.GetLength();
+                previous.Swap( run );
+            }
+            sSink = vertices[6].Pos.x;
+        }
+        Report( "LayoutText(), cached", CPUTFrameScheduler::GetSeconds() - start, glyphs, quads );
+    }
+    pFont->Release();
+    return 0;
+}
@@ -0,0 +1,308 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFont.h"
+#include "CPUTGlyphRun.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// CPUTGlyphRun layout, incremental and from the font's cache, against laying each string
+// out from scratch; CPUTCompareGlyphRuns() against its definition; and rebuilding only the
+// quads between the unchanged start and end of a string, as CPUTText::Recalculate() does,
+// against building them all.  The font is the stand-in in Shims/CPUTFontDX11.h.  Built
+// narrow and with UNICODE, where characters past 0xff have no glyph.
+
+typedef cString CPUTTestString;
+
+// Tabs, characters the font lacks, and the characters of numeric readouts
+static const char sAlphabet[] = "0123456789.:- \t\t\x01RawFPSms";
+
+//-----------------------------------------------------------------------------
+static CPUTTestString RandomString( CPUTTestRandom &random, uint32_t length )
+{
+    CPUTTestString string;
+    for( uint32_t ii=0; ii<length; ii++ )
+    {
+        string += (CPUTTestString::value_type)(unsigned char)sAlphabet[random.Index( sizeof(sAlphabet) - 1 )];
+#if defined(UNICODE) || defined(_UNICODE)
+        if( 0 == random.Index( 40 ) )
+        {
+            string[ii] = (wchar_t)0x4e2d;
+        }
+#endif
+    }
+    return string;
+}
+
+// Changes a few characters somewhere in the string, and sometimes its length, as a
+// readout does from one frame to the next
+//-----------------------------------------------------------------------------
+static CPUTTestString Edit( CPUTTestRandom &random, const CPUTTestString &string )
+{
+    CPUTTestString edited = string;
+    uint32_t at = edited.empty() ? 0 : random.Index( (uint32_t)edited.size() + 1 );
+    switch( random.Index( 4 ) )
+    {
+    case 0:  edited.insert( at, RandomString( random, 1 + random.Index( 3 ) ) ); break;
+    case 1:  edited.erase( at, 1 + random.Index( 3 ) ); break;
+    default:
+        for( uint32_t ii=at; ii<edited.size() && ii<at + 1 + random.Index( 3 ); ii++ )
+        {
+            edited[ii] = RandomString( random, 1 )[0];
+        }
+        break;
+    }
+    return edited;
+}
+
+// Lays the string out one character at a time
+//-----------------------------------------------------------------------------
+static CPUTGlyphRun Reference( const CPUTFont &font, const CPUTTestString &text )
+{
+    CPUTGlyphRun run;
+    run.mText = text;
+    float position = 0.0f;
+    for( size_t ii=0; ii<text.size(); ii++ )
+    {
+        int glyph   = font.GetGlyphIndex( text[ii] );
+        int advance = glyph < 0 ? 0 : font.GetGlyphSizeByIndex( glyph ).width;
+        if( '\t' == text[ii] && advance )
+        {
+            // To the next tab stop, a tab's width apart from the start of the string
+            advance = ((int)position / advance + 1) * advance - (int)position;
+        }
+        run.mLeft.push_back( position );
+        run.mRight.push_back( position + advance );
+        run.mGlyph.push_back( glyph );
+        position += advance;
+        if( glyph >= 0 && font.GetGlyphSizeByIndex( glyph ).height > run.mHeight )
+        {
+            run.mHeight = font.GetGlyphSizeByIndex( glyph ).height;
+        }
+    }
+    run.mWidth = (int)position;
+    return run;
+}
+
+//-----------------------------------------------------------------------------
+static bool SameRun( const CPUTGlyphRun &a, const CPUTGlyphRun &b )
+{
+    return a.mText == b.mText && a.mLeft == b.mLeft && a.mRight == b.mRight && a.mGlyph == b.mGlyph &&
+           a.mWidth == b.mWidth && a.mHeight == b.mHeight;
+}
+
+//-----------------------------------------------------------------------------
+static void TestLayout( const CPUTFont &font )
+{
+    CPUTTestRandom random( 40 );
+    CPUTGlyphRun previous, run;
+    CPUTLayoutGlyphRun( font, CPUTTestString(), NULL, &previous );
+    CPUT_CHECK( 0 == previous.GetLength() && 0 == previous.mWidth && 0 == previous.mHeight );
+
+    uint32_t wrong = 0;
+    CPUTTestString text = RandomString( random, 12 );
+    CPUTLayoutGlyphRun( font, text, NULL, &previous );
+    wrong += !SameRun( previous, Reference( font, text ) );
+    for( uint32_t ii=0; ii<20000; ii++ )
+    {
+        text = (0 == ii % 500) ? RandomString( random, random.Index( 30 ) ) : Edit( random, text );
+        CPUTLayoutGlyphRun( font, text, &previous, &run );
+        wrong += !SameRun( run, Reference( font, text ) );
+        previous.Swap( run );
+    }
+    CPUT_CHECK( 0 == wrong );
+
+    // A wider digit moves the tab after it, but not the tab stop it reaches, so what
+    // follows is where it was
+    CPUTTestString before = _L("Raw:\t1.23\t4.56 ms"), after = _L("Raw:\t1.22\t4.56 ms");
+    CPUTLayoutGlyphRun( font, before, NULL, &previous );
+    CPUTLayoutGlyphRun( font, after, &previous, &run );
+    CPUT_CHECK( SameRun( run, Reference( font, after ) ) );
+    CPUT_CHECK( previous.mRight[8] < run.mRight[8] && previous.mLeft[10] == run.mLeft[10] );
+}
+
+//-----------------------------------------------------------------------------
+static void TestCompare( const CPUTFont &font )
+{
+    CPUTTestRandom random( 41 );
+    uint32_t wrong = 0;
+    CPUTTestString text = RandomString( random, 16 );
+    for( uint32_t ii=0; ii<20000; ii++ )
+    {
+        CPUTTestString edited = Edit( random, text );
+        CPUTGlyphRun before = Reference( font, text ), after = Reference( font, edited );
+        uint32_t prefix, suffix;
+        CPUTCompareGlyphRuns( before, after, &prefix, &suffix );
+
+        // Characters that are the same, at the same place, from the start and from the end
+        uint32_t common = (uint32_t)(text.size() < edited.size() ? text.size() : edited.size());
+        uint32_t expectedPrefix = 0, expectedSuffix = 0;
+        while( expectedPrefix < common && text[expectedPrefix] == edited[expectedPrefix] &&
+               before.mLeft[expectedPrefix] == after.mLeft[expectedPrefix] && before.mRight[expectedPrefix] == after.mRight[expectedPrefix] )
+        {
+            expectedPrefix++;
+        }
+        for( ; expectedSuffix < common - expectedPrefix; expectedSuffix++ )
+        {
+            uint32_t b = (uint32_t)text.size() - 1 - expectedSuffix, a = (uint32_t)edited.size() - 1 - expectedSuffix;
+            if( text[b] != edited[a] || before.mLeft[b] != after.mLeft[a] || before.mRight[b] != after.mRight[a] )
+            {
+                break;
+            }
+        }
+        wrong += prefix != expectedPrefix || suffix != expectedSuffix;
+        text = edited.size() > 40 ? RandomString( random, 16 ) : edited;
+    }
+    CPUT_CHECK( 0 == wrong );
+}
+
+// As CPUTText::Recalculate(): keeps the quads of the unchanged start and end, slides the
+// end's to their new place, and builds the rest.  Returns the quads built.
+//-----------------------------------------------------------------------------
+static uint32_t RebuildQuads( const CPUTFont &font, const CPUTGlyphRun &before, const CPUTGlyphRun &after, CPUTGUIVertex *pVertices )
+{
+    uint32_t first, suffix;
+    CPUTCompareGlyphRuns( before, after, &first, &suffix );
+    if( suffix && before.GetLength() != after.GetLength() )
+    {
+        std::vector<CPUTGUIVertex> tail( &pVertices[6*(before.GetLength()-suffix)], &pVertices[6*before.GetLength()] );
+        std::copy( tail.begin(), tail.end(), &pVertices[6*(after.GetLength()-suffix)] );
+    }
+    uint32_t last = after.GetLength() - suffix;
+    CPUTBuildGlyphQuads( font, after, first, last, 10.0f, 20.0f, 0.5f, true, pVertices );
+    return last - first;
+}
+
+//-----------------------------------------------------------------------------
+static void TestQuads( const CPUTFont &font )
+{
+    CPUTGUIVertex zero;
+    zero.Pos = float3( 0.0f, 0.0f, 0.0f );
+    zero.UV  = float2( 0.0f, 0.0f );
+    std::vector<CPUTGUIVertex> kept( 6 * 64, zero ), built( 6 * 64, zero );
+
+    // One quad: its corners and the glyph's UVs.  Tabs and missing glyphs are zero width.
+    CPUTTestString text = _L("A\t\x01");
+    CPUTGlyphRun run = Reference( font, text );
+    CPUTBuildGlyphQuads( font, run, 0, 3, 10.0f, 20.0f, 0.5f, true, &built[0] );
+    const float *pUV = font.GetGlyphUVCoordsByIndex( run.mGlyph[0], true );
+    CPUT_CHECK( 10.0f == built[0].Pos.x && 20.0f == built[0].Pos.y && 0.5f == built[0].Pos.z );
+    CPUT_CHECK( 10.0f + run.mRight[0] == built[4].Pos.x && 35.0f == built[4].Pos.y );
+    CPUT_CHECK( pUV[0] == built[0].UV.x && pUV[1] == built[0].UV.y && pUV[2] == built[4].UV.x && pUV[3] == built[4].UV.y );
+    for( uint32_t ii=6; ii<18; ii++ )
+    {
+        CPUT_CHECK( built[ii - ii % 6].Pos.x == built[ii].Pos.x );
+    }
+
+    // A readout that changes a digit: only the quads from the first change on are built
+    // again, and only up to where the text lines up with the old text again (here, the
+    // digit and the tab after it)
+    CPUTGlyphRun before = Reference( font, _L("Raw:\t1.23\t4.56 ms") ), after = Reference( font, _L("Raw:\t1.22\t4.56 ms") );
+    CPUTBuildGlyphQuads( font, before, 0, before.GetLength(), 10.0f, 20.0f, 0.5f, true, &kept[0] );
+    CPUT_CHECK( 2 == RebuildQuads( font, before, after, &kept[0] ) );
+    CPUTBuildGlyphQuads( font, after, 0, after.GetLength(), 10.0f, 20.0f, 0.5f, true, &built[0] );
+    CPUT_CHECK( 0 == memcmp( &kept[0], &built[0], sizeof(CPUTGUIVertex) * 6 * after.GetLength() ) );
+
+    // Random edits: the kept quads always match building them all
+    CPUTTestRandom random( 42 );
+    uint32_t wrong = 0, rebuilt = 0, characters = 0;
+    text = RandomString( random, 20 );
+    before = Reference( font, text );
+    CPUTBuildGlyphQuads( font, before, 0, before.GetLength(), 10.0f, 20.0f, 0.5f, true, &kept[0] );
+    for( uint32_t ii=0; ii<20000; ii++ )
+    {
+        text  = text.size() > 50 ? text.substr( 0, 20 ) : Edit( random, text );
+        after = Reference( font, text );
+        rebuilt    += RebuildQuads( font, before, after, &kept[0] );
+        characters += after.GetLength();
+        CPUTBuildGlyphQuads( font, after, 0, after.GetLength(), 10.0f, 20.0f, 0.5f, true, &built[0] );
+        wrong += 0 != memcmp( &kept[0], &built[0], sizeof(CPUTGUIVertex) * 6 * after.GetLength() );
+        before.Swap( after );
+    }
+    CPUT_CHECK( 0 == wrong );
+    CPUT_CHECK( rebuilt < characters / 2 );
+}
+
+//-----------------------------------------------------------------------------
+static void TestCache( CPUTFont &font )
+{
+    // An unchanged string gets its cached run back
+    CPUTTestString fps = _L("FPS: 59.9"), raw = _L("Raw:\t1.23\t4.56");
+    const CPUTGlyphRun *pFps = &font.LayoutText( fps, NULL );
+    const CPUTGlyphRun *pRaw = &font.LayoutText( raw, NULL );
+    CPUT_CHECK( pFps != pRaw );
+    CPUT_CHECK( pFps == &font.LayoutText( fps, NULL ) );
+    CPUT_CHECK( pRaw == &font.LayoutText( raw, pFps ) );
+    CPUT_CHECK( SameRun( *pFps, Reference( font, fps ) ) && SameRun( *pRaw, Reference( font, raw ) ) );
+
+    // A changed one gets a run of its own, laid out from its previous one.  The others,
+    // and the previous string's, are left alone.
+    CPUTGlyphRun rawCopy = *pRaw;
+    CPUTTestString fps2 = _L("FPS: 60.1");
+    const CPUTGlyphRun *pFps2 = &font.LayoutText( fps2, pFps );
+    CPUT_CHECK( pFps2 != pFps && pFps2 != pRaw );
+    CPUT_CHECK( SameRun( *pFps2, Reference( font, fps2 ) ) );
+    CPUT_CHECK( pRaw == &font.LayoutText( raw, NULL ) && SameRun( *pRaw, rawCopy ) );
+    CPUT_CHECK( pFps == &font.LayoutText( fps, NULL ) && SameRun( *pFps, Reference( font, fps ) ) );
+
+    // Past CPUT_MAX_CACHED_GLYPH_RUNS strings the cache starts again, reusing the runs,
+    // including the one passed as the previous layout
+    CPUTTestRandom random( 43 );
+    uint32_t wrong = 0;
+    CPUTTestString text = fps;
+    const CPUTGlyphRun *pPrevious = pFps;
+    char number[32];
+    for( uint32_t ii=0; ii<3 * CPUT_MAX_CACHED_GLYPH_RUNS; ii++ )
+    {
+        sprintf( number, "%u", ii );
+        text = Edit( random, text.size() > 30 ? fps : text );
+        for( const char *pChar = number; *pChar; pChar++ )
+        {
+            text += (CPUTTestString::value_type)*pChar;
+        }
+        const CPUTGlyphRun &run = font.LayoutText( text, pPrevious );
+        wrong += !SameRun( run, Reference( font, text ) );
+        pPrevious = &run;
+    }
+    CPUT_CHECK( 0 == wrong );
+    CPUT_CHECK( SameRun( font.LayoutText( raw, pPrevious ), rawCopy ) );
+
+    // The previous layout is the first run, the one the next string gets once the cache is full
+    font.ClearGlyphRunCache();
+    CPUTTestString first = _L("Raw:\t1.23\t4.56 ms");
+    const CPUTGlyphRun *pFirst = &font.LayoutText( first, NULL );
+    for( uint32_t ii=1; ii<CPUT_MAX_CACHED_GLYPH_RUNS; ii++ )
+    {
+        sprintf( number, "%u", ii );
+        font.LayoutText( _L("Filler ") + RandomString( random, 4 ) + CPUTTestString( number, number + strlen( number ) ), NULL );
+    }
+    CPUTTestString next = _L("Raw:\t2.5\t4.56 ms");
+    CPUT_CHECK( pFirst == &font.LayoutText( next, pFirst ) );
+    CPUT_CHECK( SameRun( *pFirst, Reference( font, next ) ) );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTFont *pFont = CPUTFont::CreateFont( _L("Test"), _L("") );
+    TestLayout( *pFont );
+    TestCompare( *pFont );
+    TestQuads( *pFont );
+    TestCache( *pFont );
+    pFont->Release();
+    return CPUTTestResult();
+}
@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTGuiVertexArena.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// GUI CPU time a frame for a panel of 500 controls, each a 9-quad frame and a label, where
+// one label changes every frame (as WindowsSensors::Update() does with its raw data).
+// Retained: only that control is drawn again, placed in its arena ranges and uploaded.
+// Rebuild: every control is drawn again and both buffers uploaded whole, as the GUI did
+// before it kept the arenas.  Controls are drawn by a stand-in for DrawIntoBuffer() that
+// writes the same number of quads, on the null backend.
+
+static const uint32_t kControls = 500;
+static const uint32_t kFrames   = 1000;
+static const uint32_t kCapacity = 64 * 1024;
+
+//-----------------------------------------------------------------------------
+static void WriteQuad( CPUTGUIVertex *pVertices, uint32_t *pCount, float x, float y, float width, float height, float u, float v )
+{
+    const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        CPUTGUIVertex &vertex = pVertices[(*pCount)++];
+        vertex.Pos = float3( x + corners[ii][0] * width, y + corners[ii][1] * height, 1.0f );
+        vertex.UV  = float2( u + corners[ii][0] * 0.0625f, v + corners[ii][1] * 0.0625f );
+    }
+}
+
+// A control's frame, 9 quads, and a quad for each character of its label
+//-----------------------------------------------------------------------------
+static void DrawControl( uint32_t index, const char *pLabel, CPUTGUIVertex *pVertices, uint32_t *pCount, CPUTGUIVertex *pText, uint32_t *pTextCount )
+{
+    float x = (float)(index % 10) * 200.0f, y = (float)(index / 10) * 30.0f;
+    for( uint32_t ii=0; ii<9; ii++ )
+    {
+        WriteQuad( pVertices, pCount, x + (ii % 3) * 60.0f, y + (ii / 3) * 8.0f, 60.0f, 8.0f, (ii % 3) * 0.0625f, (ii / 3) * 0.0625f );
+    }
+    for( const char *pChar = pLabel; *pChar; pChar++ )
+    {
+        unsigned char c = (unsigned char)*pChar;
+        WriteQuad( pText, pTextCount, x + 4.0f + (pChar - pLabel) * 9.0f, y + 6.0f, 9.0f, 14.0f, (c % 16) * 0.0625f, (c / 16) * 0.0625f );
+    }
+}
+
+// Draws the controls into their ranges: only the changed one, or all of them after Reset()
+//-----------------------------------------------------------------------------
+static bool PlaceControls( CPUTGuiVertexArena &controlArena, CPUTGuiVertexArena &textArena, std::vector<uint32_t> *pRanges,
+                           const std::vector<std::string> &labels, uint32_t changed, bool rebuildAll, CPUTGUIVertex *pScratch, CPUTGUIVertex *pTextScratch )
+{
+    if( rebuildAll )
+    {
+        controlArena.Reset();
+        textArena.Reset();
+        for( uint32_t rr=0; rr<4; rr++ )
+        {
+            pRanges[rr].assign( kControls, 0 );
+        }
+    }
+    for( uint32_t ii = rebuildAll ? 0 : changed; ii < (rebuildAll ? kControls : changed + 1); ii++ )
+    {
+        uint32_t count = 0, textCount = 0;
+        DrawControl( ii, labels[ii].c_str(), pScratch, &count, pTextScratch, &textCount );
+        if( !controlArena.Place( &pRanges[0][ii], &pRanges[1][ii], pScratch, count ) ||
+            !textArena.Place( &pRanges[2][ii], &pRanges[3][ii], pTextScratch, textCount ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    std::vector<std::string> labels( kControls );
+    char label[64];
+    for( uint32_t ii=0; ii<kControls; ii++ )
+    {
+        sprintf( label, "Control %u", ii );
+        labels[ii] = label;
+    }
+    CPUTGUIVertex zero;
+    zero.Pos = float3( 0.0f, 0.0f, 0.0f );
+    zero.UV  = float2( 0.0f, 0.0f );
+    std::vector<CPUTGUIVertex> controlMirror( kCapacity, zero ), textMirror( kCapacity, zero );
+    printf( "  %u controls, one label changed a frame\n", kControls );
+
+    for( uint32_t retained=0; retained<2; retained++ )
+    {
+        CPUTRenderBackendNull backend;
+        CPUTBackendHandle controlBuffer = backend.CreateBuffer( kCapacity * sizeof(CPUTGUIVertex), CPUT_BIND_VERTEX_BUFFER, false, NULL );
+        CPUTBackendHandle textBuffer    = backend.CreateBuffer( kCapacity * sizeof(CPUTGUIVertex), CPUT_BIND_VERTEX_BUFFER, false, NULL );
+        CPUTGuiVertexArena controlArena( kCapacity ), textArena( kCapacity );
+        // Control start and size, then text start and size, by control
+        std::vector<uint32_t> ranges[4];
+        PlaceControls( controlArena, textArena, ranges, labels, 0, true, &controlMirror[0], &textMirror[0] );
+        controlArena.Upload( &backend, controlBuffer );
+        textArena.Upload( &backend, textBuffer );
+        uint32_t repacks = 0;
+        backend.ResetStats();
+
+        double start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t ff=0; ff<kFrames; ff++ )
+        {
+            uint32_t changed = kControls / 2;
+            sprintf( label, "Accelerometer: %.*f", ff % 7, ff * 0.125f );
+            labels[changed] = label;
+            if( retained )
+            {
+                // Out of room: pack them all again, as CPUTGuiControllerDX11::RebuildDirtyControls() does
+                if( !PlaceControls( controlArena, textArena, ranges, labels, changed, false, &controlMirror[0], &textMirror[0] ) )
+                {
+                    PlaceControls( controlArena, textArena, ranges, labels, 0, true, &controlMirror[0], &textMirror[0] );
+                    repacks++;
+                }
+                controlArena.Upload( &backend, controlBuffer );
+                textArena.Upload( &backend, textBuffer );
+            }
+            else
+            {
+                uint32_t count = 0, textCount = 0;
+                for( uint32_t ii=0; ii<kControls; ii++ )
+                {
+                    DrawControl( ii, labels[ii].c_str(), &controlMirror[0], &count, &textMirror[0], &textCount );
+                }
+                backend.UpdateBuffer( controlBuffer, &controlMirror[0], count * sizeof(CPUTGUIVertex) );
+                backend.UpdateBuffer( textBuffer, &textMirror[0], textCount * sizeof(CPUTGUIVertex) );
+            }
+        }
+        double microseconds = (CPUTFrameScheduler::GetSeconds() - start) * 1e6 / kFrames;
+        printf( "  %-32s %8.2f us/frame  %8.1f KB uploaded/frame  %u repacks\n", retained ? "Retained" : "Rebuild", microseconds,
+                backend.GetStats().mBytesUploaded / 1024.0 / kFrames, repacks );
+        backend.ReleaseBuffer( controlBuffer );
+        backend.ReleaseBuffer( textBuffer );
+    }
+    return 0;
+}
@@ -0,0 +1,329 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTGuiVertexArena.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <vector>
+
+// CPUTGuiVertexArena: the size of a new range and where it goes, degenerate padding after
+// a control's vertices, moving a control that outgrows its range, and which uploads
+// Upload() makes (ranges up to 48 vertices apart go in one).  Then the way
+// CPUTGuiControllerDX11::RebuildDirtyControls() recovers when the arena fills up: a
+// panel of labels that keep growing until Place() fails, then packed again from scratch.
+
+//-----------------------------------------------------------------------------
+static std::vector<CPUTGUIVertex> MakeVertices( uint32_t count, float tag )
+{
+    CPUTGUIVertex zero;
+    zero.Pos = float3( 0.0f, 0.0f, 0.0f );
+    zero.UV  = float2( 0.0f, 0.0f );
+    std::vector<CPUTGUIVertex> vertices( count, zero );
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        vertices[ii].Pos = float3( tag, (float)ii, 0.5f );
+        vertices[ii].UV  = float2( tag * 0.5f, (float)ii * 0.25f );
+    }
+    return vertices;
+}
+
+//-----------------------------------------------------------------------------
+static bool IsDegenerate( const CPUTGUIVertex &vertex )
+{
+    return 0.0f == vertex.Pos.x && 0.0f == vertex.Pos.y && 0.0f == vertex.Pos.z && 0.0f == vertex.UV.x && 0.0f == vertex.UV.y;
+}
+
+// Whether a range holds the vertices, then nothing but degenerate ones
+//-----------------------------------------------------------------------------
+static bool RangeHolds( const CPUTGuiVertexArena &arena, uint32_t start, uint32_t rangeSize, const std::vector<CPUTGUIVertex> &vertices )
+{
+    const CPUTGUIVertex *pRange = arena.GetVertices() + start;
+    if( vertices.size() > rangeSize || (vertices.size() && memcmp( pRange, &vertices[0], vertices.size() * sizeof(CPUTGUIVertex) )) )
+    {
+        return false;
+    }
+    for( uint32_t ii=(uint32_t)vertices.size(); ii<rangeSize; ii++ )
+    {
+        if( !IsDegenerate( pRange[ii] ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static void TestPlace()
+{
+    CPUTGuiVertexArena arena( 1000 );
+    CPUT_CHECK( 1000 == arena.GetCapacity() && 0 == arena.GetVertexCount() );
+
+    // A new range has room for half as many again, in whole quads
+    std::vector<CPUTGUIVertex> button = MakeVertices( 54, 1.0f );
+    uint32_t start = 0, rangeSize = 0;
+    CPUT_CHECK( arena.Place( &start, &rangeSize, &button[0], 54 ) );
+    CPUT_CHECK( 0 == start && 84 == rangeSize && 84 == arena.GetVertexCount() );
+    CPUT_CHECK( RangeHolds( arena, start, rangeSize, button ) );
+
+    std::vector<CPUTGUIVertex> label = MakeVertices( 7, 2.0f );
+    uint32_t labelStart = 0, labelSize = 0;
+    CPUT_CHECK( arena.Place( &labelStart, &labelSize, &label[0], 7 ) );
+    CPUT_CHECK( 84 == labelStart && 12 == labelSize && 96 == arena.GetVertexCount() );
+    CPUT_CHECK( RangeHolds( arena, labelStart, labelSize, label ) );
+
+    // Fewer vertices stay in the range, and the rest of it is padded
+    std::vector<CPUTGUIVertex> pressed = MakeVertices( 30, 3.0f );
+    CPUT_CHECK( arena.Place( &start, &rangeSize, &pressed[0], 30 ) );
+    CPUT_CHECK( 0 == start && 84 == rangeSize && 96 == arena.GetVertexCount() );
+    CPUT_CHECK( RangeHolds( arena, start, rangeSize, pressed ) );
+    CPUT_CHECK( RangeHolds( arena, labelStart, labelSize, label ) );
+
+    // And a control with nothing to draw is all padding
+    CPUT_CHECK( arena.Place( &labelStart, &labelSize, NULL, 0 ) );
+    CPUT_CHECK( RangeHolds( arena, labelStart, labelSize, std::vector<CPUTGUIVertex>() ) );
+
+    // Outgrowing the range moves the control to the end and leaves the old range padded
+    std::vector<CPUTGUIVertex> longer = MakeVertices( 90, 4.0f );
+    CPUT_CHECK( arena.Place( &start, &rangeSize, &longer[0], 90 ) );
+    CPUT_CHECK( 96 == start && 138 == rangeSize && 234 == arena.GetVertexCount() );
+    CPUT_CHECK( 84 == arena.GetWasted() );
+    CPUT_CHECK( RangeHolds( arena, 0, 84, std::vector<CPUTGUIVertex>() ) );
+    CPUT_CHECK( RangeHolds( arena, start, rangeSize, longer ) );
+
+    // Without room for the headroom, a range of exactly the vertices; without that, failure
+    uint32_t fillStart = 0, fillSize = 0;
+    std::vector<CPUTGUIVertex> fill = MakeVertices( 700, 5.0f );
+    CPUT_CHECK( arena.Place( &fillStart, &fillSize, &fill[0], 700 ) );
+    CPUT_CHECK( 234 == fillStart && 700 == fillSize && 934 == arena.GetVertexCount() );
+    std::vector<CPUTGUIVertex> tooMany = MakeVertices( 140, 6.0f );
+    CPUT_CHECK( !arena.Place( &start, &rangeSize, &tooMany[0], 140 ) );
+    CPUT_CHECK( 0 == rangeSize && 222 == arena.GetWasted() );
+    CPUT_CHECK( RangeHolds( arena, 96, 138, std::vector<CPUTGUIVertex>() ) );
+
+    arena.Reset();
+    CPUT_CHECK( 0 == arena.GetVertexCount() && 0 == arena.GetWasted() );
+    start = rangeSize = 0;
+    CPUT_CHECK( arena.Place( &start, &rangeSize, &tooMany[0], 140 ) );
+    CPUT_CHECK( 0 == start && 210 == rangeSize );
+}
+
+// Checks the recorded buffer updates, and that the buffer now matches the arena
+//-----------------------------------------------------------------------------
+static void CheckUploads( CPUTRenderBackendNull &backend, CPUTBackendHandle buffer, const CPUTGuiVertexArena &arena,
+                          uint32_t uploadCount, const uint32_t *pStarts, const uint32_t *pEnds )
+{
+    CPUT_CHECK( uploadCount == backend.GetRecordedCommandCount() );
+    for( uint32_t ii=0; ii<uploadCount && ii<backend.GetRecordedCommandCount(); ii++ )
+    {
+        const CPUTBackendCommand &command = backend.GetRecordedCommand( ii );
+        CPUT_CHECK( CPUT_BACKEND_CMD_UPDATE_BUFFER == command.mType && buffer == command.mHandle && 2 == command.mArg[1] );
+        CPUT_CHECK( pStarts[ii] * sizeof(CPUTGUIVertex) == command.mArg[0] );
+        CPUT_CHECK( (pEnds[ii] - pStarts[ii]) * sizeof(CPUTGUIVertex) == command.mPayloadSize );
+    }
+    const void *pBuffer = backend.Map( buffer );
+    CPUT_CHECK( 0 == memcmp( pBuffer, arena.GetVertices(), arena.GetVertexCount() * sizeof(CPUTGUIVertex) ) );
+    backend.Unmap( buffer, 0 );
+    backend.ClearRecording();
+}
+
+//-----------------------------------------------------------------------------
+static void TestUpload()
+{
+    CPUTRenderBackendNull backend;
+    CPUTBackendHandle buffer = backend.CreateBuffer( 2000 * sizeof(CPUTGUIVertex), CPUT_BIND_VERTEX_BUFFER, false, NULL );
+    backend.SetRecording( true );
+    CPUTGuiVertexArena arena( 2000 );
+
+    // Ten 12-vertex labels of 6 vertices, 12 apart: one upload
+    uint32_t starts[10], sizes[10];
+    std::vector<CPUTGUIVertex> vertices = MakeVertices( 6, 1.0f );
+    for( uint32_t ii=0; ii<10; ii++ )
+    {
+        sizes[ii] = 0;
+        arena.Place( &starts[ii], &sizes[ii], &vertices[0], 6 );
+        CPUT_CHECK( ii * 12 == starts[ii] && 12 == sizes[ii] );
+    }
+    uint32_t bytes = arena.Upload( &backend, buffer );
+    CPUT_CHECK( 120 * sizeof(CPUTGUIVertex) == bytes );
+    uint32_t all[2] = { 0, 120 };
+    CheckUploads( backend, buffer, arena, 1, all, all + 1 );
+
+    // Nothing written since: nothing uploaded
+    CPUT_CHECK( 0 == arena.Upload( &backend, buffer ) );
+    CPUT_CHECK( 0 == backend.GetRecordedCommandCount() );
+
+    // Written out of order, which Upload() sorts.  [60, 72) is 48 vertices past [0, 12), and
+    // [120, 168) 48 past that, so all three go up together, with the unchanged vertices
+    // between them.
+    uint32_t bigStart = 0, bigSize = 0;
+    std::vector<CPUTGUIVertex> big = MakeVertices( 32, 2.0f );
+    arena.Place( &bigStart, &bigSize, &big[0], 32 );
+    CPUT_CHECK( 120 == bigStart && 48 == bigSize );
+    arena.Upload( &backend, buffer );
+    backend.ClearRecording();
+    std::vector<CPUTGUIVertex> changed = MakeVertices( 6, 3.0f );
+    arena.Place( &bigStart, &bigSize, &big[0], 20 );
+    arena.Place( &starts[5], &sizes[5], &changed[0], 6 );
+    arena.Place( &starts[0], &sizes[0], &changed[0], 6 );
+    uint32_t mergedStart = 0, mergedEnd = 168;
+    CPUT_CHECK( 168 * sizeof(CPUTGUIVertex) == arena.Upload( &backend, buffer ) );
+    CheckUploads( backend, buffer, arena, 1, &mergedStart, &mergedEnd );
+
+    arena.Place( &starts[0], &sizes[0], &vertices[0], 6 );   // [0, 12)
+    arena.Place( &starts[6], &sizes[6], &vertices[0], 6 );   // [72, 84): 60 past it
+    arena.Place( &starts[7], &sizes[7], &vertices[0], 6 );   // [84, 96), touching [72, 84)
+    uint32_t splitStarts[2] = { 0, 72 }, splitEnds[2] = { 12, 96 };
+    CPUT_CHECK( (12 + 24) * sizeof(CPUTGUIVertex) == arena.Upload( &backend, buffer ) );
+    CheckUploads( backend, buffer, arena, 2, splitStarts, splitEnds );
+
+    // A control that moves uploads its padded old range and its new one
+    std::vector<CPUTGUIVertex> grown = MakeVertices( 18, 4.0f );
+    arena.Place( &starts[1], &sizes[1], &grown[0], 18 );
+    CPUT_CHECK( 168 == starts[1] && 30 == sizes[1] );
+    uint32_t movedStarts[2] = { 12, 168 }, movedEnds[2] = { 24, 198 };
+    arena.Upload( &backend, buffer );
+    CheckUploads( backend, buffer, arena, 2, movedStarts, movedEnds );
+    backend.ReleaseBuffer( buffer );
+}
+
+// Ranges 48 and 49 vertices apart.  Near the end of the arena, ranges are no bigger than
+// the vertices, so they needn't be whole quads.
+//-----------------------------------------------------------------------------
+static void TestMergeGap()
+{
+    CPUTRenderBackendNull backend;
+    CPUTBackendHandle buffer = backend.CreateBuffer( 100 * sizeof(CPUTGUIVertex), CPUT_BIND_VERTEX_BUFFER, false, NULL );
+    backend.SetRecording( true );
+    for( uint32_t gap=48; gap<=49; gap++ )
+    {
+        CPUTGuiVertexArena arena( 21 + gap );
+        std::vector<CPUTGUIVertex> vertices = MakeVertices( gap, 1.0f );
+        uint32_t start[3] = { 0, 0, 0 }, size[3] = { 0, 0, 0 };
+        arena.Place( &start[0], &size[0], &vertices[0], 1 );
+        arena.Place( &start[1], &size[1], &vertices[0], gap );
+        arena.Place( &start[2], &size[2], &vertices[0], 1 );
+        CPUT_CHECK( 6 == size[0] && gap == size[1] && 6 + gap == start[2] && 6 == size[2] );
+        arena.Upload( &backend, buffer );
+        backend.ClearRecording();
+
+        arena.Place( &start[2], &size[2], &vertices[0], 2 );
+        arena.Place( &start[0], &size[0], &vertices[0], 2 );
+        uint32_t end = 12 + gap;
+        CPUT_CHECK( (48 == gap ? end : 12) * sizeof(CPUTGUIVertex) == arena.Upload( &backend, buffer ) );
+        uint32_t starts[2] = { 0, 6 + gap }, ends[2] = { 6, end };
+        if( 48 == gap )
+        {
+            CheckUploads( backend, buffer, arena, 1, starts, &end );
+        }
+        else
+        {
+            CheckUploads( backend, buffer, arena, 2, starts, ends );
+        }
+    }
+    backend.ReleaseBuffer( buffer );
+}
+
+// A label of the panel, as CPUTGuiControllerDX11 keeps one: its text and its range
+//-----------------------------------------------------------------------------
+struct CPUTTestLabel
+{
+    uint32_t mLength;
+    bool     mDirty;
+    uint32_t mStart;
+    uint32_t mCount;
+};
+
+// As CPUTGuiControllerDX11::PlaceControls(): writes the dirty labels (or all of them)
+// into the arena, and returns false if it ran out of room.
+//-----------------------------------------------------------------------------
+static bool PlaceLabels( CPUTGuiVertexArena &arena, std::vector<CPUTTestLabel> &labels, bool rebuildAll )
+{
+    if( rebuildAll )
+    {
+        arena.Reset();
+        for( size_t ii=0; ii<labels.size(); ii++ )
+        {
+            labels[ii].mStart = labels[ii].mCount = 0;
+        }
+    }
+    for( size_t ii=0; ii<labels.size(); ii++ )
+    {
+        if( !rebuildAll && !labels[ii].mDirty )
+        {
+            continue;
+        }
+        std::vector<CPUTGUIVertex> vertices = MakeVertices( 6 * labels[ii].mLength, (float)ii + 1.0f );
+        if( !arena.Place( &labels[ii].mStart, &labels[ii].mCount, vertices.empty() ? NULL : &vertices[0], (uint32_t)vertices.size() ) )
+        {
+            return false;
+        }
+        labels[ii].mDirty = false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static void TestRepack()
+{
+    CPUTGuiVertexArena arena( 600 );
+    std::vector<CPUTTestLabel> labels( 10 );
+    for( uint32_t ii=0; ii<10; ii++ )
+    {
+        CPUTTestLabel label = { 4, true, 0, 0 };
+        labels[ii] = label;
+    }
+    CPUT_CHECK( PlaceLabels( arena, labels, true ) );
+    CPUT_CHECK( 360 == arena.GetVertexCount() );
+
+    // One label grows a character a frame.  Each time it outgrows its range it leaves the
+    // old one behind, until the arena is full; then, as RebuildDirtyControls() does, every
+    // label is placed again from an empty arena.
+    uint32_t repacks = 0;
+    for( uint32_t ff=0; ff<30; ff++ )
+    {
+        labels[3].mLength++;
+        labels[3].mDirty = true;
+        if( !PlaceLabels( arena, labels, false ) )
+        {
+            CPUT_CHECK( PlaceLabels( arena, labels, true ) );
+            CPUT_CHECK( 0 == arena.GetWasted() );
+            repacks++;
+        }
+        for( uint32_t ii=0; ii<10; ii++ )
+        {
+            CPUT_CHECK( RangeHolds( arena, labels[ii].mStart, labels[ii].mCount, MakeVertices( 6 * labels[ii].mLength, (float)ii + 1.0f ) ) );
+        }
+    }
+    CPUT_CHECK( repacks > 0 );
+    CPUT_CHECK( 34 == labels[3].mLength );
+
+    // Even packed from scratch they don't fit: PlaceControls() fails both times, and
+    // RebuildDirtyControls() asserts
+    labels[3].mLength = 100;
+    labels[3].mDirty  = true;
+    CPUT_CHECK( !PlaceLabels( arena, labels, false ) );
+    CPUT_CHECK( !PlaceLabels( arena, labels, true ) );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestPlace();
+    TestUpload();
+    TestMergeGap();
+    TestRepack();
+    return CPUTTestResult();
+}
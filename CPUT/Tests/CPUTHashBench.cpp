@@ -0,0 +1,154 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTHash.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <map>
+#include <string>
+#include <wchar.h>
+
+// Input layout lookups, 64 layouts of 3 to 15 elements against 16 vertex shaders, keyed
+// three ways: the wide string CPUTInputLayoutCacheDX11 used to build (semantic and
+// format names, then the shader's address) in a std::map; the element fields hashed as
+// HashLayout() does, in a CPUTFlatHashMap; and with the layout hash precomputed, as
+// meshes now do, leaving one combine with the shader's signature hash per lookup.  The
+// elements are a stand-in for D3D11_INPUT_ELEMENT_DESC with the same fields.
+
+static const uint32_t kLayouts  = 64;
+static const uint32_t kShaders  = 16;
+static const uint32_t kLookups  = 1000000;
+
+static volatile uintptr_t sSink;
+
+//-----------------------------------------------------------------------------
+struct CPUTTestElement
+{
+    const char *SemanticName;
+    uint32_t    SemanticIndex;
+    uint32_t    Format;
+    uint32_t    InputSlot;
+    uint32_t    AlignedByteOffset;
+    uint32_t    InputSlotClass;
+    uint32_t    InstanceDataStepRate;
+};
+
+static const char *kSemantics[5] = { "POSITION", "NORMAL", "TANGENT", "BINORMAL", "TEXCOORD" };
+static const char *kFormats[4]   = { "DXGI_FORMAT_R32G32B32_FLOAT", "DXGI_FORMAT_R32G32_FLOAT", "DXGI_FORMAT_R16G16B16A16_SNORM", "DXGI_FORMAT_R8G8B8A8_UNORM" };
+
+//-----------------------------------------------------------------------------
+static std::wstring Widen( const char *pString )
+{
+    return std::wstring( pString, pString + strlen( pString ) );
+}
+
+// As the old GenerateLayoutKey() plus ptoc() of the shader
+//-----------------------------------------------------------------------------
+static std::wstring StringKey( const CPUTTestElement *pLayout, const void *pShader )
+{
+    std::wstring key = Widen( pLayout[0].SemanticName ) + L":" + Widen( kFormats[pLayout[0].Format] );
+    for( int index=1; NULL != pLayout[index].SemanticName; index++ )
+    {
+        key = key + L"," + Widen( pLayout[index].SemanticName ) + L":" + Widen( kFormats[pLayout[index].Format] );
+    }
+    wchar_t address[32];
+    swprintf( address, 32, L"%p", pShader );
+    return key + address;
+}
+
+// As CPUTInputLayoutCacheDX11::HashLayout()
+//-----------------------------------------------------------------------------
+static uint64_t HashLayout( const CPUTTestElement *pLayout )
+{
+    uint64_t hash = CPUT_HASH_SEED;
+    for( int index=0; NULL != pLayout[index].SemanticName; index++ )
+    {
+        const CPUTTestElement &element = pLayout[index];
+        uint32_t fields[6] = { element.SemanticIndex, element.Format, element.InputSlot, element.AlignedByteOffset, element.InputSlotClass, element.InstanceDataStepRate };
+        hash = CPUTHashString( element.SemanticName, hash );
+        hash = CPUTHashBytes( fields, sizeof(fields), hash );
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, double seconds )
+{
+    printf( "  %-32s %7.1f ns/lookup\n", pName, seconds * 1e9 / kLookups );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTTestRandom random( 5 );
+    CPUTTestElement layouts[kLayouts][16];
+    uint64_t        layoutHashes[kLayouts];
+    for( uint32_t ii=0; ii<kLayouts; ii++ )
+    {
+        uint32_t count  = 3 + ii % 13;
+        uint32_t offset = 0;
+        for( uint32_t jj=0; jj<count; jj++ )
+        {
+            CPUTTestElement element = { kSemantics[jj < 4 ? jj : 4], jj < 4 ? 0 : jj - 4, random.Index( 4 ), 0, offset, 0, 0 };
+            layouts[ii][jj] = element;
+            offset += 12;
+        }
+        CPUTTestElement end = { NULL, 0, 0, 0, 0, 0, 0 };
+        layouts[ii][count] = end;
+        layoutHashes[ii]   = HashLayout( layouts[ii] );
+    }
+    int      shaders[kShaders];
+    uint64_t signatureHashes[kShaders];
+    for( uint32_t ii=0; ii<kShaders; ii++ )
+    {
+        signatureHashes[ii] = CPUTHashBytes( &ii, sizeof(ii) );
+    }
+
+    std::map<std::wstring, uintptr_t> stringMap;
+    CPUTFlatHashMap<uintptr_t>        flatMap;
+    for( uint32_t ii=0; ii<kLayouts; ii++ )
+    {
+        for( uint32_t ss=0; ss<kShaders; ss++ )
+        {
+            stringMap[StringKey( layouts[ii], &shaders[ss] )] = ii * kShaders + ss;
+            flatMap.Insert( CPUTHashBytes( &signatureHashes[ss], sizeof(uint64_t), layoutHashes[ii] ), ii * kShaders + ss );
+        }
+    }
+
+    // Lookups in draw order: a mesh draws with a few shaders in turn
+    double start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ii=0; ii<kLookups; ii++ )
+    {
+        sSink = stringMap[StringKey( layouts[(ii / 4) % kLayouts], &shaders[ii % kShaders] )];
+    }
+    Report( "String key, std::map", CPUTFrameScheduler::GetSeconds() - start );
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ii=0; ii<kLookups; ii++ )
+    {
+        uint64_t key = CPUTHashBytes( &signatureHashes[ii % kShaders], sizeof(uint64_t), HashLayout( layouts[(ii / 4) % kLayouts] ) );
+        sSink = *flatMap.Find( key );
+    }
+    Report( "Hashed layout, flat map", CPUTFrameScheduler::GetSeconds() - start );
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ii=0; ii<kLookups; ii++ )
+    {
+        uint64_t key = CPUTHashBytes( &signatureHashes[ii % kShaders], sizeof(uint64_t), layoutHashes[(ii / 4) % kLayouts] );
+        sSink = *flatMap.Find( key );
+    }
+    Report( "Precomputed hash, flat map", CPUTFrameScheduler::GetSeconds() - start );
+    return 0;
+}
@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTHash.h"
+#include "CPUTTest.h"
+#include <map>
+
+// Checks CPUTHashBytes() and CPUTHashString() against published FNV-1a values and for
+// chaining, and CPUTFlatHashMap against std::map over random inserts, replacements and
+// misses through several growths, including keys that fold to the same slot.
+
+//-----------------------------------------------------------------------------
+static void TestHash()
+{
+    CPUT_CHECK( 0xCBF29CE484222325ull == CPUTHashBytes( "", 0 ) );
+    CPUT_CHECK( 0xAF63DC4C8601EC8Cull == CPUTHashBytes( "a", 1 ) );
+    CPUT_CHECK( 0x85944171F73967E8ull == CPUTHashBytes( "foobar", 6 ) );
+
+    // Hashing in pieces equals hashing the whole
+    CPUT_CHECK( CPUTHashBytes( "foobar", 6 ) == CPUTHashBytes( "bar", 3, CPUTHashBytes( "foo", 3 ) ) );
+
+    // Strings include their terminator
+    CPUT_CHECK( CPUTHashBytes( "a", 2 ) == CPUTHashString( "a" ) );
+    CPUT_CHECK( CPUTHashString( "" ) == CPUTHashString( NULL ) );
+    CPUT_CHECK( CPUTHashString( "c", CPUTHashString( "ab" ) ) != CPUTHashString( "bc", CPUTHashString( "a" ) ) );
+    CPUT_CHECK( CPUTHashString( "ab" ) != CPUTHashString( "ba" ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestMap()
+{
+    CPUTFlatHashMap<uint32_t> map;
+    CPUT_CHECK( NULL == map.Find( 0 ) );
+    CPUT_CHECK( 0 == map.GetCount() && 0 == map.GetCapacity() );
+
+    // 0 is a key like any other, and these three fold to the same slot
+    const uint64_t sameSlot[3] = { 0, 0x0000000100000001ull, 0x8000000080000000ull };
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        map.Insert( sameSlot[ii], ii + 1 );
+    }
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        CPUT_CHECK( NULL != map.Find( sameSlot[ii] ) && ii + 1 == *map.Find( sameSlot[ii] ) );
+    }
+    CPUT_CHECK( NULL == map.Find( 0x0000000200000002ull ) );
+    map.Clear();
+    CPUT_CHECK( NULL == map.Find( 0 ) && 0 == map.GetCount() );
+
+    std::map<uint64_t, uint32_t> reference;
+    CPUTTestRandom random( 37 );
+    for( uint32_t ii=0; ii<200000; ii++ )
+    {
+        // Few enough distinct keys that many inserts replace
+        uint64_t key = CPUTHashBytes( &ii, sizeof(ii) ) % 49999;
+        key = CPUTHashBytes( &key, sizeof(key) );
+        uint32_t value = random.Next();
+        uint32_t &inserted = map.Insert( key, value );
+        CPUT_CHECK( value == inserted );
+        reference[key] = value;
+        if( 0 == (ii % 1000) )
+        {
+            CPUT_CHECK( reference.size() == map.GetCount() );
+        }
+    }
+    CPUT_CHECK( reference.size() == map.GetCount() );
+    CPUT_CHECK( 2 * map.GetCount() <= map.GetCapacity() );
+
+    uint32_t mismatches = 0;
+    for( std::map<uint64_t, uint32_t>::iterator it = reference.begin(); it != reference.end(); ++it )
+    {
+        uint32_t *pFound = map.Find( it->first );
+        mismatches += (!pFound || *pFound != it->second) ? 1 : 0;
+    }
+    CPUT_CHECK( 0 == mismatches );
+    uint32_t falseHits = 0;
+    for( uint32_t ii=0; ii<100000; ii++ )
+    {
+        uint64_t key = ((uint64_t)random.Next() << 40) ^ ((uint64_t)random.Next() << 16) ^ random.Next();
+        falseHits += (map.Find( key ) && 0 == reference.count( key )) ? 1 : 0;
+    }
+    CPUT_CHECK( 0 == falseHits );
+
+    // Iteration visits every value once
+    uint32_t used = 0;
+    uint64_t sum  = 0, referenceSum = 0;
+    for( uint32_t ii=0; ii<map.GetCapacity(); ii++ )
+    {
+        if( map.IsUsed( ii ) )
+        {
+            used++;
+            sum += map.GetValue( ii );
+        }
+    }
+    for( std::map<uint64_t, uint32_t>::iterator it = reference.begin(); it != reference.end(); ++it )
+    {
+        referenceSum += it->second;
+    }
+    CPUT_CHECK( used == map.GetCount() );
+    CPUT_CHECK( sum == referenceSum );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestHash();
+    TestMap();
+    return CPUTTestResult();
+}
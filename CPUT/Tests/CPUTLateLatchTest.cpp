@@ -0,0 +1,217 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTLateLatch.h"
+#include "CPUTRenderQueue.h"
+#include "CPUTModel.h"
+#include "CPUTMaterial.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTThreadPool.h"
+#include "CPUTTransformHierarchy.h"
+#include "CPUTUploadRing.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <vector>
+
+// Submits models (against the stand-ins in Shims/) with a late latch that moves every
+// one of them, serially and on 4 threads, with and without the upload ring and with an
+// instanced material.  Checks that the latch runs once per Submit(), before anything
+// reaches the backend, and that every constant and instance written afterwards holds
+// the latched matrix, never the one the models were queued with.  Also checks that the
+// transform hierarchy is brought up to date after the latch, and CPUTLatencyStats.
+
+static const uint32_t kModels = 64;
+static const uint32_t kMeshes = 4;
+static const uint32_t kFrames = 3;
+
+// Translations mark matrices: queued models sit at x = kQueuedX + index, latched ones at kLatchedX + index
+static const float kQueuedX  = 500000.0f;
+static const float kLatchedX = 900000.0f;
+
+//-----------------------------------------------------------------------------
+class CPUTTestLatch : public CPUTLateLatch
+{
+public:
+    CPUTRenderBackendNull   *mpBackend;
+    std::vector<CPUTModel*> *mpModels;
+    CPUTTransformHandle      mNode;
+    uint32_t                 mCalls;
+    uint32_t                 mCommandsBeforeLatch;
+
+    void Latch( CPUTRenderParameters &renderParams )
+    {
+        CPUT_CHECK( renderParams.mpBackend == mpBackend );
+        mCalls++;
+        mCommandsBeforeLatch += mpBackend->GetRecordedCommandCount();
+        for( uint32_t ii=0; ii<mpModels->size(); ii++ )
+        {
+            (*mpModels)[ii]->SetParentMatrix( float4x4Translation( kLatchedX + ii, 0.0f, 0.0f ) );
+        }
+        CPUTTransformHierarchy::GetDefaultHierarchy()->SetLocal( mNode, float4x4Translation( kLatchedX, 0.0f, 0.0f ) );
+    }
+};
+
+// Counts the queued and latched marks in the buffer data the backend received
+//-----------------------------------------------------------------------------
+static void CountMarks( const CPUTRenderBackendNull &backend, uint32_t *pQueued, std::vector<uint32_t> *pLatched )
+{
+    for( uint32_t ii=0; ii<backend.GetRecordedCommandCount(); ii++ )
+    {
+        const CPUTBackendCommand &command = backend.GetRecordedCommand( ii );
+        if( CPUT_BACKEND_CMD_UPDATE_BUFFER != command.mType || 0 == command.mPayloadSize )
+        {
+            continue;
+        }
+        std::vector<float> floats( command.mPayloadSize / sizeof(float), 0.0f );
+        memcpy( &floats[0], backend.GetRecordedPayload( command ), floats.size() * sizeof(float) );
+        for( size_t jj=0; jj<floats.size(); jj++ )
+        {
+            *pQueued += (floats[jj] >= kQueuedX && floats[jj] < kQueuedX + kModels) ? 1 : 0;
+            if( floats[jj] >= kLatchedX && floats[jj] < kLatchedX + kModels )
+            {
+                (*pLatched)[(uint32_t)(floats[jj] - kLatchedX)]++;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void TestLatch( CPUTThreadPool *pPool, uint32_t threadCount, bool useRing, bool instanced )
+{
+    CPUTRenderBackendNull backend;
+    std::vector<uint8_t> data( 64 * 32, 1 );
+    std::vector<CPUTMesh*> meshes;
+    for( uint32_t ii=0; ii<kMeshes; ii++ )
+    {
+        CPUTBackendHandle vertices = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_VERTEX_BUFFER, false, &data[0] );
+        CPUTBackendHandle indices  = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_INDEX_BUFFER, false, &data[0] );
+        meshes.push_back( new CPUTMesh( vertices, indices, 36, true ) );
+    }
+    CPUTMaterial material( (CPUTBackendHandle)0x100000, instanced ? (CPUTBackendHandle)0x100001 : 0, (CPUTBackendHandle)0x100002, (CPUTBackendHandle)0x100003 );
+    std::vector<CPUTModel*> models;
+    for( uint32_t ii=0; ii<kModels; ii++ )
+    {
+        models.push_back( new CPUTModel( &backend, meshes[ii % kMeshes], float4x4Identity() ) );
+    }
+    CPUTUploadRing ring;
+    if( useRing )
+    {
+        ring.Create( &backend, kModels * CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT );
+    }
+    CPUTTransformHierarchy *pHierarchy = CPUTTransformHierarchy::GetDefaultHierarchy();
+    CPUTTestLatch latch;
+    latch.mpBackend            = &backend;
+    latch.mpModels             = &models;
+    latch.mNode                = pHierarchy->Allocate();
+    latch.mCalls               = 0;
+    latch.mCommandsBeforeLatch = 0;
+
+    CPUTRenderQueue queue;
+    queue.SetThreadPool( threadCount > 1 ? pPool : NULL, threadCount );
+    CPUTRenderParameters renderParams;
+    renderParams.mpBackend    = &backend;
+    renderParams.mpUploadRing = useRing ? &ring : NULL;
+    renderParams.mpLateLatch  = &latch;
+    uint32_t queued = 0;
+    std::vector<uint32_t> latched( kModels, 0 );
+    for( uint32_t frame=0; frame<kFrames; frame++ )
+    {
+        // Update() places the models; the latch moves them again
+        for( uint32_t ii=0; ii<models.size(); ii++ )
+        {
+            models[ii]->SetParentMatrix( float4x4Translation( kQueuedX + ii, 0.0f, 0.0f ) );
+        }
+        pHierarchy->SetLocal( latch.mNode, float4x4Identity() );
+        ring.BeginFrame();
+        for( uint32_t ii=0; ii<kModels; ii++ )
+        {
+            uint32_t depth = CPUTRenderQueue::QuantizeDepth( 1.0f + ii );
+            depth = instanced ? CPUTRenderQueue::MakeInstancedDepth( ii % kMeshes, depth ) : depth;
+            queue.AddPacket( CPUTRenderQueue::MakeKey( CPUT_RENDER_PASS_OPAQUE, 0, 0, 0, depth ), models[ii], &material, 0 );
+        }
+        backend.ClearRecording();
+        backend.SetRecording( true );
+        queue.Submit( renderParams );
+        backend.SetRecording( false );
+        ring.EndFrame();
+        CountMarks( backend, &queued, &latched );
+
+        CPUT_CHECK( frame + 1 == latch.mCalls );
+        CPUT_CHECK( !pHierarchy->IsDirty() );
+        CPUT_CHECK( kLatchedX == pHierarchy->GetWorld( latch.mNode )->r3.x );
+    }
+    CPUT_CHECK( 0 == latch.mCommandsBeforeLatch );
+    CPUT_CHECK( 0 == queued );
+    for( uint32_t ii=0; ii<kModels; ii++ )
+    {
+        CPUT_CHECK( latched[ii] >= kFrames );
+    }
+
+    queue.ReleaseResources();
+    ring.Release();
+    pHierarchy->Free( latch.mNode );
+    for( size_t ii=0; ii<models.size(); ii++ ) { delete models[ii]; }
+    for( size_t ii=0; ii<meshes.size(); ii++ ) { delete meshes[ii]; }
+}
+
+//-----------------------------------------------------------------------------
+static void TestLatencyStats()
+{
+    CPUTLatencyStats stats;
+    CPUT_CHECK( 0 == stats.GetCount() );
+    CPUT_CHECK( 0.0 == stats.GetLast() && 0.0 == stats.GetAverage() && 0.0 == stats.GetMax() && 0.0 == stats.GetPercentile( 50.0 ) );
+
+    // 1..10 ms, shuffled
+    const double samples[10] = { 4, 9, 1, 7, 10, 3, 6, 2, 8, 5 };
+    for( uint32_t ii=0; ii<10; ii++ )
+    {
+        stats.AddSample( samples[ii] * 0.001 );
+    }
+    CPUT_CHECK( 10 == stats.GetCount() );
+    CPUT_CHECK_NEAR( stats.GetLast(), 0.005, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetAverage(), 0.0055, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetMax(), 0.010, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetPercentile( 0.0 ), 0.001, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetPercentile( 50.0 ), 0.005, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetPercentile( 91.0 ), 0.010, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetPercentile( 100.0 ), 0.010, 1e-12 );
+
+    // The window keeps the last CPUT_LATENCY_WINDOW samples
+    for( uint32_t ii=0; ii<CPUT_LATENCY_WINDOW; ii++ )
+    {
+        stats.AddSample( 1.0 + ii );
+    }
+    CPUT_CHECK( CPUT_LATENCY_WINDOW == stats.GetCount() );
+    CPUT_CHECK_NEAR( stats.GetLast(), (double)CPUT_LATENCY_WINDOW, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetAverage(), (CPUT_LATENCY_WINDOW + 1) * 0.5, 1e-9 );
+    CPUT_CHECK_NEAR( stats.GetPercentile( 0.0 ), 1.0, 1e-12 );
+    CPUT_CHECK_NEAR( stats.GetPercentile( 99.0 ), ceil( 0.99 * CPUT_LATENCY_WINDOW ), 1e-12 );
+
+    stats.Reset();
+    CPUT_CHECK( 0 == stats.GetCount() && 0.0 == stats.GetMax() );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTThreadPool pool( 3 );
+    for( uint32_t variant=0; variant<8; variant++ )
+    {
+        TestLatch( &pool, (variant & 1) ? 4 : 1, 0 != (variant & 2), 0 != (variant & 4) );
+    }
+    TestLatencyStats();
+    CPUTTransformHierarchy::DeleteDefaultHierarchy();
+    return CPUTTestResult();
+}
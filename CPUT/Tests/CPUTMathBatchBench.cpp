@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMathBatch.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// Nanoseconds per element for each CPUTMathBatch kernel, next to the same work done one
+// element at a time with the CPUTMath operators.  Build with and without CPUT_MATH_NO_SIMD
+// (or -mavx) to compare the backends.
+
+static const uint32_t kCount       = 16384;   // Fits in L2, so this times the arithmetic
+static const uint32_t kRepetitions = 200;
+
+static volatile float sSink;
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, double startSeconds )
+{
+    double seconds = CPUTFrameScheduler::GetSeconds() - startSeconds;
+    printf( "  %-36s %6.2f ns\n", pName, seconds * 1e9 / ((double)kRepetitions * kCount) );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTTestRandom random( 7 );
+    const float3 zero3( 0.0f, 0.0f, 0.0f );
+    const float4 zero4( 0.0f, 0.0f, 0.0f, 0.0f );
+    std::vector<float4x4> a( kCount, float4x4Identity() ), b( kCount, float4x4Identity() ), out( kCount, float4x4Identity() );
+    std::vector<float3>   points( kCount, zero3 ), points3( kCount, zero3 ), halves( kCount, zero3 ), centersOut( kCount, zero3 ), halvesOut( kCount, zero3 );
+    std::vector<float4>   vectors( kCount, zero4 ), vectorsOut( kCount, zero4 );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        a[ii] = float4x4RotationY( random.Float(-3.0f, 3.0f) ) * float4x4Translation( random.Float(-9.0f, 9.0f), 0.0f, 1.0f );
+        b[ii] = float4x4RotationX( random.Float(-3.0f, 3.0f) ) * float4x4Scale( 2.0f, 1.0f, 1.0f );
+        points[ii]  = float3( random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f), random.Float(-5.0f, 5.0f) );
+        halves[ii]  = float3( 1.0f, 2.0f, 0.5f );
+        vectors[ii] = float4( points[ii], 1.0f );
+    }
+    const float4x4 m = a[0];
+
+#if defined(CPUT_MATH_SSE) && defined(__AVX__)
+    printf( "SSE backend with AVX, %u elements\n", kCount );
+#elif defined(CPUT_MATH_SSE)
+    printf( "SSE backend, %u elements\n", kCount );
+#elif defined(CPUT_MATH_NEON)
+    printf( "NEON backend, %u elements\n", kCount );
+#else
+    printf( "Scalar backend, %u elements\n", kCount );
+#endif
+
+    double start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { for( uint32_t ii=0; ii<kCount; ii++ ) { out[ii] = a[ii] * b[ii]; } }
+    Report( "float4x4 * float4x4 (operator)", start );
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { CPUTMultiplyMatrices( &out[0], &a[0], &b[0], kCount ); }
+    Report( "CPUTMultiplyMatrices", start );
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { CPUTMultiplyMatrices( &out[0], &a[0], m, kCount ); }
+    Report( "CPUTMultiplyMatrices (one parent)", start );
+    sSink = out[kCount-1].r3.x;
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { for( uint32_t ii=0; ii<kCount; ii++ ) { out[ii] = inverse( a[ii] ); } }
+    Report( "inverse", start );
+    sSink = out[kCount-1].r3.x;
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { for( uint32_t ii=0; ii<kCount; ii++ ) { vectorsOut[ii] = vectors[ii] * m; } }
+    Report( "float4 * float4x4 (operator)", start );
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { CPUTTransformFloat4s( &vectorsOut[0], &vectors[0], kCount, m ); }
+    Report( "CPUTTransformFloat4s", start );
+    sSink = vectorsOut[kCount-1].x;
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ )
+    {
+        for( uint32_t ii=0; ii<kCount; ii++ )
+        {
+            float4 p = float4( points[ii], 1.0f ) * m;
+            points3[ii] = float3( p.x, p.y, p.z );
+        }
+    }
+    Report( "point (float4 operator)", start );
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { CPUTTransformPoints( &points3[0], &points[0], kCount, m ); }
+    Report( "CPUTTransformPoints", start );
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { CPUTTransformVectors( &points3[0], &points[0], kCount, m ); }
+    Report( "CPUTTransformVectors", start );
+    sSink = points3[kCount-1].x;
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { for( uint32_t ii=0; ii<kCount; ii++ ) { points3[ii] = normalize( points[ii] ); } }
+    Report( "normalize (operator)", start );
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { CPUTNormalizeVectors( &points3[0], &points[0], kCount ); }
+    Report( "CPUTNormalizeVectors", start );
+    sSink = points3[kCount-1].x;
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t rr=0; rr<kRepetitions; rr++ ) { CPUTTransformBoxes( &centersOut[0], &halvesOut[0], &points[0], &halves[0], kCount, m ); }
+    Report( "CPUTTransformBoxes", start );
+    sSink = centersOut[kCount-1].x + halvesOut[kCount-1].x;
+    return 0;
+}
@@ -0,0 +1,286 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTest.h"
+#include "CPUTMathBatch.h"
+#include <float.h>
+#include <string.h>
+#include <vector>
+
+// Checks the CPUTMath operators and the CPUTMathBatch kernels against plain scalar
+// loops.  Built twice: with the SIMD backend CPUTMath.h picks, and with CPUT_MATH_NO_SIMD.
+// The results may differ from the reference by rounding (the compiler may fuse
+// multiply-adds), so the checks allow a few ulps.
+
+static const float kTolerance = 1e-5f;  // Relative to the magnitude of the values
+static const uint32_t kCount  = 1027;   // Not a multiple of any SIMD width, to cover the tails
+
+static CPUTTestRandom sRandom( 41 );
+static const float3   sZero3( 0.0f, 0.0f, 0.0f );
+static const float4   sZero4( 0.0f, 0.0f, 0.0f, 0.0f );
+
+//-----------------------------------------------------------------------------
+static float4x4 RandomAffine()
+{
+    float3 axis( sRandom.Float(-1.0f, 1.0f), sRandom.Float(-1.0f, 1.0f), sRandom.Float(0.1f, 1.0f) );
+    return float4x4RotationAxis( normalize(axis), sRandom.Float(-3.0f, 3.0f) )
+         * float4x4Scale( sRandom.Float(0.5f, 2.0f), sRandom.Float(0.5f, 2.0f), sRandom.Float(0.5f, 2.0f) )
+         * float4x4Translation( sRandom.Float(-10.0f, 10.0f), sRandom.Float(-10.0f, 10.0f), sRandom.Float(-10.0f, 10.0f) );
+}
+
+//-----------------------------------------------------------------------------
+static float4x4 RandomMatrix()
+{
+    float4x4 m;
+    float *pM = (float*)&m;
+    for( uint32_t ii=0; ii<16; ii++ )
+    {
+        pM[ii] = sRandom.Float(-2.0f, 2.0f);
+    }
+    return m;
+}
+
+//-----------------------------------------------------------------------------
+static float3 RandomFloat3( float range )
+{
+    return float3( sRandom.Float(-range, range), sRandom.Float(-range, range), sRandom.Float(-range, range) );
+}
+
+//-----------------------------------------------------------------------------
+static bool Near( const float *pA, const float *pB, uint32_t count )
+{
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        if( fabsf( pA[ii] - pB[ii] ) > kTolerance * (1.0f + fabsf( pB[ii] )) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The scalar reference: row vectors, out = v * m
+//-----------------------------------------------------------------------------
+static void ReferenceTransform( float *pOut, const float *pV, const float4x4 &m )
+{
+    const float *pM = (const float*)&m;
+    for( uint32_t cc=0; cc<4; cc++ )
+    {
+        pOut[cc] = pV[0]*pM[cc] + pV[1]*pM[4+cc] + pV[2]*pM[8+cc] + pV[3]*pM[12+cc];
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void ReferenceMultiply( float4x4 *pOut, const float4x4 &a, const float4x4 &b )
+{
+    const float *pA = (const float*)&a;
+    float *pOutRows = (float*)pOut;
+    for( uint32_t rr=0; rr<4; rr++ )
+    {
+        ReferenceTransform( pOutRows + 4*rr, pA + 4*rr, b );
+    }
+}
+
+// Transform the eight corners and take their bounds
+//-----------------------------------------------------------------------------
+static void ReferenceBox( float3 *pCenterOut, float3 *pHalfOut, const float3 &center, const float3 &half, const float4x4 &m )
+{
+    float3 mn( FLT_MAX, FLT_MAX, FLT_MAX ), mx( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+    for( uint32_t corner=0; corner<8; corner++ )
+    {
+        float p[4] = { center.x + ((corner & 1) ? half.x : -half.x),
+                       center.y + ((corner & 2) ? half.y : -half.y),
+                       center.z + ((corner & 4) ? half.z : -half.z), 1.0f };
+        float q[4];
+        ReferenceTransform( q, p, m );
+        mn = float3( q[0] < mn.x ? q[0] : mn.x, q[1] < mn.y ? q[1] : mn.y, q[2] < mn.z ? q[2] : mn.z );
+        mx = float3( q[0] > mx.x ? q[0] : mx.x, q[1] > mx.y ? q[1] : mx.y, q[2] > mx.z ? q[2] : mx.z );
+    }
+    *pCenterOut = (mx + mn) * 0.5f;
+    *pHalfOut   = (mx - mn) * 0.5f;
+}
+
+//-----------------------------------------------------------------------------
+static void TestOperators()
+{
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        float4x4 a = (ii & 1) ? RandomAffine() : RandomMatrix();
+        float4x4 b = RandomAffine();
+        float4x4 product = a * b;
+        float4x4 reference;
+        ReferenceMultiply( &reference, a, b );
+        CPUT_CHECK( Near( (float*)&product, (float*)&reference, 16 ) );
+
+        float4 v( sRandom.Float(-2.0f, 2.0f), sRandom.Float(-2.0f, 2.0f), sRandom.Float(-2.0f, 2.0f), sRandom.Float(-2.0f, 2.0f) );
+        float4 transformed = v * a;
+        float referenceV[4];
+        ReferenceTransform( referenceV, v.f, a );
+        CPUT_CHECK( Near( transformed.f, referenceV, 4 ) );
+
+        // The SIMD inverse takes another route, so check what it's for
+        float4x4 identity = b * inverse(b);
+        CPUT_CHECK_NEAR( identity.r0.x, 1.0f, 1e-4 );
+        CPUT_CHECK_NEAR( identity.r1.y, 1.0f, 1e-4 );
+        CPUT_CHECK_NEAR( identity.r2.z, 1.0f, 1e-4 );
+        CPUT_CHECK_NEAR( identity.r3.w, 1.0f, 1e-4 );
+        CPUT_CHECK_NEAR( identity.r0.y, 0.0f, 1e-4 );
+        CPUT_CHECK_NEAR( identity.r3.x, 0.0f, 1e-4 );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void TestMultiplyMatrices()
+{
+    std::vector<float4x4> a( kCount, float4x4Identity() ), b( kCount, float4x4Identity() ), out( kCount, float4x4Identity() );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        a[ii] = (ii & 1) ? RandomAffine() : RandomMatrix();
+        b[ii] = RandomAffine();
+    }
+    float4x4 reference;
+
+    CPUTMultiplyMatrices( &out[0], &a[0], &b[0], kCount );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        ReferenceMultiply( &reference, a[ii], b[ii] );
+        CPUT_CHECK( Near( (float*)&out[ii], (float*)&reference, 16 ) );
+    }
+
+    CPUTMultiplyMatrices( &out[0], &a[0], b[7], kCount );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        ReferenceMultiply( &reference, a[ii], b[7] );
+        CPUT_CHECK( Near( (float*)&out[ii], (float*)&reference, 16 ) );
+    }
+
+    CPUTMultiplyMatrix4x4( &out[0], a[3], b[5] );
+    ReferenceMultiply( &reference, a[3], b[5] );
+    CPUT_CHECK( Near( (float*)&out[0], (float*)&reference, 16 ) );
+
+    // In place
+    std::vector<float4x4> inPlace = a;
+    CPUTMultiplyMatrices( &inPlace[0], &inPlace[0], &b[0], kCount );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        ReferenceMultiply( &reference, a[ii], b[ii] );
+        CPUT_CHECK( Near( (float*)&inPlace[ii], (float*)&reference, 16 ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void TestTransforms()
+{
+    std::vector<float3> points( kCount, sZero3 ), out3( kCount, sZero3 );
+    std::vector<float4> vectors( kCount, sZero4 ), out4( kCount, sZero4 );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        points[ii]  = RandomFloat3( 5.0f );
+        vectors[ii] = float4( RandomFloat3( 5.0f ), sRandom.Float(-1.0f, 1.0f) );
+    }
+    float4x4 m = RandomAffine();
+    float reference[4];
+
+    CPUTTransformPoints( &out3[0], &points[0], kCount, m );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        float p[4] = { points[ii].x, points[ii].y, points[ii].z, 1.0f };
+        ReferenceTransform( reference, p, m );
+        CPUT_CHECK( Near( out3[ii].f, reference, 3 ) );
+    }
+
+    CPUTTransformVectors( &out3[0], &points[0], kCount, m );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        float v[4] = { points[ii].x, points[ii].y, points[ii].z, 0.0f };
+        ReferenceTransform( reference, v, m );
+        CPUT_CHECK( Near( out3[ii].f, reference, 3 ) );
+    }
+
+    CPUTTransformFloat4s( &out4[0], &vectors[0], kCount, m );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        ReferenceTransform( reference, vectors[ii].f, m );
+        CPUT_CHECK( Near( out4[ii].f, reference, 4 ) );
+    }
+
+    // In place
+    std::vector<float3> inPlace = points;
+    CPUTTransformPoints( &inPlace[0], &inPlace[0], kCount, m );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        float p[4] = { points[ii].x, points[ii].y, points[ii].z, 1.0f };
+        ReferenceTransform( reference, p, m );
+        CPUT_CHECK( Near( inPlace[ii].f, reference, 3 ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void TestNormalize()
+{
+    std::vector<float3> vectors( kCount, sZero3 ), out( kCount, sZero3 );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        vectors[ii] = RandomFloat3( 100.0f );
+    }
+    CPUTNormalizeVectors( &out[0], &vectors[0], kCount );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        const float3 &v = vectors[ii];
+        float length = sqrtf( v.x*v.x + v.y*v.y + v.z*v.z );
+        float reference[3] = { v.x / length, v.y / length, v.z / length };
+        CPUT_CHECK( Near( out[ii].f, reference, 3 ) );
+    }
+    CPUTNormalizeVectors( &vectors[0], &vectors[0], kCount );
+    CPUT_CHECK( 0 == memcmp( &vectors[0], &out[0], kCount * sizeof(float3) ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestTransformBoxes()
+{
+    std::vector<float3> centers( kCount, sZero3 ), halves( kCount, sZero3 ), centersOut( kCount, sZero3 ), halvesOut( kCount, sZero3 );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        centers[ii] = RandomFloat3( 20.0f );
+        halves[ii]  = float3( sRandom.Float(0.0f, 5.0f), sRandom.Float(0.0f, 5.0f), sRandom.Float(0.0f, 5.0f) );
+    }
+    float4x4 m = RandomAffine();
+    CPUTTransformBoxes( &centersOut[0], &halvesOut[0], &centers[0], &halves[0], kCount, m );
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        float3 center, half;
+        ReferenceBox( &center, &half, centers[ii], halves[ii], m );
+        CPUT_CHECK( Near( centersOut[ii].f, center.f, 3 ) );
+        CPUT_CHECK( Near( halvesOut[ii].f, half.f, 3 ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+#if defined(CPUT_MATH_SSE)
+    printf( "SSE backend\n" );
+#elif defined(CPUT_MATH_NEON)
+    printf( "NEON backend\n" );
+#else
+    printf( "Scalar backend\n" );
+#endif
+    TestOperators();
+    TestMultiplyMatrices();
+    TestTransforms();
+    TestNormalize();
+    TestTransformBoxes();
+    return CPUTTestResult();
+}
@@ -0,0 +1,322 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMeshOptimizer.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+// CPUTMeshOptimizer on synthetic meshes: a grid (in order and shuffled) with a normal and
+// texture coordinates, and two concentric spheres.  Optimizing must keep the same
+// triangles with the same vertices (to within the quantization error) and improve what
+// each step is for.
+
+//-----------------------------------------------------------------------------
+struct CPUTTestMesh
+{
+    std::vector<uint8_t>           mVertices;
+    uint32_t                       mVertexCount;
+    uint32_t                       mStride;
+    std::vector<uint32_t>          mIndices;
+    std::vector<CPUTMeshAttribute> mAttributes;
+
+    const float *GetPosition( uint32_t vertex ) const { return (const float*)&mVertices[vertex * mStride + mAttributes[0].mOffset]; }
+};
+
+// A triangle's corner positions, for comparing meshes whatever the vertex and triangle order
+//-----------------------------------------------------------------------------
+struct CPUTTestTriangle
+{
+    float mPositions[9];
+
+    bool operator<( const CPUTTestTriangle &other ) const  { return memcmp( mPositions, other.mPositions, sizeof(mPositions) ) < 0; }
+    bool operator==( const CPUTTestTriangle &other ) const { return 0 == memcmp( mPositions, other.mPositions, sizeof(mPositions) ); }
+};
+
+//-----------------------------------------------------------------------------
+static std::vector<CPUTTestTriangle> GetTriangles( const CPUTTestMesh &mesh )
+{
+    std::vector<CPUTTestTriangle> triangles( mesh.mIndices.size() / 3 );
+    for( size_t ii=0; ii<triangles.size(); ii++ )
+    {
+        for( uint32_t jj=0; jj<3; jj++ )
+        {
+            memcpy( &triangles[ii].mPositions[jj*3], mesh.GetPosition( mesh.mIndices[ii*3 + jj] ), 3 * sizeof(float) );
+        }
+    }
+    std::sort( triangles.begin(), triangles.end() );
+    return triangles;
+}
+
+// (n+1)^2 vertices: float3 position, float3 normal, float2 texture coordinate.  Optionally
+// with the triangles shuffled, and one vertex no triangle uses.
+//-----------------------------------------------------------------------------
+static CPUTTestMesh MakeGrid( uint32_t n, bool shuffle, bool unusedVertex )
+{
+    CPUTTestMesh mesh;
+    mesh.mStride      = 32;
+    mesh.mVertexCount = (n+1)*(n+1) + (unusedVertex ? 1 : 0);
+    mesh.mVertices.resize( mesh.mVertexCount * mesh.mStride );
+    CPUTTestRandom random( 5 );
+    for( uint32_t ii=0; ii<mesh.mVertexCount; ii++ )
+    {
+        uint32_t x = ii % (n+1), y = ii / (n+1);
+        float *pVertex = (float*)&mesh.mVertices[ii * mesh.mStride];
+        float normal[3] = { random.Float( -1.0f, 1.0f ), 1.0f, random.Float( -1.0f, 1.0f ) };
+        float length = sqrtf( normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2] );
+        pVertex[0] = (float)x;  pVertex[1] = 0.0f;  pVertex[2] = (float)y;
+        pVertex[3] = normal[0] / length;  pVertex[4] = normal[1] / length;  pVertex[5] = normal[2] / length;
+        pVertex[6] = x / (float)n;  pVertex[7] = y / (float)n;
+    }
+    for( uint32_t yy=0; yy<n; yy++ )
+    {
+        for( uint32_t xx=0; xx<n; xx++ )
+        {
+            uint32_t a = yy*(n+1) + xx, b = a + 1, c = a + n + 1, d = c + 1;
+            uint32_t quad[6] = { a, c, b, b, c, d };
+            mesh.mIndices.insert( mesh.mIndices.end(), quad, quad + 6 );
+        }
+    }
+    for( uint32_t ii=(uint32_t)mesh.mIndices.size()/3; shuffle && ii-- > 1; )
+    {
+        uint32_t jj = random.Index( ii + 1 );
+        for( uint32_t kk=0; kk<3; kk++ )
+        {
+            std::swap( mesh.mIndices[ii*3 + kk], mesh.mIndices[jj*3 + kk] );
+        }
+    }
+    CPUTMeshAttribute position = { CPUT_MESH_ATTRIBUTE_POSITION,  CPUT_MESH_FORMAT_FLOAT, 3,  0, 12 };
+    CPUTMeshAttribute normal   = { CPUT_MESH_ATTRIBUTE_DIRECTION, CPUT_MESH_FORMAT_FLOAT, 3, 12, 12 };
+    CPUTMeshAttribute texCoord = { CPUT_MESH_ATTRIBUTE_TEXCOORD,  CPUT_MESH_FORMAT_FLOAT, 2, 24,  8 };
+    mesh.mAttributes.push_back( position );
+    mesh.mAttributes.push_back( normal );
+    mesh.mAttributes.push_back( texCoord );
+    return mesh;
+}
+
+// Two spheres of latitude/longitude quads, the inner one first, positions only.
+// flip reverses the winding, so the triangles face in.
+//-----------------------------------------------------------------------------
+static CPUTTestMesh MakeSpheres( bool flip )
+{
+    const uint32_t n = 32;
+    CPUTTestMesh mesh;
+    mesh.mStride      = 12;
+    mesh.mVertexCount = 0;
+    for( uint32_t shell=0; shell<2; shell++ )
+    {
+        float    radius = shell ? 1.0f : 0.5f;
+        uint32_t base   = mesh.mVertexCount;
+        for( uint32_t ii=0; ii<=n; ii++ )
+        {
+            for( uint32_t jj=0; jj<=n; jj++ )
+            {
+                float theta = 3.14159265f * ii / n, phi = 2.0f * 3.14159265f * jj / n;
+                float position[3] = { radius * sinf( theta ) * cosf( phi ), radius * cosf( theta ), radius * sinf( theta ) * sinf( phi ) };
+                mesh.mVertices.insert( mesh.mVertices.end(), (uint8_t*)position, (uint8_t*)position + sizeof(position) );
+                mesh.mVertexCount++;
+            }
+        }
+        for( uint32_t ii=0; ii<n; ii++ )
+        {
+            for( uint32_t jj=0; jj<n; jj++ )
+            {
+                uint32_t a = base + ii*(n+1) + jj, b = a + 1, c = a + n + 1, d = c + 1;
+                uint32_t quad[6] = { a, b, c, b, d, c };
+                if( flip )
+                {
+                    std::swap( quad[1], quad[2] );
+                    std::swap( quad[4], quad[5] );
+                }
+                mesh.mIndices.insert( mesh.mIndices.end(), quad, quad + 6 );
+            }
+        }
+    }
+    CPUTMeshAttribute position = { CPUT_MESH_ATTRIBUTE_POSITION, CPUT_MESH_FORMAT_FLOAT, 3, 0, 12 };
+    mesh.mAttributes.push_back( position );
+    return mesh;
+}
+
+//-----------------------------------------------------------------------------
+static CPUTMeshOptimizerStats Optimize( CPUTTestMesh *pMesh, const CPUTMeshOptimizerSettings &settings )
+{
+    CPUTMeshOptimizerMesh mesh = { &pMesh->mVertices[0], pMesh->mVertexCount, pMesh->mStride, &pMesh->mIndices[0], (uint32_t)pMesh->mIndices.size(),
+                                   &pMesh->mAttributes[0], (uint32_t)pMesh->mAttributes.size() };
+    CPUTMeshOptimizerStats stats;
+    CPUTOptimizeMesh( &mesh, settings, &stats );
+    pMesh->mVertexCount = mesh.mVertexCount;
+    pMesh->mStride      = mesh.mStride;
+    return stats;
+}
+
+// Optimizing keeps the triangles, and only the vertices they use
+//-----------------------------------------------------------------------------
+static void CheckSameTriangles( const CPUTTestMesh &before, const CPUTTestMesh &after )
+{
+    CPUT_CHECK( GetTriangles( before ) == GetTriangles( after ) );
+    std::vector<bool> used( after.mVertexCount, false );
+    for( size_t ii=0; ii<after.mIndices.size(); ii++ )
+    {
+        CPUT_CHECK( after.mIndices[ii] < after.mVertexCount );
+        if( after.mIndices[ii] < after.mVertexCount )
+        {
+            used[after.mIndices[ii]] = true;
+        }
+    }
+    CPUT_CHECK( std::find( used.begin(), used.end(), false ) == used.end() );
+}
+
+//-----------------------------------------------------------------------------
+static void TestHalfFloats()
+{
+    // Every finite half and infinity round trips (NaNs may not keep their payload)
+    uint32_t mismatches = 0;
+    for( uint32_t ii=0; ii<65536; ii++ )
+    {
+        bool nan = 31 == ((ii >> 10) & 0x1F) && 0 != (ii & 0x3FF);
+        mismatches += !nan && CPUTFloatToHalf( CPUTHalfToFloat( (uint16_t)ii ) ) != ii ? 1 : 0;
+    }
+    CPUT_CHECK( 0 == mismatches );
+    CPUT_CHECK( 0x3C00 == CPUTFloatToHalf( 1.0f ) );
+    CPUT_CHECK( 0x7BFF == CPUTFloatToHalf( 65519.0f ) && 0x7C00 == CPUTFloatToHalf( 65520.0f ) ); // Rounds to infinity past the largest half
+    CPUT_CHECK( 0 == CPUTFloatToHalf( 1e-8f ) );
+    CPUT_CHECK( 0x3C00 == CPUTFloatToHalf( 1.0f + 1.0f/2048 ) );    // Halfway rounds to even
+    CPUT_CHECK( 0x3C02 == CPUTFloatToHalf( 1.0f + 3.0f/2048 ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestQuantization()
+{
+    CPUTMeshOptimizerSettings settings;
+    CPUTTestMesh grid = MakeGrid( 4, false, false );
+    float *pVertex = (float*)&grid.mVertices[grid.mStride];
+    pVertex[3] = 0.6f;  pVertex[4] = -0.8f;  pVertex[5] = 0.0f;  pVertex[6] = 0.3333f;
+    CPUTMeshOptimizerStats stats;
+    uint32_t stride = CPUTQuantizeVertices( &grid.mVertices[0], grid.mVertexCount, grid.mStride, &grid.mAttributes[0], 3, settings, &stats );
+    CPUT_CHECK( 12 + 8 + 4 == stride ); // SNORM16 normal padded to four components, half2 texture coordinate
+    CPUT_CHECK( CPUT_MESH_FORMAT_SNORM16 == grid.mAttributes[1].mFormat && CPUT_MESH_FORMAT_HALF == grid.mAttributes[2].mFormat );
+    const int16_t *pNormal = (const int16_t*)&grid.mVertices[stride + grid.mAttributes[1].mOffset];
+    CPUT_CHECK( 19660 == pNormal[0] && -26214 == pNormal[1] && 0 == pNormal[2] && 0 == pNormal[3] );
+    const uint16_t *pTexCoord = (const uint16_t*)&grid.mVertices[stride + grid.mAttributes[2].mOffset];
+    CPUT_CHECK_NEAR( CPUTHalfToFloat( pTexCoord[0] ), 0.3333f, 1.0f/4096 );
+    CPUT_CHECK( 1.0f == *(const float*)&grid.mVertices[stride] ); // Positions stay float
+    CPUT_CHECK( 2 == stats.mAttributesQuantized && stats.mMaxDirectionError < 1.0f/32767 );
+
+    // A "normal" longer than 1 stays float
+    CPUTTestMesh longNormal = MakeGrid( 2, false, false );
+    ((float*)&longNormal.mVertices[0])[4] = 2.0f;
+    CPUT_CHECK( 12 + 12 + 4 == CPUTQuantizeVertices( &longNormal.mVertices[0], longNormal.mVertexCount, 32, &longNormal.mAttributes[0], 3, settings, NULL ) );
+    CPUT_CHECK( CPUT_MESH_FORMAT_FLOAT == longNormal.mAttributes[1].mFormat );
+}
+
+// The whole pipeline on a grid.  Every vertex still has its own normal and texture
+// coordinate, to within the settings' errors.
+//-----------------------------------------------------------------------------
+static void TestGrid( bool shuffle )
+{
+    CPUTMeshOptimizerSettings settings;
+    CPUTTestMesh before = MakeGrid( 64, shuffle, true );
+    CPUTTestMesh after  = before;
+    CPUTMeshOptimizerStats stats = Optimize( &after, settings );
+    CheckSameTriangles( before, after );
+
+    CPUT_CHECK( 1 == stats.mMeshes && 1 == stats.mVerticesDropped );
+    CPUT_CHECK( 2 == stats.mAttributesQuantized && 24 == after.mStride );
+    CPUT_CHECK( stats.mVertexBytesAfter == (uint64_t)after.mVertexCount * after.mStride );
+    CPUT_CHECK( stats.mCacheAfter.mTriangles == 64 * 64 * 2 );
+    CPUT_CHECK( stats.mCacheAfter.GetACMR() < 0.8f );
+    CPUT_CHECK( stats.mCacheAfter.GetACMR() <= stats.mCacheBefore.GetACMR() );
+    CPUT_CHECK( stats.mFetchAfter.mBytesFetched < stats.mFetchBefore.mBytesFetched );
+    if( shuffle )
+    {
+        CPUT_CHECK( stats.mCacheAfter.GetACMR() < 0.5f * stats.mCacheBefore.GetACMR() );
+    }
+
+    // Vertices are numbered in the order the triangles first use them
+    uint32_t next = 0;
+    for( size_t ii=0; ii<after.mIndices.size(); ii++ )
+    {
+        CPUT_CHECK( after.mIndices[ii] <= next );
+        next = after.mIndices[ii] == next ? next + 1 : next;
+    }
+    CPUT_CHECK( next == after.mVertexCount );
+
+    std::map< std::pair<float,float>, uint32_t > originals; // Grid positions are unique
+    for( uint32_t ii=0; ii+1<before.mVertexCount; ii++ )
+    {
+        originals[std::make_pair( before.GetPosition( ii )[0], before.GetPosition( ii )[2] )] = ii;
+    }
+    float directionError = 0.0f, texCoordError = 0.0f;
+    for( uint32_t ii=0; ii<after.mVertexCount; ii++ )
+    {
+        const float   *pOriginal = (const float*)&before.mVertices[originals[std::make_pair( after.GetPosition( ii )[0], after.GetPosition( ii )[2] )] * before.mStride];
+        const int16_t *pNormal   = (const int16_t*)&after.mVertices[ii * after.mStride + after.mAttributes[1].mOffset];
+        const uint16_t *pTexCoord = (const uint16_t*)&after.mVertices[ii * after.mStride + after.mAttributes[2].mOffset];
+        for( uint32_t jj=0; jj<3; jj++ )
+        {
+            directionError = std::max( directionError, fabsf( pNormal[jj] / 32767.0f - pOriginal[3 + jj] ) );
+        }
+        for( uint32_t jj=0; jj<2; jj++ )
+        {
+            texCoordError = std::max( texCoordError, fabsf( CPUTHalfToFloat( pTexCoord[jj] ) - pOriginal[6 + jj] ) );
+        }
+    }
+    CPUT_CHECK( directionError <= settings.mMaxDirectionError && directionError <= stats.mMaxDirectionError + 1e-6f );
+    CPUT_CHECK( texCoordError  <= settings.mMaxTexCoordError );
+}
+
+// With the inner sphere first, drawing the outer one first shades less.  Facing in,
+// the inner sphere is in front, so the order it was in is already good.
+//-----------------------------------------------------------------------------
+static void TestOverdraw()
+{
+    CPUTMeshOptimizerSettings settings;
+    for( uint32_t flip=0; flip<2; flip++ )
+    {
+        CPUTTestMesh before = MakeSpheres( 0 != flip );
+        CPUTTestMesh after  = before;
+        CPUTMeshOptimizerStats stats = Optimize( &after, settings );
+        CheckSameTriangles( before, after );
+        CPUT_CHECK( stats.mOverdrawAfter.mPixelsCovered == stats.mOverdrawBefore.mPixelsCovered );
+        CPUT_CHECK( stats.mOverdrawAfter.GetOverdraw() <= stats.mOverdrawBefore.GetOverdraw() * 1.02f );
+        CPUT_CHECK( stats.mCacheAfter.GetACMR() <= stats.mCacheBefore.GetACMR() );
+        if( !flip )
+        {
+            CPUT_CHECK( stats.mOverdrawAfter.GetOverdraw() < 0.9f * stats.mOverdrawBefore.GetOverdraw() );
+        }
+    }
+
+    // Only reordering for the cache leaves overdraw where the cache order puts it; reducing
+    // overdraw costs at most the threshold in ACMR
+    CPUTTestMesh cacheOnly = MakeSpheres( false ), both = MakeSpheres( false );
+    settings.mOverdraw = false;
+    CPUTMeshOptimizerStats cacheOnlyStats = Optimize( &cacheOnly, settings );
+    settings.mOverdraw = true;
+    CPUTMeshOptimizerStats bothStats = Optimize( &both, settings );
+    CPUT_CHECK( bothStats.mOverdrawAfter.GetOverdraw() < cacheOnlyStats.mOverdrawAfter.GetOverdraw() );
+    CPUT_CHECK( bothStats.mCacheAfter.GetACMR() <= cacheOnlyStats.mCacheAfter.GetACMR() * settings.mOverdrawThreshold + 0.01f );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestHalfFloats();
+    TestQuantization();
+    TestGrid( false );
+    TestGrid( true );
+    TestOverdraw();
+    return CPUTTestResult();
+}
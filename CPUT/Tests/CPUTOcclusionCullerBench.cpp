@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTOcclusionCuller.h"
+#include "CPUTThreadPool.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// Rasterizing 10k occluder triangles and testing 100k boxes, on the calling thread and
+// on a thread pool.
+
+static const uint32_t kTriangles   = 10000;
+static const uint32_t kBoxes       = 100000;
+static const uint32_t kRepetitions = 10;
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTTestRandom random( 1 );
+    std::vector<float3>   positions;
+    std::vector<uint32_t> indices;
+    for( uint32_t ii=0; ii<kTriangles; ii++ )
+    {
+        float3 center( random.Float( -100.0f, 100.0f ), random.Float( -60.0f, 60.0f ), random.Float( 20.0f, 120.0f ) );
+        for( uint32_t jj=0; jj<3; jj++ )
+        {
+            indices.push_back( (uint32_t)positions.size() );
+            positions.push_back( center + float3( random.Float( -10.0f, 10.0f ), random.Float( -10.0f, 10.0f ), random.Float( -2.0f, 2.0f ) ) );
+        }
+    }
+    std::vector<float3> centers, halves;
+    for( uint32_t ii=0; ii<kBoxes; ii++ )
+    {
+        centers.push_back( float3( random.Float( -200.0f, 200.0f ), random.Float( -120.0f, 120.0f ), random.Float( 30.0f, 330.0f ) ) );
+        halves.push_back( float3( random.Float( 0.0f, 3.0f ), random.Float( 0.0f, 3.0f ), random.Float( 0.0f, 3.0f ) ) );
+    }
+    std::vector<uint8_t> visible( kBoxes );
+    const float4x4 viewProjection = float4x4PerspectiveFovLH( 1.0f, 320.0f / 192.0f, 1000.0f, 0.1f );
+
+    CPUTThreadPool pool;
+    CPUTOcclusionCuller culler;
+    culler.AddOccluder( &positions[0], (uint32_t)positions.size(), &indices[0], (uint32_t)indices.size(), float4x4Identity() );
+    for( uint32_t threaded=0; threaded<2; threaded++ )
+    {
+        culler.SetThreadPool( threaded ? &pool : NULL );
+        double rasterSeconds = 0.0, testSeconds = 0.0;
+        for( uint32_t rr=0; rr<kRepetitions; rr++ )
+        {
+            double start = CPUTFrameScheduler::GetSeconds();
+            culler.BeginFrame( viewProjection, 0.1f );
+            culler.RenderOccluders();
+            double rendered = CPUTFrameScheduler::GetSeconds();
+            culler.TestBoxes( &centers[0], &halves[0], kBoxes, &visible[0] );
+            testSeconds   += CPUTFrameScheduler::GetSeconds() - rendered;
+            rasterSeconds += rendered - start;
+        }
+        const CPUTOcclusionStats &stats = culler.GetStats();
+        printf( "%-12s %u triangles in %6.2f ms, %u boxes in %6.2f ms (%.1f%% culled)\n",
+            threaded ? "Thread pool:" : "One thread:", stats.mOccluderTriangles, rasterSeconds * 1e3 / kRepetitions,
+            stats.mOccludeesTested, testSeconds * 1e3 / kRepetitions, 100.0 * stats.mOccludeesCulled / stats.mOccludeesTested );
+    }
+    printf( "%u threads\n", pool.GetThreadCount() );
+    return 0;
+}
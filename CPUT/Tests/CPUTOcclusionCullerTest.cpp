@@ -0,0 +1,237 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTOcclusionCuller.h"
+#include "CPUTThreadPool.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// The camera is at the origin looking down +z with CPUT's reversed-Z projection.  The
+// occluders are simple enough that whether a box is hidden can be worked out directly:
+// the culler must never cull a box that shows by more than about a pixel, and should cull
+// the boxes that are well inside the hidden region.
+
+static const float    kNear   = 0.1f;
+static const uint32_t kWidth  = 320;
+static const uint32_t kHeight = 192;
+
+//-----------------------------------------------------------------------------
+static float4x4 ViewProjection()
+{
+    return float4x4PerspectiveFovLH( 1.0f, (float)kWidth / kHeight, 1000.0f, kNear );
+}
+
+// A wall facing the camera at z = 10, from -5 to 5 in x and y
+//-----------------------------------------------------------------------------
+static uint32_t AddWall( CPUTOcclusionCuller &culler )
+{
+    const float3   quad[4]    = { float3( -5.0f, -5.0f, 10.0f ), float3( 5.0f, -5.0f, 10.0f ), float3( 5.0f, 5.0f, 10.0f ), float3( -5.0f, 5.0f, 10.0f ) };
+    const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+    return culler.AddOccluder( quad, 4, indices, 6, float4x4Identity() );
+}
+
+// How far inside the wall's shadow the box is: the smallest margin, in x/z or y/z,
+// between a corner and the wall's edge (negative when a corner is outside), or
+// -1 if the box reaches in front of the wall.
+//-----------------------------------------------------------------------------
+static float WallShadowMargin( const float3 &center, const float3 &half )
+{
+    if( center.z - half.z <= 10.0f )
+    {
+        return -1.0f;
+    }
+    float margin = 1e30f;
+    for( uint32_t ii=0; ii<8; ii++ )
+    {
+        float3 corner( center.x + ((ii & 1) ? half.x : -half.x), center.y + ((ii & 2) ? half.y : -half.y), center.z + ((ii & 4) ? half.z : -half.z) );
+        float mx = 0.5f - fabsf( corner.x ) / corner.z;
+        float my = 0.5f - fabsf( corner.y ) / corner.z;
+        margin = mx < margin ? mx : margin;
+        margin = my < margin ? my : margin;
+    }
+    return margin;
+}
+
+//-----------------------------------------------------------------------------
+static void TestWall()
+{
+    CPUTOcclusionCuller culler( kWidth, kHeight );
+    AddWall( culler );
+    culler.BeginFrame( ViewProjection(), kNear );
+    culler.RenderOccluders();
+    CPUT_CHECK( 2 == culler.GetStats().mOccluderTriangles );
+
+    const float3 unit( 1.0f, 1.0f, 1.0f );
+    CPUT_CHECK( !culler.IsVisible( float3(  0.0f, 0.0f,  20.0f ), unit ) );                       // Behind
+    CPUT_CHECK(  culler.IsVisible( float3(  0.0f, 0.0f,   5.0f ), unit ) );                       // In front
+    CPUT_CHECK(  culler.IsVisible( float3( 30.0f, 0.0f,  20.0f ), unit ) );                       // Beside
+    CPUT_CHECK(  culler.IsVisible( float3(  0.0f, 0.0f,  10.0f ), unit ) );                       // Through it
+    CPUT_CHECK(  culler.IsVisible( float3(  0.0f, 0.0f, 100.0f ), float3( 80.0f, 1.0f, 1.0f ) ) ); // Wider than its shadow
+    CPUT_CHECK(  culler.IsVisible( float3(  0.0f, 0.0f,   0.0f ), unit ) );                       // Around the camera
+    CPUT_CHECK(  culler.IsVisible( float3(  0.0f, 0.0f, -20.0f ), unit ) );                       // Behind the camera
+
+    // Random boxes: never cull a box that isn't hidden, and cull the ones that clearly are
+    CPUTTestRandom random( 5 );
+    const uint32_t count = 20000;
+    std::vector<float3> centers, halves;
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        float z = random.Float( 1.0f, 60.0f );
+        centers.push_back( float3( random.Float( -0.7f, 0.7f ) * z, random.Float( -0.7f, 0.7f ) * z, z ) );
+        halves.push_back( float3( random.Float( 0.0f, 3.0f ), random.Float( 0.0f, 3.0f ), random.Float( 0.0f, 3.0f ) ) );
+    }
+    std::vector<uint8_t> visible( count, 2 );
+    culler.TestBoxes( &centers[0], &halves[0], count, &visible[0] );
+
+    const float pixel = 1.0f / kHeight; // About one pixel, in x/z
+    uint32_t wrongCulls = 0, missedCulls = 0, culled = 0, mismatches = 0;
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        float margin = WallShadowMargin( centers[ii], halves[ii] );
+        wrongCulls  += (!visible[ii] && margin < -pixel) ? 1 : 0;
+        missedCulls += ( visible[ii] && margin > 4.0f * pixel) ? 1 : 0;
+        culled      += visible[ii] ? 0 : 1;
+        mismatches  += (visible[ii] != (culler.IsVisible( centers[ii], halves[ii] ) ? 1 : 0)) ? 1 : 0;
+    }
+    CPUT_CHECK( 0 == wrongCulls );
+    CPUT_CHECK( 0 == missedCulls );
+    CPUT_CHECK( 0 == mismatches );
+    CPUT_CHECK( culled > 0 );
+    CPUT_CHECK( count == culler.GetStats().mOccludeesTested );
+    CPUT_CHECK( culled == culler.GetStats().mOccludeesCulled );
+}
+
+//-----------------------------------------------------------------------------
+static void TestOccluderState()
+{
+    CPUTOcclusionCuller culler( kWidth, kHeight );
+    uint32_t wall = AddWall( culler );
+    CPUT_CHECK( 1 == culler.GetOccluderCount() );
+    const float3 center( 0.0f, 0.0f, 20.0f ), unit( 1.0f, 1.0f, 1.0f );
+
+    culler.SetOccluderEnabled( wall, false );
+    culler.BeginFrame( ViewProjection(), kNear );
+    culler.RenderOccluders();
+    CPUT_CHECK( 0 == culler.GetStats().mOccluderTriangles );
+    CPUT_CHECK( culler.IsVisible( center, unit ) );
+
+    // Moved aside, then back
+    culler.SetOccluderEnabled( wall, true );
+    culler.SetOccluderWorld( wall, float4x4Translation( 100.0f, 0.0f, 0.0f ) );
+    culler.BeginFrame( ViewProjection(), kNear );
+    culler.RenderOccluders();
+    CPUT_CHECK( culler.IsVisible( center, unit ) );
+    culler.SetOccluderWorld( wall, float4x4Identity() );
+    culler.BeginFrame( ViewProjection(), kNear );
+    culler.RenderOccluders();
+    CPUT_CHECK( !culler.IsVisible( center, unit ) );
+
+    culler.ClearOccluders();
+    CPUT_CHECK( 0 == culler.GetOccluderCount() );
+    culler.BeginFrame( ViewProjection(), kNear );
+    culler.RenderOccluders();
+    CPUT_CHECK( culler.IsVisible( center, unit ) );
+}
+
+// A floor under the camera that crosses the near plane, so it has to be clipped
+//-----------------------------------------------------------------------------
+static void TestNearPlaneClipping()
+{
+    CPUTOcclusionCuller culler( kWidth, kHeight );
+    const float3   floor[4]   = { float3( -100.0f, -1.0f, -50.0f ), float3( 100.0f, -1.0f, -50.0f ), float3( 100.0f, -1.0f, 100.0f ), float3( -100.0f, -1.0f, 100.0f ) };
+    const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+    culler.AddOccluder( floor, 4, indices, 6, float4x4Identity() );
+    culler.BeginFrame( ViewProjection(), kNear );
+    culler.RenderOccluders();
+    CPUT_CHECK( culler.GetStats().mOccluderTriangles > 0 );
+
+    const float3 unit( 1.0f, 1.0f, 1.0f );
+    CPUT_CHECK( !culler.IsVisible( float3( 0.0f, -5.0f, 30.0f ), unit ) ); // Under the floor
+    CPUT_CHECK(  culler.IsVisible( float3( 0.0f,  2.0f, 30.0f ), unit ) ); // On it
+    CPUT_CHECK(  culler.IsVisible( float3( 0.0f, -1.0f, 30.0f ), unit ) ); // Half through it
+
+    // Nothing that shows more than a pixel above the floor may be culled
+    const float pixel = 2.0f * tanf( 0.5f ) / kHeight; // In y/z
+    CPUTTestRandom random( 9 );
+    uint32_t wrongCulls = 0;
+    for( uint32_t ii=0; ii<5000; ii++ )
+    {
+        float3 center( random.Float( -50.0f, 50.0f ), random.Float( -10.0f, 10.0f ), random.Float( 1.0f, 90.0f ) );
+        float3 half( random.Float( 0.0f, 2.0f ), random.Float( 0.0f, 2.0f ), random.Float( 0.0f, 2.0f ) );
+        float above = (center.y + half.y + 1.0f) / (center.z - half.z);
+        if( (center.z - half.z <= kNear || above > pixel) && !culler.IsVisible( center, half ) )
+        {
+            wrongCulls++;
+        }
+    }
+    CPUT_CHECK( 0 == wrongCulls );
+}
+
+// The thread pool splits the work but must not change the result
+//-----------------------------------------------------------------------------
+static void TestThreaded()
+{
+    CPUTTestRandom random( 21 );
+    std::vector<float3>   positions;
+    std::vector<uint32_t> indices;
+    for( uint32_t ii=0; ii<2000; ii++ )
+    {
+        float3 center( random.Float( -100.0f, 100.0f ), random.Float( -60.0f, 60.0f ), random.Float( 20.0f, 120.0f ) );
+        for( uint32_t jj=0; jj<3; jj++ )
+        {
+            indices.push_back( (uint32_t)positions.size() );
+            positions.push_back( center + float3( random.Float( -10.0f, 10.0f ), random.Float( -10.0f, 10.0f ), random.Float( -2.0f, 2.0f ) ) );
+        }
+    }
+    const uint32_t count = 10000;
+    std::vector<float3> centers, halves;
+    for( uint32_t ii=0; ii<count; ii++ )
+    {
+        centers.push_back( float3( random.Float( -200.0f, 200.0f ), random.Float( -120.0f, 120.0f ), random.Float( 30.0f, 330.0f ) ) );
+        halves.push_back( float3( random.Float( 0.0f, 3.0f ), random.Float( 0.0f, 3.0f ), random.Float( 0.0f, 3.0f ) ) );
+    }
+
+    CPUTThreadPool pool( 4 );
+    std::vector<uint8_t> visible[2];
+    std::vector<float>   depth[2];
+    CPUTOcclusionStats   stats[2];
+    for( uint32_t threaded=0; threaded<2; threaded++ )
+    {
+        CPUTOcclusionCuller culler( kWidth, kHeight );
+        culler.AddOccluder( &positions[0], (uint32_t)positions.size(), &indices[0], (uint32_t)indices.size(), float4x4Identity() );
+        culler.SetThreadPool( threaded ? &pool : NULL );
+        culler.BeginFrame( ViewProjection(), kNear );
+        culler.RenderOccluders();
+        visible[threaded].resize( count );
+        culler.TestBoxes( &centers[0], &halves[0], count, &visible[threaded][0] );
+        depth[threaded].assign( culler.GetDepth(), culler.GetDepth() + kWidth * kHeight );
+        stats[threaded] = culler.GetStats();
+    }
+    CPUT_CHECK( visible[0] == visible[1] );
+    CPUT_CHECK( depth[0] == depth[1] );
+    CPUT_CHECK( stats[0].mOccluderTriangles == stats[1].mOccluderTriangles );
+    CPUT_CHECK( stats[0].mOccludeesCulled == stats[1].mOccludeesCulled );
+    CPUT_CHECK( stats[0].mOccludeesCulled > 0 && stats[0].mOccludeesCulled < count );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestWall();
+    TestOccluderState();
+    TestNearPlaneClipping();
+    TestThreaded();
+    return CPUTTestResult();
+}
@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTProfiler.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <stdio.h>
+
+// Cost of a zone (its begin and its end) and of a counter: outside a capture, in a
+// capture, and once the capture is full and events are dropped, against the same loop
+// without them (as with CPUT_NO_PROFILER).  Then the time and size of each export for a
+// capture of 2M events.  The numbers in CPUTProfiler.h come from this.
+
+static const uint32_t kZones = 1000000;
+
+static volatile uint32_t sSink;
+
+//-----------------------------------------------------------------------------
+static double RunZones( bool counters )
+{
+    double start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ii=0; ii<kZones; ii++ )
+    {
+        CPUT_PROFILE_ZONE("Zone");
+        if( counters )
+        {
+            CPUT_PROFILE_COUNTER("Counter", ii);
+        }
+        sSink = ii;
+    }
+    return CPUTFrameScheduler::GetSeconds() - start;
+}
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, double seconds )
+{
+    printf( "  %-32s %7.1f ns\n", pName, seconds * 1e9 / kZones );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    double start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ii=0; ii<kZones; ii++ )
+    {
+        sSink = ii;
+    }
+    Report( "Compiled out (loop only)", CPUTFrameScheduler::GetSeconds() - start );
+
+    Report( "Zone, not capturing", RunZones( false ) );
+
+    CPUTProfiler::SetMaxEvents( 2 * kZones );
+    CPUTProfiler::BeginCapture();
+    Report( "Zone, capturing (new memory)", RunZones( false ) );
+    CPUTProfiler::BeginCapture();
+    Report( "Zone, capturing", RunZones( false ) );
+    Report( "Zone, capture full", RunZones( false ) );
+    CPUTProfiler::SetMaxEvents( 3 * kZones );
+    CPUTProfiler::BeginCapture();
+    Report( "Zone and counter, capturing", RunZones( true ) );
+    CPUTProfiler::EndCapture();
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( uint32_t ii=0; ii<kZones; ii++ )
+    {
+        sSink = (uint32_t)CPUTProfiler::GetTicks();
+    }
+    Report( "GetTicks()", CPUTFrameScheduler::GetSeconds() - start );
+
+    CPUTProfiler::SetMaxEvents( 2 * kZones );
+    CPUTProfiler::BeginCapture();
+    RunZones( false );
+    CPUTProfiler::EndCapture();
+    const char *pFiles[2] = { "CPUTProfilerBench.json", "CPUTProfilerBench.bin" };
+    for( uint32_t ii=0; ii<2; ii++ )
+    {
+        start = CPUTFrameScheduler::GetSeconds();
+        bool written = ii ? CPUTProfiler::WriteBinary( pFiles[ii] ) : CPUTProfiler::WriteChromeTrace( pFiles[ii] );
+        double milliseconds = (CPUTFrameScheduler::GetSeconds() - start) * 1000.0;
+        FILE *pFile = fopen( pFiles[ii], "rb" );
+        long size = 0;
+        if( pFile )
+        {
+            fseek( pFile, 0, SEEK_END );
+            size = ftell( pFile );
+            fclose( pFile );
+        }
+        printf( "  %-32s %7.1f ms  %6.1f MB  %4.1f bytes/event%s\n", ii ? "WriteBinary()" : "WriteChromeTrace()", milliseconds,
+                size / 1048576.0, (double)size / CPUTProfiler::GetEventCount(), written ? "" : "  (failed)" );
+        remove( pFiles[ii] );
+    }
+    CPUTProfiler::ReleaseMemory();
+    return 0;
+}
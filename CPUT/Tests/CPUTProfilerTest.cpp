@@ -0,0 +1,434 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTProfiler.h"
+#include "CPUTThreadPool.h"
+#include "CPUTTest.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Captures zones, frames and counters, on the calling thread and on a thread pool, and
+// reads them back through both exports: the binary file is decoded in full (string
+// table, varints, zigzag values, tick deltas) and the Chrome trace is checked for its
+// escaping and thread names.  Also checks frame-limited captures, zones that straddle
+// the start or end of a capture, the event cap and reusing memory after Clear().
+
+static const char *kBinaryFile = "CPUTProfilerTest.bin";
+static const char *kTraceFile  = "CPUTProfilerTest.json";
+
+//-----------------------------------------------------------------------------
+struct CPUTTestEvent
+{
+    uint32_t mType;
+    uint32_t mName;
+    uint64_t mTicks;
+    int64_t  mValue;
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTTestThread
+{
+    uint32_t                   mIndex;
+    uint32_t                   mName;
+    std::vector<CPUTTestEvent> mEvents;
+};
+
+// A capture read back from the binary format in CPUTProfiler.h
+//-----------------------------------------------------------------------------
+struct CPUTTestCapture
+{
+    uint64_t                    mTicksPerSecond;
+    uint64_t                    mStart;
+    std::vector<std::string>    mStrings;
+    std::vector<CPUTTestThread> mThreads;
+
+    uint32_t FindString( const char *pString ) const
+    {
+        for( uint32_t ii=0; ii<mStrings.size(); ii++ )
+        {
+            if( mStrings[ii] == pString ) { return ii; }
+        }
+        return 0xFFFFFFFF;
+    }
+    uint32_t CountEvents( uint32_t type, const char *pName ) const
+    {
+        uint32_t name  = FindString( pName );
+        uint32_t count = 0;
+        for( size_t ii=0; ii<mThreads.size(); ii++ )
+        {
+            for( size_t jj=0; jj<mThreads[ii].mEvents.size(); jj++ )
+            {
+                count += (type == mThreads[ii].mEvents[jj].mType && name == mThreads[ii].mEvents[jj].mName) ? 1 : 0;
+            }
+        }
+        return count;
+    }
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTTestReader
+{
+    std::vector<uint8_t> mData;
+    size_t               mOffset;
+    bool                 mOverrun;
+
+    template<class T> T Read()
+    {
+        T value = 0;
+        if( mOffset + sizeof(T) > mData.size() )
+        {
+            mOverrun = true;
+            return value;
+        }
+        memcpy( &value, &mData[mOffset], sizeof(T) );
+        mOffset += sizeof(T);
+        return value;
+    }
+    uint64_t ReadVarint()
+    {
+        uint64_t value = 0;
+        for( uint32_t shift=0; shift<64; shift+=7 )
+        {
+            uint8_t byte = Read<uint8_t>();
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if( !(byte & 0x80) ) { break; }
+        }
+        return value;
+    }
+};
+
+//-----------------------------------------------------------------------------
+static std::vector<uint8_t> ReadFile( const char *pFileName )
+{
+    std::vector<uint8_t> data;
+    FILE *pFile = fopen( pFileName, "rb" );
+    if( pFile )
+    {
+        uint8_t buffer[4096];
+        size_t  count;
+        while( 0 != (count = fread( buffer, 1, sizeof(buffer), pFile )) )
+        {
+            data.insert( data.end(), buffer, buffer + count );
+        }
+        fclose( pFile );
+    }
+    return data;
+}
+
+// Writes the capture with WriteBinary() and decodes it
+//-----------------------------------------------------------------------------
+static bool ReadCapture( CPUTTestCapture *pCapture )
+{
+    CPUT_CHECK( CPUTProfiler::WriteBinary( kBinaryFile ) );
+    CPUTTestReader reader;
+    reader.mData    = ReadFile( kBinaryFile );
+    reader.mOffset  = 0;
+    reader.mOverrun = false;
+    remove( kBinaryFile );
+    if( reader.mData.size() < 8 || 0 != memcmp( &reader.mData[0], "CPUTPRF1", 8 ) )
+    {
+        return false;
+    }
+    reader.mOffset = 8;
+    pCapture->mTicksPerSecond = reader.Read<uint64_t>();
+    pCapture->mStart          = reader.Read<uint64_t>();
+    uint32_t stringCount = reader.Read<uint32_t>();
+    for( uint32_t ii=0; ii<stringCount && !reader.mOverrun; ii++ )
+    {
+        uint16_t length = reader.Read<uint16_t>();
+        if( reader.mOffset + length > reader.mData.size() )
+        {
+            return false;
+        }
+        pCapture->mStrings.push_back( std::string( (const char*)&reader.mData[reader.mOffset], length ) );
+        reader.mOffset += length;
+    }
+    // Every thread that has recorded an event is written, with what it has in this capture
+    uint32_t threadCount = reader.Read<uint32_t>();
+    while( reader.mOffset < reader.mData.size() && !reader.mOverrun )
+    {
+        CPUTTestThread thread;
+        thread.mIndex = reader.Read<uint32_t>();
+        thread.mName  = reader.Read<uint32_t>();
+        uint64_t eventCount = reader.Read<uint64_t>();
+        uint64_t ticks      = pCapture->mStart;
+        for( uint64_t ii=0; ii<eventCount && !reader.mOverrun; ii++ )
+        {
+            CPUTTestEvent event;
+            event.mType  = reader.Read<uint8_t>();
+            event.mName  = (uint32_t)reader.ReadVarint();
+            ticks       += reader.ReadVarint();
+            event.mTicks = ticks;
+            event.mValue = 0;
+            if( CPUT_PROFILE_FRAME == event.mType || CPUT_PROFILE_COUNTER == event.mType )
+            {
+                uint64_t zigzag = reader.ReadVarint();
+                event.mValue = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            }
+            thread.mEvents.push_back( event );
+        }
+        pCapture->mThreads.push_back( thread );
+    }
+    return !reader.mOverrun && pCapture->mThreads.size() == threadCount;
+}
+
+//-----------------------------------------------------------------------------
+static void TestNotCapturing()
+{
+    CPUTProfiler::BeginCapture();
+    CPUTProfiler::EndCapture();
+    {
+        CPUT_PROFILE_ZONE("Idle");
+        CPUT_PROFILE_COUNTER("Idle counter", 1);
+        CPUT_PROFILE_FRAME();
+    }
+    CPUT_CHECK( !CPUTProfiler::IsCapturing() );
+    CPUT_CHECK( 0 == CPUTProfiler::GetEventCount() );
+}
+
+// Nested zones, counters and frames on one thread, and the string table
+//-----------------------------------------------------------------------------
+static void TestEvents()
+{
+    // Equal names at different addresses share a string
+    char sameName[] = "Same";
+    CPUTProfiler::SetThreadName( "Main" );
+    CPUTProfiler::BeginCapture();
+    {
+        CPUT_PROFILE_ZONE("Outer");
+        {
+            CPUT_PROFILE_ZONE("Same");
+            CPUT_PROFILE_COUNTER("Counter", -5);
+        }
+        {
+            CPUTProfileZone zone( sameName );
+            CPUT_PROFILE_COUNTER("Counter", (int64_t)1 << 40);
+        }
+        CPUT_PROFILE_FRAME();
+    }
+    CPUTProfiler::EndCapture();
+    CPUT_CHECK( 9 == CPUTProfiler::GetEventCount() );
+
+    CPUTTestCapture capture;
+    CPUT_CHECK( ReadCapture( &capture ) );
+    CPUT_CHECK( CPUTProfiler::GetTicksPerSecond() == capture.mTicksPerSecond );
+    uint32_t sameCount = 0;
+    for( size_t ii=0; ii<capture.mStrings.size(); ii++ )
+    {
+        sameCount += "Same" == capture.mStrings[ii] ? 1 : 0;
+    }
+    CPUT_CHECK( 1 == sameCount );
+
+    // Only this thread has recorded so far
+    if( 1 != capture.mThreads.size() || 9 != capture.mThreads[0].mEvents.size() )
+    {
+        CPUT_CHECK( false );
+        return;
+    }
+    const CPUTTestThread &thread = capture.mThreads[0];
+    CPUT_CHECK( capture.FindString( "Main" ) == thread.mName );
+    const uint32_t types[9] = { CPUT_PROFILE_BEGIN, CPUT_PROFILE_BEGIN, CPUT_PROFILE_COUNTER, CPUT_PROFILE_END,
+                                CPUT_PROFILE_BEGIN, CPUT_PROFILE_COUNTER, CPUT_PROFILE_END, CPUT_PROFILE_FRAME, CPUT_PROFILE_END };
+    const char *pNames[9]   = { "Outer", "Same", "Counter", "Same", "Same", "Counter", "Same", "Frame", "Outer" };
+    for( uint32_t ii=0; ii<9; ii++ )
+    {
+        const CPUTTestEvent &event = thread.mEvents[ii];
+        CPUT_CHECK( types[ii] == event.mType );
+        CPUT_CHECK( capture.FindString( pNames[ii] ) == event.mName );
+        CPUT_CHECK( event.mTicks >= (ii ? thread.mEvents[ii-1].mTicks : capture.mStart) );
+    }
+    CPUT_CHECK( -5 == thread.mEvents[2].mValue );
+    CPUT_CHECK( ((int64_t)1 << 40) == thread.mEvents[5].mValue );
+    CPUT_CHECK( 0 == thread.mEvents[7].mValue );
+}
+
+// A capture of three frames ends at the third; zones keep the state they started with
+//-----------------------------------------------------------------------------
+static void TestCaptureBoundaries()
+{
+    CPUTProfileZone *pBefore = new CPUTProfileZone( "Before" );
+    CPUTProfiler::BeginCapture( 3 );
+    delete pBefore;
+    for( uint32_t ii=0; ii<5; ii++ )
+    {
+        CPUT_PROFILE_ZONE("Frame zone");
+        CPUT_CHECK( (ii < 3) == CPUTProfiler::IsCapturing() );
+        CPUT_PROFILE_FRAME();
+    }
+    CPUTProfiler::BeginCapture();
+    CPUTProfileZone *pAfter = new CPUTProfileZone( "After" );
+    CPUTProfiler::EndCapture();
+    delete pAfter;
+
+    CPUTTestCapture capture;
+    CPUT_CHECK( ReadCapture( &capture ) );
+    CPUT_CHECK( 0 == capture.CountEvents( CPUT_PROFILE_END, "Before" ) );
+    CPUT_CHECK( 0 == capture.CountEvents( CPUT_PROFILE_BEGIN, "Frame zone" ) );
+    CPUT_CHECK( 1 == capture.CountEvents( CPUT_PROFILE_BEGIN, "After" ) );
+    CPUT_CHECK( 1 == capture.CountEvents( CPUT_PROFILE_END, "After" ) );
+
+    // The frame-limited capture, before it was replaced
+    CPUTProfiler::BeginCapture( 3 );
+    for( uint32_t ii=0; ii<5; ii++ )
+    {
+        CPUT_PROFILE_ZONE("Frame zone");
+        CPUT_PROFILE_FRAME();
+    }
+    CPUTTestCapture frames;
+    CPUT_CHECK( ReadCapture( &frames ) );
+    CPUT_CHECK( 3 == frames.CountEvents( CPUT_PROFILE_BEGIN, "Frame zone" ) );
+    CPUT_CHECK( 3 == frames.CountEvents( CPUT_PROFILE_END, "Frame zone" ) );
+    CPUT_CHECK( 3 == frames.CountEvents( CPUT_PROFILE_FRAME, "Frame" ) );
+    int64_t frameNumber = 0;
+    for( size_t ii=0; ii<frames.mThreads.size(); ii++ )
+    {
+        for( size_t jj=0; jj<frames.mThreads[ii].mEvents.size(); jj++ )
+        {
+            if( CPUT_PROFILE_FRAME == frames.mThreads[ii].mEvents[jj].mType )
+            {
+                CPUT_CHECK( frameNumber++ == frames.mThreads[ii].mEvents[jj].mValue );
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+class CPUTTestZoneTask : public CPUTTask
+{
+public:
+    void Execute( uint32_t taskIndex, uint32_t /*threadIndex*/ )
+    {
+        CPUT_PROFILE_ZONE("Task");
+        CPUT_PROFILE_COUNTER("Task index", taskIndex);
+    }
+};
+
+// Every thread's zones balance, and the pool's workers are named
+//-----------------------------------------------------------------------------
+static void TestThreads()
+{
+    CPUTThreadPool   pool( 3 );
+    CPUTTestZoneTask task;
+    CPUTProfiler::BeginCapture();
+    for( uint32_t ii=0; ii<20; ii++ )
+    {
+        pool.ParallelFor( &task, 64 );
+    }
+    CPUTProfiler::EndCapture();
+
+    CPUTTestCapture capture;
+    CPUT_CHECK( ReadCapture( &capture ) );
+    CPUT_CHECK( 20 * 64 == capture.CountEvents( CPUT_PROFILE_BEGIN, "Task" ) );
+    CPUT_CHECK( 20 * 64 == capture.CountEvents( CPUT_PROFILE_END, "Task" ) );
+    CPUT_CHECK( 20 * 64 == capture.CountEvents( CPUT_PROFILE_COUNTER, "Task index" ) );
+    uint32_t taskName   = capture.FindString( "Task" );
+    uint32_t workerName = capture.FindString( "Thread pool worker" );
+    uint32_t workersWithEvents = 0;
+    for( size_t ii=0; ii<capture.mThreads.size(); ii++ )
+    {
+        const CPUTTestThread &thread = capture.mThreads[ii];
+        int32_t depth = 0;
+        for( size_t jj=0; jj<thread.mEvents.size(); jj++ )
+        {
+            const CPUTTestEvent &event = thread.mEvents[jj];
+            depth += (CPUT_PROFILE_BEGIN == event.mType && taskName == event.mName) ? 1 : 0;
+            depth -= (CPUT_PROFILE_END == event.mType && taskName == event.mName) ? 1 : 0;
+            CPUT_CHECK( 0 == depth || 1 == depth );
+        }
+        CPUT_CHECK( 0 == depth );
+        workersWithEvents += (workerName == thread.mName && !thread.mEvents.empty()) ? 1 : 0;
+    }
+    CPUT_CHECK( workersWithEvents >= 1 && workersWithEvents <= 3 );
+}
+
+// Events beyond the cap are dropped and counted; Clear() keeps the chunks for reuse
+//-----------------------------------------------------------------------------
+static void TestMemory()
+{
+    CPUTProfiler::ReleaseMemory();
+    CPUTProfiler::SetMaxEvents( 2 * CPUTProfileChunk::EVENT_COUNT );
+    CPUTProfiler::BeginCapture();
+    for( uint32_t ii=0; ii<5000; ii++ )
+    {
+        CPUT_PROFILE_COUNTER("Capped", ii);
+    }
+    CPUTProfiler::EndCapture();
+    CPUT_CHECK( 2 * CPUTProfileChunk::EVENT_COUNT == CPUTProfiler::GetEventCount() );
+    CPUT_CHECK( 5000 - 2 * CPUTProfileChunk::EVENT_COUNT == CPUTProfiler::GetDroppedEventCount() );
+
+    // A new capture starts empty, in the memory of the last one
+    CPUTProfiler::BeginCapture();
+    for( uint32_t ii=0; ii<3000; ii++ )
+    {
+        CPUT_PROFILE_COUNTER("Reused", ii);
+    }
+    CPUTProfiler::EndCapture();
+    CPUT_CHECK( 3000 == CPUTProfiler::GetEventCount() );
+    CPUT_CHECK( 0 == CPUTProfiler::GetDroppedEventCount() );
+    CPUTTestCapture capture;
+    CPUT_CHECK( ReadCapture( &capture ) );
+    CPUT_CHECK( 0 == capture.CountEvents( CPUT_PROFILE_COUNTER, "Capped" ) );
+    CPUT_CHECK( 3000 == capture.CountEvents( CPUT_PROFILE_COUNTER, "Reused" ) );
+
+    CPUTProfiler::ReleaseMemory();
+    CPUT_CHECK( 0 == CPUTProfiler::GetEventCount() );
+    CPUTProfiler::SetMaxEvents( 1024 * CPUTProfileChunk::EVENT_COUNT );
+}
+
+//-----------------------------------------------------------------------------
+static void TestChromeTrace()
+{
+    CPUTProfiler::SetThreadName( "Main \"thread\"" );
+    CPUTProfiler::BeginCapture();
+    {
+        CPUT_PROFILE_ZONE("Quote \" slash \\ tab \t");
+        CPUT_PROFILE_COUNTER("Counter", -7);
+        CPUT_PROFILE_FRAME();
+    }
+    CPUTProfiler::EndCapture();
+    CPUT_CHECK( CPUTProfiler::WriteChromeTrace( kTraceFile ) );
+    std::vector<uint8_t> data = ReadFile( kTraceFile );
+    remove( kTraceFile );
+    std::string trace( data.begin(), data.end() );
+    CPUT_CHECK( 0 == trace.find( "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" ) );
+    CPUT_CHECK( std::string::npos != trace.find( "\"name\":\"thread_name\",\"args\":{\"name\":\"Main \\\"thread\\\"\"}}" ) );
+    CPUT_CHECK( std::string::npos != trace.find( "\"name\":\"Quote \\\" slash \\\\ tab \\u0009\"}" ) );
+    CPUT_CHECK( std::string::npos != trace.find( "\"name\":\"Counter\",\"args\":{\"value\":-7}}" ) );
+    CPUT_CHECK( std::string::npos != trace.find( "\"name\":\"Frame\",\"s\":\"g\",\"args\":{\"frame\":0}}" ) );
+    CPUT_CHECK( trace.size() >= 4 && "\n]}\n" == trace.substr( trace.size() - 4 ) );
+    size_t phases = 0;
+    for( size_t found = trace.find( "{\"ph\":" ); std::string::npos != found; found = trace.find( "{\"ph\":", found + 1 ) )
+    {
+        phases++;
+    }
+    // Four events, and a name for each named thread (this one and any pool workers)
+    CPUT_CHECK( phases >= 5 );
+    CPUTProfiler::SetThreadName( "Main" );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestNotCapturing();
+    TestEvents();
+    TestCaptureBoundaries();
+    TestThreads();
+    TestMemory();
+    TestChromeTrace();
+    CPUTProfiler::ReleaseMemory();
+    return CPUTTestResult();
+}
@@ -0,0 +1,298 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTest.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTUploadRing.h"
+#include <vector>
+
+// Drives the null backend the way the frame loop does (shadow and scene passes with
+// per-draw constants from the upload ring, some of them recorded on deferred backends,
+// then Present()), and checks what it counts, records and replays.
+
+//-----------------------------------------------------------------------------
+struct TestScene
+{
+    CPUTBackendHandle mShaders[2];      // Vertex and pixel shader for every draw
+    CPUTBackendHandle mTextures[4];
+    CPUTBackendHandle mSampler;
+    CPUTBackendHandle mVertexBuffer;
+    CPUTBackendHandle mIndexBuffer;
+    CPUTBackendHandle mRenderTarget;
+    CPUTBackendHandle mDepthStencil;
+    CPUTBackendHandle mShadowMap;
+    CPUTBackendHandle mPerFrame;        // Constant buffer for the per-frame values
+};
+
+// Handles for objects the backend doesn't create (shaders, views, states) are synthetic
+//-----------------------------------------------------------------------------
+static CPUTBackendHandle TestHandle( uintptr_t value )
+{
+    return (CPUTBackendHandle)(0x10000 + value);
+}
+
+//-----------------------------------------------------------------------------
+static void CreateScene( CPUTRenderBackend *pBackend, TestScene *pScene )
+{
+    pScene->mShaders[0] = TestHandle(1);
+    pScene->mShaders[1] = TestHandle(2);
+    for( uintptr_t ii=0; ii<4; ii++ )
+    {
+        pScene->mTextures[ii] = TestHandle(10 + ii);
+    }
+    pScene->mSampler      = TestHandle(20);
+    pScene->mRenderTarget = TestHandle(21);
+    pScene->mDepthStencil = TestHandle(22);
+    pScene->mShadowMap    = TestHandle(23);
+
+    std::vector<uint8_t> vertices( 64 * 32, 1 );
+    std::vector<uint16_t> indices( 96, 0 );
+    pScene->mVertexBuffer = pBackend->CreateBuffer( (uint32_t)vertices.size(), CPUT_BIND_VERTEX_BUFFER, false, &vertices[0] );
+    pScene->mIndexBuffer  = pBackend->CreateBuffer( (uint32_t)(indices.size() * sizeof(uint16_t)), CPUT_BIND_INDEX_BUFFER, false, &indices[0] );
+    pScene->mPerFrame     = pBackend->CreateBuffer( 256, CPUT_BIND_CONSTANT_BUFFER, true, NULL );
+}
+
+// drawCount draws of one mesh, alternating between two textures, each with its own constants
+//-----------------------------------------------------------------------------
+static void DrawModels( CPUTRenderBackend *pBackend, CPUTUploadRing *pRing, const TestScene &scene, uint32_t firstDraw, uint32_t drawCount )
+{
+    pBackend->SetShader( CPUT_SHADER_STAGE_VERTEX, scene.mShaders[0] );
+    pBackend->SetShader( CPUT_SHADER_STAGE_PIXEL,  scene.mShaders[1] );
+    pBackend->SetSamplers( CPUT_SHADER_STAGE_PIXEL, 0, 1, &scene.mSampler );
+    pBackend->SetVertexBuffer( 0, scene.mVertexBuffer, 32, 0 );
+    pBackend->SetIndexBuffer( scene.mIndexBuffer, 57, 0 );
+    for( uint32_t ii=firstDraw; ii<firstDraw + drawCount; ii++ )
+    {
+        pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 1, &scene.mTextures[(ii / 4) & 1] );
+        uint32_t offset;
+        float *pConstants = (float*)pRing->Allocate( 64, &offset );
+        CPUT_CHECK( NULL != pConstants );
+        if( pConstants )
+        {
+            for( uint32_t jj=0; jj<16; jj++ )
+            {
+                pConstants[jj] = (float)(ii * 16 + jj);
+            }
+            pBackend->SetConstantBufferRange( CPUT_SHADER_STAGE_VERTEX, 1, pRing->GetBuffer(), offset, 64 );
+        }
+        pBackend->DrawIndexed( 96, 0, 0 );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void RenderFrame( CPUTRenderBackendNull *pBackend, CPUTUploadRing *pRing, const TestScene &scene, uint32_t drawCount, bool deferred )
+{
+    pRing->BeginFrame();
+
+    float *pPerFrame = (float*)pBackend->Map( scene.mPerFrame );
+    pPerFrame[0] = 1.0f;
+    pBackend->Unmap( scene.mPerFrame, 16 );
+    pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_VERTEX, 0, 1, &scene.mPerFrame );
+    pBackend->SetConstantBuffers( CPUT_SHADER_STAGE_PIXEL,  0, 1, &scene.mPerFrame );
+
+    // Shadow pass
+    pBackend->SetRenderTargets( 0, NULL, scene.mShadowMap );
+    pBackend->ClearDepthStencil( scene.mShadowMap, CPUT_CLEAR_DEPTH, 1.0f, 0 );
+    DrawModels( pBackend, pRing, scene, 0, drawCount );
+
+    // Scene pass, half of it recorded on a deferred backend
+    pBackend->SetRenderTargets( 1, &scene.mRenderTarget, scene.mDepthStencil );
+    const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    pBackend->ClearRenderTarget( scene.mRenderTarget, clearColor );
+    pBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 1, 1, &scene.mShadowMap );
+    if( deferred )
+    {
+        CPUTRenderBackend *pDeferred = pBackend->CreateDeferred();
+        pDeferred->InheritState( *pBackend );
+        pRing->Flush();
+        DrawModels( pDeferred, pRing, scene, drawCount, drawCount / 2 );
+        pRing->Flush();
+        pBackend->ExecuteDeferred( pDeferred );
+        delete pDeferred;
+        DrawModels( pBackend, pRing, scene, drawCount + drawCount / 2, drawCount - drawCount / 2 );
+    }
+    else
+    {
+        DrawModels( pBackend, pRing, scene, drawCount, drawCount );
+    }
+    pRing->EndFrame();
+    pBackend->Present( 1 );
+}
+
+//-----------------------------------------------------------------------------
+static void TestFrameLoop()
+{
+    const uint32_t drawCount = 100;
+    for( uint32_t deferred=0; deferred<2; deferred++ )
+    {
+        CPUTRenderBackendNull backend;
+        TestScene scene;
+        CreateScene( &backend, &scene );
+        CPUTUploadRing ring;
+        CPUT_CHECK( ring.Create( &backend, 64 * 1024, 3 ) );
+
+        for( uint32_t frame=0; frame<10; frame++ )
+        {
+            backend.ResetStats();
+            RenderFrame( &backend, &ring, scene, drawCount, 0 != deferred );
+
+            const CPUTBackendStats &stats = backend.GetStats();
+            CPUT_CHECK( 2 * drawCount == stats.mDrawCalls );
+            CPUT_CHECK( 2 * drawCount * 96 == stats.mIndicesSubmitted );
+            CPUT_CHECK( 1 == stats.mPresents );
+            CPUT_CHECK( 2 == stats.mClears );
+
+            // A deferred backend binds the render targets it inherits, once more
+            CPUT_CHECK( (deferred ? 3u : 2u) == stats.mRenderTargetChanges );
+
+            // Shaders and buffers never change, so after the first frame the filter drops them.
+            // A deferred backend starts from the immediate one's state, so it drops them too.
+            CPUT_CHECK( (frame ? 0u : 2u) == stats.mShaderChanges );
+            CPUT_CHECK( (frame ? 0u : 2u) == stats.mBufferBindings );
+            CPUT_CHECK( stats.mRedundantCallsSkipped > drawCount );
+        }
+        CPUT_CHECK( 0 == ring.GetStats().mFailedAllocations );
+        CPUT_CHECK( 2 * drawCount * 10 == ring.GetStats().mAllocations );
+    }
+}
+
+// A recording replayed into another backend leaves its buffers with the same contents
+//-----------------------------------------------------------------------------
+static void TestRecordAndReplay()
+{
+    CPUTRenderBackendNull recorder;
+    TestScene scene;
+    CreateScene( &recorder, &scene );
+    CPUTUploadRing ring;
+    CPUT_CHECK( ring.Create( &recorder, 64 * 1024, 2 ) );
+
+    // The target creates the same buffers, in the same order, so it hands out the same handles
+    CPUTRenderBackendNull target;
+    TestScene targetScene;
+    CreateScene( &target, &targetScene );
+    CPUTBackendHandle targetRing = target.CreateBuffer( 2 * 64 * 1024, CPUT_BIND_CONSTANT_BUFFER, true, NULL );
+    CPUT_CHECK( targetRing == ring.GetBuffer() );
+
+    recorder.SetRecording( true );
+    recorder.ResetStats();
+    RenderFrame( &recorder, &ring, scene, 50, true );
+    CPUT_CHECK( recorder.GetRecordedCommandCount() > 0 );
+
+    target.ResetStats();
+    recorder.Replay( &target );
+    CPUT_CHECK( recorder.GetStats().mDrawCalls == target.GetStats().mDrawCalls );
+    CPUT_CHECK( recorder.GetStats().mPresents  == target.GetStats().mPresents );
+    CPUT_CHECK( recorder.GetStats().mBytesUploaded == target.GetStats().mBytesUploaded );
+
+    const uint8_t *pRecorded = (const uint8_t*)recorder.Map( ring.GetBuffer() );
+    const uint8_t *pReplayed = (const uint8_t*)target.Map( targetRing );
+    CPUT_CHECK( 0 == memcmp( pRecorded, pReplayed, 2 * 64 * 1024 ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestBuffers()
+{
+    CPUTRenderBackendNull backend;
+    uint32_t data[64];
+    for( uint32_t ii=0; ii<64; ii++ )
+    {
+        data[ii] = ii;
+    }
+    CPUTBackendHandle buffer = backend.CreateBuffer( sizeof(data), CPUT_BIND_VERTEX_BUFFER, false, data );
+    CPUT_CHECK( 1 == backend.GetLiveBufferCount() );
+    CPUT_CHECK( 1 == backend.GetStats().mResourcesCreated );
+    CPUT_CHECK( sizeof(data) == backend.GetStats().mBytesAllocated );
+
+    uint32_t update[4] = { 100, 101, 102, 103 };
+    backend.UpdateBufferRange( buffer, 8 * sizeof(uint32_t), update, sizeof(update) );
+    const uint32_t *pShadow = (const uint32_t*)backend.Map( buffer );
+    CPUT_CHECK( 7 == pShadow[7] && 100 == pShadow[8] && 103 == pShadow[11] && 12 == pShadow[12] );
+    CPUT_CHECK( 1 == backend.GetStats().mBufferUpdates );
+    CPUT_CHECK( sizeof(update) == backend.GetStats().mBytesUploaded );
+
+    backend.ReleaseBuffer( buffer );
+    CPUT_CHECK( 0 == backend.GetLiveBufferCount() );
+}
+
+// Each kind of buffer update replays as the same call, whether or not the backend created the buffer
+//-----------------------------------------------------------------------------
+static void TestReplayUpdates()
+{
+    CPUTRenderBackendNull recorder;
+    recorder.SetRecording( true );
+    uint8_t data[256];
+    memset( data, 7, sizeof(data) );
+    CPUTBackendHandle buffer  = recorder.CreateBuffer( sizeof(data), CPUT_BIND_CONSTANT_BUFFER, false, NULL );
+    CPUTBackendHandle unknown = TestHandle(1);
+
+    recorder.UpdateBuffer( buffer, data, sizeof(data) );
+    recorder.UpdateBufferRange( buffer, 64, data, 32 );
+    recorder.UpdateBufferRange( unknown, 0, data, 16 );
+    memcpy( (uint8_t*)recorder.MapNoOverwrite( buffer ) + 128, data, 16 );
+    recorder.UnmapRange( buffer, 128, 16 );
+    CPUT_CHECK( 4 == recorder.GetRecordedCommandCount() );
+    CPUT_CHECK( 3 == recorder.GetStats().mBufferUpdates );
+    CPUT_CHECK( 1 == recorder.GetStats().mMaps );
+
+    CPUTRenderBackendNull target;
+    target.SetRecording( true );
+    target.CreateBuffer( sizeof(data), CPUT_BIND_CONSTANT_BUFFER, false, NULL );
+    recorder.Replay( &target );
+    CPUT_CHECK( 4 == target.GetRecordedCommandCount() );
+    CPUT_CHECK( 3 == target.GetStats().mBufferUpdates );
+    CPUT_CHECK( 1 == target.GetStats().mMaps );
+    CPUT_CHECK( recorder.GetStats().mBytesUploaded == target.GetStats().mBytesUploaded );
+    for( uint32_t ii=0; ii<4 && ii<target.GetRecordedCommandCount(); ii++ )
+    {
+        const CPUTBackendCommand &recorded = recorder.GetRecordedCommand( ii );
+        const CPUTBackendCommand &replayed = target.GetRecordedCommand( ii );
+        CPUT_CHECK( recorded.mHandle == replayed.mHandle );
+        CPUT_CHECK( recorded.mArg[0] == replayed.mArg[0] && recorded.mArg[1] == replayed.mArg[1] );
+        CPUT_CHECK( recorded.mPayloadSize == replayed.mPayloadSize );
+    }
+}
+
+// The "GPU" stays SetFenceLatency() fences behind
+//-----------------------------------------------------------------------------
+static void TestFences()
+{
+    CPUTRenderBackendNull backend;
+    backend.SetFenceLatency( 2 );
+    CPUTBackendHandle fences[3];
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        fences[ii] = backend.CreateFence();
+        backend.SignalFence( fences[ii] );
+    }
+    CPUT_CHECK( backend.IsFenceComplete( fences[0] ) );
+    CPUT_CHECK( !backend.IsFenceComplete( fences[2] ) );
+    CPUT_CHECK( !backend.IsFenceComplete( fences[2] ) );
+    CPUT_CHECK( backend.IsFenceComplete( fences[2] ) );
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        backend.ReleaseFence( fences[ii] );
+    }
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestFrameLoop();
+    TestRecordAndReplay();
+    TestBuffers();
+    TestReplayUpdates();
+    TestFences();
+    return CPUTTestResult();
+}
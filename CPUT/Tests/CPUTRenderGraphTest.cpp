@@ -0,0 +1,327 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderGraph.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTTest.h"
+#include <algorithm>
+
+// CPUTRenderGraph's culling, ordering and aliasing, compiled with the null allocator and
+// executed against the null backend.  Includes the graphs WindowsSensors and
+// CPUTPostProcess declare, and random graphs checked against lifetimes computed here.
+
+// Sets its target and draws, logging that it ran
+//-----------------------------------------------------------------------------
+class CPUTTestPass : public CPUTRenderPass
+{
+public:
+    CPUTRenderGraphResource mTarget;
+    uint32_t                mId;
+    std::vector<uint32_t>  *mpLog;
+
+    CPUTTestPass() : mTarget(CPUT_RENDER_GRAPH_NONE), mId(0), mpLog(NULL) {}
+    void Execute( CPUTRenderGraph &graph, void *pContext )
+    {
+        CPUTRenderBackend *pBackend = (CPUTRenderBackend*)pContext;
+        CPUTBackendHandle target = CPUT_RENDER_GRAPH_NONE == mTarget ? NULL : graph.GetTexture( mTarget );
+        pBackend->SetRenderTargets( 1, &target, NULL );
+        pBackend->Draw( 3, 0 );
+        mpLog->push_back( mId );
+    }
+};
+
+static const uint32_t kPassCount = 16;
+
+//-----------------------------------------------------------------------------
+static CPUTRenderGraphTextureDesc TextureDesc( uint32_t width, uint32_t height, uint32_t format, uint32_t flags = 0 )
+{
+    CPUTRenderGraphTextureDesc desc = { width, height, format, 4, 1, flags };
+    return desc;
+}
+
+//-----------------------------------------------------------------------------
+static void ResetPasses( CPUTTestPass *pPasses, std::vector<uint32_t> *pLog )
+{
+    for( uint32_t ii=0; ii<kPassCount; ii++ )
+    {
+        pPasses[ii].mTarget = CPUT_RENDER_GRAPH_NONE;
+        pPasses[ii].mId     = ii;
+        pPasses[ii].mpLog   = pLog;
+    }
+}
+
+// WindowsSensors: shadow map then scene, and a debug pass whose output nothing reads
+//-----------------------------------------------------------------------------
+static void TestCulling()
+{
+    std::vector<uint32_t> log;
+    CPUTTestPass passes[kPassCount];
+    ResetPasses( passes, &log );
+    CPUTRenderBackendNull backend;
+    backend.SetRecording( true );
+    CPUTRenderGraphAllocatorNull allocator;
+    {
+        CPUTRenderGraph graph;
+        CPUTRenderGraphResource shadow     = graph.CreateTexture( CPUTStringTable::Intern( "$shadow_depth" ), TextureDesc( 4096, 4096, 40, CPUT_RENDER_GRAPH_DEPTH ) );
+        CPUTRenderGraphResource debug      = graph.CreateTexture( CPUTStringTable::Intern( "$debug" ), TextureDesc( 1920, 1080, 28 ) );
+        CPUTRenderGraphResource backBuffer = graph.ImportTexture( CPUTStringTable::Intern( "$BackBuffer" ), (CPUTBackendHandle)0x1234 );
+        uint32_t pass = graph.AddPass( "Shadow", &passes[0] );
+        graph.Write( pass, shadow );
+        passes[0].mTarget = shadow;
+        pass = graph.AddPass( "Debug", &passes[1] );
+        graph.Read( pass, shadow );
+        graph.Write( pass, debug );
+        passes[1].mTarget = debug;
+        pass = graph.AddPass( "Scene", &passes[2] );
+        graph.Read( pass, shadow );
+        graph.Write( pass, backBuffer );
+        passes[2].mTarget = backBuffer;
+        graph.Compile( &allocator );
+
+        CPUT_CHECK( !graph.IsCulled( 0 ) && graph.IsCulled( 1 ) && !graph.IsCulled( 2 ) );
+        CPUT_CHECK( graph.HasAccess( 2, shadow, false ) && !graph.HasAccess( 2, shadow, true ) && graph.HasAccess( 2, backBuffer, true ) );
+        CPUT_CHECK( !graph.IsUsed( debug ) && NULL == graph.GetTexture( debug ) );
+        CPUT_CHECK( (CPUTBackendHandle)0x1234 == graph.GetTexture( backBuffer ) );
+        CPUT_CHECK( 1 == allocator.GetLiveTextureCount() && (64ull << 20) == allocator.GetLiveBytes() );
+        const CPUTRenderGraphStats &stats = graph.GetStats();
+        CPUT_CHECK( 3 == stats.mPasses && 1 == stats.mPassesCulled && 1 == stats.mTransients && 1 == stats.mTextures );
+
+        graph.Execute( &backend );
+        CPUT_CHECK( 2 == log.size() && 0 == log[0] && 2 == log[1] );
+        CPUT_CHECK( 4 == backend.GetRecordedCommandCount() );
+        CPUT_CHECK( CPUT_BACKEND_CMD_SET_RENDER_TARGETS == backend.GetRecordedCommand( 0 ).mType );
+        CPUT_CHECK( 2 == backend.GetStats().mDrawCalls );
+
+        // Compiling again releases the first compile's textures
+        graph.Compile( &allocator );
+        CPUT_CHECK( 1 == allocator.GetLiveTextureCount() );
+    }
+    CPUT_CHECK( 0 == allocator.GetLiveTextureCount() && 0 == allocator.GetLiveBytes() );
+}
+
+// CPUTPostProcess at 1920x1080, alone and after a shadow and scene pass
+//-----------------------------------------------------------------------------
+static void TestPostProcess()
+{
+    std::vector<uint32_t> log;
+    CPUTTestPass passes[kPassCount];
+    ResetPasses( passes, &log );
+    CPUTRenderGraphAllocatorNull allocator;
+    for( uint32_t withScene=0; withScene<2; withScene++ )
+    {
+        CPUTRenderGraph graph;
+        CPUTRenderGraphResource source        = graph.ImportTexture( CPUTStringTable::Intern( "$PostProcessSource" ), (CPUTBackendHandle)0x10 );
+        CPUTRenderGraphResource rt1x1         = graph.ImportTexture( CPUTStringTable::Intern( "$PostProcessRT1x1" ),  (CPUTBackendHandle)0x11 );
+        CPUTRenderGraphResource downSample4x4 = graph.CreateTexture( CPUTStringTable::Intern( "$PostProcessDownsample4x4" ),         TextureDesc( 480, 270, 28 ) );
+        CPUTRenderGraphResource pingPong      = graph.CreateTexture( CPUTStringTable::Intern( "$PostProcessDownsample4x4PingPong" ), TextureDesc( 480, 270, 28 ) );
+        CPUTRenderGraphResource rt64x64       = graph.CreateTexture( CPUTStringTable::Intern( "$PostProcessRT64x64" ),               TextureDesc( 64, 64, 41 ) );
+        CPUTRenderGraphResource rt4x4         = graph.CreateTexture( CPUTStringTable::Intern( "$PostProcessRT4x4" ),                 TextureDesc( 8, 8, 41 ) );
+        uint32_t pass;
+        if( withScene )
+        {
+            CPUTRenderGraphResource shadow = graph.CreateTexture( CPUTStringTable::Intern( "$shadow_depth" ), TextureDesc( 4096, 4096, 40, CPUT_RENDER_GRAPH_DEPTH ) );
+            pass = graph.AddPass( "Shadow", &passes[8] );
+            graph.Write( pass, shadow );
+            pass = graph.AddPass( "Scene", &passes[9] );
+            graph.Read( pass, shadow );
+            graph.Write( pass, source );
+        }
+        pass = graph.AddPass( "Downsample", &passes[0] );
+        graph.Read( pass, source );
+        graph.Write( pass, downSample4x4 );
+        pass = graph.AddPass( "Log luminance", &passes[1] );
+        graph.Read( pass, downSample4x4 );
+        graph.Write( pass, rt64x64 );
+        pass = graph.AddPass( "Luminance 4x4", &passes[2] );
+        graph.Read( pass, rt64x64 );
+        graph.Write( pass, rt4x4 );
+        pass = graph.AddPass( "Luminance 1x1", &passes[3] );
+        graph.Read( pass, rt4x4 );
+        graph.Read( pass, rt1x1 );
+        graph.Write( pass, rt1x1 );
+        pass = graph.AddPass( "Blur horizontal", &passes[4] );
+        graph.Read( pass, downSample4x4 );
+        graph.Write( pass, pingPong );
+        pass = graph.AddPass( "Blur vertical", &passes[5] );
+        graph.Read( pass, pingPong );
+        graph.Write( pass, downSample4x4 );
+        pass = graph.AddPass( "Composite", &passes[6], true );
+        graph.Read( pass, source );
+        graph.Read( pass, downSample4x4 );
+        graph.Read( pass, rt1x1 );
+        graph.Compile( &allocator );
+
+        const CPUTRenderGraphStats &stats = graph.GetStats();
+        CPUT_CHECK( 0 == stats.mPassesCulled );
+        CPUT_CHECK( graph.GetTextureIndex( downSample4x4 ) != graph.GetTextureIndex( pingPong ) );
+        CPUT_CHECK( graph.GetTexture( downSample4x4 ) != graph.GetTexture( pingPong ) );
+        CPUT_CHECK( allocator.GetLiveTextureCount() == stats.mTextures );
+        CPUT_CHECK( stats.mPeakBytes <= stats.mHeapBytes && stats.mHeapBytes <= stats.mTransientBytes );
+        CPUT_CHECK( stats.mTextureBytes <= stats.mTransientBytes );
+
+        log.clear();
+        CPUTRenderBackendNull backend;
+        graph.Execute( &backend );
+        CPUT_CHECK( log.size() == stats.mPasses );
+        for( uint32_t ii=1; ii<log.size(); ii++ )
+        {
+            CPUT_CHECK( log[ii] != log[ii-1] );
+        }
+        CPUT_CHECK( 6 == log.back() );
+    }
+}
+
+// Transients with the same description and disjoint lifetimes share a texture.  A write
+// that's rewritten before anyone reads it is culled, as is a blend whose result nobody reads.
+//-----------------------------------------------------------------------------
+static void TestAliasing()
+{
+    std::vector<uint32_t> log;
+    CPUTTestPass passes[kPassCount];
+    ResetPasses( passes, &log );
+    CPUTRenderGraph graph;
+    CPUTRenderGraphResource a      = graph.CreateTexture( CPUTStringTable::Intern( "a" ), TextureDesc( 256, 256, 28 ) );
+    CPUTRenderGraphResource b      = graph.CreateTexture( CPUTStringTable::Intern( "b" ), TextureDesc( 256, 256, 28 ) );
+    CPUTRenderGraphResource output = graph.ImportTexture( CPUTStringTable::Intern( "output" ), (CPUTBackendHandle)1 );
+    uint32_t pass = graph.AddPass( "Dead write", &passes[0] );
+    graph.Write( pass, a );
+    pass = graph.AddPass( "Write a", &passes[1] );
+    graph.Write( pass, a );
+    pass = graph.AddPass( "Read a", &passes[2] );
+    graph.Read( pass, a );
+    graph.Write( pass, output );
+    pass = graph.AddPass( "Write b", &passes[3] );
+    graph.Write( pass, b );
+    pass = graph.AddPass( "Read b", &passes[4] );
+    graph.Read( pass, b );
+    graph.Write( pass, output );
+    pass = graph.AddPass( "Blend a", &passes[5] );
+    graph.Read( pass, a );
+    graph.Write( pass, a );
+    graph.Compile( NULL ); // Plans without creating textures
+
+    CPUT_CHECK( graph.IsCulled( 0 ) && !graph.IsCulled( 1 ) && graph.IsCulled( 5 ) );
+    CPUT_CHECK( graph.GetTextureIndex( a ) == graph.GetTextureIndex( b ) );
+    CPUT_CHECK( 1 == graph.GetStats().mTextures && 256*256*4 == graph.GetStats().mHeapBytes );
+    CPUT_CHECK( 4 == graph.GetOrderedPassCount() && 1 == graph.GetOrderedPass( 0 ) && 4 == graph.GetOrderedPass( 3 ) );
+    CPUT_CHECK( NULL == graph.GetTexture( a ) );
+
+    graph.Reset();
+    CPUT_CHECK( 0 == graph.GetOrderedPassCount() );
+}
+
+// Random graphs.  Transients live during the same pass must get different textures and
+// disjoint heap ranges; ones that share a texture must have the same description.
+//-----------------------------------------------------------------------------
+static void TestRandomGraphs()
+{
+    std::vector<uint32_t> log;
+    CPUTTestPass passes[kPassCount];
+    ResetPasses( passes, &log );
+    CPUTRenderGraphAllocatorNull allocator;
+    CPUTTestRandom random( 7 );
+    for( uint32_t trial=0; trial<2000; trial++ )
+    {
+        CPUTRenderGraph graph;
+        uint32_t resourceCount = 1 + random.Index( 12 );
+        std::vector<CPUTRenderGraphResource>    resources;
+        std::vector<CPUTRenderGraphTextureDesc> descs;
+        for( uint32_t ii=0; ii<resourceCount; ii++ )
+        {
+            uint32_t size = 16u << random.Index( 7 );
+            descs.push_back( TextureDesc( size, size, 28 + random.Index( 2 ) ) );
+            resources.push_back( graph.CreateTexture( CPUTStringTable::Intern( "transient" ), descs.back() ) );
+        }
+        CPUTRenderGraphResource output = graph.ImportTexture( CPUTStringTable::Intern( "output" ), (CPUTBackendHandle)1 );
+
+        // Passes read transients written earlier, and write a transient or the output
+        std::vector<bool> written( resourceCount, false );
+        uint32_t passCount = 1 + random.Index( 14 );
+        std::vector< std::vector<uint32_t> > touched( passCount );
+        for( uint32_t pp=0; pp<passCount; pp++ )
+        {
+            uint32_t pass = graph.AddPass( "Random", &passes[pp] );
+            for( uint32_t rr=0; rr<2; rr++ )
+            {
+                uint32_t read = random.Index( resourceCount );
+                if( written[read] )
+                {
+                    graph.Read( pass, resources[read] );
+                    touched[pp].push_back( read );
+                }
+            }
+            uint32_t write = random.Index( resourceCount + 1 );
+            if( write == resourceCount )
+            {
+                graph.Write( pass, output );
+            }
+            else
+            {
+                graph.Write( pass, resources[write] );
+                written[write] = true;
+                touched[pp].push_back( write );
+            }
+        }
+        graph.Compile( &allocator );
+        const CPUTRenderGraphStats &stats = graph.GetStats();
+        CPUT_CHECK( stats.mPeakBytes <= stats.mHeapBytes && stats.mTextureBytes <= stats.mTransientBytes );
+        CPUT_CHECK( allocator.GetLiveTextureCount() == stats.mTextures );
+
+        // Lifetimes, in positions among the passes that run
+        std::vector<int> first( resourceCount, 1 << 30 ), last( resourceCount, -1 );
+        for( uint32_t ii=0; ii<graph.GetOrderedPassCount(); ii++ )
+        {
+            const std::vector<uint32_t> &accesses = touched[graph.GetOrderedPass( ii )];
+            for( size_t jj=0; jj<accesses.size(); jj++ )
+            {
+                first[accesses[jj]] = std::min( first[accesses[jj]], (int)ii );
+                last[accesses[jj]]  = std::max( last[accesses[jj]], (int)ii );
+            }
+        }
+        for( uint32_t xx=0; xx<resourceCount; xx++ )
+        {
+            CPUT_CHECK( graph.IsUsed( resources[xx] ) == (last[xx] >= 0) );
+            CPUT_CHECK( 0 == graph.GetHeapOffset( resources[xx] ) % CPUT_RENDER_GRAPH_HEAP_ALIGNMENT );
+            for( uint32_t yy=xx+1; yy<resourceCount; yy++ )
+            {
+                if( last[xx] < 0 || last[yy] < 0 )
+                {
+                    continue;
+                }
+                bool overlap = first[xx] <= last[yy] && first[yy] <= last[xx];
+                if( graph.GetTextureIndex( resources[xx] ) == graph.GetTextureIndex( resources[yy] ) )
+                {
+                    CPUT_CHECK( !overlap && descs[xx] == descs[yy] && graph.GetTexture( resources[xx] ) == graph.GetTexture( resources[yy] ) );
+                }
+                if( overlap )
+                {
+                    uint64_t offsetX = graph.GetHeapOffset( resources[xx] ), offsetY = graph.GetHeapOffset( resources[yy] );
+                    CPUT_CHECK( offsetX + descs[xx].GetBytes() <= offsetY || offsetY + descs[yy].GetBytes() <= offsetX );
+                }
+            }
+        }
+    }
+    CPUT_CHECK( 0 == allocator.GetLiveTextureCount() );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestCulling();
+    TestPostProcess();
+    TestAliasing();
+    TestRandomGraphs();
+    return CPUTTestResult();
+}
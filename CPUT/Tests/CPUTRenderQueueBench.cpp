@@ -0,0 +1,159 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderQueue.h"
+#include "CPUTModel.h"
+#include "CPUTMaterial.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTThreadPool.h"
+#include "CPUTUploadRing.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <vector>
+
+// CPUTRenderQueue::Submit() time for 24k draws (a shadow and an opaque pass over 12k
+// models, with the stand-ins in Shims/) on the null backend, serially and recorded on
+// 2 to 8 threads, with and without the upload ring.  Recording on the null backend is
+// cheaper than a D3D11 deferred context, and replaying it dearer than executing a
+// command list, so this shows the queue's own overhead rather than a driver's.
+//
+// Then the draw calls, API calls and Submit() time for 10k props that repeat 20 meshes,
+// with a material that is drawn instanced and one that isn't.
+
+static const uint32_t kModels    = 12000;
+static const uint32_t kMaterials = 64;
+static const uint32_t kMeshes    = 200;
+static const uint32_t kFrames    = 50;
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTRenderBackendNull backend;
+    CPUTTestRandom random( 33 );
+    std::vector<uint8_t> data( 64 * 32, 1 );
+    std::vector<CPUTMesh*> meshes;
+    for( uint32_t ii=0; ii<kMeshes; ii++ )
+    {
+        CPUTBackendHandle vertices = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_VERTEX_BUFFER, false, &data[0] );
+        CPUTBackendHandle indices  = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_INDEX_BUFFER, false, &data[0] );
+        meshes.push_back( new CPUTMesh( vertices, indices, 36, false ) );
+    }
+    std::vector<CPUTMaterial*> materials;
+    for( uintptr_t ii=0; ii<kMaterials; ii++ )
+    {
+        materials.push_back( new CPUTMaterial( (CPUTBackendHandle)(0x100000 + ii/2), 0, (CPUTBackendHandle)(0x100100 + ii/2), (CPUTBackendHandle)(0x100200 + ii) ) );
+    }
+    std::vector<CPUTModel*> models;
+    std::vector<uint32_t>   modelMaterials;
+    for( uint32_t ii=0; ii<kModels; ii++ )
+    {
+        float4x4 world = float4x4Translation( random.Float( -100.0f, 100.0f ), 0.0f, random.Float( -100.0f, 100.0f ) );
+        models.push_back( new CPUTModel( &backend, meshes[random.Index( kMeshes )], world ) );
+        modelMaterials.push_back( random.Index( kMaterials ) );
+    }
+
+    CPUTThreadPool pool( 7 );
+    CPUTUploadRing ring;
+    ring.Create( &backend, kModels * CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT );
+    const uint32_t threadCounts[4] = { 1, 2, 4, 8 };
+    printf( "  %u draws, %u hardware threads\n", 2 * kModels, CPUTThreadPool::GetHardwareThreadCount() );
+    for( uint32_t useRing=0; useRing<2; useRing++ )
+    {
+        for( uint32_t tt=0; tt<4; tt++ )
+        {
+            CPUTRenderQueue queue;
+            queue.SetThreadPool( threadCounts[tt] > 1 ? &pool : NULL, threadCounts[tt] );
+            CPUTRenderParameters renderParams;
+            renderParams.mpBackend    = &backend;
+            renderParams.mpUploadRing = useRing ? &ring : NULL;
+            double seconds = 0.0;
+            for( uint32_t ff=0; ff<kFrames; ff++ )
+            {
+                ring.BeginFrame();
+                for( uint32_t pass=0; pass<2; pass++ )
+                {
+                    for( uint32_t ii=0; ii<kModels; ii++ )
+                    {
+                        uint32_t depth = CPUTRenderQueue::QuantizeDepth( random.Float( 1.0f, 500.0f ) );
+                        uint64_t key   = CPUTRenderQueue::MakeKey( pass ? CPUT_RENDER_PASS_OPAQUE : CPUT_RENDER_PASS_SHADOW, modelMaterials[ii] / 2, 0, modelMaterials[ii], depth );
+                        queue.AddPacket( key, models[ii], materials[modelMaterials[ii]], 0 );
+                    }
+                }
+                double start = CPUTFrameScheduler::GetSeconds();
+                queue.Submit( renderParams );
+                seconds += CPUTFrameScheduler::GetSeconds() - start;
+                ring.EndFrame();
+            }
+            double milliseconds = seconds * 1000.0 / kFrames;
+            printf( "  %-32s %u thread%s  %7.2f ms  %7.0f draws/ms\n", useRing ? "Submit, upload ring" : "Submit", threadCounts[tt],
+                    threadCounts[tt] > 1 ? "s" : " ", milliseconds, 2 * kModels / milliseconds );
+            queue.ReleaseResources();
+        }
+    }
+
+    // 10k props: 20 meshes repeated, with one material, drawn instanced and not
+    static const uint32_t kProps = 10000, kPropMeshes = 20;
+    std::vector<CPUTMesh*>  propMeshes;
+    std::vector<CPUTModel*> props;
+    for( uint32_t ii=0; ii<kPropMeshes; ii++ )
+    {
+        CPUTBackendHandle vertices = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_VERTEX_BUFFER, false, &data[0] );
+        CPUTBackendHandle indices  = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_INDEX_BUFFER, false, &data[0] );
+        propMeshes.push_back( new CPUTMesh( vertices, indices, 36, true ) );
+    }
+    for( uint32_t ii=0; ii<kProps; ii++ )
+    {
+        float4x4 world = float4x4Translation( random.Float( -100.0f, 100.0f ), 0.0f, random.Float( -100.0f, 100.0f ) );
+        props.push_back( new CPUTModel( &backend, propMeshes[ii % kPropMeshes], world ) );
+    }
+    CPUTMaterial propMaterials[2] =
+    {
+        CPUTMaterial( (CPUTBackendHandle)0x100300, 0, (CPUTBackendHandle)0x100301, (CPUTBackendHandle)0x100302 ),
+        CPUTMaterial( (CPUTBackendHandle)0x100300, (CPUTBackendHandle)0x100303, (CPUTBackendHandle)0x100301, (CPUTBackendHandle)0x100302 ),
+    };
+    printf( "  %u props of %u meshes\n", kProps, kPropMeshes );
+    for( uint32_t instanced=0; instanced<2; instanced++ )
+    {
+        CPUTRenderQueue queue;
+        CPUTRenderParameters renderParams;
+        renderParams.mpBackend = &backend;
+        backend.ResetStats();
+        double seconds = 0.0;
+        for( uint32_t ff=0; ff<kFrames; ff++ )
+        {
+            for( uint32_t ii=0; ii<kProps; ii++ )
+            {
+                uint32_t depth = CPUTRenderQueue::QuantizeDepth( random.Float( 1.0f, 500.0f ) );
+                depth = instanced ? CPUTRenderQueue::MakeInstancedDepth( ii % kPropMeshes, depth ) : depth;
+                queue.AddPacket( CPUTRenderQueue::MakeKey( CPUT_RENDER_PASS_OPAQUE, 0, 0, 0, depth ), props[ii], &propMaterials[instanced], 0 );
+            }
+            double start = CPUTFrameScheduler::GetSeconds();
+            queue.Submit( renderParams );
+            seconds += CPUTFrameScheduler::GetSeconds() - start;
+        }
+        const CPUTBackendStats &stats = backend.GetStats();
+        printf( "  %-32s %7.2f ms  %6u draw calls  %6u API calls\n", instanced ? "Submit, instanced" : "Submit, not instanced",
+                seconds * 1000.0 / kFrames, stats.mDrawCalls / kFrames, stats.GetTotalAPICalls() / kFrames );
+        queue.ReleaseResources();
+    }
+
+    ring.Release();
+    for( size_t ii=0; ii<props.size(); ii++ )      { delete props[ii]; }
+    for( size_t ii=0; ii<propMeshes.size(); ii++ ) { delete propMeshes[ii]; }
+    for( size_t ii=0; ii<models.size(); ii++ )    { delete models[ii]; }
+    for( size_t ii=0; ii<materials.size(); ii++ ) { delete materials[ii]; }
+    for( size_t ii=0; ii<meshes.size(); ii++ )    { delete meshes[ii]; }
+    return 0;
+}
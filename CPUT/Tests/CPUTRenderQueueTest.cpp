@@ -0,0 +1,439 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderQueue.h"
+#include "CPUTModel.h"
+#include "CPUTMaterial.h"
+#include "CPUTRenderBackendNull.h"
+#include "CPUTThreadPool.h"
+#include "CPUTUploadRing.h"
+#include "CPUTTest.h"
+#include <map>
+#include <string.h>
+#include <vector>
+
+// Queues a shadow and an opaque packet for each of 12k models (against the stand-in
+// model, material and mesh in Shims/), submits them serially and recorded on 2 to 8
+// threads, and checks that every draw reaching the null backend sees the same thing:
+// the same draws in the same order, with the same shaders, texture, buffers, model
+// constants and instance data.  (The calls in between can differ: a threaded Submit()
+// without the ring uploads every model's constants before the first draw.)  Checked
+// without the upload ring, with it, and with a ring too small for the frame.
+//
+// Then checks that runs of packets sharing a mesh and an instanced material collapse
+// into one DrawIndexedInstanced() of the run's models.
+
+static const uint32_t kModels    = 12000;
+static const uint32_t kMaterials = 24;
+static const uint32_t kMeshes    = 40;
+
+//-----------------------------------------------------------------------------
+struct CPUTTestScene
+{
+    std::vector<CPUTMesh*>     mMeshes;
+    std::vector<CPUTMaterial*> mMaterials;
+    std::vector<CPUTModel*>    mModels;
+    std::vector<uint32_t>      mModelMaterials;
+
+    ~CPUTTestScene()
+    {
+        for( size_t ii=0; ii<mModels.size(); ii++ )    { delete mModels[ii]; }
+        for( size_t ii=0; ii<mMaterials.size(); ii++ ) { delete mMaterials[ii]; }
+        for( size_t ii=0; ii<mMeshes.size(); ii++ )    { delete mMeshes[ii]; }
+    }
+};
+
+// Handles for objects the backend doesn't create (shaders, views) are synthetic
+//-----------------------------------------------------------------------------
+static CPUTBackendHandle TestHandle( uintptr_t value )
+{
+    return (CPUTBackendHandle)(0x100000 + value);
+}
+
+// The same scene, with the same handles, every time it is created on a new backend.
+// One material in four can be drawn instanced.
+//-----------------------------------------------------------------------------
+static void CreateScene( CPUTRenderBackend *pBackend, CPUTTestScene *pScene )
+{
+    CPUTTestRandom random( 33 );
+    std::vector<uint8_t> data( 64 * 32, 1 );
+    for( uint32_t ii=0; ii<kMeshes; ii++ )
+    {
+        CPUTBackendHandle vertices = pBackend->CreateBuffer( (uint32_t)data.size(), CPUT_BIND_VERTEX_BUFFER, false, &data[0] );
+        CPUTBackendHandle indices  = pBackend->CreateBuffer( (uint32_t)data.size(), CPUT_BIND_INDEX_BUFFER, false, &data[0] );
+        pScene->mMeshes.push_back( new CPUTMesh( vertices, indices, 3 * (1 + ii), true ) );
+    }
+    for( uintptr_t ii=0; ii<kMaterials; ii++ )
+    {
+        // Pairs of materials share shaders
+        CPUTBackendHandle instanced = (ii & 3) ? 0 : TestHandle( 1000 + ii/2 );
+        pScene->mMaterials.push_back( new CPUTMaterial( TestHandle( ii/2 ), instanced, TestHandle( 100 + ii/2 ), TestHandle( 200 + ii ) ) );
+    }
+    for( uint32_t ii=0; ii<kModels; ii++ )
+    {
+        float4x4 world = float4x4Translation( random.Float( -100.0f, 100.0f ), 0.0f, random.Float( -100.0f, 100.0f ) );
+        pScene->mModels.push_back( new CPUTModel( pBackend, pScene->mMeshes[random.Index( kMeshes )], world ) );
+        pScene->mModelMaterials.push_back( random.Index( kMaterials ) );
+    }
+}
+
+// Keys as CPUTModel::QueueMeshes() builds them, with the scene's indices for ids
+//-----------------------------------------------------------------------------
+static void QueueScene( const CPUTTestScene &scene, uint32_t frame, CPUTRenderQueue *pQueue )
+{
+    CPUTTestRandom random( 7 + frame );
+    for( uint32_t pass=0; pass<2; pass++ )
+    {
+        for( uint32_t ii=0; ii<kModels; ii++ )
+        {
+            uint32_t      materialIndex = scene.mModelMaterials[ii];
+            CPUTMaterial *pMaterial     = scene.mMaterials[materialIndex];
+            CPUTModel    *pModel        = scene.mModels[ii];
+            uint32_t      depth         = CPUTRenderQueue::QuantizeDepth( random.Float( 1.0f, 500.0f ) );
+            if( pMaterial->SupportsInstancing() )
+            {
+                uint32_t meshId = 0;
+                while( scene.mMeshes[meshId] != pModel->GetMesh( 0 ) ) { meshId++; }
+                depth = CPUTRenderQueue::MakeInstancedDepth( meshId, depth );
+            }
+            uint64_t key = CPUTRenderQueue::MakeKey( pass ? CPUT_RENDER_PASS_OPAQUE : CPUT_RENDER_PASS_SHADOW, materialIndex / 2, 0, materialIndex, depth );
+            pQueue->AddPacket( key, pModel, pMaterial, 0 );
+        }
+    }
+}
+
+// Renders two frames of the scene, recording what reaches pBackend.  ringModels is the
+// number of models' constants the upload ring has room for (0 for no ring).
+//-----------------------------------------------------------------------------
+static void RenderScene( CPUTRenderBackendNull *pBackend, CPUTThreadPool *pPool, uint32_t threadCount, uint32_t ringModels, CPUTRenderQueueStats *pStats )
+{
+    CPUTTestScene scene;
+    CreateScene( pBackend, &scene );
+    CPUTUploadRing ring;
+    if( ringModels )
+    {
+        ring.Create( pBackend, ringModels * CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT );
+    }
+    CPUTRenderQueue queue;
+    queue.SetThreadPool( threadCount > 1 ? pPool : NULL, threadCount );
+    CPUTRenderParameters renderParams;
+    renderParams.mpBackend    = pBackend;
+    renderParams.mpUploadRing = ringModels ? &ring : NULL;
+    pBackend->SetRecording( true );
+    for( uint32_t frame=0; frame<2; frame++ )
+    {
+        ring.BeginFrame();
+        QueueScene( scene, frame, &queue );
+        queue.Submit( renderParams );
+        ring.EndFrame();
+    }
+    pBackend->SetRecording( false );
+    *pStats = queue.GetStats();
+    queue.ReleaseResources();
+}
+
+// What the bound state of a recording looks like at each draw
+//-----------------------------------------------------------------------------
+struct CPUTTestDrawLog
+{
+    std::map<CPUTBackendHandle, std::vector<uint8_t> > mBuffers;   // Contents, from the recorded updates
+    CPUTBackendHandle mShaders[CPUT_SHADER_STAGE_COUNT];
+    CPUTBackendHandle mTexture;
+    CPUTBackendHandle mConstantBuffer;
+    uint32_t          mConstantOffset;
+    CPUTBackendHandle mVertexBuffers[2];
+    uint32_t          mInstanceStride;
+    CPUTBackendHandle mIndexBuffer;
+
+    // One entry per draw: its arguments, the shaders, texture and vertex and index
+    // buffers bound, and the bytes of its model constants and instance data.  Buffers
+    // holding constants and instances are compared by content, not handle.
+    std::vector< std::vector<uint8_t> > mDraws;
+
+    CPUTTestDrawLog() : mTexture(0), mConstantBuffer(0), mConstantOffset(0), mInstanceStride(0), mIndexBuffer(0)
+    {
+        memset( mShaders, 0, sizeof(mShaders) );
+        memset( mVertexBuffers, 0, sizeof(mVertexBuffers) );
+    }
+
+    void Append( std::vector<uint8_t> &draw, const void *pData, size_t byteCount )
+    {
+        draw.insert( draw.end(), (const uint8_t*)pData, (const uint8_t*)pData + byteCount );
+    }
+
+    void AppendBuffer( std::vector<uint8_t> &draw, CPUTBackendHandle buffer, uint32_t offset, uint32_t byteCount )
+    {
+        std::vector<uint8_t> &contents = mBuffers[buffer];
+        if( contents.size() < offset + byteCount )
+        {
+            contents.resize( offset + byteCount );
+        }
+        Append( draw, &contents[offset], byteCount );
+    }
+
+    void Log( const CPUTRenderBackendNull &backend )
+    {
+        for( uint32_t ii=0; ii<backend.GetRecordedCommandCount(); ii++ )
+        {
+            const CPUTBackendCommand &command  = backend.GetRecordedCommand( ii );
+            const uint8_t            *pPayload = (const uint8_t*)backend.GetRecordedPayload( command );
+            switch( command.mType )
+            {
+            case CPUT_BACKEND_CMD_UPDATE_BUFFER:
+            {
+                std::vector<uint8_t> &contents = mBuffers[command.mHandle];
+                uint32_t offset = command.mArg[1] ? command.mArg[0] : 0;
+                if( contents.size() < offset + command.mPayloadSize )
+                {
+                    contents.resize( offset + command.mPayloadSize );
+                }
+                if( command.mPayloadSize )
+                {
+                    memcpy( &contents[offset], pPayload, command.mPayloadSize );
+                }
+                break;
+            }
+            case CPUT_BACKEND_CMD_SET_SHADER:
+                mShaders[command.mArg[0]] = command.mHandle;
+                break;
+            case CPUT_BACKEND_CMD_SET_CONSTANT_BUFFERS:
+                if( CPUT_SHADER_STAGE_VERTEX == command.mArg[0] && 0 == command.mArg[1] )
+                {
+                    memcpy( &mConstantBuffer, pPayload, sizeof(CPUTBackendHandle) );
+                    mConstantOffset = 0;
+                }
+                break;
+            case CPUT_BACKEND_CMD_SET_CONSTANT_BUFFER_RANGE:
+                if( CPUT_SHADER_STAGE_VERTEX == command.mArg[0] && 0 == command.mArg[1] )
+                {
+                    mConstantBuffer = command.mHandle;
+                    mConstantOffset = command.mArg[2];
+                }
+                break;
+            case CPUT_BACKEND_CMD_SET_SHADER_RESOURCES:
+                if( CPUT_SHADER_STAGE_PIXEL == command.mArg[0] && 0 == command.mArg[1] )
+                {
+                    memcpy( &mTexture, pPayload, sizeof(CPUTBackendHandle) );
+                }
+                break;
+            case CPUT_BACKEND_CMD_SET_VERTEX_BUFFER:
+                mVertexBuffers[command.mArg[0]] = command.mHandle;
+                mInstanceStride = 1 == command.mArg[0] ? command.mArg[1] : mInstanceStride;
+                break;
+            case CPUT_BACKEND_CMD_SET_INDEX_BUFFER:
+                mIndexBuffer = command.mHandle;
+                break;
+            case CPUT_BACKEND_CMD_DRAW_INDEXED:
+            case CPUT_BACKEND_CMD_DRAW_INDEXED_INSTANCED:
+            {
+                std::vector<uint8_t> draw;
+                Append( draw, &command.mType, sizeof(command.mType) );
+                Append( draw, command.mArg, sizeof(command.mArg) );
+                Append( draw, mShaders, sizeof(mShaders) );
+                Append( draw, &mTexture, sizeof(mTexture) );
+                Append( draw, &mVertexBuffers[0], sizeof(mVertexBuffers[0]) );
+                Append( draw, &mIndexBuffer, sizeof(mIndexBuffer) );
+                AppendBuffer( draw, mConstantBuffer, mConstantOffset, sizeof(float4x4) );
+                if( CPUT_BACKEND_CMD_DRAW_INDEXED_INSTANCED == command.mType )
+                {
+                    AppendBuffer( draw, mVertexBuffers[1], command.mArg[4] * mInstanceStride, command.mArg[1] * mInstanceStride );
+                }
+                mDraws.push_back( draw );
+                break;
+            }
+            }
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+static void TestThreadCounts( CPUTThreadPool *pPool )
+{
+    const uint32_t ringSizes[3]    = { 0, kModels * 2, 1000 };
+    const uint32_t threadCounts[4] = { 2, 3, 4, 8 };
+    for( uint32_t rr=0; rr<3; rr++ )
+    {
+        CPUTRenderBackendNull serial;
+        CPUTRenderQueueStats  serialStats;
+        RenderScene( &serial, pPool, 1, ringSizes[rr], &serialStats );
+        CPUT_CHECK( 2 * 2 * kModels == serialStats.mPackets );
+        CPUT_CHECK( 0 == serialStats.mRecordedRanges );
+        CPUT_CHECK( serialStats.mInstancedDraws > 0 );
+        CPUT_CHECK( (2 == rr ? 2u : 0u) == serialStats.mRingOverflows );
+        CPUTTestDrawLog serialLog;
+        serialLog.Log( serial );
+        CPUT_CHECK( serialLog.mDraws.size() == serialStats.mPackets - serialStats.mInstances + serialStats.mInstancedDraws );
+        for( uint32_t tt=0; tt<4; tt++ )
+        {
+            CPUTRenderBackendNull threaded;
+            CPUTRenderQueueStats  threadedStats;
+            RenderScene( &threaded, pPool, threadCounts[tt], ringSizes[rr], &threadedStats );
+            CPUT_CHECK( 2 * threadCounts[tt] == threadedStats.mRecordedRanges );
+            CPUT_CHECK( serialStats.mPackets == threadedStats.mPackets );
+            CPUT_CHECK( serialStats.mInstancedDraws == threadedStats.mInstancedDraws );
+            CPUT_CHECK( serialStats.mInstances == threadedStats.mInstances );
+            CPUTTestDrawLog threadedLog;
+            threadedLog.Log( threaded );
+            CPUT_CHECK( serialLog.mDraws.size() == threadedLog.mDraws.size() );
+            uint32_t difference = 0;
+            while( difference < serialLog.mDraws.size() && difference < threadedLog.mDraws.size() &&
+                   serialLog.mDraws[difference] == threadedLog.mDraws[difference] )
+            {
+                difference++;
+            }
+            CPUT_CHECK( difference == serialLog.mDraws.size() );
+            if( difference < serialLog.mDraws.size() )
+            {
+                printf( "  ring %u, %u threads: draw %u of %u differs\n", ringSizes[rr], threadCounts[tt], difference, (uint32_t)serialLog.mDraws.size() );
+            }
+        }
+    }
+}
+
+// Models of one mesh and material, queued in one pass
+//-----------------------------------------------------------------------------
+struct CPUTTestRun
+{
+    uint32_t         mCount;
+    uint32_t         mMesh;        // 0 and 1 can be drawn instanced, 2 can't
+    uint32_t         mMaterial;    // 0 can be drawn instanced, 1 can't
+    CPUT_RENDER_PASS mPass;
+};
+
+// Queues the runs, each model with a world matrix translated by its index, submits
+// serially, and counts the draws that reach the backend.  Checks that each instanced
+// draw's instances are the models of its run, each once.
+//-----------------------------------------------------------------------------
+static void SubmitRuns( const CPUTTestRun *pRuns, uint32_t runCount, uint32_t *pDraws, uint32_t *pInstancedDraws, std::vector<uint32_t> *pInstanceCounts )
+{
+    CPUTRenderBackendNull backend;
+    std::vector<uint8_t> data( 64 * 32, 1 );
+    CPUTMesh *pMeshes[3];
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        CPUTBackendHandle vertices = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_VERTEX_BUFFER, false, &data[0] );
+        CPUTBackendHandle indices  = backend.CreateBuffer( (uint32_t)data.size(), CPUT_BIND_INDEX_BUFFER, false, &data[0] );
+        pMeshes[ii] = new CPUTMesh( vertices, indices, 36, ii < 2 );
+    }
+    CPUTMaterial instanced( TestHandle( 1 ), TestHandle( 2 ), TestHandle( 3 ), TestHandle( 4 ) );
+    CPUTMaterial single( TestHandle( 5 ), 0, TestHandle( 6 ), TestHandle( 7 ) );
+    CPUTMaterial *pMaterials[2] = { &instanced, &single };
+
+    CPUTRenderQueue queue;
+    std::vector<CPUTModel*> models;
+    std::vector<uint32_t>   modelRuns;
+    CPUTTestRandom random( 9 );
+    for( uint32_t rr=0; rr<runCount; rr++ )
+    {
+        const CPUTTestRun &run = pRuns[rr];
+        for( uint32_t ii=0; ii<run.mCount; ii++ )
+        {
+            CPUTModel *pModel = new CPUTModel( &backend, pMeshes[run.mMesh], float4x4Translation( (float)models.size(), 0.0f, 0.0f ) );
+            uint32_t depth = CPUTRenderQueue::QuantizeDepth( random.Float( 1.0f, 500.0f ) );
+            if( 0 == run.mMaterial )
+            {
+                depth = CPUTRenderQueue::MakeInstancedDepth( run.mMesh, depth );
+            }
+            queue.AddPacket( CPUTRenderQueue::MakeKey( run.mPass, run.mMaterial, 0, run.mMaterial, depth ), pModel, pMaterials[run.mMaterial], 0 );
+            models.push_back( pModel );
+            modelRuns.push_back( rr );
+        }
+    }
+    CPUTRenderParameters renderParams;
+    renderParams.mpBackend = &backend;
+    backend.SetRecording( true );
+    queue.Submit( renderParams );
+    backend.SetRecording( false );
+
+    *pDraws = *pInstancedDraws = 0;
+    pInstanceCounts->clear();
+    CPUTBackendHandle instanceBuffer = 0;
+    for( uint32_t ii=0; ii<backend.GetRecordedCommandCount(); ii++ )
+    {
+        const CPUTBackendCommand &command = backend.GetRecordedCommand( ii );
+        if( CPUT_BACKEND_CMD_SET_VERTEX_BUFFER == command.mType && CPUT_INSTANCE_DATA_SLOT == command.mArg[0] )
+        {
+            CPUT_CHECK( sizeof(CPUTInstanceData) == command.mArg[1] );
+            instanceBuffer = command.mHandle;
+        }
+        else if( CPUT_BACKEND_CMD_DRAW_INDEXED == command.mType )
+        {
+            (*pDraws)++;
+        }
+        else if( CPUT_BACKEND_CMD_DRAW_INDEXED_INSTANCED == command.mType )
+        {
+            (*pInstancedDraws)++;
+            uint32_t instanceCount = command.mArg[1];
+            uint32_t firstInstance = command.mArg[4];
+            pInstanceCounts->push_back( instanceCount );
+            const CPUTInstanceData *pInstances = (const CPUTInstanceData*)backend.Map( instanceBuffer );
+            std::vector<bool> seen( models.size(), false );
+            uint32_t run = ~0u;
+            for( uint32_t jj=0; jj<instanceCount; jj++ )
+            {
+                uint32_t model = (uint32_t)pInstances[firstInstance + jj].mWorld[12];
+                CPUT_CHECK( model < models.size() && !seen[model] );
+                if( model < models.size() )
+                {
+                    seen[model] = true;
+                    run = 0 == jj ? modelRuns[model] : run;
+                    CPUT_CHECK( modelRuns[model] == run );
+                }
+            }
+            CPUT_CHECK( ~0u != run && instanceCount == pRuns[run].mCount );
+        }
+    }
+    CPUT_CHECK( queue.GetStats().mInstancedDraws == *pInstancedDraws );
+    queue.ReleaseResources();
+    for( size_t ii=0; ii<models.size(); ii++ ) { delete models[ii]; }
+    for( uint32_t ii=0; ii<3; ii++ )           { delete pMeshes[ii]; }
+}
+
+//-----------------------------------------------------------------------------
+static void TestInstancing()
+{
+    uint32_t draws, instancedDraws;
+    std::vector<uint32_t> instanceCounts;
+
+    // A run of one mesh and material is one draw of all of it
+    const CPUTTestRun run = { 100, 0, 0, CPUT_RENDER_PASS_OPAQUE };
+    SubmitRuns( &run, 1, &draws, &instancedDraws, &instanceCounts );
+    CPUT_CHECK( 0 == draws && 1 == instancedDraws );
+    CPUT_CHECK( 1 == instanceCounts.size() && 100 == instanceCounts[0] );
+
+    // Runs split where the mesh or the pass changes.  A mesh or a material that can't be
+    // drawn instanced is drawn once per model, and so is a run of one.
+    const CPUTTestRun runs[6] =
+    {
+        { 30, 0, 0, CPUT_RENDER_PASS_OPAQUE },
+        { 20, 1, 0, CPUT_RENDER_PASS_OPAQUE },
+        { 10, 2, 0, CPUT_RENDER_PASS_OPAQUE },
+        { 15, 0, 1, CPUT_RENDER_PASS_OPAQUE },
+        { 25, 0, 0, CPUT_RENDER_PASS_SHADOW },
+        {  1, 1, 0, CPUT_RENDER_PASS_SHADOW },
+    };
+    SubmitRuns( runs, 6, &draws, &instancedDraws, &instanceCounts );
+    CPUT_CHECK( 10 + 15 + 1 == draws && 3 == instancedDraws );
+    CPUT_CHECK( 3 == instanceCounts.size() && 25 == instanceCounts[0] && 30 == instanceCounts[1] && 20 == instanceCounts[2] );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    CPUTThreadPool pool( 7 );
+    TestThreadCounts( &pool );
+    TestInstancing();
+    return CPUTTestResult();
+}
@@ -0,0 +1,372 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTShaderCache.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <stdlib.h>
+#include <map>
+#include <sstream>
+#ifdef _WIN32
+#   include <direct.h>
+#else
+#   include <sys/stat.h>
+#endif
+
+// CPUTShaderCache with a stand-in compiler: includes come from an in-memory file table,
+// and the "bytecode" is a hash of everything that should affect it.  The cache files
+// go in a directory under the working directory, which the test empties before and
+// after.  Also prints the cost of a warm lookup.
+
+static const char    *kCacheDirectory = "ShaderCacheTestFiles";
+static const uint32_t kShaderCount    = 20;
+
+//-----------------------------------------------------------------------------
+class TestCompiler : public CPUTShaderCompiler
+{
+public:
+    std::map<std::string, std::string> mFiles;
+    std::string                        mVersion;
+    uint32_t                           mCompiles;
+
+    TestCompiler() : mVersion("test 1"), mCompiles(0) {}
+
+    const char *GetVersion() const { return mVersion.c_str(); }
+
+    // Macros become #defines; #include "name" lines are replaced by mFiles[name]
+    bool Preprocess( const char *pSource, uint32_t sourceSize, const char * /*pSourceName*/, const CPUTShaderMacro *pMacros,
+                     std::string *pOutput, std::string *pErrors )
+    {
+        pOutput->clear();
+        for( const CPUTShaderMacro *pMacro = pMacros; pMacro && pMacro->mpName; pMacro++ )
+        {
+            *pOutput += std::string("#define ") + pMacro->mpName + " " + pMacro->mpDefinition + "\n";
+        }
+        std::istringstream lines( std::string( pSource, sourceSize ) );
+        std::string line;
+        while( std::getline( lines, line ) )
+        {
+            if( 0 == line.compare( 0, 10, "#include \"" ) )
+            {
+                std::string name = line.substr( 10, line.find( '"', 10 ) - 10 );
+                if( !mFiles.count( name ) )
+                {
+                    *pErrors = "can't open " + name;
+                    return false;
+                }
+                *pOutput += mFiles[name];
+            }
+            else
+            {
+                *pOutput += line + "\n";
+            }
+        }
+        return true;
+    }
+
+    bool Compile( const char *pSource, uint32_t sourceSize, const char *pSourceName, const CPUTShaderMacro *pMacros,
+                  const char *pEntryPoint, const char *pProfile, std::vector<uint8_t> *pBytecode, std::string *pErrors )
+    {
+        mCompiles++;
+        std::string preprocessed;
+        if( !Preprocess( pSource, sourceSize, pSourceName, pMacros, &preprocessed, pErrors ) )
+        {
+            return false;
+        }
+        if( std::string::npos == preprocessed.find( pEntryPoint ) )
+        {
+            *pErrors = std::string( "entry point not found: " ) + pEntryPoint;
+            return false;
+        }
+        std::string everything = preprocessed + pEntryPoint + pProfile + mVersion;
+        pBytecode->clear();
+        uint32_t hash = 2166136261u;
+        for( size_t ii=0; ii<everything.size(); ii++ )
+        {
+            hash = (hash ^ (uint8_t)everything[ii]) * 16777619u;
+            pBytecode->push_back( (uint8_t)(hash >> 8) );
+        }
+        return true;
+    }
+};
+
+//-----------------------------------------------------------------------------
+struct TestShaders
+{
+    TestCompiler             mCompiler;
+    CPUTShaderCache          mCache;
+    std::vector<std::string> mNames;
+    std::vector<std::string> mSources;
+
+    TestShaders()
+    {
+        std::string common = "float4 common( float4 x ) { return x*2; }\n";
+        for( uint32_t ii=0; ii<200; ii++ )
+        {
+            common += "// lighting helper\nfloat4 helper( float4 x ) { return x; }\n";
+        }
+        mCompiler.mFiles["common.fxh"] = common;
+        mCompiler.mFiles["other.fxh"]  = "float4 other() { return 1; }\n";
+        for( uint32_t ii=0; ii<kShaderCount; ii++ )
+        {
+            std::ostringstream name, source;
+            name << "shader" << ii << ".fx";
+            // Every fourth shader includes other.fxh
+            source << "#include \"" << ((ii % 4) ? "common.fxh" : "other.fxh") << "\"\n";
+            for( uint32_t jj=0; jj<150; jj++ )
+            {
+                source << "// body " << jj << " of shader " << ii << "\n";
+            }
+            source << "float4 VSMain( float4 p : POSITION ) : SV_Position { return common(p); }\n";
+            source << "float4 PSMain() : SV_Target { return 1; }\n";
+            mNames.push_back( name.str() );
+            mSources.push_back( source.str() );
+        }
+        mCache.SetCompiler( &mCompiler );
+        mCache.SetDirectory( kCacheDirectory );
+    }
+
+    // VSMain and PSMain of every shader: 2*kShaderCount lookups
+    bool GetAll( const CPUTShaderMacro *pMacros, std::vector< std::vector<uint8_t> > *pBytecode )
+    {
+        pBytecode->assign( 2*kShaderCount, std::vector<uint8_t>() );
+        bool ok = true;
+        for( uint32_t ii=0; ii<kShaderCount; ii++ )
+        {
+            ok = GetBytecode( ii, pMacros, "VSMain", "vs_4_0", &(*pBytecode)[2*ii] ) && ok;
+            ok = GetBytecode( ii, pMacros, "PSMain", "ps_4_0", &(*pBytecode)[2*ii+1] ) && ok;
+        }
+        return ok;
+    }
+
+    bool GetBytecode( uint32_t shader, const CPUTShaderMacro *pMacros, const char *pEntryPoint, const char *pProfile, std::vector<uint8_t> *pBytecode )
+    {
+        std::string errors;
+        return mCache.GetBytecode( mSources[shader].data(), (uint32_t)mSources[shader].size(), mNames[shader].c_str(), pMacros,
+                                   pEntryPoint, pProfile, pBytecode, &errors );
+    }
+
+    std::string GetPath( uint32_t shader, const CPUTShaderMacro *pMacros, const char *pEntryPoint, const char *pProfile )
+    {
+        std::string preprocessed, errors;
+        mCompiler.Preprocess( mSources[shader].data(), (uint32_t)mSources[shader].size(), mNames[shader].c_str(), pMacros, &preprocessed, &errors );
+        return mCache.GetPath( mCache.MakeKey( preprocessed, pMacros, pEntryPoint, pProfile ) );
+    }
+
+    void ResetCounts()
+    {
+        mCache.ResetStats();
+        mCompiler.mCompiles = 0;
+    }
+};
+
+static const CPUTShaderMacro sMacros[]       = { { "_CPUT", "1" }, { NULL, NULL } };
+static const CPUTShaderMacro sShadowMacros[] = { { "_CPUT", "1" }, { "SHADOWS", "1" }, { NULL, NULL } };
+
+// Every file any of the tests can write, so runs start from an empty cache
+//-----------------------------------------------------------------------------
+static void RemoveCacheFiles( TestShaders &shaders )
+{
+    const std::string savedOther   = shaders.mCompiler.mFiles["other.fxh"];
+    const std::string savedVersion = shaders.mCompiler.mVersion;
+    const char *others[2]   = { "float4 other() { return 1; }\n", "float4 other() { return 2; }\n" };
+    const char *versions[2] = { "test 1", "test 2" };
+    const CPUTShaderMacro *macroSets[2] = { sMacros, sShadowMacros };
+    for( uint32_t oo=0; oo<2; oo++ )
+    {
+        shaders.mCompiler.mFiles["other.fxh"] = others[oo];
+        for( uint32_t vv=0; vv<2; vv++ )
+        {
+            shaders.mCompiler.mVersion = versions[vv];
+            for( uint32_t mm=0; mm<2; mm++ )
+            {
+                for( uint32_t ii=0; ii<kShaderCount; ii++ )
+                {
+                    remove( shaders.GetPath( ii, macroSets[mm], "VSMain", "vs_4_0" ).c_str() );
+                    remove( shaders.GetPath( ii, macroSets[mm], "PSMain", "ps_4_0" ).c_str() );
+                }
+            }
+        }
+    }
+    shaders.mCompiler.mFiles["other.fxh"] = savedOther;
+    shaders.mCompiler.mVersion            = savedVersion;
+}
+
+//-----------------------------------------------------------------------------
+static std::string ReadFile( const std::string &path )
+{
+    std::string contents;
+    FILE *pFile = fopen( path.c_str(), "rb" );
+    if( pFile )
+    {
+        char buffer[4096];
+        size_t size;
+        while( 0 != (size = fread( buffer, 1, sizeof(buffer), pFile )) )
+        {
+            contents.append( buffer, size );
+        }
+        fclose( pFile );
+    }
+    return contents;
+}
+
+//-----------------------------------------------------------------------------
+static void WriteFile( const std::string &path, const std::string &contents )
+{
+    FILE *pFile = fopen( path.c_str(), "wb" );
+    if( pFile )
+    {
+        fwrite( contents.data(), 1, contents.size(), pFile );
+        fclose( pFile );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void TestCache( TestShaders &shaders )
+{
+    const uint32_t lookups = 2*kShaderCount;
+    std::vector< std::vector<uint8_t> > cold, warm, again;
+    CPUT_CHECK( shaders.GetAll( sMacros, &cold ) );
+    CPUT_CHECK( lookups == shaders.mCompiler.mCompiles );
+    CPUT_CHECK( 0 == shaders.mCache.GetStats().mHits );
+    CPUT_CHECK( 0 == shaders.mCache.GetStats().mWriteFailures );
+
+    // Everything comes from disk, unchanged
+    shaders.ResetCounts();
+    CPUT_CHECK( shaders.GetAll( sMacros, &warm ) );
+    CPUT_CHECK( 0 == shaders.mCompiler.mCompiles );
+    CPUT_CHECK( lookups == shaders.mCache.GetStats().mHits );
+    CPUT_CHECK( warm == cold );
+
+    // Editing an include recompiles exactly the shaders that include it
+    shaders.mCompiler.mFiles["other.fxh"] = "float4 other() { return 2; }\n";
+    shaders.ResetCounts();
+    CPUT_CHECK( shaders.GetAll( sMacros, &again ) );
+    CPUT_CHECK( 2*(kShaderCount/4) == shaders.mCompiler.mCompiles );
+    CPUT_CHECK( lookups - 2*(kShaderCount/4) == shaders.mCache.GetStats().mHits );
+    CPUT_CHECK( again[0] != cold[0] && again[2] == cold[2] );
+    shaders.mCompiler.mFiles["other.fxh"] = "float4 other() { return 1; }\n";
+
+    // Macros and the compiler version are part of the key
+    shaders.ResetCounts();
+    CPUT_CHECK( shaders.GetAll( sShadowMacros, &again ) );
+    CPUT_CHECK( lookups == shaders.mCompiler.mCompiles );
+    shaders.mCompiler.mVersion = "test 2";
+    shaders.ResetCounts();
+    CPUT_CHECK( shaders.GetAll( sMacros, &again ) );
+    CPUT_CHECK( lookups == shaders.mCompiler.mCompiles );
+    shaders.mCompiler.mVersion = "test 1";
+
+    // Back to the first state: all hits again
+    shaders.ResetCounts();
+    CPUT_CHECK( shaders.GetAll( sMacros, &again ) );
+    CPUT_CHECK( 0 == shaders.mCompiler.mCompiles );
+    CPUT_CHECK( again == cold );
+}
+
+// Damaged files are rejected, recompiled and rewritten
+//-----------------------------------------------------------------------------
+static void TestDamagedFiles( TestShaders &shaders )
+{
+    std::vector<uint8_t> expected, bytecode;
+    CPUT_CHECK( shaders.GetBytecode( 1, sMacros, "VSMain", "vs_4_0", &expected ) );
+    const std::string path     = shaders.GetPath( 1, sMacros, "VSMain", "vs_4_0" );
+    const std::string contents = ReadFile( path );
+    CPUT_CHECK( !contents.empty() );
+
+    std::string corrupt = contents;
+    corrupt[corrupt.size() - 3] ^= 0x55;
+    WriteFile( path, corrupt );
+    shaders.ResetCounts();
+    CPUT_CHECK( shaders.GetBytecode( 1, sMacros, "VSMain", "vs_4_0", &bytecode ) );
+    CPUT_CHECK( 1 == shaders.mCache.GetStats().mRejectedFiles && 1 == shaders.mCompiler.mCompiles );
+    CPUT_CHECK( bytecode == expected );
+
+    WriteFile( path, contents.substr( 0, contents.size() / 2 ) );
+    CPUT_CHECK( shaders.GetBytecode( 1, sMacros, "VSMain", "vs_4_0", &bytecode ) );
+    CPUT_CHECK( 2 == shaders.mCache.GetStats().mRejectedFiles && 2 == shaders.mCompiler.mCompiles );
+
+    // Another shader's file under this key
+    WriteFile( path, ReadFile( shaders.GetPath( 2, sMacros, "VSMain", "vs_4_0" ) ) );
+    CPUT_CHECK( shaders.GetBytecode( 1, sMacros, "VSMain", "vs_4_0", &bytecode ) );
+    CPUT_CHECK( 3 == shaders.mCache.GetStats().mRejectedFiles && 3 == shaders.mCompiler.mCompiles );
+
+    // Rewritten
+    CPUT_CHECK( shaders.GetBytecode( 1, sMacros, "VSMain", "vs_4_0", &bytecode ) );
+    CPUT_CHECK( 1 == shaders.mCache.GetStats().mHits && 3 == shaders.mCompiler.mCompiles );
+    CPUT_CHECK( bytecode == expected );
+}
+
+//-----------------------------------------------------------------------------
+static void TestErrors( TestShaders &shaders )
+{
+    std::vector<uint8_t> bytecode;
+    std::string errors;
+    const std::string source = "float4 nothing;\n";
+    CPUT_CHECK( !shaders.mCache.GetBytecode( source.data(), (uint32_t)source.size(), "bad.fx", sMacros, "VSMain", "vs_4_0", &bytecode, &errors ) );
+    CPUT_CHECK( !errors.empty() );
+
+    const std::string missing = "#include \"missing.fxh\"\nfloat4 VSMain() : SV_Position { return 0; }\n";
+    errors.clear();
+    shaders.ResetCounts();
+    CPUT_CHECK( !shaders.mCache.GetBytecode( missing.data(), (uint32_t)missing.size(), "missing.fx", sMacros, "VSMain", "vs_4_0", &bytecode, &errors ) );
+    CPUT_CHECK( !errors.empty() && 0 == shaders.mCompiler.mCompiles );
+
+    // No directory: always compile
+    CPUTShaderCache uncached;
+    uncached.SetCompiler( &shaders.mCompiler );
+    shaders.ResetCounts();
+    for( uint32_t ii=0; ii<2; ii++ )
+    {
+        CPUT_CHECK( uncached.GetBytecode( shaders.mSources[0].data(), (uint32_t)shaders.mSources[0].size(), shaders.mNames[0].c_str(), sMacros,
+                                          "VSMain", "vs_4_0", &bytecode, &errors ) );
+    }
+    CPUT_CHECK( 2 == shaders.mCompiler.mCompiles );
+}
+
+// Preprocessing, hashing and reading the file, per shader
+//-----------------------------------------------------------------------------
+static void TimeWarmLookups( TestShaders &shaders )
+{
+    std::vector< std::vector<uint8_t> > bytecode;
+    double best = 1e9;
+    for( uint32_t rr=0; rr<10; rr++ )
+    {
+        double start = CPUTFrameScheduler::GetSeconds();
+        shaders.GetAll( sMacros, &bytecode );
+        double seconds = CPUTFrameScheduler::GetSeconds() - start;
+        best = seconds < best ? seconds : best;
+    }
+    printf( "Warm lookup: %.1f us per shader (%u KB preprocessed)\n", best * 1e6 / (2*kShaderCount),
+        (uint32_t)(shaders.mSources[1].size() + shaders.mCompiler.mFiles["common.fxh"].size()) / 1024 );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+#ifdef _WIN32
+    _mkdir( kCacheDirectory );
+#else
+    mkdir( kCacheDirectory, 0755 );
+#endif
+    TestShaders shaders;
+    RemoveCacheFiles( shaders );
+    TestCache( shaders );
+    TestDamagedFiles( shaders );
+    TestErrors( shaders );
+    TimeWarmLookups( shaders );
+    RemoveCacheFiles( shaders );
+    return CPUTTestResult();
+}
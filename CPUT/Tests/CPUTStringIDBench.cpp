@@ -0,0 +1,204 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTStringID.h"
+#include "CPUTAllocator.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Load time, memory and bind time for a scene's material names, kept as strings (as
+// CPUTConfigBlock and the shader parameter tables did) and as CPUTStringIDs.  5000
+// materials, each with 16 parameter names out of 48 and 4 texture paths of its own.  Load
+// copies them into each material, lower-casing the strings; binding looks 12 shader
+// parameters up in each material's names, lower-casing a copy of each name as
+// GetValueByName() did.  This target is built with CPUT_COUNT_HEAP_ALLOCATIONS, so the
+// memory is what the heap handed out, plus the string table's own for the IDs.
+
+typedef std::basic_string<CPUTStringChar> CPUTTestString;
+
+static const uint32_t kMaterials      = 5000;
+static const uint32_t kNamesPerMat    = 16;
+static const uint32_t kPathsPerMat    = 4;
+static const uint32_t kParameterNames = 48;
+static const uint32_t kBoundNames     = 12;
+
+static volatile uint32_t sSink;
+
+//-----------------------------------------------------------------------------
+static CPUTTestString Str( const char *pString )
+{
+    CPUTTestString string;
+    for( const char *pChar = pString; *pChar; pChar++ )
+    {
+        string += (CPUTStringChar)(unsigned char)*pChar;
+    }
+    return string;
+}
+
+//-----------------------------------------------------------------------------
+static void Lower( CPUTTestString *pString )
+{
+    for( size_t ii=0; ii<pString->length(); ii++ )
+    {
+        CPUTStringChar c = (*pString)[ii];
+        (*pString)[ii] = (c >= 'A' && c <= 'Z') ? (CPUTStringChar)(c + ('a' - 'A')) : c;
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, double seconds, const CPUTHeapCounters &before, uint64_t tableBytes )
+{
+    CPUTHeapCounters after = CPUTGetHeapCounters();
+    printf( "  %-32s %7.2f ms  %8.0f allocations  %7.1f KB allocated\n", pName, seconds * 1000.0,
+            (double)(after.mAllocations - before.mAllocations), (after.mBytes - before.mBytes + tableBytes) / 1024.0 );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    // The scene, as the material files spell it
+    CPUTTestRandom random( 47 );
+    std::vector<CPUTTestString> parameterNames, sceneNames, scenePaths;
+    char name[128];
+    const char *pKinds[kPathsPerMat] = { "Diffuse", "Normal", "Specular", "Emissive" };
+    for( uint32_t ii=0; ii<kParameterNames; ii++ )
+    {
+        sprintf( name, "g_%sParameter%u", pKinds[ii % kPathsPerMat], ii );
+        parameterNames.push_back( Str( name ) );
+    }
+    for( uint32_t ii=0; ii<kMaterials; ii++ )
+    {
+        for( uint32_t jj=0; jj<kNamesPerMat; jj++ )
+        {
+            sceneNames.push_back( parameterNames[(ii + jj * 3) % kParameterNames] );
+        }
+        for( uint32_t jj=0; jj<kPathsPerMat; jj++ )
+        {
+            sprintf( name, "Media/Level/Textures/Props/prop_%05u_%s.dds", ii, pKinds[jj] );
+            scenePaths.push_back( Str( name ) );
+        }
+    }
+    std::vector<uint32_t> bound( kBoundNames );
+    for( uint32_t ii=0; ii<kBoundNames; ii++ )
+    {
+        bound[ii] = random.Index( kParameterNames );
+    }
+    printf( "  %u materials, %u names and %u texture paths each\n", kMaterials, kNamesPerMat, kPathsPerMat );
+
+    // Strings
+    {
+        CPUTHeapCounters before = CPUTGetHeapCounters();
+        double start = CPUTFrameScheduler::GetSeconds();
+        std::vector<CPUTTestString> *pNames = new std::vector<CPUTTestString>[kMaterials];
+        std::vector<CPUTTestString> *pPaths = new std::vector<CPUTTestString>[kMaterials];
+        for( uint32_t ii=0; ii<kMaterials; ii++ )
+        {
+            pNames[ii].reserve( kNamesPerMat );
+            pPaths[ii].reserve( kPathsPerMat );
+            for( uint32_t jj=0; jj<kNamesPerMat; jj++ )
+            {
+                pNames[ii].push_back( sceneNames[ii * kNamesPerMat + jj] );
+                Lower( &pNames[ii].back() );
+            }
+            for( uint32_t jj=0; jj<kPathsPerMat; jj++ )
+            {
+                pPaths[ii].push_back( scenePaths[ii * kPathsPerMat + jj] );
+                Lower( &pPaths[ii].back() );
+            }
+        }
+        Report( "Load, strings", CPUTFrameScheduler::GetSeconds() - start, before, 0 );
+
+        before = CPUTGetHeapCounters();
+        start  = CPUTFrameScheduler::GetSeconds();
+        uint32_t found = 0;
+        for( uint32_t ii=0; ii<kMaterials; ii++ )
+        {
+            for( uint32_t bb=0; bb<kBoundNames; bb++ )
+            {
+                CPUTTestString lower = parameterNames[bound[bb]];
+                Lower( &lower );
+                for( uint32_t jj=0; jj<kNamesPerMat; jj++ )
+                {
+                    if( pNames[ii][jj] == lower )
+                    {
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+        sSink = found;
+        Report( "Bind, strings", CPUTFrameScheduler::GetSeconds() - start, before, 0 );
+        delete [] pNames;
+        delete [] pPaths;
+    }
+
+    // IDs
+    {
+        CPUTHeapCounters before = CPUTGetHeapCounters();
+        CPUTStringTableStats tableBefore = CPUTStringTable::GetStats();
+        double start = CPUTFrameScheduler::GetSeconds();
+        std::vector<CPUTStringID> *pNames = new std::vector<CPUTStringID>[kMaterials];
+        std::vector<CPUTStringID> *pPaths = new std::vector<CPUTStringID>[kMaterials];
+        for( uint32_t ii=0; ii<kMaterials; ii++ )
+        {
+            pNames[ii].reserve( kNamesPerMat );
+            pPaths[ii].reserve( kPathsPerMat );
+            for( uint32_t jj=0; jj<kNamesPerMat; jj++ )
+            {
+                pNames[ii].push_back( CPUTStringTable::Intern( sceneNames[ii * kNamesPerMat + jj] ) );
+            }
+            for( uint32_t jj=0; jj<kPathsPerMat; jj++ )
+            {
+                pPaths[ii].push_back( CPUTStringTable::Intern( scenePaths[ii * kPathsPerMat + jj] ) );
+            }
+        }
+        double seconds = CPUTFrameScheduler::GetSeconds() - start;
+        // The table's arrays come from malloc(), which isn't counted
+        Report( "Load, IDs", seconds, before, CPUTStringTable::GetStats().mTableBytes - tableBefore.mTableBytes );
+
+        // Shader reflection interns the parameter names once
+        std::vector<CPUTStringID> boundIds( kBoundNames );
+        for( uint32_t bb=0; bb<kBoundNames; bb++ )
+        {
+            boundIds[bb] = CPUTStringTable::Intern( parameterNames[bound[bb]] );
+        }
+        before = CPUTGetHeapCounters();
+        start  = CPUTFrameScheduler::GetSeconds();
+        uint32_t found = 0;
+        for( uint32_t ii=0; ii<kMaterials; ii++ )
+        {
+            for( uint32_t bb=0; bb<kBoundNames; bb++ )
+            {
+                for( uint32_t jj=0; jj<kNamesPerMat; jj++ )
+                {
+                    if( pNames[ii][jj] == boundIds[bb] )
+                    {
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+        sSink = found;
+        Report( "Bind, IDs", CPUTFrameScheduler::GetSeconds() - start, before, 0 );
+        delete [] pNames;
+        delete [] pPaths;
+    }
+    return 0;
+}
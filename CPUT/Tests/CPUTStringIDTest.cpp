@@ -0,0 +1,239 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTStringID.h"
+#include "CPUTThreadPool.h"
+#include "CPUTTest.h"
+#include <stdio.h>
+#include <vector>
+
+// CPUTStringTable: that equal strings get one ID and different ones don't, ASCII case
+// folding (and no folding outside ASCII), Find() of strings never interned, that IDs and
+// string pointers survive the table growing, and interning from several threads at once.
+// Built twice, as the narrow build and with UNICODE (as CPUT's DX11 builds are), where
+// names widened from the narrow strings D3D reflection gives must find the same IDs.
+
+typedef std::basic_string<CPUTStringChar> CPUTTestString;
+
+// Widens ASCII, as s2ws() does
+//-----------------------------------------------------------------------------
+static CPUTTestString Str( const char *pString )
+{
+    CPUTTestString string;
+    for( const char *pChar = pString; *pChar; pChar++ )
+    {
+        string += (CPUTStringChar)(unsigned char)*pChar;
+    }
+    return string;
+}
+
+//-----------------------------------------------------------------------------
+static void TestIntern()
+{
+    CPUTStringID diffuse = CPUTStringTable::Intern( Str( "g_DiffuseTexture" ) );
+    CPUTStringID normal  = CPUTStringTable::Intern( Str( "g_NormalTexture" ) );
+    CPUT_CHECK( CPUT_STRING_ID_NONE != diffuse && CPUT_STRING_ID_NONE != normal && diffuse != normal );
+    CPUT_CHECK( diffuse == CPUTStringTable::Intern( Str( "g_DiffuseTexture" ).c_str() ) );
+    CPUT_CHECK( Str( "g_DiffuseTexture" ) == CPUTStringTable::GetString( diffuse ) );
+    CPUT_CHECK( 16 == CPUTStringTable::GetLength( diffuse ) );
+
+    // A length, not a terminator, ends the string
+    CPUTTestString path = Str( "g_DiffuseTextureSRGB" );
+    CPUT_CHECK( diffuse == CPUTStringTable::Intern( path.c_str(), 16 ) );
+    CPUTStringID srgb = CPUTStringTable::Intern( path );
+    CPUT_CHECK( srgb != diffuse && 20 == CPUTStringTable::GetLength( srgb ) );
+    CPUT_CHECK( 0 == CPUTStringTable::GetString( diffuse )[16] );
+
+    // Prefixes, suffixes and a character apart are all different strings
+    const char *pNames[6] = { "$shadow_depth", "$shadow_dept", "shadow_depth", "$shadow_depth ", "$shadow_depti", "$shadow-depth" };
+    std::vector<CPUTStringID> ids;
+    for( uint32_t ii=0; ii<6; ii++ )
+    {
+        ids.push_back( CPUTStringTable::Intern( Str( pNames[ii] ) ) );
+        for( uint32_t jj=0; jj<ii; jj++ )
+        {
+            CPUT_CHECK( ids[ii] != ids[jj] );
+        }
+    }
+
+    // The empty string is CPUT_STRING_ID_NONE
+    CPUT_CHECK( CPUT_STRING_ID_NONE == CPUTStringTable::Intern( Str( "" ) ) );
+    CPUT_CHECK( CPUT_STRING_ID_NONE == CPUTStringTable::Intern( path.c_str(), 0 ) );
+    CPUT_CHECK( 0 == CPUTStringTable::GetString( CPUT_STRING_ID_NONE )[0] && 0 == CPUTStringTable::GetLength( CPUT_STRING_ID_NONE ) );
+    CPUT_CHECK( CPUTStringTable::Hash( path.c_str(), 0 ) == CPUTStringTable::GetHash( CPUT_STRING_ID_NONE ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestCaseFolding()
+{
+    // The first spelling interned is the one kept
+    CPUTStringID id = CPUTStringTable::Intern( Str( "Textures/Brick_Wall.DDS" ) );
+    CPUT_CHECK( id == CPUTStringTable::Intern( Str( "textures/brick_wall.dds" ) ) );
+    CPUT_CHECK( id == CPUTStringTable::Intern( Str( "TEXTURES/BRICK_WALL.DDS" ) ) );
+    CPUT_CHECK( id == CPUTStringTable::Find( Str( "tExTuReS/bRiCk_WaLl.dDs" ) ) );
+    CPUT_CHECK( Str( "Textures/Brick_Wall.DDS" ) == CPUTStringTable::GetString( id ) );
+
+    uint64_t hash = CPUTStringTable::GetHash( id );
+    CPUTTestString upper = Str( "TEXTURES/BRICK_WALL.DDS" );
+    CPUT_CHECK( hash == CPUTStringTable::Hash( upper.data(), upper.length() ) );
+
+    // Only A-Z fold: the characters either side of them, and of a-z, don't
+    const char *pPairs[4][2] = { { "name@", "name`" }, { "name[", "name{" }, { "name_", "name\x7f" }, { "a", "A" } };
+    for( uint32_t ii=0; ii<3; ii++ )
+    {
+        CPUT_CHECK( CPUTStringTable::Intern( Str( pPairs[ii][0] ) ) != CPUTStringTable::Intern( Str( pPairs[ii][1] ) ) );
+    }
+    CPUT_CHECK( CPUTStringTable::Intern( Str( pPairs[3][0] ) ) == CPUTStringTable::Intern( Str( pPairs[3][1] ) ) );
+
+    // Nor do letters outside ASCII, as with _wcsicmp() in the C locale
+    CPUTTestString grave = Str( "\xc0" "clat" ), graveLower = Str( "\xe0" "clat" );
+    CPUT_CHECK( CPUTStringTable::Intern( grave ) != CPUTStringTable::Intern( graveLower ) );
+    CPUT_CHECK( grave == CPUTStringTable::GetString( CPUTStringTable::Find( grave ) ) );
+}
+
+//-----------------------------------------------------------------------------
+static void TestWide()
+{
+#if defined(UNICODE) || defined(_UNICODE)
+    // Names from D3D reflection are narrow and widened before they're interned
+    CPUTStringID id = CPUTStringTable::Intern( L"g_SpecularTexture" );
+    CPUT_CHECK( id == CPUTStringTable::Find( Str( "g_specularTexture" ) ) );
+    CPUTTestString srgb = Str( "g_SpecularTexture" ) + L"sRGB";
+    CPUT_CHECK( id == CPUTStringTable::Intern( srgb.c_str(), 17 ) );
+
+    // Characters past 0xff are kept whole, not truncated to a byte
+    const wchar_t pWide[]  = { 0x0141, 0x00f3, 0x0064, 0x017a, 0 };   // L with stroke, o acute, d, z acute
+    const wchar_t pByte[]  = { 0x0041, 0x00f3, 0x0064, 0x007a, 0 };   // Cut to bytes
+    CPUTStringID wide = CPUTStringTable::Intern( pWide );
+    CPUT_CHECK( wide != CPUTStringTable::Intern( pByte ) );
+    CPUT_CHECK( CPUTTestString( pWide ) == CPUTStringTable::GetString( wide ) );
+    CPUT_CHECK( 4 == CPUTStringTable::GetLength( wide ) );
+#else
+    CPUT_CHECK( sizeof(CPUTStringChar) == sizeof(char) );
+    // Bytes past 0x7f are kept as they are, whatever char's sign
+    CPUTTestString utf8 = Str( "\xc5\x81\xc3\xb3" "d\xc5\xba" );
+    CPUTStringID id = CPUTStringTable::Intern( utf8 );
+    CPUT_CHECK( utf8 == CPUTStringTable::GetString( id ) && 7 == CPUTStringTable::GetLength( id ) );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+static void TestFind()
+{
+    CPUTStringTableStats before = CPUTStringTable::GetStats();
+    CPUT_CHECK( CPUT_STRING_ID_NONE == CPUTStringTable::Find( Str( "never interned" ) ) );
+    CPUT_CHECK( CPUT_STRING_ID_NONE == CPUTStringTable::Find( Str( "" ) ) );
+    CPUTStringTableStats after = CPUTStringTable::GetStats();
+    CPUT_CHECK( before.mStrings == after.mStrings && before.mStringBytes == after.mStringBytes );
+    CPUT_CHECK( before.mFinds + 2 == after.mFinds && before.mInterns == after.mInterns );
+
+    CPUTStringID id = CPUTStringTable::Intern( Str( "never interned" ) );
+    after = CPUTStringTable::GetStats();
+    CPUT_CHECK( id == CPUTStringTable::Find( Str( "Never Interned" ) ) );
+    CPUT_CHECK( before.mStrings + 1 == after.mStrings );
+    CPUT_CHECK( before.mStringBytes + 15 * sizeof(CPUTStringChar) == after.mStringBytes );
+    CPUT_CHECK( before.mInterns + 1 == after.mInterns );
+}
+
+// Enough strings to grow the entries and rehash the index several times
+//-----------------------------------------------------------------------------
+static void TestGrowth()
+{
+    static const uint32_t kCount = 50000;
+    std::vector<CPUTStringID>          ids;
+    std::vector<const CPUTStringChar*> strings;
+    char name[64];
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        sprintf( name, "Level/Props/prop_%05u.mdl", ii );
+        ids.push_back( CPUTStringTable::Intern( Str( name ) ) );
+        strings.push_back( CPUTStringTable::GetString( ids[ii] ) );
+        if( ii )
+        {
+            CPUT_CHECK( ids[ii] == ids[ii - 1] + 1 );
+        }
+    }
+    CPUTStringTableStats stats = CPUTStringTable::GetStats();
+    CPUT_CHECK( stats.mStrings >= kCount );
+    CPUT_CHECK( stats.mTableBytes >= (uint64_t)kCount * (8 + 2 * sizeof(CPUTStringID)) );
+
+    uint32_t wrong = 0;
+    for( uint32_t ii=0; ii<kCount; ii++ )
+    {
+        sprintf( name, "LEVEL/PROPS/PROP_%05u.MDL", ii );
+        wrong += ids[ii] != CPUTStringTable::Find( Str( name ) );
+        wrong += strings[ii] != CPUTStringTable::GetString( ids[ii] );
+    }
+    CPUT_CHECK( 0 == wrong );
+    CPUT_CHECK( stats.mStrings == CPUTStringTable::GetStats().mStrings );
+}
+
+// Each task interns the same names, half of them spelled in upper case
+//-----------------------------------------------------------------------------
+class CPUTTestInternTask : public CPUTTask
+{
+public:
+    static const uint32_t kNames = 4000;
+    std::vector<CPUTStringID> mIds[8];
+
+    void Execute( uint32_t taskIndex, uint32_t /*threadIndex*/ )
+    {
+        char name[64];
+        mIds[taskIndex].resize( kNames );
+        for( uint32_t ii=0; ii<kNames; ii++ )
+        {
+            // Start each task somewhere else, so they race to add different names
+            uint32_t index = (ii + taskIndex * 500) % kNames;
+            sprintf( name, (index + taskIndex) & 1 ? "THREADED_%u" : "threaded_%u", index );
+            mIds[taskIndex][index] = CPUTStringTable::Intern( Str( name ) );
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+static void TestThreads()
+{
+    CPUTThreadPool pool( 3 );
+    CPUTTestInternTask task;
+    uint32_t strings = CPUTStringTable::GetStats().mStrings;
+    pool.ParallelFor( &task, 8 );
+    CPUT_CHECK( strings + CPUTTestInternTask::kNames == CPUTStringTable::GetStats().mStrings );
+
+    uint32_t wrong = 0;
+    char name[64];
+    for( uint32_t ii=0; ii<CPUTTestInternTask::kNames; ii++ )
+    {
+        sprintf( name, "Threaded_%u", ii );
+        CPUTStringID id = CPUTStringTable::Find( Str( name ) );
+        wrong += CPUT_STRING_ID_NONE == id;
+        for( uint32_t tt=0; tt<8; tt++ )
+        {
+            wrong += task.mIds[tt][ii] != id;
+        }
+    }
+    CPUT_CHECK( 0 == wrong );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestIntern();
+    TestCaseFolding();
+    TestWide();
+    TestFind();
+    TestGrowth();
+    TestThreads();
+    return CPUTTestResult();
+}
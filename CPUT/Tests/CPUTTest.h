@@ -0,0 +1,51 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTEST_H__
+#define __CPUTTEST_H__
+
+// Checks for the tests in this directory.  A failed check prints where it is and the
+// test carries on; main() returns CPUTTestResult(), which is nonzero if any failed.
+#include <stdio.h>
+#include <math.h>
+
+static int sCPUTTestFailures = 0;
+
+#define CPUT_CHECK(condition) \
+    do { if( !(condition) ) { sCPUTTestFailures++; printf( "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition ); } } while(0)
+
+#define CPUT_CHECK_NEAR(a, b, tolerance) \
+    do { double _a = (a), _b = (b); if( !(fabs( _a - _b ) <= (tolerance)) ) { sCPUTTestFailures++; printf( "%s(%d): check failed: %s (%g) is not within %g of %s (%g)\n", __FILE__, __LINE__, #a, _a, (double)(tolerance), #b, _b ); } } while(0)
+
+//-----------------------------------------------------------------------------
+inline int CPUTTestResult()
+{
+    printf( "%s (%d failures)\n", sCPUTTestFailures ? "FAILED" : "passed", sCPUTTestFailures );
+    return sCPUTTestFailures ? 1 : 0;
+}
+
+// Deterministic pseudo-random numbers, the same on every platform
+//-----------------------------------------------------------------------------
+struct CPUTTestRandom
+{
+    unsigned int mState;
+
+    CPUTTestRandom( unsigned int seed = 1 ) : mState(seed) {}
+    unsigned int Next()                   { mState = mState * 1664525u + 1013904223u; return mState >> 8; }
+    float        Float( float lo, float hi ) { return lo + (hi - lo) * (float)Next() / 16777216.0f; }
+    unsigned int Index( unsigned int count ) { return Next() % count; }
+};
+
+#endif // __CPUTTEST_H__
@@ -0,0 +1,448 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTextureFile.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <algorithm>
+
+// CPUTTextureFile on synthetic DDS and KTX files.  Each file is built here with every
+// subresource filled with its own bytes, and the offsets the parser finds are checked
+// against where they were written.  Then every truncation and many corruptions of the
+// headers, which must fail or describe data inside the buffer.
+
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+const uint32_t DDPF_ALPHA       = 0x2;
+const uint32_t DDPF_FOURCC      = 0x4;
+const uint32_t DDPF_RGB         = 0x40;
+const uint32_t DDPF_LUMINANCE   = 0x20000;
+const uint32_t DDS_CUBE         = 0xFE00;   // DDSCAPS2_CUBEMAP and all six faces
+const uint32_t DDS_VOLUME       = 0x200000;
+
+//-----------------------------------------------------------------------------
+struct CPUTTestTextureFile
+{
+    std::vector<uint8_t>  mData;
+    std::vector<uint64_t> mOffsets;      // Where each subresource was written, mip + slice * mipCount
+    std::vector<uint32_t> mSizes;
+    uint32_t              mMipCount;
+    uint32_t              mArraySize;
+    uint32_t              mHeaderSize;   // Bytes before the first subresource
+
+    void Put( uint32_t value )
+    {
+        for( uint32_t ii=0; ii<4; ii++ )
+        {
+            mData.push_back( (uint8_t)(value >> (ii * 8)) );
+        }
+    }
+    void PutSubresource( uint32_t mip, uint32_t slice, uint32_t size )
+    {
+        mOffsets[mip + slice * mMipCount] = mData.size();
+        mSizes[mip + slice * mMipCount]   = size;
+        for( uint32_t ii=0; ii<size; ii++ )
+        {
+            mData.push_back( (uint8_t)(mip * 31 + slice * 7 + ii) );
+        }
+    }
+    void Begin( uint32_t mipCount, uint32_t arraySize )
+    {
+        mMipCount  = mipCount;
+        mArraySize = arraySize;
+        mOffsets.assign( mipCount * arraySize, 0 );
+        mSizes.assign( mipCount * arraySize, 0 );
+        mHeaderSize = (uint32_t)mData.size();
+    }
+};
+
+// Bytes in one mip level of one slice, worked out independently of the parser
+//-----------------------------------------------------------------------------
+static uint32_t LevelSize( uint32_t blockBytes, bool compressed, uint32_t width, uint32_t height, uint32_t depth, uint32_t mip, uint32_t rowAlignment )
+{
+    width  = (width  >> mip) ? (width  >> mip) : 1;
+    height = (height >> mip) ? (height >> mip) : 1;
+    depth  = (depth  >> mip) ? (depth  >> mip) : 1;
+    if( compressed )
+    {
+        return ((width + 3) / 4) * ((height + 3) / 4) * blockBytes * depth;
+    }
+    uint32_t rowPitch = (width * blockBytes + rowAlignment - 1) / rowAlignment * rowAlignment;
+    return rowPitch * height * depth;
+}
+
+// The magic and legacy header.  pixelFormat is flags, FourCC, bit count and the R, G, B, A masks.
+//-----------------------------------------------------------------------------
+static void PutDDSHeader( CPUTTestTextureFile *pFile, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount, const uint32_t *pPixelFormat, uint32_t caps2 )
+{
+    pFile->Put( 0x20534444 ); // "DDS "
+    uint32_t header[31] = { 0 };
+    header[0]  = 124;
+    header[1]  = 0x1007 | (mipCount > 1 ? DDSD_MIPMAPCOUNT : 0);
+    header[2]  = height;
+    header[3]  = width;
+    header[5]  = depth;
+    header[6]  = mipCount;
+    header[18] = 32;
+    memcpy( &header[19], pPixelFormat, 7 * sizeof(uint32_t) );
+    header[26] = 0x1000;
+    header[27] = caps2;
+    for( uint32_t ii=0; ii<31; ii++ )
+    {
+        pFile->Put( header[ii] );
+    }
+}
+
+// Every mip of slice 0, then of slice 1, ...
+//-----------------------------------------------------------------------------
+static void PutDDSData( CPUTTestTextureFile *pFile, uint32_t blockBytes, bool compressed, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount, uint32_t arraySize )
+{
+    pFile->Begin( mipCount, arraySize );
+    for( uint32_t slice=0; slice<arraySize; slice++ )
+    {
+        for( uint32_t mip=0; mip<mipCount; mip++ )
+        {
+            pFile->PutSubresource( mip, slice, LevelSize( blockBytes, compressed, width, height, depth, mip, 1 ) );
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static CPUTTestTextureFile MakeLegacyDDS( uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount, const uint32_t *pPixelFormat, uint32_t caps2, uint32_t blockBytes, bool compressed )
+{
+    CPUTTestTextureFile file;
+    PutDDSHeader( &file, width, height, depth, mipCount, pPixelFormat, caps2 );
+    PutDDSData( &file, blockBytes, compressed, width, height, depth, mipCount, (caps2 & DDS_CUBE) ? 6 : 1 );
+    return file;
+}
+
+// dimension is the D3D10_RESOURCE_DIMENSION: 2 for 1D, 3 for 2D, 4 for 3D
+//-----------------------------------------------------------------------------
+static CPUTTestTextureFile MakeDX10DDS( uint32_t format, uint32_t dimension, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount, uint32_t arraySize, bool cube, uint32_t blockBytes, bool compressed )
+{
+    CPUTTestTextureFile file;
+    const uint32_t pixelFormat[7] = { DDPF_FOURCC, 0x30315844 /* DX10 */, 0, 0, 0, 0, 0 };
+    PutDDSHeader( &file, width, height, depth, mipCount, pixelFormat, 0 );
+    file.Put( format );
+    file.Put( dimension );
+    file.Put( cube ? 0x4 : 0 );
+    file.Put( arraySize );
+    file.Put( 0 );
+    PutDDSData( &file, blockBytes, compressed, width, 2 == dimension ? 1 : height, depth, mipCount, arraySize * (cube ? 6 : 1) );
+    return file;
+}
+
+// Mip after mip: the image size, every face of every array element, padding
+//-----------------------------------------------------------------------------
+static CPUTTestTextureFile MakeKTX( uint32_t internalFormat, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount, uint32_t arrayElements, uint32_t faces, uint32_t blockBytes, bool compressed )
+{
+    static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    CPUTTestTextureFile file;
+    file.mData.assign( identifier, identifier + 12 );
+    const uint32_t keyValueBytes = 24;
+    const uint32_t header[13] = { 0x04030201, 0, 1, 0, internalFormat, 0, width, height, depth, arrayElements, faces, mipCount, keyValueBytes };
+    for( uint32_t ii=0; ii<13; ii++ )
+    {
+        file.Put( header[ii] );
+    }
+    for( uint32_t ii=0; ii<keyValueBytes; ii++ )
+    {
+        file.mData.push_back( 'k' );
+    }
+    uint32_t slices = (arrayElements ? arrayElements : 1) * faces;
+    file.Begin( mipCount, slices );
+    for( uint32_t mip=0; mip<mipCount; mip++ )
+    {
+        uint32_t levelSize = LevelSize( blockBytes, compressed, width, height ? height : 1, depth ? depth : 1, mip, 4 );
+        file.Put( (6 == faces && 0 == arrayElements) ? levelSize : levelSize * slices );
+        for( uint32_t slice=0; slice<slices; slice++ )
+        {
+            file.PutSubresource( mip, slice, levelSize );
+        }
+        while( file.mData.size() & 3 )
+        {
+            file.mData.push_back( 0 );
+        }
+    }
+    return file;
+}
+
+// Parses the file from a heap block of exactly its size, so that tools like AddressSanitizer
+// would catch any read past the end
+//-----------------------------------------------------------------------------
+static bool Parse( CPUTTextureFile *pParser, const std::vector<uint8_t> &data, size_t size, std::vector<uint8_t> *pCopy )
+{
+    pCopy->assign( data.begin(), data.begin() + size );
+    return pParser->Parse( size ? &(*pCopy)[0] : NULL, size );
+}
+
+// A successful parse only describes bytes inside the buffer, and they can all be copied
+//-----------------------------------------------------------------------------
+static void CheckInBounds( const CPUTTextureFile &parser, uint64_t size )
+{
+    CPUT_CHECK( parser.GetMipCount() >= 1 && parser.GetMipCount() <= 32 && parser.GetArraySize() >= 1 );
+    uint64_t end = 0;
+    for( uint32_t slice=0; slice<parser.GetArraySize(); slice++ )
+    {
+        for( uint32_t mip=0; mip<parser.GetMipCount(); mip++ )
+        {
+            const CPUTTextureSubresource &subresource = parser.GetSubresource( mip, slice );
+            CPUT_CHECK( subresource.mOffset + subresource.mSize <= size );
+            end = std::max( end, subresource.mOffset + subresource.mSize );
+        }
+    }
+    if( end <= size && end <= 64 * 1024 * 1024 )
+    {
+        for( uint32_t mip=0; mip<parser.GetMipCount(); mip++ )
+        {
+            std::vector<uint8_t> level( (size_t)parser.GetMipSize( mip ) + 1 );
+            parser.CopyMip( mip, &level[0] );
+        }
+    }
+}
+
+// Parses a well-formed file and checks everything against how it was built.  Then every
+// shorter length must fail, and corrupting header bytes must fail or stay in bounds.
+//-----------------------------------------------------------------------------
+static void CheckFile( const char *pName, const CPUTTestTextureFile &file, CPUTTextureFile::CONTAINER container, CPUTTextureFile::DIMENSION dimension,
+                       uint32_t format, uint32_t width, uint32_t height, uint32_t depth, bool cube )
+{
+    std::vector<uint8_t> copy;
+    CPUTTextureFile parser;
+    bool parsed = Parse( &parser, file.mData, file.mData.size(), &copy );
+    CPUT_CHECK( parsed );
+    if( !parsed )
+    {
+        printf( "  %s: %s\n", pName, parser.GetError() );
+        return;
+    }
+    CPUT_CHECK( container == parser.GetContainer() && dimension == parser.GetDimension() && format == parser.GetFormat() );
+    CPUT_CHECK( width == parser.GetWidth() && height == parser.GetHeight() && depth == parser.GetDepth() );
+    CPUT_CHECK( file.mMipCount == parser.GetMipCount() && file.mArraySize == parser.GetArraySize() && cube == parser.IsCubeMap() );
+    CPUT_CHECK( 0 == *parser.GetError() );
+    for( uint32_t mip=0; mip<file.mMipCount; mip++ )
+    {
+        uint64_t mipSize = 0;
+        std::vector<uint8_t> expected;
+        for( uint32_t slice=0; slice<file.mArraySize; slice++ )
+        {
+            uint32_t index = mip + slice * file.mMipCount;
+            const CPUTTextureSubresource &subresource = parser.GetSubresource( mip, slice );
+            CPUT_CHECK( file.mOffsets[index] == subresource.mOffset && file.mSizes[index] == subresource.mSize );
+            CPUT_CHECK( subresource.mWidth == std::max( width >> mip, 1u ) && subresource.mHeight == std::max( height >> mip, 1u ) );
+            CPUT_CHECK( subresource.mDepth == std::max( depth >> mip, 1u ) && subresource.mSlicePitch * subresource.mDepth == subresource.mSize );
+            CPUT_CHECK( parser.GetSubresourceData( mip, slice ) == &copy[0] + file.mOffsets[index] );
+            mipSize += subresource.mSize;
+            expected.insert( expected.end(), file.mData.begin() + file.mOffsets[index], file.mData.begin() + file.mOffsets[index] + file.mSizes[index] );
+        }
+        CPUT_CHECK( mipSize == parser.GetMipSize( mip ) );
+        std::vector<uint8_t> copied( (size_t)mipSize );
+        parser.CopyMip( mip, &copied[0] );
+        CPUT_CHECK( copied == expected );
+    }
+
+    for( size_t size=0; size<file.mData.size(); size++ )
+    {
+        CPUTTextureFile truncated;
+        CPUT_CHECK( !Parse( &truncated, file.mData, size, &copy ) && 0 != *truncated.GetError() );
+    }
+
+    CPUTTestRandom random( (uint32_t)file.mData.size() );
+    std::vector<uint8_t> corrupt;
+    for( uint32_t ii=0; ii<3000; ii++ )
+    {
+        corrupt = file.mData;
+        for( uint32_t flips=1 + random.Index( 3 ); flips--; )
+        {
+            uint32_t offset = random.Index( file.mHeaderSize );
+            corrupt[offset] = (ii & 1) ? (uint8_t)random.Next() : (uint8_t)(corrupt[offset] ^ (1u << random.Index( 8 )));
+        }
+        // Sometimes cut the data short as well
+        size_t size = (ii % 3) ? corrupt.size() : file.mHeaderSize + random.Index( (uint32_t)corrupt.size() - file.mHeaderSize );
+        CPUTTextureFile parser;
+        if( Parse( &parser, corrupt, size, &copy ) )
+        {
+            CheckInBounds( parser, size );
+        }
+        else
+        {
+            CPUT_CHECK( 0 != *parser.GetError() );
+        }
+    }
+}
+
+// Formats, cube maps, volumes and arrays in both DDS headers, with the mip tails at 4x4 and below
+//-----------------------------------------------------------------------------
+static void TestDDS()
+{
+    const CPUTTextureFile::CONTAINER dds = CPUTTextureFile::CONTAINER_DDS;
+    const uint32_t dxt1[7]  = { DDPF_FOURCC, 0x31545844, 0, 0, 0, 0, 0 };
+    const uint32_t dxt5[7]  = { DDPF_FOURCC, 0x35545844, 0, 0, 0, 0, 0 };
+    const uint32_t bc5s[7]  = { DDPF_FOURCC, 0x53354342, 0, 0, 0, 0, 0 };
+    const uint32_t rgba[7]  = { DDPF_RGB, 0, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 };
+    const uint32_t bgra[7]  = { DDPF_RGB, 0, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 };
+    const uint32_t b5g6r5[7] = { DDPF_RGB, 0, 16, 0xF800, 0x07E0, 0x001F, 0 };
+    const uint32_t lum8[7]  = { DDPF_LUMINANCE, 0, 8, 0xFF, 0, 0, 0 };
+    const uint32_t alpha8[7] = { DDPF_ALPHA, 0, 8, 0, 0, 0, 0xFF };
+    const uint32_t half4[7] = { DDPF_FOURCC, 113, 0, 0, 0, 0, 0 }; // D3DFMT_A16B16G16R16F
+
+    // BC1 with a full chain: 4x4, 2x2 and 1x1 are each one 8 byte block
+    CPUTTestTextureFile file = MakeLegacyDDS( 256, 256, 1, 9, dxt1, 0, 8, true );
+    CPUT_CHECK( 8 == file.mSizes[6] && 8 == file.mSizes[7] && 8 == file.mSizes[8] && 32768 == file.mSizes[0] );
+    CheckFile( "DXT1", file, dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC1_UNORM, 256, 256, 1, false );
+
+    // Not a power of two, and not a multiple of the block size
+    CheckFile( "DXT5", MakeLegacyDDS( 100, 60, 1, 7, dxt5, 0, 16, true ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC3_UNORM, 100, 60, 1, false );
+    CheckFile( "BC5S", MakeLegacyDDS( 30, 30, 1, 1, bc5s, 0, 16, true ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC5_SNORM, 30, 30, 1, false );
+    CheckFile( "RGBA", MakeLegacyDDS( 33, 17, 1, 6, rgba, 0, 4, false ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_R8G8B8A8_UNORM, 33, 17, 1, false );
+    CheckFile( "B5G6R5", MakeLegacyDDS( 7, 3, 1, 3, b5g6r5, 0, 2, false ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_B5G6R5_UNORM, 7, 3, 1, false );
+    CheckFile( "A8", MakeLegacyDDS( 5, 5, 1, 1, alpha8, 0, 1, false ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_A8_UNORM, 5, 5, 1, false );
+    CheckFile( "A16B16G16R16F", MakeLegacyDDS( 8, 8, 1, 4, half4, 0, 8, false ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_R16G16B16A16_FLOAT, 8, 8, 1, false );
+    CheckFile( "BGRA cube", MakeLegacyDDS( 64, 64, 1, 7, bgra, DDS_CUBE, 4, false ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_B8G8R8A8_UNORM, 64, 64, 1, true );
+    CheckFile( "L8 volume", MakeLegacyDDS( 16, 16, 8, 5, lum8, DDS_VOLUME, 1, false ), dds, CPUTTextureFile::DIMENSION_3D, CPUT_TEXTURE_FORMAT_R8_UNORM, 16, 16, 8, false );
+
+    // DX10 headers: an array, a cube array, 1D and 3D
+    CheckFile( "BC7 array", MakeDX10DDS( CPUT_TEXTURE_FORMAT_BC7_UNORM_SRGB, 3, 128, 64, 1, 8, 3, false, 16, true ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC7_UNORM_SRGB, 128, 64, 1, false );
+    CheckFile( "BC6H cube array", MakeDX10DDS( CPUT_TEXTURE_FORMAT_BC6H_UF16, 3, 32, 32, 1, 6, 2, true, 16, true ), dds, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC6H_UF16, 32, 32, 1, true );
+    CheckFile( "R32G32B32A32 1D", MakeDX10DDS( CPUT_TEXTURE_FORMAT_R32G32B32A32_FLOAT, 2, 32, 1, 1, 6, 1, false, 16, false ), dds, CPUTTextureFile::DIMENSION_1D, CPUT_TEXTURE_FORMAT_R32G32B32A32_FLOAT, 32, 1, 1, false );
+    CheckFile( "R16G16 3D", MakeDX10DDS( CPUT_TEXTURE_FORMAT_R16G16_FLOAT, 4, 8, 4, 4, 4, 1, false, 4, false ), dds, CPUTTextureFile::DIMENSION_3D, CPUT_TEXTURE_FORMAT_R16G16_FLOAT, 8, 4, 4, false );
+
+    // Headers that parse but describe something unsupported or impossible
+    struct { const char *mpName; CPUTTestTextureFile mFile; } bad[] =
+    {
+        { "partial cube",        MakeLegacyDDS( 8, 8, 1, 1, bgra, 0x0600, 4, false ) },
+        { "unknown FourCC",      MakeLegacyDDS( 8, 8, 1, 1, half4, 0, 8, false ) },
+        { "cube not square",     MakeLegacyDDS( 16, 8, 1, 1, bgra, DDS_CUBE, 4, false ) },
+        { "too many mips",       MakeLegacyDDS( 4, 4, 1, 4, dxt1, 0, 8, true ) },
+        { "too wide",            MakeLegacyDDS( 16385, 1, 1, 1, alpha8, 0, 1, false ) },
+        { "zero height",         MakeLegacyDDS( 4, 0, 1, 1, dxt1, 0, 8, true ) },
+        { "DX10 unsupported",    MakeDX10DDS( 107 /* AYUV */, 3, 4, 4, 1, 1, 1, false, 4, false ) },
+        { "DX10 dimension",      MakeDX10DDS( CPUT_TEXTURE_FORMAT_R8_UNORM, 5, 4, 4, 1, 1, 1, false, 1, false ) },
+        { "DX10 no slices",      MakeDX10DDS( CPUT_TEXTURE_FORMAT_R8_UNORM, 3, 4, 4, 1, 1, 0, false, 1, false ) },
+        { "DX10 3D array",       MakeDX10DDS( CPUT_TEXTURE_FORMAT_R8_UNORM, 4, 4, 4, 4, 1, 2, false, 1, false ) },
+        { "DX10 array wraps",    MakeDX10DDS( CPUT_TEXTURE_FORMAT_R8_UNORM, 3, 4, 4, 1, 1, 2, false, 1, false ) },
+    };
+    bad[1].mFile.mData[4 + 80] = 'Q';                 // The FourCC
+    const uint32_t wraps = 0x2AAAAAAB;                // Times 6 is 2 in 32 bits
+    memcpy( &bad[10].mFile.mData[4 + 124 + 12], &wraps, 4 );
+    bad[10].mFile.mData[4 + 124 + 8] = 0x4;           // Cube
+    for( uint32_t ii=0; ii<sizeof(bad)/sizeof(bad[0]); ii++ )
+    {
+        CPUTTextureFile parser;
+        bool parsed = parser.Parse( &bad[ii].mFile.mData[0], bad[ii].mFile.mData.size() );
+        CPUT_CHECK( !parsed && 0 != *parser.GetError() );
+        if( parsed )
+        {
+            printf( "  parsed %s\n", bad[ii].mpName );
+        }
+    }
+
+    // The header's size fields
+    CPUTTextureFile parser;
+    file.mData[4] = 100;
+    CPUT_CHECK( !parser.Parse( &file.mData[0], file.mData.size() ) );
+    file.mData[4] = 124;
+    file.mData[4 + 72] = 24;
+    CPUT_CHECK( !parser.Parse( &file.mData[0], file.mData.size() ) );
+    file.mData[4 + 72] = 32;
+    CPUT_CHECK( parser.Parse( &file.mData[0], file.mData.size() ) );
+
+    // A failed parse leaves nothing behind from an earlier success
+    CPUT_CHECK( !parser.Parse( &file.mData[0], 100 ) && 0 == strcmp( "Truncated DDS header", parser.GetError() ) );
+}
+
+// Compressed and uncompressed KTX files, with rows padded to 4 bytes, cube maps and arrays
+//-----------------------------------------------------------------------------
+static void TestKTX()
+{
+    const CPUTTextureFile::CONTAINER ktx = CPUTTextureFile::CONTAINER_KTX;
+    CheckFile( "BC1", MakeKTX( 0x83F1, 64, 64, 0, 7, 0, 1, 8, true ), ktx, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC1_UNORM, 64, 64, 1, false );
+    CheckFile( "BC7 sRGB", MakeKTX( 0x8E8D, 40, 24, 0, 6, 0, 1, 16, true ), ktx, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC7_UNORM_SRGB, 40, 24, 1, false );
+
+    // 5 one-byte pixels take 8 bytes a row
+    CPUTTestTextureFile r8 = MakeKTX( 0x8229, 5, 3, 0, 3, 0, 1, 1, false );
+    CPUT_CHECK( 24 == r8.mSizes[0] && 4 == r8.mSizes[1] && 4 == r8.mSizes[2] );
+    CheckFile( "R8", r8, ktx, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_R8_UNORM, 5, 3, 1, false );
+    CPUTTextureFile parser;
+    CPUT_CHECK( parser.Parse( &r8.mData[0], r8.mData.size() ) && 8 == parser.GetSubresource( 0, 0 ).mRowPitch );
+
+    CheckFile( "RGBA8 cube", MakeKTX( 0x8058, 16, 16, 0, 5, 0, 6, 4, false ), ktx, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_R8G8B8A8_UNORM, 16, 16, 1, true );
+    CheckFile( "BC3 cube array", MakeKTX( 0x83F3, 8, 8, 0, 4, 2, 6, 16, true ), ktx, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_BC3_UNORM, 8, 8, 1, true );
+    CheckFile( "RG16F array", MakeKTX( 0x822F, 8, 2, 0, 4, 3, 1, 4, false ), ktx, CPUTTextureFile::DIMENSION_2D, CPUT_TEXTURE_FORMAT_R16G16_FLOAT, 8, 2, 1, false );
+    CheckFile( "R32F 1D", MakeKTX( 0x822E, 16, 0, 0, 5, 0, 1, 4, false ), ktx, CPUTTextureFile::DIMENSION_1D, CPUT_TEXTURE_FORMAT_R32_FLOAT, 16, 1, 1, false );
+    CheckFile( "RGBA16F 3D", MakeKTX( 0x881A, 4, 4, 4, 3, 0, 1, 8, false ), ktx, CPUTTextureFile::DIMENSION_3D, CPUT_TEXTURE_FORMAT_R16G16B16A16_FLOAT, 4, 4, 4, false );
+
+    CPUTTestTextureFile bad[] =
+    {
+        MakeKTX( 0x8051 /* GL_RGB8 */, 4, 4, 0, 1, 0, 1, 3, false ),
+        MakeKTX( 0x8058, 4, 4, 0, 1, 0, 3, 4, false ),    // Three faces
+        MakeKTX( 0x8058, 8, 4, 0, 1, 0, 6, 4, false ),    // Cube not square
+        MakeKTX( 0x8058, 4, 4, 0, 4, 0, 1, 4, false ),    // Too many mips
+        MakeKTX( 0x8058, 0, 4, 0, 1, 0, 1, 4, false ),    // No width
+        MakeKTX( 0x8058, 4, 4, 4, 1, 2, 1, 4, false ),    // 3D array
+        MakeKTX( 0x8058, 4, 4, 0, 1, 0, 1, 4, false ),    // Big endian
+        MakeKTX( 0x8058, 4, 4, 0, 1, 0, 1, 4, false ),    // Wrong image size
+        MakeKTX( 0x8058, 4, 4, 0, 1, 0, 1, 4, false ),    // Key/value data runs past the end
+        MakeKTX( 0x8058, 4, 4, 0, 1, 400, 1, 4, false ),  // 400 array elements = 2400 slices
+    };
+    const uint32_t bigEndian = 0x01020304, keyValueBytes = 0xFFFFFFF0;
+    memcpy( &bad[6].mData[12], &bigEndian, 4 );
+    bad[7].mData[64 + 24] ^= 4;
+    memcpy( &bad[8].mData[60], &keyValueBytes, 4 );
+    for( uint32_t ii=0; ii<sizeof(bad)/sizeof(bad[0]); ii++ )
+    {
+        bool parsed = parser.Parse( &bad[ii].mData[0], bad[ii].mData.size() );
+        CPUT_CHECK( !parsed && 0 != *parser.GetError() );
+        if( parsed )
+        {
+            printf( "  parsed bad KTX %u\n", ii );
+        }
+    }
+}
+
+// Neither container, the file extension check, and reading a file through a mapping
+//-----------------------------------------------------------------------------
+static void TestFiles()
+{
+    CPUTTextureFile parser;
+    const uint8_t png[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    CPUT_CHECK( !parser.Parse( png, sizeof(png) ) && !parser.Parse( png, 0 ) && !parser.Parse( NULL, 0 ) );
+
+    CPUT_CHECK( CPUTTextureFile::HasTextureFileExtension( "a/b.dds" ) && CPUTTextureFile::HasTextureFileExtension( "B.KTX" ) );
+    CPUT_CHECK( !CPUTTextureFile::HasTextureFileExtension( "dds" ) && !CPUTTextureFile::HasTextureFileExtension( "a.png" ) && !CPUTTextureFile::HasTextureFileExtension( "a.dds.png" ) );
+
+    const char *pName = "CPUTTextureFileTest.ktx";
+    CPUTTestTextureFile file = MakeKTX( 0x83F0, 16, 16, 0, 5, 0, 1, 8, true );
+    FILE *pFile = fopen( pName, "wb" );
+    CPUT_CHECK( NULL != pFile );
+    if( pFile )
+    {
+        fwrite( &file.mData[0], 1, file.mData.size(), pFile );
+        fclose( pFile );
+        CPUTTextureFile opened;
+        CPUT_CHECK( opened.Open( pName ) && 5 == opened.GetMipCount() && CPUT_TEXTURE_FORMAT_BC1_UNORM == opened.GetFormat() );
+        CPUT_CHECK( 0 == memcmp( opened.GetSubresourceData( 4, 0 ), &file.mData[file.mOffsets[4]], 8 ) );
+        remove( pName );
+    }
+    CPUT_CHECK( !parser.Open( "CPUTTextureFileTest.missing.dds" ) && 0 != *parser.GetError() );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestDDS();
+    TestKTX();
+    TestFiles();
+    return CPUTTestResult();
+}
@@ -0,0 +1,304 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTextureStreamer.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <string.h>
+#include <algorithm>
+
+// CPUTTextureStreamer with textures that record what they are given: the mip tail at
+// Register(), the order levels stream in, the budget and eviction, and the changed
+// texture list.  Without the loader thread, so each Update() is deterministic, then
+// with it.
+
+// RGBA8, size x size with a full mip chain, in a legacy DDS.  Each level's bytes are its own.
+//-----------------------------------------------------------------------------
+static std::vector<uint8_t> MakeDDS( uint32_t size, uint8_t seed )
+{
+    uint32_t mipCount = 1;
+    while( (size >> mipCount) > 0 )
+    {
+        mipCount++;
+    }
+    uint32_t header[32] = { 0x20534444, 124, 0x21007, size, size, size * 4, 0, mipCount };
+    header[19] = 32;
+    header[20] = 0x40; // DDPF_RGB
+    header[22] = 32;
+    header[23] = 0x000000FF; header[24] = 0x0000FF00; header[25] = 0x00FF0000; header[26] = 0xFF000000;
+    header[27] = 0x401008;
+    std::vector<uint8_t> data( (uint8_t*)header, (uint8_t*)header + sizeof(header) );
+    for( uint32_t mip=0; mip<mipCount; mip++ )
+    {
+        uint32_t mipSize = std::max( size >> mip, 1u );
+        for( uint32_t ii=0; ii<mipSize * mipSize * 4; ii++ )
+        {
+            data.push_back( (uint8_t)(seed + mip * 17 + ii) );
+        }
+    }
+    return data;
+}
+
+//-----------------------------------------------------------------------------
+static uint64_t LevelBytes( uint32_t size, uint32_t mip )
+{
+    uint64_t mipSize = std::max( size >> mip, 1u );
+    return mipSize * mipSize * 4;
+}
+
+// Bytes of mips [topMip, end) of a size x size texture
+//-----------------------------------------------------------------------------
+static uint64_t ResidentBytes( uint32_t size, uint32_t topMip )
+{
+    uint64_t bytes = 0;
+    for( uint32_t mip=topMip; (size >> mip) > 0; mip++ )
+    {
+        bytes += LevelBytes( size, mip );
+    }
+    return bytes;
+}
+
+// Checks each call against the file and keeps the resident range.  Logs each level it
+// is given after Register() as id * 100 + mip.
+//-----------------------------------------------------------------------------
+class CPUTTestStreamedTexture : public CPUTStreamedTexture
+{
+public:
+    uint32_t               mId;
+    uint32_t               mTopMip;      // Resident levels, or 0xFFFFFFFF before Register()
+    uint32_t               mCalls;
+    bool                   mReject;
+    std::vector<uint32_t> *mpLog;
+
+    CPUTTestStreamedTexture( uint32_t id, std::vector<uint32_t> *pLog ) : mId(id), mTopMip(0xFFFFFFFF), mCalls(0), mReject(false), mpLog(pLog) {}
+    ~CPUTTestStreamedTexture() {}
+
+    bool SetResidentMips( const CPUTTextureFile &file, uint32_t topMip, const uint8_t *const *ppMipData )
+    {
+        mCalls++;
+        if( mReject )
+        {
+            return false;
+        }
+        CPUT_CHECK( topMip < file.GetMipCount() );
+        for( uint32_t mip=topMip; mip<file.GetMipCount(); mip++ )
+        {
+            const uint8_t *pData = ppMipData[mip - topMip];
+            if( mip < mTopMip )
+            {
+                // New: exactly the level's bytes
+                CPUT_CHECK( NULL != pData );
+                CPUT_CHECK( NULL != pData && 0 == memcmp( pData, file.GetSubresourceData( mip, 0 ), (size_t)file.GetMipSize( mip ) ) );
+                if( 0xFFFFFFFF != mTopMip )
+                {
+                    mpLog->push_back( mId * 100 + mip );
+                }
+            }
+            else
+            {
+                CPUT_CHECK( NULL == pData ); // Already resident
+            }
+        }
+        // Loads add one level at a time; evictions drop one
+        CPUT_CHECK( 0xFFFFFFFF == mTopMip || topMip + 1 == mTopMip || topMip == mTopMip + 1 );
+        mTopMip = topMip;
+        return true;
+    }
+};
+
+// A texture, its file and its handle
+//-----------------------------------------------------------------------------
+struct CPUTTestStreamed
+{
+    std::vector<uint8_t>    mData;
+    CPUTTestStreamedTexture mTexture;
+    CPUTStreamingHandle     mHandle;
+    uint32_t                mSize;
+
+    CPUTTestStreamed( uint32_t id, uint32_t size, std::vector<uint32_t> *pLog ) : mData(MakeDDS( size, (uint8_t)id )), mTexture(id, pLog), mHandle(CPUT_INVALID_STREAMING_HANDLE), mSize(size) {}
+
+    void Register( CPUTTextureStreamer *pStreamer, float priority )
+    {
+        CPUTTextureFile *pFile = new CPUTTextureFile();
+        CPUT_CHECK( pFile->Parse( &mData[0], mData.size() ) );
+        mHandle = pStreamer->Register( &mTexture, pFile, priority );
+    }
+};
+
+// Register() makes the tail resident at once, and Update() adds a level at a time
+//-----------------------------------------------------------------------------
+static void TestTailFirst()
+{
+    std::vector<uint32_t> log;
+    CPUTTextureStreamer streamer( false );
+    CPUTTestStreamed big( 1, 256, &log ), small( 2, 32, &log ), shortTail( 3, 256, &log );
+    big.Register( &streamer, 1.0f );
+    CPUT_CHECK( 2 == big.mTexture.mTopMip && 2 == streamer.GetTopMip( big.mHandle ) ); // 64x64 and smaller
+    CPUT_CHECK( 1 == big.mTexture.mCalls );
+    CPUT_CHECK( 1 == streamer.GetStats().mTextures && ResidentBytes( 256, 2 ) == streamer.GetStats().mResidentBytes );
+    small.Register( &streamer, 1.0f );
+    CPUT_CHECK( 0 == small.mTexture.mTopMip ); // All tail
+    streamer.SetTailSize( 16 );
+    shortTail.Register( &streamer, 0.0f );
+    CPUT_CHECK( 4 == shortTail.mTexture.mTopMip );
+
+    // One level per Update(), for the textures with a positive priority
+    CPUT_CHECK( 1 == streamer.Update() && 1 == big.mTexture.mTopMip );
+    CPUT_CHECK( 1 == streamer.GetChangedTextures().size() && &big.mTexture == streamer.GetChangedTextures()[0] );
+    CPUT_CHECK( 1 == streamer.Update() && 0 == big.mTexture.mTopMip && streamer.IsIdle() );
+    CPUT_CHECK( 0 == streamer.Update() && streamer.GetChangedTextures().empty() );
+    CPUT_CHECK( 4 == shortTail.mTexture.mTopMip && 0 == small.mTexture.mTopMip );
+    const CPUTTextureStreamerStats &stats = streamer.GetStats();
+    CPUT_CHECK( 2 == stats.mLoads && LevelBytes( 256, 0 ) + LevelBytes( 256, 1 ) == stats.mBytesLoaded );
+    CPUT_CHECK( ResidentBytes( 256, 0 ) + ResidentBytes( 32, 0 ) + ResidentBytes( 256, 4 ) == stats.mResidentBytes );
+    CPUT_CHECK( 0 == stats.mPendingBytes && 0 == stats.mEvictions );
+
+    // Raising the priority streams it; unregistering gives back its bytes and its handle
+    streamer.SetPriority( shortTail.mHandle, 1.0f );
+    CPUT_CHECK( 1 == streamer.Update() && 3 == shortTail.mTexture.mTopMip );
+    CPUTStreamingHandle handle = shortTail.mHandle;
+    streamer.Unregister( handle );
+    CPUT_CHECK( 2 == streamer.GetStats().mTextures && ResidentBytes( 256, 0 ) + ResidentBytes( 32, 0 ) == streamer.GetStats().mResidentBytes );
+    CPUT_CHECK( 0 == streamer.Update() );
+    CPUTTestStreamed reused( 4, 128, &log );
+    reused.Register( &streamer, 1.0f );
+    CPUT_CHECK( handle == reused.mHandle );
+
+    // A texture that refuses its tail isn't registered
+    CPUTTestStreamed rejected( 5, 64, &log );
+    rejected.mTexture.mReject = true;
+    rejected.Register( &streamer, 1.0f );
+    CPUT_CHECK( CPUT_INVALID_STREAMING_HANDLE == rejected.mHandle && 3 == streamer.GetStats().mTextures );
+    CPUT_CHECK( log.size() == 3 && 101 == log[0] && 100 == log[1] && 303 == log[2] );
+}
+
+// Highest priority first.  Between equal priorities the blurriest, so they sharpen together.
+//-----------------------------------------------------------------------------
+static void TestPriorityOrder()
+{
+    std::vector<uint32_t> log;
+    CPUTTextureStreamer streamer( false );
+    streamer.SetMaxLoadsInFlight( 1 );
+    CPUTTestStreamed a( 1, 256, &log ), b( 2, 256, &log ), c( 3, 1024, &log ), d( 4, 256, &log );
+    a.Register( &streamer, 1.0f );
+    b.Register( &streamer, 3.0f );
+    c.Register( &streamer, 1.0f );
+    d.Register( &streamer, -1.0f );
+    for( uint32_t ii=0; ii<20; ii++ )
+    {
+        streamer.Update();
+    }
+    // b, then c down to a's level, then a and c in turn
+    const uint32_t expected[] = { 201, 200, 303, 302, 101, 301, 100, 300 };
+    CPUT_CHECK( log.size() == sizeof(expected) / sizeof(expected[0]) );
+    CPUT_CHECK( log.size() == sizeof(expected) / sizeof(expected[0]) && 0 == memcmp( &log[0], expected, sizeof(expected) ) );
+    CPUT_CHECK( 2 == d.mTexture.mTopMip ); // Never streams
+    CPUT_CHECK( 8 == streamer.GetStats().mLoads && 0 == streamer.GetStats().mBudgetStalls );
+}
+
+// Loads stay under the budget, evicting lower priority levels to make room
+//-----------------------------------------------------------------------------
+static void TestBudget()
+{
+    std::vector<uint32_t> log;
+    CPUTTextureStreamer streamer( false );
+    const uint64_t tails = 3 * ResidentBytes( 256, 2 );
+    streamer.SetBudget( tails + 2 * LevelBytes( 256, 1 ) );
+    CPUT_CHECK( tails + 2 * LevelBytes( 256, 1 ) == streamer.GetBudget() );
+    CPUTTestStreamed low( 1, 256, &log ), high( 2, 256, &log ), equal( 3, 256, &log );
+    low.Register( &streamer, 1.0f );
+    CPUT_CHECK( 1 == streamer.Update() && 1 == low.mTexture.mTopMip );
+    high.Register( &streamer, 2.0f );
+    CPUT_CHECK( 1 == streamer.Update() && 1 == high.mTexture.mTopMip && 1 == low.mTexture.mTopMip );
+    CPUT_CHECK( 0 == streamer.GetStats().mEvictions );
+
+    // high's top level is more than evicting low's level would free, so low keeps it
+    for( uint32_t ii=0; ii<5; ii++ )
+    {
+        CPUT_CHECK( 0 == streamer.Update() );
+    }
+    CPUT_CHECK( 1 == low.mTexture.mTopMip && 1 == high.mTexture.mTopMip );
+    CPUT_CHECK( 0 == streamer.GetStats().mEvictions && streamer.GetStats().mBudgetStalls >= 5 );
+
+    // A new texture with high's priority takes low's level
+    equal.Register( &streamer, 2.0f );
+    CPUT_CHECK( 2 == streamer.Update() && 2 == low.mTexture.mTopMip && 1 == equal.mTexture.mTopMip );
+    const std::vector<CPUTStreamedTexture*> &changed = streamer.GetChangedTextures();
+    CPUT_CHECK( 2 == changed.size() && changed[0] < changed[1] ); // Sorted, once each
+    CPUT_CHECK( 1 == streamer.GetStats().mEvictions && streamer.GetStats().mResidentBytes <= streamer.GetBudget() );
+
+    // Equal priorities don't trade the same level back and forth
+    for( uint32_t ii=0; ii<5; ii++ )
+    {
+        CPUT_CHECK( 0 == streamer.Update() );
+    }
+    CPUT_CHECK( 1 == high.mTexture.mTopMip && 1 == equal.mTexture.mTopMip && 1 == streamer.GetStats().mEvictions );
+
+    // Raised above both, low takes a level back from one of them
+    streamer.SetPriority( low.mHandle, 3.0f );
+    CPUT_CHECK( 2 == streamer.Update() && 1 == low.mTexture.mTopMip && 3 == high.mTexture.mTopMip + equal.mTexture.mTopMip );
+    CPUT_CHECK( 2 == streamer.GetStats().mEvictions && streamer.GetStats().mResidentBytes <= streamer.GetBudget() );
+    CPUT_CHECK( 0 == streamer.GetStats().mPendingBytes );
+}
+
+// The loader thread gets every texture to full detail, in the background
+//-----------------------------------------------------------------------------
+static void TestThread()
+{
+    std::vector<uint32_t> log;
+    CPUTTextureStreamer streamer( true );
+    std::vector<CPUTTestStreamed*> textures;
+    for( uint32_t ii=0; ii<8; ii++ )
+    {
+        textures.push_back( new CPUTTestStreamed( ii, 128 << (ii & 3), &log ) );
+        textures.back()->Register( &streamer, 1.0f + (ii & 1) );
+    }
+    streamer.Unregister( textures[7]->mHandle ); // Possibly while its first level is loading
+
+    double start = CPUTFrameScheduler::GetSeconds();
+    uint32_t changes = 0;
+    bool done = false;
+    while( !done && CPUTFrameScheduler::GetSeconds() - start < 10.0 )
+    {
+        changes += streamer.Update();
+        done = streamer.IsIdle();
+        for( uint32_t ii=0; ii<7; ii++ )
+        {
+            done = done && 0 == textures[ii]->mTexture.mTopMip;
+        }
+    }
+    CPUT_CHECK( done );
+    uint64_t expected = 0;
+    for( uint32_t ii=0; ii<7; ii++ )
+    {
+        expected += ResidentBytes( textures[ii]->mSize, 0 );
+    }
+    CPUT_CHECK( expected == streamer.GetStats().mResidentBytes && 0 == streamer.GetStats().mPendingBytes );
+    CPUT_CHECK( changes == streamer.GetStats().mLoads && changes == log.size() );
+    for( size_t ii=0; ii<textures.size(); ii++ )
+    {
+        delete textures[ii];
+    }
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    TestTailFirst();
+    TestPriorityOrder();
+    TestBudget();
+    TestThread();
+    return CPUTTestResult();
+}
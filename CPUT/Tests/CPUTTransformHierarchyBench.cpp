@@ -0,0 +1,232 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTransformHierarchy.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+#include <stdlib.h>
+#include <vector>
+
+// Updates of 10k to 1M node hierarchies, next to the same hierarchy as a tree of
+// separately allocated nodes updated recursively (as CPUTRenderNode did before it used
+// CPUTTransformHierarchy).  Nodes get random earlier nodes as parents, and are created
+// in shuffled order, so the first Update() has to re-sort.  Pass the largest node count
+// to run as an argument (default 1000000).
+
+// The baseline: a node per allocation, children reached through pointers
+//-----------------------------------------------------------------------------
+struct TreeNode
+{
+    float4x4               mLocal;
+    float4x4               mWorld;
+    bool                   mDirty;
+    std::vector<TreeNode*> mChildren;
+};
+
+//-----------------------------------------------------------------------------
+static void UpdateTree( TreeNode *pNode, const float4x4 *pParentWorld, bool parentChanged, uint32_t *pUpdated )
+{
+    bool changed = parentChanged || pNode->mDirty;
+    if( changed )
+    {
+        pNode->mWorld = pParentWorld ? pNode->mLocal * *pParentWorld : pNode->mLocal;
+        pNode->mDirty = false;
+        (*pUpdated)++;
+    }
+    for( size_t ii=0; ii<pNode->mChildren.size(); ii++ )
+    {
+        UpdateTree( pNode->mChildren[ii], &pNode->mWorld, changed, pUpdated );
+    }
+}
+
+//-----------------------------------------------------------------------------
+static float4x4 LocalMatrix( CPUTTestRandom &random )
+{
+    return float4x4RotationY( random.Float(-0.5f, 0.5f) ) * float4x4Translation( random.Float(-1.0f, 1.0f), random.Float(0.0f, 1.0f), random.Float(-1.0f, 1.0f) );
+}
+
+//-----------------------------------------------------------------------------
+static double Milliseconds( double startSeconds )
+{
+    return (CPUTFrameScheduler::GetSeconds() - startSeconds) * 1000.0;
+}
+
+//-----------------------------------------------------------------------------
+static bool RunBenchmark( uint32_t nodeCount )
+{
+    CPUTTestRandom random( nodeCount );
+
+    // One root per 64 nodes; every other node's parent is a random earlier node
+    std::vector<uint32_t> parents( nodeCount );
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        parents[ii] = (ii % 64) ? random.Index( ii ) : CPUT_INVALID_TRANSFORM;
+    }
+    std::vector<uint32_t> creationOrder( nodeCount );
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        creationOrder[ii] = ii;
+    }
+    for( uint32_t ii=nodeCount-1; ii>0; ii-- )
+    {
+        uint32_t other = random.Index( ii + 1 );
+        uint32_t swap = creationOrder[ii]; creationOrder[ii] = creationOrder[other]; creationOrder[other] = swap;
+    }
+    std::vector<float4x4> locals( nodeCount, float4x4Identity() );
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        locals[ii] = LocalMatrix( random );
+    }
+    std::vector<uint32_t> dirty( nodeCount / 100 );
+    for( size_t ii=0; ii<dirty.size(); ii++ )
+    {
+        dirty[ii] = random.Index( nodeCount );
+    }
+
+    // Flattened hierarchy
+    double start = CPUTFrameScheduler::GetSeconds();
+    CPUTTransformHierarchy hierarchy;
+    std::vector<CPUTTransformHandle> handles( nodeCount );
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        handles[creationOrder[ii]] = hierarchy.Allocate();
+    }
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        hierarchy.SetLocal( handles[ii], locals[ii] );
+        if( CPUT_INVALID_TRANSFORM != parents[ii] )
+        {
+            hierarchy.SetParent( handles[ii], handles[parents[ii]] );
+        }
+    }
+    double buildMs = Milliseconds( start );
+    start = CPUTFrameScheduler::GetSeconds();
+    hierarchy.Update();
+    double firstUpdateMs = Milliseconds( start );
+
+    double fullMs[2];
+    for( uint32_t simd=0; simd<2; simd++ )
+    {
+        hierarchy.SetUseSIMD( 0 != simd );
+        start = CPUTFrameScheduler::GetSeconds();
+        for( uint32_t ii=0; ii<nodeCount; ii += 64 )
+        {
+            hierarchy.MarkDirty( handles[ii] );
+        }
+        hierarchy.Update();
+        fullMs[simd] = Milliseconds( start );
+    }
+    uint32_t fullCount = hierarchy.GetLastUpdateCount();
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( size_t ii=0; ii<dirty.size(); ii++ )
+    {
+        hierarchy.MarkDirty( handles[dirty[ii]] );
+    }
+    hierarchy.Update();
+    double partialMs = Milliseconds( start );
+    uint32_t partialCount = hierarchy.GetLastUpdateCount();
+
+    // Pointer tree
+    start = CPUTFrameScheduler::GetSeconds();
+    std::vector<TreeNode*> nodes( nodeCount );
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        nodes[creationOrder[ii]] = new TreeNode();
+    }
+    std::vector<TreeNode*> roots;
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        nodes[ii]->mLocal = locals[ii];
+        nodes[ii]->mDirty = true;
+        if( CPUT_INVALID_TRANSFORM != parents[ii] )
+        {
+            nodes[parents[ii]]->mChildren.push_back( nodes[ii] );
+        }
+        else
+        {
+            roots.push_back( nodes[ii] );
+        }
+    }
+    double treeBuildMs = Milliseconds( start );
+    uint32_t treeUpdated = 0;
+    for( size_t ii=0; ii<roots.size(); ii++ )
+    {
+        UpdateTree( roots[ii], NULL, false, &treeUpdated );
+    }
+
+    start = CPUTFrameScheduler::GetSeconds();
+    treeUpdated = 0;
+    for( size_t ii=0; ii<roots.size(); ii++ )
+    {
+        roots[ii]->mDirty = true;
+        UpdateTree( roots[ii], NULL, false, &treeUpdated );
+    }
+    double treeFullMs = Milliseconds( start );
+
+    start = CPUTFrameScheduler::GetSeconds();
+    for( size_t ii=0; ii<dirty.size(); ii++ )
+    {
+        nodes[dirty[ii]]->mDirty = true;
+    }
+    treeUpdated = 0;
+    for( size_t ii=0; ii<roots.size(); ii++ )
+    {
+        UpdateTree( roots[ii], NULL, false, &treeUpdated );
+    }
+    double treePartialMs = Milliseconds( start );
+
+    // Both must agree
+    uint32_t mismatches = 0;
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        const float *pFlat = (const float*)hierarchy.GetWorld( handles[ii] );
+        const float *pTree = (const float*)&nodes[ii]->mWorld;
+        for( uint32_t jj=0; jj<16; jj++ )
+        {
+            if( fabsf( pFlat[jj] - pTree[jj] ) > 1e-3f * (1.0f + fabsf( pTree[jj] )) )
+            {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    for( uint32_t ii=0; ii<nodeCount; ii++ )
+    {
+        delete nodes[ii];
+    }
+
+    printf( "%8u nodes   flattened: build %7.2f ms, first update (re-sort) %7.2f ms, full update %6.2f ms (%.1f ns/node; operator* %6.2f ms), 1%% dirty %6.2f ms (%u updated)\n",
+        nodeCount, buildMs, firstUpdateMs, fullMs[1], fullMs[1] * 1e6 / fullCount, fullMs[0], partialMs, partialCount );
+    printf( "%8s         pointer tree: build %7.2f ms, full update %6.2f ms (%.1f ns/node), 1%% dirty %6.2f ms (%u updated)\n",
+        "", treeBuildMs, treeFullMs, treeFullMs * 1e6 / nodeCount, treePartialMs, treeUpdated );
+    if( mismatches )
+    {
+        printf( "%u world matrices differ\n", mismatches );
+    }
+    return 0 == mismatches;
+}
+
+//-----------------------------------------------------------------------------
+int main( int argc, char **argv )
+{
+    uint32_t maxNodes = argc > 1 ? (uint32_t)atoi( argv[1] ) : 1000000;
+    bool ok = true;
+    for( uint32_t nodeCount=10000; nodeCount<=maxNodes; nodeCount *= 10 )
+    {
+        ok = RunBenchmark( nodeCount ) && ok;
+    }
+    return ok ? 0 : 1;
+}
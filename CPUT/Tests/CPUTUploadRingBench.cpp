@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTRenderBackendNull.h"
+#include "CPUTUploadRing.h"
+#include "CPUTFrameScheduler.h"
+#include "CPUTTest.h"
+
+// Per-draw constant uploads a second on the null backend: through the upload ring (one
+// map a frame, a range bind per draw), against mapping one constant buffer per draw
+// and UpdateBuffer() per draw, the paths used without the ring.  The null backend copies
+// what the real one would hand to the driver, so this measures the CPU side only.  On
+// DX11 the ring is only enabled in builds with CPUT_FOR_DX11_1.
+
+static const uint32_t kDraws  = 10000;
+static const uint32_t kFrames = 100;
+
+//-----------------------------------------------------------------------------
+static void WriteConstants( float *pConstants, uint32_t floatCount, uint32_t draw )
+{
+    for( uint32_t ii=0; ii<floatCount; ii++ )
+    {
+        pConstants[ii] = (float)(draw + ii);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void Report( const char *pName, uint32_t byteCount, double seconds, const CPUTRenderBackendNull &backend )
+{
+    printf( "  %-32s %4u bytes  %7.2f M uploads/s  %6u maps/frame\n", pName, byteCount,
+            (double)kDraws * kFrames / seconds / 1e6, backend.GetStats().mMaps / kFrames );
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    const uint32_t byteCounts[2] = { 64, 256 };
+    for( uint32_t bb=0; bb<2; bb++ )
+    {
+        uint32_t byteCount  = byteCounts[bb];
+        uint32_t floatCount = byteCount / sizeof(float);
+        uint32_t slotSize   = (byteCount + CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT - 1) & ~(CPUT_BACKEND_CONSTANT_BUFFER_ALIGNMENT - 1);
+        {
+            CPUTRenderBackendNull backend;
+            // The "GPU" runs three frames behind, so BeginFrame() waits on the fence
+            backend.SetFenceLatency( 3 );
+            CPUTUploadRing ring;
+            ring.Create( &backend, kDraws * slotSize, 3 );
+            backend.ResetStats();
+            double start = CPUTFrameScheduler::GetSeconds();
+            for( uint32_t ff=0; ff<kFrames; ff++ )
+            {
+                ring.BeginFrame();
+                for( uint32_t ii=0; ii<kDraws; ii++ )
+                {
+                    uint32_t offset;
+                    float *pConstants = (float*)ring.Allocate( byteCount, &offset );
+                    WriteConstants( pConstants, floatCount, ii );
+                    backend.SetConstantBufferRange( CPUT_SHADER_STAGE_VERTEX, 1, ring.GetBuffer(), offset, byteCount );
+                    backend.DrawIndexed( 36, 0, 0 );
+                }
+                ring.EndFrame();
+                backend.Present( 1 );
+            }
+            Report( "Upload ring", byteCount, CPUTFrameScheduler::GetSeconds() - start, backend );
+            printf( "  %-32s %u fence waits, %u failed allocations\n", "", ring.GetStats().mFenceWaits, ring.GetStats().mFailedAllocations );
+        }
+        {
+            CPUTRenderBackendNull backend;
+            CPUTBackendHandle buffer = backend.CreateBuffer( byteCount, CPUT_BIND_CONSTANT_BUFFER, true, NULL );
+            backend.ResetStats();
+            double start = CPUTFrameScheduler::GetSeconds();
+            for( uint32_t ff=0; ff<kFrames; ff++ )
+            {
+                for( uint32_t ii=0; ii<kDraws; ii++ )
+                {
+                    WriteConstants( (float*)backend.Map( buffer ), floatCount, ii );
+                    backend.Unmap( buffer, byteCount );
+                    backend.SetConstantBuffers( CPUT_SHADER_STAGE_VERTEX, 1, 1, &buffer );
+                    backend.DrawIndexed( 36, 0, 0 );
+                }
+                backend.Present( 1 );
+            }
+            Report( "Map per draw", byteCount, CPUTFrameScheduler::GetSeconds() - start, backend );
+            backend.ReleaseBuffer( buffer );
+        }
+        {
+            CPUTRenderBackendNull backend;
+            CPUTBackendHandle buffer = backend.CreateBuffer( byteCount, CPUT_BIND_CONSTANT_BUFFER, false, NULL );
+            float constants[64];
+            backend.ResetStats();
+            double start = CPUTFrameScheduler::GetSeconds();
+            for( uint32_t ff=0; ff<kFrames; ff++ )
+            {
+                for( uint32_t ii=0; ii<kDraws; ii++ )
+                {
+                    WriteConstants( constants, floatCount, ii );
+                    backend.UpdateBuffer( buffer, constants, byteCount );
+                    backend.SetConstantBuffers( CPUT_SHADER_STAGE_VERTEX, 1, 1, &buffer );
+                    backend.DrawIndexed( 36, 0, 0 );
+                }
+                backend.Present( 1 );
+            }
+            Report( "UpdateBuffer per draw", byteCount, CPUTFrameScheduler::GetSeconds() - start, backend );
+            backend.ReleaseBuffer( buffer );
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTBASE_H__
+#define __CPUTBASE_H__
+
+// Stands in for CPUT/CPUT.h (which needs Windows) in the tests that build CPUT sources
+// that only use its basic types.  See CMakeLists.txt.
+#include <assert.h>
+#include <string>
+#include "CPUTMath.h"
+
+typedef unsigned int UINT;
+
+#if defined (UNICODE) || defined(_UNICODE)
+    #define cString std::wstring
+    #define _L(x)      L##x
+#else
+    #define cString std::string
+    #define _L(x)      x
+#endif
+
+#define SAFE_DELETE(p)       {if((p)){ delete (p);   (p)=NULL; }}
+#define SAFE_DELETE_ARRAY(p) {if((p)){ delete[](p);  (p)=NULL; }}
+
+#ifndef UNREFERENCED_PARAMETER
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+#endif
+
+#endif // __CPUTBASE_H__
@@ -0,0 +1,47 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTCamera_H__
+#define __CPUTCamera_H__
+
+// Stands in for CPUT/CPUTCamera.h in the tests: just the getters CPUTFrustum reads.
+#include "CPUT.h"
+
+//-----------------------------------------------------------------------------
+class CPUTCamera
+{
+protected:
+    float  mNearPlaneDistance;
+    float  mFarPlaneDistance;
+    float  mAspectRatio;
+    float  mFov;
+    float3 mPosition;
+    float3 mLook;
+    float3 mUp;
+
+public:
+    CPUTCamera( float nearPlaneDistance, float farPlaneDistance, float aspectRatio, float fov, const float3 &position, const float3 &look, const float3 &up )
+        : mNearPlaneDistance(nearPlaneDistance), mFarPlaneDistance(farPlaneDistance), mAspectRatio(aspectRatio), mFov(fov), mPosition(position), mLook(look), mUp(up) {}
+
+    float  GetNearPlaneDistance() { return mNearPlaneDistance; }
+    float  GetFarPlaneDistance() { return mFarPlaneDistance; }
+    float  GetAspectRatio() { return mAspectRatio; }
+    float  GetFov() { return mFov; }
+    float3 GetPosition() { return mPosition; }
+    float3 GetLook() { return mLook; }
+    float3 GetUp() { return mUp; }
+};
+
+#endif // __CPUTCamera_H__
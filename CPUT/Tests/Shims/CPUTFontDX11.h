@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTFONTDX11_H__
+#define __CPUTFONTDX11_H__
+
+// Stands in for CPUT/CPUTFontDX11.h in the glyph run tests.  CreateFont() fills the glyph
+// tables as the real one does from the atlas's start markers, but with made-up widths
+// (5 to 10 pixels, varying by glyph), instead of loading a texture.
+#include "CPUT.h"
+#include "CPUTRefCount.h"
+#include "CPUTFont.h"
+
+extern int gFontMap_active[];
+
+//-----------------------------------------------------------------------------
+class CPUTFontDX11 : public CPUTFont
+{
+protected:
+    ~CPUTFontDX11() {}
+
+public:
+    CPUTFontDX11() {}
+
+    static CPUTFont *CreateFont( cString /*FontName*/, cString /*AbsolutePathAndFilename*/ )
+    {
+        CPUTFontDX11 *pNewFont = new CPUTFontDX11();
+        pNewFont->mAtlasWidth  = 1024.0f;
+        pNewFont->mAtlasHeight = 64.0f;
+        int index = 0;
+        for( ; -1 != gFontMap_active[index]; index++ )
+        {
+            pNewFont->mpGlyphSizes[index].width  = 5 + (index * 7) % 6;
+            pNewFont->mpGlyphSizes[index].height = 15;
+            for( int ii=0; ii<4; ii++ )
+            {
+                pNewFont->mpGlyphUVCoords[4*index+ii]         = (float)(4*index+ii) / 1024.0f;
+                pNewFont->mpGlyphUVCoordsDisabled[4*index+ii] = (float)(4*index+ii) / 1024.0f + 0.5f;
+            }
+        }
+        pNewFont->mNumberOfGlyphsInAtlas = index;
+        pNewFont->BuildGlyphMap();
+        return pNewFont;
+    }
+};
+
+#endif // __CPUTFONTDX11_H__
@@ -0,0 +1,38 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTGUICONTROLLER_H__
+#define __CPUTGUICONTROLLER_H__
+
+// Stands in for CPUT/CPUTGuiController.h (which needs Windows) in the GUI vertex arena
+// and glyph run tests: only the vertex the controls are drawn with, and the size type
+// (from CPUTControl.h) fonts measure glyphs in.
+#include "CPUT.h"
+
+//-----------------------------------------------------------------------------
+struct CPUT_SIZE
+{
+    int width;
+    int height;
+};
+
+//-----------------------------------------------------------------------------
+struct CPUTGUIVertex
+{
+    float3 Pos;
+    float2 UV;
+};
+
+#endif // __CPUTGUICONTROLLER_H__
@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMATERIAL_H__
+#define __CPUTMATERIAL_H__
+
+// Stands in for CPUT/CPUTMaterial.h in the render queue tests: a shader pair and a
+// texture, with an optional instanced vertex shader, set through the backend.
+#include "CPUT.h"
+#include "CPUTRenderParams.h"
+#include "CPUTRenderBackend.h"
+
+//-----------------------------------------------------------------------------
+class CPUTMaterial
+{
+protected:
+    CPUTBackendHandle mVertexShader;
+    CPUTBackendHandle mInstancedVertexShader; // 0 if the material can't be drawn instanced
+    CPUTBackendHandle mPixelShader;
+    CPUTBackendHandle mTexture;
+
+public:
+    CPUTMaterial( CPUTBackendHandle vertexShader, CPUTBackendHandle instancedVertexShader, CPUTBackendHandle pixelShader, CPUTBackendHandle texture )
+        : mVertexShader(vertexShader), mInstancedVertexShader(instancedVertexShader), mPixelShader(pixelShader), mTexture(texture) {}
+    virtual ~CPUTMaterial() {}
+
+    virtual void SetRenderStates( CPUTRenderParameters &renderParams )
+    {
+        renderParams.mpBackend->SetShader( CPUT_SHADER_STAGE_VERTEX, mVertexShader );
+        renderParams.mpBackend->SetShader( CPUT_SHADER_STAGE_PIXEL,  mPixelShader );
+        renderParams.mpBackend->SetShaderResources( CPUT_SHADER_STAGE_PIXEL, 0, 1, &mTexture );
+    }
+    virtual bool SupportsInstancing() { return 0 != mInstancedVertexShader; }
+    virtual void SetInstancing( CPUTRenderParameters &renderParams, bool instanced )
+    {
+        renderParams.mpBackend->SetShader( CPUT_SHADER_STAGE_VERTEX, instanced ? mInstancedVertexShader : mVertexShader );
+    }
+};
+
+#endif // __CPUTMATERIAL_H__
@@ -0,0 +1,63 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMESH_H__
+#define __CPUTMESH_H__
+
+// Stands in for CPUT/CPUTMesh.h in the render queue tests: a mesh with a vertex and an
+// index buffer, drawn through the backend the way CPUTMeshDX11 draws.
+#include "CPUT.h"
+#include "CPUTRenderParams.h"
+#include "CPUTRenderBackend.h"
+
+class CPUTModel;
+
+//-----------------------------------------------------------------------------
+class CPUTMesh
+{
+protected:
+    CPUTBackendHandle mVertexBuffer;
+    CPUTBackendHandle mIndexBuffer;
+    UINT              mIndexCount;
+    bool              mInstancing;
+
+    void Bind( CPUTRenderParameters &renderParams )
+    {
+        renderParams.mpBackend->SetVertexBuffer( 0, mVertexBuffer, 32, 0 );
+        renderParams.mpBackend->SetIndexBuffer( mIndexBuffer, 57, 0 );
+    }
+
+public:
+    CPUTMesh( CPUTBackendHandle vertexBuffer, CPUTBackendHandle indexBuffer, UINT indexCount, bool instancing )
+        : mVertexBuffer(vertexBuffer), mIndexBuffer(indexBuffer), mIndexCount(indexCount), mInstancing(instancing) {}
+    virtual ~CPUTMesh() {}
+
+    virtual void Draw( CPUTRenderParameters &renderParams, CPUTModel * )
+    {
+        Bind( renderParams );
+        renderParams.mpBackend->DrawIndexed( mIndexCount, 0, 0 );
+    }
+    virtual void DrawShadow( CPUTRenderParameters &renderParams, CPUTModel *pModel ) { Draw( renderParams, pModel ); }
+
+    virtual bool SupportsInstancing( bool ) { return mInstancing; }
+    virtual void DrawInstanced( CPUTRenderParameters &renderParams, CPUTModel *, UINT instanceCount, UINT firstInstance )
+    {
+        Bind( renderParams );
+        renderParams.mpBackend->DrawIndexedInstanced( mIndexCount, instanceCount, 0, 0, firstInstance );
+    }
+    virtual void DrawShadowInstanced( CPUTRenderParameters &renderParams, CPUTModel *pModel, UINT instanceCount, UINT firstInstance ) { DrawInstanced( renderParams, pModel, instanceCount, firstInstance ); }
+};
+
+#endif // __CPUTMESH_H__
@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMODEL_H__
+#define __CPUTMODEL_H__
+
+// Stands in for CPUT/CPUTModel.h in the render queue tests: a model with one mesh, a
+// world matrix and its own constant buffer, with the render queue support of
+// CPUTModelDX11 (constants in the upload ring, or in the model's buffer once a Submit()).
+#include "CPUT.h"
+#include "CPUTMesh.h"
+#include "CPUTRenderQueue.h"
+#include "CPUTUploadRing.h"
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+class CPUTModel
+{
+protected:
+    CPUTRenderBackend *mpBackend;
+    CPUTMesh          *mpMesh;
+    float4x4           mWorld;
+    CPUTBackendHandle  mConstantBuffer;
+    UINT               mConstantsSubmitIndex;
+    UINT               mRingSubmitIndex;
+    UINT               mRingOffset;
+
+public:
+    CPUTModel( CPUTRenderBackend *pBackend, CPUTMesh *pMesh, const float4x4 &world )
+        : mpBackend(pBackend), mpMesh(pMesh), mWorld(world), mConstantsSubmitIndex(0), mRingSubmitIndex(0), mRingOffset(0)
+    {
+        mConstantBuffer = pBackend->CreateBuffer( sizeof(float4x4), CPUT_BIND_CONSTANT_BUFFER, true, 0 );
+    }
+    virtual ~CPUTModel() { mpBackend->ReleaseBuffer( mConstantBuffer ); }
+
+    CPUTMesh *GetMesh( UINT ) { return mpMesh; }
+    void      SetParentMatrix( const float4x4 &parentMatrix ) { mWorld = parentMatrix; }
+
+    virtual bool UploadQueuedConstants( CPUTRenderParameters &renderParams, UINT submitIndex )
+    {
+        if( mRingSubmitIndex == submitIndex )
+        {
+            return true;
+        }
+        UINT  offset;
+        void *pMapped = renderParams.mpUploadRing->Allocate( sizeof(float4x4), &offset );
+        if( !pMapped )
+        {
+            return false;
+        }
+        memcpy( pMapped, &mWorld, sizeof(float4x4) );
+        mRingSubmitIndex = submitIndex;
+        mRingOffset      = offset;
+        return true;
+    }
+    virtual void UpdateQueuedConstants( CPUTRenderParameters &renderParams, UINT submitIndex )
+    {
+        if( mConstantsSubmitIndex != submitIndex )
+        {
+            memcpy( renderParams.mpBackend->Map( mConstantBuffer ), &mWorld, sizeof(float4x4) );
+            renderParams.mpBackend->Unmap( mConstantBuffer, sizeof(float4x4) );
+            mConstantsSubmitIndex = submitIndex;
+        }
+    }
+    virtual void SetQueuedRenderStates( CPUTRenderParameters &renderParams, UINT submitIndex )
+    {
+        if( mRingSubmitIndex == submitIndex )
+        {
+            renderParams.mpBackend->SetConstantBufferRange( CPUT_SHADER_STAGE_VERTEX, 0, renderParams.mpUploadRing->GetBuffer(), mRingOffset, sizeof(float4x4) );
+            return;
+        }
+        UpdateQueuedConstants( renderParams, submitIndex );
+        renderParams.mpBackend->SetConstantBuffers( CPUT_SHADER_STAGE_VERTEX, 0, 1, &mConstantBuffer );
+    }
+    virtual void FillInstanceData( CPUTInstanceData *pData )
+    {
+        memcpy( pData->mWorld, &mWorld, sizeof(float4x4) );
+        memcpy( pData->mWorldViewProjection, &mWorld, sizeof(float4x4) );
+        memcpy( pData->mLightWorldViewProjection, &mWorld, sizeof(float4x4) );
+    }
+};
+
+#endif // __CPUTMODEL_H__
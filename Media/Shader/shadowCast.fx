@@ -52,6 +52,23 @@ PS_INPUT VSMain( VS_INPUT input )
     return output;
 }
 
+// ********************************************************************************************************
+// Instanced variant: WorldViewProjection comes from the instance stream (CPUTInstanceData)
+struct INSTANCE_INPUT
+{
+    float4 World0   : INSTANCE0;  float4 World1   : INSTANCE1;  float4 World2   : INSTANCE2;  float4 World3   : INSTANCE3;
+    float4 Wvp0     : INSTANCE4;  float4 Wvp1     : INSTANCE5;  float4 Wvp2     : INSTANCE6;  float4 Wvp3     : INSTANCE7;
+    float4 LightWvp0: INSTANCE8;  float4 LightWvp1: INSTANCE9;  float4 LightWvp2: INSTANCE10; float4 LightWvp3: INSTANCE11;
+};
+PS_INPUT VSMainInstanced( VS_INPUT input, INSTANCE_INPUT instance )
+{
+    float4x4 wvp = float4x4( instance.Wvp0, instance.Wvp1, instance.Wvp2, instance.Wvp3 );
+    PS_INPUT output = (PS_INPUT)0;
+    output.Pos = mul( float4( input.Pos, 1.0f), wvp );
+    output.Pos.z -= 0.0001 * output.Pos.w;
+    return output;
+}
+
 // ********************************************************************************************************
 float4 PSMain( PS_INPUT input ) : SV_Target
 {
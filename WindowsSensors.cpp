@@ -15,6 +15,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "WindowsSensors.h"
 #include "CPUTRenderTarget.h"
+#include <algorithm>
 
 //
 // Screen auto-rotation defines
@@ -93,6 +94,11 @@ int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdL
     cString CommandLine(lpCmdLine);
     pSample->CPUTParseCommandLine(CommandLine, &params, &AssetFilename);       
 
+    // -simulatesensor drives the bike with generated tilts (e.g. with -headless true, to measure input latency)
+    cString LowerCommandLine(CommandLine);
+    std::transform(LowerCommandLine.begin(), LowerCommandLine.end(), LowerCommandLine.begin(), ::tolower);
+    pSample->SetSimulateSensor( cString::npos != LowerCommandLine.find(_L("-simulatesensor")) );
+
     // parse out the filename of the .set file to open (if one was given)
     if(AssetFilename.size())
     {
@@ -203,19 +209,37 @@ void WindowsSensors::Create()
     CPUTPixelShaderDX11  *pPSNoTex  = CPUTPixelShaderDX11::CreatePixelShaderFromMemory(   _L("$DefaultShaderNoTexture"), CPUT_DX11::mpD3dDevice, _L("PSMainNoTexture"), _L("ps_4_0"), gpDefaultShaderSource );
     CPUTVertexShaderDX11 *pVS       = CPUTVertexShaderDX11::CreateVertexShaderFromMemory(          _L("$DefaultShader"), CPUT_DX11::mpD3dDevice,          _L("VSMain"), _L("vs_4_0"), gpDefaultShaderSource );
     CPUTVertexShaderDX11 *pVSNoTex  = CPUTVertexShaderDX11::CreateVertexShaderFromMemory( _L("$DefaultShaderNoTexture"), CPUT_DX11::mpD3dDevice, _L("VSMainNoTexture"), _L("vs_4_0"), gpDefaultShaderSource );
+    CPUTVertexShaderDX11 *pVSInst   = CPUTVertexShaderDX11::CreateVertexShaderFromMemory(          _L("$DefaultShader"), CPUT_DX11::mpD3dDevice, _L("VSMainInstanced"), _L("vs_4_0"), gpDefaultShaderSource );
+    CPUTVertexShaderDX11 *pVSInstNoTex = CPUTVertexShaderDX11::CreateVertexShaderFromMemory( _L("$DefaultShaderNoTexture"), CPUT_DX11::mpD3dDevice, _L("VSMainInstancedNoTexture"), _L("vs_4_0"), gpDefaultShaderSource );
 
     // We just want to create them, which adds them to the library.  We don't need them any more so release them, leaving refCount at 1 (only library owns a ref)
     SAFE_RELEASE(pPS);
     SAFE_RELEASE(pPSNoTex);
     SAFE_RELEASE(pVS);
     SAFE_RELEASE(pVSNoTex);
+    SAFE_RELEASE(pVSInst);
+    SAFE_RELEASE(pVSInstNoTex);
 
     // load shadow casting material+sprite object
     cString ExecutableDirectory;
     CPUTOSServices::GetOSServices()->GetExecutableDirectory(&ExecutableDirectory);
     pAssetLibrary->SetMediaDirectoryName(  ExecutableDirectory+_L(".\\Media\\"));
-    mpShadowRenderTarget = new CPUTRenderTargetDepth();
-    mpShadowRenderTarget->CreateRenderTarget( cString(_L("$shadow_depth")), SHADOW_WIDTH_HEIGHT, SHADOW_WIDTH_HEIGHT, DXGI_FORMAT_D32_FLOAT );
+
+    // The frame's passes.  The shadow map is a transient of the render graph; compiling
+    // creates it, and adds it to the library as $shadow_depth for the materials loaded below.
+    // The scene pass binds the back buffer itself (resizing replaces it), so its import
+    // only tells the graph the pass's output is used.
+    CPUTRenderGraphTextureDesc shadowDesc = { SHADOW_WIDTH_HEIGHT, SHADOW_WIDTH_HEIGHT, DXGI_FORMAT_D32_FLOAT, 4, 1, CPUT_RENDER_GRAPH_DEPTH };
+    mShadowDepth = mRenderGraph.CreateTexture( CPUTStringTable::Intern(_L("$shadow_depth")), shadowDesc );
+    CPUTRenderGraphResource backBuffer = mRenderGraph.ImportTexture( CPUTStringTable::Intern(_L("$BackBuffer")), NULL );
+    mShadowPass.mpSample = this;
+    mScenePass.mpSample  = this;
+    UINT pass = mRenderGraph.AddPass( "Shadow pass", &mShadowPass );
+    mRenderGraph.Write( pass, mShadowDepth );
+    pass = mRenderGraph.AddPass( "Scene pass", &mScenePass );
+    mRenderGraph.Read( pass, mShadowDepth );
+    mRenderGraph.Write( pass, backBuffer );
+    mRenderGraph.Compile( &mRenderGraphAllocator );
 
     int width, height;
     CPUTOSServices::GetOSServices()->GetClientDimensions(&width, &height);
@@ -240,8 +264,13 @@ void WindowsSensors::Create()
     pBlock->Release(); // We're done with it.  The library owns it now.
 
     //
-    // Load models
+    // Load models, counting the heap allocations it takes.  The media isn't baked with
+    // CPUTModel::OptimizeModelPayload(), so optimize its meshes as they load.
     //
+    CPUTMeshOptimizerSettings meshOptimizerSettings;
+    CPUTAssetLibrary::SetMeshOptimizerSettings( &meshOptimizerSettings );
+    CPUTHeapCounters loadStart = CPUTGetHeapCounters();
+    double loadStartSeconds = CPUTFrameScheduler::GetSeconds();
     g_OpenFilePath = _L("Media\\bikeBlueMerged\\");
     g_OpenFileName = _L("bikeBlueMerged");
     pAssetLibrary->SetMediaDirectoryName( g_OpenFilePath );
@@ -257,6 +286,8 @@ void WindowsSensors::Create()
     g_OpenFileName = _L("skyBox");
     pAssetLibrary->SetMediaDirectoryName( g_OpenFilePath );
     mpSkyboxSet = pAssetLibrary->GetAssetSet( g_OpenFileName );
+    mLoadHeapAllocations = CPUTGetHeapCounters().mAllocations - loadStart.mAllocations;
+    mLoadSeconds         = CPUTFrameScheduler::GetSeconds() - loadStartSeconds;
 
     //
 	// If no cameras were created from the model sets then create a default simple camera
@@ -364,54 +395,191 @@ void WindowsSensors::Create()
     pGUI->CreateText(_L("\tX\tY\tZ"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL);
     pGUI->CreateText(_L( "Raw:\tN/A\tN/A\tN/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpSensorText);
     pGUI->CreateText(_L("Zero:\tN/A\tN/A\tN/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpSensorZeroText);
+    pGUI->CreateText(_L("Occluded: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpOcclusionText);
+    pGUI->CreateText(_L("Draws: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpSubmitText);
+    pGUI->CreateText(_L("Input age at submit: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpLatencyText);
+    pGUI->CreateText(_L("Frames: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpPacingText);
+    pGUI->CreateText(_L("Allocations: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpAllocationText);
+    pGUI->CreateText(_L("Materials: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpMaterialText);
+    pGUI->CreateText(_L("Render graph: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpRenderGraphText);
+    pGUI->CreateText(_L("Meshes: N/A"), ID_IGNORE_CONTROL_ID, ID_MAIN_PANEL, &mpMeshText);
+
+    //
+    // Pace frames at 60 Hz.  Once the sensor has been still, the bike parked and no input
+    // has arrived for two seconds, render 4 frames a second and check the sensor 30 times.
+    //
+    mFrameScheduler.SetTargetRate(60.0);
+    mFrameScheduler.SetIdleRate(4.0);
+    mFrameScheduler.SetPollRate(30.0);
+    mFrameScheduler.SetIdleDelay(2.0);
+    mFrameScheduler.SetIdleThrottling(true);
 
     //
     // Set up level
     //
     memset(&mBike, 0, sizeof(mBike));
 
-    // Create walls
-    mWalls[0] = float4( 1.0f, 0.0f,  0.0f, -6300.0f);
-    mWalls[1] = float4( 0.0f, 0.0f,  1.0f, -6300.0f);
-    mWalls[2] = float4(-1.0f, 0.0f,  0.0f, -6300.0f);
-    mWalls[3] = float4( 0.0f, 0.0f, -1.0f, -6300.0f);
+    // The bike collides with the level's actual geometry
+    mpLevelCollision = new CPUTCollisionMesh();
+    if( mpLevelSet )
+    {
+        for( UINT ii=0; ii<mpLevelSet->GetAssetCount(); ii++ )
+        {
+            CPUTRenderNode *pNode = NULL;
+            mpLevelSet->GetAssetByIndex( ii, &pNode );
+            if( pNode->IsModel() )
+            {
+                mpLevelCollision->AddModel( (CPUTModel*)pNode );
+            }
+            SAFE_RELEASE(pNode);
+        }
+    }
+    mpLevelCollision->Build();
+
+    // The level's triangles (already in world space) also serve as occluders for the main pass
+    mpThreadPool      = new CPUTThreadPool();
+    mpOcclusionCuller = new CPUTOcclusionCuller();
+    mpOcclusionCuller->SetThreadPool( mpThreadPool );
+    mRenderQueue.SetThreadPool( mpThreadPool );
+    UINT occluderVertexCount = mpLevelCollision->GetTriangleCount() * 3;
+    if( occluderVertexCount )
+    {
+        std::vector<uint32_t> occluderIndices( occluderVertexCount );
+        for( UINT ii=0; ii<occluderVertexCount; ii++ )
+        {
+            occluderIndices[ii] = ii;
+        }
+        mpOcclusionCuller->AddOccluder( mpLevelCollision->GetTrianglePositions(), occluderVertexCount,
+            &occluderIndices[0], occluderVertexCount, float4x4Identity() );
+    }
 }
 
+typedef VOID (WINAPI *pGSTPAFT)(LPFILETIME pSystemTime);
+
+// The sensors' clock: 100 ns units since 1601, as in their timestamps.  The precise
+// version of the system time only exists from Windows 8 on.
 //-----------------------------------------------------------------------------
-void WindowsSensors::Update(double deltaSeconds)
+static __int64 GetSensorClock()
 {
-    float elapsedTime = (float)deltaSeconds;
-    InclinometerData sensorData = {0};
+    static pGSTPAFT GetSystemTimePrecise = (pGSTPAFT)GetProcAddress(GetModuleHandle(TEXT("kernel32.dll")),
+                                                                    "GetSystemTimePreciseAsFileTime");
+    FILETIME now;
+    if( GetSystemTimePrecise )
+    {
+        GetSystemTimePrecise( &now );
+    }
+    else
+    {
+        GetSystemTimeAsFileTime( &now );
+    }
+    return ((__int64)now.dwHighDateTime << 32) | now.dwLowDateTime;
+}
 
-    //
-    // Poll the sensors
-    //
-    if(mpSensorManager->GetStatus(mCurrentSensor) == SENSOR_STATUS_ACTIVE)
+// Reads the current sensor's tilts, in degrees, or makes them up with -simulatesensor.
+// Returns false when there is no sensor.
+//-----------------------------------------------------------------------------
+bool WindowsSensors::GetRawSensorData(InclinometerData *pData)
+{
+    if( mSimulateSensor )
+    {
+        // Weave left and right every ~5 seconds while speeding up and slowing down every ~9
+        __int64 now = GetSensorClock();
+        if( !mSimulationStart )
+        {
+            mSimulationStart = now;
+        }
+        float seconds = (float)((now - mSimulationStart) * 1e-7);
+        pData->X_Tilt = -8.0f - 6.0f * sinf(seconds * 0.7f);
+        pData->Y_Tilt = 25.0f * sinf(seconds * 1.3f);
+        pData->Z_Tilt = 0.0f;
+        pData->InclinometerTime = now;
+        return true;
+    }
+    if(mpSensorManager->GetStatus(mCurrentSensor) != SENSOR_STATUS_ACTIVE)
+    {
+        return false;
+    }
+    mpSensorManager->GetData(mCurrentSensor, pData);
+    return true;
+}
+
+// Reads the sensor, zeroed and in radians.  pRawText, if any, shows the raw tilts.
+//-----------------------------------------------------------------------------
+void WindowsSensors::ReadSensor(InclinometerData *pData, CPUTText *pRawText)
+{
+    CPUT_PROFILE_ZONE("Read sensors");
+    if( GetRawSensorData(pData) )
     {
-        mpSensorManager->GetData(mCurrentSensor, &sensorData);
-        TCHAR buffer[256];
-        swprintf(buffer, 256, _L("Raw:\t%.2f\t%.2f\t%.2f"), sensorData.X_Tilt, sensorData.Y_Tilt, sensorData.Z_Tilt);
-        mpSensorText->SetText(buffer);
+        ReportSensorMotion(*pData);
+        if( pRawText )
+        {
+            TCHAR buffer[256];
+            swprintf(buffer, 256, _L("Raw:\t%.2f\t%.2f\t%.2f"), pData->X_Tilt, pData->Y_Tilt, pData->Z_Tilt);
+            pRawText->SetText(buffer);
+        }
 
         // Modify the raw data by the zero
-        sensorData.X_Tilt -= mSensorZero.x;
-        sensorData.Y_Tilt -= mSensorZero.y;
-        sensorData.Z_Tilt -= mSensorZero.z;
+        pData->X_Tilt -= mSensorZero.x;
+        pData->Y_Tilt -= mSensorZero.y;
+        pData->Z_Tilt -= mSensorZero.z;
         
-        sensorData.X_Tilt = DegToRad(sensorData.X_Tilt);
-        sensorData.Y_Tilt = DegToRad(sensorData.Y_Tilt);
-        sensorData.Z_Tilt = DegToRad(sensorData.Z_Tilt);
+        pData->X_Tilt = DegToRad(pData->X_Tilt);
+        pData->Y_Tilt = DegToRad(pData->Y_Tilt);
+        pData->Z_Tilt = DegToRad(pData->Z_Tilt);
     }
     else
     {
         // If the sensor(s) is disconnected, zero out the data
-        sensorData.X_Tilt = 0.0f;
-        sensorData.Y_Tilt = 0.0f;
-        sensorData.Z_Tilt = 0.0f;
+        pData->X_Tilt = 0.0f;
+        pData->Y_Tilt = 0.0f;
+        pData->Z_Tilt = 0.0f;
+        pData->InclinometerTime = 0;
         mSensorZero.x     = 0.0f;
         mSensorZero.y     = 0.0f;
         mSensorZero.z     = 0.0f;
     }
+}
+
+// Tells the frame scheduler when the tilts moved (raw, in degrees)
+//-----------------------------------------------------------------------------
+void WindowsSensors::ReportSensorMotion(const InclinometerData &rawData)
+{
+    if( fabsf(rawData.X_Tilt - mMotionTilt.x) > SENSOR_MOTION_THRESHOLD ||
+        fabsf(rawData.Y_Tilt - mMotionTilt.y) > SENSOR_MOTION_THRESHOLD ||
+        fabsf(rawData.Z_Tilt - mMotionTilt.z) > SENSOR_MOTION_THRESHOLD )
+    {
+        mMotionTilt = float3(rawData.X_Tilt, rawData.Y_Tilt, rawData.Z_Tilt);
+        mFrameScheduler.ReportActivity(CPUTFrameScheduler::GetSeconds());
+    }
+}
+
+// Called between idle frames.  Motion wakes the frame scheduler.
+//-----------------------------------------------------------------------------
+void WindowsSensors::PollActivity()
+{
+    InclinometerData sensorData = {0};
+    if( GetRawSensorData(&sensorData) )
+    {
+        ReportSensorMotion(sensorData);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void WindowsSensors::Update(double deltaSeconds)
+{
+    float elapsedTime = (float)deltaSeconds;
+    InclinometerData sensorData = {0};
+
+    if( mProfileCapturePending && !CPUTProfiler::IsCapturing() )
+    {
+        CPUTProfiler::WriteChromeTrace( "WindowsSensors.json" );
+        mProfileCapturePending = false;
+    }
+
+    //
+    // Poll the sensors
+    //
+    ReadSensor(&sensorData, mpSensorText);
 
     //
     // Update camera
@@ -428,9 +596,29 @@ void WindowsSensors::Update(double deltaSeconds)
     mpCamera->LookAt(bikePosition.x, bikePosition.y, bikePosition.z);
     mpCameraController->Update(elapsedTime);
 
+    // Keep rendering at full rate while the bike coasts and the camera catches up
+    if( mBike.velocity > MIN_VELOCITY || (idealPosition - realPosition).length() > 1.0f )
+    {
+        mFrameScheduler.ReportActivity(CPUTFrameScheduler::GetSeconds());
+    }
+
     //
     // Update bike
     //
+    mBikeStart         = mBike;
+    mBikeStartPosition = bikePosition;
+    mBikeElapsedTime   = elapsedTime;
+    mUpdateSampleTime  = sensorData.InclinometerTime;
+    StepBike(sensorData);
+}
+
+// Moves the bike from where it was at the start of Update(), with the given tilts
+//-----------------------------------------------------------------------------
+void WindowsSensors::StepBike(const InclinometerData &sensorData)
+{
+    float  elapsedTime  = mBikeElapsedTime;
+    float3 bikePosition = mBikeStartPosition;
+    mBike = mBikeStart;
     if(mBike.velocity > MIN_VELOCITY)
     {
         mBike.turnDelta = -sensorData.Y_Tilt * elapsedTime;
@@ -459,25 +647,44 @@ void WindowsSensors::Update(double deltaSeconds)
     if(tilt < -0.8f) tilt = -0.8f;
     if(tilt >  0.8f) tilt =  0.8f;
 
-    // Wall collision
-    for(int ii = 0; ii < 4; ++ii)
+    // Wall collision.  Cast a ray along the bike's path (above the floor) and bounce off
+    // whatever vertical level geometry is in the way, BIKE_COLLISION_RADIUS short of it.
+    for(int ii = 0; ii < BIKE_MAX_BOUNCES; ++ii)
     {
-        float start = DistanceToPlane(mWalls[ii], bikePosition);
-        float end = DistanceToPlane(mWalls[ii], newBikePosition);
+        float3 motion = newBikePosition - bikePosition;
+        float  motionLength = motion.length();
+        CPUTCollisionHit hit;
+        if( motionLength <= 0.0f ||
+            !mpLevelCollision->Raycast( bikePosition + float3(0.0f, BIKE_COLLISION_HEIGHT, 0.0f), motion / motionLength,
+                                        motionLength + BIKE_COLLISION_LOOKAHEAD, &hit ) ||
+            fabsf(hit.mNormal.y) > 0.5f )
+        {
+            break;
+        }
+        // The wall's plane, moved toward the bike by its radius.  hit.mNormal faces the bike.
+        float3 wallPoint = hit.mPosition - float3(0.0f, BIKE_COLLISION_HEIGHT, 0.0f) + hit.mNormal * BIKE_COLLISION_RADIUS;
+        Plane  wall      = float4( hit.mNormal, dot3(hit.mNormal, wallPoint) );
+
+        float start = DistanceToPlane(wall, bikePosition);
+        float end = DistanceToPlane(wall, newBikePosition);
         if((start < 0 && end >= 0) || (start >= 0 && end < 0)) // Signs are different, we crossed the wall
         {
             // "Bounce" off the wall
             float bounce = abs(start)/(abs(start) + abs(end));
             bikePosition = bikePosition + (newBikePosition-bikePosition) * bounce;
-            float3 reflect = float3(mWalls[ii].x * 2.0f * end, 
-                                    mWalls[ii].y * 2.0f * end,
-                                    mWalls[ii].z * 2.0f * end);
+            float3 reflect = float3(wall.x * 2.0f * end, 
+                                    wall.y * 2.0f * end,
+                                    wall.z * 2.0f * end);
             newBikePosition = newBikePosition - reflect;
 
             // Reset the bikes anagle
             float3 dir = normalize(newBikePosition-bikePosition);
             mBike.angle = -atan2f(dir.z, dir.x);
         }
+        else
+        {
+            break;
+        }
     }
 
     float4x4 x = float4x4RotationX(tilt);
@@ -486,6 +693,35 @@ void WindowsSensors::Update(double deltaSeconds)
     float4x4 translation = float4x4Translation(newBikePosition);
     float4x4 transform = x * y * z * translation;
     mpBikeModel->SetParentMatrix(transform);
+    mpBikeModel->UpdateBoundsWorldSpace(); // The main pass culls the bike against its bounds
+}
+
+// Called by the main pass's Submit(), after culling and queueing and before any
+// constants are written.  Always measures how old the sensor sample is by then.
+// Submit() updates the transform hierarchy after this returns, so moving the bike here
+// is safe even when the queue records on several threads.
+//-----------------------------------------------------------------------------
+void WindowsSensors::Latch(CPUTRenderParameters &renderParams)
+{
+    UNREFERENCED_PARAMETER(renderParams);
+    CPUT_PROFILE_ZONE("Late latch");
+    InclinometerData sensorData = {0};
+    if( mLateLatch )
+    {
+        ReadSensor(&sensorData, NULL);
+        StepBike(sensorData);
+    }
+
+    __int64 submitTime = GetSensorClock();
+    if( mUpdateSampleTime )
+    {
+        mUpdateLatency.AddSample( (submitTime - mUpdateSampleTime) * 1e-7 );
+    }
+    if( sensorData.InclinometerTime )
+    {
+        mLatchLatency.AddSample( (submitTime - sensorData.InclinometerTime) * 1e-7 );
+        CPUT_PROFILE_COUNTER("Latched input age (us)", (submitTime - sensorData.InclinometerTime) / 10);
+    }
 }
 
 // Handle keyboard events
@@ -515,6 +751,30 @@ CPUTEventHandledCode WindowsSensors::HandleKeyboardEvent(CPUTKey key)
         handled = CPUT_EVENT_HANDLED;
         Shutdown();
         break;
+    case KEY_T:
+        // Cycle the render queue's recording threads: 1, 2, 4, ... all
+        if( mpThreadPool )
+        {
+            UINT threadCount = mRenderQueue.GetThreadCount();
+            threadCount = (threadCount >= mpThreadPool->GetThreadCount()) ? 1 : threadCount * 2;
+            mRenderQueue.SetThreadPool( mpThreadPool, threadCount );
+        }
+        handled = CPUT_EVENT_HANDLED;
+        break;
+    case KEY_L:
+        mLateLatch = !mLateLatch;
+        mLatchLatency.Reset();
+        handled = CPUT_EVENT_HANDLED;
+        break;
+    case KEY_P:
+        // Profile the next 120 frames, then write them to WindowsSensors.json for chrome://tracing
+        if( !CPUTProfiler::IsCapturing() )
+        {
+            CPUTProfiler::BeginCapture( 120 );
+            mProfileCapturePending = true;
+        }
+        handled = CPUT_EVENT_HANDLED;
+        break;
     }
 
     // pass it to the camera controller
@@ -561,9 +821,8 @@ void WindowsSensors::HandleCallbackEvent( CPUTEventID Event, CPUTControlID Contr
     case ID_SENSOR_ZERO:
         {
             InclinometerData sensorData = {0};
-            if(mpSensorManager->GetStatus(mCurrentSensor) == SENSOR_STATUS_ACTIVE)
+            if( GetRawSensorData(&sensorData) )
             {
-                mpSensorManager->GetData(mCurrentSensor, &sensorData);
                 TCHAR buffer[256];
                 swprintf(buffer, 256, _L("Zero:\t%.2f\t%.2f\t%.2f"), sensorData.X_Tilt, sensorData.Y_Tilt, sensorData.Z_Tilt);
                 mpSensorZeroText->SetText(buffer);
@@ -600,36 +859,149 @@ void WindowsSensors::ResizeWindow(UINT width, UINT height)
 }
 
 //-----------------------------------------------------------------------------
-void WindowsSensors::Render(double deltaSeconds)
+void WindowsSensors::ShadowPass::Execute(CPUTRenderGraph &graph, void *pContext)
 {
-    CPUTRenderParametersDX renderParams(mpContext);
+    mpSample->RenderShadowPass(*(CPUTRenderParametersDX*)pContext, graph);
+}
+
+//-----------------------------------------------------------------------------
+void WindowsSensors::ScenePass::Execute(CPUTRenderGraph &graph, void *pContext)
+{
+    mpSample->RenderScenePass(*(CPUTRenderParametersDX*)pContext);
+}
 
-    //*******************************
-    // Draw the shadow scene
-    //*******************************
+//-----------------------------------------------------------------------------
+void WindowsSensors::RenderShadowPass(CPUTRenderParametersDX &renderParams, CPUTRenderGraph &graph)
+{
+    CPUTRenderTargetDepth *pShadowRenderTarget = (CPUTRenderTargetDepth*)graph.GetTexture(mShadowDepth);
     CPUTCamera *pLastCamera = mpCamera;
     mpCamera = renderParams.mpCamera = mpShadowCamera;
-    mpShadowRenderTarget->SetRenderTarget( renderParams, 0, 0.0f, true );
+    pShadowRenderTarget->SetRenderTarget( renderParams, 0, 0.0f, true );
 
     mpLevelSet->RenderShadowRecursive(renderParams);
     mpBikeSet->RenderShadowRecursive(renderParams);
+    mSubmitTimer.StartTimer();
+    mRenderQueue.Submit(renderParams);
+    mSubmitSeconds += mSubmitTimer.StopTimer();
 
-    mpShadowRenderTarget->RestoreRenderTarget(renderParams);
+    pShadowRenderTarget->RestoreRenderTarget(renderParams);
     mpCamera = renderParams.mpCamera = pLastCamera;
 
     // Save the light direction to a global so we can set it to a constant buffer later (TODO: have light do this)
     gLightDir = mpShadowCamera->GetLook();
+}
 
+//-----------------------------------------------------------------------------
+void WindowsSensors::RenderScenePass(CPUTRenderParametersDX &renderParams)
+{
     // Clear back buffer
     const float clearColor[] = { 0.0993f, 0.0993f, 0.0993f, 1.0f };
-    mpContext->ClearRenderTargetView( mpBackBufferRTV,  clearColor );
-    mpContext->ClearDepthStencilView( mpDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 0.0f, 0);
-
-    renderParams.mRenderOnlyVisibleModels = false;
+    mpBackend->ClearRenderTarget( mpBackBufferRTV,  clearColor );
+    mpBackend->ClearDepthStencil( mpDepthStencilView, CPUT_CLEAR_DEPTH | CPUT_CLEAR_STENCIL, 0.0f, 0 );
+
+    // Rasterize the occluders into the CPU depth buffer, then draw the level and bike
+    // culled against the frustum and that buffer
+    mOcclusionTimer.StartTimer();
+    mpOcclusionCuller->BeginFrame( *mpCamera->GetViewMatrix() * *mpCamera->GetProjectionMatrix(), mpCamera->GetNearPlaneDistance() );
+    mpOcclusionCuller->RenderOccluders( &mFrameArena );
+    mOcclusionSeconds = mOcclusionTimer.StopTimer();
+
+    renderParams.mRenderOnlyVisibleModels = true;
+    renderParams.mpOcclusionCuller = mpOcclusionCuller;
     mpLevelSet->RenderRecursive(renderParams);
     mpBikeSet->RenderRecursive(renderParams);
+
+    // The skybox's bounds don't reflect what it covers, so never cull it
+    renderParams.mRenderOnlyVisibleModels = false;
+    renderParams.mpOcclusionCuller = NULL;
+    renderParams.mRenderPass = CPUT_RENDER_PASS_SKY;
     mpSkyboxSet->RenderRecursive(renderParams);
 
+    // Only this pass latches the sensor: the shadow pass drew the bike as Update() left it
+    renderParams.mpLateLatch = this;
+    mSubmitTimer.StartTimer();
+    mRenderQueue.Submit(renderParams);
+    mSubmitSeconds += mSubmitTimer.StopTimer();
+    renderParams.mpLateLatch   = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void WindowsSensors::Render(double deltaSeconds)
+{
+    CPUTRenderParametersDX renderParams(mpContext);
+    renderParams.mpBackend = mpBackend;
+    renderParams.mpUploadRing = mpUploadRing; // NULL on DX11 unless built with CPUT_FOR_DX11_1 (see CPUTRenderBackendDX11.h)
+    renderParams.mpFrameArena = &mFrameArena;
+    mpBackend->ResetStats();
+
+    // Models queue their meshes.  Each pass is sorted and drawn by Submit().
+    renderParams.mpRenderQueue = &mRenderQueue;
+    mRenderQueue.ResetStats();
+    mSubmitSeconds = 0.0;
+
+    mRenderGraph.Execute( &renderParams );
+    renderParams.mpRenderQueue = NULL;
+
+    const CPUTOcclusionStats &stats = mpOcclusionCuller->GetStats();
+    TCHAR buffer[256];
+    swprintf(buffer, 256, _L("Occluded: %d/%d (%.2f ms)"), stats.mOccludeesCulled, stats.mOccludeesTested, mOcclusionSeconds * 1000.0);
+    mpOcclusionText->SetText(buffer);
+
+    const CPUTBackendStats     &backendStats = mpBackend->GetStats();
+    const CPUTRenderQueueStats &queueStats   = mRenderQueue.GetStats();
+    swprintf(buffer, 256, _L("Draws: %d (%d instanced, %d instances)  Materials: %d  API calls: %d, %d skipped (%.2f ms, %d threads, T to change)"),
+        backendStats.mDrawCalls, queueStats.mInstancedDraws, queueStats.mInstances, queueStats.mMaterialChanges, backendStats.GetTotalAPICalls(), backendStats.mRedundantCallsSkipped,
+        mSubmitSeconds * 1000.0, mRenderQueue.GetThreadCount());
+    mpSubmitText->SetText(buffer);
+
+    if( mLateLatch )
+    {
+        swprintf(buffer, 256, _L("Input age at submit: %.2f ms, %.2f ms latched (99%%: %.2f ms)  L to disable late latching"),
+            mUpdateLatency.GetAverage() * 1000.0, mLatchLatency.GetAverage() * 1000.0, mLatchLatency.GetPercentile(99.0) * 1000.0);
+    }
+    else
+    {
+        swprintf(buffer, 256, _L("Input age at submit: %.2f ms (99%%: %.2f ms)  L to enable late latching"),
+            mUpdateLatency.GetAverage() * 1000.0, mUpdateLatency.GetPercentile(99.0) * 1000.0);
+    }
+    mpLatencyText->SetText(buffer);
+
+    const CPUTFrameSchedulerStats &pacing = mFrameScheduler.GetStats();
+    swprintf(buffer, 256, _L("Frames: %.0f Hz%s, %.2f ms CPU/frame, %llu idle frames, %llu wakeups (%llu by messages, %llu by activity)"),
+        mFrameScheduler.GetTargetRate(), mFrameScheduler.IsIdle(CPUTFrameScheduler::GetSeconds()) ? _L(" (idle)") : _L(""),
+        pacing.GetCPUSecondsPerFrame() * 1000.0, pacing.mIdleFrames, pacing.mWakeups, pacing.mEventWakeups, pacing.mActivityWakeups);
+    mpPacingText->SetText(buffer);
+
+    // The last whole frame's allocations (this one's are still being counted)
+    const CPUTFrameAllocations &allocations = GetFrameAllocations();
+    CPUTPoolStats nodeStats = CPUTRenderNode::GetPoolStats();
+    swprintf(buffer, 256, _L("Allocations/frame: %llu heap (%.1f KB), %llu arena (%.1f KB)  Load: %llu heap allocations, %.0f ms  Pooled nodes: %u"),
+        allocations.mHeapAllocations, allocations.mHeapBytes / 1024.0, allocations.mArenaAllocations, allocations.mArenaBytes / 1024.0,
+        mLoadHeapAllocations, mLoadSeconds * 1000.0, nodeStats.mLive);
+    mpAllocationText->SetText(buffer);
+
+    const CPUTMaterialStats &materials = CPUTAssetLibrary::GetAssetLibrary()->GetMaterialStats();
+    swprintf(buffer, 256, _L("Materials: %u unique of %u loaded, %.1f KB (%.1f KB before sharing)"),
+        materials.GetUnique(), materials.mLoaded, materials.mBytes / 1024.0, (materials.mBytes + materials.mBytesSaved) / 1024.0);
+    mpMaterialText->SetText(buffer);
+
+    const CPUTRenderGraphStats &graphStats = mRenderGraph.GetStats();
+    swprintf(buffer, 256, _L("Render graph: %u passes (%u culled), %u transients in %u textures: %.1f MB (%.1f MB unaliased, %.1f MB peak)"),
+        graphStats.mPasses, graphStats.mPassesCulled, graphStats.mTransients, graphStats.mTextures, graphStats.mTextureBytes / 1048576.0,
+        graphStats.mTransientBytes / 1048576.0, graphStats.mPeakBytes / 1048576.0);
+    mpRenderGraphText->SetText(buffer);
+
+    const CPUTMeshOptimizerStats &meshStats = *CPUTAssetLibrary::GetMeshOptimizerStats();
+    swprintf(buffer, 256, _L("Meshes: ACMR %.2f -> %.2f, ATVR %.2f -> %.2f, overdraw %.2f -> %.2f, vertices %.1f KB -> %.1f KB"),
+        meshStats.mCacheBefore.GetACMR(), meshStats.mCacheAfter.GetACMR(), meshStats.mCacheBefore.GetATVR(), meshStats.mCacheAfter.GetATVR(),
+        meshStats.mOverdrawBefore.GetOverdraw(), meshStats.mOverdrawAfter.GetOverdraw(),
+        meshStats.mVertexBytesBefore / 1024.0, meshStats.mVertexBytesAfter / 1024.0);
+    mpMeshText->SetText(buffer);
+    CPUT_PROFILE_COUNTER("Frame CPU time (us)", pacing.mLastCPUSeconds * 1000000.0);
+    CPUT_PROFILE_COUNTER("Draw calls", backendStats.mDrawCalls);
+    CPUT_PROFILE_COUNTER("API calls", backendStats.GetTotalAPICalls());
+    CPUT_PROFILE_COUNTER("Occludees culled", stats.mOccludeesCulled);
+
     CPUTDrawGUI();
 }
 
@@ -685,6 +1057,27 @@ PS_INPUT VSMain( VS_INPUT input )\n\
     return output;\n\
 }\n\
 // ********************************************************************************************************\n\
+// Instanced variants read the per-model matrices from the instance stream (CPUTInstanceData)\n\
+struct INSTANCE_INPUT\n\
+{\n\
+    float4 World0   : INSTANCE0;  float4 World1   : INSTANCE1;  float4 World2   : INSTANCE2;  float4 World3   : INSTANCE3;\n\
+    float4 Wvp0     : INSTANCE4;  float4 Wvp1     : INSTANCE5;  float4 Wvp2     : INSTANCE6;  float4 Wvp3     : INSTANCE7;\n\
+    float4 LightWvp0: INSTANCE8;  float4 LightWvp1: INSTANCE9;  float4 LightWvp2: INSTANCE10; float4 LightWvp3: INSTANCE11;\n\
+};\n\
+PS_INPUT VSMainInstanced( VS_INPUT input, INSTANCE_INPUT instance )\n\
+{\n\
+    float4x4 world    = float4x4( instance.World0,    instance.World1,    instance.World2,    instance.World3 );\n\
+    float4x4 wvp      = float4x4( instance.Wvp0,      instance.Wvp1,      instance.Wvp2,      instance.Wvp3 );\n\
+    float4x4 lightWvp = float4x4( instance.LightWvp0, instance.LightWvp1, instance.LightWvp2, instance.LightWvp3 );\n\
+    PS_INPUT output = (PS_INPUT)0;\n\
+    output.Pos      = mul( float4( input.Pos, 1.0f), wvp );\n\
+    output.Position = mul( float4( input.Pos, 1.0f), world ).xyz;\n\
+    output.Norm = mul( input.Norm, (float3x3)world );\n\
+    output.Uv   = float2(input.Uv.x, input.Uv.y);\n\
+    output.LightUv   = mul( float4( input.Pos, 1.0f), lightWvp );\n\
+    return output;\n\
+}\n\
+// ********************************************************************************************************\n\
 float4 PSMain( PS_INPUT input ) : SV_Target\n\
 {\n\
     float3  lightUv = input.LightUv.xyz / input.LightUv.w;\n\
@@ -729,6 +1122,19 @@ PS_INPUT_NO_TEX VSMainNoTexture( VS_INPUT_NO_TEX input )\n\
     return output;\n\
 }\n\
 // ********************************************************************************************************\n\
+PS_INPUT_NO_TEX VSMainInstancedNoTexture( VS_INPUT_NO_TEX input, INSTANCE_INPUT instance )\n\
+{\n\
+    float4x4 world    = float4x4( instance.World0,    instance.World1,    instance.World2,    instance.World3 );\n\
+    float4x4 wvp      = float4x4( instance.Wvp0,      instance.Wvp1,      instance.Wvp2,      instance.Wvp3 );\n\
+    float4x4 lightWvp = float4x4( instance.LightWvp0, instance.LightWvp1, instance.LightWvp2, instance.LightWvp3 );\n\
+    PS_INPUT_NO_TEX output = (PS_INPUT_NO_TEX)0;\n\
+    output.Pos      = mul( float4( input.Pos, 1.0f), wvp );\n\
+    output.Position = mul( float4( input.Pos, 1.0f), world ).xyz;\n\
+    output.Norm = mul( input.Norm, (float3x3)world );\n\
+    output.LightUv   = mul( float4( input.Pos, 1.0f), lightWvp );\n\
+    return output;\n\
+}\n\
+// ********************************************************************************************************\n\
 float4 PSMainNoTexture( PS_INPUT_NO_TEX input ) : SV_Target\n\
 {\n\
     float3 lightUv = input.LightUv.xyz / input.LightUv.w;\n\
@@ -23,6 +23,14 @@
 #include "SensorManager\SensorManagerEvents.h"
 #define INITGUID
 #include "SensorManager\MyGuids.h"
+#include "CPUTCollisionMesh.h"
+#include "CPUTLateLatch.h"
+#include "CPUTOcclusionCuller.h"
+#include "CPUTProfiler.h"
+#include "CPUTRenderGraphDX11.h"
+#include "CPUTRenderQueue.h"
+#include "CPUTThreadPool.h"
+#include "CPUTTimerWin.h"
 
 // define some controls
 const CPUTControlID ID_MAIN_PANEL = 10;
@@ -37,16 +45,57 @@ const CPUTControlID ID_SENSOR_ZERO = 300;
 #define MAX_VELOCITY 2400.0f
 #define MIN_VELOCITY 0.0f
 
+#define BIKE_COLLISION_RADIUS    100.0f // The bike bounces this far from walls
+#define BIKE_COLLISION_HEIGHT     50.0f // Height of the collision ray above the floor
+#define BIKE_COLLISION_LOOKAHEAD 400.0f // Extra ray length (for walls approached at shallow angles)
+#define BIKE_MAX_BOUNCES           2
+
+#define SENSOR_MOTION_THRESHOLD    0.5f // Degrees of tilt change that count as motion (above the sensor's jitter)
+
+// The bike's motion state.  Its position is the bike model's.
+//-----------------------------------------------------------------------------
+struct BikeState
+{
+    float   velocity;
+    float   angle;
+    float   turnDelta;
+    float   acceleration;
+};
+
+// With late latching (the default, L toggles it), Update() steps the bike with the sensor
+// sample it reads, and the frame is culled and queued with that pose.  Then, just before
+// the main pass's constants are written, Latch() reads the sensor again and redoes the
+// step from the same starting state with the newer sample.  The chase camera follows
+// the pose the frame starts from, so the bike's matrix is all that moves.
 //-----------------------------------------------------------------------------
-class WindowsSensors : public CPUT_DX11
+class WindowsSensors : public CPUT_DX11, public CPUTLateLatch
 {
 private:
     float                   mfElapsedTime;
     CPUTCameraController   *mpCameraController;
 
     CPUTAssetSet           *mpShadowCameraSet;
-    CPUTRenderTargetDepth  *mpShadowRenderTarget;
 
+    // The render graph's passes run these
+    class ShadowPass : public CPUTRenderPass
+    {
+    public:
+        WindowsSensors *mpSample;
+        void Execute(CPUTRenderGraph &graph, void *pContext);
+    };
+    class ScenePass : public CPUTRenderPass
+    {
+    public:
+        WindowsSensors *mpSample;
+        void Execute(CPUTRenderGraph &graph, void *pContext);
+    };
+    CPUTRenderGraphAllocatorDX11 mRenderGraphAllocator;     // Before the graph, which releases into it
+    CPUTRenderGraph              mRenderGraph;
+    CPUTRenderGraphResource      mShadowDepth;
+    ShadowPass                   mShadowPass;
+    ScenePass                    mScenePass;
+    CPUTText                    *mpRenderGraphText;
+    CPUTText                    *mpMeshText;
 
     CPUTAssetSet           *mpBikeSet;
     CPUTAssetSet           *mpLevelSet;
@@ -56,19 +105,47 @@ private:
     SENSOR_ID               mCurrentSensor;
     float3                  mSensorZero;
 
-    Plane                   mWalls[4];
+    CPUTCollisionMesh      *mpLevelCollision;
+
+    CPUTThreadPool         *mpThreadPool;
+    CPUTOcclusionCuller    *mpOcclusionCuller;
+    CPUTTimerWin            mOcclusionTimer;
+    double                  mOcclusionSeconds;
+
+    CPUTRenderQueue         mRenderQueue;
+    CPUTTimerWin            mSubmitTimer;
+    double                  mSubmitSeconds;           // This frame's, over both passes
 
     CPUTModel              *mpBikeModel;
     CPUTText               *mpSensorText;
     CPUTText               *mpSensorZeroText;
+    CPUTText               *mpOcclusionText;
+    CPUTText               *mpSubmitText;
 
-    struct
-    {
-        float   velocity;
-        float   angle;
-        float   turnDelta;
-        float   acceleration;
-    }                       mBike;
+    bool                    mProfileCapturePending;   // Write the trace when the capture ends
+
+    BikeState               mBike;
+
+    // The step Update() made, which Latch() redoes
+    BikeState               mBikeStart;
+    float3                  mBikeStartPosition;
+    float                   mBikeElapsedTime;
+
+    bool                    mLateLatch;
+    bool                    mSimulateSensor;          // Generate tilts instead of reading a sensor
+    __int64                 mSimulationStart;
+    __int64                 mUpdateSampleTime;        // Timestamp of the sample Update() used
+    CPUTLatencyStats        mUpdateLatency;           // Sample timestamp to main pass Submit(), without latching
+    CPUTLatencyStats        mLatchLatency;            // and with
+    CPUTText               *mpLatencyText;
+
+    float3                  mMotionTilt;              // Raw tilts when motion was last reported
+    CPUTText               *mpPacingText;
+
+    unsigned __int64        mLoadHeapAllocations;     // Made while loading the asset sets
+    double                  mLoadSeconds;
+    CPUTText               *mpAllocationText;
+    CPUTText               *mpMaterialText;
 
 public:
     WindowsSensors() 
@@ -76,8 +153,31 @@ public:
         , mpBikeSet(NULL)
         , mpCameraController(NULL)
         , mpShadowCameraSet(NULL)
+        , mShadowDepth(CPUT_RENDER_GRAPH_NONE)
+        , mpRenderGraphText(NULL)
+        , mpMeshText(NULL)
         , mpBikeModel(NULL)
         , mpSkyboxSet(NULL)
+        , mpLevelCollision(NULL)
+        , mpThreadPool(NULL)
+        , mpOcclusionCuller(NULL)
+        , mOcclusionSeconds(0.0)
+        , mSubmitSeconds(0.0)
+        , mpOcclusionText(NULL)
+        , mpSubmitText(NULL)
+        , mProfileCapturePending(false)
+        , mBikeElapsedTime(0.0f)
+        , mLateLatch(true)
+        , mSimulateSensor(false)
+        , mSimulationStart(0)
+        , mUpdateSampleTime(0)
+        , mpLatencyText(NULL)
+        , mMotionTilt(0.0f)
+        , mpPacingText(NULL)
+        , mLoadHeapAllocations(0)
+        , mLoadSeconds(0.0)
+        , mpAllocationText(NULL)
+        , mpMaterialText(NULL)
         , mSensorZero(0.0f)
     {
     }
@@ -92,10 +192,13 @@ public:
         SAFE_RELEASE(mpBikeSet);
         SAFE_RELEASE(mpLevelSet);
         SAFE_RELEASE(mpSkyboxSet);
+        SAFE_DELETE(mpLevelCollision);
+        SAFE_DELETE(mpOcclusionCuller);
+        SAFE_DELETE(mpThreadPool);
 
         SAFE_DELETE( mpCameraController );
         SAFE_RELEASE(mpShadowCameraSet);
-        SAFE_DELETE( mpShadowRenderTarget );
+        mRenderGraph.Reset(); // Deletes the shadow map
     }
     CPUTEventHandledCode HandleKeyboardEvent(CPUTKey key);
     CPUTEventHandledCode HandleMouseEvent(int x, int y, int wheel, CPUTMouseState state);
@@ -105,5 +208,17 @@ public:
     void Render(double deltaSeconds);
     void Update(double deltaSeconds);
     void ResizeWindow(UINT width, UINT height);
+    void Latch(CPUTRenderParameters &renderParams);
+    void PollActivity();
+
+    void SetSimulateSensor(bool simulate) { mSimulateSensor = simulate; }
+
+protected:
+    bool GetRawSensorData(InclinometerData *pData);
+    void ReadSensor(InclinometerData *pData, CPUTText *pRawText);
+    void ReportSensorMotion(const InclinometerData &rawData);
+    void StepBike(const InclinometerData &sensorData);
+    void RenderShadowPass(CPUTRenderParametersDX &renderParams, CPUTRenderGraph &graph);
+    void RenderScenePass(CPUTRenderParametersDX &renderParams);
 };
 #endif // __CPUT_SAMPLESTARTDX11_H__